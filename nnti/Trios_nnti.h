@@ -68,6 +68,13 @@ typedef NNTI_result_t (*NNTI_callback_fn_t) (
         const uint64_t          local_atomic,
         void                   *context);
 
+typedef NNTI_result_t (*NNTI_am_handler_fn_t) (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *src,
+        void                   *payload,
+        const uint32_t          length,
+        void                   *context);
+
 
 /**
  * @brief Initialize NNTI to use a specific transport.
@@ -250,10 +257,23 @@ NNTI_result_t NNTI_dt_free (
 /**
  * @brief Send a message to a peer.
  *
+ * When the peer enables request flow control (TRIOS_NNTI_REQUEST_CREDITS
+ * on IB and MPI caps the credits it offers), each message sent to the
+ * peer's request queue spends one of the credits the peer granted at
+ * connect time, one per slot in its request queue.  The peer returns
+ * credits as it consumes requests.  A send without a credit is not
+ * started and returns NNTI_EAGAIN; the caller should make progress
+ * (e.g. wait on an outstanding operation) and try again.  Gemini limits
+ * requests with its own mailbox credits instead.
+ *
+ * The whole of <tt>msg_hdl</tt> is sent, so a message for the request
+ * queue must fit in one of the peer's slots (NNTI_REQUEST_BUFFER_SIZE) or
+ * in its request ring.  Send larger messages with NNTI_rendezvous_send().
+ *
  * \param[in] peer_hdl  The peer to send the message to.
  * \param[in] msg_hdl   A buffer containing the message to send.
  * \param[in] dest_hdl  A buffer to put the data into.
- * \return A result code (NNTI_OK or an error)
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
  */
 NNTI_result_t NNTI_send (
         const NNTI_peer_t   *peer_hdl,
@@ -261,6 +281,59 @@ NNTI_result_t NNTI_send (
         const NNTI_buffer_t *dest_hdl,
         NNTI_work_request_t *wr);
 
+/**
+ * @brief Send a message to a peer's request queue by rendezvous.
+ *
+ * Only a header describing <tt>msg_hdl</tt> is queued at the peer, which
+ * recognizes it with NNTI_rendezvous_length() and pulls the message with
+ * NNTI_rendezvous_recv().  The message may be of any size.  <tt>wr</tt>
+ * completes once the peer has the message, so <tt>msg_hdl</tt> must not
+ * change until then.  At most NNTI_RENDEZVOUS_MAX of these may be in
+ * flight per transport; beyond that this returns NNTI_EAGAIN.  The header
+ * spends a request credit like any NNTI_send().
+ *
+ * \param[in]  peer_hdl  The peer to send the message to.
+ * \param[in]  msg_hdl   A buffer registered with NNTI_GET_SRC containing the message to send.
+ * \param[out] wr        The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EINVAL if <tt>msg_hdl</tt> can't be read remotely, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_rendezvous_send (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Get the length of the message announced by a rendezvous header.
+ *
+ * \param[in]  status  The status of a request taken from the receive queue.
+ * \param[out] length  The number of bytes in the message.
+ * \return A result code (NNTI_OK or NNTI_ENOENT if the request isn't a rendezvous header)
+ */
+NNTI_result_t NNTI_rendezvous_length (
+        const NNTI_status_t *status,
+        uint64_t            *length);
+
+/**
+ * @brief Pull the message announced by a rendezvous header.
+ *
+ * Gets the message straight from the sender's buffer into
+ * <tt>dest_hdl</tt>, which may be the caller's own buffer or one taken
+ * from a pool such as a trios_buffer_queue.  When <tt>wr</tt> completes the
+ * message is in place and the sender's send has completed too.  The
+ * request slot holding the header can be reused as soon as this returns.
+ *
+ * \param[in]  status       The status of the rendezvous header.
+ * \param[in]  dest_hdl     A buffer registered with NNTI_BOP_LOCAL_WRITE.
+ * \param[in]  dest_offset  The offset (in bytes) into <tt>dest_hdl</tt> for the message.
+ * \param[out] wr           The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_ENOENT if the request isn't a rendezvous header, NNTI_EMSGSIZE if the message doesn't fit, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_rendezvous_recv (
+        const NNTI_status_t *status,
+        const NNTI_buffer_t *dest_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr);
+
 /**
  * @brief Transfer data to a peer.
  *
@@ -279,6 +352,60 @@ NNTI_result_t NNTI_put (
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr);
 
+/**
+ * @brief Transfer data to a peer as an ordered stream of chunks.
+ *
+ * The data is put in chunks of <tt>chunk_size</tt> bytes (the last one may be
+ * shorter).  Instead of one completion for the whole transfer, waiters on
+ * the target buffer get one event per chunk, in order, as each chunk lands.
+ * The <tt>offset</tt> and <tt>length</tt> of each event's status describe the
+ * chunk, so the target can process the start of the data while the rest
+ * is still in flight.  The initiator's work request completes once, when
+ * the whole transfer is done.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to put.
+ * \param[in] src_offset       The offset (in bytes) into the src_buffer from which to put.
+ * \param[in] src_length       The number of bytes to put.
+ * \param[in] dest_buffer_hdl  A buffer to put the data into.
+ * \param[in] dest_offset      The offset (in bytes) into the dest at which to put.
+ * \param[in] chunk_size       The number of bytes in each chunk.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport can't stream or an error)
+ */
+NNTI_result_t NNTI_put_stream (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Transfer data to a peer and tell the target what it was.
+ *
+ * Like NNTI_put(), but <tt>imm</tt> is delivered to the target with the
+ * put.  A waiter on the target buffer gets one event whose status carries
+ * <tt>imm</tt>, so the target can tell which logical message landed without
+ * a separate NNTI_send().  Values that fit in 32 bits are as cheap as full
+ * 64-bit values.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to put.
+ * \param[in] src_offset       The offset (in bytes) into the src_buffer from which to put.
+ * \param[in] src_length       The number of bytes to put.
+ * \param[in] dest_buffer_hdl  A buffer to put the data into.
+ * \param[in] dest_offset      The offset (in bytes) into the dest at which to put.
+ * \param[in] imm              The value delivered in the target's status.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport can't deliver target events or an error)
+ */
+NNTI_result_t NNTI_put_notify (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr);
+
 /**
  * @brief Transfer data from a peer.
  *
@@ -297,6 +424,265 @@ NNTI_result_t NNTI_get (
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr);
 
+/**
+ * @brief Send a message from unregistered memory.
+ *
+ * Messages up to NNTI_RAW_BOUNCE_SIZE are copied into a registered bounce
+ * buffer, so <tt>msg</tt> can be reused as soon as this returns.  Larger
+ * messages are sent in place from a cached registration of <tt>msg</tt>
+ * and must not change until <tt>wr</tt> completes.  A message for the
+ * request queue larger than NNTI_REQUEST_BUFFER_SIZE goes by rendezvous
+ * (see NNTI_rendezvous_send()), so the peer must expect one.  At most
+ * NNTI_RAW_MAX raw operations may be in flight per transport; beyond that
+ * these calls return NNTI_EAGAIN.
+ *
+ * \warning Cached registrations are found by address and length alone.
+ * If memory used here is freed and other memory is later allocated at the
+ * same address with the same length, the stale registration is reused and
+ * the transfer reads or writes the wrong pages.  Call
+ * NNTI_raw_cache_flush() before freeing memory passed to NNTI_send_raw(),
+ * NNTI_put_from() or NNTI_get_into().
+ *
+ * \param[in]  trans_hdl  A handle to the configured transport.
+ * \param[in]  peer_hdl   The peer to send the message to.
+ * \param[in]  msg        The message.
+ * \param[in]  length     The number of bytes in the message.
+ * \param[in]  dest_hdl   A buffer to put the data into (NULL for the request queue).
+ * \param[out] wr         The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_send_raw (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *peer_hdl,
+        const void             *msg,
+        const uint64_t          length,
+        const NNTI_buffer_t    *dest_hdl,
+        NNTI_work_request_t    *wr);
+
+/**
+ * @brief Transfer data from unregistered memory to a peer.
+ *
+ * Uses a bounce buffer or a cached registration like NNTI_send_raw().
+ *
+ * \warning Call NNTI_raw_cache_flush() before freeing <tt>src</tt>.  A
+ * later allocation at the same address would reuse its stale registration
+ * (see NNTI_send_raw()).
+ *
+ * \param[in]  trans_hdl        A handle to the configured transport.
+ * \param[in]  src              The data to put.
+ * \param[in]  length           The number of bytes to put.
+ * \param[in]  dest_buffer_hdl  A buffer to put the data into.
+ * \param[in]  dest_offset      The offset (in bytes) into the dest at which to put.
+ * \param[out] wr               The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_put_from (
+        const NNTI_transport_t *trans_hdl,
+        const void             *src,
+        const uint64_t          length,
+        const NNTI_buffer_t    *dest_buffer_hdl,
+        const uint64_t          dest_offset,
+        NNTI_work_request_t    *wr);
+
+/**
+ * @brief Transfer data from a peer into unregistered memory.
+ *
+ * Small transfers land in a bounce buffer and are copied to <tt>dest</tt>
+ * when <tt>wr</tt> completes.  Larger ones go straight into a cached
+ * registration of <tt>dest</tt>.  Either way <tt>dest</tt> holds the data
+ * once a wait on <tt>wr</tt> returns.
+ *
+ * \warning Call NNTI_raw_cache_flush() before freeing <tt>dest</tt>.  A
+ * later allocation at the same address would reuse its stale registration
+ * (see NNTI_send_raw()).
+ *
+ * \param[in]  trans_hdl       A handle to the configured transport.
+ * \param[in]  src_buffer_hdl  A buffer to get the data from.
+ * \param[in]  src_offset      The offset (in bytes) into the src_buffer from which to get.
+ * \param[in]  length          The number of bytes to get.
+ * \param[in]  dest            Where to put the data.
+ * \param[out] wr              The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_get_into (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_buffer_t    *src_buffer_hdl,
+        const uint64_t          src_offset,
+        const uint64_t          length,
+        void                   *dest,
+        NNTI_work_request_t    *wr);
+
+/**
+ * @brief Drop the idle registrations cached by the raw operations.
+ *
+ * Memory passed to NNTI_send_raw(), NNTI_put_from() or NNTI_get_into()
+ * above NNTI_RAW_BOUNCE_SIZE stays registered after the operation
+ * completes and is matched by address and length alone.  Call this before
+ * freeing such memory, or a later allocation at the same address reuses
+ * the stale registration.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_raw_cache_flush (
+        const NNTI_transport_t *trans_hdl);
+
+/**
+ * @brief Set when coalesced operations are flushed.
+ *
+ * NNTI_send_coalesced() and NNTI_put_coalesced() collect small operations
+ * into batches.  A batch goes out when the next operation wouldn't fit in
+ * <tt>max_bytes</tt>, when its oldest operation has waited
+ * <tt>max_delay</tt> milliseconds, when NNTI_coalesce_flush() is called or
+ * when a wait function is called on one of its work requests.  The delay
+ * is checked whenever an operation is coalesced or a wait function is
+ * called.  A wait function that may block sends every open batch first.
+ * A batch the transport refuses with NNTI_EAGAIN (eg. out of request
+ * credits) stays open and is sent again by the next wait function.
+ * The defaults are NNTI_COALESCE_SIZE and NNTI_COALESCE_DELAY.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \param[in] max_bytes  The size of a batch (at most NNTI_COALESCE_SIZE).
+ * \param[in] max_delay  The time (in milliseconds) an operation may wait in a batch.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_coalesce_config (
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          max_bytes,
+        const int               max_delay);
+
+/**
+ * @brief Send a small message to a peer as part of a batch.
+ *
+ * Messages to the same peer are framed into one request.  The receiver
+ * splits it with NNTI_coalesced_count() and NNTI_coalesced_message().  The
+ * message is copied, so <tt>msg_hdl</tt> can be reused as soon as this
+ * returns.  <tt>wr</tt> completes when the batch carrying the message has
+ * been sent.  A message too large for a batch is sent on its own with
+ * NNTI_send(), after the peer's open batch.  Beyond NNTI_COALESCE_MAX
+ * coalesced operations in flight, or when the peer's full batch was
+ * refused, this returns NNTI_EAGAIN.  <tt>peer_hdl</tt> is copied.
+ *
+ * \param[in]  peer_hdl  The peer to send the message to.
+ * \param[in]  msg_hdl   A buffer containing the message to send.
+ * \param[out] wr        The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_send_coalesced (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Transfer a small piece of data to a peer as part of a batch.
+ *
+ * A put that starts where the open batch for <tt>dest_buffer_hdl</tt>
+ * ends joins that batch, and the batch goes out as one put.  Any other put
+ * starts a new batch.  The data is copied, so the source can be reused as
+ * soon as this returns.  <tt>dest_buffer_hdl</tt> is not copied and must
+ * stay valid until the batch has been sent, which is at the latest when
+ * <tt>wr</tt> completes.  A target that asked for events gets one event per
+ * batch rather than one per put.  <tt>wr</tt> completes with the batch.
+ *
+ * \param[in]  src_buffer_hdl   A buffer containing the data to put.
+ * \param[in]  src_offset       The offset (in bytes) into the src_buffer from which to put.
+ * \param[in]  src_length       The number of bytes to put.
+ * \param[in]  dest_buffer_hdl  A buffer to put the data into.
+ * \param[in]  dest_offset      The offset (in bytes) into the dest at which to put.
+ * \param[out] wr               The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_put_coalesced (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Send every open batch of coalesced operations.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \return A result code (NNTI_OK, NNTI_EAGAIN if a batch was refused or an error)
+ */
+NNTI_result_t NNTI_coalesce_flush (
+        const NNTI_transport_t *trans_hdl);
+
+/**
+ * @brief Get the number of messages in a received request.
+ *
+ * A request that isn't a batch from NNTI_send_coalesced() holds one
+ * message.
+ *
+ * \param[in]  status  The status of the request from a receive queue.
+ * \param[out] count   The number of messages.
+ * \return A result code (NNTI_OK)
+ */
+NNTI_result_t NNTI_coalesced_count (
+        const NNTI_status_t *status,
+        uint32_t            *count);
+
+/**
+ * @brief Describe one message of a received request.
+ *
+ * <tt>msg</tt> is a copy of <tt>status</tt> whose offset and length
+ * describe message <tt>index</tt>.
+ *
+ * \param[in]  status  The status of the request from a receive queue.
+ * \param[in]  index   The message to describe.
+ * \param[out] msg     The status of the message.
+ * \return A result code (NNTI_OK or NNTI_ENOENT if there is no such message)
+ */
+NNTI_result_t NNTI_coalesced_message (
+        const NNTI_status_t *status,
+        const uint32_t       index,
+        NNTI_status_t       *msg);
+
+/**
+ * @brief Transfer a list of regions to a peer.
+ *
+ * Each entry of <tt>iov</tt> puts <tt>length</tt> bytes from
+ * <tt>src_offset</tt> in <tt>src_buffer_hdl</tt> to <tt>dest_offset</tt>
+ * in <tt>dest_buffer_hdl</tt>.  The whole list is one operation with one
+ * work request.  The list may be reused as soon as this call returns.
+ *
+ * The status of a vectored operation reports the lowest offset and the
+ * extent of the regions it touched in the local buffer.  A target event
+ * does the same for the target buffer.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to put.
+ * \param[in] dest_buffer_hdl  A buffer to put the data into.
+ * \param[in] iov              The regions to put.
+ * \param[in] iov_count        The number of regions.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_putv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Transfer a list of regions from a peer.
+ *
+ * Like NNTI_putv(), but the data moves from the remote
+ * <tt>src_buffer_hdl</tt> into the local <tt>dest_buffer_hdl</tt>.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to get.
+ * \param[in] dest_buffer_hdl  A buffer to get the data into.
+ * \param[in] iov              The regions to get.
+ * \param[in] iov_count        The number of regions.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_getv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+
 /**
  * @brief Transfer data to a peer.
  *
@@ -340,8 +726,17 @@ NNTI_result_t NNTI_gather (
  * \param[in]  context       data passed to cbfunc() at every invocation
  *
  * This function assigns a callback to the atomic variable {local_atomic}.
- * {cbfunc} will be invoked after every successful atomic operation on
- * {local_atomic}.  Reads are not considered an atomic operation.
+ * {cbfunc} will be invoked after atomic operations modify {local_atomic}.
+ * Reads are not considered an atomic operation.  How often it is invoked
+ * depends on the transport.  MPI invokes it once for every atomic
+ * operation on {local_atomic}.  IB can't see one-sided atomics arrive, so
+ * it watches the value instead.  Several operations that land between two
+ * looks are reported by a single invocation, and an operation that leaves
+ * the value alone doesn't invoke {cbfunc} at all.
+ *
+ * The callback runs from the transport's progress path, so some thread
+ * must be inside NNTI_wait() or one of its variants.  It must not wait on
+ * a work request itself.  A NULL {cbfunc} removes the callback.
  */
 NNTI_result_t NNTI_atomic_set_callback (
 		const NNTI_transport_t *trans_hdl,
@@ -349,6 +744,25 @@ NNTI_result_t NNTI_atomic_set_callback (
 		NNTI_callback_fn_t      cbfunc,
 		void                   *context);
 
+/**
+ * assign a callback to an atomic variable that fires at a threshold
+ *
+ * \param[in]  trans_hdl     A handle to the configured transport.
+ * \param[in]  local_atomic  index of the local atomic variable
+ * \param[in]  threshold     value the atomic variable must reach
+ * \param[in]  cbfunc        callback function invoked when {threshold} is reached
+ * \param[in]  context       data passed to cbfunc() at every invocation
+ *
+ * Like NNTI_atomic_set_callback(), but {cbfunc} is only invoked when
+ * {local_atomic} goes from below {threshold} to {threshold} or above.
+ */
+NNTI_result_t NNTI_atomic_set_threshold_callback (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		const int64_t           threshold,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context);
+
 /**
  * read a 64-bit value from an local atomic variable
  *
@@ -378,6 +792,12 @@ NNTI_result_t NNTI_atomic_read (
  * This function executes an atomic operation with get semantics. When the operation
  * is complete the result of the operation is visible in {target_atomic} and the
  * previous value is visible in {result_atomic}.
+ *
+ * The non-fetching operations (NNTI_ATOMIC_ADD, NNTI_ATOMIC_AND, ...) don't
+ * touch {result_atomic}.  Their work request may complete as soon as the
+ * operation has been handed to the network, but operations from this
+ * process to {target_atomic} are applied in the order they were issued.
+ * Returns NNTI_EINVAL if {op} isn't an NNTI_atomic_op_t.
  */
 NNTI_result_t NNTI_atomic_fop (
 		const NNTI_transport_t *trans_hdl,
@@ -412,6 +832,80 @@ NNTI_result_t NNTI_atomic_cswap (
 		const int64_t           swap_operand,
 		NNTI_work_request_t    *wr);
 
+/**
+ * perform a 64-bit atomic operation on a registered buffer
+ *
+ * \param[in]  target_buf    remote buffer registered with NNTI_BOP_ATOMICS
+ * \param[in]  target_offset 8-byte aligned offset of the target variable in {target_buf}
+ * \param[in]  result_buf    local registered buffer that receives the previous value
+ * \param[in]  result_offset 8-byte aligned offset of the result in {result_buf}
+ * \param[in]  operand       64-bit operand to the atomic operation
+ * \param[in]  op            atomic operation to execute
+ * \param[out] wr            work request to wait on
+ *
+ * Like NNTI_atomic_fop(), but the target variable lives in user data
+ * instead of the transport's table of atomic variables.  {result_buf} may
+ * be NULL for the non-fetching operations.  Returns NNTI_EINVAL if an
+ * offset is misaligned or out of range or if {target_buf} doesn't allow
+ * atomics.  Atomic operations on a variable are only atomic with respect
+ * to each other, not to puts or local stores.
+ */
+NNTI_result_t NNTI_atomic_fop_buffer (
+		const NNTI_buffer_t    *target_buf,
+		const uint64_t          target_offset,
+		const NNTI_buffer_t    *result_buf,
+		const uint64_t          result_offset,
+		const int64_t           operand,
+		const NNTI_atomic_op_t  op,
+		NNTI_work_request_t    *wr);
+
+/**
+ * perform a 64-bit compare-and-swap operation on a registered buffer
+ *
+ * \param[in]  target_buf      remote buffer registered with NNTI_BOP_ATOMICS
+ * \param[in]  target_offset   8-byte aligned offset of the target variable in {target_buf}
+ * \param[in]  result_buf      local registered buffer that receives the previous value
+ * \param[in]  result_offset   8-byte aligned offset of the result in {result_buf}
+ * \param[in]  compare_operand 64-bit operand to compare with
+ * \param[in]  swap_operand    64-bit operand to swap in
+ * \param[out] wr              work request to wait on
+ *
+ * Like NNTI_atomic_cswap(), but on a variable in a registered buffer (see
+ * NNTI_atomic_fop_buffer()).
+ */
+NNTI_result_t NNTI_atomic_cswap_buffer (
+		const NNTI_buffer_t    *target_buf,
+		const uint64_t          target_offset,
+		const NNTI_buffer_t    *result_buf,
+		const uint64_t          result_offset,
+		const int64_t           compare_operand,
+		const int64_t           swap_operand,
+		NNTI_work_request_t    *wr);
+
+/**
+ * perform a list of 64-bit atomic operations on one peer
+ *
+ * \param[in]  trans_hdl     handle to the configured transport
+ * \param[in]  peer          NNTI process that hosts the target atomic variables
+ * \param[in]  updates       list of updates to apply
+ * \param[in]  update_count  number of updates
+ * \param[out] wr            work request to wait on
+ *
+ * Applies each update like NNTI_atomic_fop(), but the whole list goes to
+ * {peer} in one request and the previous values come back in one reply.
+ * Each update is atomic on its own; the list as a whole is not, and the
+ * updates may be applied in any order.  Fetching updates need distinct
+ * result variables.  {updates} may be reused as soon as the call returns.
+ * Returns NNTI_EINVAL if the list is empty or an op isn't an
+ * NNTI_atomic_op_t.
+ */
+NNTI_result_t NNTI_atomic_fopv (
+		const NNTI_transport_t     *trans_hdl,
+		const NNTI_peer_t          *peer_hdl,
+		const NNTI_atomic_update_t *updates,
+		const uint32_t              update_count,
+		NNTI_work_request_t        *wr);
+
 
 /**
  * @brief Create a receive work request that can be used to wait for buffer
@@ -517,6 +1011,272 @@ NNTI_result_t NNTI_waitall (
         const int             timeout,
         NNTI_status_t       **status);
 
+/**
+ * @brief Take up to <tt>max_count</tt> received requests from a receive queue.
+ *
+ * Each returned request slot is on loan to the caller.  The message can be
+ * decoded in place at <tt>status_list[i].start + status_list[i].offset</tt>
+ * and the slot is not reused until it is returned with NNTI_release_requests().
+ * Don't mix this call with NNTI_wait*() on the same receive queue.
+ *
+ * \param[in]  reg_buf      A buffer registered with NNTI_RECV_QUEUE or NNTI_RECV_RING.
+ * \param[in]  max_count    The maximum number of requests to return.
+ * \param[in]  timeout      The amount of time to wait for the first request (-1 waits forever, 0 does not wait).
+ * \param[out] wr_list      An array of at least <tt>max_count</tt> work requests, one per loaned slot.
+ * \param[out] status_list  An array of at least <tt>max_count</tt> statuses describing the requests.
+ * \param[out] count        The number of requests returned.
+ * \return A result code (NNTI_OK, NNTI_ETIMEDOUT if nothing arrived or an error)
+ */
+NNTI_result_t NNTI_dequeue_requests (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count);
+
+/**
+ * @brief Return loaned request slots to the receive queue.
+ *
+ * \param[in]  wr_list   The work requests filled in by NNTI_dequeue_requests().
+ * \param[in]  wr_count  The number of work requests in the array.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_release_requests (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count);
+
+/**
+ * @brief Create a target completion counter.
+ *
+ * A counter counts the puts and gets that complete on the target buffers
+ * bound to it with NNTI_counter_bind().  It starts at zero.
+ *
+ * \param[in]  trans_hdl  A handle to the configured transport.
+ * \param[out] counter    The new counter.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_counter_create (
+        const NNTI_transport_t *trans_hdl,
+        NNTI_counter_t         *counter);
+
+/**
+ * @brief Bind a target buffer to a counter.
+ *
+ * Every put into and get from <tt>reg_buf</tt> that completes from then on
+ * adds one to <tt>counter</tt> and raises no event, so a target that only
+ * needs to know how many operations have landed doesn't have to wait on
+ * each of them.  A streaming put counts once, when all of its data is
+ * there.  Several buffers may share a counter.  A NULL <tt>counter</tt>
+ * unbinds the buffer and its events come back.
+ *
+ * \param[in] reg_buf  A buffer registered with NNTI_BOP_REMOTE_WRITE or NNTI_BOP_REMOTE_READ.
+ * \param[in] counter  The counter to bind to or NULL.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport can't count target completions or an error)
+ */
+NNTI_result_t NNTI_counter_bind (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter);
+
+/**
+ * @brief Read a counter without waiting.
+ *
+ * \param[in]  counter  The counter.
+ * \param[out] value    The number of operations counted so far.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_counter_read (
+        const NNTI_counter_t *counter,
+        uint64_t             *value);
+
+/**
+ * @brief Wait for a counter to reach a threshold.
+ *
+ * \param[in]  counter    The counter.
+ * \param[in]  threshold  The value to wait for.
+ * \param[in]  timeout    The amount of time to wait (-1 waits forever, 0 does not wait).
+ * \param[out] value      The value of the counter when the wait ended.
+ * \return A result code (NNTI_OK, NNTI_ETIMEDOUT or an error)
+ */
+NNTI_result_t NNTI_counter_wait (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value);
+
+/**
+ * @brief Destroy a counter.  Unbind its buffers first.
+ *
+ * \param[in] counter  The counter.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_counter_destroy (
+        NNTI_counter_t *counter);
+
+/**
+ * @brief Send a message to a peer without a work request.
+ *
+ * Like NNTI_send(), but the caller doesn't get a work request to wait on.
+ * The transport only counts the send against <tt>peer_hdl</tt>.  Use
+ * NNTI_flush() or NNTI_flush_all() to find out that it has completed.
+ * <tt>msg_hdl</tt> must not be reused or freed until then.
+ *
+ * \param[in] peer_hdl  The peer to send the message to.
+ * \param[in] msg_hdl   A buffer containing the message to send.
+ * \param[in] dest_hdl  A buffer to put the data into.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport has no implicit operations or an error)
+ */
+NNTI_result_t NNTI_send_implicit (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl);
+
+/**
+ * @brief Transfer data to a peer without a work request.
+ *
+ * Like NNTI_put(), but completion is only observed through NNTI_flush()
+ * or NNTI_flush_all().  The source region must not be modified until then.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to put.
+ * \param[in] src_offset       The offset (in bytes) into the src_buffer from which to put.
+ * \param[in] src_length       The number of bytes to put.
+ * \param[in] dest_buffer_hdl  A buffer to put the data into.
+ * \param[in] dest_offset      The offset (in bytes) into the dest at which to put.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport has no implicit operations or an error)
+ */
+NNTI_result_t NNTI_put_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+/**
+ * @brief Transfer data from a peer without a work request.
+ *
+ * Like NNTI_get(), but completion is only observed through NNTI_flush()
+ * or NNTI_flush_all().  The destination region is undefined until then.
+ *
+ * \param[in] src_buffer_hdl   A buffer containing the data to get.
+ * \param[in] src_offset       The offset (in bytes) into the src_buffer from which to get.
+ * \param[in] src_length       The number of bytes to get.
+ * \param[in] dest_buffer_hdl  A buffer to get the data into.
+ * \param[in] dest_offset      The offset (in bytes) into the dest at which to get.
+ * \return A result code (NNTI_OK, NNTI_ENOTSUP if the transport has no implicit operations or an error)
+ */
+NNTI_result_t NNTI_get_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+/**
+ * @brief Wait for the implicit operations to a peer to complete.
+ *
+ * Returns once every implicit send, put and get to <tt>peer_hdl</tt> has
+ * completed at the initiator, including any started while waiting.  The
+ * result reports the first implicit operation to this peer that failed
+ * since the last flush.
+ *
+ * \param[in] peer_hdl  The peer.
+ * \param[in] timeout   The amount of time to wait (-1 waits forever, 0 does not wait).
+ * \return A result code (NNTI_OK, NNTI_ETIMEDOUT or the error of a failed operation)
+ */
+NNTI_result_t NNTI_flush (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout);
+
+/**
+ * @brief Wait for the implicit operations to every peer to complete.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \param[in] timeout    The amount of time to wait (-1 waits forever, 0 does not wait).
+ * \return A result code (NNTI_OK, NNTI_ETIMEDOUT or the error of a failed operation)
+ */
+NNTI_result_t NNTI_flush_all (
+        const NNTI_transport_t *trans_hdl,
+        const int               timeout);
+
+/**
+ * @brief Register the handler for an active message.
+ *
+ * Active messages are requests that carry a handler ID.  When one is taken
+ * from the receive queue by NNTI_wait(), NNTI_waitany() or
+ * NNTI_dequeue_requests(), the handler runs on the payload in place and
+ * the slot is recycled before the call looks for the next request.  The
+ * caller only sees ordinary requests.  A NULL <tt>handler</tt> removes the
+ * registration.  A request is only recognized by its contents, so it is
+ * taken as an active message only if it starts with an active message
+ * header whose payload fits in the request and whose handler is
+ * registered.  Anything else, including an active message without a
+ * handler, is returned like an ordinary request.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \param[in] id         The handler ID (less than NNTI_AM_MAX_HANDLERS).
+ * \param[in] handler    The function to invoke.
+ * \param[in] context    Passed to <tt>handler</tt>.
+ * \return A result code (NNTI_OK or NNTI_EINVAL if <tt>id</tt> is out of range)
+ */
+NNTI_result_t NNTI_am_register (
+        const NNTI_transport_t *trans_hdl,
+        const uint32_t          id,
+        NNTI_am_handler_fn_t    handler,
+        void                   *context);
+
+/**
+ * @brief Send an active message to a peer.
+ *
+ * The payload is the <tt>length</tt> bytes at NNTI_AM_PAYLOAD(msg_hdl).
+ * The first NNTI_AM_HEADER_SIZE bytes of <tt>msg_hdl</tt> are overwritten
+ * with the header.  Only the header and the payload are sent, however
+ * large <tt>msg_hdl</tt> is.  The message goes to the peer's receive queue
+ * like any NNTI_send() and completes the same way.  Sending from a buffer
+ * larger than the message takes a raw operation slot (see NNTI_send_raw())
+ * until a wait function sees <tt>wr</tt> complete.
+ *
+ * \param[in]  peer_hdl  The peer to send the message to.
+ * \param[in]  msg_hdl   A buffer containing the header space and the payload.
+ * \param[in]  id        The handler ID on the peer.
+ * \param[in]  length    The number of payload bytes.
+ * \param[out] wr        The work request to wait on.
+ * \return A result code (NNTI_OK, NNTI_EMSGSIZE if the message doesn't fit in <tt>msg_hdl</tt> or a request, NNTI_EAGAIN or an error)
+ */
+NNTI_result_t NNTI_am_send (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const uint32_t       id,
+        const uint32_t       length,
+        NNTI_work_request_t *wr);
+
+/**
+ * @brief Run active message handlers on a pool of threads.
+ *
+ * Each thread takes requests from <tt>reg_buf</tt> with
+ * NNTI_dequeue_requests(), so handlers run concurrently and the
+ * application doesn't need to drive the receive queue at all.  The queue
+ * must carry only active messages while the threads run.  Anything else is
+ * dropped.
+ *
+ * \param[in] reg_buf       A buffer registered with NNTI_RECV_QUEUE or NNTI_RECV_RING.
+ * \param[in] thread_count  The number of handler threads.
+ * \return A result code (NNTI_OK, NNTI_EINVAL if threads are already running or NNTI_ENOTSUP without pthreads)
+ */
+NNTI_result_t NNTI_am_start_threads (
+        NNTI_buffer_t  *reg_buf,
+        const uint32_t  thread_count);
+
+/**
+ * @brief Stop the handler threads started by NNTI_am_start_threads().
+ *
+ * Returns once every thread has exited.  NNTI_fini() does this too.
+ *
+ * \param[in] trans_hdl  A handle to the configured transport.
+ * \return A result code (NNTI_OK or an error)
+ */
+NNTI_result_t NNTI_am_stop_threads (
+        const NNTI_transport_t *trans_hdl);
+
 /**
  * @brief Disable this transport.
  *
@@ -571,6 +1331,46 @@ NNTI_result_t NNTI_fini (
  */
 #define NNTI_BUFFER_SIZE(b) (b)->payload_size
 
+/**
+ * @brief The number of active message handler IDs per transport.
+ */
+#define NNTI_AM_MAX_HANDLERS 256
+/**
+ * @brief Bytes at the start of an active message reserved for its header.
+ */
+#define NNTI_AM_HEADER_SIZE 16
+/**
+ * @brief Return a 'char *' pointer to the payload of active message buffer 'b'.
+ */
+#define NNTI_AM_PAYLOAD(b) (NNTI_BUFFER_C_POINTER(b) + NNTI_AM_HEADER_SIZE)
+
+/**
+ * @brief The number of rendezvous sends and receives in flight per transport.
+ */
+#define NNTI_RENDEZVOUS_MAX 32
+
+/**
+ * @brief The largest transfer the raw operations copy through a bounce buffer.
+ */
+#define NNTI_RAW_BOUNCE_SIZE 4096
+/**
+ * @brief The number of raw operations in flight per transport.
+ */
+#define NNTI_RAW_MAX 32
+
+/**
+ * @brief The largest batch of coalesced operations.
+ */
+#define NNTI_COALESCE_SIZE NNTI_REQUEST_BUFFER_SIZE
+/**
+ * @brief The default time (in milliseconds) an operation may wait in a batch.
+ */
+#define NNTI_COALESCE_DELAY 1
+/**
+ * @brief The number of coalesced operations in flight per transport.
+ */
+#define NNTI_COALESCE_MAX 64
+
 /**
  * @brief
  *
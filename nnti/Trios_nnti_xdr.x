@@ -211,9 +211,38 @@ enum NNTI_result_t {
 
 /**
   * atomic operations that may be implemented by a transport
+  *
+  * The fetching operations return the previous value of the target
+  * variable in the result variable.  The others leave the result variable
+  * alone and don't send a result back.  MIN and MAX compare signed values.
   */
 enum NNTI_atomic_op_t {
-  NNTI_ATOMIC_FADD
+  /** @brief add the operand and fetch the previous value */
+  NNTI_ATOMIC_FADD,
+  /** @brief replace the value with the operand and fetch the previous value */
+  NNTI_ATOMIC_FSWAP,
+  /** @brief AND the operand in and fetch the previous value */
+  NNTI_ATOMIC_FAND,
+  /** @brief OR the operand in and fetch the previous value */
+  NNTI_ATOMIC_FOR,
+  /** @brief XOR the operand in and fetch the previous value */
+  NNTI_ATOMIC_FXOR,
+  /** @brief keep the smaller of the value and the operand and fetch the previous value */
+  NNTI_ATOMIC_FMIN,
+  /** @brief keep the larger of the value and the operand and fetch the previous value */
+  NNTI_ATOMIC_FMAX,
+  /** @brief add the operand */
+  NNTI_ATOMIC_ADD,
+  /** @brief AND the operand in */
+  NNTI_ATOMIC_AND,
+  /** @brief OR the operand in */
+  NNTI_ATOMIC_OR,
+  /** @brief XOR the operand in */
+  NNTI_ATOMIC_XOR,
+  /** @brief keep the smaller of the value and the operand */
+  NNTI_ATOMIC_MIN,
+  /** @brief keep the larger of the value and the operand */
+  NNTI_ATOMIC_MAX
 };
 
 
@@ -719,7 +748,9 @@ enum NNTI_buf_ops_t {
     /** @brief this buffer has multiple receive slots */
     NNTI_BOP_RECV_QUEUE=64,
     /** @brief this buffer allows atomic operations */
-    NNTI_BOP_ATOMICS=128
+    NNTI_BOP_ATOMICS=128,
+    /** @brief this buffer packs variable length requests back to back */
+    NNTI_BOP_RECV_RING=256
 };
 
 /** @brief this buffer can be put from */
@@ -736,6 +767,8 @@ enum NNTI_buf_ops_t {
 %#define NNTI_RECV_DST   ((NNTI_buf_ops_t)(NNTI_BOP_REMOTE_WRITE|NNTI_BOP_WITH_EVENTS))
 /** @brief this buffer has multiple receive slots */
 %#define NNTI_RECV_QUEUE ((NNTI_buf_ops_t)(NNTI_BOP_RECV_QUEUE))
+/** @brief this buffer packs variable length requests back to back (MPI only; IB and Gemini return NNTI_ENOTSUP) */
+%#define NNTI_RECV_RING  ((NNTI_buf_ops_t)(NNTI_BOP_RECV_RING))
 /** @brief this buffer allows atomic operations */
 %#define NNTI_ATOMICS    ((NNTI_buf_ops_t)(NNTI_BOP_ATOMICS))
 
@@ -774,6 +807,41 @@ struct NNTI_buffer_t {
 };
 
 
+/**
+ * @brief One region of a vectored put or get.
+ *
+ * <tt>length</tt> bytes at <tt>src_offset</tt> in the source buffer are
+ * transferred to <tt>dest_offset</tt> in the destination buffer.
+ */
+struct NNTI_iovec_t {
+    /** @brief Offset of the region in the source buffer. */
+    uint64_t src_offset;
+    /** @brief Offset of the region in the destination buffer. */
+    uint64_t dest_offset;
+    /** @brief Size of the region. */
+    uint64_t length;
+};
+
+
+/**
+ * @brief One update of a vectored atomic operation.
+ *
+ * <tt>op</tt> is applied with <tt>operand</tt> to the target variable
+ * <tt>target_atomic</tt>.  A fetching op lands the previous value in the
+ * local variable <tt>result_atomic</tt>.
+ */
+struct NNTI_atomic_update_t {
+    /** @brief Index of the target atomic variable. */
+    uint64_t         target_atomic;
+    /** @brief Index of the local result atomic variable. */
+    uint64_t         result_atomic;
+    /** @brief 64-bit operand to the atomic operation. */
+    int64_t          operand;
+    /** @brief Atomic operation to execute. */
+    NNTI_atomic_op_t op;
+};
+
+
 /***********  Work Request Types  ***********/
 
 /**
@@ -800,6 +868,21 @@ struct NNTI_work_request_t {
 };
 
 
+/***********  Counter Types  ***********/
+
+/**
+ * @brief handle to a target completion counter (see NNTI_counter_create())
+ *
+ */
+struct NNTI_counter_t {
+    /** @brief the transport that owns this counter */
+    NNTI_transport_id_t transport_id;
+
+    /** @brief Private storage (cast to a uint64_t). */
+    uint64_t     transport_private;
+};
+
+
 /***********  Transport Header Type  ***********/
 
 /**
@@ -844,6 +927,13 @@ struct NNTI_status_t {
     NNTI_peer_t src;
     /** @brief The peer that was the data destination for this operation. */
     NNTI_peer_t dest;
+
+    /**
+     * @brief The immediate value that came with an NNTI_put_notify().
+     *
+     * Only set in the target's status.  Zero for every other operation.
+     */
+    uint64_t imm;
 };
 
 
@@ -44,6 +44,7 @@
 #include "Trios_config.h"
 
 #include "Trios_logger.h"
+#include "Trios_timer.h"
 #include "buffer_queue.h"
 
 #include "assert.h"
@@ -104,6 +105,48 @@ static NNTI_result_t destroy_buffer(NNTI_buffer_t **buffer)
     return(nnti_rc);
 }
 
+/*
+ * Pick the home magazine of the calling thread.  Without pthreads all
+ * callers share magazine 0 and the queue degenerates to a single list.
+ */
+static uint32_t home_magazine(void)
+{
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    uint64_t h=(uint64_t)pthread_self();
+    h ^= (h >> 33);
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= (h >> 33);
+    return((uint32_t)(h % TRIOS_BUFFER_QUEUE_MAGAZINES));
+#else
+    return(0);
+#endif
+}
+
+static NNTI_buffer_t *magazine_pop(
+        trios_buffer_magazine_t *m)
+{
+    NNTI_buffer_t *buffer=NULL;
+
+    if (nthread_lock(&m->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    if (!m->queue.empty()) {
+        buffer=m->queue.front();
+        m->queue.pop_front();
+        m->hits++;
+    }
+    nthread_unlock(&m->mutex);
+
+    return(buffer);
+}
+
+static void magazine_push(
+        trios_buffer_magazine_t *m,
+        NNTI_buffer_t           *buffer)
+{
+    if (nthread_lock(&m->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    m->queue.push_front(buffer);
+    nthread_unlock(&m->mutex);
+}
+
 int trios_buffer_queue_init(
         trios_buffer_queue_t *bq,
         uint32_t              initial_size,
@@ -124,10 +167,16 @@ int trios_buffer_queue_init(
     }
 
     nthread_lock_init(&bq->mutex);
-
-    if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+        nthread_lock_init(&bq->magazine[i].mutex);
+        bq->magazine[i].hits=0;
+    }
 
     bq->current_size=0;
+    bq->fly_count=0;
+    bq->misses=0;
+    bq->registrations=0;
+    bq->deregistrations=0;
     bq->initial_size=initial_size;
     bq->max_size=max_size;
     bq->create_on_fly=create_on_fly;
@@ -135,6 +184,7 @@ int trios_buffer_queue_init(
     bq->op=op;
     bq->buffer_size=buffer_size;
 
+    /* the queue isn't visible to other threads yet, so no locking is required */
     for (uint32_t i=0;i<bq->initial_size;i++) {
         log_debug(bq_debug_level, "creating queue buffer");
         nnti_rc=create_buffer(
@@ -144,14 +194,14 @@ int trios_buffer_queue_init(
                 &buffer);
         if (nnti_rc==NNTI_OK) {
             log_debug(bq_debug_level, "pushing queue buffer");
-            bq->queue.push_back(buffer);
+            bq->magazine[i % TRIOS_BUFFER_QUEUE_MAGAZINES].queue.push_back(buffer);
             bq->current_size++;
+            bq->registrations++;
         } else {
             log_error(bq_debug_level, "failed creating queue buffer: %d", nnti_rc);
             break;
         }
     }
-    nthread_unlock(&bq->mutex);
 
     log_debug(bq_debug_level, "exit");
 
@@ -163,42 +213,71 @@ NNTI_buffer_t *trios_buffer_queue_pop(
 {
     NNTI_result_t nnti_rc=NNTI_OK;
     NNTI_buffer_t *buffer=NULL;
+    uint32_t       home=home_magazine();
+    bool           expand=false;
+    bool           on_the_fly=false;
 
     log_debug(bq_debug_level, "enter");
 
+    /* try the home magazine first, then steal from the others */
+    for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+        buffer=magazine_pop(&bq->magazine[(home+i) % TRIOS_BUFFER_QUEUE_MAGAZINES]);
+        if (buffer != NULL) {
+            log_debug(bq_debug_level, "got buffer from magazine %u (home=%u)", (home+i) % TRIOS_BUFFER_QUEUE_MAGAZINES, home);
+            log_debug(bq_debug_level, "exit");
+            return(buffer);
+        }
+    }
+
+    /*
+     * every magazine is empty.  reserve the right to create a buffer
+     * while holding the lock, but do the (expensive) registration
+     * after the lock is released.
+     */
     if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
-    if (!bq->queue.empty()) {
-        log_debug(bq_debug_level, "getting buffer from queue");
-        buffer=bq->queue.front();
-        bq->queue.pop_front();
-    } else {
-        if (bq->current_size < bq->max_size) {
-            nnti_rc=create_buffer(
-                    bq->trans_hdl,
-                    bq->op,
-                    bq->buffer_size,
-                    &buffer);
-            if (nnti_rc==NNTI_OK) {
+    bq->misses++;
+    if (bq->current_size < bq->max_size) {
+        bq->current_size++;
+        bq->registrations++;
+        expand=true;
+    } else if ((bq->current_size >= bq->max_size) && (bq->create_on_fly==TRUE)) {
+        bq->fly_count++;
+        bq->registrations++;
+        on_the_fly=true;
+    }
+    nthread_unlock(&bq->mutex);
+
+    if (expand || on_the_fly) {
+        nnti_rc=create_buffer(
+                bq->trans_hdl,
+                bq->op,
+                bq->buffer_size,
+                &buffer);
+        if (nnti_rc==NNTI_OK) {
+            if (expand) {
                 log_debug(bq_debug_level, "expanding buffer queue");
-                bq->current_size++;
             } else {
-                log_error(bq_debug_level, "failed creating queue buffer to expand the queue: %d", nnti_rc);
+                log_debug(bq_debug_level, "creating on the fly queue buffer");
             }
-        } else if ((bq->current_size == bq->max_size) && (bq->create_on_fly==TRUE)) {
-            nnti_rc=create_buffer(
-                    bq->trans_hdl,
-                    bq->op,
-                    bq->buffer_size,
-                    &buffer);
-            if (nnti_rc!=NNTI_OK) {
-                log_error(bq_debug_level, "failed creating on the fly queue buffer: %d", nnti_rc);
-                buffer=NULL;
+        } else {
+            /* give back the reservation */
+            if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+            if (expand) {
+                bq->current_size--;
             } else {
-                log_debug(bq_debug_level, "creating on the fly queue buffer");
+                bq->fly_count--;
             }
+            bq->registrations--;
+            nthread_unlock(&bq->mutex);
+
+            if (expand) {
+                log_error(bq_debug_level, "failed creating queue buffer to expand the queue: %d", nnti_rc);
+            } else {
+                log_error(bq_debug_level, "failed creating on the fly queue buffer: %d", nnti_rc);
+            }
+            buffer=NULL;
         }
     }
-    nthread_unlock(&bq->mutex);
 
     log_debug(bq_debug_level, "exit");
 
@@ -210,16 +289,29 @@ void trios_buffer_queue_push(
         NNTI_buffer_t       *buffer)
 {
     NNTI_result_t nnti_rc=NNTI_OK;
+    bool          destroy=false;
 
     log_debug(bq_debug_level, "enter");
 
+    /*
+     * queued buffers are interchangeable, so it doesn't matter whether
+     * this particular buffer was created on the fly.  as long as there
+     * are on the fly buffers outstanding, one returning buffer is destroyed.
+     */
     if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get lock");
-    if (bq->queue.size() < bq->max_size) {
+    if (bq->fly_count > 0) {
+        bq->fly_count--;
+        bq->deregistrations++;
+        destroy=true;
+    }
+    nthread_unlock(&bq->mutex);
+
+    if (!destroy) {
         /* when buffers are popped, the size could be reduced to avoid transferring more bytes than necessary */
         log_debug(bq_debug_level, "reset buffer size to bq->buffer_size");
         NNTI_BUFFER_SIZE(buffer)=bq->buffer_size;
         log_debug(bq_debug_level, "returning buffer to queue");
-        bq->queue.push_front(buffer);
+        magazine_push(&bq->magazine[home_magazine()], buffer);
     } else {
         nnti_rc=destroy_buffer(&buffer);
         if (nnti_rc!=NNTI_OK) {
@@ -228,9 +320,123 @@ void trios_buffer_queue_push(
             log_debug(bq_debug_level, "destroying on the fly queue buffer");
         }
     }
+
+    log_debug(bq_debug_level, "exit");
+}
+
+static uint32_t queue_max_size(
+        trios_buffer_queue_t *bq)
+{
+    uint32_t max_size=0;
+
+    if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    max_size=bq->max_size;
+    nthread_unlock(&bq->mutex);
+
+    return(max_size);
+}
+
+/*
+ * Change the number of buffers the queue keeps.  Growing adopts
+ * outstanding on the fly buffers into the queue so they are kept
+ * when pushed.  Shrinking destroys idle buffers beyond the new
+ * max_size; buffers that are popped at the moment are converted to
+ * on the fly buffers and destroyed when they are pushed.  The number
+ * of buffers the queue gave up is returned in *released.
+ */
+static int resize_queue(
+        trios_buffer_queue_t *bq,
+        uint32_t              max_size,
+        uint32_t             *released)
+{
+    NNTI_result_t  nnti_rc=NNTI_OK;
+    NNTI_buffer_t *buffer=NULL;
+    uint32_t       excess=0;
+    uint32_t       adopt=0;
+
+    log_debug(bq_debug_level, "enter");
+
+    if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    if (max_size > bq->current_size) {
+        adopt=max_size - bq->current_size;
+        if (adopt > bq->fly_count) adopt=bq->fly_count;
+        bq->fly_count    -= adopt;
+        bq->current_size += adopt;
+    } else {
+        excess=bq->current_size - max_size;
+    }
+    bq->max_size=max_size;
     nthread_unlock(&bq->mutex);
 
+    if (released != NULL) *released=excess;
+
+    log_debug(bq_debug_level, "resized queue (%p) to max_size=%u (adopted=%u, excess=%u)", bq, max_size, adopt, excess);
+
+    while (excess > 0) {
+        buffer=NULL;
+        for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+            if (nthread_lock(&bq->magazine[i].mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+            if (!bq->magazine[i].queue.empty()) {
+                buffer=bq->magazine[i].queue.back();
+                bq->magazine[i].queue.pop_back();
+            }
+            nthread_unlock(&bq->magazine[i].mutex);
+            if (buffer != NULL) break;
+        }
+
+        if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+        bq->current_size--;
+        if (buffer != NULL) {
+            bq->deregistrations++;
+        } else {
+            /* nothing idle.  the next push of a popped buffer destroys it. */
+            bq->fly_count++;
+        }
+        nthread_unlock(&bq->mutex);
+
+        if (buffer != NULL) {
+            nnti_rc=destroy_buffer(&buffer);
+            if (nnti_rc!=NNTI_OK) {
+                log_error(bq_debug_level, "failed destroying trimmed queue buffer: %d", nnti_rc);
+            }
+        }
+        excess--;
+    }
+
     log_debug(bq_debug_level, "exit");
+
+    return((int)nnti_rc);
+}
+
+int trios_buffer_queue_resize(
+        trios_buffer_queue_t *bq,
+        uint32_t              max_size)
+{
+    return(resize_queue(bq, max_size, NULL));
+}
+
+void trios_buffer_queue_get_stats(
+        trios_buffer_queue_t       *bq,
+        trios_buffer_queue_stats_t *stats)
+{
+    memset(stats, 0, sizeof(trios_buffer_queue_stats_t));
+
+    for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+        if (nthread_lock(&bq->magazine[i].mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+        stats->hits += bq->magazine[i].hits;
+        nthread_unlock(&bq->magazine[i].mutex);
+    }
+
+    if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    stats->buffer_size    =bq->buffer_size;
+    stats->misses         =bq->misses;
+    stats->registrations  =bq->registrations;
+    stats->deregistrations=bq->deregistrations;
+    stats->pooled         =bq->current_size;
+    stats->on_the_fly     =bq->fly_count;
+    nthread_unlock(&bq->mutex);
+
+    stats->bytes_held=(uint64_t)(stats->pooled + stats->on_the_fly) * stats->buffer_size;
 }
 
 int trios_buffer_queue_fini(
@@ -238,36 +444,306 @@ int trios_buffer_queue_fini(
 {
     NNTI_result_t nnti_rc=NNTI_OK;
     NNTI_buffer_t *buffer=NULL;
+    buffer_queue_t drained;
 
     log_debug(bq_debug_level, "enter");
 
-    if (nthread_lock(&bq->mutex)) log_warn(bq_debug_level, "failed to get lock");
-    if (bq->queue.size() != bq->current_size) {
-        log_warn(bq_debug_level, "buffer queue (%p) has missing entries (bq->queue.size(%llu) != bq->current_size(%llu))",
-                bq, (uint64_t)bq->queue.size(), (uint64_t)bq->current_size);
+    for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+        if (nthread_lock(&bq->magazine[i].mutex)) log_warn(bq_debug_level, "failed to get lock");
+        drained.insert(drained.end(), bq->magazine[i].queue.begin(), bq->magazine[i].queue.end());
+        bq->magazine[i].queue.clear();
+        nthread_unlock(&bq->magazine[i].mutex);
     }
-    if (bq->queue.size() < bq->initial_size) {
-        log_warn(bq_debug_level, "buffer queue (%p) has missing entries (bq->queue.size(%llu) < bq->initial_size(%llu))",
-                bq, (uint64_t)bq->queue.size(), (uint64_t)bq->initial_size);
+
+    if (drained.size() != bq->current_size) {
+        log_warn(bq_debug_level, "buffer queue (%p) has missing entries (queued(%llu) != bq->current_size(%llu))",
+                bq, (uint64_t)drained.size(), (uint64_t)bq->current_size);
+    }
+    if (drained.size() < bq->initial_size) {
+        log_warn(bq_debug_level, "buffer queue (%p) has missing entries (queued(%llu) < bq->initial_size(%llu))",
+                bq, (uint64_t)drained.size(), (uint64_t)bq->initial_size);
     }
-    if (bq->queue.size() > bq->max_size) {
-        log_warn(bq_debug_level, "buffer queue (%p) has extra entries (bq->queue.size(%llu) > bq->max_size(%llu))",
-                bq, (uint64_t)bq->queue.size(), (uint64_t)bq->max_size);
+    if (drained.size() > bq->max_size) {
+        log_warn(bq_debug_level, "buffer queue (%p) has extra entries (queued(%llu) > bq->max_size(%llu))",
+                bq, (uint64_t)drained.size(), (uint64_t)bq->max_size);
     }
-    while (!bq->queue.empty()) {
-        buffer=bq->queue.front();
-        bq->queue.pop_front();
+    while (!drained.empty()) {
+        buffer=drained.front();
+        drained.pop_front();
         nnti_rc=destroy_buffer(&buffer);
         if (nnti_rc!=NNTI_OK) {
             log_error(bq_debug_level, "failed destroying queue buffer: %d", nnti_rc);
             break;
         }
     }
-    nthread_unlock(&bq->mutex);
 
+    for (uint32_t i=0;i<TRIOS_BUFFER_QUEUE_MAGAZINES;i++) {
+        nthread_lock_fini(&bq->magazine[i].mutex);
+    }
     nthread_lock_fini(&bq->mutex);
 
     log_debug(bq_debug_level, "exit");
 
     return((int)nnti_rc);
 }
+
+
+int trios_buffer_pool_init(
+        trios_buffer_pool_t *pool,
+        uint32_t             class_count,
+        const uint32_t      *class_sizes,
+        uint32_t             initial_per_class,
+        uint32_t             max_per_class,
+        long                 decay_ms,
+        NNTI_transport_t    *trans_hdl,
+        NNTI_buf_ops_t       op)
+{
+    int rc=0;
+
+    log_debug(bq_debug_level, "enter");
+
+    /* a pool that fails to initialize has no classes */
+    pool->class_count=0;
+
+    if ((class_count == 0) || (class_count > TRIOS_BUFFER_POOL_MAX_CLASSES)) {
+        log_error(bq_debug_level, "class_count(%u) must be between 1 and %u", class_count, TRIOS_BUFFER_POOL_MAX_CLASSES);
+        return((int)NNTI_EINVAL);
+    }
+    for (uint32_t i=1;i<class_count;i++) {
+        if (class_sizes[i] <= class_sizes[i-1]) {
+            log_error(bq_debug_level, "class_sizes must be strictly increasing (class_sizes[%u]=%u, class_sizes[%u]=%u)",
+                    i-1, class_sizes[i-1], i, class_sizes[i]);
+            return((int)NNTI_EINVAL);
+        }
+    }
+    if (initial_per_class > max_per_class) {
+        initial_per_class=max_per_class;
+    }
+
+    nthread_lock_init(&pool->mutex);
+
+    pool->class_count  =class_count;
+    pool->max_per_class=max_per_class;
+    pool->decay_ms     =decay_ms;
+    pool->last_trim_ms =trios_get_time_ms();
+
+    for (uint32_t i=0;i<class_count;i++) {
+        /* start small and let the high-water mark pull max_size up to max_per_class */
+        rc=trios_buffer_queue_init(
+                &pool->cls[i].queue,
+                initial_per_class,
+                initial_per_class,
+                TRUE,
+                trans_hdl,
+                op,
+                class_sizes[i]);
+        if (rc != NNTI_OK) {
+            log_error(bq_debug_level, "failed creating size class %u (buffer_size=%u): %d", i, class_sizes[i], rc);
+            /* release the classes that were created and leave the pool empty */
+            trios_buffer_queue_fini(&pool->cls[i].queue);
+            while (i > 0) {
+                trios_buffer_queue_fini(&pool->cls[--i].queue);
+            }
+            pool->class_count=0;
+            nthread_lock_fini(&pool->mutex);
+            break;
+        }
+        pool->cls[i].outstanding   =0;
+        pool->cls[i].high_water    =0;
+        pool->cls[i].last_active_ms=pool->last_trim_ms;
+    }
+
+    log_debug(bq_debug_level, "exit");
+
+    return(rc);
+}
+
+NNTI_buffer_t *trios_buffer_pool_pop(
+        trios_buffer_pool_t *pool,
+        uint32_t             size)
+{
+    NNTI_buffer_t        *buffer=NULL;
+    trios_buffer_class_t *c=NULL;
+    uint32_t              index=0;
+    uint32_t              max_size=0;
+    uint32_t              grow_to=0;
+
+    log_debug(bq_debug_level, "enter");
+
+    for (index=0;index<pool->class_count;index++) {
+        if (pool->cls[index].queue.buffer_size >= size) {
+            c=&pool->cls[index];
+            break;
+        }
+    }
+    if (c == NULL) {
+        if (pool->class_count == 0) {
+            log_warn(bq_debug_level, "buffer pool (%p) has no size classes", pool);
+        } else {
+            log_warn(bq_debug_level, "no size class fits a %u byte request (largest is %u bytes)",
+                    size, pool->cls[pool->class_count-1].queue.buffer_size);
+        }
+        return(NULL);
+    }
+
+    buffer=trios_buffer_queue_pop(&c->queue);
+    if (buffer == NULL) {
+        log_debug(bq_debug_level, "exit");
+        return(NULL);
+    }
+    max_size=queue_max_size(&c->queue);
+
+    if (nthread_lock(&pool->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    pool->owner[buffer]=index;
+    c->outstanding++;
+    c->last_active_ms=trios_get_time_ms();
+    if (c->outstanding > c->high_water) {
+        c->high_water=c->outstanding;
+        if ((c->high_water > max_size) && (max_size < pool->max_per_class)) {
+            grow_to=(c->high_water < pool->max_per_class) ? c->high_water : pool->max_per_class;
+        }
+    }
+    nthread_unlock(&pool->mutex);
+
+    if (grow_to > 0) {
+        log_debug(bq_debug_level, "growing size class %u to %u buffers", index, grow_to);
+        trios_buffer_queue_resize(&c->queue, grow_to);
+    }
+
+    log_debug(bq_debug_level, "exit");
+
+    return(buffer);
+}
+
+void trios_buffer_pool_push(
+        trios_buffer_pool_t *pool,
+        NNTI_buffer_t       *buffer)
+{
+    buffer_class_map_t::iterator iter;
+    uint32_t index=0;
+    bool     found=false;
+    bool     trim=false;
+    long     now=trios_get_time_ms();
+
+    log_debug(bq_debug_level, "enter");
+
+    if (nthread_lock(&pool->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    iter=pool->owner.find(buffer);
+    if (iter != pool->owner.end()) {
+        index=iter->second;
+        pool->owner.erase(iter);
+        pool->cls[index].outstanding--;
+        pool->cls[index].last_active_ms=now;
+        found=true;
+    }
+    if ((pool->decay_ms > 0) && (now - pool->last_trim_ms >= pool->decay_ms)) {
+        pool->last_trim_ms=now;
+        trim=true;
+    }
+    nthread_unlock(&pool->mutex);
+
+    if (found) {
+        trios_buffer_queue_push(&pool->cls[index].queue, buffer);
+    } else {
+        log_error(bq_debug_level, "buffer (%p) was not popped from pool (%p)", buffer, pool);
+    }
+
+    if (trim) {
+        trios_buffer_pool_trim(pool);
+    }
+
+    log_debug(bq_debug_level, "exit");
+}
+
+/*
+ * Halve the high-water mark of every class that has been idle for at
+ * least decay_ms and shrink its queue to match.  Returns the number of
+ * buffers the queues gave up.
+ */
+uint32_t trios_buffer_pool_trim(
+        trios_buffer_pool_t *pool)
+{
+    uint32_t released=0;
+    uint32_t max_size[TRIOS_BUFFER_POOL_MAX_CLASSES];
+    uint32_t shrink_to[TRIOS_BUFFER_POOL_MAX_CLASSES];
+    long     now=trios_get_time_ms();
+
+    log_debug(bq_debug_level, "enter");
+
+    for (uint32_t i=0;i<pool->class_count;i++) {
+        max_size[i]=queue_max_size(&pool->cls[i].queue);
+    }
+
+    if (nthread_lock(&pool->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    for (uint32_t i=0;i<pool->class_count;i++) {
+        trios_buffer_class_t *c=&pool->cls[i];
+
+        shrink_to[i]=max_size[i];
+        if (now - c->last_active_ms < pool->decay_ms) {
+            continue;
+        }
+        c->high_water=(c->high_water + c->outstanding) / 2;
+        if (c->high_water < c->outstanding) {
+            c->high_water=c->outstanding;
+        }
+        shrink_to[i]=(c->high_water > c->queue.initial_size) ? c->high_water : c->queue.initial_size;
+        c->last_active_ms=now;
+    }
+    nthread_unlock(&pool->mutex);
+
+    for (uint32_t i=0;i<pool->class_count;i++) {
+        uint32_t class_released=0;
+        if (shrink_to[i] < max_size[i]) {
+            log_debug(bq_debug_level, "trimming size class %u from %u to %u buffers", i, max_size[i], shrink_to[i]);
+            /* max_size can be ahead of the buffers actually created, so count what the queue gave up */
+            resize_queue(&pool->cls[i].queue, shrink_to[i], &class_released);
+            released += class_released;
+        }
+    }
+
+    log_debug(bq_debug_level, "exit");
+
+    return(released);
+}
+
+int trios_buffer_pool_get_stats(
+        trios_buffer_pool_t       *pool,
+        uint32_t                   class_index,
+        trios_buffer_pool_stats_t *stats)
+{
+    if (class_index >= pool->class_count) {
+        return((int)NNTI_EINVAL);
+    }
+
+    trios_buffer_queue_get_stats(&pool->cls[class_index].queue, &stats->queue);
+
+    if (nthread_lock(&pool->mutex)) log_warn(bq_debug_level, "failed to get thread lock");
+    stats->outstanding=pool->cls[class_index].outstanding;
+    stats->high_water =pool->cls[class_index].high_water;
+    nthread_unlock(&pool->mutex);
+
+    return((int)NNTI_OK);
+}
+
+int trios_buffer_pool_fini(
+        trios_buffer_pool_t *pool)
+{
+    int rc=NNTI_OK;
+
+    log_debug(bq_debug_level, "enter");
+
+    if (!pool->owner.empty()) {
+        log_warn(bq_debug_level, "buffer pool (%p) has %llu buffers outstanding", pool, (uint64_t)pool->owner.size());
+    }
+    for (uint32_t i=0;i<pool->class_count;i++) {
+        int class_rc=trios_buffer_queue_fini(&pool->cls[i].queue);
+        if (class_rc != NNTI_OK) rc=class_rc;
+    }
+    pool->owner.clear();
+
+    nthread_lock_fini(&pool->mutex);
+
+    log_debug(bq_debug_level, "exit");
+
+    return(rc);
+}
@@ -43,7 +43,8 @@
 /*-------------------------------------------------------------------------*/
 /**  @file buffer_queue.h
  *
- *   @brief API for a circular list of NNTI_buffer_t.
+ *   @brief API for a circular list of NNTI_buffer_t and a size-classed
+ *          pool built from several of them.
  *
  *   @author Todd Kordenbrock (thkorde\@sandia.gov).
  *
@@ -60,21 +61,87 @@
 #include "Trios_nnti.h"
 
 #include <deque>
+#include <map>
 
 typedef std::deque<NNTI_buffer_t *>  buffer_queue_t;
 
-typedef struct trios_buffer_queue {
+/*
+ * Free buffers are spread across several magazines.  Each thread
+ * hashes to a home magazine, so concurrent pop/push from different
+ * threads rarely touch the same lock.  An empty home magazine steals
+ * from its neighbors before a new buffer is created.
+ */
+#define TRIOS_BUFFER_QUEUE_MAGAZINES 8
+
+typedef struct trios_buffer_magazine {
     nthread_lock_t    mutex;
     buffer_queue_t    queue;
-    uint32_t          current_size;
-    uint32_t          initial_size;
-    uint32_t          max_size;
-    uint8_t           create_on_fly;
-    NNTI_transport_t *trans_hdl;
-    NNTI_buf_ops_t    op;
-    uint32_t          buffer_size;
+    uint64_t          hits;
+} trios_buffer_magazine_t;
+
+typedef struct trios_buffer_queue {
+    nthread_lock_t          mutex;         /* protects current_size and fly_count only */
+    trios_buffer_magazine_t magazine[TRIOS_BUFFER_QUEUE_MAGAZINES];
+    uint32_t                current_size;  /* number of pooled buffers created (<= max_size) */
+    uint32_t                fly_count;     /* number of on the fly buffers currently outstanding */
+    uint32_t                initial_size;
+    uint32_t                max_size;
+    uint8_t                 create_on_fly;
+    NNTI_transport_t       *trans_hdl;
+    NNTI_buf_ops_t          op;
+    uint32_t                buffer_size;
+    uint64_t                misses;
+    uint64_t                registrations;
+    uint64_t                deregistrations;
 } trios_buffer_queue_t;
 
+typedef struct trios_buffer_queue_stats {
+    uint32_t buffer_size;
+    uint64_t hits;             /* pops satisfied by a queued buffer */
+    uint64_t misses;           /* pops that found every magazine empty */
+    uint64_t registrations;    /* buffers created (NNTI_alloc) */
+    uint64_t deregistrations;  /* buffers destroyed (NNTI_free) */
+    uint32_t pooled;           /* buffers owned by the queue (queued or popped) */
+    uint32_t on_the_fly;       /* on the fly buffers currently outstanding */
+    uint64_t bytes_held;       /* (pooled + on_the_fly) * buffer_size */
+} trios_buffer_queue_stats_t;
+
+
+/*
+ * A buffer pool is a set of buffer queues of increasing buffer size
+ * (size classes).  A pop is served by the smallest class that fits.
+ * Each class tracks the high-water mark of buffers outstanding and
+ * grows its max_size toward it, so bursts stop churning registrations.
+ * Classes that sit idle for decay_ms have their high-water mark halved
+ * and surplus idle buffers released.
+ */
+#define TRIOS_BUFFER_POOL_MAX_CLASSES 16
+
+typedef std::map<NNTI_buffer_t *, uint32_t>  buffer_class_map_t;
+
+typedef struct trios_buffer_class {
+    trios_buffer_queue_t queue;
+    uint32_t             outstanding;
+    uint32_t             high_water;
+    long                 last_active_ms;
+} trios_buffer_class_t;
+
+typedef struct trios_buffer_pool {
+    nthread_lock_t       mutex;        /* protects owner and the per-class counters */
+    buffer_class_map_t   owner;        /* popped buffer -> class index */
+    trios_buffer_class_t cls[TRIOS_BUFFER_POOL_MAX_CLASSES];
+    uint32_t             class_count;
+    uint32_t             max_per_class;
+    long                 decay_ms;     /* 0 disables trimming */
+    long                 last_trim_ms;
+} trios_buffer_pool_t;
+
+typedef struct trios_buffer_pool_stats {
+    trios_buffer_queue_stats_t queue;
+    uint32_t                   outstanding;
+    uint32_t                   high_water;
+} trios_buffer_pool_stats_t;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -95,9 +162,39 @@ extern "C" {
     extern void trios_buffer_queue_push(
             trios_buffer_queue_t *bq,
             NNTI_buffer_t       *buffer);
+    extern int trios_buffer_queue_resize(
+            trios_buffer_queue_t *bq,
+            uint32_t              max_size);
+    extern void trios_buffer_queue_get_stats(
+            trios_buffer_queue_t       *bq,
+            trios_buffer_queue_stats_t *stats);
     extern int trios_buffer_queue_fini(
             trios_buffer_queue_t *bq);
 
+    extern int trios_buffer_pool_init(
+            trios_buffer_pool_t *pool,
+            uint32_t             class_count,
+            const uint32_t      *class_sizes,
+            uint32_t             initial_per_class,
+            uint32_t             max_per_class,
+            long                 decay_ms,
+            NNTI_transport_t    *trans_hdl,
+            NNTI_buf_ops_t       op);
+    extern NNTI_buffer_t *trios_buffer_pool_pop(
+            trios_buffer_pool_t *pool,
+            uint32_t             size);
+    extern void trios_buffer_pool_push(
+            trios_buffer_pool_t *pool,
+            NNTI_buffer_t       *buffer);
+    extern uint32_t trios_buffer_pool_trim(
+            trios_buffer_pool_t *pool);
+    extern int trios_buffer_pool_get_stats(
+            trios_buffer_pool_t       *pool,
+            uint32_t                   class_index,
+            trios_buffer_pool_stats_t *stats);
+    extern int trios_buffer_pool_fini(
+            trios_buffer_pool_t *pool);
+
 #endif
 
 
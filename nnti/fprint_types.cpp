@@ -452,6 +452,7 @@ void fprint_NNTI_status(
     out << subprefix << " start  = " << status->start << std::endl;
     out << subprefix << " offset = " << status->offset << std::endl;
     out << subprefix << " length = " << status->length << std::endl;
+    out << subprefix << " imm    = " << status->imm << std::endl;
     fprint_NNTI_peer(out, "src", subprefix.c_str(), &status->src);
     fprint_NNTI_peer(out, "dest", subprefix.c_str(), &status->dest);
 
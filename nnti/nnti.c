@@ -51,10 +51,12 @@
 
 #include "Trios_config.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "Trios_nnti.h"
 #include "nnti_internal.h"
+#include "nnti_utils.h"
 
 #if defined(HAVE_TRIOS_PORTALS) || defined(HAVE_TRIOS_CRAYPORTALS)
 #include "nnti_ptls.h"
@@ -76,6 +78,11 @@
 #endif
 
 #include "Trios_logger.h"
+#include "Trios_timer.h"
+
+#if defined(HAVE_TRIOS_PTHREAD_H)
+#include <pthread.h>
+#endif
 
 
 
@@ -86,694 +93,3451 @@ log_level nnti_debug_level = LOG_UNDEFINED;
 static NNTI_internal_transport_t available_transports[NNTI_TRANSPORT_COUNT];
 
 
-/**
- * @brief Initialize NNTI to use a specific transport.
- *
- * Enable the use of a particular transport by this process.  <tt>my_url</tt>
- * allows the process to have some control (if possible) over the
- * URL assigned for the transport.  For example, a Portals URL to put
- * might be "ptl://-1,128".  This would tell Portals to use the default
- * network ID, but use PID=128.  If the transport
- * can be initialized without this info (eg. a Portals client), <tt>my_url</tt> can
- * be NULL or empty.
- *
+/*
+ * Active messages (see NNTI_am_register()).  They travel as ordinary
+ * requests and are recognized by the header where requests come off the
+ * receive queue, so every transport with a receive queue supports them.
+ * A request is only taken as an active message when its payload fits in
+ * the request and its handler is registered.
  */
-NNTI_result_t NNTI_init (
-        const NNTI_transport_id_t  trans_id,
-        const char                *my_url,
-        NNTI_transport_t          *trans_hdl)
+#define NNTI_AM_MAGIC 0x4e4e54495f414d31ULL  /* "NNTI_AM1" */
+
+typedef struct {
+    uint64_t magic;
+    uint32_t id;
+    uint32_t length;
+} nnti_am_header;
+
+typedef struct {
+    NNTI_am_handler_fn_t handler;
+    void                *context;
+} nnti_am_handler;
+
+typedef struct {
+    nthread_lock_t          lock;
+    const NNTI_transport_t *trans_hdl;
+    uint32_t                handler_count;
+    nnti_am_handler         handlers[NNTI_AM_MAX_HANDLERS];
+
+    /* see NNTI_am_start_threads() */
+    NNTI_buffer_t          *thread_queue;
+    uint32_t                thread_count;
+    volatile int8_t         thread_stop;
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    pthread_t              *threads;
+#endif
+} nnti_am_table;
+
+static nnti_am_table am_tables[NNTI_TRANSPORT_COUNT];
+
+/* requests taken per NNTI_dequeue_requests() by a handler thread */
+#define NNTI_AM_THREAD_BATCH 16
+
+
+/*
+ * If the request described by <tt>status</tt> is an active message for a
+ * registered handler, run the handler on the payload in place and return
+ * TRUE.  The caller recycles the slot.  Anything else goes back to the
+ * caller as an ordinary request.
+ */
+static int8_t am_dispatch(
+        const NNTI_transport_id_t  id,
+        const NNTI_status_t       *status)
 {
-    NNTI_result_t rc=NNTI_OK;
-    static int8_t first_init=TRUE;
+    nnti_am_table        *t=&am_tables[id];
+    nnti_am_header       *hdr=NULL;
+    NNTI_am_handler_fn_t  handler=NULL;
+    void                 *context=NULL;
+    NNTI_result_t         rc=NNTI_OK;
+
+    if (status->length < NNTI_AM_HEADER_SIZE) {
+        return(FALSE);
+    }
+    hdr=(nnti_am_header *)(status->start + status->offset);
+    if (hdr->magic != NNTI_AM_MAGIC) {
+        return(FALSE);
+    }
 
-    if (first_init==TRUE) {
-        memset(&available_transports[0], 0, NNTI_TRANSPORT_COUNT*sizeof(NNTI_internal_transport_t));
-        first_init=FALSE;
+    if ((hdr->id >= NNTI_AM_MAX_HANDLERS) || ((uint64_t)hdr->length + NNTI_AM_HEADER_SIZE > status->length)) {
+        log_debug(nnti_debug_level, "request isn't an active message (id=%u ; length=%u ; request length=%llu)",
+                hdr->id, hdr->length, (unsigned long long)status->length);
+        return(FALSE);
     }
 
-#if defined(HAVE_TRIOS_PORTALS) || defined(HAVE_TRIOS_CRAYPORTALS)
-    if (trans_id == NNTI_TRANSPORT_PORTALS) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_ptl_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_ptl_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_ptl_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_ptl_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_ptl_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_ptl_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_ptl_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_ptl_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_ptl_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_ptl_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_ptl_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_ptl_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_ptl_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_ptl_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_ptl_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_ptl_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_ptl_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_ptl_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_ptl_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_ptl_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_ptl_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_ptl_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_ptl_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_ptl_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_ptl_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_ptl_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_ptl_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_ptl_fini;
+    nthread_lock(&t->lock);
+    handler=t->handlers[hdr->id].handler;
+    context=t->handlers[hdr->id].context;
+    nthread_unlock(&t->lock);
+
+    if (handler == NULL) {
+        log_debug(nnti_debug_level, "returning an active message for unregistered handler %u", hdr->id);
+        return(FALSE);
     }
-#endif
-#if defined(HAVE_TRIOS_INFINIBAND)
-    if (trans_id == NNTI_TRANSPORT_IB) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_ib_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_ib_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_ib_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_ib_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_ib_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_ib_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_ib_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_ib_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_ib_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_ib_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_ib_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_ib_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_ib_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_ib_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_ib_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_ib_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_ib_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_ib_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_ib_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_ib_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_ib_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_ib_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_ib_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_ib_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_ib_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_ib_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_ib_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_ib_fini;
+
+    rc=handler(t->trans_hdl, &status->src, (char *)hdr + NNTI_AM_HEADER_SIZE, hdr->length, context);
+    if (rc != NNTI_OK) {
+        log_debug(nnti_debug_level, "active message handler %u returned %d", hdr->id, rc);
     }
-#endif
-#if defined(HAVE_TRIOS_GEMINI)
-    if (trans_id == NNTI_TRANSPORT_GEMINI) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_gni_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_gni_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_gni_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_gni_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_gni_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_gni_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_gni_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_gni_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_gni_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_gni_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_gni_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_gni_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_gni_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_gni_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_gni_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_gni_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_gni_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_gni_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_gni_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_gni_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_gni_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_gni_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_gni_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_gni_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_gni_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_gni_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_gni_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_gni_fini;
+
+    return(TRUE);
+}
+
+/*
+ * Does this work request take requests off a receive queue that may carry
+ * active messages?
+ */
+static int8_t am_watched(
+        const NNTI_work_request_t *wr)
+{
+    if (am_tables[wr->transport_id].handler_count == 0) {
+        return(FALSE);
     }
-#endif
-#if defined(HAVE_TRIOS_BGPDCMF)
-    if (trans_id == NNTI_TRANSPORT_DCMF) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_bgpdcmf_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_bgpdcmf_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_bgpdcmf_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_bgpdcmf_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_bgpdcmf_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_bgpdcmf_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_bgpdcmf_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_bgpdcmf_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_bgpdcmf_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_bgpdcmf_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_bgpdcmf_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_bgpdcmf_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_bgpdcmf_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_bgpdcmf_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_bgpdcmf_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_bgpdcmf_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_bgpdcmf_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_bgpdcmf_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_bgpdcmf_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_bgpdcmf_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_bgpdcmf_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_bgpdcmf_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_bgpdcmf_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_bgpdcmf_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_bgpdcmf_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_bgpdcmf_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_bgpdcmf_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_bgpdcmf_fini;
+    return((wr->ops == NNTI_BOP_RECV_QUEUE) || (wr->ops == NNTI_BOP_RECV_RING));
+}
+
+/*
+ * Milliseconds left of <tt>timeout</tt> (-1 if it is infinite, 0 if it has expired).
+ */
+static int am_remaining(
+        const int  timeout,
+        const long entry_time)
+{
+    long elapsed_time=0;
+
+    if (timeout < 0) {
+        return(-1);
     }
-#endif
-#if defined(HAVE_TRIOS_BGQPAMI)
-    if (trans_id == NNTI_TRANSPORT_PAMI) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_bgqpami_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_bgqpami_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_bgqpami_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_bgqpami_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_bgqpami_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_bgqpami_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_bgqpami_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_bgqpami_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_bgqpami_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_bgqpami_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_bgqpami_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_bgqpami_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_bgqpami_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_bgqpami_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_bgqpami_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_bgqpami_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_bgqpami_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_bgqpami_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_bgqpami_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_bgqpami_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_bgqpami_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_bgqpami_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_bgqpami_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_bgqpami_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_bgqpami_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_bgqpami_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_bgqpami_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_bgqpami_fini;
+    elapsed_time=trios_get_time_ms() - entry_time;
+    if (elapsed_time >= timeout) {
+        return(0);
+    }
+    return(timeout - (int)elapsed_time);
+}
+
+#if defined(HAVE_TRIOS_PTHREAD_H)
+static void *am_thread(
+        void *arg)
+{
+    nnti_am_table       *t=(nnti_am_table *)arg;
+    NNTI_work_request_t  wr_list[NNTI_AM_THREAD_BATCH];
+    NNTI_status_t        status_list[NNTI_AM_THREAD_BATCH];
+    uint32_t             count=0;
+
+    while (!t->thread_stop) {
+        /* NNTI_dequeue_requests() runs the handlers and only returns the rest */
+        NNTI_dequeue_requests(t->thread_queue, NNTI_AM_THREAD_BATCH, 100, wr_list, status_list, &count);
+        if (count > 0) {
+            log_warn(nnti_debug_level, "handler thread dropping %u requests that aren't active messages", count);
+            NNTI_release_requests(wr_list, count);
+        }
     }
+
+    return(NULL);
+}
 #endif
-#if defined(HAVE_TRIOS_MPI)
-    if (trans_id == NNTI_TRANSPORT_MPI) {
-        available_transports[trans_id].initialized                      = 1;
-        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_mpi_init;
-        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_mpi_get_url;
-        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_mpi_connect;
-        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_mpi_disconnect;
-        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_mpi_alloc;
-        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_mpi_free;
-        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_mpi_register_memory;
-        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_mpi_register_segments;
-        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_mpi_unregister_memory;
-        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_mpi_send;
-        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_mpi_put;
-        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_mpi_get;
-        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_mpi_scatter;
-        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_mpi_gather;
-        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_mpi_atomic_set_callback;
-        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_mpi_atomic_read;
-        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_mpi_atomic_fop;
-        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_mpi_atomic_cswap;
-        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_mpi_create_work_request;
-        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_mpi_clear_work_request;
-        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_mpi_destroy_work_request;
-        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_mpi_cancel;
-        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_mpi_cancelall;
-        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_mpi_interrupt;
-        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_mpi_wait;
-        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_mpi_waitany;
-        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_mpi_waitall;
-        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_mpi_fini;
+
+static void am_stop_threads(
+        nnti_am_table *t)
+{
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    uint32_t i=0;
+
+    nthread_lock(&t->lock);
+    t->thread_stop=TRUE;
+    nthread_unlock(&t->lock);
+
+    for (i=0;i<t->thread_count;i++) {
+        pthread_join(t->threads[i], NULL);
     }
+
+    nthread_lock(&t->lock);
+    free(t->threads);
+    t->threads     =NULL;
+    t->thread_count=0;
+    t->thread_queue=NULL;
+    nthread_unlock(&t->lock);
 #endif
+}
 
-    trans_hdl->datatype = NNTI_dt_transport;
-    trans_hdl->id       = trans_id;
 
-    rc = available_transports[trans_id].ops.nnti_init_fn(
-            trans_id,
-            my_url,
-            trans_hdl);
+/*
+ * Rendezvous for requests too large for a receive queue slot (see
+ * NNTI_send()).  The sender queues a header that carries the packed
+ * message buffer and a reply buffer.  The receiver gets the message and
+ * sends a reply that completes the sender's work request.  Each side keeps
+ * a slot per rendezvous so the wait functions can finish the protocol when
+ * the caller's work request completes.
+ */
+#define NNTI_RV_MAGIC 0x4e4e54495f525631ULL  /* "NNTI_RV1" */
+
+typedef struct {
+    uint64_t magic;
+    uint64_t length;
+    /* the packed message buffer and reply buffer follow */
+    uint32_t msg_len;
+    uint32_t reply_len;
+} nnti_rv_header;
+
+typedef enum {
+    NNTI_RV_FREE=0,
+    NNTI_RV_SENDING,
+    NNTI_RV_PULLING,
+    /* the caller is done but ctrl_wr is still in flight */
+    NNTI_RV_DRAINING
+} nnti_rv_state;
+
+typedef struct {
+    nnti_rv_state        state;
+    NNTI_work_request_t *user_wr;
+
+    /*
+     * the header (sender) or the reply (receiver) goes out of ctrl.  the
+     * reply is NNTI_RV_MAGIC followed by the result of the pull.
+     */
+    int8_t               ctrl_allocated;
+    NNTI_buffer_t        ctrl;
+    NNTI_work_request_t  ctrl_wr;
+
+    /* sender: the receiver's reply lands here */
+    int8_t               reply_allocated;
+    NNTI_buffer_t        reply;
+    const NNTI_buffer_t *msg_hdl;
+
+    /* receiver: unpacked from the header */
+    int8_t               unpacked;
+    NNTI_buffer_t        remote_msg;
+    NNTI_buffer_t        remote_reply;
+} nnti_rv_slot;
+
+typedef struct {
+    nthread_lock_t    lock;
+    NNTI_transport_t *trans_hdl;
+    volatile uint32_t busy;
+    nnti_rv_slot      slots[NNTI_RENDEZVOUS_MAX];
+} nnti_rv_table;
+
+static nnti_rv_table rv_tables[NNTI_TRANSPORT_COUNT];
+
+
+static void rv_release_locked(
+        nnti_rv_table *t,
+        nnti_rv_slot  *slot);
+
+/*
+ * Free the draining slots whose ctrl_wr has finished.  Called with the
+ * table locked.
+ */
+static void rv_reap(
+        nnti_rv_table *t)
+{
+    NNTI_status_t ctrl_status;
+    uint32_t      i=0;
+
+    for (i=0;i<NNTI_RENDEZVOUS_MAX;i++) {
+        if ((t->slots[i].state == NNTI_RV_DRAINING) &&
+            (available_transports[t->trans_hdl->id].ops.nnti_wait_fn(&t->slots[i].ctrl_wr, 0, &ctrl_status) != NNTI_ETIMEDOUT)) {
+            rv_release_locked(t, &t->slots[i]);
+        }
+    }
+}
+
+/*
+ * Claim a free slot and register the buffers it needs.  Returns NULL if
+ * every slot is busy or registration fails.
+ */
+static nnti_rv_slot *rv_take(
+        nnti_rv_table *t,
+        const int8_t   need_reply)
+{
+    nnti_rv_slot *slot=NULL;
+    NNTI_result_t rc=NNTI_OK;
+    uint32_t      i=0;
+    int           pass=0;
+
+    nthread_lock(&t->lock);
+    for (pass=0;(slot == NULL) && (pass < 2);pass++) {
+        if (pass == 1) {
+            rv_reap(t);
+        }
+        for (i=0;i<NNTI_RENDEZVOUS_MAX;i++) {
+            if (t->slots[i].state == NNTI_RV_FREE) {
+                slot=&t->slots[i];
+                break;
+            }
+        }
+    }
+    if (slot == NULL) {
+        nthread_unlock(&t->lock);
+        return(NULL);
+    }
+
+    if (!slot->ctrl_allocated) {
+        rc=NNTI_alloc(t->trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &slot->ctrl);
+        slot->ctrl_allocated=(rc == NNTI_OK);
+    }
+    if ((rc == NNTI_OK) && need_reply && !slot->reply_allocated) {
+        rc=NNTI_alloc(t->trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_RECV_DST, &slot->reply);
+        slot->reply_allocated=(rc == NNTI_OK);
+    }
+    if (rc != NNTI_OK) {
+        log_error(nnti_debug_level, "failed to register rendezvous buffers: %d", rc);
+        nthread_unlock(&t->lock);
+        return(NULL);
+    }
+
+    slot->state=need_reply ? NNTI_RV_SENDING : NNTI_RV_PULLING;
+    t->busy++;
+    nthread_unlock(&t->lock);
+
+    return(slot);
+}
+
+static void rv_release_locked(
+        nnti_rv_table *t,
+        nnti_rv_slot  *slot)
+{
+    if (slot->unpacked) {
+        NNTI_dt_free(t->trans_hdl, &slot->remote_msg);
+        NNTI_dt_free(t->trans_hdl, &slot->remote_reply);
+        slot->unpacked=FALSE;
+    }
+    slot->state  =NNTI_RV_FREE;
+    slot->user_wr=NULL;
+    slot->msg_hdl=NULL;
+    t->busy--;
+}
+
+static void rv_release(
+        nnti_rv_table *t,
+        nnti_rv_slot  *slot)
+{
+    nthread_lock(&t->lock);
+    rv_release_locked(t, slot);
+    nthread_unlock(&t->lock);
+}
+
+/*
+ * The slot whose caller's work request is <tt>wr</tt>, if any.
+ */
+static nnti_rv_slot *rv_find(
+        const NNTI_work_request_t *wr)
+{
+    nnti_rv_table *t=&rv_tables[wr->transport_id];
+    nnti_rv_slot  *slot=NULL;
+    uint32_t       i=0;
+
+    if (t->busy == 0) {
+        return(NULL);
+    }
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_RENDEZVOUS_MAX;i++) {
+        if ((t->slots[i].state != NNTI_RV_FREE) && (t->slots[i].user_wr == wr)) {
+            slot=&t->slots[i];
+            break;
+        }
+    }
+    nthread_unlock(&t->lock);
+
+    return(slot);
+}
+
+/*
+ * Finish the rendezvous behind <tt>wr</tt> once the transport has a final
+ * <tt>result</tt> for it, good or bad.  A wait that succeeds may still
+ * report a failed work request in <tt>status</tt>.  The sender reaps the
+ * header send and reports the message rather than the reply.  The
+ * receiver tells the sender it is done and how the pull went.  Both wait
+ * up to <tt>timeout</tt> for the ctrl send.  If it is still in flight the
+ * slot drains until rv_take() finds it finished.  Returns the result for
+ * the caller, which is also left in <tt>status</tt>.
+ */
+static NNTI_result_t rv_complete(
+        NNTI_work_request_t *wr,
+        NNTI_result_t        result,
+        NNTI_status_t       *status,
+        const int            timeout)
+{
+    nnti_rv_table *t=&rv_tables[wr->transport_id];
+    nnti_rv_slot  *slot=rv_find(wr);
+    NNTI_status_t  ctrl_status;
+    NNTI_result_t  rc=NNTI_OK;
+    uint64_t      *ack=NULL;
+
+    if (slot == NULL) {
+        return(result);
+    }
+    if ((result == NNTI_OK) && (status->result != NNTI_OK)) {
+        result=status->result;
+    }
+
+    if (slot->state == NNTI_RV_SENDING) {
+        /* the reply proves the header arrived, so this rarely waits */
+        rc=available_transports[wr->transport_id].ops.nnti_wait_fn(&slot->ctrl_wr, timeout, &ctrl_status);
+        if ((rc != NNTI_OK) && (rc != NNTI_ETIMEDOUT)) {
+            log_error(nnti_debug_level, "failed to send the rendezvous header: %d", rc);
+            if (result == NNTI_OK) {
+                result=rc;
+            }
+        }
+        if ((result == NNTI_OK) && (status->length >= 2*sizeof(uint64_t))) {
+            ack=(uint64_t *)(status->start + status->offset);
+            result=(NNTI_result_t)ack[1];
+        }
+        NNTI_destroy_work_request(wr);
+
+        if (result == NNTI_OK) {
+            status->op    =slot->msg_hdl->ops;
+            status->start =slot->msg_hdl->payload;
+            status->offset=0;
+            status->length=slot->msg_hdl->payload_size;
+        }
+    } else {
+        ack=(uint64_t *)NNTI_BUFFER_C_POINTER(&slot->ctrl);
+        ack[0]=NNTI_RV_MAGIC;
+        ack[1]=result;
+        rc=available_transports[wr->transport_id].ops.nnti_send_fn(
+                &slot->remote_reply.buffer_owner,
+                &slot->ctrl,
+                &slot->remote_reply,
+                &slot->ctrl_wr);
+        if (rc == NNTI_OK) {
+            rc=available_transports[wr->transport_id].ops.nnti_wait_fn(&slot->ctrl_wr, timeout, &ctrl_status);
+        }
+        if ((rc != NNTI_OK) && (rc != NNTI_ETIMEDOUT)) {
+            log_error(nnti_debug_level, "failed to send the rendezvous reply: %d", rc);
+            if (result == NNTI_OK) {
+                result=rc;
+            }
+        }
+    }
+
+    if (rc == NNTI_ETIMEDOUT) {
+        nthread_lock(&t->lock);
+        slot->state  =NNTI_RV_DRAINING;
+        slot->user_wr=NULL;
+        nthread_unlock(&t->lock);
+    } else {
+        rv_release(t, slot);
+    }
+
+    status->result=result;
+
+    return(result);
+}
+
+/*
+ * Queue a rendezvous header at the peer instead of the message.
+ * <tt>wr</tt> waits for the peer's reply.
+ */
+static NNTI_result_t rv_send(
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        NNTI_work_request_t *wr)
+{
+    nnti_rv_table  *t=&rv_tables[msg_hdl->transport_id];
+    nnti_rv_slot   *slot=NULL;
+    nnti_rv_header *hdr=NULL;
+    uint64_t        msg_len=0;
+    uint64_t        reply_len=0;
+    NNTI_result_t   rc=NNTI_OK;
+
+    slot=rv_take(t, TRUE);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+
+    NNTI_dt_sizeof(t->trans_hdl, (void *)msg_hdl, &msg_len);
+    NNTI_dt_sizeof(t->trans_hdl, &slot->reply, &reply_len);
+    if (sizeof(nnti_rv_header) + msg_len + reply_len > NNTI_REQUEST_BUFFER_SIZE) {
+        log_error(nnti_debug_level, "rendezvous header doesn't fit in a request (msg_len=%llu ; reply_len=%llu)",
+                (unsigned long long)msg_len, (unsigned long long)reply_len);
+        rv_release(t, slot);
+        return(NNTI_EMSGSIZE);
+    }
+
+    hdr=(nnti_rv_header *)NNTI_BUFFER_C_POINTER(&slot->ctrl);
+    hdr->magic    =NNTI_RV_MAGIC;
+    hdr->length   =msg_hdl->payload_size;
+    hdr->msg_len  =msg_len;
+    hdr->reply_len=reply_len;
+    NNTI_dt_pack(t->trans_hdl, (void *)msg_hdl, (char *)(hdr+1), msg_len);
+    NNTI_dt_pack(t->trans_hdl, &slot->reply, (char *)(hdr+1) + msg_len, reply_len);
+
+    /* ready for the reply before the header goes out */
+    rc=NNTI_create_work_request(&slot->reply, wr);
+    if (rc == NNTI_OK) {
+        slot->msg_hdl=msg_hdl;
+        slot->user_wr=wr;
+        rc=available_transports[msg_hdl->transport_id].ops.nnti_send_fn(
+                peer_hdl,
+                &slot->ctrl,
+                NULL,
+                &slot->ctrl_wr);
+        if (rc != NNTI_OK) {
+            NNTI_destroy_work_request(wr);
+        }
+    }
+    if (rc != NNTI_OK) {
+        rv_release(t, slot);
+    }
+
+    return(rc);
+}
+
+
+/*
+ * Raw operations (see NNTI_send_raw()).  Small transfers go through a
+ * bounce buffer owned by the slot.  Larger ones use a registration from a
+ * small cache of recently used regions.  The slot lives until the wait
+ * functions see the caller's work request complete.
+ */
+#define NNTI_RAW_CACHE_SIZE (2*NNTI_RAW_MAX)
+
+typedef struct {
+    int8_t          valid;
+    const void     *addr;
+    uint64_t        length;
+    NNTI_buf_ops_t  ops;
+    NNTI_buffer_t   buf;
+    uint32_t        refs;
+    uint64_t        last_use;
+} nnti_raw_cache_entry;
+
+typedef struct {
+    int8_t                busy;
+    NNTI_work_request_t  *user_wr;
+
+    int8_t                bounce_allocated;
+    NNTI_buffer_t         bounce;
+    /* the buffer handed to the transport, trimmed to the message for a send */
+    NNTI_buffer_t         view;
+
+    nnti_raw_cache_entry *entry;
+    /* NNTI_get_into() through the bounce buffer copies out here */
+    void                 *copy_out;
+    uint64_t              length;
+} nnti_raw_slot;
+
+typedef struct {
+    nthread_lock_t        lock;
+    NNTI_transport_t     *trans_hdl;
+    volatile uint32_t     busy;
+    uint64_t              use_clock;
+    nnti_raw_slot         slots[NNTI_RAW_MAX];
+    nnti_raw_cache_entry  cache[NNTI_RAW_CACHE_SIZE];
+} nnti_raw_table;
+
+static nnti_raw_table raw_tables[NNTI_TRANSPORT_COUNT];
+
+
+/*
+ * Claim a free slot.  With <tt>bounce</tt>, register its bounce buffer if
+ * this is the slot's first bounce.
+ */
+static nnti_raw_slot *raw_take(
+        nnti_raw_table *t,
+        const int8_t    bounce)
+{
+    nnti_raw_slot *slot=NULL;
+    NNTI_result_t  rc=NNTI_OK;
+    uint32_t       i=0;
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_RAW_MAX;i++) {
+        if (!t->slots[i].busy) {
+            slot=&t->slots[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        nthread_unlock(&t->lock);
+        return(NULL);
+    }
+
+    if (bounce && !slot->bounce_allocated) {
+        rc=NNTI_alloc(t->trans_hdl, NNTI_RAW_BOUNCE_SIZE, 1,
+                (NNTI_buf_ops_t)(NNTI_BOP_LOCAL_READ|NNTI_BOP_LOCAL_WRITE|NNTI_BOP_WITH_EVENTS), &slot->bounce);
+        if (rc != NNTI_OK) {
+            log_error(nnti_debug_level, "failed to register a bounce buffer: %d", rc);
+            nthread_unlock(&t->lock);
+            return(NULL);
+        }
+        slot->bounce_allocated=TRUE;
+    }
+
+    slot->busy=TRUE;
+    t->busy++;
+    nthread_unlock(&t->lock);
+
+    return(slot);
+}
+
+/*
+ * Find or make a registration of exactly [addr, addr+length) for
+ * <tt>ops</tt> and take a reference on it.  The least recently used idle
+ * entry makes room.  There are more entries than slots, so one is always
+ * idle.  Nothing notices memory being freed and reallocated at the same
+ * address, so callers must NNTI_raw_cache_flush() before freeing.
+ */
+static nnti_raw_cache_entry *raw_cache_get(
+        nnti_raw_table       *t,
+        const void           *addr,
+        const uint64_t        length,
+        const NNTI_buf_ops_t  ops)
+{
+    nnti_raw_cache_entry *entry=NULL;
+    nnti_raw_cache_entry *victim=NULL;
+    NNTI_result_t         rc=NNTI_OK;
+    uint32_t              i=0;
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_RAW_CACHE_SIZE;i++) {
+        nnti_raw_cache_entry *e=&t->cache[i];
+        if (e->valid && (e->addr == addr) && (e->length == length) && (e->ops == ops)) {
+            entry=e;
+            break;
+        }
+        if ((e->refs == 0) && ((victim == NULL) || !e->valid || (victim->valid && (e->last_use < victim->last_use)))) {
+            victim=e;
+        }
+    }
+    if (entry == NULL) {
+        if (victim == NULL) {
+            nthread_unlock(&t->lock);
+            return(NULL);
+        }
+        if (victim->valid) {
+            NNTI_unregister_memory(&victim->buf);
+            victim->valid=FALSE;
+        }
+        rc=NNTI_register_memory(t->trans_hdl, (char *)addr, length, 1, ops, &victim->buf);
+        if (rc != NNTI_OK) {
+            log_error(nnti_debug_level, "failed to register %llu bytes at %p: %d", (unsigned long long)length, addr, rc);
+            nthread_unlock(&t->lock);
+            return(NULL);
+        }
+        victim->valid =TRUE;
+        victim->addr  =addr;
+        victim->length=length;
+        victim->ops   =ops;
+        entry=victim;
+    }
+    entry->refs++;
+    entry->last_use=++t->use_clock;
+    nthread_unlock(&t->lock);
+
+    return(entry);
+}
+
+static void raw_release(
+        nnti_raw_table *t,
+        nnti_raw_slot  *slot)
+{
+    nthread_lock(&t->lock);
+    if (slot->entry != NULL) {
+        slot->entry->refs--;
+    }
+    slot->busy    =FALSE;
+    slot->user_wr =NULL;
+    slot->entry   =NULL;
+    slot->copy_out=NULL;
+    t->busy--;
+    nthread_unlock(&t->lock);
+}
+
+/*
+ * The slot whose caller's work request is <tt>wr</tt>, if any.
+ */
+static nnti_raw_slot *raw_find(
+        const NNTI_transport_id_t  id,
+        const NNTI_work_request_t *wr)
+{
+    nnti_raw_table *t=&raw_tables[id];
+    nnti_raw_slot  *slot=NULL;
+    uint32_t        i=0;
+
+    if (t->busy == 0) {
+        return(NULL);
+    }
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_RAW_MAX;i++) {
+        if (t->slots[i].busy && (t->slots[i].user_wr == wr)) {
+            slot=&t->slots[i];
+            break;
+        }
+    }
+    nthread_unlock(&t->lock);
+
+    return(slot);
+}
+
+/*
+ * Finish the raw operation behind <tt>wr</tt> once the transport has a
+ * final <tt>result</tt> for it.  Only a successful NNTI_get_into() copies
+ * the bounce buffer out.
+ */
+static void raw_complete(
+        const NNTI_transport_id_t  id,
+        const NNTI_work_request_t *wr,
+        const NNTI_result_t        result)
+{
+    nnti_raw_table *t=&raw_tables[id];
+    nnti_raw_slot  *slot=raw_find(id, wr);
+
+    if (slot == NULL) {
+        return;
+    }
+    if ((result == NNTI_OK) && (slot->copy_out != NULL)) {
+        memcpy(slot->copy_out, NNTI_BUFFER_C_POINTER(&slot->bounce), slot->length);
+    }
+    raw_release(t, slot);
+}
+
+/*
+ * The wait functions call this for every work request that reaches a
+ * final <tt>result</tt>, which is anything but NNTI_ETIMEDOUT.  A
+ * rendezvous destroys the work request, so take the transport first.
+ */
+static NNTI_result_t wr_complete(
+        NNTI_work_request_t *wr,
+        NNTI_result_t        result,
+        NNTI_status_t       *status,
+        const int            timeout)
+{
+    NNTI_transport_id_t id=wr->transport_id;
+    NNTI_result_t       rc=NNTI_OK;
+
+    rc=rv_complete(wr, result, status, timeout);
+    raw_complete(id, wr, (result == NNTI_OK) ? status->result : result);
+
+    return(rc);
+}
+
+/*
+ * NNTI_waitall() for a list that holds rendezvous or raw work requests.
+ * The transport's waitall can't say which work requests finished when
+ * one fails, so each is waited on by itself and finished with its own
+ * result, even after another has failed.  Returns the first failure.
+ */
+static NNTI_result_t wr_waitall(
+        const NNTI_transport_id_t  id,
+        NNTI_work_request_t      **wr_list,
+        const uint32_t             wr_count,
+        const int                  timeout,
+        NNTI_status_t            **status)
+{
+    NNTI_result_t rc=NNTI_OK;
+    NNTI_result_t wr_rc=NNTI_OK;
+    int           remaining=timeout;
+    long          entry_time=trios_get_time_ms();
+    uint32_t      i=0;
+
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i] == NULL) {
+            continue;
+        }
+        wr_rc=available_transports[id].ops.nnti_wait_fn(wr_list[i], remaining, status[i]);
+        if (wr_rc != NNTI_ETIMEDOUT) {
+            wr_rc=wr_complete(wr_list[i], wr_rc, status[i], remaining);
+        }
+        if (rc == NNTI_OK) {
+            rc=wr_rc;
+        }
+        remaining=am_remaining(timeout, entry_time);
+    }
+
+    return(rc);
+}
+
+
+/*
+ * Coalescing (see NNTI_send_coalesced()).  Small sends to one peer are
+ * framed into one request and adjacent puts into one buffer become one
+ * put.  Each batch is staged in a buffer it owns and sent with a single
+ * work request.  The callers' work requests live in an op table until the
+ * wait functions reap them from the batch.
+ */
+#define NNTI_CO_MAGIC 0x4e4e54495f434f31ULL  /* "NNTI_CO1" */
+
+/* batches in flight per transport */
+#define NNTI_COALESCE_BATCHES 8
+
+/* milliseconds between attempts to send a batch the transport refused */
+#define NNTI_CO_RETRY 1
+
+#define NNTI_CO_ALIGN(n) (((n) + 7) & ~((uint64_t)7))
+
+typedef struct {
+    uint64_t magic;
+    uint32_t count;
+    uint32_t reserved;
+    /* count records follow, each padded to 8 bytes */
+} nnti_co_frame;
+
+typedef struct {
+    uint32_t length;
+    uint32_t reserved;
+} nnti_co_record;
+
+typedef enum {
+    NNTI_CO_FREE=0,
+    NNTI_CO_OPEN,
+    NNTI_CO_FLUSHED,
+    NNTI_CO_DONE
+} nnti_co_state;
+
+typedef struct {
+    nnti_co_state        state;
+    int8_t               is_put;
+    /* the transport refused the batch with NNTI_EAGAIN */
+    int8_t               refused;
+    long                 opened;
+    uint64_t             used;
+    uint32_t             count;
+    /* ops not yet reaped */
+    uint32_t             pending;
+
+    /* a send batch goes to peer, a put batch to dest_hdl at dest_offset */
+    NNTI_peer_t          peer;
+    const NNTI_buffer_t *dest_hdl;
+    uint64_t             dest_offset;
+
+    int8_t               send_allocated;
+    NNTI_buffer_t        send_buf;
+    int8_t               put_allocated;
+    NNTI_buffer_t        put_buf;
+    /* send_buf trimmed to the frame */
+    NNTI_buffer_t        view;
+
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    NNTI_result_t        result;
+} nnti_co_batch;
+
+typedef struct {
+    NNTI_work_request_t *user_wr;
+    nnti_co_batch       *batch;
+    /* what the caller's status describes */
+    uint64_t             start;
+    uint64_t             offset;
+    uint64_t             length;
+} nnti_co_op;
+
+typedef struct {
+    nthread_lock_t    lock;
+    /* held while waiting on a batch's work request */
+    nthread_lock_t    reap_lock;
+    NNTI_transport_t *trans_hdl;
+    uint64_t          max_bytes;
+    int               max_delay;
+    volatile uint32_t open;
+    volatile uint32_t busy;
+    nnti_co_batch     batches[NNTI_COALESCE_BATCHES];
+    nnti_co_op        ops[NNTI_COALESCE_MAX];
+} nnti_co_table;
+
+static nnti_co_table co_tables[NNTI_TRANSPORT_COUNT];
+
+
+/*
+ * Send an open batch.  A batch the transport refuses with NNTI_EAGAIN
+ * (eg. out of request credits) stays open and is sent again by the next
+ * poll or wait.  Call with the table locked.
+ */
+static NNTI_result_t co_flush_batch(
+        nnti_co_table *t,
+        nnti_co_batch *b)
+{
+    NNTI_transport_id_t id=t->trans_hdl->id;
+    nnti_co_frame      *frame=NULL;
+    NNTI_result_t       rc=NNTI_OK;
+
+    if (b->is_put) {
+        rc=available_transports[id].ops.nnti_put_fn(
+                &b->put_buf,
+                0,
+                b->used,
+                b->dest_hdl,
+                b->dest_offset,
+                &b->wr);
+    } else {
+        frame=(nnti_co_frame *)NNTI_BUFFER_C_POINTER(&b->send_buf);
+        frame->magic   =NNTI_CO_MAGIC;
+        frame->count   =b->count;
+        frame->reserved=0;
+
+        b->view=b->send_buf;
+        b->view.payload_size=b->used;
+        rc=available_transports[id].ops.nnti_send_fn(
+                &b->peer,
+                &b->view,
+                NULL,
+                &b->wr);
+    }
+
+    if (rc == NNTI_EAGAIN) {
+        log_debug(nnti_debug_level, "batch of %u operations refused.  trying again later.", b->count);
+        b->refused=TRUE;
+        return(rc);
+    }
+    t->open--;
+
+    if (rc == NNTI_OK) {
+        b->state=NNTI_CO_FLUSHED;
+    } else {
+        log_error(nnti_debug_level, "failed to send a batch of %u operations: %d", b->count, rc);
+        memset(&b->status, 0, sizeof(b->status));
+        b->status.op    =NNTI_BOP_LOCAL_READ;
+        b->status.result=rc;
+        b->result=rc;
+        b->state =NNTI_CO_DONE;
+    }
+
+    return(rc);
+}
+
+/*
+ * Send the open batches, or only the ones past the delay or refused before
+ * with <tt>expired</tt>.  Call with the table locked.
+ */
+static void co_flush_open(
+        nnti_co_table *t,
+        const int8_t   expired)
+{
+    long     now=trios_get_time_ms();
+    uint32_t i=0;
+
+    for (i=0;(t->open > 0) && (i<NNTI_COALESCE_BATCHES);i++) {
+        nnti_co_batch *b=&t->batches[i];
+        if ((b->state == NNTI_CO_OPEN) && (!expired || b->refused || (now - b->opened >= t->max_delay))) {
+            co_flush_batch(t, b);
+        }
+    }
+}
+
+/*
+ * The wait functions call this so a batch can't outlive its delay.  A wait
+ * that may block sends every open batch, because what it waits for might
+ * be the answer to a message still in a batch.
+ */
+static void co_poll(
+        const NNTI_transport_id_t id,
+        const int                 timeout)
+{
+    nnti_co_table *t=&co_tables[id];
+
+    if (t->open == 0) {
+        return;
+    }
+
+    nthread_lock(&t->lock);
+    co_flush_open(t, (timeout == 0));
+    nthread_unlock(&t->lock);
+}
+
+/*
+ * The open batch for a peer (<tt>peer</tt>) or a buffer (<tt>dest_hdl</tt>).
+ * Call with the table locked.
+ */
+static nnti_co_batch *co_find_batch(
+        nnti_co_table       *t,
+        const NNTI_peer_t   *peer,
+        const NNTI_buffer_t *dest_hdl)
+{
+    uint32_t i=0;
+
+    for (i=0;i<NNTI_COALESCE_BATCHES;i++) {
+        nnti_co_batch *b=&t->batches[i];
+        if (b->state != NNTI_CO_OPEN) {
+            continue;
+        }
+        if (peer && !b->is_put && !strcmp(b->peer.url, peer->url)) {
+            return(b);
+        }
+        if (dest_hdl && b->is_put && (b->dest_hdl == dest_hdl)) {
+            return(b);
+        }
+    }
+
+    return(NULL);
+}
+
+/*
+ * Open a free batch and register its staging buffer if this is its first
+ * batch of the kind.  Call with the table locked.
+ */
+static NNTI_result_t co_open_batch(
+        nnti_co_table  *t,
+        const int8_t    is_put,
+        nnti_co_batch **batch)
+{
+    nnti_co_batch *b=NULL;
+    NNTI_result_t  rc=NNTI_OK;
+    uint32_t       i=0;
+
+    for (i=0;i<NNTI_COALESCE_BATCHES;i++) {
+        if (t->batches[i].state == NNTI_CO_FREE) {
+            b=&t->batches[i];
+            break;
+        }
+    }
+    if (b == NULL) {
+        return(NNTI_EAGAIN);
+    }
+
+    if (is_put && !b->put_allocated) {
+        rc=NNTI_alloc(t->trans_hdl, NNTI_COALESCE_SIZE, 1, NNTI_PUT_SRC, &b->put_buf);
+        b->put_allocated=(rc == NNTI_OK);
+    } else if (!is_put && !b->send_allocated) {
+        rc=NNTI_alloc(t->trans_hdl, NNTI_COALESCE_SIZE, 1, NNTI_SEND_SRC, &b->send_buf);
+        b->send_allocated=(rc == NNTI_OK);
+    }
+    if (rc != NNTI_OK) {
+        log_error(nnti_debug_level, "failed to register a coalescing buffer: %d", rc);
+        return(rc);
+    }
+
+    b->state  =NNTI_CO_OPEN;
+    b->is_put =is_put;
+    b->refused=FALSE;
+    b->opened =trios_get_time_ms();
+    b->used   =is_put ? 0 : sizeof(nnti_co_frame);
+    b->count  =0;
+    b->pending=0;
+    b->result =NNTI_OK;
+    t->open++;
+
+    *batch=b;
+
+    return(NNTI_OK);
+}
+
+/*
+ * Add the caller's work request to batch <tt>b</tt>.  Call with the table
+ * locked and a free op.
+ */
+static void co_add_op(
+        nnti_co_table       *t,
+        nnti_co_op          *op,
+        nnti_co_batch       *b,
+        const NNTI_buffer_t *hdl,
+        const uint64_t       offset,
+        const uint64_t       length,
+        NNTI_work_request_t *wr)
+{
+    op->user_wr=wr;
+    op->batch  =b;
+    op->start  =(uint64_t)hdl->payload;
+    op->offset =offset;
+    op->length =length;
+    b->count++;
+    b->pending++;
+    t->busy++;
+
+    wr->transport_id     =hdl->transport_id;
+    wr->reg_buf          =(NNTI_buffer_t *)hdl;
+    wr->ops              =NNTI_BOP_LOCAL_READ;
+    wr->result           =NNTI_OK;
+    wr->transport_private=0;
+    wr->datatype         =NNTI_dt_work_request;
+
+    if (t->max_delay == 0) {
+        co_flush_batch(t, b);
+    }
+}
+
+/*
+ * A free op.  Call with the table locked.
+ */
+static nnti_co_op *co_take_op(
+        nnti_co_table *t)
+{
+    uint32_t i=0;
+
+    for (i=0;i<NNTI_COALESCE_MAX;i++) {
+        if (t->ops[i].user_wr == NULL) {
+            return(&t->ops[i]);
+        }
+    }
+
+    return(NULL);
+}
+
+/*
+ * The op whose caller's work request is <tt>wr</tt>, if any.
+ */
+static nnti_co_op *co_find_op(
+        const NNTI_work_request_t *wr)
+{
+    nnti_co_table *t=NULL;
+    nnti_co_op    *op=NULL;
+    uint32_t       i=0;
+
+    if ((wr == NULL) || (wr->transport_id >= NNTI_TRANSPORT_COUNT)) {
+        return(NULL);
+    }
+    t=&co_tables[wr->transport_id];
+    if (t->busy == 0) {
+        return(NULL);
+    }
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_COALESCE_MAX;i++) {
+        if (t->ops[i].user_wr == wr) {
+            op=&t->ops[i];
+            break;
+        }
+    }
+    nthread_unlock(&t->lock);
+
+    return(op);
+}
+
+/*
+ * Whether any request in the list is a coalesced operation.
+ */
+static int8_t co_find_any(
+        NNTI_work_request_t **wr_list,
+        const uint32_t        wr_count)
+{
+    uint32_t i=0;
+
+    for (i=0;i<wr_count;i++) {
+        if (co_find_op(wr_list[i]) != NULL) {
+            return(TRUE);
+        }
+    }
+
+    return(FALSE);
+}
+
+/*
+ * Record how the work request of batch <tt>b</tt> finished.  Call with the
+ * reap lock held.
+ */
+static void co_batch_done(
+        nnti_co_table       *t,
+        nnti_co_batch       *b,
+        const NNTI_result_t  rc,
+        const NNTI_status_t *status)
+{
+    nthread_lock(&t->lock);
+    b->status=*status;
+    b->result=(rc == NNTI_OK) ? status->result : rc;
+    b->state =NNTI_CO_DONE;
+    nthread_unlock(&t->lock);
+}
+
+/*
+ * Wait for the batch carrying <tt>op</tt>, sending it first if it's still
+ * open, and describe the caller's operation in <tt>status</tt>.
+ */
+static NNTI_result_t co_wait(
+        const NNTI_transport_id_t  id,
+        nnti_co_op                *op,
+        const int                  timeout,
+        NNTI_status_t             *status)
+{
+    nnti_co_table *t=&co_tables[id];
+    nnti_co_batch *b=op->batch;
+    NNTI_status_t  batch_status;
+    long           entry_time=trios_get_time_ms();
+    int            remaining=0;
+    NNTI_result_t  rc=NNTI_OK;
+
+    nthread_lock(&t->lock);
+    while ((b->state == NNTI_CO_OPEN) && (co_flush_batch(t, b) == NNTI_EAGAIN)) {
+        nthread_unlock(&t->lock);
+        remaining=am_remaining(timeout, entry_time);
+        if (remaining == 0) {
+            status->op    =op->user_wr->ops;
+            status->result=NNTI_ETIMEDOUT;
+            return(NNTI_ETIMEDOUT);
+        }
+        nnti_sleep(((remaining < 0) || (remaining > NNTI_CO_RETRY)) ? NNTI_CO_RETRY : remaining);
+        nthread_lock(&t->lock);
+    }
+    nthread_unlock(&t->lock);
+
+    nthread_lock(&t->reap_lock);
+    if (b->state == NNTI_CO_FLUSHED) {
+        rc=available_transports[id].ops.nnti_wait_fn(&b->wr, am_remaining(timeout, entry_time), &batch_status);
+        if (rc != NNTI_ETIMEDOUT) {
+            co_batch_done(t, b, rc, &batch_status);
+        }
+    }
+    nthread_unlock(&t->reap_lock);
+
+    if (rc == NNTI_ETIMEDOUT) {
+        status->op    =op->user_wr->ops;
+        status->result=rc;
+        return(rc);
+    }
+
+    *status=b->status;
+    status->result=b->result;
+    status->start =op->start;
+    status->offset=op->offset;
+    status->length=op->length;
+    rc=b->result;
+
+    nthread_lock(&t->lock);
+    op->user_wr=NULL;
+    op->batch  =NULL;
+    b->pending--;
+    if (b->pending == 0) {
+        b->state=NNTI_CO_FREE;
+    }
+    t->busy--;
+    nthread_unlock(&t->lock);
+
+    return(rc);
+}
+
+/*
+ * Block until one of <tt>others</tt> or a batch carrying one of the
+ * coalesced operations in <tt>wr_list</tt> completes.  A batch that
+ * completes is recorded for co_wait() to reap and leaves
+ * <tt>*other_which</tt> at <tt>other_count</tt>.  While a batch is
+ * refused this only blocks until it's time to send it again.
+ */
+static NNTI_result_t co_block(
+        const NNTI_transport_id_t   id,
+        NNTI_work_request_t       **wr_list,
+        const uint32_t              wr_count,
+        NNTI_work_request_t       **others,
+        const uint32_t              other_count,
+        int                         timeout,
+        uint32_t                   *other_which,
+        NNTI_status_t              *status)
+{
+    nnti_co_table        *t=&co_tables[id];
+    NNTI_work_request_t **block_list=NULL;
+    nnti_co_batch       **block_batch=NULL;
+    uint32_t              block_count=0;
+    uint32_t              which=0;
+    nnti_co_op           *op=NULL;
+    NNTI_status_t         block_status;
+    NNTI_result_t         rc=NNTI_ETIMEDOUT;
+    uint32_t              i=0;
+    uint32_t              j=0;
+
+    *other_which=other_count;
+
+    block_list =(NNTI_work_request_t **)malloc((other_count+wr_count)*sizeof(NNTI_work_request_t *));
+    block_batch=(nnti_co_batch **)malloc(wr_count*sizeof(nnti_co_batch *));
+    if ((block_list == NULL) || (block_batch == NULL)) {
+        free(block_list);
+        free(block_batch);
+        return(NNTI_ENOMEM);
+    }
+    for (i=0;i<other_count;i++) {
+        block_list[block_count++]=others[i];
+    }
+
+    nthread_lock(&t->reap_lock);
+    for (i=0;i<wr_count;i++) {
+        op=co_find_op(wr_list[i]);
+        if (op == NULL) {
+            continue;
+        }
+        if (op->batch->state == NNTI_CO_DONE) {
+            /* finished since the last look */
+            goto done;
+        }
+        if (op->batch->state == NNTI_CO_OPEN) {
+            if ((timeout < 0) || (timeout > NNTI_CO_RETRY)) {
+                timeout=NNTI_CO_RETRY;
+            }
+            continue;
+        }
+        for (j=other_count;j<block_count;j++) {
+            if (block_batch[j-other_count] == op->batch) {
+                break;
+            }
+        }
+        if (j == block_count) {
+            block_batch[block_count-other_count]=op->batch;
+            block_list[block_count++]=&op->batch->wr;
+        }
+    }
+
+    if (block_count == 0) {
+        nnti_sleep((timeout < 0) ? NNTI_CO_RETRY : timeout);
+        goto done;
+    }
+    rc=NNTI_waitany(block_list, block_count, timeout, &which, &block_status);
+    if ((rc != NNTI_ETIMEDOUT) && (which < other_count)) {
+        *other_which=which;
+        *status=block_status;
+    } else if ((rc != NNTI_ETIMEDOUT) && (which < block_count)) {
+        co_batch_done(t, block_batch[which-other_count], rc, &block_status);
+        rc=NNTI_ETIMEDOUT;
+    }
+
+done:
+    nthread_unlock(&t->reap_lock);
+    free(block_list);
+    free(block_batch);
+
+    return(rc);
+}
+
+/*
+ * NNTI_waitany() for a list with coalesced operations.  Each pass reaps
+ * any request that is already done, then blocks on the batches and the
+ * other requests for what's left of the timeout.
+ */
+static NNTI_result_t co_waitany(
+        const NNTI_transport_id_t   id,
+        NNTI_work_request_t       **wr_list,
+        const uint32_t              wr_count,
+        const int                   timeout,
+        uint32_t                   *which,
+        NNTI_status_t              *status)
+{
+    NNTI_work_request_t **others=NULL;
+    uint32_t             *other_index=NULL;
+    uint32_t              other_count=0;
+    uint32_t              other_which=0;
+    nnti_co_op           *op=NULL;
+    long                  entry_time=trios_get_time_ms();
+    int                   remaining=0;
+    NNTI_result_t         rc=NNTI_OK;
+    uint32_t              i=0;
+
+    others     =(NNTI_work_request_t **)malloc(wr_count*sizeof(NNTI_work_request_t *));
+    other_index=(uint32_t *)malloc(wr_count*sizeof(uint32_t));
+    if ((others == NULL) || (other_index == NULL)) {
+        free(others);
+        free(other_index);
+        return(NNTI_ENOMEM);
+    }
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i] && (co_find_op(wr_list[i]) == NULL)) {
+            others[other_count]     =wr_list[i];
+            other_index[other_count]=i;
+            other_count++;
+        }
+    }
+
+    while (1) {
+        for (i=0;i<wr_count;i++) {
+            op=co_find_op(wr_list[i]);
+            if (op != NULL) {
+                rc=co_wait(id, op, 0, status);
+                if (rc != NNTI_ETIMEDOUT) {
+                    *which=i;
+                    goto done;
+                }
+            }
+        }
+        if (other_count > 0) {
+            rc=NNTI_waitany(others, other_count, 0, &other_which, status);
+            if (rc != NNTI_ETIMEDOUT) {
+                *which=other_index[other_which];
+                goto done;
+            }
+        }
+        remaining=am_remaining(timeout, entry_time);
+        if (remaining == 0) {
+            rc=NNTI_ETIMEDOUT;
+            status->result=rc;
+            goto done;
+        }
+        rc=co_block(id, wr_list, wr_count, others, other_count, remaining, &other_which, status);
+        if (rc == NNTI_ENOMEM) {
+            goto done;
+        }
+        if ((rc != NNTI_ETIMEDOUT) && (other_which < other_count)) {
+            *which=other_index[other_which];
+            goto done;
+        }
+    }
+
+done:
+    free(others);
+    free(other_index);
+
+    return(rc);
+}
+
+/*
+ * NNTI_waitall() for a list with coalesced operations.  Every request is
+ * waited on even after one fails, and the first failure is returned.
+ */
+static NNTI_result_t co_waitall(
+        const NNTI_transport_id_t   id,
+        NNTI_work_request_t       **wr_list,
+        const uint32_t              wr_count,
+        const int                   timeout,
+        NNTI_status_t             **status)
+{
+    NNTI_work_request_t **others=NULL;
+    NNTI_status_t       **other_status=NULL;
+    uint32_t              other_count=0;
+    nnti_co_op           *op=NULL;
+    long                  entry_time=trios_get_time_ms();
+    NNTI_result_t         rc=NNTI_OK;
+    NNTI_result_t         op_rc=NNTI_OK;
+    uint32_t              i=0;
+
+    others      =(NNTI_work_request_t **)malloc(wr_count*sizeof(NNTI_work_request_t *));
+    other_status=(NNTI_status_t **)malloc(wr_count*sizeof(NNTI_status_t *));
+    if ((others == NULL) || (other_status == NULL)) {
+        free(others);
+        free(other_status);
+        return(NNTI_ENOMEM);
+    }
+
+    /* send every batch before waiting on any of them.  co_wait() retries refused ones. */
+    for (i=0;i<wr_count;i++) {
+        op=co_find_op(wr_list[i]);
+        if (op != NULL) {
+            nthread_lock(&co_tables[id].lock);
+            if (op->batch->state == NNTI_CO_OPEN) {
+                co_flush_batch(&co_tables[id], op->batch);
+            }
+            nthread_unlock(&co_tables[id].lock);
+        }
+    }
+
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i] == NULL) {
+            continue;
+        }
+        op=co_find_op(wr_list[i]);
+        if (op == NULL) {
+            others[other_count]      =wr_list[i];
+            other_status[other_count]=status[i];
+            other_count++;
+            continue;
+        }
+        op_rc=co_wait(id, op, am_remaining(timeout, entry_time), status[i]);
+        if (rc == NNTI_OK) {
+            rc=op_rc;
+        }
+    }
+    if (other_count > 0) {
+        op_rc=NNTI_waitall(others, other_count, am_remaining(timeout, entry_time), other_status);
+        if (rc == NNTI_OK) {
+            rc=op_rc;
+        }
+    }
+
+    free(others);
+    free(other_status);
+
+    return(rc);
+}
+
+
+/**
+ * @brief Initialize NNTI to use a specific transport.
+ *
+ * Enable the use of a particular transport by this process.  <tt>my_url</tt>
+ * allows the process to have some control (if possible) over the
+ * URL assigned for the transport.  For example, a Portals URL to put
+ * might be "ptl://-1,128".  This would tell Portals to use the default
+ * network ID, but use PID=128.  If the transport
+ * can be initialized without this info (eg. a Portals client), <tt>my_url</tt> can
+ * be NULL or empty.
+ *
+ */
+NNTI_result_t NNTI_init (
+        const NNTI_transport_id_t  trans_id,
+        const char                *my_url,
+        NNTI_transport_t          *trans_hdl)
+{
+    NNTI_result_t rc=NNTI_OK;
+    static int8_t first_init=TRUE;
+
+    if (first_init==TRUE) {
+        int i;
+
+        memset(&available_transports[0], 0, NNTI_TRANSPORT_COUNT*sizeof(NNTI_internal_transport_t));
+        memset(&am_tables[0], 0, NNTI_TRANSPORT_COUNT*sizeof(nnti_am_table));
+        memset(&rv_tables[0], 0, NNTI_TRANSPORT_COUNT*sizeof(nnti_rv_table));
+        memset(&raw_tables[0], 0, NNTI_TRANSPORT_COUNT*sizeof(nnti_raw_table));
+        memset(&co_tables[0], 0, NNTI_TRANSPORT_COUNT*sizeof(nnti_co_table));
+        for (i=0;i<NNTI_TRANSPORT_COUNT;i++) {
+            nthread_lock_init(&am_tables[i].lock);
+            nthread_lock_init(&rv_tables[i].lock);
+            nthread_lock_init(&raw_tables[i].lock);
+            nthread_lock_init(&co_tables[i].lock);
+            nthread_lock_init(&co_tables[i].reap_lock);
+        }
+        first_init=FALSE;
+    }
+
+#if defined(HAVE_TRIOS_PORTALS) || defined(HAVE_TRIOS_CRAYPORTALS)
+    if (trans_id == NNTI_TRANSPORT_PORTALS) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_ptl_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_ptl_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_ptl_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_ptl_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_ptl_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_ptl_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_ptl_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_ptl_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_ptl_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_ptl_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_ptl_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_ptl_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_ptl_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_ptl_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_ptl_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_ptl_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_ptl_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_ptl_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_ptl_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_ptl_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_ptl_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_ptl_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_ptl_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_ptl_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_ptl_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_ptl_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_ptl_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_ptl_fini;
+    }
+#endif
+#if defined(HAVE_TRIOS_INFINIBAND)
+    if (trans_id == NNTI_TRANSPORT_IB) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_ib_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_ib_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_ib_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_ib_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_ib_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_ib_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_ib_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_ib_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_ib_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_ib_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_ib_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_ib_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_ib_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_ib_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_ib_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_ib_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_ib_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_ib_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_ib_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_ib_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_ib_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_ib_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_ib_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_ib_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_ib_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_ib_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_ib_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_ib_fini;
+        available_transports[trans_id].ops.nnti_dequeue_requests_fn     = NNTI_ib_dequeue_requests;
+        available_transports[trans_id].ops.nnti_release_requests_fn     = NNTI_ib_release_requests;
+        available_transports[trans_id].ops.nnti_put_stream_fn           = NNTI_ib_put_stream;
+        available_transports[trans_id].ops.nnti_putv_fn                 = NNTI_ib_putv;
+        available_transports[trans_id].ops.nnti_getv_fn                 = NNTI_ib_getv;
+        available_transports[trans_id].ops.nnti_put_notify_fn           = NNTI_ib_put_notify;
+        available_transports[trans_id].ops.nnti_counter_bind_fn         = NNTI_ib_counter_bind;
+        available_transports[trans_id].ops.nnti_counter_wait_fn         = NNTI_ib_counter_wait;
+        available_transports[trans_id].ops.nnti_send_implicit_fn        = NNTI_ib_send_implicit;
+        available_transports[trans_id].ops.nnti_put_implicit_fn         = NNTI_ib_put_implicit;
+        available_transports[trans_id].ops.nnti_get_implicit_fn         = NNTI_ib_get_implicit;
+        available_transports[trans_id].ops.nnti_flush_fn                = NNTI_ib_flush;
+        available_transports[trans_id].ops.nnti_atomic_fop_buffer_fn    = NNTI_ib_atomic_fop_buffer;
+        available_transports[trans_id].ops.nnti_atomic_cswap_buffer_fn  = NNTI_ib_atomic_cswap_buffer;
+        available_transports[trans_id].ops.nnti_atomic_set_threshold_callback_fn = NNTI_ib_atomic_set_threshold_callback;
+        available_transports[trans_id].ops.nnti_atomic_fopv_fn          = NNTI_ib_atomic_fopv;
+    }
+#endif
+#if defined(HAVE_TRIOS_GEMINI)
+    if (trans_id == NNTI_TRANSPORT_GEMINI) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_gni_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_gni_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_gni_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_gni_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_gni_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_gni_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_gni_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_gni_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_gni_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_gni_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_gni_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_gni_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_gni_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_gni_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_gni_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_gni_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_gni_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_gni_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_gni_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_gni_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_gni_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_gni_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_gni_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_gni_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_gni_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_gni_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_gni_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_gni_fini;
+    }
+#endif
+#if defined(HAVE_TRIOS_BGPDCMF)
+    if (trans_id == NNTI_TRANSPORT_DCMF) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_bgpdcmf_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_bgpdcmf_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_bgpdcmf_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_bgpdcmf_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_bgpdcmf_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_bgpdcmf_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_bgpdcmf_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_bgpdcmf_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_bgpdcmf_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_bgpdcmf_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_bgpdcmf_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_bgpdcmf_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_bgpdcmf_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_bgpdcmf_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_bgpdcmf_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_bgpdcmf_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_bgpdcmf_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_bgpdcmf_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_bgpdcmf_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_bgpdcmf_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_bgpdcmf_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_bgpdcmf_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_bgpdcmf_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_bgpdcmf_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_bgpdcmf_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_bgpdcmf_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_bgpdcmf_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_bgpdcmf_fini;
+    }
+#endif
+#if defined(HAVE_TRIOS_BGQPAMI)
+    if (trans_id == NNTI_TRANSPORT_PAMI) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_bgqpami_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_bgqpami_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_bgqpami_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_bgqpami_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_bgqpami_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_bgqpami_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_bgqpami_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_bgqpami_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_bgqpami_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_bgqpami_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_bgqpami_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_bgqpami_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_bgqpami_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_bgqpami_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_bgqpami_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_bgqpami_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_bgqpami_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_bgqpami_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_bgqpami_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_bgqpami_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_bgqpami_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_bgqpami_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_bgqpami_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_bgqpami_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_bgqpami_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_bgqpami_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_bgqpami_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_bgqpami_fini;
+    }
+#endif
+#if defined(HAVE_TRIOS_MPI)
+    if (trans_id == NNTI_TRANSPORT_MPI) {
+        available_transports[trans_id].initialized                      = 1;
+        available_transports[trans_id].ops.nnti_init_fn                 = NNTI_mpi_init;
+        available_transports[trans_id].ops.nnti_get_url_fn              = NNTI_mpi_get_url;
+        available_transports[trans_id].ops.nnti_connect_fn              = NNTI_mpi_connect;
+        available_transports[trans_id].ops.nnti_disconnect_fn           = NNTI_mpi_disconnect;
+        available_transports[trans_id].ops.nnti_alloc_fn                = NNTI_mpi_alloc;
+        available_transports[trans_id].ops.nnti_free_fn                 = NNTI_mpi_free;
+        available_transports[trans_id].ops.nnti_register_memory_fn      = NNTI_mpi_register_memory;
+        available_transports[trans_id].ops.nnti_register_segments_fn    = NNTI_mpi_register_segments;
+        available_transports[trans_id].ops.nnti_unregister_memory_fn    = NNTI_mpi_unregister_memory;
+        available_transports[trans_id].ops.nnti_send_fn                 = NNTI_mpi_send;
+        available_transports[trans_id].ops.nnti_put_fn                  = NNTI_mpi_put;
+        available_transports[trans_id].ops.nnti_get_fn                  = NNTI_mpi_get;
+        available_transports[trans_id].ops.nnti_scatter_fn              = NNTI_mpi_scatter;
+        available_transports[trans_id].ops.nnti_gather_fn               = NNTI_mpi_gather;
+        available_transports[trans_id].ops.nnti_atomic_set_callback_fn  = NNTI_mpi_atomic_set_callback;
+        available_transports[trans_id].ops.nnti_atomic_read_fn          = NNTI_mpi_atomic_read;
+        available_transports[trans_id].ops.nnti_atomic_fop_fn           = NNTI_mpi_atomic_fop;
+        available_transports[trans_id].ops.nnti_atomic_cswap_fn         = NNTI_mpi_atomic_cswap;
+        available_transports[trans_id].ops.nnti_create_work_request_fn  = NNTI_mpi_create_work_request;
+        available_transports[trans_id].ops.nnti_clear_work_request_fn   = NNTI_mpi_clear_work_request;
+        available_transports[trans_id].ops.nnti_destroy_work_request_fn = NNTI_mpi_destroy_work_request;
+        available_transports[trans_id].ops.nnti_cancel_fn               = NNTI_mpi_cancel;
+        available_transports[trans_id].ops.nnti_cancelall_fn            = NNTI_mpi_cancelall;
+        available_transports[trans_id].ops.nnti_interrupt_fn            = NNTI_mpi_interrupt;
+        available_transports[trans_id].ops.nnti_wait_fn                 = NNTI_mpi_wait;
+        available_transports[trans_id].ops.nnti_waitany_fn              = NNTI_mpi_waitany;
+        available_transports[trans_id].ops.nnti_waitall_fn              = NNTI_mpi_waitall;
+        available_transports[trans_id].ops.nnti_fini_fn                 = NNTI_mpi_fini;
+        available_transports[trans_id].ops.nnti_dequeue_requests_fn     = NNTI_mpi_dequeue_requests;
+        available_transports[trans_id].ops.nnti_release_requests_fn     = NNTI_mpi_release_requests;
+        available_transports[trans_id].ops.nnti_put_stream_fn           = NNTI_mpi_put_stream;
+        available_transports[trans_id].ops.nnti_putv_fn                 = NNTI_mpi_putv;
+        available_transports[trans_id].ops.nnti_getv_fn                 = NNTI_mpi_getv;
+        available_transports[trans_id].ops.nnti_put_notify_fn           = NNTI_mpi_put_notify;
+        available_transports[trans_id].ops.nnti_counter_bind_fn         = NNTI_mpi_counter_bind;
+        available_transports[trans_id].ops.nnti_counter_wait_fn         = NNTI_mpi_counter_wait;
+        available_transports[trans_id].ops.nnti_send_implicit_fn        = NNTI_mpi_send_implicit;
+        available_transports[trans_id].ops.nnti_put_implicit_fn         = NNTI_mpi_put_implicit;
+        available_transports[trans_id].ops.nnti_get_implicit_fn         = NNTI_mpi_get_implicit;
+        available_transports[trans_id].ops.nnti_flush_fn                = NNTI_mpi_flush;
+        available_transports[trans_id].ops.nnti_atomic_fop_buffer_fn    = NNTI_mpi_atomic_fop_buffer;
+        available_transports[trans_id].ops.nnti_atomic_cswap_buffer_fn  = NNTI_mpi_atomic_cswap_buffer;
+        available_transports[trans_id].ops.nnti_atomic_set_threshold_callback_fn = NNTI_mpi_atomic_set_threshold_callback;
+        available_transports[trans_id].ops.nnti_atomic_fopv_fn          = NNTI_mpi_atomic_fopv;
+    }
+#endif
+
+    trans_hdl->datatype = NNTI_dt_transport;
+    trans_hdl->id       = trans_id;
+
+    rc = available_transports[trans_id].ops.nnti_init_fn(
+            trans_id,
+            my_url,
+            trans_hdl);
+
+    if (rc == NNTI_OK) {
+        rv_tables[trans_id].trans_hdl =trans_hdl;
+        raw_tables[trans_id].trans_hdl=trans_hdl;
+        co_tables[trans_id].trans_hdl =trans_hdl;
+        co_tables[trans_id].max_bytes =NNTI_COALESCE_SIZE;
+        co_tables[trans_id].max_delay =NNTI_COALESCE_DELAY;
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Return the URL field of this transport.
+ *
+ * Return the URL field of this transport.  After initialization, the transport will
+ * have a specific location on the network where peers can contact it.  The
+ * transport will convert this location to a string that other instances of the
+ * transport will recognize.
+ *
+ * URL format: "transport://address/memory_descriptor"
+ *    - transport - (required) identifies how the URL should parsed
+ *    - address   - (required) uniquely identifies a location on the network
+ *                - ex. "ptl://nid:pid/", "ib://ip_addr:port"
+ *    - memory_descriptor - (optional) transport-specific representation of RMA params
+ *
+ */
+NNTI_result_t NNTI_get_url (
+        const NNTI_transport_t *trans_hdl,
+        char                   *url,
+        const uint64_t          maxlen)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[trans_hdl->id].ops.nnti_get_url_fn(
+                trans_hdl,
+                url,
+                maxlen);
+    }
+
+    return(rc);
+}
+
+/**
+ * @brief Prepare for communication with the peer identified by <tt>url</tt>.
+ *
+ * Parse <tt>url</tt> in a transport specific way.  Perform any transport specific
+ * actions necessary to begin communication with this peer.
+ *
+ */
+NNTI_result_t NNTI_connect (
+        const NNTI_transport_t *trans_hdl,
+        const char             *url,
+        const int               timeout,
+        NNTI_peer_t            *peer_hdl)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[trans_hdl->id].ops.nnti_connect_fn(
+                trans_hdl,
+                url,
+                timeout,
+                peer_hdl);
+    }
+
+    peer_hdl->datatype = NNTI_dt_peer;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Terminate communication with this peer.
+ *
+ * Perform any transport specific actions necessary to end communication with
+ * this peer.
+ *
+ */
+NNTI_result_t NNTI_disconnect (
+        const NNTI_transport_t *trans_hdl,
+        NNTI_peer_t            *peer_hdl)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[trans_hdl->id].ops.nnti_disconnect_fn(
+                trans_hdl,
+                peer_hdl);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Allocate a block of memory and prepare it for network operations.
+ *
+ * Allocate a block of memory in a transport specific way and wrap it in an
+ * NNTI_buffer_t.  The transport may take additional actions to prepare the
+ * memory for network send/receive.
+ *
+ */
+NNTI_result_t NNTI_alloc (
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          element_size,
+        const uint64_t          num_elements,
+        const NNTI_buf_ops_t    ops,
+        NNTI_buffer_t          *reg_buf)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[trans_hdl->id].ops.nnti_alloc_fn(
+                trans_hdl,
+                element_size,
+                num_elements,
+                ops,
+                reg_buf);
+    }
+
+    reg_buf->datatype = NNTI_dt_buffer;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Cleanup after network operations are complete and release the block
+ * of memory.
+ *
+ * Destroy an NNTI_buffer_t that was previously created by NNTI_alloc().
+ *
+ */
+NNTI_result_t NNTI_free (
+        NNTI_buffer_t    *reg_buf)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[reg_buf->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[reg_buf->transport_id].ops.nnti_free_fn(
+                reg_buf);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Prepare a block of memory for network operations.
+ *
+ * Wrap a user allocated block of memory in an NNTI_buffer_t.  The transport
+ * may take additional actions to prepare the memory for network send/receive.
+ * If the memory block doesn't meet the transport's requirements for memory
+ * regions, then errors or poor performance may result.
+ *
+ */
+NNTI_result_t NNTI_register_memory (
+        const NNTI_transport_t *trans_hdl,
+        char                   *buffer,
+        const uint64_t          element_size,
+        const uint64_t          num_elements,
+        const NNTI_buf_ops_t    ops,
+        NNTI_buffer_t          *reg_buf)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        if (ops == NNTI_BOP_RECV_QUEUE) {
+            log_error(nnti_debug_level, "NNTI_BOP_RECV_QUEUE type require the use of NNTI_alloc().");
+            rc=NNTI_EINVAL;
+        } else {
+            rc = available_transports[trans_hdl->id].ops.nnti_register_memory_fn(
+                    trans_hdl,
+                    buffer,
+                    element_size,
+                    num_elements,
+                    ops,
+                    reg_buf);
+        }
+    }
+
+    reg_buf->datatype = NNTI_dt_buffer;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Prepare a list of memory segments for network operations.
+ *
+ * Wrap a list of user allocated memory segments in an NNTI_buffer_t.  The
+ * transport may take additional actions to prepare the memory segments for
+ * network send/receive.  If the memory segments don't meet the transport's
+ * requirements for memory regions, then errors or poor performance may
+ * result.
+ *
+ */
+NNTI_result_t NNTI_register_segments (
+        const NNTI_transport_t *trans_hdl,
+        char                  **segments,
+        const uint64_t         *segment_lengths,
+        const uint64_t          num_segments,
+        const NNTI_buf_ops_t    ops,
+        NNTI_buffer_t          *reg_buf)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        if ((ops == NNTI_BOP_RECV_QUEUE) || (ops == NNTI_BOP_RECV_RING)) {
+            log_error(nnti_debug_level, "NNTI_BOP_RECV_QUEUE and NNTI_BOP_RECV_RING types cannot be segmented.");
+            rc=NNTI_EINVAL;
+        } else {
+            rc = available_transports[trans_hdl->id].ops.nnti_register_segments_fn(
+                    trans_hdl,
+                    segments,
+                    segment_lengths,
+                    num_segments,
+                    ops,
+                    reg_buf);
+        }
+    }
+
+    reg_buf->datatype = NNTI_dt_buffer;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Cleanup after network operations are complete.
+ *
+ * Destroy an NNTI_buffer_t that was previously created by NNTI_regsiter_buffer().
+ * It is the user's responsibility to release the the memory region.
+ *
+ */
+NNTI_result_t NNTI_unregister_memory (
+        NNTI_buffer_t    *reg_buf)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[reg_buf->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[reg_buf->transport_id].ops.nnti_unregister_memory_fn(
+                reg_buf);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Calculate the number of bytes required to store an encoded NNTI datatype.
+ *
+ */
+NNTI_result_t NNTI_dt_sizeof (
+        const NNTI_transport_t *trans_hdl,
+        void                   *nnti_dt,
+        uint64_t               *packed_len)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        xdrproc_t sizeof_fn;
+        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
+
+        switch (*dt) {
+            case NNTI_dt_transport:
+                sizeof_fn=(xdrproc_t)&xdr_NNTI_transport_t;
+                break;
+            case NNTI_dt_peer:
+                sizeof_fn=(xdrproc_t)&xdr_NNTI_peer_t;
+                break;
+            case NNTI_dt_buffer:
+                sizeof_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
+                break;
+            case NNTI_dt_work_request:
+                sizeof_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
+                break;
+            case NNTI_dt_status:
+                sizeof_fn=(xdrproc_t)&xdr_NNTI_status_t;
+                break;
+        }
+        *packed_len = xdr_sizeof(sizeof_fn, nnti_dt);
+        *packed_len += sizeof(NNTI_datatype_t);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Encode an NNTI datatype into an array of bytes.
+ *
+ */
+NNTI_result_t NNTI_dt_pack (
+        const NNTI_transport_t *trans_hdl,
+        void                   *nnti_dt,
+        char                   *packed_buf,
+        uint64_t                packed_buflen)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        XDR       encode_xdrs;
+        xdrproc_t encode_fn;
+        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
+
+        switch (*dt) {
+            case NNTI_dt_transport:
+                encode_fn=(xdrproc_t)&xdr_NNTI_transport_t;
+                break;
+            case NNTI_dt_peer:
+                encode_fn=(xdrproc_t)&xdr_NNTI_peer_t;
+                break;
+            case NNTI_dt_buffer:
+                encode_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
+                break;
+            case NNTI_dt_work_request:
+                encode_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
+                break;
+            case NNTI_dt_status:
+                encode_fn=(xdrproc_t)&xdr_NNTI_status_t;
+                break;
+        }
+
+        *(NNTI_datatype_t*)packed_buf = *dt;
+
+        packed_buf += sizeof(NNTI_datatype_t);
+        packed_buflen -= sizeof(NNTI_datatype_t);
+
+        xdrmem_create(
+                &encode_xdrs,
+                packed_buf,
+                packed_buflen,
+                XDR_ENCODE);
+
+        if (!encode_fn(&encode_xdrs, nnti_dt)) {
+            log_fatal(nnti_debug_level,"packing failed");
+            return NNTI_EENCODE;
+        }
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Decode an array of bytes into an NNTI datatype.
+ *
+ */
+NNTI_result_t NNTI_dt_unpack (
+        const NNTI_transport_t *trans_hdl,
+        void                   *nnti_dt,
+        char                   *packed_buf,
+        uint64_t                packed_buflen)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        XDR       decode_xdrs;
+        xdrproc_t decode_fn;
+        NNTI_datatype_t *dt=(NNTI_datatype_t*)packed_buf;
+        uint64_t dt_size;
+
+        switch (*dt) {
+            case NNTI_dt_transport:
+                decode_fn=(xdrproc_t)&xdr_NNTI_transport_t;
+                dt_size=sizeof(NNTI_transport_t);
+                break;
+            case NNTI_dt_peer:
+                decode_fn=(xdrproc_t)&xdr_NNTI_peer_t;
+                dt_size=sizeof(NNTI_peer_t);
+                break;
+            case NNTI_dt_buffer:
+                decode_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
+                dt_size=sizeof(NNTI_buffer_t);
+                break;
+            case NNTI_dt_work_request:
+                decode_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
+                dt_size=sizeof(NNTI_work_request_t);
+                break;
+            case NNTI_dt_status:
+                decode_fn=(xdrproc_t)&xdr_NNTI_status_t;
+                dt_size=sizeof(NNTI_status_t);
+                break;
+        }
+
+        packed_buf += sizeof(NNTI_datatype_t);
+        packed_buflen -= sizeof(NNTI_datatype_t);
+
+        memset(nnti_dt, 0, dt_size);
+        xdrmem_create(
+                &decode_xdrs,
+                packed_buf,
+                packed_buflen,
+                XDR_DECODE);
+        if (!decode_fn(&decode_xdrs, nnti_dt)) {
+            log_fatal(nnti_debug_level,"unpacking failed");
+            return NNTI_EDECODE;
+        }
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Free a variable size NNTI datatype that was unpacked with NNTI_dt_unpack().
+ *
+ */
+NNTI_result_t NNTI_dt_free (
+        const NNTI_transport_t *trans_hdl,
+        void                   *nnti_dt)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        xdrproc_t free_fn;
+        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
+
+        switch (*dt) {
+            case NNTI_dt_transport:
+                free_fn=(xdrproc_t)&xdr_NNTI_transport_t;
+                break;
+            case NNTI_dt_peer:
+                free_fn=(xdrproc_t)&xdr_NNTI_peer_t;
+                break;
+            case NNTI_dt_buffer:
+                free_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
+                break;
+            case NNTI_dt_work_request:
+                free_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
+                break;
+            case NNTI_dt_status:
+                free_fn=(xdrproc_t)&xdr_NNTI_status_t;
+                break;
+        }
+
+        xdr_free(free_fn, nnti_dt);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Send a message to a peer.
+ *
+ * Send a message (<tt>msg_hdl</tt>) to a peer (<tt>peer_hdl</tt>).  The
+ * message must fit in a slot of the peer's request queue (or in its request
+ * ring).  Larger messages go with NNTI_rendezvous_send().
+ *
+ */
+NNTI_result_t NNTI_send (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[msg_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[msg_hdl->transport_id].ops.nnti_send_fn(
+                peer_hdl,
+                msg_hdl,
+                dest_hdl,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Send a message to a peer's request queue by rendezvous.
+ *
+ */
+NNTI_result_t NNTI_rendezvous_send (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[msg_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else if (!(msg_hdl->ops & NNTI_BOP_REMOTE_READ)) {
+        rc=NNTI_EINVAL;
+    } else {
+        rc = rv_send(
+                peer_hdl,
+                msg_hdl,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Get the length of the message announced by a rendezvous header.
+ *
+ */
+NNTI_result_t NNTI_rendezvous_length (
+        const NNTI_status_t *status,
+        uint64_t            *length)
+{
+    const nnti_rv_header *hdr=(const nnti_rv_header *)(status->start + status->offset);
+
+    if ((status->length < sizeof(nnti_rv_header)) || (hdr->magic != NNTI_RV_MAGIC)) {
+        return(NNTI_ENOENT);
+    }
+
+    *length=hdr->length;
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Pull the message announced by a rendezvous header.
+ *
+ * The buffer handles in the header are unpacked into a slot that lives
+ * until <tt>wr</tt> completes, when the wait functions send the reply.
+ *
+ */
+NNTI_result_t NNTI_rendezvous_recv (
+        const NNTI_status_t *status,
+        const NNTI_buffer_t *dest_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr)
+{
+    const nnti_rv_header *hdr=(const nnti_rv_header *)(status->start + status->offset);
+    nnti_rv_table        *t=&rv_tables[dest_hdl->transport_id];
+    nnti_rv_slot         *slot=NULL;
+    char                 *packed=NULL;
+    NNTI_result_t         rc=NNTI_OK;
+
+    if (available_transports[dest_hdl->transport_id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+    if ((status->length < sizeof(nnti_rv_header)) || (hdr->magic != NNTI_RV_MAGIC)) {
+        return(NNTI_ENOENT);
+    }
+    if (dest_offset + hdr->length > dest_hdl->payload_size) {
+        return(NNTI_EMSGSIZE);
+    }
+
+    slot=rv_take(t, FALSE);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+
+    packed=(char *)(hdr+1);
+    rc=NNTI_dt_unpack(t->trans_hdl, &slot->remote_msg, packed, hdr->msg_len);
+    if (rc == NNTI_OK) {
+        rc=NNTI_dt_unpack(t->trans_hdl, &slot->remote_reply, packed + hdr->msg_len, hdr->reply_len);
+        if (rc != NNTI_OK) {
+            NNTI_dt_free(t->trans_hdl, &slot->remote_msg);
+        }
+    }
+    if (rc != NNTI_OK) {
+        rv_release(t, slot);
+        return(rc);
+    }
+    slot->unpacked=TRUE;
+
+    slot->user_wr=wr;
+    rc = available_transports[dest_hdl->transport_id].ops.nnti_get_fn(
+            &slot->remote_msg,
+            0,
+            hdr->length,
+            dest_hdl,
+            dest_offset,
+            wr);
+    if (rc != NNTI_OK) {
+        rv_release(t, slot);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data to a peer.
+ *
+ * Put the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt>.  It is
+ * assumed that the destination is at least <tt>src_length</tt> bytes in size.
+ *
+ */
+NNTI_result_t NNTI_put (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_put_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data to a peer as an ordered stream of chunks.
+ *
+ * Put the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt> in
+ * chunks of <tt>chunk_size</tt> bytes.  The target gets one event per chunk.
+ *
+ */
+NNTI_result_t NNTI_put_stream (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else if (available_transports[src_buffer_hdl->transport_id].ops.nnti_put_stream_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else {
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_put_stream_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset,
+                chunk_size,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data to a peer and tell the target what it was.
+ *
+ * Put the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt>.
+ * <tt>imm</tt> arrives in the status of the target's event.
+ *
+ */
+NNTI_result_t NNTI_put_notify (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else if (available_transports[src_buffer_hdl->transport_id].ops.nnti_put_notify_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else {
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_put_notify_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset,
+                imm,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data from a peer.
+ *
+ * Get the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt>.  It is
+ * assumed that the destination is at least <tt>src_length</tt> bytes in size.
+ *
+ */
+NNTI_result_t NNTI_get (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_get_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+/**
+ * @brief Send a message from unregistered memory.
+ *
+ * A queued message too large for a request slot always goes by
+ * rendezvous, so it is registered for NNTI_GET_SRC rather than bounced.
+ *
+ */
+NNTI_result_t NNTI_send_raw (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *peer_hdl,
+        const void             *msg,
+        const uint64_t          length,
+        const NNTI_buffer_t    *dest_hdl,
+        NNTI_work_request_t    *wr)
+{
+    nnti_raw_table *t=&raw_tables[trans_hdl->id];
+    nnti_raw_slot  *slot=NULL;
+    int8_t          rendezvous=FALSE;
+    int8_t          bounce=FALSE;
+    NNTI_result_t   rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    rendezvous=(dest_hdl == NULL) && (length > NNTI_REQUEST_BUFFER_SIZE);
+    bounce    =!rendezvous && (length <= NNTI_RAW_BOUNCE_SIZE);
+
+    slot=raw_take(t, bounce);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+    if (bounce) {
+        memcpy(NNTI_BUFFER_C_POINTER(&slot->bounce), msg, length);
+        slot->view=slot->bounce;
+    } else {
+        slot->entry=raw_cache_get(t, msg, length, rendezvous ? NNTI_GET_SRC : NNTI_SEND_SRC);
+        if (slot->entry == NULL) {
+            raw_release(t, slot);
+            return(NNTI_ENOMEM);
+        }
+        slot->view=slot->entry->buf;
+    }
+    slot->view.payload_size=length;
+    slot->user_wr=wr;
+
+    if (rendezvous) {
+        rc=NNTI_rendezvous_send(peer_hdl, &slot->view, wr);
+    } else {
+        rc=NNTI_send(peer_hdl, &slot->view, dest_hdl, wr);
+    }
+    if (rc != NNTI_OK) {
+        raw_release(t, slot);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data from unregistered memory to a peer.
+ *
+ */
+NNTI_result_t NNTI_put_from (
+        const NNTI_transport_t *trans_hdl,
+        const void             *src,
+        const uint64_t          length,
+        const NNTI_buffer_t    *dest_buffer_hdl,
+        const uint64_t          dest_offset,
+        NNTI_work_request_t    *wr)
+{
+    nnti_raw_table *t=&raw_tables[trans_hdl->id];
+    nnti_raw_slot  *slot=NULL;
+    int8_t          bounce=(length <= NNTI_RAW_BOUNCE_SIZE);
+    NNTI_result_t   rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    slot=raw_take(t, bounce);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+    if (bounce) {
+        memcpy(NNTI_BUFFER_C_POINTER(&slot->bounce), src, length);
+        slot->view=slot->bounce;
+    } else {
+        slot->entry=raw_cache_get(t, src, length, NNTI_PUT_SRC);
+        if (slot->entry == NULL) {
+            raw_release(t, slot);
+            return(NNTI_ENOMEM);
+        }
+        slot->view=slot->entry->buf;
+    }
+    slot->user_wr=wr;
+
+    rc=NNTI_put(&slot->view, 0, length, dest_buffer_hdl, dest_offset, wr);
+    if (rc != NNTI_OK) {
+        raw_release(t, slot);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Transfer data from a peer into unregistered memory.
+ *
+ */
+NNTI_result_t NNTI_get_into (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_buffer_t    *src_buffer_hdl,
+        const uint64_t          src_offset,
+        const uint64_t          length,
+        void                   *dest,
+        NNTI_work_request_t    *wr)
+{
+    nnti_raw_table *t=&raw_tables[trans_hdl->id];
+    nnti_raw_slot  *slot=NULL;
+    int8_t          bounce=(length <= NNTI_RAW_BOUNCE_SIZE);
+    NNTI_result_t   rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    slot=raw_take(t, bounce);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+    if (bounce) {
+        slot->view    =slot->bounce;
+        slot->copy_out=dest;
+        slot->length  =length;
+    } else {
+        slot->entry=raw_cache_get(t, dest, length, NNTI_GET_DST);
+        if (slot->entry == NULL) {
+            raw_release(t, slot);
+            return(NNTI_ENOMEM);
+        }
+        slot->view=slot->entry->buf;
+    }
+    slot->user_wr=wr;
+
+    rc=NNTI_get(src_buffer_hdl, src_offset, length, &slot->view, 0, wr);
+    if (rc != NNTI_OK) {
+        raw_release(t, slot);
+    }
+
+    return(rc);
+}
+
+
+/**
+ * @brief Drop the idle registrations cached by the raw operations.
+ *
+ */
+NNTI_result_t NNTI_raw_cache_flush (
+        const NNTI_transport_t *trans_hdl)
+{
+    nnti_raw_table *t=&raw_tables[trans_hdl->id];
+    uint32_t        i=0;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    nthread_lock(&t->lock);
+    for (i=0;i<NNTI_RAW_CACHE_SIZE;i++) {
+        if (t->cache[i].valid && (t->cache[i].refs == 0)) {
+            NNTI_unregister_memory(&t->cache[i].buf);
+            t->cache[i].valid=FALSE;
+        }
+    }
+    nthread_unlock(&t->lock);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Set when coalesced operations are flushed.
+ *
+ */
+NNTI_result_t NNTI_coalesce_config (
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          max_bytes,
+        const int               max_delay)
+{
+    nnti_co_table *t=&co_tables[trans_hdl->id];
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+    if ((max_bytes <= sizeof(nnti_co_frame) + sizeof(nnti_co_record)) ||
+        (max_bytes > NNTI_COALESCE_SIZE) ||
+        (max_delay < 0)) {
+        return(NNTI_EINVAL);
+    }
+
+    nthread_lock(&t->lock);
+    t->max_bytes=max_bytes;
+    t->max_delay=max_delay;
+    nthread_unlock(&t->lock);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Send a small message to a peer as part of a batch.
+ *
+ */
+NNTI_result_t NNTI_send_coalesced (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        NNTI_work_request_t *wr)
+{
+    nnti_co_table  *t=&co_tables[msg_hdl->transport_id];
+    nnti_co_batch  *b=NULL;
+    nnti_co_op     *op=NULL;
+    nnti_co_record *record=NULL;
+    uint64_t        length=msg_hdl->payload_size;
+    uint64_t        need=sizeof(nnti_co_record) + NNTI_CO_ALIGN(length);
+    NNTI_result_t   rc=NNTI_OK;
+
+    if (available_transports[msg_hdl->transport_id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    nthread_lock(&t->lock);
+    co_flush_open(t, TRUE);
+
+    b=co_find_batch(t, peer_hdl, NULL);
+    if ((b != NULL) && (b->used + need > t->max_bytes)) {
+        if (co_flush_batch(t, b) == NNTI_EAGAIN) {
+            /* nothing may pass a refused batch */
+            nthread_unlock(&t->lock);
+            return(NNTI_EAGAIN);
+        }
+        b=NULL;
+    }
+    if (sizeof(nnti_co_frame) + need > t->max_bytes) {
+        /* too large for a batch.  it still goes out after the batch before it. */
+        nthread_unlock(&t->lock);
+        return(NNTI_send(peer_hdl, msg_hdl, NULL, wr));
+    }
+
+    op=co_take_op(t);
+    if (op == NULL) {
+        rc=NNTI_EAGAIN;
+    } else if (b == NULL) {
+        rc=co_open_batch(t, FALSE, &b);
+    }
+    if (rc != NNTI_OK) {
+        /* let the batches in flight drain */
+        co_flush_open(t, FALSE);
+        nthread_unlock(&t->lock);
+        return(rc);
+    }
+    b->peer=*peer_hdl;
+
+    record=(nnti_co_record *)(NNTI_BUFFER_C_POINTER(&b->send_buf) + b->used);
+    record->length  =length;
+    record->reserved=0;
+    memcpy(record+1, NNTI_BUFFER_C_POINTER(msg_hdl), length);
+    b->used+=need;
+
+    co_add_op(t, op, b, msg_hdl, 0, length, wr);
+    nthread_unlock(&t->lock);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Transfer a small piece of data to a peer as part of a batch.
+ *
+ */
+NNTI_result_t NNTI_put_coalesced (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        NNTI_work_request_t *wr)
+{
+    nnti_co_table *t=&co_tables[src_buffer_hdl->transport_id];
+    nnti_co_batch *b=NULL;
+    nnti_co_op    *op=NULL;
+    NNTI_result_t  rc=NNTI_OK;
+
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    nthread_lock(&t->lock);
+    co_flush_open(t, TRUE);
+
+    b=co_find_batch(t, NULL, dest_buffer_hdl);
+    if ((b != NULL) &&
+        ((dest_offset != b->dest_offset + b->used) || (b->used + src_length > t->max_bytes))) {
+        if (co_flush_batch(t, b) == NNTI_EAGAIN) {
+            nthread_unlock(&t->lock);
+            return(NNTI_EAGAIN);
+        }
+        b=NULL;
+    }
+    if (src_length > t->max_bytes) {
+        nthread_unlock(&t->lock);
+        return(NNTI_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, wr));
+    }
+
+    op=co_take_op(t);
+    if (op == NULL) {
+        rc=NNTI_EAGAIN;
+    } else if (b == NULL) {
+        rc=co_open_batch(t, TRUE, &b);
+        if (rc == NNTI_OK) {
+            b->dest_hdl   =dest_buffer_hdl;
+            b->dest_offset=dest_offset;
+        }
+    }
+    if (rc != NNTI_OK) {
+        co_flush_open(t, FALSE);
+        nthread_unlock(&t->lock);
+        return(rc);
+    }
+
+    memcpy(NNTI_BUFFER_C_POINTER(&b->put_buf) + b->used, NNTI_BUFFER_C_POINTER(src_buffer_hdl) + src_offset, src_length);
+    b->used+=src_length;
+
+    co_add_op(t, op, b, src_buffer_hdl, src_offset, src_length, wr);
+    nthread_unlock(&t->lock);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Send every open batch of coalesced operations.
+ *
+ */
+NNTI_result_t NNTI_coalesce_flush (
+        const NNTI_transport_t *trans_hdl)
+{
+    nnti_co_table *t=&co_tables[trans_hdl->id];
+    NNTI_result_t  rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    nthread_lock(&t->lock);
+    co_flush_open(t, FALSE);
+    /* what's still open was refused */
+    rc=(t->open > 0) ? NNTI_EAGAIN : NNTI_OK;
+    nthread_unlock(&t->lock);
+
+    return(rc);
+}
+
+
+/**
+ * @brief Get the number of messages in a received request.
+ *
+ */
+NNTI_result_t NNTI_coalesced_count (
+        const NNTI_status_t *status,
+        uint32_t            *count)
+{
+    const nnti_co_frame *frame=(const nnti_co_frame *)(status->start + status->offset);
+
+    if ((status->length < sizeof(nnti_co_frame)) || (frame->magic != NNTI_CO_MAGIC)) {
+        *count=1;
+    } else {
+        *count=frame->count;
+    }
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Describe one message of a received request.
+ *
+ */
+NNTI_result_t NNTI_coalesced_message (
+        const NNTI_status_t *status,
+        const uint32_t       index,
+        NNTI_status_t       *msg)
+{
+    const nnti_co_frame  *frame=(const nnti_co_frame *)(status->start + status->offset);
+    const nnti_co_record *record=NULL;
+    uint64_t              offset=sizeof(nnti_co_frame);
+    uint32_t              i=0;
+
+    if ((status->length < sizeof(nnti_co_frame)) || (frame->magic != NNTI_CO_MAGIC)) {
+        if (index > 0) {
+            return(NNTI_ENOENT);
+        }
+        *msg=*status;
+        return(NNTI_OK);
+    }
+    if (index >= frame->count) {
+        return(NNTI_ENOENT);
+    }
+
+    for (i=0;;i++) {
+        record=(const nnti_co_record *)((const char *)frame + offset);
+        if ((offset + sizeof(nnti_co_record) > status->length) ||
+            (offset + sizeof(nnti_co_record) + record->length > status->length)) {
+            log_error(nnti_debug_level, "coalesced request is corrupt (index=%u ; offset=%llu ; length=%llu)",
+                    i, (unsigned long long)offset, (unsigned long long)status->length);
+            return(NNTI_ENOENT);
+        }
+        if (i == index) {
+            break;
+        }
+        offset+=sizeof(nnti_co_record) + NNTI_CO_ALIGN(record->length);
+    }
+
+    *msg=*status;
+    msg->offset=status->offset + offset + sizeof(nnti_co_record);
+    msg->length=record->length;
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Transfer a list of regions to a peer.
+ *
+ * Each entry of <tt>iov</tt> puts a region of <tt>src_buffer_hdl</tt> into
+ * <tt>dest_buffer_hdl</tt>.  The whole list is one work request.
+ *
+ */
+NNTI_result_t NNTI_putv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else if (available_transports[src_buffer_hdl->transport_id].ops.nnti_putv_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else {
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_putv_fn(
+                src_buffer_hdl,
+                dest_buffer_hdl,
+                iov,
+                iov_count,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
 
     return(rc);
 }
 
 
 /**
- * @brief Return the URL field of this transport.
- *
- * Return the URL field of this transport.  After initialization, the transport will
- * have a specific location on the network where peers can contact it.  The
- * transport will convert this location to a string that other instances of the
- * transport will recognize.
+ * @brief Transfer a list of regions from a peer.
  *
- * URL format: "transport://address/memory_descriptor"
- *    - transport - (required) identifies how the URL should parsed
- *    - address   - (required) uniquely identifies a location on the network
- *                - ex. "ptl://nid:pid/", "ib://ip_addr:port"
- *    - memory_descriptor - (optional) transport-specific representation of RMA params
+ * Each entry of <tt>iov</tt> gets a region of <tt>src_buffer_hdl</tt> into
+ * <tt>dest_buffer_hdl</tt>.  The whole list is one work request.
  *
  */
-NNTI_result_t NNTI_get_url (
-        const NNTI_transport_t *trans_hdl,
-        char                   *url,
-        const uint64_t          maxlen)
+NNTI_result_t NNTI_getv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[dest_buffer_hdl->transport_id].ops.nnti_getv_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_get_url_fn(
-                trans_hdl,
-                url,
-                maxlen);
+        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_getv_fn(
+                src_buffer_hdl,
+                dest_buffer_hdl,
+                iov,
+                iov_count,
+                wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
+
 /**
- * @brief Prepare for communication with the peer identified by <tt>url</tt>.
- *
- * Parse <tt>url</tt> in a transport specific way.  Perform any transport specific
- * actions necessary to begin communication with this peer.
+ * @brief Transfer data to a peer.
  *
  */
-NNTI_result_t NNTI_connect (
-        const NNTI_transport_t *trans_hdl,
-        const char             *url,
-        const int               timeout,
-        NNTI_peer_t            *peer_hdl)
+NNTI_result_t NNTI_scatter (
+        const NNTI_buffer_t  *src_buffer_hdl,
+        const uint64_t        src_length,
+        const NNTI_buffer_t **dest_buffer_list,
+        const uint64_t        dest_count,
+        NNTI_work_request_t  *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_connect_fn(
-                trans_hdl,
-                url,
-                timeout,
-                peer_hdl);
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_scatter_fn(
+                src_buffer_hdl,
+                src_length,
+                dest_buffer_list,
+                dest_count,
+                wr);
     }
 
-    peer_hdl->datatype = NNTI_dt_peer;
+    wr->datatype = NNTI_dt_work_request;
 
     return(rc);
 }
 
 
 /**
- * @brief Terminate communication with this peer.
- *
- * Perform any transport specific actions necessary to end communication with
- * this peer.
+ * @brief Transfer data from a peer.
  *
  */
-NNTI_result_t NNTI_disconnect (
-        const NNTI_transport_t *trans_hdl,
-        NNTI_peer_t            *peer_hdl)
+NNTI_result_t NNTI_gather (
+        const NNTI_buffer_t **src_buffer_list,
+        const uint64_t        src_length,
+        const uint64_t        src_count,
+        const NNTI_buffer_t  *dest_buffer_hdl,
+        NNTI_work_request_t  *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_gather_fn(
+                src_buffer_list,
+                src_length,
+                src_count,
+                dest_buffer_hdl,
+                wr);
+    }
+
+    wr->datatype = NNTI_dt_work_request;
+
+    return(rc);
+}
+
+
+NNTI_result_t NNTI_atomic_set_callback (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context)
 {
     NNTI_result_t rc=NNTI_OK;
 
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_disconnect_fn(
+        rc = available_transports[trans_hdl->id].ops.nnti_atomic_set_callback_fn(
                 trans_hdl,
-                peer_hdl);
+                local_atomic,
+                cbfunc,
+                context);
     }
 
     return(rc);
 }
 
 
-/**
- * @brief Allocate a block of memory and prepare it for network operations.
- *
- * Allocate a block of memory in a transport specific way and wrap it in an
- * NNTI_buffer_t.  The transport may take additional actions to prepare the
- * memory for network send/receive.
- *
- */
-NNTI_result_t NNTI_alloc (
-        const NNTI_transport_t *trans_hdl,
-        const uint64_t          element_size,
-        const uint64_t          num_elements,
-        const NNTI_buf_ops_t    ops,
-        NNTI_buffer_t          *reg_buf)
+NNTI_result_t NNTI_atomic_set_threshold_callback (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		const int64_t           threshold,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context)
 {
     NNTI_result_t rc=NNTI_OK;
 
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[trans_hdl->id].ops.nnti_atomic_set_threshold_callback_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_alloc_fn(
+        rc = available_transports[trans_hdl->id].ops.nnti_atomic_set_threshold_callback_fn(
                 trans_hdl,
-                element_size,
-                num_elements,
-                ops,
-                reg_buf);
+                local_atomic,
+                threshold,
+                cbfunc,
+                context);
     }
 
-    reg_buf->datatype = NNTI_dt_buffer;
+    return(rc);
+}
+
+
+NNTI_result_t NNTI_atomic_read (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		int64_t                *value)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[trans_hdl->id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[trans_hdl->id].ops.nnti_atomic_read_fn(
+                trans_hdl,
+                local_atomic,
+                value);
+    }
 
     return(rc);
 }
 
 
-/**
- * @brief Cleanup after network operations are complete and release the block
- * of memory.
- *
- * Destroy an NNTI_buffer_t that was previously created by NNTI_alloc().
- *
- */
-NNTI_result_t NNTI_free (
-        NNTI_buffer_t    *reg_buf)
+NNTI_result_t NNTI_atomic_fop (
+		const NNTI_transport_t *trans_hdl,
+		const NNTI_peer_t      *peer_hdl,
+		const uint64_t          target_atomic,
+		const uint64_t          result_atomic,
+		const int64_t           operand,
+		const NNTI_atomic_op_t  op,
+		NNTI_work_request_t    *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[reg_buf->transport_id].initialized==0) {
+    if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (nnti_atomic_fetches(op) < 0) {
+        rc=NNTI_EINVAL;
     } else {
-        rc = available_transports[reg_buf->transport_id].ops.nnti_free_fn(
-                reg_buf);
+        rc = available_transports[trans_hdl->id].ops.nnti_atomic_fop_fn(
+                trans_hdl,
+                peer_hdl,
+                target_atomic,
+                result_atomic,
+                operand,
+                op,
+                wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
 
-/**
- * @brief Prepare a block of memory for network operations.
- *
- * Wrap a user allocated block of memory in an NNTI_buffer_t.  The transport
- * may take additional actions to prepare the memory for network send/receive.
- * If the memory block doesn't meet the transport's requirements for memory
- * regions, then errors or poor performance may result.
- *
+/*
+ * The target and result of a buffer atomic must be aligned 64-bit
+ * variables inside their buffers.  The target buffer must allow atomics.
  */
-NNTI_result_t NNTI_register_memory (
-        const NNTI_transport_t *trans_hdl,
-        char                   *buffer,
-        const uint64_t          element_size,
-        const uint64_t          num_elements,
-        const NNTI_buf_ops_t    ops,
-        NNTI_buffer_t          *reg_buf)
+static NNTI_result_t check_atomic_buffers(
+        const NNTI_buffer_t *target_buf,
+        const uint64_t       target_offset,
+        const NNTI_buffer_t *result_buf,
+        const uint64_t       result_offset,
+        const int            need_result)
+{
+    if (!(target_buf->ops & NNTI_BOP_ATOMICS) ||
+        (target_offset % sizeof(int64_t) != 0) ||
+        (target_offset + sizeof(int64_t) > target_buf->payload_size)) {
+        return(NNTI_EINVAL);
+    }
+    if (result_buf == NULL) {
+        return(need_result ? NNTI_EINVAL : NNTI_OK);
+    }
+    if ((result_offset % sizeof(int64_t) != 0) ||
+        (result_offset + sizeof(int64_t) > result_buf->payload_size)) {
+        return(NNTI_EINVAL);
+    }
+
+    return(NNTI_OK);
+}
+
+
+NNTI_result_t NNTI_atomic_cswap (
+		const NNTI_transport_t *trans_hdl,
+		const NNTI_peer_t      *peer_hdl,
+		const uint64_t          target_atomic,
+		const uint64_t          result_atomic,
+		const int64_t           compare_operand,
+		const int64_t           swap_operand,
+		NNTI_work_request_t    *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        if (ops == NNTI_BOP_RECV_QUEUE) {
-            log_error(nnti_debug_level, "NNTI_BOP_RECV_QUEUE type require the use of NNTI_alloc().");
-            rc=NNTI_EINVAL;
-        } else {
-            rc = available_transports[trans_hdl->id].ops.nnti_register_memory_fn(
-                    trans_hdl,
-                    buffer,
-                    element_size,
-                    num_elements,
-                    ops,
-                    reg_buf);
-        }
+        rc = available_transports[trans_hdl->id].ops.nnti_atomic_cswap_fn(
+                trans_hdl,
+                peer_hdl,
+                target_atomic,
+                result_atomic,
+                compare_operand,
+                swap_operand,
+                wr);
     }
 
-    reg_buf->datatype = NNTI_dt_buffer;
+    wr->datatype = NNTI_dt_work_request;
 
     return(rc);
 }
 
 
 /**
- * @brief Prepare a list of memory segments for network operations.
- *
- * Wrap a list of user allocated memory segments in an NNTI_buffer_t.  The
- * transport may take additional actions to prepare the memory segments for
- * network send/receive.  If the memory segments don't meet the transport's
- * requirements for memory regions, then errors or poor performance may
- * result.
+ * @brief Perform a list of atomic operations on one peer.
  *
  */
-NNTI_result_t NNTI_register_segments (
-        const NNTI_transport_t *trans_hdl,
-        char                  **segments,
-        const uint64_t         *segment_lengths,
-        const uint64_t          num_segments,
-        const NNTI_buf_ops_t    ops,
-        NNTI_buffer_t          *reg_buf)
+NNTI_result_t NNTI_atomic_fopv (
+		const NNTI_transport_t     *trans_hdl,
+		const NNTI_peer_t          *peer_hdl,
+		const NNTI_atomic_update_t *updates,
+		const uint32_t              update_count,
+		NNTI_work_request_t        *wr)
 {
     NNTI_result_t rc=NNTI_OK;
+    uint32_t      i;
 
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[trans_hdl->id].ops.nnti_atomic_fopv_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else if ((updates == NULL) || (update_count == 0)) {
+        rc=NNTI_EINVAL;
     } else {
-        if (ops == NNTI_BOP_RECV_QUEUE) {
-            log_error(nnti_debug_level, "NNTI_BOP_RECV_QUEUE type cannot be segmented.");
-            rc=NNTI_EINVAL;
-        } else {
-            rc = available_transports[trans_hdl->id].ops.nnti_register_segments_fn(
+        for (i=0;i<update_count;i++) {
+            if (nnti_atomic_fetches(updates[i].op) < 0) {
+                rc=NNTI_EINVAL;
+                break;
+            }
+        }
+        if (rc == NNTI_OK) {
+            rc = available_transports[trans_hdl->id].ops.nnti_atomic_fopv_fn(
                     trans_hdl,
-                    segments,
-                    segment_lengths,
-                    num_segments,
-                    ops,
-                    reg_buf);
+                    peer_hdl,
+                    updates,
+                    update_count,
+                    wr);
         }
     }
 
-    reg_buf->datatype = NNTI_dt_buffer;
+    wr->datatype = NNTI_dt_work_request;
 
     return(rc);
 }
 
 
 /**
- * @brief Cleanup after network operations are complete.
+ * @brief Perform an atomic operation on a variable in a registered buffer.
  *
- * Destroy an NNTI_buffer_t that was previously created by NNTI_regsiter_buffer().
- * It is the user's responsibility to release the the memory region.
+ * The fetched value lands in <tt>result_buf</tt> at <tt>result_offset</tt>.
  *
  */
-NNTI_result_t NNTI_unregister_memory (
-        NNTI_buffer_t    *reg_buf)
+NNTI_result_t NNTI_atomic_fop_buffer (
+		const NNTI_buffer_t    *target_buf,
+		const uint64_t          target_offset,
+		const NNTI_buffer_t    *result_buf,
+		const uint64_t          result_offset,
+		const int64_t           operand,
+		const NNTI_atomic_op_t  op,
+		NNTI_work_request_t    *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[reg_buf->transport_id].initialized==0) {
+    if (available_transports[target_buf->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
-    } else {
-        rc = available_transports[reg_buf->transport_id].ops.nnti_unregister_memory_fn(
-                reg_buf);
+    } else if (available_transports[target_buf->transport_id].ops.nnti_atomic_fop_buffer_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else if (nnti_atomic_fetches(op) < 0) {
+        rc=NNTI_EINVAL;
+    } else if ((rc=check_atomic_buffers(target_buf, target_offset, result_buf, result_offset, nnti_atomic_fetches(op))) == NNTI_OK) {
+        rc = available_transports[target_buf->transport_id].ops.nnti_atomic_fop_buffer_fn(
+                target_buf,
+                target_offset,
+                result_buf,
+                result_offset,
+                operand,
+                op,
+                wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
 
 /**
- * @brief Calculate the number of bytes required to store an encoded NNTI datatype.
+ * @brief Perform a compare-and-swap on a variable in a registered buffer.
  *
  */
-NNTI_result_t NNTI_dt_sizeof (
-        const NNTI_transport_t *trans_hdl,
-        void                   *nnti_dt,
-        uint64_t               *packed_len)
+NNTI_result_t NNTI_atomic_cswap_buffer (
+		const NNTI_buffer_t    *target_buf,
+		const uint64_t          target_offset,
+		const NNTI_buffer_t    *result_buf,
+		const uint64_t          result_offset,
+		const int64_t           compare_operand,
+		const int64_t           swap_operand,
+		NNTI_work_request_t    *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[target_buf->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
-    } else {
-        xdrproc_t sizeof_fn;
-        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
-
-        switch (*dt) {
-            case NNTI_dt_transport:
-                sizeof_fn=(xdrproc_t)&xdr_NNTI_transport_t;
-                break;
-            case NNTI_dt_peer:
-                sizeof_fn=(xdrproc_t)&xdr_NNTI_peer_t;
-                break;
-            case NNTI_dt_buffer:
-                sizeof_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
-                break;
-            case NNTI_dt_work_request:
-                sizeof_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
-                break;
-            case NNTI_dt_status:
-                sizeof_fn=(xdrproc_t)&xdr_NNTI_status_t;
-                break;
-        }
-        *packed_len = xdr_sizeof(sizeof_fn, nnti_dt);
-        *packed_len += sizeof(NNTI_datatype_t);
+    } else if (available_transports[target_buf->transport_id].ops.nnti_atomic_cswap_buffer_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else if ((rc=check_atomic_buffers(target_buf, target_offset, result_buf, result_offset, TRUE)) == NNTI_OK) {
+        rc = available_transports[target_buf->transport_id].ops.nnti_atomic_cswap_buffer_fn(
+                target_buf,
+                target_offset,
+                result_buf,
+                result_offset,
+                compare_operand,
+                swap_operand,
+                wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
 
 /**
- * @brief Encode an NNTI datatype into an array of bytes.
+ * @brief Create a receive work request that can be used to wait for buffer
+ * operations to complete.
  *
  */
-NNTI_result_t NNTI_dt_pack (
-        const NNTI_transport_t *trans_hdl,
-        void                   *nnti_dt,
-        char                   *packed_buf,
-        uint64_t                packed_buflen)
+NNTI_result_t NNTI_create_work_request (
+        NNTI_buffer_t        *reg_buf,
+        NNTI_work_request_t  *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[reg_buf->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        XDR       encode_xdrs;
-        xdrproc_t encode_fn;
-        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
+        rc = available_transports[reg_buf->transport_id].ops.nnti_create_work_request_fn(
+                reg_buf,
+                wr);
+    }
 
-        switch (*dt) {
-            case NNTI_dt_transport:
-                encode_fn=(xdrproc_t)&xdr_NNTI_transport_t;
-                break;
-            case NNTI_dt_peer:
-                encode_fn=(xdrproc_t)&xdr_NNTI_peer_t;
-                break;
-            case NNTI_dt_buffer:
-                encode_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
-                break;
-            case NNTI_dt_work_request:
-                encode_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
-                break;
-            case NNTI_dt_status:
-                encode_fn=(xdrproc_t)&xdr_NNTI_status_t;
-                break;
-        }
+    wr->datatype = NNTI_dt_work_request;
 
-        *(NNTI_datatype_t*)packed_buf = *dt;
+    return(rc);
+}
 
-        packed_buf += sizeof(NNTI_datatype_t);
-        packed_buflen -= sizeof(NNTI_datatype_t);
 
-        xdrmem_create(
-                &encode_xdrs,
-                packed_buf,
-                packed_buflen,
-                XDR_ENCODE);
+/**
+ * @brief Disassociates a receive work request from a previous receive
+ * and prepares it for reuse.
+ *
+ */
+NNTI_result_t NNTI_clear_work_request (
+        NNTI_work_request_t  *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
 
-        if (!encode_fn(&encode_xdrs, nnti_dt)) {
-            log_fatal(nnti_debug_level,"packing failed");
-            return NNTI_EENCODE;
-        }
+    if (available_transports[wr->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[wr->transport_id].ops.nnti_clear_work_request_fn(
+                wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
 
 /**
- * @brief Decode an array of bytes into an NNTI datatype.
+ * @brief Disassociates a receive work request from reg_buf.
  *
  */
-NNTI_result_t NNTI_dt_unpack (
-        const NNTI_transport_t *trans_hdl,
-        void                   *nnti_dt,
-        char                   *packed_buf,
-        uint64_t                packed_buflen)
+NNTI_result_t NNTI_destroy_work_request (
+        NNTI_work_request_t  *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[wr->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        XDR       decode_xdrs;
-        xdrproc_t decode_fn;
-        NNTI_datatype_t *dt=(NNTI_datatype_t*)packed_buf;
-        uint64_t dt_size;
+        rc = available_transports[wr->transport_id].ops.nnti_destroy_work_request_fn(
+                wr);
+    }
 
-        switch (*dt) {
-            case NNTI_dt_transport:
-                decode_fn=(xdrproc_t)&xdr_NNTI_transport_t;
-                dt_size=sizeof(NNTI_transport_t);
-                break;
-            case NNTI_dt_peer:
-                decode_fn=(xdrproc_t)&xdr_NNTI_peer_t;
-                dt_size=sizeof(NNTI_peer_t);
-                break;
-            case NNTI_dt_buffer:
-                decode_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
-                dt_size=sizeof(NNTI_buffer_t);
-                break;
-            case NNTI_dt_work_request:
-                decode_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
-                dt_size=sizeof(NNTI_work_request_t);
-                break;
-            case NNTI_dt_status:
-                decode_fn=(xdrproc_t)&xdr_NNTI_status_t;
-                dt_size=sizeof(NNTI_status_t);
-                break;
-        }
+    wr->datatype = NNTI_dt_work_request;
 
-        packed_buf += sizeof(NNTI_datatype_t);
-        packed_buflen -= sizeof(NNTI_datatype_t);
+    return(rc);
+}
 
-        memset(nnti_dt, 0, dt_size);
-        xdrmem_create(
-                &decode_xdrs,
-                packed_buf,
-                packed_buflen,
-                XDR_DECODE);
-        if (!decode_fn(&decode_xdrs, nnti_dt)) {
-            log_fatal(nnti_debug_level,"unpacking failed");
-            return NNTI_EDECODE;
-        }
+
+/**
+ * @brief Attempts to cancel an NNTI opertion.
+ *
+ */
+NNTI_result_t NNTI_cancel (
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    if (available_transports[wr->transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else {
+        rc = available_transports[wr->transport_id].ops.nnti_cancel_fn(wr);
     }
 
+    wr->datatype = NNTI_dt_work_request;
+
     return(rc);
 }
 
 
 /**
- * @brief Free a variable size NNTI datatype that was unpacked with NNTI_dt_unpack().
+ * @brief Attempts to cancel a list of NNTI opertions.
  *
  */
-NNTI_result_t NNTI_dt_free (
-        const NNTI_transport_t *trans_hdl,
-        void                   *nnti_dt)
+NNTI_result_t NNTI_cancelall (
+        NNTI_work_request_t **wr_list,
+        const uint32_t        wr_count)
 {
     NNTI_result_t rc=NNTI_OK;
+    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
+    uint32_t i=0;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
-        rc=NNTI_ENOTINIT;
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i]) {
+            id=wr_list[i]->transport_id;
+        }
+    }
+
+    if (id == NNTI_TRANSPORT_NULL) {
+        rc=NNTI_EINVAL;
     } else {
-        xdrproc_t free_fn;
-        NNTI_datatype_t *dt=(NNTI_datatype_t*)nnti_dt;
+        if (available_transports[id].initialized==0) {
+            rc=NNTI_ENOTINIT;
+        } else {
+            rc = available_transports[id].ops.nnti_cancelall_fn(
+                    wr_list,
+                    wr_count);
+        }
+    }
 
-        switch (*dt) {
-            case NNTI_dt_transport:
-                free_fn=(xdrproc_t)&xdr_NNTI_transport_t;
-                break;
-            case NNTI_dt_peer:
-                free_fn=(xdrproc_t)&xdr_NNTI_peer_t;
-                break;
-            case NNTI_dt_buffer:
-                free_fn=(xdrproc_t)&xdr_NNTI_buffer_t;
-                break;
-            case NNTI_dt_work_request:
-                free_fn=(xdrproc_t)&xdr_NNTI_work_request_t;
-                break;
-            case NNTI_dt_status:
-                free_fn=(xdrproc_t)&xdr_NNTI_status_t;
-                break;
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i]) {
+            wr_list[i]->datatype = NNTI_dt_work_request;
         }
-
-        xdr_free(free_fn, nnti_dt);
     }
 
     return(rc);
@@ -781,393 +3545,572 @@ NNTI_result_t NNTI_dt_free (
 
 
 /**
- * @brief Send a message to a peer.
- *
- * Send a message (<tt>msg_hdl</tt>) to a peer (<tt>peer_hdl</tt>).  It is expected that the
- * message is small, but the exact maximum size is transport dependent.
+ * @brief Interrupts NNTI_wait*()
  *
  */
-NNTI_result_t NNTI_send (
-        const NNTI_peer_t   *peer_hdl,
-        const NNTI_buffer_t *msg_hdl,
-        const NNTI_buffer_t *dest_hdl,
-        NNTI_work_request_t *wr)
+NNTI_result_t NNTI_interrupt (
+        const NNTI_transport_t *trans_hdl)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[msg_hdl->transport_id].initialized==0) {
+    if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
-        rc = available_transports[msg_hdl->transport_id].ops.nnti_send_fn(
-                peer_hdl,
-                msg_hdl,
-                dest_hdl,
-                wr);
+        rc = available_transports[trans_hdl->id].ops.nnti_interrupt_fn(
+                trans_hdl);
     }
 
-    wr->datatype = NNTI_dt_work_request;
-
     return(rc);
 }
 
 
 /**
- * @brief Transfer data to a peer.
+ * @brief Wait for <tt>remote_op</tt> on <tt>reg_buf</tt> to complete.
  *
- * Put the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt>.  It is
- * assumed that the destination is at least <tt>src_length</tt> bytes in size.
+ * Wait for <tt>remote_op</tt> on <tt>reg_buf</tt> to complete or timeout
+ * waiting.  This is typically used to wait for a result or a bulk data
+ * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
+ * means wait forever.  A timeout of <tt>0</tt> means do not wait.
  *
  */
-NNTI_result_t NNTI_put (
-        const NNTI_buffer_t *src_buffer_hdl,
-        const uint64_t       src_offset,
-        const uint64_t       src_length,
-        const NNTI_buffer_t *dest_buffer_hdl,
-        const uint64_t       dest_offset,
-        NNTI_work_request_t *wr)
+NNTI_result_t NNTI_wait (
+        NNTI_work_request_t *wr,
+        const int            timeout,
+        NNTI_status_t       *status)
 {
-    NNTI_result_t rc=NNTI_OK;
+    NNTI_result_t  rc=NNTI_OK;
+    NNTI_buffer_t *reg_buf=wr->reg_buf;
+    nnti_co_op    *op=NULL;
+    int            remaining=timeout;
+    long           entry_time=trios_get_time_ms();
 
-    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
+    if (available_transports[wr->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if ((op=co_find_op(wr)) != NULL) {
+        rc=co_wait(wr->transport_id, op, timeout, status);
     } else {
-        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_put_fn(
-                src_buffer_hdl,
-                src_offset,
-                src_length,
-                dest_buffer_hdl,
-                dest_offset,
-                wr);
+        co_poll(wr->transport_id, timeout);
+        while (1) {
+            rc = available_transports[wr->transport_id].ops.nnti_wait_fn(
+                    wr,
+                    remaining,
+                    status);
+
+            if ((rc != NNTI_OK) || !am_watched(wr) || !am_dispatch(wr->transport_id, status)) {
+                if (rc != NNTI_ETIMEDOUT) {
+                    rc=wr_complete(wr, rc, status, timeout);
+                }
+                break;
+            }
+
+            /* the request was an active message.  wait for the next one. */
+            NNTI_destroy_work_request(wr);
+            NNTI_create_work_request(reg_buf, wr);
+
+            remaining=am_remaining(timeout, entry_time);
+            if (remaining == 0) {
+                rc=NNTI_ETIMEDOUT;
+                status->op    =wr->ops;
+                status->result=rc;
+                break;
+            }
+        }
     }
 
-    wr->datatype = NNTI_dt_work_request;
+    status->datatype = NNTI_dt_status;
 
     return(rc);
 }
 
 
 /**
- * @brief Transfer data from a peer.
+ * @brief Wait for <tt>remote_op</tt> on any buffer in <tt>buf_list</tt> to complete.
  *
- * Get the contents of <tt>src_buffer_hdl</tt> into <tt>dest_buffer_hdl</tt>.  It is
- * assumed that the destination is at least <tt>src_length</tt> bytes in size.
+ * Wait for <tt>remote_op</tt> on any buffer in <tt>buf_list</tt> to complete or timeout
+ * waiting.  This is typically used to wait for a result or a bulk data
+ * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
+ * means wait forever.  A timeout of <tt>0</tt> means do not wait.
+ *
+ * Caveats:
+ *   1) All buffers in buf_list must be registered with the same transport.
+ *   2) You can't wait on the receive queue and RDMA buffers in the same call.  Will probably be fixed in the future.
  *
  */
-NNTI_result_t NNTI_get (
-        const NNTI_buffer_t *src_buffer_hdl,
-        const uint64_t       src_offset,
-        const uint64_t       src_length,
-        const NNTI_buffer_t *dest_buffer_hdl,
-        const uint64_t       dest_offset,
-        NNTI_work_request_t *wr)
+NNTI_result_t NNTI_waitany (
+        NNTI_work_request_t **wr_list,
+        const uint32_t        wr_count,
+        const int             timeout,
+        uint32_t             *which,
+        NNTI_status_t        *status)
 {
     NNTI_result_t rc=NNTI_OK;
+    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
+    NNTI_buffer_t *reg_buf=NULL;
+    int      remaining=timeout;
+    long     entry_time=trios_get_time_ms();
+    uint32_t i=0;
 
-    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
-        rc=NNTI_ENOTINIT;
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i]) {
+            id=wr_list[i]->transport_id;
+        }
+    }
+
+    if (id == NNTI_TRANSPORT_NULL) {
+        rc=NNTI_EINVAL;
     } else {
-        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_get_fn(
-                src_buffer_hdl,
-                src_offset,
-                src_length,
-                dest_buffer_hdl,
-                dest_offset,
-                wr);
+        if (available_transports[id].initialized==0) {
+            rc=NNTI_ENOTINIT;
+        } else if (co_find_any(wr_list, wr_count)) {
+            rc=co_waitany(id, wr_list, wr_count, timeout, which, status);
+        } else {
+            co_poll(id, timeout);
+            while (1) {
+                /* a failure that doesn't name a work request completes none */
+                *which=wr_count;
+                rc = available_transports[id].ops.nnti_waitany_fn(
+                        wr_list,
+                        wr_count,
+                        remaining,
+                        which,
+                        status);
+
+                if ((rc != NNTI_OK) || !am_watched(wr_list[*which]) || !am_dispatch(id, status)) {
+                    if ((rc != NNTI_ETIMEDOUT) && (*which < wr_count) && (wr_list[*which] != NULL)) {
+                        rc=wr_complete(wr_list[*which], rc, status, timeout);
+                    }
+                    break;
+                }
+
+                /* the request was an active message.  wait for the next one. */
+                reg_buf=wr_list[*which]->reg_buf;
+                NNTI_destroy_work_request(wr_list[*which]);
+                NNTI_create_work_request(reg_buf, wr_list[*which]);
+
+                remaining=am_remaining(timeout, entry_time);
+                if (remaining == 0) {
+                    rc=NNTI_ETIMEDOUT;
+                    status->op    =wr_list[*which]->ops;
+                    status->result=rc;
+                    break;
+                }
+            }
+        }
     }
 
-    wr->datatype = NNTI_dt_work_request;
+    status->datatype = NNTI_dt_status;
 
     return(rc);
 }
 
 
 /**
- * @brief Transfer data to a peer.
+ * @brief Wait for <tt>remote_op</tt> on all buffers in <tt>buf_list</tt> to complete.
+ *
+ * Wait for <tt>remote_op</tt> on all buffers in <tt>buf_list</tt> to complete or timeout
+ * waiting.  This is typically used to wait for a result or a bulk data
+ * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
+ * means wait forever.  A timeout of <tt>0</tt> means do not wait.
+ *
+ * Caveats:
+ *   1) All buffers in buf_list must be registered with the same transport.
+ *   2) You can't wait on the receive queue and RDMA buffers in the same call.  Will probably be fixed in the future.
  *
  */
-NNTI_result_t NNTI_scatter (
-        const NNTI_buffer_t  *src_buffer_hdl,
-        const uint64_t        src_length,
-        const NNTI_buffer_t **dest_buffer_list,
-        const uint64_t        dest_count,
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_waitall (
+        NNTI_work_request_t **wr_list,
+        const uint32_t        wr_count,
+        const int             timeout,
+        NNTI_status_t       **status)
 {
     NNTI_result_t rc=NNTI_OK;
+    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
+    uint32_t i=0;
 
-    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
-        rc=NNTI_ENOTINIT;
+    for (i=0;i<wr_count;i++) {
+        if (wr_list[i]) {
+            id=wr_list[i]->transport_id;
+        }
+    }
+
+    if (id == NNTI_TRANSPORT_NULL) {
+        rc=NNTI_EINVAL;
     } else {
-        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_scatter_fn(
-                src_buffer_hdl,
-                src_length,
-                dest_buffer_list,
-                dest_count,
-                wr);
+        if (available_transports[id].initialized==0) {
+            rc=NNTI_ENOTINIT;
+        } else if (co_find_any(wr_list, wr_count)) {
+            rc=co_waitall(id, wr_list, wr_count, timeout, status);
+        } else {
+            co_poll(id, timeout);
+            for (i=0;i<wr_count;i++) {
+                if ((wr_list[i]) && ((rv_find(wr_list[i]) != NULL) || (raw_find(id, wr_list[i]) != NULL))) {
+                    break;
+                }
+            }
+            if (i < wr_count) {
+                rc=wr_waitall(id, wr_list, wr_count, timeout, status);
+            } else {
+                rc = available_transports[id].ops.nnti_waitall_fn(
+                        wr_list,
+                        wr_count,
+                        timeout,
+                        status);
+            }
+        }
     }
 
-    wr->datatype = NNTI_dt_work_request;
+    for (i=0;i<wr_count;i++) {
+        if (status[i]) {
+            status[i]->datatype = NNTI_dt_status;
+        }
+    }
 
     return(rc);
 }
 
 
 /**
- * @brief Transfer data from a peer.
+ * @brief Take up to <tt>max_count</tt> received requests from a receive queue.
+ *
+ * The returned slots stay on loan to the caller until they are returned
+ * with NNTI_release_requests().
  *
  */
-NNTI_result_t NNTI_gather (
-        const NNTI_buffer_t **src_buffer_list,
-        const uint64_t        src_length,
-        const uint64_t        src_count,
-        const NNTI_buffer_t  *dest_buffer_hdl,
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_dequeue_requests (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count)
 {
     NNTI_result_t rc=NNTI_OK;
+    int      remaining=timeout;
+    long     entry_time=trios_get_time_ms();
+    uint32_t kept=0;
+    uint32_t i=0;
 
-    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
+    *count=0;
+
+    if (available_transports[reg_buf->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[reg_buf->transport_id].ops.nnti_dequeue_requests_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_gather_fn(
-                src_buffer_list,
-                src_length,
-                src_count,
-                dest_buffer_hdl,
-                wr);
+        while (1) {
+            rc = available_transports[reg_buf->transport_id].ops.nnti_dequeue_requests_fn(
+                    reg_buf,
+                    max_count,
+                    remaining,
+                    wr_list,
+                    status_list,
+                    count);
+
+            if ((rc != NNTI_OK) || (am_tables[reg_buf->transport_id].handler_count == 0)) {
+                break;
+            }
+
+            /* run the active messages and return their slots.  pack the rest. */
+            kept=0;
+            for (i=0;i<*count;i++) {
+                if (am_dispatch(reg_buf->transport_id, &status_list[i])) {
+                    available_transports[reg_buf->transport_id].ops.nnti_release_requests_fn(&wr_list[i], 1);
+                } else {
+                    if (kept != i) {
+                        wr_list[kept]    =wr_list[i];
+                        status_list[kept]=status_list[i];
+                    }
+                    kept++;
+                }
+            }
+            *count=kept;
+            if (kept > 0) {
+                break;
+            }
+
+            remaining=am_remaining(timeout, entry_time);
+            if (remaining == 0) {
+                rc=NNTI_ETIMEDOUT;
+                break;
+            }
+        }
     }
 
-    wr->datatype = NNTI_dt_work_request;
+    for (i=0;i<*count;i++) {
+        wr_list[i].datatype     = NNTI_dt_work_request;
+        status_list[i].datatype = NNTI_dt_status;
+    }
 
     return(rc);
 }
 
 
-NNTI_result_t NNTI_atomic_set_callback (
-		const NNTI_transport_t *trans_hdl,
-		const uint64_t          local_atomic,
-		NNTI_callback_fn_t      cbfunc,
-		void                   *context)
+/**
+ * @brief Return loaned request slots to the receive queue.
+ *
+ * The transport reposts each slot so it can receive another request.
+ *
+ */
+NNTI_result_t NNTI_release_requests (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count)
 {
     NNTI_result_t rc=NNTI_OK;
+    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (wr_count == 0) {
+        return(NNTI_OK);
+    }
+
+    id=wr_list[0].transport_id;
+
+    if (available_transports[id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[id].ops.nnti_release_requests_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_atomic_set_callback_fn(
-                trans_hdl,
-                local_atomic,
-                cbfunc,
-                context);
+        rc = available_transports[id].ops.nnti_release_requests_fn(
+                wr_list,
+                wr_count);
     }
 
     return(rc);
 }
 
 
-NNTI_result_t NNTI_atomic_read (
-		const NNTI_transport_t *trans_hdl,
-		const uint64_t          local_atomic,
-		int64_t                *value)
+/**
+ * @brief Create a target completion counter.
+ *
+ * The counter itself is the same on every transport.  The transport
+ * counts into it once buffers are bound with NNTI_counter_bind().
+ *
+ */
+NNTI_result_t NNTI_counter_create (
+        const NNTI_transport_t *trans_hdl,
+        NNTI_counter_t         *counter)
 {
-    NNTI_result_t rc=NNTI_OK;
+    nnti_counter *c=NULL;
 
     if (available_transports[trans_hdl->id].initialized==0) {
-        rc=NNTI_ENOTINIT;
-    } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_atomic_read_fn(
-                trans_hdl,
-                local_atomic,
-                value);
+        return(NNTI_ENOTINIT);
     }
 
-    return(rc);
+    c=(nnti_counter *)calloc(1, sizeof(nnti_counter));
+    if (c == NULL) {
+        return(NNTI_ENOMEM);
+    }
+    nthread_counter_init(&c->value);
+
+    counter->transport_id     =trans_hdl->id;
+    counter->transport_private=(uint64_t)c;
+
+    return(NNTI_OK);
 }
 
 
-NNTI_result_t NNTI_atomic_fop (
-		const NNTI_transport_t *trans_hdl,
-		const NNTI_peer_t      *peer_hdl,
-		const uint64_t          target_atomic,
-		const uint64_t          result_atomic,
-		const int64_t           operand,
-		const NNTI_atomic_op_t  op,
-		NNTI_work_request_t    *wr)
+/**
+ * @brief Bind a target buffer to a counter.
+ *
+ * Puts and gets that complete on <tt>reg_buf</tt> are counted in
+ * <tt>counter</tt> instead of raising events.  A NULL <tt>counter</tt> unbinds.
+ *
+ */
+NNTI_result_t NNTI_counter_bind (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[reg_buf->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[reg_buf->transport_id].ops.nnti_counter_bind_fn==NULL) {
+        rc=NNTI_ENOTSUP;
+    } else if ((counter != NULL) && (counter->transport_id != reg_buf->transport_id)) {
+        rc=NNTI_EINVAL;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_atomic_fop_fn(
-                trans_hdl,
-                peer_hdl,
-                target_atomic,
-                result_atomic,
-                operand,
-                op,
-                wr);
-    }
-
-    wr->datatype = NNTI_dt_work_request;
+        rc = available_transports[reg_buf->transport_id].ops.nnti_counter_bind_fn(
+                reg_buf,
+                counter);
+    }
 
     return(rc);
 }
 
 
-NNTI_result_t NNTI_atomic_cswap (
-		const NNTI_transport_t *trans_hdl,
-		const NNTI_peer_t      *peer_hdl,
-		const uint64_t          target_atomic,
-		const uint64_t          result_atomic,
-		const int64_t           compare_operand,
-		const int64_t           swap_operand,
-		NNTI_work_request_t    *wr)
+/**
+ * @brief Read a counter without waiting.
+ *
+ */
+NNTI_result_t NNTI_counter_read (
+        const NNTI_counter_t *counter,
+        uint64_t             *value)
+{
+    *value=(uint64_t)nthread_counter_read(&NNTI_COUNTER(counter)->value);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Wait for a counter to reach a threshold.
+ *
+ * The transport makes progress until <tt>counter</tt> reaches
+ * <tt>threshold</tt> or the timeout expires.
+ *
+ */
+NNTI_result_t NNTI_counter_wait (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[trans_hdl->id].initialized==0) {
+    if (available_transports[counter->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[counter->transport_id].ops.nnti_counter_wait_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_atomic_cswap_fn(
-                trans_hdl,
-                peer_hdl,
-                target_atomic,
-                result_atomic,
-                compare_operand,
-                swap_operand,
-                wr);
+        rc = available_transports[counter->transport_id].ops.nnti_counter_wait_fn(
+                counter,
+                threshold,
+                timeout,
+                value);
     }
 
-    wr->datatype = NNTI_dt_work_request;
-
     return(rc);
 }
 
 
 /**
- * @brief Create a receive work request that can be used to wait for buffer
- * operations to complete.
+ * @brief Destroy a counter.
  *
  */
-NNTI_result_t NNTI_create_work_request (
-        NNTI_buffer_t        *reg_buf,
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_counter_destroy (
+        NNTI_counter_t *counter)
 {
-    NNTI_result_t rc=NNTI_OK;
+    nnti_counter *c=NNTI_COUNTER(counter);
 
-    if (available_transports[reg_buf->transport_id].initialized==0) {
-        rc=NNTI_ENOTINIT;
-    } else {
-        rc = available_transports[reg_buf->transport_id].ops.nnti_create_work_request_fn(
-                reg_buf,
-                wr);
+    if (c != NULL) {
+        nthread_counter_fini(&c->value);
+        free(c);
     }
+    counter->transport_private=0;
 
-    wr->datatype = NNTI_dt_work_request;
-
-    return(rc);
+    return(NNTI_OK);
 }
 
 
 /**
- * @brief Disassociates a receive work request from a previous receive
- * and prepares it for reuse.
+ * @brief Send a message to a peer without a work request.
+ *
+ * Completion is observed with NNTI_flush() or NNTI_flush_all().
  *
  */
-NNTI_result_t NNTI_clear_work_request (
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_send_implicit (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[wr->transport_id].initialized==0) {
+    if (available_transports[msg_hdl->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[msg_hdl->transport_id].ops.nnti_send_implicit_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[wr->transport_id].ops.nnti_clear_work_request_fn(
-                wr);
+        rc = available_transports[msg_hdl->transport_id].ops.nnti_send_implicit_fn(
+                peer_hdl,
+                msg_hdl,
+                dest_hdl);
     }
 
-    wr->datatype = NNTI_dt_work_request;
-
     return(rc);
 }
 
 
 /**
- * @brief Disassociates a receive work request from reg_buf.
+ * @brief Transfer data to a peer without a work request.
+ *
+ * Completion is observed with NNTI_flush() or NNTI_flush_all().
  *
  */
-NNTI_result_t NNTI_destroy_work_request (
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_put_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[wr->transport_id].initialized==0) {
+    if (available_transports[src_buffer_hdl->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[src_buffer_hdl->transport_id].ops.nnti_put_implicit_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[wr->transport_id].ops.nnti_destroy_work_request_fn(
-                wr);
+        rc = available_transports[src_buffer_hdl->transport_id].ops.nnti_put_implicit_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset);
     }
 
-    wr->datatype = NNTI_dt_work_request;
-
     return(rc);
 }
 
 
 /**
- * @brief Attempts to cancel an NNTI opertion.
+ * @brief Transfer data from a peer without a work request.
+ *
+ * Completion is observed with NNTI_flush() or NNTI_flush_all().
  *
  */
-NNTI_result_t NNTI_cancel (
-        NNTI_work_request_t *wr)
+NNTI_result_t NNTI_get_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
 {
     NNTI_result_t rc=NNTI_OK;
 
-    if (available_transports[wr->transport_id].initialized==0) {
+    if (available_transports[dest_buffer_hdl->transport_id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[dest_buffer_hdl->transport_id].ops.nnti_get_implicit_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[wr->transport_id].ops.nnti_cancel_fn(wr);
+        rc = available_transports[dest_buffer_hdl->transport_id].ops.nnti_get_implicit_fn(
+                src_buffer_hdl,
+                src_offset,
+                src_length,
+                dest_buffer_hdl,
+                dest_offset);
     }
 
-    wr->datatype = NNTI_dt_work_request;
-
     return(rc);
 }
 
 
 /**
- * @brief Attempts to cancel a list of NNTI opertions.
+ * @brief Wait for the implicit operations to a peer to complete.
  *
  */
-NNTI_result_t NNTI_cancelall (
-        NNTI_work_request_t **wr_list,
-        const uint32_t        wr_count)
+NNTI_result_t NNTI_flush (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout)
 {
     NNTI_result_t rc=NNTI_OK;
-    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
-    uint32_t i=0;
-
-    for (i=0;i<wr_count;i++) {
-        if (wr_list[i]) {
-            id=wr_list[i]->transport_id;
-        }
-    }
 
-    if (id == NNTI_TRANSPORT_NULL) {
-        rc=NNTI_EINVAL;
+    if (available_transports[peer_hdl->peer.transport_id].initialized==0) {
+        rc=NNTI_ENOTINIT;
+    } else if (available_transports[peer_hdl->peer.transport_id].ops.nnti_flush_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        if (available_transports[id].initialized==0) {
-            rc=NNTI_ENOTINIT;
-        } else {
-            rc = available_transports[id].ops.nnti_cancelall_fn(
-                    wr_list,
-                    wr_count);
-        }
-    }
-
-    for (i=0;i<wr_count;i++) {
-        if (wr_list[i]) {
-            wr_list[i]->datatype = NNTI_dt_work_request;
-        }
+        rc = available_transports[peer_hdl->peer.transport_id].ops.nnti_flush_fn(
+                peer_hdl,
+                timeout);
     }
 
     return(rc);
@@ -1175,19 +4118,23 @@ NNTI_result_t NNTI_cancelall (
 
 
 /**
- * @brief Interrupts NNTI_wait*()
+ * @brief Wait for the implicit operations to every peer to complete.
  *
  */
-NNTI_result_t NNTI_interrupt (
-        const NNTI_transport_t *trans_hdl)
+NNTI_result_t NNTI_flush_all (
+        const NNTI_transport_t *trans_hdl,
+        const int               timeout)
 {
     NNTI_result_t rc=NNTI_OK;
 
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
+    } else if (available_transports[trans_hdl->id].ops.nnti_flush_fn==NULL) {
+        rc=NNTI_ENOTSUP;
     } else {
-        rc = available_transports[trans_hdl->id].ops.nnti_interrupt_fn(
-                trans_hdl);
+        rc = available_transports[trans_hdl->id].ops.nnti_flush_fn(
+                NULL,
+                timeout);
     }
 
     return(rc);
@@ -1195,137 +4142,166 @@ NNTI_result_t NNTI_interrupt (
 
 
 /**
- * @brief Wait for <tt>remote_op</tt> on <tt>reg_buf</tt> to complete.
- *
- * Wait for <tt>remote_op</tt> on <tt>reg_buf</tt> to complete or timeout
- * waiting.  This is typically used to wait for a result or a bulk data
- * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
- * means wait forever.  A timeout of <tt>0</tt> means do not wait.
+ * @brief Register the handler for an active message.
  *
  */
-NNTI_result_t NNTI_wait (
-        NNTI_work_request_t *wr,
-        const int            timeout,
-        NNTI_status_t       *status)
+NNTI_result_t NNTI_am_register (
+        const NNTI_transport_t *trans_hdl,
+        const uint32_t          id,
+        NNTI_am_handler_fn_t    handler,
+        void                   *context)
 {
-    NNTI_result_t rc=NNTI_OK;
+    nnti_am_table *t=&am_tables[trans_hdl->id];
 
-    if (available_transports[wr->transport_id].initialized==0) {
-        rc=NNTI_ENOTINIT;
-    } else {
-        rc = available_transports[wr->transport_id].ops.nnti_wait_fn(
-                wr,
-                timeout,
-                status);
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+    if (id >= NNTI_AM_MAX_HANDLERS) {
+        return(NNTI_EINVAL);
     }
 
-    status->datatype = NNTI_dt_status;
+    nthread_lock(&t->lock);
+    if ((t->handlers[id].handler == NULL) && (handler != NULL)) {
+        t->handler_count++;
+    } else if ((t->handlers[id].handler != NULL) && (handler == NULL)) {
+        t->handler_count--;
+    }
+    t->trans_hdl           =trans_hdl;
+    t->handlers[id].handler=handler;
+    t->handlers[id].context=context;
+    nthread_unlock(&t->lock);
 
-    return(rc);
+    return(NNTI_OK);
 }
 
 
 /**
- * @brief Wait for <tt>remote_op</tt> on any buffer in <tt>buf_list</tt> to complete.
- *
- * Wait for <tt>remote_op</tt> on any buffer in <tt>buf_list</tt> to complete or timeout
- * waiting.  This is typically used to wait for a result or a bulk data
- * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
- * means wait forever.  A timeout of <tt>0</tt> means do not wait.
+ * @brief Send an active message to a peer.
  *
- * Caveats:
- *   1) All buffers in buf_list must be registered with the same transport.
- *   2) You can't wait on the receive queue and RDMA buffers in the same call.  Will probably be fixed in the future.
+ * Fills in the header at the start of <tt>msg_hdl</tt> and sends the
+ * header and payload to the peer's receive queue.
  *
  */
-NNTI_result_t NNTI_waitany (
-        NNTI_work_request_t **wr_list,
-        const uint32_t        wr_count,
-        const int             timeout,
-        uint32_t             *which,
-        NNTI_status_t        *status)
+NNTI_result_t NNTI_am_send (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const uint32_t       id,
+        const uint32_t       length,
+        NNTI_work_request_t *wr)
 {
-    NNTI_result_t rc=NNTI_OK;
-    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
-    uint32_t i=0;
+    nnti_raw_table *t=&raw_tables[msg_hdl->transport_id];
+    nnti_raw_slot  *slot=NULL;
+    nnti_am_header *hdr=NULL;
+    uint64_t        msg_len=(uint64_t)length + NNTI_AM_HEADER_SIZE;
+    NNTI_result_t   rc=NNTI_OK;
 
-    for (i=0;i<wr_count;i++) {
-        if (wr_list[i]) {
-            id=wr_list[i]->transport_id;
-        }
+    if (available_transports[msg_hdl->transport_id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+    if (id >= NNTI_AM_MAX_HANDLERS) {
+        return(NNTI_EINVAL);
+    }
+    if ((msg_len > msg_hdl->payload_size) || (msg_len > NNTI_REQUEST_BUFFER_SIZE)) {
+        return(NNTI_EMSGSIZE);
     }
 
-    if (id == NNTI_TRANSPORT_NULL) {
-        rc=NNTI_EINVAL;
-    } else {
-        if (available_transports[id].initialized==0) {
-            rc=NNTI_ENOTINIT;
-        } else {
-            rc = available_transports[id].ops.nnti_waitany_fn(
-                    wr_list,
-                    wr_count,
-                    timeout,
-                    which,
-                    status);
-        }
+    hdr=(nnti_am_header *)NNTI_BUFFER_C_POINTER(msg_hdl);
+    hdr->magic =NNTI_AM_MAGIC;
+    hdr->id    =id;
+    hdr->length=length;
+
+    if (msg_len == msg_hdl->payload_size) {
+        return(NNTI_send(peer_hdl, msg_hdl, NULL, wr));
     }
 
-    status->datatype = NNTI_dt_status;
+    /* only the message goes on the wire.  a raw slot holds the trimmed handle until the send completes. */
+    slot=raw_take(t, FALSE);
+    if (slot == NULL) {
+        return(NNTI_EAGAIN);
+    }
+    slot->view=*msg_hdl;
+    slot->view.payload_size=msg_len;
+    slot->user_wr=wr;
+
+    rc=NNTI_send(peer_hdl, &slot->view, NULL, wr);
+    if (rc != NNTI_OK) {
+        raw_release(t, slot);
+    }
 
     return(rc);
 }
 
 
 /**
- * @brief Wait for <tt>remote_op</tt> on all buffers in <tt>buf_list</tt> to complete.
- *
- * Wait for <tt>remote_op</tt> on all buffers in <tt>buf_list</tt> to complete or timeout
- * waiting.  This is typically used to wait for a result or a bulk data
- * transfer.  The timeout is specified in milliseconds.  A timeout of <tt>-1</tt>
- * means wait forever.  A timeout of <tt>0</tt> means do not wait.
- *
- * Caveats:
- *   1) All buffers in buf_list must be registered with the same transport.
- *   2) You can't wait on the receive queue and RDMA buffers in the same call.  Will probably be fixed in the future.
+ * @brief Run active message handlers on a pool of threads.
  *
  */
-NNTI_result_t NNTI_waitall (
-        NNTI_work_request_t **wr_list,
-        const uint32_t        wr_count,
-        const int             timeout,
-        NNTI_status_t       **status)
+NNTI_result_t NNTI_am_start_threads (
+        NNTI_buffer_t  *reg_buf,
+        const uint32_t  thread_count)
 {
-    NNTI_result_t rc=NNTI_OK;
-    NNTI_transport_id_t id=NNTI_TRANSPORT_NULL;
-    uint32_t i=0;
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    nnti_am_table *t=&am_tables[reg_buf->transport_id];
+    uint32_t       i=0;
 
-    for (i=0;i<wr_count;i++) {
-        if (wr_list[i]) {
-            id=wr_list[i]->transport_id;
-        }
+    if (available_transports[reg_buf->transport_id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+    if (available_transports[reg_buf->transport_id].ops.nnti_dequeue_requests_fn==NULL) {
+        return(NNTI_ENOTSUP);
+    }
+    if ((thread_count == 0) ||
+        ((reg_buf->ops != NNTI_BOP_RECV_QUEUE) && (reg_buf->ops != NNTI_BOP_RECV_RING))) {
+        return(NNTI_EINVAL);
     }
 
-    if (id == NNTI_TRANSPORT_NULL) {
-        rc=NNTI_EINVAL;
-    } else {
-        if (available_transports[id].initialized==0) {
-            rc=NNTI_ENOTINIT;
-        } else {
-            rc = available_transports[id].ops.nnti_waitall_fn(
-                    wr_list,
-                    wr_count,
-                    timeout,
-                    status);
+    nthread_lock(&t->lock);
+    if (t->thread_count > 0) {
+        nthread_unlock(&t->lock);
+        return(NNTI_EINVAL);
+    }
+    t->threads=(pthread_t *)calloc(thread_count, sizeof(pthread_t));
+    if (t->threads == NULL) {
+        nthread_unlock(&t->lock);
+        return(NNTI_ENOMEM);
+    }
+    t->thread_queue=reg_buf;
+    t->thread_stop =FALSE;
+    for (i=0;i<thread_count;i++) {
+        if (pthread_create(&t->threads[i], NULL, am_thread, t) != 0) {
+            log_error(nnti_debug_level, "failed to start active message handler thread %u", i);
+            break;
         }
     }
+    t->thread_count=i;
+    nthread_unlock(&t->lock);
 
-    for (i=0;i<wr_count;i++) {
-        if (status[i]) {
-            status[i]->datatype = NNTI_dt_status;
-        }
+    if (i < thread_count) {
+        am_stop_threads(t);
+        return(NNTI_EIO);
     }
 
-    return(rc);
+    return(NNTI_OK);
+#else
+    return(NNTI_ENOTSUP);
+#endif
+}
+
+
+/**
+ * @brief Stop the handler threads started by NNTI_am_start_threads().
+ *
+ */
+NNTI_result_t NNTI_am_stop_threads (
+        const NNTI_transport_t *trans_hdl)
+{
+    if (available_transports[trans_hdl->id].initialized==0) {
+        return(NNTI_ENOTINIT);
+    }
+
+    am_stop_threads(&am_tables[trans_hdl->id]);
+
+    return(NNTI_OK);
 }
 
 
@@ -1344,6 +4320,64 @@ NNTI_result_t NNTI_fini (
     if (available_transports[trans_hdl->id].initialized==0) {
         rc=NNTI_ENOTINIT;
     } else {
+        nnti_am_table *t=&am_tables[trans_hdl->id];
+
+        nnti_rv_table  *rv=&rv_tables[trans_hdl->id];
+        nnti_raw_table *raw=&raw_tables[trans_hdl->id];
+        nnti_co_table  *co=&co_tables[trans_hdl->id];
+        uint32_t        i=0;
+
+        am_stop_threads(t);
+        nthread_lock(&t->lock);
+        memset(t->handlers, 0, sizeof(t->handlers));
+        t->handler_count=0;
+        t->trans_hdl    =NULL;
+        nthread_unlock(&t->lock);
+
+        for (i=0;i<NNTI_RENDEZVOUS_MAX;i++) {
+            if (rv->slots[i].state != NNTI_RV_FREE) {
+                rv_release(rv, &rv->slots[i]);
+            }
+            if (rv->slots[i].ctrl_allocated) {
+                NNTI_free(&rv->slots[i].ctrl);
+            }
+            if (rv->slots[i].reply_allocated) {
+                NNTI_free(&rv->slots[i].reply);
+            }
+        }
+        memset(rv->slots, 0, sizeof(rv->slots));
+        rv->busy     =0;
+        rv->trans_hdl=NULL;
+
+        for (i=0;i<NNTI_RAW_MAX;i++) {
+            if (raw->slots[i].bounce_allocated) {
+                NNTI_free(&raw->slots[i].bounce);
+            }
+        }
+        for (i=0;i<NNTI_RAW_CACHE_SIZE;i++) {
+            if (raw->cache[i].valid) {
+                NNTI_unregister_memory(&raw->cache[i].buf);
+            }
+        }
+        memset(raw->slots, 0, sizeof(raw->slots));
+        memset(raw->cache, 0, sizeof(raw->cache));
+        raw->busy     =0;
+        raw->trans_hdl=NULL;
+
+        for (i=0;i<NNTI_COALESCE_BATCHES;i++) {
+            if (co->batches[i].send_allocated) {
+                NNTI_free(&co->batches[i].send_buf);
+            }
+            if (co->batches[i].put_allocated) {
+                NNTI_free(&co->batches[i].put_buf);
+            }
+        }
+        memset(co->batches, 0, sizeof(co->batches));
+        memset(co->ops, 0, sizeof(co->ops));
+        co->open     =0;
+        co->busy     =0;
+        co->trans_hdl=NULL;
+
         rc = available_transports[trans_hdl->id].ops.nnti_fini_fn(
                 trans_hdl);
         memset(&available_transports[trans_hdl->id], 0, sizeof(NNTI_internal_transport_t));
@@ -0,0 +1,239 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+
+
+#include "Trios_config.h"
+
+#include "Trios_logger.h"
+#include "nnti_credits.h"
+#include "nnti_internal.h"
+
+
+void nnti_credits_init(
+        nnti_credit_table_t *table,
+        uint32_t             limit)
+{
+    nthread_lock_init(&table->mutex);
+    table->peers.clear();
+    table->limit  =limit;
+    table->limited=false;
+
+    log_debug(nnti_debug_level, "request credits: limit=%u", table->limit);
+}
+
+int nnti_credits_enabled(
+        nnti_credit_table_t *table)
+{
+    return((table->limit > 0) || (table->limited));
+}
+
+/*
+ * The number of credits to offer a connecting peer for a request queue
+ * of <tt>queue_slots</tt> slots.  0 leaves the peer unlimited.
+ */
+uint32_t nnti_credits_offer(
+        nnti_credit_table_t *table,
+        uint32_t             queue_slots)
+{
+    if (queue_slots < table->limit) {
+        return(queue_slots);
+    }
+    return(table->limit);
+}
+
+/*
+ * Record the credits exchanged with <tt>peer_key</tt> at connect.
+ * <tt>offered</tt> is what this process offered the peer and
+ * <tt>granted</tt> is what the peer offered this process.  A grant of 0
+ * means the peer doesn't limit this process.  Reconnecting doesn't
+ * refill the credits.
+ */
+void nnti_credits_connect(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key,
+        uint32_t             offered,
+        uint32_t             granted)
+{
+    nthread_lock(&table->mutex);
+    nnti_credit_peer_t &p=table->peers[peer_key];
+    p.offered=offered;
+    if ((granted > 0) && (!p.granted)) {
+        p.granted  =true;
+        p.available=granted;
+        table->limited=true;
+    }
+    log_debug(nnti_debug_level, "peer %llu: offered %u credits ; granted %u credits",
+            (unsigned long long)peer_key, offered, granted);
+    nthread_unlock(&table->mutex);
+}
+
+/*
+ * Spend one credit on a request to <tt>peer_key</tt>.  Returns 1 if the
+ * request may be sent.  Peers that didn't grant credits are not limited.
+ */
+int nnti_credits_take(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key)
+{
+    int taken=1;
+
+    if (!table->limited) {
+        return(1);
+    }
+
+    nthread_lock(&table->mutex);
+    credit_peer_map_iter_t iter=table->peers.find(peer_key);
+    if ((iter != table->peers.end()) && (iter->second.granted)) {
+        if (iter->second.available > 0) {
+            iter->second.available--;
+        } else {
+            taken=0;
+        }
+    }
+    nthread_unlock(&table->mutex);
+
+    return(taken);
+}
+
+/*
+ * <tt>peer_key</tt> returned <tt>credits</tt> for requests it consumed.
+ */
+void nnti_credits_add(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key,
+        uint32_t             credits)
+{
+    if ((!table->limited) || (credits == 0)) {
+        return;
+    }
+
+    nthread_lock(&table->mutex);
+    credit_peer_map_iter_t iter=table->peers.find(peer_key);
+    if ((iter != table->peers.end()) && (iter->second.granted)) {
+        iter->second.available += credits;
+        log_debug(nnti_debug_level, "peer %llu returned %u credits (available=%lld)",
+                (unsigned long long)peer_key, credits, (long long)iter->second.available);
+    }
+    nthread_unlock(&table->mutex);
+}
+
+int64_t nnti_credits_available(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key)
+{
+    int64_t available=-1;
+
+    nthread_lock(&table->mutex);
+    credit_peer_map_iter_t iter=table->peers.find(peer_key);
+    if ((iter != table->peers.end()) && (iter->second.granted)) {
+        available=iter->second.available;
+    }
+    nthread_unlock(&table->mutex);
+
+    return(available);
+}
+
+/*
+ * Record that this process consumed <tt>credits</tt> requests from
+ * <tt>peer_key</tt>.  Once half of the offer is owed, the owed credits
+ * are collected and returned so the transport can send them back right
+ * away.  Otherwise returns 0 and the credits wait for a message to ride
+ * along with.
+ */
+uint32_t nnti_credits_owe(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key,
+        uint32_t             credits)
+{
+    uint32_t owed=0;
+
+    if (table->limit == 0) {
+        return(0);
+    }
+
+    nthread_lock(&table->mutex);
+    credit_peer_map_iter_t iter=table->peers.find(peer_key);
+    if ((iter != table->peers.end()) && (iter->second.offered > 0)) {
+        iter->second.owed += credits;
+        /* return credits once half the offer is owed so the peer never stalls on a quiet server */
+        if (iter->second.owed >= (iter->second.offered+1)/2) {
+            owed=iter->second.owed;
+            iter->second.owed=0;
+        }
+    }
+    nthread_unlock(&table->mutex);
+
+    return(owed);
+}
+
+/*
+ * Take every credit owed to <tt>peer_key</tt> so they can be sent back.
+ */
+uint32_t nnti_credits_collect(
+        nnti_credit_table_t *table,
+        uint64_t             peer_key)
+{
+    uint32_t owed=0;
+
+    if (table->limit == 0) {
+        return(0);
+    }
+
+    nthread_lock(&table->mutex);
+    credit_peer_map_iter_t iter=table->peers.find(peer_key);
+    if (iter != table->peers.end()) {
+        owed=iter->second.owed;
+        iter->second.owed=0;
+    }
+    nthread_unlock(&table->mutex);
+
+    return(owed);
+}
+
+void nnti_credits_fini(
+        nnti_credit_table_t *table)
+{
+    table->peers.clear();
+    table->limited=false;
+    nthread_lock_fini(&table->mutex);
+}
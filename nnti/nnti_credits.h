@@ -0,0 +1,142 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*-------------------------------------------------------------------------*/
+/**  @file nnti_credits.h
+ *
+ *   @brief Per-peer credit accounting for request queue flow control.
+ *
+ *   When a connection is set up, each side offers the other credits for
+ *   its request queue (one per queue slot, capped by the configured
+ *   limit) and learns how many credits the other side offered in return.
+ *   A process spends one credit for each request it sends to the peer's
+ *   request queue and stops sending when it runs out.  It owes a credit
+ *   back for each request it consumes from the peer.  Owed credits ride
+ *   along with the next message sent to that peer or, once half of the
+ *   offer is owed, in a message of their own.
+ *
+ *   The table doesn't know how offers and credits move across the
+ *   network.  That is up to each transport.
+ *
+ */
+
+#ifndef _NNTI_CREDITS_H_
+#define _NNTI_CREDITS_H_
+
+
+#include "Trios_config.h"
+
+#include "Trios_threads.h"
+
+#include <map>
+
+typedef struct nnti_credit_peer {
+    /* the peer granted credits at connect, so requests to it are limited by available */
+    bool     granted;
+    /* credits this process may spend on requests to the peer */
+    int64_t  available;
+    /* credits this process offered the peer at connect.  0 if the peer isn't limited. */
+    uint32_t offered;
+    /* credits this process owes the peer for consumed requests */
+    int64_t  owed;
+} nnti_credit_peer_t;
+
+typedef std::map<uint64_t, nnti_credit_peer_t>           credit_peer_map_t;
+typedef std::map<uint64_t, nnti_credit_peer_t>::iterator credit_peer_map_iter_t;
+
+typedef struct nnti_credit_table {
+    nthread_lock_t    mutex;
+    credit_peer_map_t peers;
+    /* the most credits offered to a peer.  0 offers none, which leaves peers unlimited. */
+    uint32_t          limit;
+    /* some peer granted this process credits */
+    bool              limited;
+} nnti_credit_table_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+    extern void nnti_credits_init(
+            nnti_credit_table_t *table,
+            uint32_t             limit);
+    extern int nnti_credits_enabled(
+            nnti_credit_table_t *table);
+    extern uint32_t nnti_credits_offer(
+            nnti_credit_table_t *table,
+            uint32_t             queue_slots);
+    extern void nnti_credits_connect(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key,
+            uint32_t             offered,
+            uint32_t             granted);
+    extern int nnti_credits_take(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key);
+    extern void nnti_credits_add(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key,
+            uint32_t             credits);
+    extern int64_t nnti_credits_available(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key);
+    extern uint32_t nnti_credits_owe(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key,
+            uint32_t             credits);
+    extern uint32_t nnti_credits_collect(
+            nnti_credit_table_t *table,
+            uint64_t             peer_key);
+    extern void nnti_credits_fini(
+            nnti_credit_table_t *table);
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -305,6 +305,7 @@ typedef struct {
 
 // forward declaration
 struct nnti_gni_work_request_t;
+struct nnti_gni_wr_pool_t;
 
 typedef struct {
 	nnti_gni_work_request_t *gni_wr;
@@ -335,6 +336,9 @@ typedef struct nnti_gni_work_request_t {
     uint8_t                  last_op;
 
     NNTI_instance_id         peer_instance;
+
+    struct nnti_gni_wr_pool_t *pool;        /* owning pool or NULL if allocated on its own */
+    uint32_t                   pool_shard;  /* shard the request is returned to */
 } nnti_gni_work_request_t;
 
 typedef std::deque<nnti_gni_work_request_t *>           wr_queue_t;
@@ -451,6 +455,10 @@ static nthread_cond_t nnti_progress_cond;
 static void *aligned_malloc(
         size_t size);
 static NNTI_result_t setup_atomics(void);
+static gni_fma_cmd_type_t atomic_amo_cmd(
+        const NNTI_atomic_op_t op,
+        uint64_t              *first_operand,
+        uint64_t              *second_operand);
 static gni_mem_handle_t register_memory_segment(
         NNTI_buf_ops_t ops,
 		void *buf,
@@ -567,8 +575,8 @@ static void print_sgehash_map(void);
 static NNTI_result_t wr_pool_init(void);
 static nnti_gni_work_request_t *wr_pool_target_pop(void);
 static nnti_gni_work_request_t *wr_pool_initiator_pop(void);
-static void wr_pool_target_push(nnti_gni_work_request_t *wr);
-static void wr_pool_initiator_push(nnti_gni_work_request_t *wr);
+static void wr_pool_push(nnti_gni_work_request_t *wr);
+static void wr_pool_get_stats(struct nnti_gni_wr_pool_t *pool, nnti_wr_pool_stats *stats);
 static NNTI_result_t wr_pool_fini(void);
 
 static uint16_t get_dlvr_mode_from_env();
@@ -741,7 +749,6 @@ static nthread_lock_t nnti_sge_sgehash_lock;
 
 typedef std::deque<nnti_gni_work_request_t *>           wr_pool_t;
 typedef std::deque<nnti_gni_work_request_t *>::iterator wr_pool_iter_t;
-static nthread_lock_t nnti_wr_pool_lock;
 
 typedef std::map<NNTI_instance_id, wr_queue_t *>           wr_queue_map_t;
 typedef std::map<NNTI_instance_id, wr_queue_t *>::iterator wr_queue_map_iter_t;
@@ -750,8 +757,43 @@ typedef std::deque<nnti_gni_mbox_backlog_t *>           mbox_backlog_t;
 typedef std::deque<nnti_gni_mbox_backlog_t *>::iterator mbox_backlog_iter_t;
 static nthread_lock_t nnti_mbox_backlog_lock;
 
-static wr_pool_t target_wr_pool;
-static wr_pool_t initiator_wr_pool;
+/*
+ * Work request pools.  A thread pops from the shard its id hashes to and a
+ * request goes back to the shard it came from.  An empty shard steals half
+ * of a neighbor's free list, then grows by a chunk as large as the shard
+ * already is (at least WR_POOL_MIN_CHUNK).  Past wr_pool_max_size,
+ * requests are only allocated on their own if wr_pool_create_if_empty is
+ * set, and those are freed when they're pushed.
+ */
+#define WR_POOL_SHARDS    8
+#define WR_POOL_MIN_CHUNK 16
+
+typedef struct {
+    nthread_lock_t lock;
+    wr_pool_t      free_list;
+    uint32_t       owned;       /* requests homed on this shard, free or in use */
+    uint32_t       high_water;  /* most requests in use at once */
+    uint64_t       pops;
+    uint64_t       steals;
+} nnti_gni_wr_pool_shard_t;
+
+typedef std::deque<nnti_gni_work_request_t *> wr_chunk_list_t;
+
+typedef struct nnti_gni_wr_pool_t {
+    const char               *name;
+    uint8_t                   is_initiator;
+    gni_cq_handle_t           cq_hdl;       /* passed to wr_pool_register() */
+    nnti_gni_wr_pool_shard_t  shard[WR_POOL_SHARDS];
+    nthread_lock_t            chunk_lock;   /* protects everything below */
+    wr_chunk_list_t           chunks;
+    std::deque<uint32_t>      chunk_sizes;
+    uint32_t                  size;
+    uint64_t                  grows;
+    uint64_t                  overflows;
+} nnti_gni_wr_pool_t;
+
+static nnti_gni_wr_pool_t target_wr_pool;
+static nnti_gni_wr_pool_t initiator_wr_pool;
 
 static wr_queue_map_t wr_resend_map;
 static mbox_backlog_t mbox_backlog;
@@ -820,8 +862,6 @@ NNTI_result_t NNTI_gni_init (
         nthread_lock_init(&nnti_buf_bufhash_lock);
         nthread_lock_init(&nnti_sge_sgehash_lock);
 
-        nthread_lock_init(&nnti_wr_pool_lock);
-
         nthread_lock_init(&transport_global_data.atomics_lock);
 
         config_init(&config);
@@ -1453,6 +1493,11 @@ NNTI_result_t NNTI_gni_alloc (
     assert(ops>0);
     assert(reg_buf);
 
+    if (ops == NNTI_BOP_RECV_RING) {
+        log_error(nnti_debug_level, "the Gemini transport doesn't support NNTI_RECV_RING buffers");
+        return(NNTI_ENOTSUP);
+    }
+
     char *buf=(char *)aligned_malloc((element_size+transport_extra)*num_elements);
     assert(buf);
 
@@ -1522,6 +1567,12 @@ NNTI_result_t NNTI_gni_register_memory (
 {
     NNTI_result_t rc=NNTI_OK;
 
+    if (ops == NNTI_BOP_RECV_RING) {
+        /* receives land in fixed mailbox slots, so requests can't be packed */
+        log_error(nnti_debug_level, "the Gemini transport doesn't support NNTI_RECV_RING buffers");
+        return(NNTI_ENOTSUP);
+    }
+
     rc=register_memory(
     		trans_hdl,
             buffer,
@@ -1751,11 +1802,7 @@ nthread_lock(&nnti_mem_lock);
             log_debug(nnti_debug_level, "removing pending wr=%p", wr);
             gni_mem_hdl->wr_queue->pop_front();
             if (config.use_wr_pool) {
-                if (wr->is_initiator==TRUE) {
-                    wr_pool_initiator_push(wr);
-                } else {
-                    wr_pool_target_push(wr);
-                }
+                wr_pool_push(wr);
             } else {
                 log_debug(nnti_debug_level, "free(wr) (reg_buf=%p, wr=%p)", reg_buf, wr);
                 free(wr);
@@ -2709,9 +2756,12 @@ NNTI_result_t NNTI_gni_atomic_fop (
     gni_wr->sge_list[0].post_desc.remote_addr    =conn->atomics_addr+(target_atomic*sizeof(int64_t));
     gni_wr->sge_list[0].post_desc.remote_mem_hndl=conn->atomics_mem_hdl;
     gni_wr->sge_list[0].post_desc.length         =sizeof(int64_t);
-    gni_wr->sge_list[0].post_desc.amo_cmd        =GNI_FMA_ATOMIC_FADD;
     gni_wr->sge_list[0].post_desc.first_operand  =operand;
     gni_wr->sge_list[0].post_desc.second_operand =0;
+    gni_wr->sge_list[0].post_desc.amo_cmd        =atomic_amo_cmd(
+            op,
+            &gni_wr->sge_list[0].post_desc.first_operand,
+            &gni_wr->sge_list[0].post_desc.second_operand);
 
     gni_wr->sge_list[0].state=NNTI_GNI_SGE_STATE_STARTED;
     gni_wr->sge_list[0].gni_wr=gni_wr;
@@ -3286,7 +3336,7 @@ NNTI_result_t NNTI_gni_wait (
             del_sge_sgehash(&gni_wr->sge_list[0]);
 
             if (config.use_wr_pool) {
-                wr_pool_initiator_push(gni_wr);
+                wr_pool_push(gni_wr);
             } else {
                 log_debug(nnti_debug_level, "free(gni_wr) (wr=%p, gni_wr=%p)", wr, gni_wr);
                 free(gni_wr);
@@ -3336,7 +3386,7 @@ NNTI_result_t NNTI_gni_wait (
                     free(gni_wr->sge_list);
                 }
                 if (config.use_wr_pool) {
-                    wr_pool_initiator_push(gni_wr);
+                    wr_pool_push(gni_wr);
                 } else {
                     log_debug(nnti_debug_level, "free(gni_wr) (wr=%p, gni_wr=%p)", wr, gni_wr);
                     free(gni_wr);
@@ -3535,7 +3585,7 @@ NNTI_result_t NNTI_gni_waitany (
                 free(GNI_WORK_REQUEST(wr_list[*which])->sge_list);
             }
             if (config.use_wr_pool) {
-                wr_pool_initiator_push(GNI_WORK_REQUEST(wr_list[*which]));
+                wr_pool_push(GNI_WORK_REQUEST(wr_list[*which]));
             } else {
                 free(GNI_WORK_REQUEST(wr_list[*which]));
             }
@@ -3733,7 +3783,7 @@ NNTI_result_t NNTI_gni_waitall (
                     free(GNI_WORK_REQUEST(wr_list[i])->sge_list);
                 }
                 if (config.use_wr_pool) {
-                    wr_pool_initiator_push(GNI_WORK_REQUEST(wr_list[i]));
+                    wr_pool_push(GNI_WORK_REQUEST(wr_list[i]));
                 } else {
                     free(GNI_WORK_REQUEST(wr_list[i]));
                 }
@@ -3752,6 +3802,29 @@ cleanup:
     return(nnti_rc);
 }
 
+/**
+ * @brief Report the occupancy of the work request pools.
+ *
+ * Returns NNTI_ENOTSUP unless TRIOS_NNTI_USE_WR_POOL is set.
+ */
+NNTI_result_t NNTI_gni_get_wr_pool_stats (
+        nnti_wr_pool_stats *target_stats,
+        nnti_wr_pool_stats *initiator_stats)
+{
+    if (!gni_initialized || !config.use_wr_pool) {
+        return(NNTI_ENOTSUP);
+    }
+
+    if (target_stats != NULL) {
+        wr_pool_get_stats(&target_wr_pool, target_stats);
+    }
+    if (initiator_stats != NULL) {
+        wr_pool_get_stats(&initiator_wr_pool, initiator_stats);
+    }
+
+    return(NNTI_OK);
+}
+
 /**
  * @brief Disable this transport.
  *
@@ -3799,7 +3872,6 @@ NNTI_result_t NNTI_gni_fini (
     nthread_lock_fini(&nnti_conn_instance_lock);
     nthread_lock_fini(&nnti_buf_bufhash_lock);
     nthread_lock_fini(&nnti_sge_sgehash_lock);
-    nthread_lock_fini(&nnti_wr_pool_lock);
 
     nthread_lock_fini(&transport_global_data.atomics_lock);
 
@@ -3849,6 +3921,37 @@ static NNTI_result_t setup_atomics(void)
     return(rc);
 }
 
+/*
+ * The AMO that carries out <op>.  The operands arrive as (operand, 0).
+ * A swap is AND-XOR with an AND mask of 0.  MIN and MAX are Aries AMOs.
+ */
+static gni_fma_cmd_type_t atomic_amo_cmd(
+        const NNTI_atomic_op_t op,
+        uint64_t              *first_operand,
+        uint64_t              *second_operand)
+{
+    switch (op) {
+        case NNTI_ATOMIC_FADD:  return(GNI_FMA_ATOMIC_FADD);
+        case NNTI_ATOMIC_FAND:  return(GNI_FMA_ATOMIC_FAND);
+        case NNTI_ATOMIC_FOR:   return(GNI_FMA_ATOMIC_FOR);
+        case NNTI_ATOMIC_FXOR:  return(GNI_FMA_ATOMIC_FXOR);
+        case NNTI_ATOMIC_FMIN:  return(GNI_FMA_ATOMIC2_FIMIN);
+        case NNTI_ATOMIC_FMAX:  return(GNI_FMA_ATOMIC2_FIMAX);
+        case NNTI_ATOMIC_ADD:   return(GNI_FMA_ATOMIC_ADD);
+        case NNTI_ATOMIC_AND:   return(GNI_FMA_ATOMIC_AND);
+        case NNTI_ATOMIC_OR:    return(GNI_FMA_ATOMIC_OR);
+        case NNTI_ATOMIC_XOR:   return(GNI_FMA_ATOMIC_XOR);
+        case NNTI_ATOMIC_MIN:   return(GNI_FMA_ATOMIC2_IMIN);
+        case NNTI_ATOMIC_MAX:   return(GNI_FMA_ATOMIC2_IMAX);
+        case NNTI_ATOMIC_FSWAP:
+            *second_operand=*first_operand;
+            *first_operand =0;
+            return(GNI_FMA_ATOMIC_FAX);
+    }
+
+    return(GNI_FMA_ATOMIC_FADD);
+}
+
 static void *aligned_malloc(
         size_t size)
 {
@@ -4656,6 +4759,7 @@ static void create_status(
     nnti_gni_connection_t    *conn       =NULL;
 
     status->op = wr->ops;
+    status->imm = 0;
     if (is_wr_complete(gni_wr)) {
         status->result = wr->result;
     } else {
@@ -5159,145 +5263,366 @@ static NNTI_result_t wr_pool_deregister(
 
     return(NNTI_OK);
 }
-static NNTI_result_t wr_pool_init(void)
+/*
+ * Pick the home shard of the calling thread.  Without pthreads all
+ * callers share shard 0.
+ */
+static uint32_t wr_pool_home_shard(void)
 {
-    NNTI_result_t  rc=NNTI_OK;
-    uint32_t i;
-    nnti_gni_work_request_t *wr=NULL;
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    uint64_t h=(uint64_t)pthread_self();
+    h ^= (h >> 33);
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= (h >> 33);
+    return((uint32_t)(h % WR_POOL_SHARDS));
+#else
+    return(0);
+#endif
+}
 
-    log_debug(nnti_debug_level, "enter");
+static void wr_pool_setup(
+        nnti_gni_wr_pool_t *pool,
+        const char         *name,
+        uint8_t             is_initiator,
+        gni_cq_handle_t     cq_hdl)
+{
+    pool->name        =name;
+    pool->is_initiator=is_initiator;
+    pool->cq_hdl      =cq_hdl;
+    pool->size        =0;
+    pool->grows       =0;
+    pool->overflows   =0;
+    pool->chunks.clear();
+    pool->chunk_sizes.clear();
+    nthread_lock_init(&pool->chunk_lock);
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        nthread_lock_init(&pool->shard[i].lock);
+        pool->shard[i].free_list.clear();
+        pool->shard[i].owned     =0;
+        pool->shard[i].high_water=0;
+        pool->shard[i].pops      =0;
+        pool->shard[i].steals    =0;
+    }
+}
 
-    for (i=0;i<config.wr_pool_initial_size;i++) {
-        wr=(nnti_gni_work_request_t *)malloc(sizeof(nnti_gni_work_request_t));
-        memset(wr, 0, sizeof(nnti_gni_work_request_t));
-        assert(wr);
-        nthread_lock_init(&wr->lock);
-        rc=wr_pool_register(wr, transport_global_data.mem_cq_hdl);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to register target work request: rc=%d", rc);
-            goto cleanup;
-        }
-        wr->is_initiator=FALSE;
-        wr_pool_target_push(wr);
+/*
+ * Add up to <tt>count</tt> requests to shard <tt>home</tt> as one chunk.
+ * Returns the number added, which is 0 once the pool has reached
+ * wr_pool_max_size.
+ */
+static uint32_t wr_pool_grow(
+        nnti_gni_wr_pool_t *pool,
+        uint32_t            home,
+        uint32_t            count)
+{
+    nnti_gni_work_request_t  *chunk=NULL;
+    nnti_gni_wr_pool_shard_t *shard=&pool->shard[home];
+    uint32_t                  i;
 
-        wr=(nnti_gni_work_request_t *)malloc(sizeof(nnti_gni_work_request_t));
-        memset(wr, 0, sizeof(nnti_gni_work_request_t));
-        assert(wr);
-        nthread_lock_init(&wr->lock);
-        rc=wr_pool_register(wr, NULL);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to register initiator work request: rc=%d", rc);
-            goto cleanup;
+    log_debug(nnti_debug_level, "enter (pool=%s, shard=%u, count=%u)", pool->name, home, count);
+
+    // reserve the requests first so concurrent growers can't overshoot max_size
+    if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    if (pool->size + count > config.wr_pool_max_size) {
+        count=(pool->size < config.wr_pool_max_size) ? config.wr_pool_max_size - pool->size : 0;
+    }
+    pool->size += count;
+    nthread_unlock(&pool->chunk_lock);
+
+    if (count == 0) {
+        log_debug(nnti_debug_level, "exit (pool=%s is at its max size)", pool->name);
+        return(0);
+    }
+
+    chunk=(nnti_gni_work_request_t *)calloc(count, sizeof(nnti_gni_work_request_t));
+    if (chunk != NULL) {
+        for (i=0;i<count;i++) {
+            nnti_gni_work_request_t *wr=&chunk[i];
+            nthread_lock_init(&wr->lock);
+            if (wr_pool_register(wr, pool->cq_hdl) != NNTI_OK) {
+                log_error(nnti_debug_level, "failed to register %s work request", pool->name);
+                break;
+            }
+            wr->is_initiator=pool->is_initiator;
+            wr->pool        =pool;
+            wr->pool_shard  =home;
+        }
+        if (i < count) {
+            while (i > 0) {
+                wr_pool_deregister(&chunk[--i]);
+            }
+            free(chunk);
+            chunk=NULL;
         }
-        wr->is_initiator=TRUE;
-        wr_pool_initiator_push(wr);
     }
+    if (chunk == NULL) {
+        log_error(nnti_debug_level, "failed to grow the %s pool by %u requests", pool->name, count);
 
-cleanup:
-    log_debug(nnti_debug_level, "exit");
+        if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+        pool->size -= count;
+        nthread_unlock(&pool->chunk_lock);
 
-    return(rc);
+        return(0);
+    }
+
+    if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    pool->chunks.push_back(chunk);
+    pool->chunk_sizes.push_back(count);
+    pool->grows++;
+    nthread_unlock(&pool->chunk_lock);
+
+    if (nthread_lock(&shard->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    for (i=0;i<count;i++) {
+        shard->free_list.push_back(&chunk[i]);
+    }
+    shard->owned += count;
+    nthread_unlock(&shard->lock);
+
+    log_debug(nnti_debug_level, "exit (pool=%s, shard=%u, added=%u)", pool->name, home, count);
+
+    return(count);
 }
-static nnti_gni_work_request_t *wr_pool_target_pop(void)
+
+/*
+ * Move half of the first non-empty neighbor's free requests to shard
+ * <tt>home</tt>.  Only one shard lock is held at a time.
+ */
+static uint32_t wr_pool_steal(
+        nnti_gni_wr_pool_t *pool,
+        uint32_t            home)
 {
-    nnti_gni_work_request_t *wr=NULL;
+    wr_pool_t loot;
 
-    log_debug(nnti_debug_level, "enter");
+    for (uint32_t i=1;i<WR_POOL_SHARDS;i++) {
+        nnti_gni_wr_pool_shard_t *victim=&pool->shard[(home+i) % WR_POOL_SHARDS];
+
+        if (nthread_lock(&victim->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+        uint32_t take=(victim->free_list.size()+1)/2;
+        for (uint32_t j=0;j<take;j++) {
+            loot.push_back(victim->free_list.front());
+            victim->free_list.pop_front();
+        }
+        victim->owned -= take;
+        nthread_unlock(&victim->lock);
 
-    if (nthread_lock(&nnti_wr_pool_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
-    if (!target_wr_pool.empty()) {
-        wr=target_wr_pool.front();
-        target_wr_pool.pop_front();
+        if (!loot.empty()) {
+            break;
+        }
     }
-    nthread_unlock(&nnti_wr_pool_lock);
 
-    log_debug(nnti_debug_level, "exit");
+    if (!loot.empty()) {
+        nnti_gni_wr_pool_shard_t *shard=&pool->shard[home];
 
-    return(wr);
+        if (nthread_lock(&shard->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+        for (wr_pool_iter_t iter=loot.begin();iter!=loot.end();iter++) {
+            (*iter)->pool_shard=home;
+            shard->free_list.push_back(*iter);
+        }
+        shard->owned += loot.size();
+        shard->steals++;
+        nthread_unlock(&shard->lock);
+    }
+
+    return(loot.size());
 }
-static nnti_gni_work_request_t *wr_pool_initiator_pop(void)
+
+static nnti_gni_work_request_t *wr_pool_pop(
+        nnti_gni_wr_pool_t *pool)
 {
-    nnti_gni_work_request_t *wr=NULL;
+    nnti_gni_work_request_t  *wr=NULL;
+    uint32_t                  home=wr_pool_home_shard();
+    nnti_gni_wr_pool_shard_t *shard=&pool->shard[home];
+    uint32_t                  owned;
+
+    log_debug(nnti_debug_level, "enter (pool=%s, shard=%u)", pool->name, home);
+
+    while (1) {
+        if (nthread_lock(&shard->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+        if (!shard->free_list.empty()) {
+            wr=shard->free_list.front();
+            shard->free_list.pop_front();
+            shard->pops++;
+            uint32_t in_use=shard->owned - shard->free_list.size();
+            if (in_use > shard->high_water) {
+                shard->high_water=in_use;
+            }
+        }
+        owned=shard->owned;
+        nthread_unlock(&shard->lock);
 
-    log_debug(nnti_debug_level, "enter");
+        if (wr != NULL) {
+            break;
+        }
 
-    if (nthread_lock(&nnti_wr_pool_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
-    if (!initiator_wr_pool.empty()) {
-        wr=initiator_wr_pool.front();
-        initiator_wr_pool.pop_front();
+        if (wr_pool_steal(pool, home) > 0) {
+            continue;
+        }
+        // every request homed here is in use, so double the shard
+        if (wr_pool_grow(pool, home, (owned < WR_POOL_MIN_CHUNK) ? WR_POOL_MIN_CHUNK : owned) > 0) {
+            continue;
+        }
+
+        if (config.wr_pool_create_if_empty) {
+            // the pool is at its cap.  hand out a request that is freed when it's pushed.
+            if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+            pool->overflows++;
+            nthread_unlock(&pool->chunk_lock);
+
+            wr=(nnti_gni_work_request_t *)malloc(sizeof(nnti_gni_work_request_t));
+            if (wr != NULL) {
+                memset(wr, 0, sizeof(nnti_gni_work_request_t));
+                nthread_lock_init(&wr->lock);
+                wr->is_initiator=pool->is_initiator;
+            }
+        } else {
+            log_error(nnti_debug_level, "the %s work request pool is exhausted (max size %u)", pool->name, config.wr_pool_max_size);
+        }
+        break;
     }
-    nthread_unlock(&nnti_wr_pool_lock);
 
-    log_debug(nnti_debug_level, "exit");
+    log_debug(nnti_debug_level, "exit (wr=%p)", wr);
 
     return(wr);
 }
-static void wr_pool_target_push(nnti_gni_work_request_t *wr)
+
+static NNTI_result_t wr_pool_init(void)
 {
+    NNTI_result_t  rc=NNTI_OK;
+
     log_debug(nnti_debug_level, "enter");
 
-    memset(&wr->wc, 0, sizeof(nnti_gni_work_completion_t));
-    wr->state  =NNTI_GNI_WR_STATE_RESET;
-    wr->last_op       =0;
+    wr_pool_setup(&target_wr_pool, "target", FALSE, transport_global_data.mem_cq_hdl);
+    wr_pool_setup(&initiator_wr_pool, "initiator", TRUE, NULL);
 
-    if (nthread_lock(&nnti_wr_pool_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
-    target_wr_pool.push_front(wr);
-    nthread_unlock(&nnti_wr_pool_lock);
+    if (config.wr_pool_initial_size > 0) {
+        uint32_t home=wr_pool_home_shard();
+        if ((wr_pool_grow(&target_wr_pool, home, config.wr_pool_initial_size) == 0) ||
+            (wr_pool_grow(&initiator_wr_pool, home, config.wr_pool_initial_size) == 0)) {
+            log_error(nnti_debug_level, "failed to allocate the initial work requests");
+            rc=NNTI_ENOMEM;
+        }
+        // the initial chunks aren't growth
+        target_wr_pool.grows=0;
+        initiator_wr_pool.grows=0;
+    }
 
     log_debug(nnti_debug_level, "exit");
 
-    return;
+    return(rc);
 }
-static void wr_pool_initiator_push(nnti_gni_work_request_t *wr)
+static nnti_gni_work_request_t *wr_pool_target_pop(void)
+{
+    return(wr_pool_pop(&target_wr_pool));
+}
+static nnti_gni_work_request_t *wr_pool_initiator_pop(void)
+{
+    return(wr_pool_pop(&initiator_wr_pool));
+}
+static void wr_pool_push(nnti_gni_work_request_t *wr)
 {
     log_debug(nnti_debug_level, "enter");
 
-    memset(&wr->wc, 0, sizeof(nnti_gni_work_completion_t));
+    if (wr->pool == NULL) {
+        // allocated outside of a pool chunk
+        log_debug(nnti_debug_level, "free(wr) (wr=%p)", wr);
+        free(wr);
+        return;
+    }
+
+    // wc is a pointer.  clear the completion it may point to, not the fields after it.
+    memset(&wr->rdma_wc, 0, sizeof(nnti_gni_work_completion_t));
+    wr->wc     =NULL;
     wr->state  =NNTI_GNI_WR_STATE_RESET;
     wr->last_op       =0;
 
-    if (nthread_lock(&nnti_wr_pool_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
-    initiator_wr_pool.push_front(wr);
-    nthread_unlock(&nnti_wr_pool_lock);
+    nnti_gni_wr_pool_shard_t *shard=&wr->pool->shard[wr->pool_shard];
+    if (nthread_lock(&shard->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    shard->free_list.push_front(wr);
+    nthread_unlock(&shard->lock);
 
     log_debug(nnti_debug_level, "exit");
 
     return;
 }
+
+static void wr_pool_get_stats(
+        nnti_gni_wr_pool_t *pool,
+        nnti_wr_pool_stats *stats)
+{
+    memset(stats, 0, sizeof(nnti_wr_pool_stats));
+
+    if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    stats->size     =pool->size;
+    stats->grows    =pool->grows;
+    stats->overflows=pool->overflows;
+    nthread_unlock(&pool->chunk_lock);
+
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        nnti_gni_wr_pool_shard_t *shard=&pool->shard[i];
+        if (nthread_lock(&shard->lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+        stats->free       += shard->free_list.size();
+        stats->high_water += shard->high_water;
+        stats->pops       += shard->pops;
+        stats->steals     += shard->steals;
+        nthread_unlock(&shard->lock);
+    }
+    stats->in_use=(stats->size > stats->free) ? stats->size - stats->free : 0;
+}
+
+static NNTI_result_t wr_pool_teardown(
+        nnti_gni_wr_pool_t *pool)
+{
+    NNTI_result_t      rc=NNTI_OK;
+    nnti_wr_pool_stats stats;
+
+    wr_pool_get_stats(pool, &stats);
+    log_debug(nnti_debug_level, "%s pool: size=%u in_use=%u high_water=%u pops=%llu steals=%llu grows=%llu overflows=%llu",
+            pool->name, stats.size, stats.in_use, stats.high_water,
+            stats.pops, stats.steals, stats.grows, stats.overflows);
+    if (stats.in_use > 0) {
+        log_warn(nnti_debug_level, "%u %s work requests are still in use", stats.in_use, pool->name);
+    }
+
+    if (nthread_lock(&pool->chunk_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
+    while (!pool->chunks.empty()) {
+        nnti_gni_work_request_t *chunk=pool->chunks.front();
+        uint32_t                 count=pool->chunk_sizes.front();
+        pool->chunks.pop_front();
+        pool->chunk_sizes.pop_front();
+        for (uint32_t i=0;i<count;i++) {
+            if (wr_pool_deregister(&chunk[i]) != NNTI_OK) {
+                log_error(nnti_debug_level, "failed to deregister %s work request", pool->name);
+                rc=NNTI_EIO;
+            }
+        }
+        free(chunk);
+    }
+    pool->size=0;
+    nthread_unlock(&pool->chunk_lock);
+
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        pool->shard[i].free_list.clear();
+        pool->shard[i].owned=0;
+        nthread_lock_fini(&pool->shard[i].lock);
+    }
+    nthread_lock_fini(&pool->chunk_lock);
+
+    return(rc);
+}
+
 static NNTI_result_t wr_pool_fini(void)
 {
     NNTI_result_t  rc=NNTI_OK;
-    nnti_gni_work_request_t *wr=NULL;
 
     log_debug(nnti_debug_level, "enter");
 
-    if (nthread_lock(&nnti_wr_pool_lock)) log_warn(nnti_debug_level, "failed to get thread lock");
-    while (!target_wr_pool.empty()) {
-        wr=target_wr_pool.front();
-        target_wr_pool.pop_front();
-        assert(wr);
-        rc=wr_pool_deregister(wr);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to deregister target work request: rc=%d", rc);
-            goto cleanup;
-        }
-        free(wr);
+    if (wr_pool_teardown(&target_wr_pool) != NNTI_OK) {
+        rc=NNTI_EIO;
     }
-    while (!initiator_wr_pool.empty()) {
-        wr=initiator_wr_pool.front();
-        initiator_wr_pool.pop_front();
-        assert(wr);
-        rc=wr_pool_deregister(wr);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to deregister initiator work request: rc=%d", rc);
-            goto cleanup;
-        }
-        free(wr);
+    if (wr_pool_teardown(&initiator_wr_pool) != NNTI_OK) {
+        rc=NNTI_EIO;
     }
 
-cleanup:
-    nthread_unlock(&nnti_wr_pool_lock);
-
     log_debug(nnti_debug_level, "exit");
 
     return(rc);
@@ -218,6 +218,10 @@ NNTI_result_t NNTI_gni_waitall (
         const int             timeout,
         NNTI_status_t       **status);
 
+NNTI_result_t NNTI_gni_get_wr_pool_stats (
+        nnti_wr_pool_stats *target_stats,
+        nnti_wr_pool_stats *initiator_stats);
+
 NNTI_result_t NNTI_gni_fini (
         const NNTI_transport_t *trans_hdl);
 
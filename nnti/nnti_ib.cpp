@@ -83,7 +83,9 @@
 #endif
 
 #include "nnti_ib.h"
+#include "nnti_ib_emu.h"
 #include "nnti_utils.h"
+#include "nnti_credits.h"
 
 
 
@@ -121,6 +123,30 @@ typedef struct {
 
     bool     drop_if_full_queue;
 
+    /* run against the in-process verbs emulator instead of an HCA */
+    bool     use_verbs_emulator;
+
+    /* sends at or below this size are posted with IBV_SEND_INLINE (capped by the HCA) */
+    uint32_t max_inline_data;
+    /* inline sends are unsignaled except for every Nth one on a QP */
+    uint32_t send_signal_interval;
+    /* sends to the same QP are held and posted together once this many are queued */
+    uint32_t send_chain_max;
+
+    /* the most request queue credits offered to each client.  0 disables flow control. */
+    uint32_t request_credits;
+
+    /* work requests each pool starts with, and the most it may grow to */
+    uint32_t wr_pool_initial_size;
+    uint32_t wr_pool_max_size;
+
+    /* put/get transfers larger than rdma_chunk_threshold bytes are split
+     * into rdma_chunk_size byte work requests with at most rdma_chunk_window
+     * of them in flight.  a threshold of 0 disables chunking. */
+    uint64_t rdma_chunk_threshold;
+    uint64_t rdma_chunk_size;
+    uint32_t rdma_chunk_window;
+
 } nnti_ib_config;
 
 
@@ -167,11 +193,44 @@ typedef enum {
 #define SRQ_DEPTH 20480
 #define CQ_DEPTH 20480
 
+/* upper bound on TRIOS_NNTI_IB_SEND_CHAIN */
+#define IB_SEND_CHAIN_MAX 32
+/* wr_id of an unsignaled send.  it only comes back in an error completion. */
+#define IB_UNSIGNALED_WR_ID 0xFFFFFFFFFFFFFFFFULL
+/* wr_id of the RDMA write that returns request credits (see return_request_credits()) */
+#define IB_CREDIT_WR_ID     0xFFFFFFFFFFFFFFFEULL
+
+/* a vectored put/get (see vector_rdma_wrs()) gathers at most this many SGEs into one work request */
+#define IB_VECTOR_MAX_SGE    32
+/* ...moves at most this many bytes with one SGE or work request */
+#define IB_VECTOR_MAX_LENGTH ((uint64_t)0x40000000)
+/* ...and keeps at most this many work requests on the send queue */
+#define IB_VECTOR_WINDOW     64
+
+struct ib_work_request;
+struct ib_wr_pool;
+struct ib_atomic_vector;
+
 typedef struct {
     struct ibv_qp           *qp;
     uint32_t                 qpn;
     uint32_t                 peer_qpn;
+
+    /* small send state.  protected by nnti_send_lock. */
+    uint32_t                 max_inline;        // inline limit the HCA granted for this QP
+    uint32_t                 unsignaled_count;  // sends posted since the last signaled send
+    struct ib_work_request  *send_chain[IB_SEND_CHAIN_MAX];
+    uint32_t                 send_chain_len;
 } conn_qp;
+/*
+ * Request credits returned over a connection.  Registered so the peer
+ * can write <tt>returned</tt> without a receive.
+ */
+typedef struct {
+    volatile uint64_t returned;  // credits the peer has returned so far.  written by the peer.
+    uint64_t          sent;      // credits returned to the peer so far.  the source of the peer's write.
+} ib_credit_record;
+
 typedef struct {
     NNTI_peer_t   peer;
     char         *peer_name;
@@ -186,18 +245,35 @@ typedef struct {
     uint32_t      atomics_rkey;
     uint64_t      atomics_addr;
 
+    /* request credits (see nnti_credits.h) */
+    ib_credit_record *credits;
+    struct ibv_mr    *credits_mr;
+    uint64_t          credits_seen;  // credits->returned already added to the table.  protected by nnti_send_lock.
+    uint32_t          peer_credits_rkey;
+    uint64_t          peer_credits_addr;
+
     ib_connection_state state;
 
     int8_t disconnect_requested;
+
+    /* implicit operations to this peer (see NNTI_ib_flush()).  protected by nnti_implicit_lock. */
+    uint64_t      implicit_issued;
+    uint64_t      implicit_retired;
+    NNTI_result_t implicit_result;   // the first failure since the last flush
+
+    /* an unsignaled send to this peer failed after it was reported complete.  protected by nnti_send_lock. */
+    NNTI_result_t send_result;
 } ib_connection;
 
 typedef struct {
     uint32_t op;
     uint64_t offset;
     uint64_t length;
+    uint64_t chunk_size;  /* >0 if this is a streaming put (see NNTI_ib_put_stream()) */
+    uint64_t imm;         /* the value of an NNTI_ib_put_notify() */
 } ib_rdma_ack;
 
-typedef struct {
+typedef struct ib_work_request {
     nthread_lock_t lock;
 
     NNTI_work_request_t *nnti_wr;
@@ -228,7 +304,9 @@ typedef struct {
     struct ibv_recv_wr ack_rq_wr;
     struct ibv_sge     ack_sge;
     struct ibv_mr     *ack_mr;
-    ib_rdma_ack        ack;
+    ib_rdma_ack       *ack;          /* slot in the ACK slab or &ack_private */
+    int32_t            ack_slot;     /* index into the ACK slab or -1 */
+    ib_rdma_ack        ack_private;  /* used when the ACK slab is exhausted */
 
     /* this is a copy of the last work completion that arrived for this buffer */
     struct ibv_wc    last_wc;
@@ -237,8 +315,70 @@ typedef struct {
     uint64_t      offset;
     uint64_t      length;
 
+    struct ib_wr_pool *pool;        /* owning pool or NULL if allocated on its own */
+    uint32_t           pool_shard;  /* shard the request is returned to */
+
+    /* a chunked put/get posts sq_wr_list a window at a time (see chunk_rdma_wrs()) */
+    uint32_t chunk_count;   /* 0 if the transfer isn't chunked */
+    uint32_t chunk_window;
+    uint32_t chunk_posted;
+
+    /* this target event is a chunk of a streaming put.  its SRQ receive was replaced when it landed. */
+    int8_t   stream_event;
+
+    /*
+     * an implicit operation has no caller-owned work request, so nnti_wr
+     * points at implicit_wr.  once <implicit> is set, whoever sees the
+     * request complete retires it (see implicit_retire()).
+     */
+    int8_t              implicit;
+    NNTI_work_request_t implicit_wr;
+
+    /*
+     * verbs only has fetch-add and compare-swap.  other atomics are a
+     * compare-swap loop (see atomic_retry()).  each attempt fetches into
+     * the caller's result or, for a non-fetching op, the scratch slot
+     * atomics[atomic_slot].
+     */
+    NNTI_atomic_op_t atomic_op;
+    int64_t          atomic_operand;
+    int64_t          atomic_expected;
+    uint32_t         atomic_slot;
+    int8_t           atomic_emulated;
+    int8_t           atomic_scratch;
+    /* the updates of a vectored atomic (see atomic_vector_post()) */
+    struct ib_atomic_vector *atomic_vector;
+
 } ib_work_request;
 
+/*
+ * verbs has no batched atomic, so a vectored atomic posts one work request
+ * per update.  they go out as chains of up to IB_VECTOR_WINDOW with only
+ * the last one signaled.  send completions arrive in order, so that
+ * completion means the whole window landed.  emulated updates whose
+ * compare-swap missed are posted again once every update has been tried.
+ */
+typedef struct ib_atomic_update {
+    NNTI_atomic_op_t op;
+    int64_t          operand;
+    int64_t          expected;
+    int8_t           emulated;
+    int8_t           done;
+} ib_atomic_update;
+
+typedef struct ib_atomic_vector {
+    ib_atomic_update   *updates;
+    struct ibv_send_wr *sq_wrs;
+    struct ibv_sge     *sges;
+    uint32_t            count;
+    uint32_t            remaining;     /* updates that haven't landed */
+    uint32_t            cursor;        /* next update to consider for a window */
+    uint32_t           *window;        /* updates in the window on the wire */
+    uint32_t            window_count;
+    uint32_t           *slots;         /* scratch slots of the non-fetching updates */
+    uint32_t            slot_count;
+} ib_atomic_vector;
+
 typedef std::deque<ib_work_request *>           wr_queue_t;
 typedef std::deque<ib_work_request *>::iterator wr_queue_iter_t;
 
@@ -249,6 +389,22 @@ typedef struct {
     wr_queue_t      wr_queue;
     nthread_lock_t  wr_queue_lock;
     uint32_t        ref_count;
+    ib_rdma_ack    *target_ack;  /* ACK record published to initiators (use_rdma_target_ack) */
+
+    /*
+     * a streaming put into this buffer.  chunks land in order, so the
+     * events are described by the next offset to deliver and two counters.
+     */
+    uint64_t        stream_offset;    /* offset of the next chunk to deliver */
+    uint64_t        stream_end;
+    uint64_t        stream_chunk;
+    uint32_t        stream_expected;  /* chunks that haven't landed yet */
+    uint32_t        stream_landed;    /* chunks that landed but haven't been delivered */
+
+    /* completed puts and gets are counted here instead of raising events (see NNTI_ib_counter_bind()) */
+    nnti_counter   *counter;
+    /* chunks of a counted streaming put that haven't landed yet, by the initiator's QP */
+    std::map<NNTI_qp_num, uint32_t> counter_streams;
 } ib_memory_handle;
 
 typedef struct {
@@ -274,10 +430,14 @@ typedef struct {
     struct ibv_comp_channel *req_comp_channel;
     struct ibv_cq           *req_cq;
     struct ibv_srq          *req_srq;
+    /* req_cq will raise an event on req_comp_channel for the next completion */
+    bool                     req_cq_armed;
 
     struct ibv_comp_channel *data_comp_channel;
     struct ibv_cq           *data_cq;
     struct ibv_srq          *data_srq;
+    /* data_cq will raise an event on data_comp_channel for the next completion */
+    bool                     data_cq_armed;
 
     uint32_t req_srq_count;
     uint32_t data_srq_count;
@@ -303,6 +463,8 @@ typedef struct {
 
 
 static nthread_lock_t nnti_ib_lock;
+
+static nnti_credit_table_t request_credits;
 static nthread_lock_t nnti_progress_lock;
 static nthread_cond_t nnti_progress_cond;
 
@@ -318,16 +480,117 @@ static int register_ack(
         ib_work_request *ib_wr);
 static int unregister_ack(
         ib_work_request *ib_wr);
-static void send_ack (
-        ib_work_request *ib_wr);
 static NNTI_result_t setup_data_channel(void);
 static NNTI_result_t setup_request_channel(void);
 static NNTI_result_t setup_interrupt_pipe(void);
 static NNTI_result_t setup_atomics(void);
-static ib_work_request *decode_work_request(
-        const struct ibv_wc *wc);
+static int8_t atomic_scratch_pop(
+        uint32_t *slot);
+static void atomic_scratch_push(
+        const uint32_t slot);
+static int8_t atomic_vector_next(
+        ib_work_request *ib_wr);
+static int atomic_vector_post(
+        ib_work_request *ib_wr);
+static void atomic_vector_free(
+        ib_work_request *ib_wr);
+static int8_t atomic_retry(
+        ib_work_request *ib_wr);
+static NNTI_result_t set_atomic_callback(
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          local_atomic,
+        const int8_t            use_threshold,
+        const int64_t           threshold,
+        NNTI_callback_fn_t      cbfunc,
+        void                   *context);
+static int check_atomic_callbacks(void);
+static NNTI_result_t ib_atomic_fop(
+        const NNTI_transport_id_t transport_id,
+        ib_connection            *conn,
+        const uint64_t            remote_addr,
+        const uint32_t            rkey,
+        uint64_t                  local_addr,
+        uint32_t                  lkey,
+        const int64_t             operand,
+        const NNTI_atomic_op_t    op,
+        NNTI_work_request_t      *wr);
+static NNTI_result_t ib_atomic_cswap(
+        const NNTI_transport_id_t transport_id,
+        ib_connection            *conn,
+        const uint64_t            remote_addr,
+        const uint32_t            rkey,
+        const uint64_t            local_addr,
+        const uint32_t            lkey,
+        const int64_t             compare_operand,
+        const int64_t             swap_operand,
+        NNTI_work_request_t      *wr);
+static NNTI_result_t setup_ack_slab(void);
+static void teardown_ack_slab(void);
+static void decode_work_request_list(
+        const struct ibv_wc  *wc_list,
+        const int             wc_count,
+        ib_work_request     **ib_wr_list);
 static int cancel_wr(
         ib_work_request *ib_wr);
+static NNTI_result_t ib_put(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       stream_chunk,
+        const uint64_t       imm,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+static NNTI_result_t ib_get(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+static void vector_rdma_wrs(
+        ib_work_request     *ib_wr,
+        const NNTI_buffer_t *local_hdl,
+        const NNTI_buffer_t *remote_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        const int8_t         is_put);
+static void chunk_rdma_wrs(
+        ib_work_request *ib_wr,
+        uint64_t         length,
+        uint64_t         chunk_size);
+static int chunk_post_next(
+        ib_work_request *ib_wr);
+static void chunk_free(
+        ib_work_request *ib_wr);
+static void replace_srq_recv(
+        ib_work_request *ib_wr);
+static void implicit_issue(
+        ib_work_request *ib_wr);
+static void implicit_arm(
+        ib_work_request *ib_wr,
+        NNTI_result_t    rc);
+static void implicit_retire(
+        ib_work_request *ib_wr);
+static void implicit_fail(
+        ib_connection *conn,
+        NNTI_result_t  result);
+static void fail_unsignaled(
+        ib_connection *conn,
+        NNTI_result_t  result);
+static NNTI_result_t take_send_result(
+        ib_connection *conn);
+static int8_t counter_landed(
+        ib_work_request     *ib_wr,
+        const struct ibv_wc *wc);
+static int8_t stream_chunk_landed(
+        ib_work_request *ib_wr);
+static void stream_deliver(
+        ib_work_request *ib_wr);
 static int process_event(
         ib_work_request     *ib_wr,
         const struct ibv_wc *wc);
@@ -394,6 +657,12 @@ static void transition_qp_from_reset_to_ready(
         int            min_rnr_timer,
         int            ack_timeout,
         int            retry_count);
+static struct ibv_qp *create_conn_qp(
+        struct ibv_qp_init_attr *att,
+        conn_qp                 *cqp);
+static NNTI_result_t post_send_chain(
+        conn_qp *cqp);
+static void flush_send_chains(void);
 static void transition_qp_from_error_to_ready(
         struct ibv_qp *qp,
         uint32_t       peer_qpn,
@@ -412,6 +681,17 @@ static NNTI_result_t init_connection(
         const int sock,
         const int is_server);
 static void close_connection(ib_connection *c);
+static int check_emulated_peer(
+        const ib_connection *c);
+static uint64_t credit_key(
+        const ib_connection *c);
+static int setup_credit_record(
+        ib_connection *c);
+static int8_t take_request_credit(
+        ib_connection *c);
+static void return_request_credits(
+        ib_connection *c,
+        uint32_t       credits);
 static void print_wc(
         const struct ibv_wc *wc,
         bool force);
@@ -431,11 +711,11 @@ static NNTI_buffer_t *get_buf_bufhash(const uint32_t bufhash);
 static NNTI_buffer_t *del_buf_bufhash(NNTI_buffer_t *buf);
 //static void print_bufhash_map(void);
 
-static NNTI_result_t wr_pool_init(uint32_t pool_size);
+static NNTI_result_t wr_pool_init(void);
 static ib_work_request *wr_pool_rdma_pop(void);
 static ib_work_request *wr_pool_sendrecv_pop(void);
-static void wr_pool_rdma_push(ib_work_request *ib_wr);
-static void wr_pool_sendrecv_push(ib_work_request *ib_wr);
+static void wr_pool_push(ib_work_request *ib_wr);
+static void wr_pool_get_stats(struct ib_wr_pool *pool, nnti_wr_pool_stats *stats);
 static NNTI_result_t wr_pool_fini(void);
 
 static void close_all_conn(void);
@@ -530,7 +810,45 @@ static nthread_lock_t nnti_buf_bufhash_lock;
 
 typedef std::deque<ib_work_request *>           wr_pool_t;
 typedef std::deque<ib_work_request *>::iterator wr_pool_iter_t;
-static nthread_lock_t nnti_wr_pool_lock;
+
+/* QPs holding sends that haven't been posted yet (send_chain_max > 1) */
+typedef std::deque<conn_qp *> send_chain_list_t;
+static nthread_lock_t    nnti_send_lock;
+static send_chain_list_t pending_send_chains;
+
+/* implicit operations to all peers.  the per-peer counts live in ib_connection. */
+static nthread_lock_t nnti_implicit_lock;
+static uint64_t       implicit_issued;
+static uint64_t       implicit_retired;
+static NNTI_result_t  implicit_result;
+
+/*
+ * non-fetching atomics still get a value back from the HCA.  it lands in
+ * one of these slots past the end of the caller's atomic variables.
+ * protected by atomics_lock.
+ */
+#define ATOMIC_SCRATCH_SLOTS 64
+static std::deque<uint32_t> atomic_scratch_slots;
+
+/*
+ * one-sided atomics don't generate an event at the target, so progress()
+ * watches the variables that have callbacks for a change in value.  while
+ * any are watched, progress() wakes at least every ATOMIC_CALLBACK_POLL_MS.
+ * protected by atomics_lock.  atomic_callbacks_watched mirrors the size of
+ * the map so progress() can skip the lock when nothing is watched.
+ */
+typedef struct {
+    NNTI_callback_fn_t      cbfunc;
+    void                   *context;
+    const NNTI_transport_t *trans_hdl;
+    int64_t                 threshold;
+    int8_t                  use_threshold;
+    int64_t                 last_value;
+} ib_atomic_callback;
+#define ATOMIC_CALLBACK_POLL_MS 10
+static std::map<uint64_t, ib_atomic_callback> atomic_callbacks;
+static volatile uint32_t atomic_callbacks_watched=0;
+typedef std::map<uint64_t, ib_atomic_callback>::iterator atomic_callback_iter_t;
 
 typedef uint32_t wr_key_t;
 static std::map<wr_key_t, ib_work_request *> wrmap;
@@ -539,8 +857,61 @@ typedef std::map<wr_key_t, ib_work_request *>::iterator wrmap_iter_t;
 static nthread_lock_t nnti_wrmap_lock;
 static nthread_counter_t nnti_wrmap_counter;
 
-static wr_pool_t rdma_wr_pool;
-static wr_pool_t sendrecv_wr_pool;
+/*
+ * Work request pools.  Each pool is split into shards and a thread pops
+ * from the shard its id hashes to, so threads rarely share a lock.  A
+ * request goes back to the shard it came from.  An empty shard steals
+ * half of a neighbor's free list before it grows.  Growth adds a chunk
+ * as large as the shard already is (at least WR_POOL_MIN_CHUNK), so a
+ * shard ends up sized to the concurrency it has seen.  The ACK records of
+ * a chunk are registered with one MR.  Once a pool reaches
+ * wr_pool_max_size, requests are allocated on their own and freed when
+ * they're pushed.
+ */
+#define WR_POOL_SHARDS    8
+#define WR_POOL_MIN_CHUNK 16
+
+typedef struct {
+    nthread_lock_t lock;
+    wr_pool_t      free_list;
+    uint32_t       owned;       /* requests homed on this shard, free or in use */
+    uint32_t       high_water;  /* most requests in use at once */
+    uint64_t       pops;
+    uint64_t       steals;
+} ib_wr_pool_shard;
+
+typedef struct {
+    ib_work_request *wrs;
+    ib_rdma_ack     *acks;
+    struct ibv_mr   *ack_mr;
+} ib_wr_pool_chunk;
+typedef std::deque<ib_wr_pool_chunk> wr_chunk_list_t;
+
+typedef struct ib_wr_pool {
+    const char       *name;
+    bool              with_ack;     /* requests carry a registered ACK record */
+    ib_wr_pool_shard  shard[WR_POOL_SHARDS];
+    nthread_lock_t    chunk_lock;   /* protects everything below */
+    wr_chunk_list_t   chunks;
+    uint32_t          size;
+    uint64_t          grows;
+    uint64_t          overflows;
+} ib_wr_pool;
+
+static ib_wr_pool rdma_wr_pool;
+static ib_wr_pool sendrecv_wr_pool;
+
+/*
+ * ACK records are carved out of a single slab that is registered once at
+ * init.  register_ack() hands out a slot and unregister_ack() returns it,
+ * so target ACKs don't cost an ibv_reg_mr()/ibv_dereg_mr() per transfer.
+ */
+#define ACK_SLAB_SLOTS 4096
+typedef std::deque<uint32_t> ack_slot_list_t;
+static nthread_lock_t   nnti_ack_slab_lock;
+static ib_rdma_ack     *ack_slab=NULL;
+static struct ibv_mr   *ack_slab_mr=NULL;
+static ack_slot_list_t  ack_slab_free;
 
 
 static nnti_ib_config config;
@@ -552,7 +923,11 @@ void ibv_ack_cq_events_wrapper(struct ibv_cq *cq, unsigned int nevents)
 {
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    ibv_ack_cq_events(cq, nevents);
+    if (config.use_verbs_emulator) {
+        ibv_emu_ack_cq_events(cq, nevents);
+    } else {
+        ibv_ack_cq_events(cq, nevents);
+    }
     if (sampling) SAMPLING_START();
 
     return;
@@ -564,7 +939,11 @@ struct ibv_pd *ibv_alloc_pd_wrapper(struct ibv_context *context)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    pd=ibv_alloc_pd(context);
+    if (config.use_verbs_emulator) {
+        pd=ibv_emu_alloc_pd(context);
+    } else {
+        pd=ibv_alloc_pd(context);
+    }
     if (sampling) SAMPLING_START();
 
     return pd;
@@ -576,7 +955,11 @@ int ibv_close_device_wrapper(struct ibv_context *context)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_close_device(context);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_close_device(context);
+    } else {
+        rc=ibv_close_device(context);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -588,7 +971,11 @@ struct ibv_comp_channel *ibv_create_comp_channel_wrapper(struct ibv_context *con
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    channel=ibv_create_comp_channel(context);
+    if (config.use_verbs_emulator) {
+        channel=ibv_emu_create_comp_channel(context);
+    } else {
+        channel=ibv_create_comp_channel(context);
+    }
     if (sampling) SAMPLING_START();
 
     return channel;
@@ -603,7 +990,11 @@ struct ibv_cq *ibv_create_cq_wrapper(struct ibv_context *context, int cqe,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    cq=ibv_create_cq(context, cqe, cq_context, channel, comp_vector);
+    if (config.use_verbs_emulator) {
+        cq=ibv_emu_create_cq(context, cqe, cq_context, channel, comp_vector);
+    } else {
+        cq=ibv_create_cq(context, cqe, cq_context, channel, comp_vector);
+    }
     if (sampling) SAMPLING_START();
 
     return cq;
@@ -616,7 +1007,11 @@ struct ibv_qp *ibv_create_qp_wrapper(struct ibv_pd *pd,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    qp=ibv_create_qp(pd, qp_init_attr);
+    if (config.use_verbs_emulator) {
+        qp=ibv_emu_create_qp(pd, qp_init_attr);
+    } else {
+        qp=ibv_create_qp(pd, qp_init_attr);
+    }
     if (sampling) SAMPLING_START();
 
     return qp;
@@ -629,7 +1024,11 @@ struct ibv_srq *ibv_create_srq_wrapper(struct ibv_pd *pd,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    srq=ibv_create_srq(pd, srq_init_attr);
+    if (config.use_verbs_emulator) {
+        srq=ibv_emu_create_srq(pd, srq_init_attr);
+    } else {
+        srq=ibv_create_srq(pd, srq_init_attr);
+    }
     if (sampling) SAMPLING_START();
 
     return srq;
@@ -641,7 +1040,11 @@ int ibv_dealloc_pd_wrapper(struct ibv_pd *pd)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_dealloc_pd(pd);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_dealloc_pd(pd);
+    } else {
+        rc=ibv_dealloc_pd(pd);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -653,7 +1056,11 @@ int ibv_dereg_mr_wrapper(struct ibv_mr *mr)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_dereg_mr(mr);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_dereg_mr(mr);
+    } else {
+        rc=ibv_dereg_mr(mr);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -666,7 +1073,11 @@ int ibv_destroy_comp_channel_wrapper(
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_destroy_comp_channel(channel);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_destroy_comp_channel(channel);
+    } else {
+        rc=ibv_destroy_comp_channel(channel);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -679,7 +1090,11 @@ int ibv_destroy_cq_wrapper(
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_destroy_cq(cq);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_destroy_cq(cq);
+    } else {
+        rc=ibv_destroy_cq(cq);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -691,7 +1106,11 @@ int ibv_destroy_qp_wrapper(struct ibv_qp *qp)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_destroy_qp(qp);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_destroy_qp(qp);
+    } else {
+        rc=ibv_destroy_qp(qp);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -704,7 +1123,11 @@ int ibv_destroy_srq_wrapper(
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_destroy_srq(srq);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_destroy_srq(srq);
+    } else {
+        rc=ibv_destroy_srq(srq);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -714,7 +1137,11 @@ void ibv_free_device_list_wrapper(struct ibv_device **list)
 {
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    ibv_free_device_list(list);
+    if (config.use_verbs_emulator) {
+        ibv_emu_free_device_list(list);
+    } else {
+        ibv_free_device_list(list);
+    }
     if (sampling) SAMPLING_START();
 
     return;
@@ -728,7 +1155,11 @@ int ibv_get_cq_event_wrapper(struct ibv_comp_channel *channel,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_get_cq_event(channel, cq, cq_context);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_get_cq_event(channel, cq, cq_context);
+    } else {
+        rc=ibv_get_cq_event(channel, cq, cq_context);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -740,7 +1171,11 @@ struct ibv_device **ibv_get_device_list_wrapper(int *num_devices)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    dev=ibv_get_device_list(num_devices);
+    if (config.use_verbs_emulator) {
+        dev=ibv_emu_get_device_list(num_devices);
+    } else {
+        dev=ibv_get_device_list(num_devices);
+    }
     if (sampling) SAMPLING_START();
 
     return dev;
@@ -754,7 +1189,11 @@ int ibv_modify_qp_wrapper(struct ibv_qp *qp,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_modify_qp(qp, attr, attr_mask);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_modify_qp(qp, attr, attr_mask);
+    } else {
+        rc=ibv_modify_qp(qp, attr, attr_mask);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -766,7 +1205,11 @@ struct ibv_context *ibv_open_device_wrapper(struct ibv_device *device)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    context=ibv_open_device(device);
+    if (config.use_verbs_emulator) {
+        context=ibv_emu_open_device(device);
+    } else {
+        context=ibv_open_device(device);
+    }
     if (sampling) SAMPLING_START();
 
     return context;
@@ -778,7 +1221,11 @@ int ibv_poll_cq_wrapper(struct ibv_cq *cq, int num_entries, struct ibv_wc *wc)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_poll_cq(cq, num_entries, wc);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_poll_cq(cq, num_entries, wc);
+    } else {
+        rc=ibv_poll_cq(cq, num_entries, wc);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -792,7 +1239,11 @@ int ibv_post_send_wrapper(struct ibv_qp *qp,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_post_send(qp, ib_wr, bad_wr);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_post_send(qp, ib_wr, bad_wr);
+    } else {
+        rc=ibv_post_send(qp, ib_wr, bad_wr);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -806,7 +1257,11 @@ int ibv_post_srq_recv_wrapper(struct ibv_srq *srq,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_post_srq_recv(srq,  recv_wr, bad_recv_wr);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_post_srq_recv(srq,  recv_wr, bad_recv_wr);
+    } else {
+        rc=ibv_post_srq_recv(srq,  recv_wr, bad_recv_wr);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -819,7 +1274,29 @@ int ibv_query_device_wrapper(struct ibv_context *context,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_query_device(context, device_attr);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_query_device(context, device_attr);
+    } else {
+        rc=ibv_query_device(context, device_attr);
+    }
+    if (sampling) SAMPLING_START();
+
+    return rc;
+}
+static
+int ibv_query_qp_wrapper(struct ibv_qp *qp, struct ibv_qp_attr *attr,
+                 int attr_mask,
+                 struct ibv_qp_init_attr *init_attr)
+{
+    int rc=0;
+
+    bool sampling = SAMPLING_IS_ACTIVE();
+    if (sampling) SAMPLING_STOP();
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_query_qp(qp, attr, attr_mask, init_attr);
+    } else {
+        rc=ibv_query_qp(qp, attr, attr_mask, init_attr);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -832,7 +1309,11 @@ int ibv_query_port_wrapper(struct ibv_context *context, uint8_t port_num,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_query_port(context, port_num, port_attr);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_query_port(context, port_num, port_attr);
+    } else {
+        rc=ibv_query_port(context, port_num, port_attr);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -845,7 +1326,11 @@ struct ibv_mr *ibv_reg_mr_wrapper(struct ibv_pd *pd, void *addr,
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    mr=ibv_reg_mr(pd, addr, length, access);
+    if (config.use_verbs_emulator) {
+        mr=ibv_emu_reg_mr(pd, addr, length, access);
+    } else {
+        mr=ibv_reg_mr(pd, addr, length, access);
+    }
     if (sampling) SAMPLING_START();
 
     return mr;
@@ -857,7 +1342,11 @@ int ibv_req_notify_cq_wrapper(struct ibv_cq *cq, int solicited_only)
 
     bool sampling = SAMPLING_IS_ACTIVE();
     if (sampling) SAMPLING_STOP();
-    rc=ibv_req_notify_cq(cq, solicited_only);
+    if (config.use_verbs_emulator) {
+        rc=ibv_emu_req_notify_cq(cq, solicited_only);
+    } else {
+        rc=ibv_req_notify_cq(cq, solicited_only);
+    }
     if (sampling) SAMPLING_START();
 
     return rc;
@@ -931,13 +1420,15 @@ NNTI_result_t NNTI_ib_init (
         nthread_lock_init(&nnti_wrmap_lock);
         nthread_counter_init(&nnti_wrmap_counter);
 
-        nthread_lock_init(&transport_global_data.atomics_lock);
-
-        nthread_lock_init(&nnti_wr_pool_lock);
+        nthread_lock_init(&nnti_ack_slab_lock);
+        nthread_lock_init(&nnti_send_lock);
+        nthread_lock_init(&nnti_implicit_lock);
 
         config_init(&config);
         config_get_from_env(&config);
 
+        nnti_credits_init(&request_credits, config.request_credits);
+
         log_debug(nnti_debug_level, "my_url=%s", my_url);
 
         if (my_url != NULL) {
@@ -982,7 +1473,14 @@ NNTI_result_t NNTI_ib_init (
 
         memset(&transport_global_data, 0, sizeof(ib_transport_global));
 
+        /* after the memset, which would otherwise wipe it out */
+        nthread_lock_init(&transport_global_data.atomics_lock);
+
         struct ibv_device *dev=get_ib_device();
+        if (dev == NULL) {
+            log_error(nnti_debug_level, "no InfiniBand devices found");
+            return NNTI_ENOENT;
+        }
 
         /* open the device */
         transport_global_data.ctx = ibv_open_device_wrapper(dev);
@@ -1036,8 +1534,16 @@ NNTI_result_t NNTI_ib_init (
         setup_request_channel();
         setup_data_channel();
 
+        if (config.use_rdma_target_ack) {
+            rc=setup_ack_slab();
+            if (rc!=NNTI_OK) {
+                log_error(nnti_debug_level, "setup_ack_slab(): %d", rc);
+                goto cleanup;
+            }
+        }
+
         if (config.use_wr_pool) {
-            rc=wr_pool_init(101);
+            rc=wr_pool_init();
             if (rc!=NNTI_OK) {
                 log_error(nnti_debug_level, "wr_pool_init(): %d", rc);
                 goto cleanup;
@@ -1211,8 +1717,13 @@ retry:
     }
 
     trios_start_timer(callTime);
-    init_connection(&conn, s, 0);
+    rc=init_connection(&conn, s, 0);
     trios_stop_timer("ib init connection", callTime);
+    if (rc != NNTI_OK) {
+        close(s);
+        free(conn);
+        goto cleanup;
+    }
 
     create_peer(
             peer_hdl,
@@ -1301,6 +1812,11 @@ NNTI_result_t NNTI_ib_alloc (
     assert(ops>0);
     assert(reg_buf);
 
+    if (ops == NNTI_BOP_RECV_RING) {
+        log_error(nnti_debug_level, "the IB transport doesn't support NNTI_RECV_RING buffers");
+        return(NNTI_ENOTSUP);
+    }
+
     char *buf=(char *)aligned_malloc(element_size*num_elements);
     assert(buf);
 
@@ -1389,6 +1905,12 @@ NNTI_result_t NNTI_ib_register_memory (
     assert(ops>0);
     assert(reg_buf);
 
+    if (ops == NNTI_BOP_RECV_RING) {
+        /* receives are preposted into fixed slots, so requests can't be packed */
+        log_error(nnti_debug_level, "the IB transport doesn't support NNTI_RECV_RING buffers");
+        return(NNTI_ENOTSUP);
+    }
+
     old_buf=get_buf_bufhash(hash6432shift((uint64_t)buffer));
     if (old_buf==NULL) {
         ib_mem_hdl=new ib_memory_handle();
@@ -1454,10 +1976,14 @@ NNTI_result_t NNTI_ib_register_memory (
             }
 
         } else {
+            int access=IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE;
+            if (ops & NNTI_BOP_ATOMICS) {
+                access |= IBV_ACCESS_REMOTE_ATOMIC;
+            }
             ib_mem_hdl->mr=register_memory_segment(
                                 buffer,
                                 element_size,
-                                (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
+                                (ibv_access_flags)access);
 
             log_debug(nnti_debug_level, "mr=%p mr_list[0]=%p", ib_mem_hdl->mr, ib_mem_hdl->mr_list[0]);
 
@@ -1593,11 +2119,15 @@ NNTI_result_t NNTI_ib_register_segments (
         ib_mem_hdl->mr_list=(struct ibv_mr **)calloc(num_segments, sizeof(struct ibv_mr *));
         ib_mem_hdl->mr_count=num_segments;
 
+        int access=IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE;
+        if (ops & NNTI_BOP_ATOMICS) {
+            access |= IBV_ACCESS_REMOTE_ATOMIC;
+        }
         for (int i=0;i<num_segments;i++) {
             ib_mem_hdl->mr_list[i]=register_memory_segment(
                                         segments[i],
                                         segment_lengths[i],
-                                        (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
+                                        (ibv_access_flags)access);
 
             log_debug(nnti_debug_level, "mr_list[%d]=%p", i, ib_mem_hdl->mr_list[i]);
         }
@@ -1677,11 +2207,7 @@ NNTI_result_t NNTI_ib_unregister_memory (
                 break;
             ib_mem_hdl->wr_queue.pop_front();
             if (config.use_wr_pool) {
-                if (ib_wr->ack_mr!=NULL) {
-                    wr_pool_rdma_push(ib_wr);
-                } else {
-                    wr_pool_sendrecv_push(ib_wr);
-                }
+                wr_pool_push(ib_wr);
             } else {
                 if (config.use_rdma_target_ack) {
                     unregister_ack(ib_wr);
@@ -1733,10 +2259,11 @@ NNTI_result_t NNTI_ib_send (
 
     trios_declare_timer(call_time);
 
-    struct ibv_send_wr *bad_wr;
-
     ib_memory_handle *ib_mem_hdl=NULL;
     ib_work_request  *ib_wr=NULL;
+    ib_connection    *conn=NULL;
+    conn_qp          *cqp=NULL;
+    uint64_t          msg_len=0;
 
     log_debug(nnti_debug_level, "enter");
 
@@ -1745,6 +2272,22 @@ NNTI_result_t NNTI_ib_send (
 
     log_level debug_level=nnti_debug_level;
 
+    conn=get_conn_peer(peer_hdl);
+    assert(conn);
+
+    rc=take_send_result(conn);
+    if (rc != NNTI_OK) {
+        log_error(nnti_debug_level, "an earlier send to %s failed: %d", conn->peer_name, rc);
+        return(rc);
+    }
+
+    if ((dest_hdl == NULL) || (dest_hdl->ops == NNTI_BOP_RECV_QUEUE)) {
+        if (!take_request_credit(conn)) {
+            log_debug(nnti_debug_level, "out of request credits for %s", conn->peer_name);
+            return(NNTI_EAGAIN);
+        }
+    }
+
     ib_mem_hdl=IB_MEM_HDL(msg_hdl);
     assert(ib_mem_hdl);
     if (config.use_wr_pool) {
@@ -1756,8 +2299,13 @@ NNTI_result_t NNTI_ib_send (
     }
     assert(ib_wr);
 
-    ib_wr->conn = get_conn_peer(peer_hdl);
-    assert(ib_wr->conn);
+    ib_wr->conn = conn;
+
+    if (wr == NULL) {
+        // an implicit send (see NNTI_ib_send_implicit())
+        wr=&ib_wr->implicit_wr;
+        implicit_issue(ib_wr);
+    }
 
     ib_wr->nnti_wr = wr;
     ib_wr->reg_buf = (NNTI_buffer_t *)msg_hdl;
@@ -1780,6 +2328,8 @@ NNTI_result_t NNTI_ib_send (
         ib_wr->sq_wr.send_flags=IBV_SEND_SIGNALED;
 
         ib_wr->last_op=IB_OP_SEND_REQUEST;
+
+        cqp=&ib_wr->conn->req_qp;
     } else {
         ib_wr->comp_channel=transport_global_data.data_comp_channel;
         ib_wr->cq          =transport_global_data.data_cq;
@@ -1795,6 +2345,8 @@ NNTI_result_t NNTI_ib_send (
         ib_wr->sq_wr.send_flags=IBV_SEND_SIGNALED;
 
         ib_wr->last_op=IB_OP_SEND_BUFFER;
+
+        cqp=&ib_wr->conn->data_qp;
     }
 
     // setup the scatter-gather list for this work request
@@ -1812,6 +2364,9 @@ NNTI_result_t NNTI_ib_send (
             ib_wr->sge_list[i].lkey  =ib_mem_hdl->mr_list[i]->lkey;
         }
     }
+    for (int i=0;i<ib_wr->sge_count;i++) {
+        msg_len += ib_wr->sge_list[i].length;
+    }
     ib_wr->sq_wr.wr_id   = (uint64_t)ib_wr->key;
     ib_wr->sq_wr.next    = NULL;  // RAOLDFI ADDED
     ib_wr->sq_wr.sg_list = ib_wr->sge_list;
@@ -1828,10 +2383,12 @@ NNTI_result_t NNTI_ib_send (
                       ib_wr->sq_wr.wr.rdma.rkey,
             (void *)  ib_wr->sq_wr.wr.rdma.remote_addr);
 
-    log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
-    nthread_lock(&ib_mem_hdl->wr_queue_lock);
-    ib_mem_hdl->wr_queue.push_back(ib_wr);
-    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    if (wr != &ib_wr->implicit_wr) {
+        log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
+        nthread_lock(&ib_mem_hdl->wr_queue_lock);
+        ib_mem_hdl->wr_queue.push_back(ib_wr);
+        nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    }
 
     log_debug(nnti_debug_level, "wrmap[key(%lx)]=ib_wr(%p)", ib_wr->key, ib_wr);
     nthread_lock(&nnti_wrmap_lock);
@@ -1845,13 +2402,46 @@ NNTI_result_t NNTI_ib_send (
     wr->result           =NNTI_OK;
     wr->transport_private=(uint64_t)ib_wr;
 
-    log_debug(nnti_debug_level, "posting ib_wr=%p (key=%lx)", ib_wr, ib_wr->key);
-    trios_start_timer(call_time);
-    if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr, &bad_wr)) {
-        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
-        rc=NNTI_EIO;
+    nthread_lock(&nnti_send_lock);
+
+    if (msg_len <= cqp->max_inline) {
+        // the HCA copies the payload out of the WQE, so msg_hdl is free once this is posted
+        ib_wr->sq_wr.send_flags |= IBV_SEND_INLINE;
+
+        /*
+         * An inline send doesn't need a completion to release its buffer, so
+         * only every send_signal_interval'th one is signaled.  That completion
+         * retires the unsignaled sends ahead of it in the send queue.  Requests
+         * stay signaled if a full queue must be reported as NNTI_EDROPPED.
+         */
+        if ((!config.drop_if_full_queue || (ib_wr->last_op != IB_OP_SEND_REQUEST)) &&
+            (++cqp->unsignaled_count < config.send_signal_interval)) {
+            ib_wr->sq_wr.send_flags &= ~IBV_SEND_SIGNALED;
+            ib_wr->sq_wr.wr_id       = IB_UNSIGNALED_WR_ID;
+        } else {
+            cqp->unsignaled_count=0;
+        }
+    }
+
+    log_debug(nnti_debug_level, "queueing ib_wr=%p (key=%lx ; send_flags=%x)", ib_wr, ib_wr->key, ib_wr->sq_wr.send_flags);
+    cqp->send_chain[cqp->send_chain_len++]=ib_wr;
+    if (cqp->send_chain_len >= config.send_chain_max) {
+        trios_start_timer(call_time);
+        rc=post_send_chain(cqp);
+        trios_stop_timer("NNTI_ib_send - ibv_post_send", call_time);
+        if (config.send_chain_max > 1) {
+            pending_send_chains.erase(find(pending_send_chains.begin(), pending_send_chains.end(), cqp));
+        }
+    } else if (cqp->send_chain_len == 1) {
+        // the first send held on this QP.  NNTI_ib_wait*() or the next RDMA op posts it.
+        pending_send_chains.push_back(cqp);
+    }
+
+    nthread_unlock(&nnti_send_lock);
+
+    if (wr == &ib_wr->implicit_wr) {
+        implicit_arm(ib_wr, NNTI_OK);
     }
-    trios_stop_timer("NNTI_ib_send - ibv_post_send", call_time);
 
     log_debug(nnti_debug_level, "exit");
 
@@ -1873,6 +2463,104 @@ NNTI_result_t NNTI_ib_put (
         const NNTI_buffer_t *dest_buffer_hdl,
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr)
+{
+    return(ib_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, NULL, 0, wr));
+}
+
+
+/**
+ * @brief Transfer data to a peer as a stream of chunks.
+ *
+ * Like NNTI_ib_put(), but every chunk of <tt>chunk_size</tt> bytes is written
+ * with an immediate, so the target gets one event per chunk.  The ACK record
+ * that precedes the first chunk carries the chunk size, which lets the
+ * target work out the offset and length of each chunk as it lands.
+ *
+ * The target only learns about puts through the ACK records, so this
+ * requires TRIOS_NNTI_USE_RDMA_TARGET_ACK.  An empty put or a destination
+ * registered in several segments gets a regular put and one event.
+ */
+NNTI_result_t NNTI_ib_put_stream (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t *wr)
+{
+    uint64_t stream_chunk=chunk_size;
+
+    if (!config.use_rdma_target_ack) {
+        log_debug(nnti_debug_level, "streaming puts require TRIOS_NNTI_USE_RDMA_TARGET_ACK");
+        return(NNTI_ENOTSUP);
+    }
+    if ((chunk_size == 0) || (chunk_size > 0x80000000ULL)) {
+        log_debug(nnti_debug_level, "chunk_size(%llu) must be >0 and fit in an SGE", chunk_size);
+        return(NNTI_EINVAL);
+    }
+    if ((src_length == 0) ||
+        (dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_len > 1)) {
+        stream_chunk=0;
+    }
+
+    return(ib_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, stream_chunk, 0, NULL, 0, wr));
+}
+
+
+/**
+ * @brief Transfer data to a peer and tell the target what it was.
+ *
+ * Like NNTI_ib_put(), but <tt>imm</tt> reaches the target's status.  The
+ * 32-bit immediate of the final RDMA write already carries the hash that
+ * finds the target buffer, so <tt>imm</tt> rides in the ACK record that is
+ * written ahead of it.  The put costs no more than a regular put and 32-bit
+ * and 64-bit values are treated alike.
+ *
+ * The target only learns about puts through the ACK records, so this
+ * requires TRIOS_NNTI_USE_RDMA_TARGET_ACK.
+ */
+NNTI_result_t NNTI_ib_put_notify (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr)
+{
+    if (!config.use_rdma_target_ack) {
+        log_debug(nnti_debug_level, "put notifications require TRIOS_NNTI_USE_RDMA_TARGET_ACK");
+        return(NNTI_ENOTSUP);
+    }
+
+    return(ib_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, imm, NULL, 0, wr));
+}
+
+
+/*
+ * Build and post a put.  <stream_chunk> is 0 for a regular put.  Otherwise
+ * the transfer is cut into chunks of that size and every chunk carries the
+ * immediate (see NNTI_ib_put_stream()).
+ *
+ * With TRIOS_NNTI_USE_RDMA_TARGET_ACK, <imm> goes to the target in the ACK
+ * record (see NNTI_ib_put_notify()).
+ *
+ * If <iov> isn't NULL, the put moves the regions it lists (see
+ * NNTI_ib_putv()) and <src_offset>/<src_length> describe the extent of
+ * the regions in the source buffer.
+ */
+static NNTI_result_t ib_put(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       stream_chunk,
+        const uint64_t       imm,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
@@ -1900,6 +2588,8 @@ NNTI_result_t NNTI_ib_put (
 
     log_debug(nnti_debug_level, "enter");
 
+    flush_send_chains();
+
     assert(src_buffer_hdl);
     assert(dest_buffer_hdl);
 
@@ -1921,6 +2611,12 @@ NNTI_result_t NNTI_ib_put (
     ib_wr->conn = get_conn_peer(&dest_buffer_hdl->buffer_owner);
     assert(ib_wr->conn);
 
+    if (wr == NULL) {
+        // an implicit put (see NNTI_ib_put_implicit())
+        wr=&ib_wr->implicit_wr;
+        implicit_issue(ib_wr);
+    }
+
     ib_wr->nnti_wr = wr;
     ib_wr->reg_buf = (NNTI_buffer_t *)src_buffer_hdl;
 
@@ -1933,8 +2629,12 @@ NNTI_result_t NNTI_ib_put (
     ib_wr->peer_qpn    =(uint64_t)ib_wr->conn->data_qp.peer_qpn;
 
     ib_wr->sq_wr_completed_count=0;
+    ib_wr->chunk_count=0;
+
+    if (iov != NULL) {
+        vector_rdma_wrs(ib_wr, src_buffer_hdl, dest_buffer_hdl, iov, iov_count, TRUE);
 
-    if (dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_len == 1) {
+    } else if (dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_len == 1) {
         // this is the easy case.  the destination (remote) buffer is contiguous so we can complete this PUT with one ibv_send_wr.
 
         ib_wr->sq_wr_list =&ib_wr->sq_wr;
@@ -2222,16 +2922,39 @@ NNTI_result_t NNTI_ib_put (
         }
     }
 
-    if (config.use_rdma_target_ack) {
-        ib_wr->ack.op    =IB_OP_PUT_TARGET;
-        ib_wr->ack.offset=dest_offset;
-        ib_wr->ack.length=src_length;
+    if (iov != NULL) {
+        // vector_rdma_wrs() already set up the window
+    } else if (stream_chunk > 0) {
+        // every chunk tells the target it landed
+        chunk_rdma_wrs(ib_wr, src_length, stream_chunk);
+        for (uint32_t i=0;i<ib_wr->sq_wr_count;i++) {
+            ib_wr->sq_wr_list[i].opcode=IBV_WR_RDMA_WRITE_WITH_IMM;
+        }
+    } else if ((config.rdma_chunk_threshold > 0) && (src_length > config.rdma_chunk_threshold)) {
+        chunk_rdma_wrs(ib_wr, src_length, config.rdma_chunk_size);
+    }
+
+    // chain the segments so the whole transfer goes out with one ibv_post_send()
+    for (uint32_t i=1;i<ib_wr->sq_wr_count;i++) {
+        ib_wr->sq_wr_list[i-1].next=&ib_wr->sq_wr_list[i];
+    }
+    ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].next=NULL;
 
+    if (config.use_rdma_target_ack) {
         if (!config.use_wr_pool) {
             register_ack(ib_wr);
         }
-        ib_wr->ack_sge.addr  =(uint64_t)ib_wr->ack_mr->addr;
-        ib_wr->ack_sge.length=ib_wr->ack_mr->length;
+        ib_wr->ack->op        =IB_OP_PUT_TARGET;
+        ib_wr->ack->offset    =dest_offset;
+        ib_wr->ack->length    =src_length;
+        ib_wr->ack->chunk_size=stream_chunk;
+        ib_wr->ack->imm       =imm;
+        if (iov != NULL) {
+            nnti_iovec_extent(iov, iov_count, FALSE, &ib_wr->ack->offset, &ib_wr->ack->length);
+        }
+
+        ib_wr->ack_sge.addr  =(uint64_t)ib_wr->ack;
+        ib_wr->ack_sge.length=sizeof(ib_rdma_ack);
         ib_wr->ack_sge.lkey  =ib_wr->ack_mr->lkey;
 
         ib_wr->ack_sq_wr.sg_list=&ib_wr->ack_sge;
@@ -2240,11 +2963,19 @@ NNTI_result_t NNTI_ib_put (
         ib_wr->ack_sq_wr.wr.rdma.rkey       =dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_key;
         ib_wr->ack_sq_wr.wr.rdma.remote_addr=dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_buf;
 
-        ib_wr->ack_sq_wr.opcode    =IBV_WR_RDMA_WRITE_WITH_IMM;
-        ib_wr->ack_sq_wr.send_flags=IBV_SEND_SIGNALED|IBV_SEND_FENCE;
-        ib_wr->sq_wr.wr_id         =(uint64_t)ib_wr->key;
-        ib_wr->ack_sq_wr.imm_data  =hash6432shift((uint64_t)dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.buf);
-        ib_wr->ack_sq_wr.next      =NULL;  // RAOLDFI ADDED
+        /*
+         * The ACK record goes out unsignaled ahead of the data.  The last data write
+         * carries the immediate, so the target's completion can't arrive before the
+         * record does and no separate ACK message is needed.
+         */
+        ib_wr->ack_sq_wr.opcode    =IBV_WR_RDMA_WRITE;
+        ib_wr->ack_sq_wr.send_flags=0;
+        ib_wr->ack_sq_wr.wr_id     =ib_wr->sq_wr_list[0].wr_id;
+        ib_wr->ack_sq_wr.imm_data  =0;
+        ib_wr->ack_sq_wr.next      =&ib_wr->sq_wr_list[0];
+
+        ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].opcode  =IBV_WR_RDMA_WRITE_WITH_IMM;
+        ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].imm_data=hash6432shift((uint64_t)dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.buf);
     }
 
     ib_wr->last_op=IB_OP_PUT_INITIATOR;
@@ -2256,10 +2987,12 @@ NNTI_result_t NNTI_ib_put (
             ib_wr->qp,
             ib_wr->qpn);
 
-    log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
-    nthread_lock(&ib_mem_hdl->wr_queue_lock);
-    ib_mem_hdl->wr_queue.push_back(ib_wr);
-    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    if (wr != &ib_wr->implicit_wr) {
+        log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
+        nthread_lock(&ib_mem_hdl->wr_queue_lock);
+        ib_mem_hdl->wr_queue.push_back(ib_wr);
+        nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    }
 
     wr->transport_id     =src_buffer_hdl->transport_id;
     wr->reg_buf          =(NNTI_buffer_t*)src_buffer_hdl;
@@ -2267,27 +3000,40 @@ NNTI_result_t NNTI_ib_put (
     wr->result           =NNTI_OK;
     wr->transport_private=(uint64_t)ib_wr;
 
-    for (int i=0;i<ib_wr->sq_wr_count;i++) {
-        log_debug(nnti_debug_level, "posting ib_wr->sq_wr_list[%d]=%p (key=%lx)", i, ib_wr->sq_wr_list[i], ib_wr->sq_wr_list[i].wr_id);
-        trios_start_timer(call_time);
-        if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr_list[i], &bad_wr)) {
-            log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
-            rc=NNTI_EIO;
-        }
-        trios_stop_timer("NNTI_ib_get - ibv_post_send", call_time);
-
-        if (config.use_rdma_target_ack) {
-            send_ack(ib_wr);
+    if (ib_wr->chunk_count > 0) {
+        // only the first window goes out now.  process_event() posts the rest as chunks complete.
+        ib_wr->chunk_posted=ib_wr->chunk_window;
+        if (ib_wr->chunk_posted < ib_wr->chunk_count) {
+            ib_wr->sq_wr_list[ib_wr->chunk_posted-1].next=NULL;
         }
+    }
 
-    //    print_wr(ib_wr);
+    log_debug(nnti_debug_level, "posting ib_wr->sq_wr_list=%p (sq_wr_count=%d)", ib_wr->sq_wr_list, ib_wr->sq_wr_count);
+    trios_start_timer(call_time);
+    if (ibv_post_send_wrapper(ib_wr->qp, (config.use_rdma_target_ack ? &ib_wr->ack_sq_wr : &ib_wr->sq_wr_list[0]), &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        rc=NNTI_EIO;
     }
+    trios_stop_timer("NNTI_ib_put - ibv_post_send", call_time);
 
-    if (ib_wr->sge_list != &ib_wr->sge) {
-        free(ib_wr->sge_list);
+    if (ib_wr->chunk_count > 0) {
+        // unless the first window was the whole transfer, process_event() posts the rest and frees the lists
+        nthread_lock(&ib_wr->lock);
+        if ((rc != NNTI_OK) || (ib_wr->chunk_window == ib_wr->chunk_count)) {
+            chunk_free(ib_wr);
+        }
+        nthread_unlock(&ib_wr->lock);
+    } else {
+        if (ib_wr->sge_list != &ib_wr->sge) {
+            free(ib_wr->sge_list);
+        }
+        if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
+            free(ib_wr->sq_wr_list);
+        }
     }
-    if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
-        free(ib_wr->sq_wr_list);
+
+    if (wr == &ib_wr->implicit_wr) {
+        implicit_arm(ib_wr, rc);
     }
 
     log_debug(nnti_debug_level, "exit");
@@ -2310,6 +3056,25 @@ NNTI_result_t NNTI_ib_get (
         const NNTI_buffer_t *dest_buffer_hdl,
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr)
+{
+    return(ib_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, NULL, 0, wr));
+}
+
+
+/*
+ * Build and post a get.  If <iov> isn't NULL, the get moves the regions it
+ * lists (see NNTI_ib_getv()) and <src_offset>/<src_length> describe the
+ * extent of the regions in the source buffer.
+ */
+static NNTI_result_t ib_get(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
 {
     NNTI_result_t rc=NNTI_OK;
     log_level debug_level = nnti_debug_level;
@@ -2340,6 +3105,8 @@ NNTI_result_t NNTI_ib_get (
 
     log_debug(debug_level, "enter (wr=%p)", wr);
 
+    flush_send_chains();
+
     assert(src_buffer_hdl);
     assert(dest_buffer_hdl);
 
@@ -2361,6 +3128,12 @@ NNTI_result_t NNTI_ib_get (
     ib_wr->conn = get_conn_peer(&src_buffer_hdl->buffer_owner);
     assert(ib_wr->conn);
 
+    if (wr == NULL) {
+        // an implicit get (see NNTI_ib_get_implicit())
+        wr=&ib_wr->implicit_wr;
+        implicit_issue(ib_wr);
+    }
+
     ib_wr->nnti_wr = wr;
     ib_wr->reg_buf = (NNTI_buffer_t *)dest_buffer_hdl;
 
@@ -2373,8 +3146,12 @@ NNTI_result_t NNTI_ib_get (
     ib_wr->peer_qpn    =(uint64_t)ib_wr->conn->data_qp.peer_qpn;
 
     ib_wr->sq_wr_completed_count=0;
+    ib_wr->chunk_count=0;
 
-    if (src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_len == 1) {
+    if (iov != NULL) {
+        vector_rdma_wrs(ib_wr, dest_buffer_hdl, src_buffer_hdl, iov, iov_count, FALSE);
+
+    } else if (src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_len == 1) {
         // this is the easy case.  the source (remote) buffer is contiguous so we can complete this GET with one ibv_send_wr.
 
         ib_wr->sq_wr_list =&ib_wr->sq_wr;
@@ -2672,16 +3449,29 @@ NNTI_result_t NNTI_ib_get (
         }
     }
 
-    if (config.use_rdma_target_ack) {
-        ib_wr->ack.op    =IB_OP_GET_TARGET;
-        ib_wr->ack.offset=src_offset;
-        ib_wr->ack.length=src_length;
+    if ((iov == NULL) &&
+        (config.rdma_chunk_threshold > 0) && (src_length > config.rdma_chunk_threshold)) {
+        chunk_rdma_wrs(ib_wr, src_length, config.rdma_chunk_size);
+    }
+
+    // chain the segments so the whole transfer goes out with one ibv_post_send()
+    for (uint32_t i=1;i<ib_wr->sq_wr_count;i++) {
+        ib_wr->sq_wr_list[i-1].next=&ib_wr->sq_wr_list[i];
+    }
+    ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].next=NULL;
 
+    if (config.use_rdma_target_ack) {
         if (!config.use_wr_pool) {
             register_ack(ib_wr);
         }
-        ib_wr->ack_sge.addr  =(uint64_t)ib_wr->ack_mr->addr;
-        ib_wr->ack_sge.length=ib_wr->ack_mr->length;
+        ib_wr->ack->op        =IB_OP_GET_TARGET;
+        ib_wr->ack->offset    =src_offset;
+        ib_wr->ack->length    =src_length;
+        ib_wr->ack->chunk_size=0;
+        ib_wr->ack->imm       =0;
+
+        ib_wr->ack_sge.addr  =(uint64_t)ib_wr->ack;
+        ib_wr->ack_sge.length=sizeof(ib_rdma_ack);
         ib_wr->ack_sge.lkey  =ib_wr->ack_mr->lkey;
 
         ib_wr->ack_sq_wr.sg_list=&ib_wr->ack_sge;
@@ -2690,26 +3480,38 @@ NNTI_result_t NNTI_ib_get (
         ib_wr->ack_sq_wr.wr.rdma.rkey       =src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_key;
         ib_wr->ack_sq_wr.wr.rdma.remote_addr=src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_buf;
 
+        /*
+         * A read can't carry an immediate, so the ACK record follows the reads
+         * as a fenced write-with-immediate.  The fence holds it until every read
+         * has completed, which also makes it the last completion of this get.
+         */
         ib_wr->ack_sq_wr.opcode    =IBV_WR_RDMA_WRITE_WITH_IMM;
         ib_wr->ack_sq_wr.send_flags=IBV_SEND_SIGNALED|IBV_SEND_FENCE;
-        ib_wr->sq_wr.wr_id         =(uint64_t)ib_wr->key;
+        ib_wr->ack_sq_wr.wr_id     =ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].wr_id;
         ib_wr->ack_sq_wr.imm_data  =hash6432shift((uint64_t)src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.buf);
-        ib_wr->ack_sq_wr.next      =NULL;  // RAOLDFI ADDED
+        ib_wr->ack_sq_wr.next      =NULL;
+
+        ib_wr->sq_wr_list[ib_wr->sq_wr_count-1].next=&ib_wr->ack_sq_wr;
     }
 
     ib_wr->last_op=IB_OP_GET_INITIATOR;
     ib_wr->length=src_length;
     ib_wr->offset=dest_offset;
+    if (iov != NULL) {
+        nnti_iovec_extent(iov, iov_count, FALSE, &ib_wr->offset, &ib_wr->length);
+    }
 
     log_debug(debug_level, "getting from (%s, qp=%p, qpn=%lu)",
             src_buffer_hdl->buffer_owner.url,
             ib_wr->qp,
             ib_wr->qpn);
 
-    log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
-    nthread_lock(&ib_mem_hdl->wr_queue_lock);
-    ib_mem_hdl->wr_queue.push_back(ib_wr);
-    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    if (wr != &ib_wr->implicit_wr) {
+        log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
+        nthread_lock(&ib_mem_hdl->wr_queue_lock);
+        ib_mem_hdl->wr_queue.push_back(ib_wr);
+        nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    }
 
     wr->transport_id     =dest_buffer_hdl->transport_id;
     wr->reg_buf          =(NNTI_buffer_t*)dest_buffer_hdl;
@@ -2717,27 +3519,40 @@ NNTI_result_t NNTI_ib_get (
     wr->result           =NNTI_OK;
     wr->transport_private=(uint64_t)ib_wr;
 
-    for (int i=0;i<ib_wr->sq_wr_count;i++) {
-        log_debug(nnti_debug_level, "posting ib_wr->sq_wr_list[%d]=%p (key=%lx)", i, ib_wr->sq_wr_list[i], ib_wr->sq_wr_list[i].wr_id);
-        trios_start_timer(call_time);
-        if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr_list[i], &bad_wr)) {
-            log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
-            rc=NNTI_EIO;
-        }
-        trios_stop_timer("NNTI_ib_get - ibv_post_send", call_time);
-
-        if (config.use_rdma_target_ack) {
-            send_ack(ib_wr);
+    if (ib_wr->chunk_count > 0) {
+        // only the first window goes out now.  process_event() posts the rest as chunks complete.
+        ib_wr->chunk_posted=ib_wr->chunk_window;
+        if (ib_wr->chunk_posted < ib_wr->chunk_count) {
+            ib_wr->sq_wr_list[ib_wr->chunk_posted-1].next=NULL;
         }
+    }
 
-    //    print_wr(ib_wr);
+    log_debug(nnti_debug_level, "posting ib_wr->sq_wr_list=%p (sq_wr_count=%d)", ib_wr->sq_wr_list, ib_wr->sq_wr_count);
+    trios_start_timer(call_time);
+    if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr_list[0], &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        rc=NNTI_EIO;
     }
+    trios_stop_timer("NNTI_ib_get - ibv_post_send", call_time);
 
-    if (ib_wr->sge_list != &ib_wr->sge) {
-        free(ib_wr->sge_list);
+    if (ib_wr->chunk_count > 0) {
+        // unless the first window was the whole transfer, process_event() posts the rest and frees the lists
+        nthread_lock(&ib_wr->lock);
+        if ((rc != NNTI_OK) || (ib_wr->chunk_window == ib_wr->chunk_count)) {
+            chunk_free(ib_wr);
+        }
+        nthread_unlock(&ib_wr->lock);
+    } else {
+        if (ib_wr->sge_list != &ib_wr->sge) {
+            free(ib_wr->sge_list);
+        }
+        if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
+            free(ib_wr->sq_wr_list);
+        }
     }
-    if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
-        free(ib_wr->sq_wr_list);
+
+    if (wr == &ib_wr->implicit_wr) {
+        implicit_arm(ib_wr, rc);
     }
 
     log_debug(nnti_debug_level, "exit");
@@ -2748,6 +3563,70 @@ NNTI_result_t NNTI_ib_get (
 }
 
 
+/**
+ * @brief Transfer a list of regions to a peer.
+ *
+ * The regions become RDMA writes.  Regions that continue the remote range
+ * of the write before them are gathered into it as more SGEs, so strided
+ * local data bound for one remote range is a single work request.  The
+ * writes are chained and posted together (see vector_rdma_wrs()).
+ */
+NNTI_result_t NNTI_ib_putv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+    uint64_t src_offset=0;
+    uint64_t src_length=0;
+    uint64_t dest_offset=0;
+    uint64_t dest_length=0;
+
+    rc=nnti_iovec_check(src_buffer_hdl, dest_buffer_hdl, iov, iov_count, (uint64_t)-1);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    nnti_iovec_extent(iov, iov_count, TRUE,  &src_offset,  &src_length);
+    nnti_iovec_extent(iov, iov_count, FALSE, &dest_offset, &dest_length);
+
+    return(ib_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, iov, iov_count, wr));
+}
+
+
+/**
+ * @brief Transfer a list of regions from a peer.
+ *
+ * Like NNTI_ib_putv(), but with RDMA reads that scatter a remote range
+ * into several local regions.
+ */
+NNTI_result_t NNTI_ib_getv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+    uint64_t src_offset=0;
+    uint64_t src_length=0;
+    uint64_t dest_offset=0;
+    uint64_t dest_length=0;
+
+    rc=nnti_iovec_check(src_buffer_hdl, dest_buffer_hdl, iov, iov_count, (uint64_t)-1);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    nnti_iovec_extent(iov, iov_count, TRUE,  &src_offset,  &src_length);
+    nnti_iovec_extent(iov, iov_count, FALSE, &dest_offset, &dest_length);
+
+    return(ib_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, iov, iov_count, wr));
+}
+
+
 /**
  * @brief Transfer data to a peer.
  *
@@ -2802,7 +3681,18 @@ NNTI_result_t NNTI_ib_atomic_set_callback (
         NNTI_callback_fn_t      cbfunc,
         void                   *context)
 {
-    return NNTI_ENOTSUP;
+    return(set_atomic_callback(trans_hdl, local_atomic, FALSE, 0, cbfunc, context));
+}
+
+
+NNTI_result_t NNTI_ib_atomic_set_threshold_callback (
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          local_atomic,
+        const int64_t           threshold,
+        NNTI_callback_fn_t      cbfunc,
+        void                   *context)
+{
+    return(set_atomic_callback(trans_hdl, local_atomic, TRUE, threshold, cbfunc, context));
 }
 
 
@@ -2819,14 +3709,20 @@ NNTI_result_t NNTI_ib_atomic_read (
 }
 
 
-NNTI_result_t NNTI_ib_atomic_fop (
-        const NNTI_transport_t *trans_hdl,
-        const NNTI_peer_t      *peer_hdl,
-        const uint64_t          target_atomic,
-        const uint64_t          result_atomic,
-        const int64_t           operand,
-        const NNTI_atomic_op_t  op,
-        NNTI_work_request_t    *wr)
+/*
+ * Post an atomic op on <remote_addr>.  A fetching op lands the previous
+ * value at <local_addr>; a non-fetching op lands it in a scratch slot.
+ */
+static NNTI_result_t ib_atomic_fop(
+        const NNTI_transport_id_t transport_id,
+        ib_connection            *conn,
+        const uint64_t            remote_addr,
+        const uint32_t            rkey,
+        uint64_t                  local_addr,
+        uint32_t                  lkey,
+        const int64_t             operand,
+        const NNTI_atomic_op_t    op,
+        NNTI_work_request_t      *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
@@ -2836,11 +3732,24 @@ NNTI_result_t NNTI_ib_atomic_fop (
 
     ib_work_request  *ib_wr=NULL;
 
+    uint32_t slot   =0;
+    int8_t   scratch=FALSE;
+
     log_debug(nnti_debug_level, "enter");
 
-    assert(peer_hdl);
+    flush_send_chains();
 
-    log_level debug_level=nnti_debug_level;
+    assert(conn);
+
+    if (!nnti_atomic_fetches(op)) {
+        if (!atomic_scratch_pop(&slot)) {
+            log_debug(nnti_debug_level, "too many non-fetching atomics in flight");
+            return(NNTI_ENOMEM);
+        }
+        scratch   =TRUE;
+        local_addr=(uint64_t)&transport_global_data.atomics[slot];
+        lkey      =transport_global_data.atomics_mr->lkey;
+    }
 
     if (config.use_wr_pool) {
         ib_wr=wr_pool_sendrecv_pop();
@@ -2851,8 +3760,7 @@ NNTI_result_t NNTI_ib_atomic_fop (
     }
     assert(ib_wr);
 
-    ib_wr->conn = get_conn_peer(peer_hdl);
-    assert(ib_wr->conn);
+    ib_wr->conn = conn;
 
     ib_wr->nnti_wr = wr;
 
@@ -2871,18 +3779,32 @@ NNTI_result_t NNTI_ib_atomic_fop (
     ib_wr->sq_wr_list =&ib_wr->sq_wr;
     ib_wr->sq_wr_count=1;
 
-    ib_wr->sq_wr.wr.atomic.rkey       =ib_wr->conn->atomics_rkey;
-    ib_wr->sq_wr.wr.atomic.remote_addr=ib_wr->conn->atomics_addr+(target_atomic*sizeof(int64_t));
-    ib_wr->sq_wr.wr.atomic.compare_add=operand;
-
-    ib_wr->sq_wr.opcode    =IBV_WR_ATOMIC_FETCH_AND_ADD;
+    ib_wr->atomic_op      =op;
+    ib_wr->atomic_operand =operand;
+    ib_wr->atomic_expected=0;
+    ib_wr->atomic_slot    =slot;
+    ib_wr->atomic_scratch =scratch;
+    ib_wr->atomic_emulated=((op != NNTI_ATOMIC_FADD) && (op != NNTI_ATOMIC_ADD));
+    ib_wr->atomic_vector  =NULL;
+
+    ib_wr->sq_wr.wr.atomic.rkey       =rkey;
+    ib_wr->sq_wr.wr.atomic.remote_addr=remote_addr;
+    if (ib_wr->atomic_emulated) {
+        // guess that the target is 0.  a wrong guess costs one more compare-swap.
+        ib_wr->sq_wr.wr.atomic.compare_add=ib_wr->atomic_expected;
+        ib_wr->sq_wr.wr.atomic.swap       =nnti_atomic_apply(op, ib_wr->atomic_expected, operand);
+        ib_wr->sq_wr.opcode               =IBV_WR_ATOMIC_CMP_AND_SWP;
+    } else {
+        ib_wr->sq_wr.wr.atomic.compare_add=operand;
+        ib_wr->sq_wr.opcode               =IBV_WR_ATOMIC_FETCH_AND_ADD;
+    }
     ib_wr->sq_wr.send_flags=IBV_SEND_SIGNALED;
 
     ib_wr->sge_count=1;
     ib_wr->sge_list=&ib_wr->sge;
-    ib_wr->sge_list[0].addr  =(uint64_t)&transport_global_data.atomics[result_atomic];
+    ib_wr->sge_list[0].addr  =local_addr;
     ib_wr->sge_list[0].length=sizeof(int64_t);
-    ib_wr->sge_list[0].lkey  =transport_global_data.atomics_mr->lkey;
+    ib_wr->sge_list[0].lkey  =lkey;
 
     ib_wr->sq_wr.wr_id   = (uint64_t)ib_wr->key;
     ib_wr->sq_wr.next    = NULL;
@@ -2890,8 +3812,8 @@ NNTI_result_t NNTI_ib_atomic_fop (
     ib_wr->sq_wr.num_sge = ib_wr->sge_count;
 
 
-    log_debug(nnti_debug_level, "sending to (%s, qp=%p, qpn=%d, sge.addr=%p, sge.length=%llu, sq_wr.ib_wr.rdma.rkey=0x%x, sq_wr.ib_wr.rdma.remote_addr=%p)",
-            peer_hdl->url,
+    log_debug(nnti_debug_level, "sending to (qpn=%d, qp=%p, qpn=%d, sge.addr=%p, sge.length=%llu, sq_wr.ib_wr.rdma.rkey=0x%x, sq_wr.ib_wr.rdma.remote_addr=%p)",
+            ib_wr->peer_qpn,
             ib_wr->qp,
             ib_wr->qpn,
             (void *)  ib_wr->sge.addr,
@@ -2907,7 +3829,7 @@ NNTI_result_t NNTI_ib_atomic_fop (
     wrmap[ib_wr->key] = ib_wr;
     nthread_unlock(&nnti_wrmap_lock);
 
-    wr->transport_id     =trans_hdl->id;
+    wr->transport_id     =transport_id;
     wr->reg_buf          =(NNTI_buffer_t*)NULL;
     wr->ops              =NNTI_BOP_ATOMICS;
     wr->result           =NNTI_OK;
@@ -2917,6 +3839,10 @@ NNTI_result_t NNTI_ib_atomic_fop (
     trios_start_timer(call_time);
     if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr, &bad_wr)) {
         log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        if (ib_wr->atomic_scratch) {
+            atomic_scratch_push(ib_wr->atomic_slot);
+            ib_wr->atomic_scratch=FALSE;
+        }
         rc=NNTI_EIO;
     }
     trios_stop_timer("NNTI_ib_send - ibv_post_send", call_time);
@@ -2927,14 +3853,16 @@ NNTI_result_t NNTI_ib_atomic_fop (
 }
 
 
-NNTI_result_t NNTI_ib_atomic_cswap (
-        const NNTI_transport_t *trans_hdl,
-        const NNTI_peer_t      *peer_hdl,
-        const uint64_t          target_atomic,
-        const uint64_t          result_atomic,
-        const int64_t           compare_operand,
-        const int64_t           swap_operand,
-        NNTI_work_request_t    *wr)
+static NNTI_result_t ib_atomic_cswap(
+        const NNTI_transport_id_t transport_id,
+        ib_connection            *conn,
+        const uint64_t            remote_addr,
+        const uint32_t            rkey,
+        const uint64_t            local_addr,
+        const uint32_t            lkey,
+        const int64_t             compare_operand,
+        const int64_t             swap_operand,
+        NNTI_work_request_t      *wr)
 {
     NNTI_result_t rc=NNTI_OK;
 
@@ -2946,9 +3874,9 @@ NNTI_result_t NNTI_ib_atomic_cswap (
 
     log_debug(nnti_debug_level, "enter");
 
-    assert(peer_hdl);
+    flush_send_chains();
 
-    log_level debug_level=nnti_debug_level;
+    assert(conn);
 
     if (config.use_wr_pool) {
         ib_wr=wr_pool_sendrecv_pop();
@@ -2959,8 +3887,7 @@ NNTI_result_t NNTI_ib_atomic_cswap (
     }
     assert(ib_wr);
 
-    ib_wr->conn = get_conn_peer(peer_hdl);
-    assert(ib_wr->conn);
+    ib_wr->conn = conn;
 
     ib_wr->nnti_wr = wr;
 
@@ -2976,11 +3903,15 @@ NNTI_result_t NNTI_ib_atomic_cswap (
 
     ib_wr->last_op=IB_OP_COMPARE_SWAP;
 
+    ib_wr->atomic_emulated=FALSE;
+    ib_wr->atomic_scratch =FALSE;
+    ib_wr->atomic_vector  =NULL;
+
     ib_wr->sq_wr_list =&ib_wr->sq_wr;
     ib_wr->sq_wr_count=1;
 
-    ib_wr->sq_wr.wr.atomic.rkey       =ib_wr->conn->atomics_rkey;
-    ib_wr->sq_wr.wr.atomic.remote_addr=ib_wr->conn->atomics_addr+(target_atomic*sizeof(int64_t));
+    ib_wr->sq_wr.wr.atomic.rkey       =rkey;
+    ib_wr->sq_wr.wr.atomic.remote_addr=remote_addr;
     ib_wr->sq_wr.wr.atomic.compare_add=compare_operand;
     ib_wr->sq_wr.wr.atomic.swap       =swap_operand;
 
@@ -2989,9 +3920,9 @@ NNTI_result_t NNTI_ib_atomic_cswap (
 
     ib_wr->sge_count=1;
     ib_wr->sge_list=&ib_wr->sge;
-    ib_wr->sge_list[0].addr  =(uint64_t)&transport_global_data.atomics[result_atomic];
+    ib_wr->sge_list[0].addr  =local_addr;
     ib_wr->sge_list[0].length=sizeof(int64_t);
-    ib_wr->sge_list[0].lkey  =transport_global_data.atomics_mr->lkey;
+    ib_wr->sge_list[0].lkey  =lkey;
 
     ib_wr->sq_wr.wr_id   = (uint64_t)ib_wr->key;
     ib_wr->sq_wr.next    = NULL;
@@ -2999,8 +3930,8 @@ NNTI_result_t NNTI_ib_atomic_cswap (
     ib_wr->sq_wr.num_sge = ib_wr->sge_count;
 
 
-    log_debug(nnti_debug_level, "sending to (%s, qp=%p, qpn=%d, sge.addr=%p, sge.length=%llu, sq_wr.ib_wr.rdma.rkey=0x%x, sq_wr.ib_wr.rdma.remote_addr=%p)",
-            peer_hdl->url,
+    log_debug(nnti_debug_level, "sending to (qpn=%d, qp=%p, qpn=%d, sge.addr=%p, sge.length=%llu, sq_wr.ib_wr.rdma.rkey=0x%x, sq_wr.ib_wr.rdma.remote_addr=%p)",
+            ib_wr->peer_qpn,
             ib_wr->qp,
             ib_wr->qpn,
             (void *)  ib_wr->sge.addr,
@@ -3016,7 +3947,7 @@ NNTI_result_t NNTI_ib_atomic_cswap (
     wrmap[ib_wr->key] = ib_wr;
     nthread_unlock(&nnti_wrmap_lock);
 
-    wr->transport_id     =trans_hdl->id;
+    wr->transport_id     =transport_id;
     wr->reg_buf          =(NNTI_buffer_t*)NULL;
     wr->ops              =NNTI_BOP_ATOMICS;
     wr->result           =NNTI_OK;
@@ -3036,90 +3967,467 @@ NNTI_result_t NNTI_ib_atomic_cswap (
 }
 
 
-/**
- * @brief Create a receive work request that can be used to wait for buffer
- * operations to complete.
- *
- */
-NNTI_result_t NNTI_ib_create_work_request (
-        NNTI_buffer_t        *reg_buf,
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_ib_atomic_fop (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *peer_hdl,
+        const uint64_t          target_atomic,
+        const uint64_t          result_atomic,
+        const int64_t           operand,
+        const NNTI_atomic_op_t  op,
+        NNTI_work_request_t    *wr)
 {
-    wr_queue_iter_t   iter;
-    ib_memory_handle *ib_mem_hdl=NULL;
-    ib_work_request  *ib_wr=NULL;
-
-    log_debug(nnti_debug_level, "enter (reg_buf=%p ; wr=%p)", reg_buf, wr);
-
-    ib_mem_hdl=IB_MEM_HDL(reg_buf);
-    assert(ib_mem_hdl);
-
-    nthread_lock(&ib_mem_hdl->wr_queue_lock);
-
-    for ( iter=ib_mem_hdl->wr_queue.begin() ; iter != ib_mem_hdl->wr_queue.end() ; ++iter ) {
-        if ((*iter)->nnti_wr == NULL) {
-            ib_wr=*iter;
-            break;
-        }
-    }
-    assert(ib_wr);
+    ib_connection *conn=NULL;
 
-    wr->transport_private=(uint64_t)ib_wr;
-    ib_wr->nnti_wr=wr;
+    assert(peer_hdl);
 
-    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+    conn=get_conn_peer(peer_hdl);
+    assert(conn);
+
+    return(ib_atomic_fop(
+            trans_hdl->id,
+            conn,
+            conn->atomics_addr+(target_atomic*sizeof(int64_t)),
+            conn->atomics_rkey,
+            (uint64_t)&transport_global_data.atomics[result_atomic],
+            transport_global_data.atomics_mr->lkey,
+            operand,
+            op,
+            wr));
+}
 
-    wr->transport_id     =reg_buf->transport_id;
-    wr->reg_buf          =reg_buf;
-    wr->ops              =reg_buf->ops;
-    wr->result           =NNTI_OK;
 
-    log_debug(nnti_debug_level, "assigned ib_work_request(%p) to NNTI_work_request(%p)", ib_wr, wr);
+NNTI_result_t NNTI_ib_atomic_cswap (
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *peer_hdl,
+        const uint64_t          target_atomic,
+        const uint64_t          result_atomic,
+        const int64_t           compare_operand,
+        const int64_t           swap_operand,
+        NNTI_work_request_t    *wr)
+{
+    ib_connection *conn=NULL;
 
-    log_debug(nnti_debug_level, "exit (reg_buf=%p ; wr=%p)", reg_buf, wr);
+    assert(peer_hdl);
 
-    return(NNTI_OK);
+    conn=get_conn_peer(peer_hdl);
+    assert(conn);
+
+    return(ib_atomic_cswap(
+            trans_hdl->id,
+            conn,
+            conn->atomics_addr+(target_atomic*sizeof(int64_t)),
+            conn->atomics_rkey,
+            (uint64_t)&transport_global_data.atomics[result_atomic],
+            transport_global_data.atomics_mr->lkey,
+            compare_operand,
+            swap_operand,
+            wr));
 }
 
 
 /**
- * @brief Disassociates a receive work request from a previous receive
- * and prepares it for reuse.
+ * @brief Perform a list of atomic operations on one peer.
  *
+ * Each update is its own atomic work request, but a window of them is
+ * posted with one call and completes with one event (see
+ * atomic_vector_post()).
  */
-NNTI_result_t NNTI_ib_clear_work_request (
-        NNTI_work_request_t  *wr)
+NNTI_result_t NNTI_ib_atomic_fopv (
+        const NNTI_transport_t     *trans_hdl,
+        const NNTI_peer_t          *peer_hdl,
+        const NNTI_atomic_update_t *updates,
+        const uint32_t              update_count,
+        NNTI_work_request_t        *wr)
 {
-    log_debug(nnti_debug_level, "enter (wr=%p)", wr);
-
-    wr->result           =NNTI_OK;
-    wr->transport_private=NULL;
-
-    log_debug(nnti_debug_level, "exit (wr=%p)", wr);
+    NNTI_result_t rc=NNTI_OK;
 
-    return(NNTI_OK);
-}
+    ib_connection    *conn =NULL;
+    ib_work_request  *ib_wr=NULL;
+    ib_atomic_vector *vec  =NULL;
 
+    uint32_t slots_needed=0;
+    uint32_t next_slot   =0;
+    int8_t   add_scratch =FALSE;
 
-/**
- * @brief Disassociates a receive work request from reg_buf.
- *
- */
-NNTI_result_t NNTI_ib_destroy_work_request (
-        NNTI_work_request_t  *wr)
-{
-    ib_memory_handle *ib_mem_hdl;
-    ib_work_request *ib_wr;
+    log_debug(nnti_debug_level, "enter (update_count=%u)", update_count);
 
-    log_debug(nnti_debug_level, "enter (wr=%p ; ib_wr=%p)", wr, ib_wr);
+    assert(peer_hdl);
 
-    ib_mem_hdl=IB_MEM_HDL(wr->reg_buf);
-    assert(ib_mem_hdl);
-    ib_wr=IB_WORK_REQUEST(wr);
+    conn=get_conn_peer(peer_hdl);
+    assert(conn);
 
-    if (!ib_wr) {
-        return(NNTI_OK);
-    }
+    flush_send_chains();
+
+    /* non-fetching adds ignore what they fetch, so they share scratch slot 0 */
+    for (uint32_t i=0;i<update_count;i++) {
+        if (nnti_atomic_fetches(updates[i].op)) {
+            continue;
+        }
+        if (updates[i].op == NNTI_ATOMIC_ADD) {
+            add_scratch=TRUE;
+        } else {
+            slots_needed++;
+        }
+    }
+    if (add_scratch) {
+        slots_needed++;
+        next_slot=1;
+    }
+
+    vec=(ib_atomic_vector *)calloc(1, sizeof(ib_atomic_vector));
+    assert(vec);
+    vec->updates=(ib_atomic_update *)calloc(update_count, sizeof(ib_atomic_update));
+    vec->sq_wrs =(struct ibv_send_wr *)calloc(update_count, sizeof(struct ibv_send_wr));
+    vec->sges   =(struct ibv_sge *)calloc(update_count, sizeof(struct ibv_sge));
+    vec->window =(uint32_t *)calloc(std::min(update_count, (uint32_t)IB_VECTOR_WINDOW), sizeof(uint32_t));
+    vec->slots  =(uint32_t *)calloc(slots_needed+1, sizeof(uint32_t));
+    assert(vec->updates && vec->sq_wrs && vec->sges && vec->window && vec->slots);
+    vec->count    =update_count;
+    vec->remaining=update_count;
+
+    if (config.use_wr_pool) {
+        ib_wr=wr_pool_sendrecv_pop();
+    } else {
+        ib_wr=(ib_work_request *)calloc(1, sizeof(ib_work_request));
+        log_debug(nnti_debug_level, "allocated ib_wr (wr=%p ; ib_wr=%p)", wr, ib_wr);
+        nthread_lock_init(&ib_wr->lock);
+    }
+    assert(ib_wr);
+
+    ib_wr->atomic_emulated=FALSE;
+    ib_wr->atomic_scratch =FALSE;
+    ib_wr->atomic_vector  =vec;
+
+    while (vec->slot_count < slots_needed) {
+        if (!atomic_scratch_pop(&vec->slots[vec->slot_count])) {
+            log_debug(nnti_debug_level, "too many non-fetching atomics in flight");
+            atomic_vector_free(ib_wr);
+            if (config.use_wr_pool) {
+                wr_pool_push(ib_wr);
+            } else {
+                free(ib_wr);
+            }
+            return(NNTI_ENOMEM);
+        }
+        vec->slot_count++;
+    }
+
+    ib_wr->conn = conn;
+
+    ib_wr->nnti_wr = wr;
+
+    ib_wr->key = nthread_counter_increment(&nnti_wrmap_counter);
+
+    ib_wr->state=NNTI_IB_WR_STATE_STARTED;
+
+    ib_wr->comp_channel=transport_global_data.data_comp_channel;
+    ib_wr->cq          =transport_global_data.data_cq;
+    ib_wr->qp          =ib_wr->conn->data_qp.qp;
+    ib_wr->qpn         =(uint64_t)ib_wr->conn->data_qp.qpn;
+    ib_wr->peer_qpn    =(uint64_t)ib_wr->conn->data_qp.peer_qpn;
+
+    ib_wr->last_op=IB_OP_FETCH_ADD;
+
+    ib_wr->sq_wr_list =&ib_wr->sq_wr;
+    ib_wr->sq_wr_count=1;
+    ib_wr->sge_list   =&ib_wr->sge;
+    ib_wr->sge_count  =1;
+
+    for (uint32_t i=0;i<update_count;i++) {
+        ib_atomic_update   *update=&vec->updates[i];
+        struct ibv_send_wr *sq_wr =&vec->sq_wrs[i];
+        struct ibv_sge     *sge   =&vec->sges[i];
+
+        update->op      =updates[i].op;
+        update->operand =updates[i].operand;
+        update->expected=0;
+        update->emulated=((update->op != NNTI_ATOMIC_FADD) && (update->op != NNTI_ATOMIC_ADD));
+
+        if (nnti_atomic_fetches(update->op)) {
+            sge->addr=(uint64_t)&transport_global_data.atomics[updates[i].result_atomic];
+        } else if (update->op == NNTI_ATOMIC_ADD) {
+            sge->addr=(uint64_t)&transport_global_data.atomics[vec->slots[0]];
+        } else {
+            sge->addr=(uint64_t)&transport_global_data.atomics[vec->slots[next_slot++]];
+        }
+        sge->length=sizeof(int64_t);
+        sge->lkey  =transport_global_data.atomics_mr->lkey;
+
+        sq_wr->wr.atomic.rkey       =conn->atomics_rkey;
+        sq_wr->wr.atomic.remote_addr=conn->atomics_addr+(updates[i].target_atomic*sizeof(int64_t));
+        if (update->emulated) {
+            // guess that the target is 0 like ib_atomic_fop() does.
+            sq_wr->wr.atomic.compare_add=update->expected;
+            sq_wr->wr.atomic.swap       =nnti_atomic_apply(update->op, update->expected, update->operand);
+            sq_wr->opcode               =IBV_WR_ATOMIC_CMP_AND_SWP;
+        } else {
+            sq_wr->wr.atomic.compare_add=update->operand;
+            sq_wr->opcode               =IBV_WR_ATOMIC_FETCH_AND_ADD;
+        }
+        sq_wr->wr_id  =(uint64_t)ib_wr->key;
+        sq_wr->sg_list=sge;
+        sq_wr->num_sge=1;
+    }
+
+    log_debug(nnti_debug_level, "wrmap[key(%lx)]=ib_wr(%p)", ib_wr->key, ib_wr);
+    nthread_lock(&nnti_wrmap_lock);
+    assert(wrmap.find(ib_wr->key) == wrmap.end());
+    wrmap[ib_wr->key] = ib_wr;
+    nthread_unlock(&nnti_wrmap_lock);
+
+    wr->transport_id     =trans_hdl->id;
+    wr->reg_buf          =(NNTI_buffer_t*)NULL;
+    wr->ops              =NNTI_BOP_ATOMICS;
+    wr->result           =NNTI_OK;
+    wr->transport_private=(uint64_t)ib_wr;
+
+    if (atomic_vector_post(ib_wr) != 0) {
+        atomic_vector_free(ib_wr);
+        rc=NNTI_EIO;
+    }
+
+    log_debug(nnti_debug_level, "exit");
+
+    return(rc);
+}
+
+
+/*
+ * Find the segment of <reg_buf> that holds the 64-bit variable at <offset>.
+ * Returns FALSE if the variable straddles two segments.
+ */
+static int8_t atomic_buffer_segment(
+        const NNTI_buffer_t *reg_buf,
+        const uint64_t       offset,
+        uint32_t            *segment,
+        uint64_t            *segment_offset)
+{
+    uint64_t start=0;
+
+    for (uint32_t i=0;i<reg_buf->buffer_segments.NNTI_remote_addr_array_t_len;i++) {
+        uint64_t size=reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[i].NNTI_remote_addr_t_u.ib.size;
+        if (offset < start+size) {
+            if (offset+sizeof(int64_t) > start+size) {
+                return(FALSE);
+            }
+            *segment       =i;
+            *segment_offset=offset-start;
+            return(TRUE);
+        }
+        start += size;
+    }
+
+    return(FALSE);
+}
+
+
+/*
+ * Resolve the remote target and the local result of a buffer atomic.
+ * Without a result buffer <local_addr> and <lkey> are left alone.
+ */
+static NNTI_result_t atomic_buffer_addrs(
+        const NNTI_buffer_t *target_buf,
+        const uint64_t       target_offset,
+        const NNTI_buffer_t *result_buf,
+        const uint64_t       result_offset,
+        uint64_t            *remote_addr,
+        uint32_t            *rkey,
+        uint64_t            *local_addr,
+        uint32_t            *lkey)
+{
+    NNTI_remote_addr_t *target_addr=NULL;
+    ib_memory_handle   *ib_mem_hdl =NULL;
+    uint32_t            segment;
+    uint64_t            segment_offset;
+
+    if (!atomic_buffer_segment(target_buf, target_offset, &segment, &segment_offset)) {
+        return(NNTI_EINVAL);
+    }
+    target_addr =&target_buf->buffer_segments.NNTI_remote_addr_array_t_val[segment];
+    *remote_addr=target_addr->NNTI_remote_addr_t_u.ib.buf+segment_offset;
+    *rkey       =target_addr->NNTI_remote_addr_t_u.ib.key;
+
+    if (result_buf != NULL) {
+        if (!atomic_buffer_segment(result_buf, result_offset, &segment, &segment_offset)) {
+            return(NNTI_EINVAL);
+        }
+        ib_mem_hdl=IB_MEM_HDL(result_buf);
+        assert(ib_mem_hdl);
+        *local_addr=(uint64_t)ib_mem_hdl->mr_list[segment]->addr+segment_offset;
+        *lkey      =ib_mem_hdl->mr_list[segment]->lkey;
+    }
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Perform an atomic operation on a variable in a registered buffer.
+ *
+ * FADD and ADD are a native fetch-add on the target.  The others are
+ * emulated with compare-swap like NNTI_ib_atomic_fop().
+ */
+NNTI_result_t NNTI_ib_atomic_fop_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           operand,
+        const NNTI_atomic_op_t  op,
+        NNTI_work_request_t    *wr)
+{
+    NNTI_result_t  rc=NNTI_OK;
+    ib_connection *conn=NULL;
+    uint64_t       remote_addr=0;
+    uint32_t       rkey=0;
+    uint64_t       local_addr=0;
+    uint32_t       lkey=0;
+
+    rc=atomic_buffer_addrs(target_buf, target_offset, result_buf, result_offset, &remote_addr, &rkey, &local_addr, &lkey);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    conn=get_conn_peer(&target_buf->buffer_owner);
+    assert(conn);
+
+    return(ib_atomic_fop(
+            target_buf->transport_id,
+            conn,
+            remote_addr,
+            rkey,
+            local_addr,
+            lkey,
+            operand,
+            op,
+            wr));
+}
+
+
+/**
+ * @brief Perform a compare-and-swap on a variable in a registered buffer.
+ */
+NNTI_result_t NNTI_ib_atomic_cswap_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           compare_operand,
+        const int64_t           swap_operand,
+        NNTI_work_request_t    *wr)
+{
+    NNTI_result_t  rc=NNTI_OK;
+    ib_connection *conn=NULL;
+    uint64_t       remote_addr=0;
+    uint32_t       rkey=0;
+    uint64_t       local_addr=0;
+    uint32_t       lkey=0;
+
+    rc=atomic_buffer_addrs(target_buf, target_offset, result_buf, result_offset, &remote_addr, &rkey, &local_addr, &lkey);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    conn=get_conn_peer(&target_buf->buffer_owner);
+    assert(conn);
+
+    return(ib_atomic_cswap(
+            target_buf->transport_id,
+            conn,
+            remote_addr,
+            rkey,
+            local_addr,
+            lkey,
+            compare_operand,
+            swap_operand,
+            wr));
+}
+
+
+/**
+ * @brief Create a receive work request that can be used to wait for buffer
+ * operations to complete.
+ *
+ */
+NNTI_result_t NNTI_ib_create_work_request (
+        NNTI_buffer_t        *reg_buf,
+        NNTI_work_request_t  *wr)
+{
+    wr_queue_iter_t   iter;
+    ib_memory_handle *ib_mem_hdl=NULL;
+    ib_work_request  *ib_wr=NULL;
+
+    log_debug(nnti_debug_level, "enter (reg_buf=%p ; wr=%p)", reg_buf, wr);
+
+    ib_mem_hdl=IB_MEM_HDL(reg_buf);
+    assert(ib_mem_hdl);
+
+    nthread_lock(&ib_mem_hdl->wr_queue_lock);
+
+    for ( iter=ib_mem_hdl->wr_queue.begin() ; iter != ib_mem_hdl->wr_queue.end() ; ++iter ) {
+        if ((*iter)->nnti_wr == NULL) {
+            ib_wr=*iter;
+            break;
+        }
+    }
+    assert(ib_wr);
+
+    wr->transport_private=(uint64_t)ib_wr;
+    ib_wr->nnti_wr=wr;
+
+    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+
+    wr->transport_id     =reg_buf->transport_id;
+    wr->reg_buf          =reg_buf;
+    wr->ops              =reg_buf->ops;
+    wr->result           =NNTI_OK;
+
+    log_debug(nnti_debug_level, "assigned ib_work_request(%p) to NNTI_work_request(%p)", ib_wr, wr);
+
+    log_debug(nnti_debug_level, "exit (reg_buf=%p ; wr=%p)", reg_buf, wr);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Disassociates a receive work request from a previous receive
+ * and prepares it for reuse.
+ *
+ */
+NNTI_result_t NNTI_ib_clear_work_request (
+        NNTI_work_request_t  *wr)
+{
+    log_debug(nnti_debug_level, "enter (wr=%p)", wr);
+
+    wr->result           =NNTI_OK;
+    wr->transport_private=NULL;
+
+    log_debug(nnti_debug_level, "exit (wr=%p)", wr);
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Disassociates a receive work request from reg_buf.
+ *
+ */
+NNTI_result_t NNTI_ib_destroy_work_request (
+        NNTI_work_request_t  *wr)
+{
+    ib_memory_handle *ib_mem_hdl;
+    ib_work_request *ib_wr;
+
+    log_debug(nnti_debug_level, "enter (wr=%p ; ib_wr=%p)", wr, ib_wr);
+
+    ib_mem_hdl=IB_MEM_HDL(wr->reg_buf);
+    assert(ib_mem_hdl);
+    ib_wr=IB_WORK_REQUEST(wr);
+
+    if (!ib_wr) {
+        return(NNTI_OK);
+    }
 
     if ((ib_wr->last_op == IB_OP_SEND_REQUEST)   ||
         (ib_wr->last_op == IB_OP_SEND_BUFFER)    ||
@@ -3131,6 +4439,8 @@ NNTI_result_t NNTI_ib_destroy_work_request (
 
     if (ib_wr->last_op == IB_OP_NEW_REQUEST) {
         if (ib_wr->state == NNTI_IB_WR_STATE_WAIT_COMPLETE) {
+            return_request_credits(get_conn_qpn(ib_wr->last_wc.qp_num), 1);
+
             repost_recv_work_request(wr, ib_wr);
 
             nthread_lock(&ib_mem_hdl->wr_queue_lock);
@@ -3299,6 +4609,8 @@ NNTI_result_t NNTI_ib_wait (
 
     log_debug(debug_level, "enter (wr=%p ; ib_wr=%p ; timeout=%d)", wr, IB_WORK_REQUEST(wr), timeout);
 
+    flush_send_chains();
+
     trios_start_timer(total_time);
 
     assert(wr);
@@ -3400,7 +4712,7 @@ NNTI_result_t NNTI_ib_wait (
             nthread_unlock(&nnti_wrmap_lock);
 
             if (config.use_wr_pool) {
-                wr_pool_sendrecv_push(ib_wr);
+                wr_pool_push(ib_wr);
             } else {
                 if (config.use_rdma_target_ack) {
                     unregister_ack(ib_wr);
@@ -3444,7 +4756,7 @@ NNTI_result_t NNTI_ib_wait (
                 nthread_unlock(&nnti_wrmap_lock);
 
                 if (config.use_wr_pool) {
-                    wr_pool_sendrecv_push(ib_wr);
+                    wr_pool_push(ib_wr);
                 } else {
                     if (config.use_rdma_target_ack) {
                         unregister_ack(ib_wr);
@@ -3509,6 +4821,8 @@ NNTI_result_t NNTI_ib_waitany (
 
     log_debug(debug_level, "enter");
 
+    flush_send_chains();
+
     trios_start_timer(total_time);
 
     assert(wr_list);
@@ -3633,7 +4947,7 @@ NNTI_result_t NNTI_ib_waitany (
             nthread_unlock(&nnti_wrmap_lock);
 
             if (config.use_wr_pool) {
-                wr_pool_sendrecv_push(IB_WORK_REQUEST(wr_list[*which]));
+                wr_pool_push(IB_WORK_REQUEST(wr_list[*which]));
             } else {
                 if (config.use_rdma_target_ack) {
                     unregister_ack(IB_WORK_REQUEST(wr_list[*which]));
@@ -3695,6 +5009,8 @@ NNTI_result_t NNTI_ib_waitall (
 
     log_debug(debug_level, "enter");
 
+    flush_send_chains();
+
     trios_start_timer(total_time);
 
     assert(wr_list);
@@ -3788,9 +5104,34 @@ NNTI_result_t NNTI_ib_waitall (
                     "end of NNTI_ib_waitall", status[i]);
         }
 
-        if (is_wr_complete(IB_WORK_REQUEST(wr_list[i]))) {
+        ib_wr=IB_WORK_REQUEST(wr_list[i]);
+
+        if (is_wr_complete(ib_wr)) {
+
+            ib_wr->state=NNTI_IB_WR_STATE_WAIT_COMPLETE;
+
+            if (wr_list[i]->ops == NNTI_BOP_ATOMICS) {
+                // atomics have no reg_buf.  clean up like NNTI_ib_wait() does.
+                nthread_lock(&nnti_wrmap_lock);
+                wrmap_iter_t m_victim=wrmap.find(ib_wr->key);
+                if (m_victim != wrmap.end()) {
+                    log_debug(nnti_debug_level, "erasing ib_wr=%p (key=%lx) from the wrmap", ib_wr, ib_wr->key);
+                    wrmap.erase(m_victim);
+                }
+                nthread_unlock(&nnti_wrmap_lock);
 
-            IB_WORK_REQUEST(wr_list[i])->state=NNTI_IB_WR_STATE_WAIT_COMPLETE;
+                if (config.use_wr_pool) {
+                    wr_pool_push(ib_wr);
+                } else {
+                    if (config.use_rdma_target_ack) {
+                        unregister_ack(ib_wr);
+                    }
+                    log_debug(nnti_debug_level, "freeing ib_wr=%p", ib_wr);
+                    free(ib_wr);
+                }
+                wr_list[i]->transport_private=(uint64_t)NULL;
+                continue;
+            }
 
             ib_mem_hdl=IB_MEM_HDL(wr_list[i]->reg_buf);
             assert(ib_mem_hdl);
@@ -3822,7 +5163,7 @@ NNTI_result_t NNTI_ib_waitall (
                 nthread_unlock(&nnti_wrmap_lock);
 
                 if (config.use_wr_pool) {
-                    wr_pool_sendrecv_push(IB_WORK_REQUEST(wr_list[i]));
+                    wr_pool_push(IB_WORK_REQUEST(wr_list[i]));
                 } else {
                     if (config.use_rdma_target_ack) {
                         unregister_ack(IB_WORK_REQUEST(wr_list[i]));
@@ -3848,35 +5189,413 @@ cleanup:
 
 
 /**
- * @brief Disable this transport.
- *
- * Shutdown the transport.  Any outstanding sends, gets and puts will be
- * canceled.  Any new transport requests will fail.
+ * @brief Take up to <tt>max_count</tt> received requests from a receive queue.
  *
+ * Completed receive work requests are claimed in the order they were posted.
+ * A claimed ib_wr is marked NNTI_IB_WR_STATE_WAIT_COMPLETE and bound to the
+ * caller's work request, so it is neither reposted nor handed out by
+ * NNTI_ib_create_work_request() until NNTI_ib_release_requests().
  */
-NNTI_result_t NNTI_ib_fini (
-        const NNTI_transport_t *trans_hdl)
+NNTI_result_t NNTI_ib_dequeue_requests (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count)
 {
-    NNTI_result_t rc=NNTI_OK;;
+    NNTI_result_t     nnti_rc=NNTI_OK;
+    NNTI_result_t     rc=NNTI_OK;
+    ib_memory_handle *ib_mem_hdl=NULL;
+    wr_queue_iter_t   iter;
+    uint32_t          n=0;
 
-    log_debug(nnti_debug_level, "enter");
+    long entry_time  =trios_get_time_ms();
+    long elapsed_time=0;
 
-    close_all_conn();
+    log_debug(nnti_debug_level, "enter (reg_buf=%p ; max_count=%u ; timeout=%d)", reg_buf, max_count, timeout);
 
-    if (config.use_wr_pool) {
-        rc=wr_pool_fini();
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "wr_pool_fini() failed: %d", rc);
-            rc=NNTI_EINVAL;
-        }
-    }
+    assert(reg_buf);
+    assert(wr_list);
+    assert(status_list);
 
-    close(transport_global_data.listen_sock);
-    transport_global_data.listen_name[0]='\0';
-    transport_global_data.listen_addr=0;
-    transport_global_data.listen_port=0;
+    *count=0;
 
-    ibv_destroy_comp_channel_wrapper(transport_global_data.data_comp_channel);
+    if (reg_buf->ops != NNTI_BOP_RECV_QUEUE) {
+        log_error(nnti_debug_level, "reg_buf(%p) is not a receive queue", reg_buf);
+        return(NNTI_EINVAL);
+    }
+
+    ib_mem_hdl=IB_MEM_HDL(reg_buf);
+    assert(ib_mem_hdl);
+
+    while (1) {
+        nthread_lock(&ib_mem_hdl->wr_queue_lock);
+        for (iter=ib_mem_hdl->wr_queue.begin() ; (iter != ib_mem_hdl->wr_queue.end()) && (n < max_count) ; ++iter) {
+            ib_work_request *ib_wr=*iter;
+
+            nthread_lock(&ib_wr->lock);
+            if ((ib_wr->nnti_wr == NULL) && (ib_wr->state == NNTI_IB_WR_STATE_RDMA_COMPLETE)) {
+                ib_wr->state  =NNTI_IB_WR_STATE_WAIT_COMPLETE;
+                ib_wr->nnti_wr=&wr_list[n];
+                wr_list[n++].transport_private=(uint64_t)ib_wr;
+            }
+            nthread_unlock(&ib_wr->lock);
+        }
+        nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+
+        if (n > 0) {
+            nnti_rc=NNTI_OK;
+            break;
+        }
+
+        elapsed_time=trios_get_time_ms() - entry_time;
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        rc=progress((timeout < 0) ? -1 : timeout-elapsed_time, NULL, 0);
+        if ((rc != NNTI_OK) && (rc != NNTI_ETIMEDOUT)) {
+            nnti_rc=rc;
+            break;
+        }
+    }
+
+    for (uint32_t i=0;i<n;i++) {
+        wr_list[i].transport_id     =reg_buf->transport_id;
+        wr_list[i].reg_buf          =reg_buf;
+        wr_list[i].ops              =reg_buf->ops;
+        wr_list[i].result           =NNTI_OK;
+
+        create_status(&wr_list[i], IB_WORK_REQUEST(&wr_list[i]), NNTI_OK, &status_list[i]);
+    }
+    *count=n;
+
+    log_debug(nnti_debug_level, "exit (count=%u)", n);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Return loaned request slots to the receive queue.
+ *
+ * Each slot is reposted to the SRQ exactly as NNTI_ib_destroy_work_request()
+ * does for a completed receive queue work request.
+ */
+NNTI_result_t NNTI_ib_release_requests (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    log_debug(nnti_debug_level, "enter (wr_count=%u)", wr_count);
+
+    for (uint32_t i=0;i<wr_count;i++) {
+        if (IB_WORK_REQUEST(&wr_list[i]) == NULL) {
+            continue;
+        }
+        rc=NNTI_ib_destroy_work_request(&wr_list[i]);
+        if (rc != NNTI_OK) {
+            log_error(nnti_debug_level, "failed to release wr_list[%u]: %d", i, rc);
+            break;
+        }
+    }
+
+    log_debug(nnti_debug_level, "exit");
+
+    return(rc);
+}
+
+
+/**
+ * @brief Bind a target buffer to a counter.
+ *
+ * The target only learns about puts and gets through the ACK records, so
+ * this requires TRIOS_NNTI_USE_RDMA_TARGET_ACK.  From then on the
+ * immediate of each operation bumps the counter and the buffer's receive
+ * is replaced on the spot (see counter_landed()).
+ */
+NNTI_result_t NNTI_ib_counter_bind (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter)
+{
+    ib_memory_handle *ib_mem_hdl=NULL;
+
+    log_debug(nnti_debug_level, "enter (reg_buf=%p ; counter=%p)", reg_buf, counter);
+
+    if (!config.use_rdma_target_ack) {
+        log_debug(nnti_debug_level, "target counters require TRIOS_NNTI_USE_RDMA_TARGET_ACK");
+        return(NNTI_ENOTSUP);
+    }
+    if (!(reg_buf->ops & NNTI_BOP_REMOTE_WRITE) &&
+        !(reg_buf->ops & NNTI_BOP_REMOTE_READ)) {
+        log_debug(nnti_debug_level, "reg_buf(%p) isn't an RDMA target (ops=%d)", reg_buf, reg_buf->ops);
+        return(NNTI_EINVAL);
+    }
+
+    ib_mem_hdl=IB_MEM_HDL(reg_buf);
+    assert(ib_mem_hdl);
+
+    nthread_lock(&ib_mem_hdl->wr_queue_lock);
+    ib_mem_hdl->counter=(counter != NULL) ? NNTI_COUNTER(counter) : NULL;
+    ib_mem_hdl->counter_streams.clear();
+    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+
+    log_debug(nnti_debug_level, "exit");
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Wait for a counter to reach a threshold.
+ *
+ * Counting happens while completions are processed, so this makes
+ * progress on behalf of no work request in particular until the counter
+ * gets there.
+ */
+NNTI_result_t NNTI_ib_counter_wait (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    NNTI_result_t rc=NNTI_OK;
+
+    nnti_counter *c=NNTI_COUNTER(counter);
+
+    long entry_time  =trios_get_time_ms();
+    long elapsed_time=0;
+
+    log_debug(nnti_debug_level, "enter (counter=%p ; threshold=%llu ; timeout=%d)", c, threshold, timeout);
+
+    flush_send_chains();
+
+    while ((uint64_t)nthread_counter_read(&c->value) < threshold) {
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        rc=progress(timeout-elapsed_time, NULL, 0);
+        if ((rc != NNTI_OK) && (rc != NNTI_ETIMEDOUT)) {
+            log_debug(nnti_debug_level, "progress() failed: %d", rc);
+            nnti_rc=rc;
+            break;
+        }
+
+        elapsed_time=(trios_get_time_ms() - entry_time);
+    }
+
+    *value=(uint64_t)nthread_counter_read(&c->value);
+
+    log_debug(nnti_debug_level, "exit (value=%llu ; nnti_rc=%d)", *value, nnti_rc);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Send a message to a peer without a work request.
+ *
+ * The transport's work request is counted against the connection and
+ * recycled as soon as it completes (see implicit_retire()).
+ */
+NNTI_result_t NNTI_ib_send_implicit (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl)
+{
+    return(NNTI_ib_send(peer_hdl, msg_hdl, dest_hdl, NULL));
+}
+
+
+/**
+ * @brief Transfer data to a peer without a work request.
+ *
+ */
+NNTI_result_t NNTI_ib_put_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
+{
+    return(ib_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, NULL, 0, NULL));
+}
+
+
+/**
+ * @brief Transfer data from a peer without a work request.
+ *
+ */
+NNTI_result_t NNTI_ib_get_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
+{
+    return(ib_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, NULL, 0, NULL));
+}
+
+
+/**
+ * @brief Wait for the implicit operations to a peer (or every peer) to complete.
+ *
+ * Makes progress until as many implicit operations have retired as have
+ * been issued.  A NULL <tt>peer_hdl</tt> waits on the global counts.
+ */
+NNTI_result_t NNTI_ib_flush (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    NNTI_result_t rc=NNTI_OK;
+
+    ib_connection *conn=NULL;
+    bool           done=false;
+
+    long entry_time  =trios_get_time_ms();
+    long elapsed_time=0;
+
+    log_debug(nnti_debug_level, "enter (peer_hdl=%p ; timeout=%d)", peer_hdl, timeout);
+
+    if (peer_hdl != NULL) {
+        conn=get_conn_peer(peer_hdl);
+        if (conn == NULL) {
+            log_debug(nnti_debug_level, "not connected to this peer");
+            return(NNTI_EINVAL);
+        }
+    }
+
+    // sends held in a chain haven't even been posted
+    flush_send_chains();
+
+    while (1) {
+        nthread_lock(&nnti_implicit_lock);
+        if (conn != NULL) {
+            done=(conn->implicit_retired == conn->implicit_issued);
+        } else {
+            done=(implicit_retired == implicit_issued);
+        }
+        nthread_unlock(&nnti_implicit_lock);
+        if (done) {
+            break;
+        }
+
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        // a failed completion retires its operation with the failure, so keep going until they all have
+        rc=progress(timeout-elapsed_time, NULL, 0);
+        if ((rc != NNTI_OK) && (rc != NNTI_ETIMEDOUT)) {
+            log_debug(nnti_debug_level, "progress() failed: %d", rc);
+        }
+
+        elapsed_time=(trios_get_time_ms() - entry_time);
+    }
+
+    if (done) {
+        // report (and forget) the first failure since the last flush
+        nthread_lock(&nnti_implicit_lock);
+        if (conn != NULL) {
+            nnti_rc=conn->implicit_result;
+            conn->implicit_result=NNTI_OK;
+        } else {
+            nnti_rc=implicit_result;
+            implicit_result=NNTI_OK;
+        }
+        nthread_unlock(&nnti_implicit_lock);
+    }
+
+    log_debug(nnti_debug_level, "exit (nnti_rc=%d)", nnti_rc);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Report the occupancy of the work request pools.
+ *
+ * <tt>rdma_stats</tt> covers the pool of requests with ACK records (puts
+ * and gets with use_rdma_target_ack, RDMA targets).  <tt>sendrecv_stats</tt>
+ * covers everything else.  Returns NNTI_ENOTSUP unless
+ * TRIOS_NNTI_USE_WR_POOL is set.
+ */
+NNTI_result_t NNTI_ib_get_wr_pool_stats (
+        nnti_wr_pool_stats *rdma_stats,
+        nnti_wr_pool_stats *sendrecv_stats)
+{
+    if (!ib_initialized || !config.use_wr_pool) {
+        return(NNTI_ENOTSUP);
+    }
+
+    if (rdma_stats != NULL) {
+        wr_pool_get_stats(&rdma_wr_pool, rdma_stats);
+    }
+    if (sendrecv_stats != NULL) {
+        wr_pool_get_stats(&sendrecv_wr_pool, sendrecv_stats);
+    }
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Disable this transport.
+ *
+ * Shutdown the transport.  Any outstanding sends, gets and puts will be
+ * canceled.  Any new transport requests will fail.
+ *
+ */
+NNTI_result_t NNTI_ib_fini (
+        const NNTI_transport_t *trans_hdl)
+{
+    NNTI_result_t rc=NNTI_OK;;
+
+    log_debug(nnti_debug_level, "enter");
+
+    close_all_conn();
+
+    if (config.use_wr_pool) {
+        rc=wr_pool_fini();
+        if (rc!=NNTI_OK) {
+            log_error(nnti_debug_level, "wr_pool_fini() failed: %d", rc);
+            rc=NNTI_EINVAL;
+        }
+    }
+
+    if (config.use_rdma_target_ack) {
+        teardown_ack_slab();
+    }
+
+    close(transport_global_data.listen_sock);
+    transport_global_data.listen_name[0]='\0';
+    transport_global_data.listen_addr=0;
+    transport_global_data.listen_port=0;
+
+    ibv_destroy_comp_channel_wrapper(transport_global_data.data_comp_channel);
     ibv_destroy_cq_wrapper(transport_global_data.data_cq);
     ibv_destroy_srq_wrapper(transport_global_data.data_srq);
 
@@ -3897,7 +5616,11 @@ NNTI_result_t NNTI_ib_fini (
     nthread_lock_fini(&nnti_conn_qpn_lock);
     nthread_lock_fini(&nnti_buf_bufhash_lock);
     nthread_lock_fini(&transport_global_data.atomics_lock);
-    nthread_lock_fini(&nnti_wr_pool_lock);
+    nthread_lock_fini(&nnti_ack_slab_lock);
+    nthread_lock_fini(&nnti_send_lock);
+    nthread_lock_fini(&nnti_implicit_lock);
+
+    nnti_credits_fini(&request_credits);
 
     ib_initialized=false;
 
@@ -3947,6 +5670,7 @@ static NNTI_result_t setup_request_channel(void)
         log_error(nnti_debug_level, "ibv_req_notify_cq failed");
         return NNTI_EIO;
     }
+    transport_global_data.req_cq_armed=true;
 
     /* use non-blocking IO on the async fd and completion fd */
     flags = fcntl(transport_global_data.ctx->async_fd, F_GETFL);
@@ -4010,6 +5734,7 @@ static NNTI_result_t setup_data_channel(void)
         log_error(nnti_debug_level, "ibv_req_notify_cq failed");
         return NNTI_EIO;
     }
+    transport_global_data.data_cq_armed=true;
 
     /* use non-blocking IO on the async fd and completion fd */
     flags = fcntl(transport_global_data.ctx->async_fd, F_GETFL);
@@ -4086,7 +5811,7 @@ static NNTI_result_t setup_atomics(void)
 
     log_debug(nnti_debug_level, "enter");
 
-    atomics_bytes=config.min_atomics_vars * sizeof(int64_t);
+    atomics_bytes=(config.min_atomics_vars + ATOMIC_SCRATCH_SLOTS) * sizeof(int64_t);
     trios_start_timer(callTime);
     transport_global_data.atomics=(int64_t*)aligned_malloc(atomics_bytes);
     if (transport_global_data.atomics == NULL) {
@@ -4095,6 +5820,13 @@ static NNTI_result_t setup_atomics(void)
     memset(transport_global_data.atomics, 0, atomics_bytes);
     trios_stop_timer("malloc and memset", callTime);
 
+    atomic_scratch_slots.clear();
+    atomic_callbacks.clear();
+    atomic_callbacks_watched=0;
+    for (uint32_t i=0;i<ATOMIC_SCRATCH_SLOTS;i++) {
+        atomic_scratch_slots.push_back(config.min_atomics_vars + i);
+    }
+
     trios_start_timer(callTime);
     mr = ibv_reg_mr_wrapper(transport_global_data.pd, transport_global_data.atomics, atomics_bytes, flags);
     if (!mr) {
@@ -4114,30 +5846,317 @@ static NNTI_result_t setup_atomics(void)
     return(NNTI_OK);
 }
 
-static void *aligned_malloc(
-        size_t size)
+static int8_t atomic_scratch_pop(
+        uint32_t *slot)
 {
-    int rc = 0;
-    void * ptr = NULL;
-
-#ifdef NO_MEMALIGN
-      ptr = malloc( size );
-#else
-      rc = posix_memalign( &ptr , 128 , size );
-#endif
+    int8_t rc=FALSE;
 
-    if (rc!=0) {
-        log_error(nnti_debug_level, "posix_memalign() failed: rc=%d (%s)", rc, strerror(errno));
-        ptr=NULL;
+    nthread_lock(&transport_global_data.atomics_lock);
+    if (!atomic_scratch_slots.empty()) {
+        *slot=atomic_scratch_slots.front();
+        atomic_scratch_slots.pop_front();
+        rc=TRUE;
     }
+    nthread_unlock(&transport_global_data.atomics_lock);
 
-    return ptr;
+    return(rc);
 }
 
-static struct ibv_mr *register_memory_segment(
-        void *buf,
-        uint64_t len,
-        enum ibv_access_flags access)
+static void atomic_scratch_push(
+        const uint32_t slot)
+{
+    nthread_lock(&transport_global_data.atomics_lock);
+    atomic_scratch_slots.push_back(slot);
+    nthread_unlock(&transport_global_data.atomics_lock);
+}
+
+/*
+ * An emulated atomic succeeded if its compare-swap fetched the value it
+ * expected.  Otherwise another process got there first, so try again
+ * against the value that was fetched.  Returns TRUE if the compare-swap
+ * was posted again.
+ */
+static int8_t atomic_retry(
+        ib_work_request *ib_wr)
+{
+    struct ibv_send_wr *bad_wr;
+
+    int64_t fetched=*(int64_t *)ib_wr->sge_list[0].addr;
+    if (fetched == ib_wr->atomic_expected) {
+        return(FALSE);
+    }
+
+    log_debug(nnti_debug_level, "compare-swap missed (ib_wr=%p ; expected=%ld ; fetched=%ld)",
+            ib_wr, ib_wr->atomic_expected, fetched);
+
+    ib_wr->atomic_expected            =fetched;
+    ib_wr->sq_wr.wr.atomic.compare_add=fetched;
+    ib_wr->sq_wr.wr.atomic.swap       =nnti_atomic_apply(ib_wr->atomic_op, fetched, ib_wr->atomic_operand);
+    if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->sq_wr, &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        ib_wr->nnti_wr->result=NNTI_EIO;
+        return(FALSE);
+    }
+
+    return(TRUE);
+}
+
+/*
+ * Post the next window of a vectored atomic.  A window holds up to
+ * IB_VECTOR_WINDOW updates that haven't landed, chained in one post with
+ * only the last one signaled.  Past the last update the cursor wraps
+ * around to pick up the compare-swaps that missed.
+ */
+static int atomic_vector_post(
+        ib_work_request *ib_wr)
+{
+    ib_atomic_vector   *vec=ib_wr->atomic_vector;
+    struct ibv_send_wr *bad_wr;
+
+    vec->window_count=0;
+    while (vec->window_count == 0) {
+        if (vec->cursor == vec->count) {
+            vec->cursor=0;
+        }
+        while ((vec->cursor < vec->count) && (vec->window_count < IB_VECTOR_WINDOW)) {
+            uint32_t i=vec->cursor++;
+            if (vec->updates[i].done) {
+                continue;
+            }
+            vec->sq_wrs[i].send_flags=0;
+            vec->sq_wrs[i].next      =NULL;
+            if (vec->window_count > 0) {
+                vec->sq_wrs[vec->window[vec->window_count-1]].next=&vec->sq_wrs[i];
+            }
+            vec->window[vec->window_count++]=i;
+        }
+    }
+    vec->sq_wrs[vec->window[vec->window_count-1]].send_flags=IBV_SEND_SIGNALED;
+
+    log_debug(nnti_debug_level, "posting %u of %u atomic updates (ib_wr=%p ; remaining=%u)",
+            vec->window_count, vec->count, ib_wr, vec->remaining);
+    if (ibv_post_send_wrapper(ib_wr->qp, &vec->sq_wrs[vec->window[0]], &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        return(-1);
+    }
+
+    return(0);
+}
+
+/*
+ * A window of a vectored atomic landed.  Retire the updates that are done
+ * and aim the emulated ones that missed at the value they fetched.
+ * Returns TRUE if another window was posted.
+ */
+static int8_t atomic_vector_next(
+        ib_work_request *ib_wr)
+{
+    ib_atomic_vector *vec=ib_wr->atomic_vector;
+
+    for (uint32_t w=0;w<vec->window_count;w++) {
+        uint32_t          i     =vec->window[w];
+        ib_atomic_update *update=&vec->updates[i];
+
+        if (update->emulated) {
+            int64_t fetched=*(int64_t *)vec->sges[i].addr;
+            if (fetched != update->expected) {
+                log_debug(nnti_debug_level, "compare-swap of update %u missed (ib_wr=%p ; expected=%ld ; fetched=%ld)",
+                        i, ib_wr, update->expected, fetched);
+                update->expected                    =fetched;
+                vec->sq_wrs[i].wr.atomic.compare_add=fetched;
+                vec->sq_wrs[i].wr.atomic.swap       =nnti_atomic_apply(update->op, fetched, update->operand);
+                continue;
+            }
+        }
+        update->done=TRUE;
+        vec->remaining--;
+    }
+
+    if (vec->remaining == 0) {
+        return(FALSE);
+    }
+    if (atomic_vector_post(ib_wr) != 0) {
+        ib_wr->nnti_wr->result=NNTI_EIO;
+        return(FALSE);
+    }
+
+    return(TRUE);
+}
+
+/*
+ * Return the scratch slots of a vectored atomic and free its lists.
+ */
+static void atomic_vector_free(
+        ib_work_request *ib_wr)
+{
+    ib_atomic_vector *vec=ib_wr->atomic_vector;
+
+    for (uint32_t i=0;i<vec->slot_count;i++) {
+        atomic_scratch_push(vec->slots[i]);
+    }
+
+    free(vec->updates);
+    free(vec->sq_wrs);
+    free(vec->sges);
+    free(vec->window);
+    free(vec->slots);
+    free(vec);
+    ib_wr->atomic_vector=NULL;
+}
+
+static NNTI_result_t set_atomic_callback(
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          local_atomic,
+        const int8_t            use_threshold,
+        const int64_t           threshold,
+        NNTI_callback_fn_t      cbfunc,
+        void                   *context)
+{
+    if (local_atomic >= config.min_atomics_vars) {
+        return(NNTI_EINVAL);
+    }
+
+    nthread_lock(&transport_global_data.atomics_lock);
+    if (cbfunc == NULL) {
+        atomic_callbacks.erase(local_atomic);
+    } else {
+        ib_atomic_callback *cb=&atomic_callbacks[local_atomic];
+        cb->cbfunc       =cbfunc;
+        cb->context      =context;
+        cb->trans_hdl    =trans_hdl;
+        cb->threshold    =threshold;
+        cb->use_threshold=use_threshold;
+        cb->last_value   =transport_global_data.atomics[local_atomic];
+    }
+    atomic_callbacks_watched=atomic_callbacks.size();
+    nthread_unlock(&transport_global_data.atomics_lock);
+
+    return(NNTI_OK);
+}
+
+/*
+ * Invoke the callback of every watched atomic variable whose value changed
+ * since the last look (or crossed its threshold).  The callbacks run after
+ * atomics_lock is dropped so they can read the variables.  Returns the
+ * number of callbacks invoked.
+ */
+static int check_atomic_callbacks(void)
+{
+    std::deque<std::pair<uint64_t, ib_atomic_callback> > fired;
+
+    if (atomic_callbacks_watched == 0) {
+        return(0);
+    }
+
+    nthread_lock(&transport_global_data.atomics_lock);
+    for (atomic_callback_iter_t iter=atomic_callbacks.begin(); iter != atomic_callbacks.end(); ++iter) {
+        ib_atomic_callback *cb   =&iter->second;
+        int64_t             value=*(volatile int64_t *)&transport_global_data.atomics[iter->first];
+
+        if (value == cb->last_value) {
+            continue;
+        }
+        if (!cb->use_threshold ||
+            ((cb->last_value < cb->threshold) && (value >= cb->threshold))) {
+            fired.push_back(*iter);
+        }
+        cb->last_value=value;
+    }
+    nthread_unlock(&transport_global_data.atomics_lock);
+
+    for (size_t i=0;i<fired.size();i++) {
+        fired[i].second.cbfunc(fired[i].second.trans_hdl, fired[i].first, fired[i].second.context);
+    }
+
+    return(fired.size());
+}
+
+static NNTI_result_t setup_ack_slab(void)
+{
+    trios_declare_timer(callTime);
+
+    struct ibv_mr *mr=NULL;
+
+    uint32_t slab_bytes;
+
+    log_debug(nnti_debug_level, "enter");
+
+    slab_bytes=ACK_SLAB_SLOTS * sizeof(ib_rdma_ack);
+    trios_start_timer(callTime);
+    ack_slab=(ib_rdma_ack *)aligned_malloc(slab_bytes);
+    if (ack_slab == NULL) {
+        return(NNTI_ENOMEM);
+    }
+    memset(ack_slab, 0, slab_bytes);
+    trios_stop_timer("malloc and memset", callTime);
+
+    mr=register_memory_segment(ack_slab, slab_bytes, (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
+    if (!mr) {
+        free(ack_slab);
+        ack_slab=NULL;
+        return(NNTI_ENOMEM);
+    }
+    ack_slab_mr=mr;
+
+    nthread_lock(&nnti_ack_slab_lock);
+    ack_slab_free.clear();
+    for (uint32_t i=0;i<ACK_SLAB_SLOTS;i++) {
+        ack_slab_free.push_back(i);
+    }
+    nthread_unlock(&nnti_ack_slab_lock);
+
+    log_debug(nnti_debug_level, "exit (slab==%p, slots==%d, mr==%p, lkey %x, rkey %x)...", ack_slab, ACK_SLAB_SLOTS, mr, mr->lkey, mr->rkey);
+
+    return(NNTI_OK);
+}
+
+static void teardown_ack_slab(void)
+{
+    log_debug(nnti_debug_level, "enter");
+
+    nthread_lock(&nnti_ack_slab_lock);
+    if (ack_slab_free.size() != ACK_SLAB_SLOTS) {
+        log_warn(nnti_debug_level, "%lu ACK slots are still in use", (uint64_t)(ACK_SLAB_SLOTS - ack_slab_free.size()));
+    }
+    ack_slab_free.clear();
+    nthread_unlock(&nnti_ack_slab_lock);
+
+    if (ack_slab_mr != NULL) {
+        unregister_memory_segment(ack_slab_mr);
+        ack_slab_mr=NULL;
+    }
+    if (ack_slab != NULL) {
+        free(ack_slab);
+        ack_slab=NULL;
+    }
+
+    log_debug(nnti_debug_level, "exit");
+}
+
+static void *aligned_malloc(
+        size_t size)
+{
+    int rc = 0;
+    void * ptr = NULL;
+
+#ifdef NO_MEMALIGN
+      ptr = malloc( size );
+#else
+      rc = posix_memalign( &ptr , 128 , size );
+#endif
+
+    if (rc!=0) {
+        log_error(nnti_debug_level, "posix_memalign() failed: rc=%d (%s)", rc, strerror(errno));
+        ptr=NULL;
+    }
+
+    return ptr;
+}
+
+static struct ibv_mr *register_memory_segment(
+        void *buf,
+        uint64_t len,
+        enum ibv_access_flags access)
 {
     NNTI_result_t rc=NNTI_OK; /* return code */
 
@@ -4187,24 +6206,48 @@ static int register_ack(ib_work_request *ib_wr)
 
     log_debug(nnti_debug_level, "enter");
 
-    len = sizeof(ib_wr->ack);
+    len = sizeof(ib_rdma_ack);
+
+    ib_wr->ack_slot=-1;
+    nthread_lock(&nnti_ack_slab_lock);
+    if (!ack_slab_free.empty()) {
+        ib_wr->ack_slot=ack_slab_free.front();
+        ack_slab_free.pop_front();
+    }
+    nthread_unlock(&nnti_ack_slab_lock);
+
+    if (ib_wr->ack_slot != -1) {
+        ib_wr->ack   =&ack_slab[ib_wr->ack_slot];
+        ib_wr->ack_mr=ack_slab_mr;
+        memset(ib_wr->ack, 0, len);
+
+        log_debug(nnti_debug_level, "exit (slot==%d, ack==%p)", ib_wr->ack_slot, ib_wr->ack);
+
+        return(rc);
+    }
+
+    /* the slab is exhausted.  fall back to registering the record embedded in the work request. */
+    log_debug(nnti_debug_level, "ACK slab is exhausted.  registering a private ACK record.");
+
+    ib_wr->ack=&ib_wr->ack_private;
 
     if (config.use_memset) {
         trios_start_timer(callTime);
-        memset(&ib_wr->ack, 0, len);
+        memset(ib_wr->ack, 0, len);
         trios_stop_timer("memset", callTime);
     }
     if (config.use_mlock) {
         trios_start_timer(callTime);
-        mlock(&ib_wr->ack, len);
+        mlock(ib_wr->ack, len);
         trios_stop_timer("mlock", callTime);
     }
 
     trios_start_timer(callTime);
-    mr = ibv_reg_mr_wrapper(transport_global_data.pd, &ib_wr->ack, len, (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
+    mr = ibv_reg_mr_wrapper(transport_global_data.pd, ib_wr->ack, len, (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
     if (!mr) {
         log_error(nnti_debug_level, "failed to register memory region");
         perror("errno");
+        ib_wr->ack=NULL;
         return errno;
     }
     trios_stop_timer("register", callTime);
@@ -4250,128 +6293,742 @@ static int unregister_ack(ib_work_request *ib_wr)
 
     log_debug(nnti_debug_level, "enter");
 
-    if (ib_wr->ack_mr!=NULL) {
+    if (ib_wr->ack_mr==NULL) {
+        log_debug(nnti_debug_level, "exit ib_wr(%p) - not registered", ib_wr);
+        return (rc);
+    }
+    if (ib_wr->pool!=NULL) {
+        log_debug(nnti_debug_level, "exit ib_wr(%p) - ACK belongs to the pool", ib_wr);
+        return (rc);
+    }
+
+    if (ib_wr->ack_slot != -1) {
+        nthread_lock(&nnti_ack_slab_lock);
+        ack_slab_free.push_back(ib_wr->ack_slot);
+        nthread_unlock(&nnti_ack_slab_lock);
+    } else {
         trios_start_timer(callTime);
         ibv_rc=ibv_dereg_mr_wrapper(ib_wr->ack_mr);
         if (ibv_rc != 0) {
             log_error(nnti_debug_level, "deregistering the ACK buffer failed");
         }
         trios_stop_timer("deregister", callTime);
-    }
 
-    if (config.use_mlock) {
-        trios_start_timer(callTime);
-        munlock(ib_wr->ack_mr->addr, ib_wr->ack_mr->length);
-        trios_stop_timer("munlock", callTime);
+        if (config.use_mlock) {
+            trios_start_timer(callTime);
+            munlock(ib_wr->ack, sizeof(ib_rdma_ack));
+            trios_stop_timer("munlock", callTime);
+        }
     }
 
+    ib_wr->ack     =NULL;
+    ib_wr->ack_mr  =NULL;
+    ib_wr->ack_slot=-1;
+
     log_debug(nnti_debug_level, "exit");
 
     return (rc);
 }
 
-static void send_ack (
+/*
+ * Find the ib_wr for each completion in wc_list.  Completions keyed by
+ * wc.wr_id are looked up in the work request map with a single
+ * acquisition of nnti_wrmap_lock.  The rest are target side events keyed
+ * by the hash of a buffer in wc.imm_data.
+ */
+static void decode_work_request_list(
+        const struct ibv_wc  *wc_list,
+        const int             wc_count,
+        ib_work_request     **ib_wr_list)
+{
+    NNTI_buffer_t    *event_buf=NULL;
+    ib_memory_handle *ib_mem_hdl=NULL;
+
+    log_debug(nnti_debug_level, "enter (wc_count=%d)", wc_count);
+
+    nthread_lock(&nnti_wrmap_lock);
+    for (int i=0;i<wc_count;i++) {
+        const struct ibv_wc *wc=&wc_list[i];
+
+        ib_wr_list[i]=NULL;
+
+        if ((wc->wr_id == IB_UNSIGNALED_WR_ID) || (wc->wr_id == IB_CREDIT_WR_ID)) {
+            // an unsignaled send failed or credits were returned.  neither has a work request.  process_wc_list() reports them.
+            continue;
+        }
+        if ((wc->opcode==IBV_WC_RECV) ||
+            (wc->opcode==IBV_WC_SEND) ||
+            (wc->imm_data == 0)) {
+            // a new request, a send request or I am the initiator, so wc.wr_id is a key to the work request map
+            wrmap_iter_t iter=wrmap.find(wc->wr_id);
+            if (iter != wrmap.end()) {
+                ib_wr_list[i]=iter->second;
+            }
+            assert(ib_wr_list[i]);
+        }
+    }
+    nthread_unlock(&nnti_wrmap_lock);
+
+    for (int i=0;i<wc_count;i++) {
+        const struct ibv_wc *wc=&wc_list[i];
+
+        if ((ib_wr_list[i] == NULL) && (wc->wr_id != IB_UNSIGNALED_WR_ID) && (wc->wr_id != IB_CREDIT_WR_ID)) {
+            log_debug(nnti_debug_level, "wc->imm_data != 0, so I am the target.  wc->imm_data is either the hash of a buffer or the hash of an ib_wr.");
+
+            // This is not a request buffer and I am the target, so wc.imm_data is the hash of either the buffer or the work request
+            event_buf = get_buf_bufhash(wc->imm_data);
+            assert(event_buf);
+            ib_mem_hdl=IB_MEM_HDL(event_buf);
+            assert(ib_mem_hdl);
+            ib_wr_list[i] = ib_mem_hdl->wr_queue.front();
+            assert(ib_wr_list[i]);
+        }
+        log_debug(nnti_debug_level, "wc_list[%d] -> ib_wr==%p", i, ib_wr_list[i]);
+    }
+
+    log_debug(nnti_debug_level, "exit");
+}
+
+static int cancel_wr(
         ib_work_request *ib_wr)
 {
-    struct ibv_send_wr *bad_wr;
+    NNTI_result_t rc=NNTI_OK;
 
-    NNTI_buffer_t    *reg_buf=NULL;
-    ib_memory_handle *ib_mem_hdl=NULL;
+    log_debug(nnti_debug_level, "enter (ib_wr=%p)", ib_wr);
 
-    reg_buf=ib_wr->reg_buf;
-    assert(reg_buf);
-    ib_mem_hdl=IB_MEM_HDL(reg_buf);
-    assert(ib_mem_hdl);
+    ib_wr->state=NNTI_IB_WR_STATE_WAIT_COMPLETE;
+    ib_wr->nnti_wr->result=NNTI_ECANCELED;
 
-    log_debug(nnti_debug_level, "sending ACK to (ack_sge.addr=%p, ack_sge.length=%llu, ack_sq_wr.ib_wr.rdma.rkey=%x, ack_sq_wr.ib_wr.rdma.remote_addr=%p)",
-            (void *)  ib_wr->ack_sge.addr,
-            (uint64_t)ib_wr->ack_sge.length,
-                      ib_wr->ack_sq_wr.wr.rdma.rkey,
-            (void *)  ib_wr->ack_sq_wr.wr.rdma.remote_addr);
+    log_debug(nnti_debug_level, "exit (ib_wr==%p)", ib_wr);
 
-    if (ibv_post_send_wrapper(ib_wr->qp, &ib_wr->ack_sq_wr, &bad_wr)) {
-        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+    return(rc);
+}
+
+/*
+ * Split the work requests of a large put/get into chunks of at most
+ * <chunk_size> bytes.  A chunk never spans two of the original
+ * work requests, so each chunk has one remote address and a slice of the
+ * original SGEs.  Every chunk is signaled and carries ib_wr->key, so the
+ * completions find this work request in the wrmap.  sq_wr_list and
+ * sge_list are replaced by the chunk lists and sq_wr_count by the number
+ * of chunks, which the put/get code then chains and posts a window at a time.
+ *
+ * <length> is the length of the whole transfer.  When the transfer is one
+ * work request with one SGE, it is used instead of the 32-bit SGE length.
+ */
+static void chunk_rdma_wrs(
+        ib_work_request *ib_wr,
+        uint64_t         length,
+        uint64_t         chunk_size)
+{
+    uint32_t chunk_count=0;
+    uint32_t sge_count=0;
+
+    struct ibv_send_wr *chunk_wr_list=NULL;
+    struct ibv_sge     *chunk_sge_list=NULL;
+
+    log_debug(nnti_debug_level, "enter (ib_wr=%p ; length=%llu ; chunk_size=%llu)", ib_wr, length, chunk_size);
+
+    /* count the chunks and the SGE slices they need */
+    for (uint32_t i=0;i<ib_wr->sq_wr_count;i++) {
+        uint64_t in_chunk=chunk_size;
+        for (int j=0;j<ib_wr->sq_wr_list[i].num_sge;j++) {
+            uint64_t left=ib_wr->sq_wr_list[i].sg_list[j].length;
+            if ((ib_wr->sq_wr_count == 1) && (ib_wr->sq_wr_list[i].num_sge == 1)) {
+                left=length;
+            }
+            while (left > 0) {
+                if (in_chunk == chunk_size) {
+                    chunk_count++;
+                    in_chunk=0;
+                }
+                uint64_t take=chunk_size - in_chunk;
+                if (take > left) {
+                    take=left;
+                }
+                sge_count++;
+                in_chunk += take;
+                left     -= take;
+            }
+        }
     }
 
-    return;
+    chunk_wr_list =(struct ibv_send_wr *)calloc(chunk_count, sizeof(struct ibv_send_wr));
+    chunk_sge_list=(struct ibv_sge *)calloc(sge_count, sizeof(struct ibv_sge));
+    assert(chunk_wr_list);
+    assert(chunk_sge_list);
+
+    /* fill them in */
+    struct ibv_send_wr *chunk=NULL;
+    struct ibv_sge     *sge  =chunk_sge_list;
+    for (uint32_t i=0;i<ib_wr->sq_wr_count;i++) {
+        struct ibv_send_wr *orig=&ib_wr->sq_wr_list[i];
+        uint64_t in_chunk   =chunk_size;
+        uint64_t remote_addr=orig->wr.rdma.remote_addr;
+        for (int j=0;j<orig->num_sge;j++) {
+            uint64_t addr=orig->sg_list[j].addr;
+            uint64_t left=orig->sg_list[j].length;
+            if ((ib_wr->sq_wr_count == 1) && (orig->num_sge == 1)) {
+                left=length;
+            }
+            while (left > 0) {
+                if (in_chunk == chunk_size) {
+                    chunk=(chunk == NULL) ? chunk_wr_list : chunk+1;
+                    chunk->opcode             =orig->opcode;
+                    chunk->send_flags         =IBV_SEND_SIGNALED;
+                    chunk->wr_id              =(uint64_t)ib_wr->key;
+                    chunk->imm_data           =orig->imm_data;
+                    chunk->wr.rdma.rkey       =orig->wr.rdma.rkey;
+                    chunk->wr.rdma.remote_addr=remote_addr;
+                    chunk->sg_list            =sge;
+                    chunk->num_sge            =0;
+                    chunk->next               =NULL;
+                    in_chunk=0;
+                }
+                uint64_t take=chunk_size - in_chunk;
+                if (take > left) {
+                    take=left;
+                }
+                sge->addr  =addr;
+                sge->length=take;
+                sge->lkey  =orig->sg_list[j].lkey;
+                sge++;
+                chunk->num_sge++;
+
+                addr        += take;
+                remote_addr += take;
+                in_chunk    += take;
+                left        -= take;
+            }
+        }
+    }
+
+    /*
+     * a transfer that needed several work requests registered each of them in
+     * the wrmap.  the chunks all use one key instead.
+     */
+    nthread_lock(&nnti_wrmap_lock);
+    if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
+        for (uint32_t i=0;i<ib_wr->sq_wr_count;i++) {
+            wrmap_iter_t victim=wrmap.find(ib_wr->sq_wr_list[i].wr_id);
+            if (victim != wrmap.end()) {
+                wrmap.erase(victim);
+            }
+        }
+        ib_wr->key = nthread_counter_increment(&nnti_wrmap_counter);
+        for (uint32_t i=0;i<chunk_count;i++) {
+            chunk_wr_list[i].wr_id=(uint64_t)ib_wr->key;
+        }
+        assert(wrmap.find(ib_wr->key) == wrmap.end());
+        wrmap[ib_wr->key] = ib_wr;
+    }
+    nthread_unlock(&nnti_wrmap_lock);
+
+    if (ib_wr->sge_list != &ib_wr->sge) {
+        free(ib_wr->sge_list);
+    }
+    if (ib_wr->sq_wr_list != &ib_wr->sq_wr) {
+        free(ib_wr->sq_wr_list);
+    }
+
+    ib_wr->sq_wr_list  =chunk_wr_list;
+    ib_wr->sq_wr_count =chunk_count;
+    ib_wr->sge_list    =chunk_sge_list;
+    ib_wr->sge_count   =sge_count;
+    ib_wr->chunk_count =chunk_count;
+    ib_wr->chunk_window=config.rdma_chunk_window;
+    if ((ib_wr->chunk_window == 0) || (ib_wr->chunk_window > chunk_count)) {
+        ib_wr->chunk_window=chunk_count;
+    }
+    ib_wr->chunk_posted=0;
+
+    log_debug(nnti_debug_level, "exit (ib_wr=%p ; chunk_count=%u ; sge_count=%u ; chunk_window=%u)",
+            ib_wr, chunk_count, sge_count, ib_wr->chunk_window);
+}
+
+/*
+ * A chunk completed, so there is room in the window for another one.  The
+ * last chunk of a get is still chained to the fenced ACK, which goes out
+ * with it.  Called with ib_wr->lock held.
+ */
+static int chunk_post_next(
+        ib_work_request *ib_wr)
+{
+    int rc=0;
+    struct ibv_send_wr *bad_wr=NULL;
+
+    if (ib_wr->chunk_posted == ib_wr->chunk_count) {
+        return(0);
+    }
+
+    struct ibv_send_wr *chunk=&ib_wr->sq_wr_list[ib_wr->chunk_posted];
+    if (ib_wr->chunk_posted < ib_wr->chunk_count-1) {
+        chunk->next=NULL;
+    }
+
+    log_debug(nnti_debug_level, "posting chunk %u of %u (ib_wr=%p)", ib_wr->chunk_posted, ib_wr->chunk_count, ib_wr);
+    if (ibv_post_send_wrapper(ib_wr->qp, chunk, &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post chunk %u of %u: %s", ib_wr->chunk_posted, ib_wr->chunk_count, strerror(errno));
+        chunk_free(ib_wr);
+        return(-1);
+    }
+    ib_wr->chunk_posted++;
+
+    if (ib_wr->chunk_posted == ib_wr->chunk_count) {
+        chunk_free(ib_wr);
+    }
+
+    return(rc);
 }
 
-static ib_work_request *decode_work_request(
+/*
+ * Release the chunk lists.  Posted work requests are copied by the HCA,
+ * so this is safe once the last chunk is posted.
+ */
+static void chunk_free(
+        ib_work_request *ib_wr)
+{
+    free(ib_wr->sq_wr_list);
+    free(ib_wr->sge_list);
+    ib_wr->sq_wr_list  =NULL;
+    ib_wr->sge_list    =NULL;
+    ib_wr->chunk_posted=ib_wr->chunk_count;
+}
+
+/*
+ * Find the segment of <hdl> that holds <offset>.  On return <offset> is
+ * relative to the segment and <remaining> is the number of bytes from
+ * there to the end of the segment.
+ */
+static uint32_t find_segment(
+        const NNTI_buffer_t *hdl,
+        uint64_t            *offset,
+        uint64_t            *remaining)
+{
+    const NNTI_remote_addr_t *seg=hdl->buffer_segments.NNTI_remote_addr_array_t_val;
+    uint32_t                  i  =0;
+
+    while ((i < hdl->buffer_segments.NNTI_remote_addr_array_t_len-1) &&
+           (*offset >= seg[i].NNTI_remote_addr_t_u.ib.size)) {
+        *offset -= seg[i].NNTI_remote_addr_t_u.ib.size;
+        i++;
+    }
+    *remaining=seg[i].NNTI_remote_addr_t_u.ib.size - *offset;
+
+    return(i);
+}
+
+/*
+ * Build the work requests of a vectored put (<is_put> is TRUE) or get.
+ * Each region is cut where it crosses a segment boundary of either buffer.
+ * A piece that continues the remote range of the work request before it
+ * is added to that work request, growing its last SGE if the local memory
+ * is contiguous too, or as a new SGE otherwise.  Every work request is
+ * signaled and carries ib_wr->key.  Long lists go out a window at a time,
+ * like the chunks of a large transfer (see chunk_rdma_wrs()).
+ */
+static void vector_rdma_wrs(
+        ib_work_request     *ib_wr,
+        const NNTI_buffer_t *local_hdl,
+        const NNTI_buffer_t *remote_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        const int8_t         is_put)
+{
+    ib_memory_handle *ib_mem_hdl=IB_MEM_HDL(local_hdl);
+
+    uint32_t piece_count=0;
+    uint32_t wr_count   =0;
+    uint32_t sge_count  =0;
+    uint64_t wr_length  =0;
+
+    struct ibv_send_wr *vec_wr=NULL;
+
+    log_debug(nnti_debug_level, "enter (ib_wr=%p ; iov_count=%u ; is_put=%d)", ib_wr, iov_count, is_put);
+
+    /* every piece needs at most one work request and one SGE */
+    for (uint32_t i=0;i<iov_count;i++) {
+        uint64_t local_offset =(is_put == TRUE) ? iov[i].src_offset  : iov[i].dest_offset;
+        uint64_t remote_offset=(is_put == TRUE) ? iov[i].dest_offset : iov[i].src_offset;
+        uint64_t left=iov[i].length;
+        while (left > 0) {
+            uint64_t local_segment_offset =local_offset;
+            uint64_t remote_segment_offset=remote_offset;
+            uint64_t local_remaining, remote_remaining;
+            find_segment(local_hdl, &local_segment_offset, &local_remaining);
+            find_segment(remote_hdl, &remote_segment_offset, &remote_remaining);
+
+            uint64_t take=std::min(std::min(left, IB_VECTOR_MAX_LENGTH), std::min(local_remaining, remote_remaining));
+            piece_count++;
+            local_offset  += take;
+            remote_offset += take;
+            left          -= take;
+        }
+    }
+
+    ib_wr->sq_wr_list=(struct ibv_send_wr *)calloc(piece_count, sizeof(struct ibv_send_wr));
+    ib_wr->sge_list  =(struct ibv_sge *)calloc(piece_count, sizeof(struct ibv_sge));
+    assert(ib_wr->sq_wr_list);
+    assert(ib_wr->sge_list);
+
+    ib_wr->key = nthread_counter_increment(&nnti_wrmap_counter);
+
+    for (uint32_t i=0;i<iov_count;i++) {
+        uint64_t local_offset =(is_put == TRUE) ? iov[i].src_offset  : iov[i].dest_offset;
+        uint64_t remote_offset=(is_put == TRUE) ? iov[i].dest_offset : iov[i].src_offset;
+        uint64_t left=iov[i].length;
+        while (left > 0) {
+            uint64_t local_segment_offset =local_offset;
+            uint64_t remote_segment_offset=remote_offset;
+            uint64_t local_remaining, remote_remaining;
+            uint32_t local_segment =find_segment(local_hdl, &local_segment_offset, &local_remaining);
+            uint32_t remote_segment=find_segment(remote_hdl, &remote_segment_offset, &remote_remaining);
+
+            uint64_t take=std::min(std::min(left, IB_VECTOR_MAX_LENGTH), std::min(local_remaining, remote_remaining));
+
+            const NNTI_remote_addr_t *remote=&remote_hdl->buffer_segments.NNTI_remote_addr_array_t_val[remote_segment];
+            uint64_t addr       =(uint64_t)ib_mem_hdl->mr_list[local_segment]->addr + local_segment_offset;
+            uint32_t lkey       =ib_mem_hdl->mr_list[local_segment]->lkey;
+            uint64_t remote_addr=remote->NNTI_remote_addr_t_u.ib.buf + remote_segment_offset;
+            uint32_t rkey       =remote->NNTI_remote_addr_t_u.ib.key;
+
+            int8_t continues=((vec_wr != NULL) &&
+                              (vec_wr->wr.rdma.rkey == rkey) &&
+                              (vec_wr->wr.rdma.remote_addr + wr_length == remote_addr) &&
+                              (wr_length + take <= IB_VECTOR_MAX_LENGTH));
+            struct ibv_sge *last_sge=(vec_wr != NULL) ? &vec_wr->sg_list[vec_wr->num_sge-1] : NULL;
+
+            if (continues && (last_sge->lkey == lkey) && (last_sge->addr + last_sge->length == addr)) {
+                last_sge->length += take;
+            } else if (continues && (vec_wr->num_sge < IB_VECTOR_MAX_SGE)) {
+                ib_wr->sge_list[sge_count].addr  =addr;
+                ib_wr->sge_list[sge_count].length=take;
+                ib_wr->sge_list[sge_count].lkey  =lkey;
+                sge_count++;
+                vec_wr->num_sge++;
+            } else {
+                vec_wr=&ib_wr->sq_wr_list[wr_count++];
+                ib_wr->sge_list[sge_count].addr  =addr;
+                ib_wr->sge_list[sge_count].length=take;
+                ib_wr->sge_list[sge_count].lkey  =lkey;
+
+                vec_wr->opcode             =(is_put == TRUE) ? IBV_WR_RDMA_WRITE : IBV_WR_RDMA_READ;
+                vec_wr->send_flags         =IBV_SEND_SIGNALED;
+                vec_wr->wr_id              =(uint64_t)ib_wr->key;
+                vec_wr->imm_data           =hash6432shift((uint64_t)remote_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.buf);
+                vec_wr->wr.rdma.rkey       =rkey;
+                vec_wr->wr.rdma.remote_addr=remote_addr;
+                vec_wr->sg_list            =&ib_wr->sge_list[sge_count];
+                vec_wr->num_sge            =1;
+                vec_wr->next               =NULL;
+                sge_count++;
+                wr_length=0;
+            }
+            wr_length += take;
+
+            local_offset  += take;
+            remote_offset += take;
+            left          -= take;
+        }
+    }
+
+    log_debug(nnti_debug_level, "wrmap[key(%lx)]=ib_wr(%p)", ib_wr->key, ib_wr);
+    nthread_lock(&nnti_wrmap_lock);
+    assert(wrmap.find(ib_wr->key) == wrmap.end());
+    wrmap[ib_wr->key] = ib_wr;
+    nthread_unlock(&nnti_wrmap_lock);
+
+    ib_wr->sq_wr_count =wr_count;
+    ib_wr->sge_count   =sge_count;
+    ib_wr->chunk_count =wr_count;
+    ib_wr->chunk_window=std::min(wr_count, (uint32_t)IB_VECTOR_WINDOW);
+    ib_wr->chunk_posted=0;
+
+    log_debug(nnti_debug_level, "exit (ib_wr=%p ; pieces=%u ; wr_count=%u ; sge_count=%u)",
+            ib_wr, piece_count, wr_count, sge_count);
+}
+
+/*
+ * Count an implicit operation against its connection before it is posted.
+ */
+static void implicit_issue(
+        ib_work_request *ib_wr)
+{
+    // a pooled work request may still hold the result of its last implicit operation
+    ib_wr->implicit_wr.result=NNTI_OK;
+
+    nthread_lock(&nnti_implicit_lock);
+    ib_wr->conn->implicit_issued++;
+    implicit_issued++;
+    nthread_unlock(&nnti_implicit_lock);
+}
+
+/*
+ * The initiator is done with an implicit operation it just posted.  From
+ * here on the completion retires it, unless it already completed (or
+ * failed to post) and this has to.
+ */
+static void implicit_arm(
+        ib_work_request *ib_wr,
+        NNTI_result_t    rc)
+{
+    bool retire=false;
+
+    nthread_lock(&ib_wr->lock);
+    if (rc != NNTI_OK) {
+        ib_wr->state             =NNTI_IB_WR_STATE_WAIT_COMPLETE;
+        ib_wr->implicit_wr.result=rc;
+    }
+    ib_wr->implicit=TRUE;
+    retire=((ib_wr->state==NNTI_IB_WR_STATE_RDMA_COMPLETE) || (ib_wr->state==NNTI_IB_WR_STATE_WAIT_COMPLETE));
+    nthread_unlock(&ib_wr->lock);
+
+    if (retire) {
+        implicit_retire(ib_wr);
+    }
+}
+
+/*
+ * An implicit operation completed.  Nobody will wait on it, so recycle the
+ * work request like NNTI_ib_wait() would and count it as retired.
+ */
+static void implicit_retire(
+        ib_work_request *ib_wr)
+{
+    ib_connection *conn  =ib_wr->conn;
+    NNTI_result_t  result=ib_wr->implicit_wr.result;
+
+    log_debug(nnti_debug_level, "retiring implicit ib_wr=%p (result=%d)", ib_wr, result);
+
+    nthread_lock(&nnti_wrmap_lock);
+    wrmap_iter_t m_victim=wrmap.find(ib_wr->key);
+    if (m_victim != wrmap.end()) {
+        log_debug(nnti_debug_level, "erasing ib_wr=%p (key=%lx) from the wrmap", ib_wr, ib_wr->key);
+        wrmap.erase(m_victim);
+    }
+    nthread_unlock(&nnti_wrmap_lock);
+
+    if (config.use_wr_pool) {
+        wr_pool_push(ib_wr);
+    } else {
+        if (config.use_rdma_target_ack) {
+            unregister_ack(ib_wr);
+        }
+        log_debug(nnti_debug_level, "freeing ib_wr=%p", ib_wr);
+        free(ib_wr);
+    }
+
+    nthread_lock(&nnti_implicit_lock);
+    conn->implicit_retired++;
+    implicit_retired++;
+    nthread_unlock(&nnti_implicit_lock);
+
+    implicit_fail(conn, result);
+}
+
+/*
+ * An unsignaled send to <conn> (NULL if the connection is unknown) failed
+ * after NNTI_ib_send() reported it complete.  The next send to the peer
+ * returns the failure, and so does the next flush in case it was implicit.
+ */
+static void fail_unsignaled(
+        ib_connection *conn,
+        NNTI_result_t  result)
+{
+    if (conn != NULL) {
+        nthread_lock(&nnti_send_lock);
+        if (conn->send_result == NNTI_OK) {
+            conn->send_result=result;
+        }
+        nthread_unlock(&nnti_send_lock);
+    }
+    implicit_fail(conn, result);
+}
+
+/*
+ * Report (and forget) the failure of an unsignaled send to <conn>.
+ */
+static NNTI_result_t take_send_result(
+        ib_connection *conn)
+{
+    NNTI_result_t result=NNTI_OK;
+
+    nthread_lock(&nnti_send_lock);
+    result=conn->send_result;
+    conn->send_result=NNTI_OK;
+    nthread_unlock(&nnti_send_lock);
+
+    return(result);
+}
+
+/*
+ * Keep the first failure of an implicit operation to <conn> (NULL if the
+ * connection is unknown) and to any peer until a flush reports it.
+ */
+static void implicit_fail(
+        ib_connection *conn,
+        NNTI_result_t  result)
+{
+    if (result == NNTI_OK) {
+        return;
+    }
+
+    nthread_lock(&nnti_implicit_lock);
+    if ((conn != NULL) && (conn->implicit_result == NNTI_OK)) {
+        conn->implicit_result=result;
+    }
+    if (implicit_result == NNTI_OK) {
+        implicit_result=result;
+    }
+    nthread_unlock(&nnti_implicit_lock);
+}
+
+/*
+ * Post the SRQ receive of a target work request again right away, as long
+ * as the SRQ isn't already half full.
+ */
+static void replace_srq_recv(
+        ib_work_request *ib_wr)
+{
+    int ibv_rc=0;
+    struct ibv_recv_wr *bad_wr=NULL;
+
+    if (transport_global_data.data_srq_count < (transport_global_data.srq_count/2)) {
+        ibv_rc=ibv_post_srq_recv_wrapper(transport_global_data.data_srq, &ib_wr->rq_wr, &bad_wr);
+        if (ibv_rc) {
+            log_error(nnti_debug_level, "failed to post SRQ recv (rq_wr=%p ; bad_wr=%p): %s",
+                    &ib_wr->rq_wr, bad_wr, strerror(ibv_rc));
+        } else {
+            transport_global_data.data_srq_count++;
+            log_debug(nnti_debug_level, "transport_global_data.data_srq_count==%ld", transport_global_data.data_srq_count);
+        }
+    }
+}
+
+/*
+ * An immediate arrived for the target buffer of ib_wr.  If the buffer is
+ * bound to a counter, count the operation, replace the SRQ receive it
+ * consumed and leave the work request posted, so no event is raised.  A
+ * streaming put is counted when its last chunk lands.  Chunks of one
+ * initiator arrive in order on its QP, so the chunks still to land are
+ * tracked per QP and streams from several initiators don't mix.  Returns
+ * FALSE if the buffer isn't bound.
+ */
+static int8_t counter_landed(
+        ib_work_request     *ib_wr,
         const struct ibv_wc *wc)
 {
-    ib_connection   *conn=NULL;
-    ib_work_request *ib_wr=NULL;
-    NNTI_buffer_t   *event_buf=NULL;
-    ib_memory_handle *ib_mem_hdl=NULL;
+    int8_t counted=TRUE;
 
-    log_debug(nnti_debug_level, "enter");
-
-    if (wc->opcode==IBV_WC_RECV) {
-        log_debug(nnti_debug_level, "wc->opcode is IBV_WC_RECV, so this is a new request.  wc.wr_id is a key to the work request map.");
-
-//        ib_mem_hdl=IB_MEM_HDL(transport_global_data.req_queue.reg_buf);
-//        assert(ib_mem_hdl);
+    ib_memory_handle *ib_mem_hdl=IB_MEM_HDL(ib_wr->reg_buf);
+    assert(ib_mem_hdl);
 
-        nthread_lock(&nnti_wrmap_lock);
-        if (wrmap.find(wc->wr_id) != wrmap.end()) {
-            ib_wr = wrmap[wc->wr_id];
+    nthread_lock(&ib_mem_hdl->wr_queue_lock);
+    nnti_counter *counter   =ib_mem_hdl->counter;
+    ib_rdma_ack  *target_ack=ib_mem_hdl->target_ack;
+    if (counter == NULL) {
+        nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+        return(FALSE);
+    }
+    if ((target_ack != NULL) &&
+        (target_ack->op == IB_OP_PUT_TARGET) &&
+        (target_ack->chunk_size > 0)) {
+        uint32_t &expected=ib_mem_hdl->counter_streams[wc->qp_num];
+        if (expected == 0) {
+            expected=(target_ack->length + target_ack->chunk_size - 1) / target_ack->chunk_size;
         }
-        nthread_unlock(&nnti_wrmap_lock);
-        assert(ib_wr);
-
-    } else if (wc->opcode==IBV_WC_SEND) {
-        log_debug(nnti_debug_level, "wc->opcode is IBV_WC_SEND, so this is a send request (IB_OP_SEND_REQUEST).  wc.wr_id is a key to the work request map.");
-
-        nthread_lock(&nnti_wrmap_lock);
-        if (wrmap.find(wc->wr_id) != wrmap.end()) {
-            ib_wr = wrmap[wc->wr_id];
+        expected--;
+        counted=(expected == 0);
+        if (counted) {
+            ib_mem_hdl->counter_streams.erase(wc->qp_num);
         }
-        nthread_unlock(&nnti_wrmap_lock);
-        assert(ib_wr);
-
-    } else {
-        if (wc->imm_data == 0) {
-            log_debug(nnti_debug_level, "wc->imm_data == 0, so I am the initiator.  wc.wr_id is a key to the work request map.");
-
-            // This is not a request buffer and I am the initiator, so wc.wr_id is the hash of the work request
-            nthread_lock(&nnti_wrmap_lock);
-            if (wrmap.find(wc->wr_id) != wrmap.end()) {
-                ib_wr = wrmap[wc->wr_id];
-            }
-            nthread_unlock(&nnti_wrmap_lock);
-            assert(ib_wr);
+    }
+    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
 
-        } else {
-            log_debug(nnti_debug_level, "wc->imm_data != 0, so I am the target.  wc->imm_data is either the hash of a buffer or the hash of an ib_wr.");
+    replace_srq_recv(ib_wr);
 
-            // This is not a request buffer and I am the target, so wc.imm_data is the hash of either the buffer or the work request
-            event_buf = get_buf_bufhash(wc->imm_data);
-            assert(event_buf);
-            ib_mem_hdl=IB_MEM_HDL(event_buf);
-            assert(ib_mem_hdl);
-            ib_wr = ib_mem_hdl->wr_queue.front();
-            assert(ib_wr);
-        }
+    if (counted) {
+        nthread_counter_increment(&counter->value);
+        log_debug(nnti_debug_level, "counted a target completion (reg_buf=%p ; counter=%p)", ib_wr->reg_buf, counter);
     }
 
-    log_debug(nnti_debug_level, "exit (ib_wr==%p)", ib_wr);
-
-    return(ib_wr);
+    return(TRUE);
 }
 
-static int cancel_wr(
+/*
+ * An immediate arrived for the target buffer of ib_wr.  If it is a chunk
+ * of a streaming put, count it, replace the SRQ receive it consumed and
+ * deliver the next chunk event if the waiter is free.  The first chunk of
+ * a stream starts it from the ACK record the initiator wrote ahead of the
+ * data.  Returns FALSE if the immediate isn't part of a stream.
+ */
+static int8_t stream_chunk_landed(
         ib_work_request *ib_wr)
 {
-    NNTI_result_t rc=NNTI_OK;
+    ib_memory_handle *ib_mem_hdl=IB_MEM_HDL(ib_wr->reg_buf);
+    assert(ib_mem_hdl);
 
-    log_debug(nnti_debug_level, "enter (ib_wr=%p)", ib_wr);
+    nthread_lock(&ib_mem_hdl->wr_queue_lock);
+    if (ib_mem_hdl->stream_expected == 0) {
+        ib_rdma_ack *target_ack=ib_mem_hdl->target_ack;
+        if ((target_ack == NULL) ||
+            (target_ack->op != IB_OP_PUT_TARGET) ||
+            (target_ack->chunk_size == 0)) {
+            nthread_unlock(&ib_mem_hdl->wr_queue_lock);
+            return(FALSE);
+        }
+        ib_mem_hdl->stream_offset  =target_ack->offset;
+        ib_mem_hdl->stream_end     =target_ack->offset + target_ack->length;
+        ib_mem_hdl->stream_chunk   =target_ack->chunk_size;
+        ib_mem_hdl->stream_expected=(target_ack->length + target_ack->chunk_size - 1) / target_ack->chunk_size;
+        log_debug(nnti_debug_level, "stream started (offset=%lu ; length=%lu ; chunk_size=%lu ; chunks=%u)",
+                target_ack->offset, target_ack->length, target_ack->chunk_size, ib_mem_hdl->stream_expected);
+    }
+    ib_mem_hdl->stream_expected--;
+    ib_mem_hdl->stream_landed++;
+    log_debug(nnti_debug_level, "stream chunk landed (expected=%u ; landed=%u)", ib_mem_hdl->stream_expected, ib_mem_hdl->stream_landed);
+    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
 
-    ib_wr->state=NNTI_IB_WR_STATE_WAIT_COMPLETE;
-    ib_wr->nnti_wr->result=NNTI_ECANCELED;
+    // replace the receive now.  a consumer that falls behind shouldn't drain the SRQ.
+    replace_srq_recv(ib_wr);
 
-    log_debug(nnti_debug_level, "exit (ib_wr==%p)", ib_wr);
+    stream_deliver(ib_wr);
 
-    return(rc);
+    return(TRUE);
+}
+
+/*
+ * If a chunk landed that the waiter hasn't seen and the waiter is free,
+ * complete ib_wr with the offset and length of that chunk.
+ */
+static void stream_deliver(
+        ib_work_request *ib_wr)
+{
+    ib_memory_handle *ib_mem_hdl=IB_MEM_HDL(ib_wr->reg_buf);
+    assert(ib_mem_hdl);
+
+    nthread_lock(&ib_mem_hdl->wr_queue_lock);
+    if ((ib_mem_hdl->stream_landed > 0) && (ib_wr->state == NNTI_IB_WR_STATE_POSTED)) {
+        uint64_t length=ib_mem_hdl->stream_end - ib_mem_hdl->stream_offset;
+        if (length > ib_mem_hdl->stream_chunk) {
+            length=ib_mem_hdl->stream_chunk;
+        }
+        ib_wr->ack_private.op        =IB_OP_PUT_TARGET;
+        ib_wr->ack_private.offset    =ib_mem_hdl->stream_offset;
+        ib_wr->ack_private.length    =length;
+        ib_wr->ack_private.chunk_size=ib_mem_hdl->stream_chunk;
+        ib_wr->ack_private.imm       =0;
+        ib_wr->last_op     =IB_OP_PUT_TARGET;
+        ib_wr->stream_event=TRUE;
+        ib_wr->state       =NNTI_IB_WR_STATE_RDMA_COMPLETE;
+
+        ib_mem_hdl->stream_offset += length;
+        ib_mem_hdl->stream_landed--;
+
+        log_debug(nnti_debug_level, "stream chunk delivered (offset=%lu ; length=%lu ; ib_wr=%p)",
+                ib_wr->ack_private.offset, ib_wr->ack_private.length, ib_wr);
+    }
+    nthread_unlock(&ib_mem_hdl->wr_queue_lock);
 }
 
 static int process_event(
@@ -4385,9 +7042,22 @@ static int process_event(
     log_debug(nnti_debug_level, "enter (ib_wr=%p)", ib_wr);
 
     if ((ib_wr->nnti_wr) && (ib_wr->nnti_wr->ops == NNTI_BOP_ATOMICS)) {
+        if (wc->status != IBV_WC_SUCCESS) {
+            ib_wr->nnti_wr->result=NNTI_EIO;
+        } else if ((ib_wr->atomic_vector) && (atomic_vector_next(ib_wr) == TRUE)) {
+            return NNTI_OK;
+        } else if ((ib_wr->atomic_emulated) && (atomic_retry(ib_wr) == TRUE)) {
+            return NNTI_OK;
+        }
+        if (ib_wr->atomic_vector) {
+            atomic_vector_free(ib_wr);
+        }
+        if (ib_wr->atomic_scratch) {
+            atomic_scratch_push(ib_wr->atomic_slot);
+            ib_wr->atomic_scratch=FALSE;
+        }
         ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
-        ib_wr->nnti_wr->result=NNTI_OK;
-        return NNTI_OK;
+        return ib_wr->nnti_wr->result;
     }
 
     if (wc->status == IBV_WC_RNR_RETRY_EXC_ERR) {
@@ -4424,26 +7094,22 @@ static int process_event(
                     log_debug(debug_level, "RDMA write (initiator) completion - wc==%p, ib_wr==%p", wc, ib_wr);
                     ib_wr->sq_wr_completed_count++;
                     log_debug(nnti_debug_level, "ib_wr->sq_wr_completed_count=%d", ib_wr->sq_wr_completed_count);
+                    if ((ib_wr->chunk_count > 0) && (chunk_post_next(ib_wr) != 0)) {
+                        ib_wr->state =NNTI_IB_WR_STATE_WAIT_COMPLETE;
+                        ib_wr->nnti_wr->result=NNTI_EIO;
+                        return NNTI_EIO;
+                    }
                 }
                 if (ib_wr->sq_wr_completed_count==ib_wr->sq_wr_count) {
+                    // with target ACKs, the last write carried the immediate.  nothing else to wait for.
                     ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
-                    if (!config.use_rdma_target_ack) {
-                        ib_wr->nnti_wr->result=NNTI_OK;
-                    }
-                }
-            }
-            if (wc->wc_flags==IBV_WC_WITH_IMM) {
-                if ((config.use_rdma_target_ack) &&
-                    (ib_wr->state == NNTI_IB_WR_STATE_RDMA_COMPLETE)) {
-                    log_debug(debug_level, "RDMA write ACK (initiator) completion - wc==%p, ib_wr==%p", wc, ib_wr);
-                    ib_wr->state=NNTI_IB_WR_STATE_ACK_COMPLETE;
                     ib_wr->nnti_wr->result=NNTI_OK;
                 }
             }
         }
 //        if (ib_wr->state == NNTI_IB_WR_STATE_RDMA_COMPLETE) {
 //            print_xfer_buf((void *)ib_wr->reg_buf->payload, ib_wr->reg_buf->payload_size);
-//            print_ack_buf(&ib_wr->ack);
+//            print_ack_buf(ib_wr->ack);
 //        }
     } else if (ib_wr->last_op == IB_OP_GET_INITIATOR) {
         log_debug(debug_level, "RDMA read event - wc==%p, ib_wr==%p, state==%d", wc, ib_wr, ib_wr->state);
@@ -4453,26 +7119,30 @@ static int process_event(
                 log_debug(debug_level, "RDMA read (initiator) completion - wc==%p, ib_wr==%p", wc, ib_wr);
                 ib_wr->sq_wr_completed_count++;
                 log_debug(nnti_debug_level, "ib_wr->sq_wr_completed_count=%d", ib_wr->sq_wr_completed_count);
+                if ((ib_wr->chunk_count > 0) && (chunk_post_next(ib_wr) != 0)) {
+                    ib_wr->state =NNTI_IB_WR_STATE_WAIT_COMPLETE;
+                    ib_wr->nnti_wr->result=NNTI_EIO;
+                    return NNTI_EIO;
+                }
             }
-            if (ib_wr->sq_wr_completed_count==ib_wr->sq_wr_count) {
+            if ((!config.use_rdma_target_ack) &&
+                (ib_wr->sq_wr_completed_count==ib_wr->sq_wr_count)) {
                 ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
-                if (!config.use_rdma_target_ack) {
-                    ib_wr->nnti_wr->result=NNTI_OK;
-                }
+                ib_wr->nnti_wr->result=NNTI_OK;
             }
         }
         else if ((config.use_rdma_target_ack) &&
-                 ((wc->opcode==IBV_WC_RDMA_WRITE) &&
-                  (wc->wc_flags==IBV_WC_WITH_IMM))) {
-            if (ib_wr->state == NNTI_IB_WR_STATE_RDMA_COMPLETE) {
+                 (wc->opcode==IBV_WC_RDMA_WRITE)) {
+            // the ACK is fenced behind the reads, so it completes last
+            if (ib_wr->state==NNTI_IB_WR_STATE_STARTED) {
                 log_debug(debug_level, "RDMA read ACK (initiator) completion - wc==%p, ib_wr==%p", wc, ib_wr);
-                ib_wr->state=NNTI_IB_WR_STATE_ACK_COMPLETE;
+                ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
                 ib_wr->nnti_wr->result=NNTI_OK;
             }
         }
 //        if (ib_wr->state == NNTI_IB_WR_STATE_RDMA_COMPLETE) {
 //            print_xfer_buf((void *)ib_wr->reg_buf->payload, ib_wr->reg_buf->payload_size);
-//            print_ack_buf(&ib_wr->ack);
+//            print_ack_buf(ib_wr->ack);
 //        }
     } else if (ib_wr->last_op == IB_OP_NEW_REQUEST) {
         if (wc->opcode==IBV_WC_RECV) {
@@ -4497,40 +7167,74 @@ static int process_event(
     } else if (ib_wr->last_op == IB_OP_RECEIVE) {
         if (wc->opcode==IBV_WC_RECV_RDMA_WITH_IMM) {
             log_debug(debug_level, "recv completion - wc==%p, ib_wr==%p", wc, ib_wr);
-            ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
 
             if (ib_wr->cq == transport_global_data.data_cq) {
                 transport_global_data.data_srq_count--;
                 log_debug(nnti_debug_level, "transport_global_data.data_srq_count==%ld", transport_global_data.data_srq_count);
             }
+
+            if ((config.use_rdma_target_ack) && (counter_landed(ib_wr, wc) == TRUE)) {
+                // the buffer is bound to a counter.  no event.
+            } else if ((config.use_rdma_target_ack) && (stream_chunk_landed(ib_wr) == TRUE)) {
+                // a chunk of a streaming put.  the event was delivered or queued.
+            } else {
+                ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
+
+                if (config.use_rdma_target_ack) {
+                    ib_memory_handle *ib_mem_hdl=IB_MEM_HDL(ib_wr->reg_buf);
+                    ib_rdma_ack      *target_ack=ib_mem_hdl->target_ack;
+                    if ((target_ack != NULL) &&
+                        ((target_ack->op == IB_OP_PUT_TARGET) || (target_ack->op == IB_OP_GET_TARGET))) {
+                        // the initiator wrote the ACK record before the immediate.  snapshot it before the next transfer reuses the slot.
+                        ib_wr->ack_private=*target_ack;
+                        ib_wr->last_op    =target_ack->op;
+                        log_debug(debug_level, "target ACK (op=%u ; offset=%lu ; length=%lu ; imm=%lu) - wc==%p, ib_wr==%p",
+                                ib_wr->ack_private.op, ib_wr->ack_private.offset, ib_wr->ack_private.length, ib_wr->ack_private.imm, wc, ib_wr);
+                    }
+                }
+            }
         }
     } else if (ib_wr->last_op == IB_OP_PUT_TARGET) {
         if (wc->opcode==IBV_WC_RECV_RDMA_WITH_IMM) {
             log_debug(debug_level, "RDMA write (target) completion - wc==%p, ib_wr==%p", wc, ib_wr);
-            ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
 
             if (ib_wr->cq == transport_global_data.data_cq) {
                 transport_global_data.data_srq_count--;
                 log_debug(nnti_debug_level, "transport_global_data.data_srq_count==%ld", transport_global_data.data_srq_count);
             }
+
+            if ((config.use_rdma_target_ack) && (counter_landed(ib_wr, wc) == TRUE)) {
+                // the buffer is bound to a counter.  no event.
+            } else if ((config.use_rdma_target_ack) && (stream_chunk_landed(ib_wr) == TRUE)) {
+                // a chunk of a streaming put.  the event was delivered or queued.
+            } else {
+                ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
+            }
         }
 //        if (ib_wr->op_state == RDMA_WRITE_COMPLETE) {
 //            print_xfer_buf((void *)ib_wr->reg_buf->payload, ib_wr->reg_buf->payload_size);
-//            print_ack_buf(&ib_wr->ack);
+//            print_ack_buf(ib_wr->ack);
 //        }
     } else if (ib_wr->last_op == IB_OP_GET_TARGET) {
         if (wc->opcode==IBV_WC_RECV_RDMA_WITH_IMM) {
             log_debug(debug_level, "RDMA read (target) completion - wc==%p, ib_wr==%p", wc, ib_wr);
-            ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
 
             if (ib_wr->cq == transport_global_data.data_cq) {
                 transport_global_data.data_srq_count--;
                 log_debug(nnti_debug_level, "transport_global_data.data_srq_count==%ld", transport_global_data.data_srq_count);
             }
+
+            if ((config.use_rdma_target_ack) && (counter_landed(ib_wr, wc) == TRUE)) {
+                // the buffer is bound to a counter.  no event.
+            } else if ((config.use_rdma_target_ack) && (stream_chunk_landed(ib_wr) == TRUE)) {
+                // a chunk of a streaming put.  the event was delivered or queued.
+            } else {
+                ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
+            }
         }
 //        if (ib_wr->op_state == RDMA_READ_COMPLETE) {
 //            print_xfer_buf((void *)ib_wr->reg_buf->payload, ib_wr->reg_buf->payload_size);
-//            print_ack_buf(&ib_wr->ack);
+//            print_ack_buf(ib_wr->ack);
 //        }
     } else {
         log_error(nnti_debug_level, "unknown ib_wr->last_op(%d)", ib_wr->last_op);
@@ -4695,6 +7399,7 @@ static NNTI_result_t post_ack_recv_work_request(
     ib_wr->key = nthread_counter_increment(&nnti_wrmap_counter);
 
     ib_wr->state=NNTI_IB_WR_STATE_POSTED;
+    ib_wr->stream_event=FALSE;
 
     if (reg_buf->ops==NNTI_BOP_RECV_QUEUE) {
         ib_wr->last_op=IB_OP_NEW_REQUEST;
@@ -4714,12 +7419,14 @@ static NNTI_result_t post_ack_recv_work_request(
         register_ack(ib_wr);
     }
 
-    reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_size = ib_wr->ack_mr->length;
-    reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_buf  = (uint64_t)ib_wr->ack_mr->addr;
+    ib_mem_hdl->target_ack=ib_wr->ack;
+
+    reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_size = sizeof(ib_rdma_ack);
+    reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_buf  = (uint64_t)ib_wr->ack;
     reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.ib.ack_key  = ib_wr->ack_mr->rkey;
 
-    ib_wr->sge.addr  =(uint64_t)ib_wr->ack_mr->addr;
-    ib_wr->sge.length=ib_wr->ack_mr->length;
+    ib_wr->sge.addr  =(uint64_t)ib_wr->ack;
+    ib_wr->sge.length=sizeof(ib_rdma_ack);
     ib_wr->sge.lkey  =ib_wr->ack_mr->lkey;
 
     ib_wr->rq_wr.wr_id  =(uint64_t)ib_wr->key;
@@ -4867,6 +7574,17 @@ static NNTI_result_t repost_ack_recv_work_request(
 
     ib_wr->state=NNTI_IB_WR_STATE_POSTED;
 
+    if (ib_wr->stream_event == TRUE) {
+        // the chunk's receive was replaced when it landed.  hand over the next chunk if it's already here.
+        ib_wr->stream_event=FALSE;
+        ib_wr->last_op     =IB_OP_RECEIVE;
+        stream_deliver(ib_wr);
+
+        log_debug(nnti_debug_level, "exit (wr=%p)", wr);
+
+        return(NNTI_OK);
+    }
+
     if (wr->reg_buf->ops==NNTI_BOP_RECV_QUEUE) {
         ib_wr->last_op=IB_OP_NEW_REQUEST;
 
@@ -4906,9 +7624,23 @@ static NNTI_result_t repost_ack_recv_work_request(
         log_debug(nnti_debug_level, "transport_global_data.req_srq_count==%ld", transport_global_data.req_srq_count);
     }
 
+    /*
+     * Target events are matched to the work request at the front of the
+     * buffer's queue.  A waiter that calls NNTI_wait() again on the same work
+     * request expects the next event, so this work request goes back to the
+     * front.  At the back, the next event would go to the buffer's other ACK
+     * receive, which nobody is waiting on, and the waiter would time out.
+     * This only matters with TRIOS_NNTI_USE_RDMA_TARGET_ACK, where every
+     * event on a target buffer completes one of these receives.
+     */
     log_debug(nnti_debug_level, "pushing ib_wr=%p", ib_wr);
     nthread_lock(&ib_mem_hdl->wr_queue_lock);
-    ib_mem_hdl->wr_queue.push_back(ib_wr);
+    wr_queue_iter_t q_victim=find(ib_mem_hdl->wr_queue.begin(), ib_mem_hdl->wr_queue.end(), ib_wr);
+    if (q_victim != ib_mem_hdl->wr_queue.end()) {
+        log_debug(nnti_debug_level, "erasing ib_wr=%p from the wr_queue", ib_wr);
+        ib_mem_hdl->wr_queue.erase(q_victim);
+    }
+    ib_mem_hdl->wr_queue.push_front(ib_wr);
     nthread_unlock(&ib_mem_hdl->wr_queue_lock);
 
     nthread_lock(&nnti_wrmap_lock);
@@ -4923,6 +7655,9 @@ static NNTI_result_t repost_ack_recv_work_request(
     wrmap[ib_wr->key] = ib_wr;
     nthread_unlock(&nnti_wrmap_lock);
 
+    // chunks of a stream may have landed while the previous event was waiting
+    stream_deliver(ib_wr);
+
     log_debug(nnti_debug_level, "exit (wr=%p)", wr);
 
     return(NNTI_OK);
@@ -5085,6 +7820,7 @@ static void create_status(
     trios_start_timer(total_time);
 
     status->op     = wr->ops;
+    status->imm    = 0;
     if (is_wr_complete(ib_wr)) {
         status->result = wr->result;
     } else {
@@ -5092,7 +7828,7 @@ static void create_status(
     }
     if (status->result==NNTI_OK) {
 
-//        print_ack_buf(&ib_wr->ack);
+//        print_ack_buf(ib_wr->ack);
 //        print_wr(ib_wr);
 
         conn = get_conn_qpn(ib_wr->last_wc.qp_num);
@@ -5145,8 +7881,9 @@ static void create_status(
             case IB_OP_GET_TARGET:
             case IB_OP_PUT_TARGET:
                 if (config.use_rdma_target_ack) {
-                    status->offset = ib_wr->ack.offset;
-                    status->length = ib_wr->ack.length;
+                    status->offset = ib_wr->ack_private.offset;
+                    status->length = ib_wr->ack_private.length;
+                    status->imm    = ib_wr->ack_private.imm;
                 }
                 break;
         }
@@ -5520,6 +8257,122 @@ out:
     return rc;
 }
 
+/*
+ * Create an RC queue pair with room for inline sends.  The HCA may grant
+ * less than config.max_inline_data (or refuse it altogether), so the
+ * granted limit is kept with the QP.
+ */
+static struct ibv_qp *create_conn_qp(
+        struct ibv_qp_init_attr *att,
+        conn_qp                 *cqp)
+{
+    struct ibv_qp *qp=NULL;
+
+    att->cap.max_inline_data=config.max_inline_data;
+    qp=ibv_create_qp_wrapper(transport_global_data.pd, att);
+    if ((qp == NULL) && (config.max_inline_data > 0)) {
+        log_debug(nnti_debug_level, "failed to create QP with max_inline_data=%u: %s.  retrying without inline sends.",
+                config.max_inline_data, strerror(errno));
+        att->cap.max_inline_data=0;
+        qp=ibv_create_qp_wrapper(transport_global_data.pd, att);
+    }
+    if (qp != NULL) {
+        cqp->max_inline=att->cap.max_inline_data;
+        log_debug(nnti_debug_level, "qp=%p max_inline=%u", qp, cqp->max_inline);
+    }
+
+    return(qp);
+}
+
+/*
+ * Post every send held on <tt>cqp</tt> with one ibv_post_send().  Unsignaled
+ * sends never produce a completion, so they are completed here.  Sends at
+ * or after a failed WR are completed with NNTI_EIO.
+ *
+ * The caller holds nnti_send_lock.
+ */
+static NNTI_result_t post_send_chain(
+        conn_qp *cqp)
+{
+    NNTI_result_t rc=NNTI_OK;
+
+    struct ibv_send_wr *bad_wr=NULL;
+
+    bool failed=false;
+
+    if (cqp->send_chain_len == 0) {
+        return(NNTI_OK);
+    }
+
+    for (uint32_t i=1;i<cqp->send_chain_len;i++) {
+        cqp->send_chain[i-1]->sq_wr.next=&cqp->send_chain[i]->sq_wr;
+    }
+    cqp->send_chain[cqp->send_chain_len-1]->sq_wr.next=NULL;
+
+    log_debug(nnti_debug_level, "posting %u sends to qp=%p", cqp->send_chain_len, cqp->qp);
+    if (ibv_post_send_wrapper(cqp->qp, &cqp->send_chain[0]->sq_wr, &bad_wr)) {
+        log_error(nnti_debug_level, "failed to post send: %s", strerror(errno));
+        rc=NNTI_EIO;
+    }
+
+    for (uint32_t i=0;i<cqp->send_chain_len;i++) {
+        ib_work_request *ib_wr=cqp->send_chain[i];
+        bool             retire=false;
+
+        cqp->send_chain[i]=NULL;
+
+        if ((rc != NNTI_OK) && ((bad_wr == NULL) || (&ib_wr->sq_wr == bad_wr))) {
+            failed=true;
+        }
+        if (failed) {
+            nthread_lock(&ib_wr->lock);
+            ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
+            ib_wr->nnti_wr->result=NNTI_EIO;
+            retire=ib_wr->implicit;
+            nthread_unlock(&ib_wr->lock);
+        } else if (!(ib_wr->sq_wr.send_flags & IBV_SEND_SIGNALED)) {
+            nthread_lock(&ib_wr->lock);
+            // create_status() finds the connection and length through last_wc
+            memset(&ib_wr->last_wc, 0, sizeof(struct ibv_wc));
+            ib_wr->last_wc.status =IBV_WC_SUCCESS;
+            ib_wr->last_wc.opcode =IBV_WC_SEND;
+            ib_wr->last_wc.qp_num =cqp->qp->qp_num;
+            for (int j=0;j<ib_wr->sq_wr.num_sge;j++) {
+                ib_wr->last_wc.byte_len += ib_wr->sq_wr.sg_list[j].length;
+            }
+            ib_wr->state=NNTI_IB_WR_STATE_RDMA_COMPLETE;
+            ib_wr->nnti_wr->result=NNTI_OK;
+            retire=ib_wr->implicit;
+            nthread_unlock(&ib_wr->lock);
+        }
+        if (retire) {
+            implicit_retire(ib_wr);
+        }
+    }
+    cqp->send_chain_len=0;
+
+    return(rc);
+}
+
+/*
+ * Post the sends held on every QP.  Called before anything that waits on
+ * or is ordered behind those sends.
+ */
+static void flush_send_chains(void)
+{
+    if (config.send_chain_max <= 1) {
+        return;
+    }
+
+    nthread_lock(&nnti_send_lock);
+    while (!pending_send_chains.empty()) {
+        conn_qp *cqp=pending_send_chains.front();
+        pending_send_chains.pop_front();
+        post_send_chain(cqp);
+    }
+    nthread_unlock(&nnti_send_lock);
+}
+
 static int new_client_connection(
         ib_connection *c,
         int sock)
@@ -5541,6 +8394,9 @@ static int new_client_connection(
         uint32_t peer_qpn;
         uint32_t atomics_rkey;
         uint64_t atomics_addr;
+        uint32_t credits_rkey;
+        uint64_t credits_addr;
+        uint32_t request_credits;
     } param_in, param_out;
 
     trios_declare_timer(callTime);
@@ -5566,7 +8422,7 @@ static int new_client_connection(
     att.qp_type          = IBV_QPT_RC;
 
     trios_start_timer(callTime);
-    c->req_qp.qp = ibv_create_qp_wrapper(transport_global_data.pd, &att);
+    c->req_qp.qp = create_conn_qp(&att, &c->req_qp);
     if (!c->req_qp.qp) {
         log_error(nnti_debug_level, "failed to create QP: %s", strerror(errno));
     }
@@ -5587,7 +8443,7 @@ static int new_client_connection(
     att.cap.max_recv_sge = 32;
     att.cap.max_send_sge = 32;
     att.qp_type          = IBV_QPT_RC;
-    c->data_qp.qp = ibv_create_qp_wrapper(transport_global_data.pd, &att);
+    c->data_qp.qp = create_conn_qp(&att, &c->data_qp);
     if (!c->data_qp.qp) {
         log_error(nnti_debug_level, "failed to create QP: %s", strerror(errno));
     }
@@ -5601,6 +8457,13 @@ static int new_client_connection(
     param_out.atomics_rkey=transport_global_data.atomics_mr->rkey;
     param_out.atomics_addr=(uint64_t)transport_global_data.atomics_mr->addr;
 
+    rc = setup_credit_record(c);
+    if (rc)
+        goto out;
+    param_out.credits_rkey   =c->credits_mr->rkey;
+    param_out.credits_addr   =(uint64_t)c->credits_mr->addr;
+    param_out.request_credits=htonl(nnti_credits_offer(&request_credits, transport_global_data.req_queue.req_count));
+
     trios_start_timer(callTime);
     rc = tcp_exchange(sock, 0, &param_in, &param_out, sizeof(param_in));
     trios_stop_timer("exch data", callTime);
@@ -5615,6 +8478,14 @@ static int new_client_connection(
     c->data_qp.peer_qpn = ntohl(param_in.my_qpn);
     c->atomics_rkey = param_in.atomics_rkey;
     c->atomics_addr = param_in.atomics_addr;
+    c->peer_credits_rkey = param_in.credits_rkey;
+    c->peer_credits_addr = param_in.credits_addr;
+
+    rc = check_emulated_peer(c);
+    if (rc)
+        goto out;
+
+    nnti_credits_connect(&request_credits, credit_key(c), ntohl(param_out.request_credits), ntohl(param_in.request_credits));
 
 out:
     return rc;
@@ -5641,6 +8512,9 @@ static int new_server_connection(
         uint32_t peer_qpn;
         uint32_t atomics_rkey;
         uint64_t atomics_addr;
+        uint32_t credits_rkey;
+        uint64_t credits_addr;
+        uint32_t request_credits;
     } param_in, param_out;
 
     // initialize structs to avoid valgrind warnings
@@ -5666,7 +8540,7 @@ static int new_server_connection(
     att.qp_type          = IBV_QPT_RC;
 
     trios_start_timer(callTime);
-    c->req_qp.qp = ibv_create_qp_wrapper(transport_global_data.pd, &att);
+    c->req_qp.qp = create_conn_qp(&att, &c->req_qp);
     if (!c->req_qp.qp) {
         log_error(nnti_debug_level, "failed to create QP: %s", strerror(errno));
     }
@@ -5687,7 +8561,7 @@ static int new_server_connection(
     att.cap.max_recv_sge = 32;
     att.cap.max_send_sge = 32;
     att.qp_type          = IBV_QPT_RC;
-    c->data_qp.qp = ibv_create_qp_wrapper(transport_global_data.pd, &att);
+    c->data_qp.qp = create_conn_qp(&att, &c->data_qp);
     if (!c->data_qp.qp) {
         log_error(nnti_debug_level, "failed to create QP: %s", strerror(errno));
     }
@@ -5701,6 +8575,13 @@ static int new_server_connection(
     param_out.atomics_rkey=transport_global_data.atomics_mr->rkey;
     param_out.atomics_addr=(uint64_t)transport_global_data.atomics_mr->addr;
 
+    rc = setup_credit_record(c);
+    if (rc)
+        goto out;
+    param_out.credits_rkey   =c->credits_mr->rkey;
+    param_out.credits_addr   =(uint64_t)c->credits_mr->addr;
+    param_out.request_credits=htonl(nnti_credits_offer(&request_credits, transport_global_data.req_queue.req_count));
+
     trios_start_timer(callTime);
     rc = tcp_exchange(sock, 1, &param_in, &param_out, sizeof(param_in));
     trios_stop_timer("exch data", callTime);
@@ -5715,6 +8596,14 @@ static int new_server_connection(
     c->data_qp.peer_qpn = ntohl(param_in.my_qpn);
     c->atomics_rkey = param_in.atomics_rkey;
     c->atomics_addr = param_in.atomics_addr;
+    c->peer_credits_rkey = param_in.credits_rkey;
+    c->peer_credits_addr = param_in.credits_addr;
+
+    rc = check_emulated_peer(c);
+    if (rc)
+        goto out;
+
+    nnti_credits_connect(&request_credits, credit_key(c), ntohl(param_out.request_credits), ntohl(param_in.request_credits));
 
 out:
     return rc;
@@ -5990,212 +8879,355 @@ static NNTI_buffer_t *del_buf_bufhash(NNTI_buffer_t *buf)
 //    }
 //}
 
-static NNTI_result_t wr_pool_register(
-        ib_work_request *ib_wr)
+/*
+ * Pick the home shard of the calling thread.  Without pthreads all
+ * callers share shard 0.
+ */
+static uint32_t wr_pool_home_shard(void)
 {
-    NNTI_result_t rc=NNTI_OK; /* return code */
+#if defined(HAVE_TRIOS_PTHREAD_H)
+    uint64_t h=(uint64_t)pthread_self();
+    h ^= (h >> 33);
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= (h >> 33);
+    return((uint32_t)(h % WR_POOL_SHARDS));
+#else
+    return(0);
+#endif
+}
 
-    trios_declare_timer(callTime);
+static void wr_pool_setup(
+        ib_wr_pool *pool,
+        const char *name,
+        bool        with_ack)
+{
+    pool->name     =name;
+    pool->with_ack =with_ack;
+    pool->size     =0;
+    pool->grows    =0;
+    pool->overflows=0;
+    pool->chunks.clear();
+    nthread_lock_init(&pool->chunk_lock);
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        nthread_lock_init(&pool->shard[i].lock);
+        pool->shard[i].free_list.clear();
+        pool->shard[i].owned     =0;
+        pool->shard[i].high_water=0;
+        pool->shard[i].pops      =0;
+        pool->shard[i].steals    =0;
+    }
+}
 
-    struct ibv_mr *mr=NULL;
+/*
+ * Add up to <tt>count</tt> requests to shard <tt>home</tt>.  The requests
+ * and their ACK records are allocated as one chunk and the ACK records are
+ * registered together.  Returns the number added, which is 0 once the pool
+ * has reached wr_pool_max_size.
+ */
+static uint32_t wr_pool_grow(
+        ib_wr_pool *pool,
+        uint32_t    home,
+        uint32_t    count)
+{
+    ib_wr_pool_chunk  chunk;
+    ib_wr_pool_shard *shard=&pool->shard[home];
 
-    uint32_t len;
+    log_debug(nnti_debug_level, "enter (pool=%s, shard=%u, count=%u)", pool->name, home, count);
 
-    log_debug(nnti_debug_level, "enter");
+    // reserve the requests first so concurrent growers can't overshoot max_size
+    nthread_lock(&pool->chunk_lock);
+    if (pool->size + count > config.wr_pool_max_size) {
+        count=(pool->size < config.wr_pool_max_size) ? config.wr_pool_max_size - pool->size : 0;
+    }
+    pool->size += count;
+    nthread_unlock(&pool->chunk_lock);
 
-    len = sizeof(ib_wr->ack);
+    if (count == 0) {
+        log_debug(nnti_debug_level, "exit (pool=%s is at its max size)", pool->name);
+        return(0);
+    }
 
-    if (config.use_memset) {
-        trios_start_timer(callTime);
-        memset(&ib_wr->ack, 0, len);
-        trios_stop_timer("memset", callTime);
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.wrs=(ib_work_request *)calloc(count, sizeof(ib_work_request));
+    if ((chunk.wrs != NULL) && pool->with_ack) {
+        chunk.acks=(ib_rdma_ack *)aligned_malloc(count * sizeof(ib_rdma_ack));
+        if (chunk.acks != NULL) {
+            memset(chunk.acks, 0, count * sizeof(ib_rdma_ack));
+            chunk.ack_mr=register_memory_segment(chunk.acks, count * sizeof(ib_rdma_ack),
+                    (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
+        }
     }
-    if (config.use_mlock) {
-        trios_start_timer(callTime);
-        mlock(&ib_wr->ack, len);
-        trios_stop_timer("mlock", callTime);
+    if ((chunk.wrs == NULL) || (pool->with_ack && (chunk.ack_mr == NULL))) {
+        log_error(nnti_debug_level, "failed to grow the %s pool by %u requests", pool->name, count);
+        if (chunk.acks != NULL) free(chunk.acks);
+        if (chunk.wrs != NULL)  free(chunk.wrs);
+
+        nthread_lock(&pool->chunk_lock);
+        pool->size -= count;
+        nthread_unlock(&pool->chunk_lock);
+
+        return(0);
     }
 
-    trios_start_timer(callTime);
-    mr = ibv_reg_mr_wrapper(
-            transport_global_data.pd,
-            &ib_wr->ack,
-            len,
-            (ibv_access_flags)(IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ | IBV_ACCESS_REMOTE_WRITE));
-    if (!mr) {
-        log_error(nnti_debug_level, "failed to register memory region");
-        perror("errno");
-        return NNTI_EIO;
+    for (uint32_t i=0;i<count;i++) {
+        ib_work_request *ib_wr=&chunk.wrs[i];
+        nthread_lock_init(&ib_wr->lock);
+        ib_wr->pool      =pool;
+        ib_wr->pool_shard=home;
+        ib_wr->ack_slot  =-1;
+        if (pool->with_ack) {
+            ib_wr->ack   =&chunk.acks[i];
+            ib_wr->ack_mr=chunk.ack_mr;
+        }
     }
-    trios_stop_timer("register", callTime);
 
-    ib_wr->ack_mr=mr;
+    nthread_lock(&pool->chunk_lock);
+    pool->chunks.push_back(chunk);
+    pool->grows++;
+    nthread_unlock(&pool->chunk_lock);
 
-    log_debug(nnti_debug_level, "exit (mr==%p, addr %p, length %lu, lkey %x, rkey %x)...", mr, mr->addr, mr->length, mr->lkey, mr->rkey);
+    nthread_lock(&shard->lock);
+    for (uint32_t i=0;i<count;i++) {
+        shard->free_list.push_back(&chunk.wrs[i]);
+    }
+    shard->owned += count;
+    nthread_unlock(&shard->lock);
 
-    return (rc);
+    log_debug(nnti_debug_level, "exit (pool=%s, shard=%u, added=%u)", pool->name, home, count);
+
+    return(count);
 }
-static NNTI_result_t wr_pool_deregister(
-        ib_work_request *ib_wr)
+
+/*
+ * Move half of the first non-empty neighbor's free requests to shard
+ * <tt>home</tt>.  Only one shard lock is held at a time.
+ */
+static uint32_t wr_pool_steal(
+        ib_wr_pool *pool,
+        uint32_t    home)
 {
-    int ibv_rc=0;
-    trios_declare_timer(callTime);
+    wr_pool_t loot;
 
-    log_debug(nnti_debug_level, "enter");
+    for (uint32_t i=1;i<WR_POOL_SHARDS;i++) {
+        ib_wr_pool_shard *victim=&pool->shard[(home+i) % WR_POOL_SHARDS];
 
-    if (ib_wr->ack_mr!=NULL) {
-        trios_start_timer(callTime);
-        ibv_rc=ibv_dereg_mr_wrapper(ib_wr->ack_mr);
-        if (ibv_rc != 0) {
-            log_error(nnti_debug_level, "deregistering the ACK buffer failed");
+        nthread_lock(&victim->lock);
+        uint32_t take=(victim->free_list.size()+1)/2;
+        for (uint32_t j=0;j<take;j++) {
+            loot.push_back(victim->free_list.front());
+            victim->free_list.pop_front();
+        }
+        victim->owned -= take;
+        nthread_unlock(&victim->lock);
+
+        if (!loot.empty()) {
+            break;
         }
-        trios_stop_timer("deregister", callTime);
-        ib_wr->ack_mr=NULL;
-    } else {
-        log_debug(nnti_debug_level, "exit ib_wr(%p) - not registered", ib_wr);
-        return(NNTI_OK);
     }
 
-    if (config.use_mlock) {
-        trios_start_timer(callTime);
-        munlock(ib_wr->ack_mr->addr, ib_wr->ack_mr->length);
-        trios_stop_timer("munlock", callTime);
+    if (!loot.empty()) {
+        ib_wr_pool_shard *shard=&pool->shard[home];
+
+        nthread_lock(&shard->lock);
+        for (wr_pool_iter_t iter=loot.begin();iter!=loot.end();iter++) {
+            (*iter)->pool_shard=home;
+            shard->free_list.push_back(*iter);
+        }
+        shard->owned += loot.size();
+        shard->steals++;
+        nthread_unlock(&shard->lock);
+    }
+
+    return(loot.size());
+}
+
+static ib_work_request *wr_pool_pop(
+        ib_wr_pool *pool)
+{
+    ib_work_request  *ib_wr=NULL;
+    uint32_t          home=wr_pool_home_shard();
+    ib_wr_pool_shard *shard=&pool->shard[home];
+    uint32_t          owned;
+
+    log_debug(nnti_debug_level, "enter (pool=%s, shard=%u)", pool->name, home);
+
+    while (1) {
+        nthread_lock(&shard->lock);
+        if (!shard->free_list.empty()) {
+            ib_wr=shard->free_list.front();
+            shard->free_list.pop_front();
+            shard->pops++;
+            uint32_t in_use=shard->owned - shard->free_list.size();
+            if (in_use > shard->high_water) {
+                shard->high_water=in_use;
+            }
+        }
+        owned=shard->owned;
+        nthread_unlock(&shard->lock);
+
+        if (ib_wr != NULL) {
+            break;
+        }
+
+        if (wr_pool_steal(pool, home) > 0) {
+            continue;
+        }
+        // every request homed here is in use, so double the shard
+        if (wr_pool_grow(pool, home, (owned < WR_POOL_MIN_CHUNK) ? WR_POOL_MIN_CHUNK : owned) > 0) {
+            continue;
+        }
+
+        // the pool is at its cap.  hand out a request that is freed when it's pushed.
+        nthread_lock(&pool->chunk_lock);
+        pool->overflows++;
+        nthread_unlock(&pool->chunk_lock);
+
+        ib_wr=(ib_work_request *)calloc(1, sizeof(ib_work_request));
+        if (ib_wr != NULL) {
+            nthread_lock_init(&ib_wr->lock);
+            ib_wr->ack_slot=-1;
+            if (pool->with_ack) {
+                register_ack(ib_wr);
+            }
+        }
+        break;
     }
 
-    log_debug(nnti_debug_level, "exit");
+    log_debug(nnti_debug_level, "exit (ib_wr=%p)", ib_wr);
 
-    return(NNTI_OK);
+    return(ib_wr);
 }
-static NNTI_result_t wr_pool_init(uint32_t pool_size)
+
+static NNTI_result_t wr_pool_init(void)
 {
-    NNTI_result_t  rc=NNTI_OK;
-    uint32_t i;
-    ib_work_request *ib_wr=NULL;
+    NNTI_result_t rc=NNTI_OK;
 
     log_debug(nnti_debug_level, "enter");
 
-    for (i=0;i<pool_size;i++) {
-        ib_wr=(ib_work_request *)calloc(1, sizeof(ib_work_request));
-        assert(ib_wr);
-        log_debug(nnti_debug_level, "allocated ib_wr (ib_wr=%p)", ib_wr);
-        nthread_lock_init(&ib_wr->lock);
-        rc=wr_pool_register(ib_wr);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to register target work request: rc=%d", rc);
-            goto cleanup;
-        }
-        wr_pool_rdma_push(ib_wr);
+    wr_pool_setup(&rdma_wr_pool, "rdma", true);
+    wr_pool_setup(&sendrecv_wr_pool, "sendrecv", false);
 
-        ib_wr=(ib_work_request *)calloc(1, sizeof(ib_work_request));
-        assert(ib_wr);
-        log_debug(nnti_debug_level, "allocated ib_wr (ib_wr=%p)", ib_wr);
-        nthread_lock_init(&ib_wr->lock);
-        wr_pool_sendrecv_push(ib_wr);
+    if (config.wr_pool_initial_size > 0) {
+        uint32_t home=wr_pool_home_shard();
+        if ((wr_pool_grow(&rdma_wr_pool, home, config.wr_pool_initial_size) == 0) ||
+            (wr_pool_grow(&sendrecv_wr_pool, home, config.wr_pool_initial_size) == 0)) {
+            log_error(nnti_debug_level, "failed to allocate the initial work requests");
+            rc=NNTI_ENOMEM;
+        }
+        // the initial chunks aren't growth
+        rdma_wr_pool.grows=0;
+        sendrecv_wr_pool.grows=0;
     }
 
-cleanup:
     log_debug(nnti_debug_level, "exit");
 
     return(rc);
 }
 static ib_work_request *wr_pool_rdma_pop(void)
 {
-    ib_work_request *ib_wr=NULL;
-
-    log_debug(nnti_debug_level, "enter");
-
-    nthread_lock(&nnti_wr_pool_lock);
-    if (!rdma_wr_pool.empty()) {
-        ib_wr=rdma_wr_pool.front();
-        rdma_wr_pool.pop_front();
-    }
-    nthread_unlock(&nnti_wr_pool_lock);
-
-    log_debug(nnti_debug_level, "exit");
-
-    return(ib_wr);
+    return(wr_pool_pop(&rdma_wr_pool));
 }
 static ib_work_request *wr_pool_sendrecv_pop(void)
 {
-    ib_work_request *ib_wr=NULL;
-
-    log_debug(nnti_debug_level, "enter");
-
-    nthread_lock(&nnti_wr_pool_lock);
-    if (!sendrecv_wr_pool.empty()) {
-        ib_wr=sendrecv_wr_pool.front();
-        sendrecv_wr_pool.pop_front();
-    }
-    nthread_unlock(&nnti_wr_pool_lock);
-
-    log_debug(nnti_debug_level, "exit");
-
-    return(ib_wr);
+    return(wr_pool_pop(&sendrecv_wr_pool));
 }
-static void wr_pool_rdma_push(ib_work_request *ib_wr)
+static void wr_pool_push(ib_work_request *ib_wr)
 {
     log_debug(nnti_debug_level, "enter");
 
-    ib_wr->last_op=0;
-    ib_wr->state  =NNTI_IB_WR_STATE_RESET;
+    if (ib_wr->pool == NULL) {
+        // allocated outside of a pool chunk
+        unregister_ack(ib_wr);
+        log_debug(nnti_debug_level, "freeing ib_wr=%p", ib_wr);
+        free(ib_wr);
+        return;
+    }
+
+    ib_wr->nnti_wr =NULL;
+    ib_wr->last_op =0;
+    ib_wr->state   =NNTI_IB_WR_STATE_RESET;
+    ib_wr->implicit=FALSE;
 
-    nthread_lock(&nnti_wr_pool_lock);
-    rdma_wr_pool.push_front(ib_wr);
-    nthread_unlock(&nnti_wr_pool_lock);
+    ib_wr_pool_shard *shard=&ib_wr->pool->shard[ib_wr->pool_shard];
+    nthread_lock(&shard->lock);
+    shard->free_list.push_front(ib_wr);
+    nthread_unlock(&shard->lock);
 
     log_debug(nnti_debug_level, "exit");
 
     return;
 }
-static void wr_pool_sendrecv_push(ib_work_request *ib_wr)
+
+static void wr_pool_get_stats(
+        ib_wr_pool         *pool,
+        nnti_wr_pool_stats *stats)
 {
-    log_debug(nnti_debug_level, "enter");
+    memset(stats, 0, sizeof(nnti_wr_pool_stats));
+
+    nthread_lock(&pool->chunk_lock);
+    stats->size     =pool->size;
+    stats->grows    =pool->grows;
+    stats->overflows=pool->overflows;
+    nthread_unlock(&pool->chunk_lock);
+
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        ib_wr_pool_shard *shard=&pool->shard[i];
+        nthread_lock(&shard->lock);
+        stats->free       += shard->free_list.size();
+        stats->high_water += shard->high_water;
+        stats->pops       += shard->pops;
+        stats->steals     += shard->steals;
+        nthread_unlock(&shard->lock);
+    }
+    stats->in_use=(stats->size > stats->free) ? stats->size - stats->free : 0;
+}
 
-    ib_wr->last_op=0;
-    ib_wr->state  =NNTI_IB_WR_STATE_RESET;
+static void wr_pool_teardown(
+        ib_wr_pool *pool)
+{
+    nnti_wr_pool_stats stats;
 
-    nthread_lock(&nnti_wr_pool_lock);
-    sendrecv_wr_pool.push_front(ib_wr);
-    nthread_unlock(&nnti_wr_pool_lock);
+    wr_pool_get_stats(pool, &stats);
+    log_debug(nnti_debug_level, "%s pool: size=%u in_use=%u high_water=%u pops=%llu steals=%llu grows=%llu overflows=%llu",
+            pool->name, stats.size, stats.in_use, stats.high_water,
+            stats.pops, stats.steals, stats.grows, stats.overflows);
+    if (stats.in_use > 0) {
+        log_warn(nnti_debug_level, "%u %s work requests are still in use", stats.in_use, pool->name);
+    }
 
-    log_debug(nnti_debug_level, "exit");
+    nthread_lock(&pool->chunk_lock);
+    while (!pool->chunks.empty()) {
+        ib_wr_pool_chunk chunk=pool->chunks.front();
+        pool->chunks.pop_front();
+        if (chunk.ack_mr != NULL) {
+            unregister_memory_segment(chunk.ack_mr);
+        }
+        if (chunk.acks != NULL) {
+            free(chunk.acks);
+        }
+        free(chunk.wrs);
+    }
+    pool->size=0;
+    nthread_unlock(&pool->chunk_lock);
 
-    return;
+    for (int i=0;i<WR_POOL_SHARDS;i++) {
+        pool->shard[i].free_list.clear();
+        pool->shard[i].owned=0;
+        nthread_lock_fini(&pool->shard[i].lock);
+    }
+    nthread_lock_fini(&pool->chunk_lock);
 }
+
 static NNTI_result_t wr_pool_fini(void)
 {
-    NNTI_result_t  rc=NNTI_OK;
-    ib_work_request *ib_wr=NULL;
-
     log_debug(nnti_debug_level, "enter");
 
-    nthread_lock(&nnti_wr_pool_lock);
-    while (!rdma_wr_pool.empty()) {
-        ib_wr=rdma_wr_pool.front();
-        rdma_wr_pool.pop_front();
-        assert(ib_wr);
-        rc=wr_pool_deregister(ib_wr);
-        if (rc!=NNTI_OK) {
-            log_error(nnti_debug_level, "failed to deregister target work request: rc=%d", rc);
-            goto cleanup;
-        }
-        log_debug(nnti_debug_level, "freeing ib_wr=%p", ib_wr);
-        free(ib_wr);
-    }
-    while (!sendrecv_wr_pool.empty()) {
-        ib_wr=sendrecv_wr_pool.front();
-        sendrecv_wr_pool.pop_front();
-        assert(ib_wr);
-        log_debug(nnti_debug_level, "freeing ib_wr=%p", ib_wr);
-        free(ib_wr);
-    }
-
-cleanup:
-    nthread_unlock(&nnti_wr_pool_lock);
+    wr_pool_teardown(&rdma_wr_pool);
+    wr_pool_teardown(&sendrecv_wr_pool);
 
     log_debug(nnti_debug_level, "exit");
 
-    return(rc);
+    return(NNTI_OK);
 }
 
 static void close_all_conn(void)
@@ -6287,6 +9319,19 @@ static void close_connection(ib_connection *c)
 
     print_ib_conn(c);
 
+    // sends still held for this connection go out before the QPs are torn down
+    nthread_lock(&nnti_send_lock);
+    post_send_chain(&c->req_qp);
+    post_send_chain(&c->data_qp);
+    for (send_chain_list_t::iterator iter=pending_send_chains.begin(); iter != pending_send_chains.end(); ) {
+        if ((*iter == &c->req_qp) || (*iter == &c->data_qp)) {
+            iter=pending_send_chains.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    nthread_unlock(&nnti_send_lock);
+
     transition_connection_to_error(c);
 
     if (c->peer_name) free(c->peer_name);
@@ -6300,11 +9345,145 @@ static void close_connection(ib_connection *c)
         if (rc < 0)
             log_error(nnti_debug_level, "failed to destroy QP");
     }
+    if (c->credits_mr) {
+        ibv_dereg_mr_wrapper(c->credits_mr);
+        c->credits_mr=NULL;
+    }
+    if (c->credits) {
+        free(c->credits);
+        c->credits=NULL;
+    }
     c->state=DISCONNECTED;
 
     log_debug(nnti_debug_level, "exit");
 }
 
+/*
+ * The verbs emulator keeps every QP in this process, so the peer must be
+ * this process too.
+ */
+static int check_emulated_peer(
+        const ib_connection *c)
+{
+    if ((config.use_verbs_emulator) &&
+        ((c->peer_addr != transport_global_data.listen_addr) || (c->peer_port != transport_global_data.listen_port))) {
+        log_error(nnti_debug_level, "the verbs emulator can't connect to another process (%s)", c->peer_name);
+        return(NNTI_ENOTSUP);
+    }
+
+    return(NNTI_OK);
+}
+
+/*
+ * Credits are kept by the peer's listen address so both connections
+ * between a pair of processes share them.
+ */
+static uint64_t credit_key(
+        const ib_connection *c)
+{
+    return(((uint64_t)c->peer_addr << 32) | c->peer_port);
+}
+
+/*
+ * Register the record the peer writes returned credits into.  Called
+ * before the connection parameters are exchanged.
+ */
+static int setup_credit_record(
+        ib_connection *c)
+{
+    c->credits=(ib_credit_record *)calloc(1, sizeof(ib_credit_record));
+    if (c->credits == NULL) {
+        return(NNTI_ENOMEM);
+    }
+    c->credits_mr=ibv_reg_mr_wrapper(transport_global_data.pd, c->credits, sizeof(ib_credit_record),
+            IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+    if (c->credits_mr == NULL) {
+        log_error(nnti_debug_level, "failed to register the credit record: %s", strerror(errno));
+        free(c->credits);
+        c->credits=NULL;
+        return(NNTI_ENOMEM);
+    }
+    c->credits_seen=0;
+
+    return(NNTI_OK);
+}
+
+/*
+ * Spend a credit on a request to the peer of <tt>c</tt>.  If none are
+ * left, pick up the credits the peer wrote back before giving up.
+ */
+static int8_t take_request_credit(
+        ib_connection *c)
+{
+    uint64_t key=credit_key(c);
+    uint64_t returned=0;
+
+    if (nnti_credits_take(&request_credits, key)) {
+        return(TRUE);
+    }
+
+    nthread_lock(&nnti_send_lock);
+    returned=c->credits->returned;
+    if (returned > c->credits_seen) {
+        nnti_credits_add(&request_credits, key, (uint32_t)(returned - c->credits_seen));
+        c->credits_seen=returned;
+    }
+    nthread_unlock(&nnti_send_lock);
+
+    return(nnti_credits_take(&request_credits, key) ? TRUE : FALSE);
+}
+
+/*
+ * A request from the peer of <tt>c</tt> was consumed.  Once half of the
+ * offer is owed, the running total of returned credits is written into
+ * the peer's credit record.  The write is inline when the QP allows it so
+ * later returns can't change the value while it's in flight.
+ */
+static void return_request_credits(
+        ib_connection *c,
+        uint32_t       credits)
+{
+    struct ibv_sge      sge;
+    struct ibv_send_wr  sq_wr;
+    struct ibv_send_wr *bad_wr=NULL;
+
+    uint32_t owed=0;
+
+    if (c == NULL) {
+        return;
+    }
+    owed=nnti_credits_owe(&request_credits, credit_key(c), credits);
+    if (owed == 0) {
+        return;
+    }
+
+    log_debug(nnti_debug_level, "returning %u credits to %s", owed, c->peer_name);
+
+    nthread_lock(&nnti_send_lock);
+    c->credits->sent += owed;
+
+    sge.addr  =(uint64_t)&c->credits->sent;
+    sge.length=sizeof(uint64_t);
+    sge.lkey  =c->credits_mr->lkey;
+
+    memset(&sq_wr, 0, sizeof(struct ibv_send_wr));
+    sq_wr.wr_id              =IB_CREDIT_WR_ID;
+    sq_wr.sg_list            =&sge;
+    sq_wr.num_sge            =1;
+    sq_wr.opcode             =IBV_WR_RDMA_WRITE;
+    sq_wr.send_flags         =IBV_SEND_SIGNALED;
+    sq_wr.wr.rdma.rkey       =c->peer_credits_rkey;
+    sq_wr.wr.rdma.remote_addr=c->peer_credits_addr;
+    if (c->req_qp.max_inline >= sizeof(uint64_t)) {
+        sq_wr.send_flags |= IBV_SEND_INLINE;
+    }
+
+    if (ibv_post_send_wrapper(c->req_qp.qp, &sq_wr, &bad_wr)) {
+        log_error(nnti_debug_level, "failed to return request credits: %s", strerror(errno));
+    }
+    nthread_unlock(&nnti_send_lock);
+}
+
 static NNTI_result_t check_for_waiting_connection()
 {
     NNTI_result_t rc = NNTI_OK;
@@ -6344,6 +9523,8 @@ static NNTI_result_t check_for_waiting_connection()
 //        nthread_lock(&nnti_ib_lock);
         rc=init_connection(&conn, s, 1);
         if (rc!=NNTI_OK) {
+            close(s);
+            free(conn);
             goto cleanup;
         }
         create_peer(
@@ -6425,7 +9606,7 @@ static void get_qp_state(struct ibv_qp *qp)
     struct ibv_qp_attr attr;
     struct ibv_qp_init_attr init_attr;
 
-    if (ibv_query_qp(qp, &attr,
+    if (ibv_query_qp_wrapper(qp, &attr,
               IBV_QP_STATE, &init_attr)) {
         log_error(nnti_debug_level, "Failed to query QP state\n");
         return;
@@ -6624,9 +9805,12 @@ static NNTI_result_t poll_all(
     }
     if (my_pollfd[DATA_CQ_SOCKET_INDEX].revents == POLLIN) {
         process_comp_channel_event(transport_global_data.data_comp_channel, transport_global_data.data_cq);
+        /* the event disarmed the CQ.  progress() rearms it once the CQ is drained. */
+        transport_global_data.data_cq_armed=false;
     }
     if (my_pollfd[REQ_CQ_SOCKET_INDEX].revents == POLLIN) {
         process_comp_channel_event(transport_global_data.req_comp_channel, transport_global_data.req_cq);
+        transport_global_data.req_cq_armed=false;
     }
     if (my_pollfd[INTERRUPT_PIPE_INDEX].revents == POLLIN) {
         log_debug(nnti_debug_level, "poll() interrupted by NNTI_ib_interrupt");
@@ -6642,14 +9826,6 @@ static NNTI_result_t poll_all(
         } while(bytes_read > 0);
         rc = NNTI_EINTR;
     }
-    if (ibv_req_notify_cq_wrapper(transport_global_data.data_cq, 0)) {
-        log_error(nnti_debug_level, "Couldn't request CQ notification: %s", strerror(errno));
-        rc = NNTI_EIO;
-    }
-    if (ibv_req_notify_cq_wrapper(transport_global_data.req_cq, 0)) {
-        log_error(nnti_debug_level, "Couldn't request CQ notification: %s", strerror(errno));
-        rc = NNTI_EIO;
-    }
 
 cleanup:
     trios_stop_timer("poll_all", total_time);
@@ -6659,6 +9835,105 @@ cleanup:
 }
 
 
+/* the most work completions taken from a CQ by one ibv_poll_cq() */
+#define CQ_POLL_BATCH 32
+
+/*
+ * Rearm a CQ that has been polled dry.  A completion that slipped in
+ * between the poll and the rearm doesn't raise an event, so the caller
+ * must poll once more after this returns true.
+ */
+static bool arm_drained_cq(
+        struct ibv_cq *cq,
+        bool          *armed)
+{
+    if (*armed) {
+        return false;
+    }
+    if (ibv_req_notify_cq_wrapper(cq, 0)) {
+        log_error(nnti_debug_level, "Couldn't request CQ notification: %s", strerror(errno));
+        return false;
+    }
+    *armed=true;
+
+    return true;
+}
+
+static void process_wc_list(
+        struct ibv_wc   *wc_list,
+        const int        wc_count,
+        NNTI_result_t   *nnti_rc)
+{
+    ib_work_request *ib_wr_list[CQ_POLL_BATCH];
+
+    trios_declare_timer(call_time);
+
+    trios_start_timer(call_time);
+    decode_work_request_list(wc_list, wc_count, ib_wr_list);
+    trios_stop_timer("progress - decode_work_request_list", call_time);
+
+    for (int i=0;i<wc_count;i++) {
+        struct ibv_wc   *wc   =&wc_list[i];
+        ib_work_request *ib_wr=ib_wr_list[i];
+
+        log_debug(nnti_debug_level, "polling status is %s", ibv_wc_status_str(wc->status));
+
+        print_wc(wc, false);
+        if (wc->wr_id == IB_CREDIT_WR_ID) {
+            if (wc->status != IBV_WC_SUCCESS) {
+                log_error(nnti_debug_level, "failed to return request credits: status %s (%d)",
+                        ibv_wc_status_str(wc->status), wc->status);
+            }
+            continue;
+        }
+        if (ib_wr == NULL) {
+            log_error(nnti_debug_level, "unsignaled send failed with status %s (%d).  the send was already reported complete.",
+                    ibv_wc_status_str(wc->status), wc->status);
+            *nnti_rc=NNTI_EIO;
+            fail_unsignaled(get_conn_qpn(wc->qp_num), NNTI_EIO);
+            continue;
+        }
+        if ((wc->status == IBV_WC_RNR_RETRY_EXC_ERR) ||
+            (wc->status == IBV_WC_RETRY_EXC_ERR)) {
+            *nnti_rc=NNTI_EDROPPED;
+
+            int min_rnr_timer=1;  /* means 0.01ms delay before sending RNR NAK */
+            int ack_timeout  =17; /* time to wait for ACK/NAK before retransmitting.  4.096us * 2^17 == 0.536ss */
+            int retry_count;
+            if (config.drop_if_full_queue) {
+                retry_count=1; /* number of retries if no answer on primary path or if remote sends RNR NAK */
+            } else {
+                retry_count=7; /* number of retries if no answer on primary path or if remote sends RNR NAK.  7 has special meaning of infinite retries. */
+            }
+            transition_qp_from_error_to_ready(
+                    ib_wr->conn->req_qp.qp,
+                    ib_wr->conn->peer_req_qpn,
+                    ib_wr->conn->peer_lid,
+                    min_rnr_timer,
+                    ack_timeout,
+                    retry_count);
+
+        } else if (wc->status != IBV_WC_SUCCESS) {
+            log_error(nnti_debug_level, "Failed status %s (%d) for wr_id %lx",
+                    ibv_wc_status_str(wc->status),
+                    wc->status, wc->wr_id);
+            *nnti_rc=NNTI_EIO;
+        }
+
+        trios_start_timer(call_time);
+        nthread_lock(&ib_wr->lock);
+        process_event(ib_wr, wc);
+        bool retire=((ib_wr->implicit) &&
+                     ((ib_wr->state==NNTI_IB_WR_STATE_RDMA_COMPLETE) || (ib_wr->state==NNTI_IB_WR_STATE_WAIT_COMPLETE)));
+        nthread_unlock(&ib_wr->lock);
+        trios_stop_timer("progress - process_event", call_time);
+
+        if (retire) {
+            implicit_retire(ib_wr);
+        }
+    }
+}
+
 #define CQ_COUNT 2
 static NNTI_result_t progress(
         int                   timeout,
@@ -6671,10 +9946,9 @@ static NNTI_result_t progress(
 
     uint32_t which=0;
 
-    struct ibv_wc            wc;
-    struct ibv_comp_channel *comp_channel;
+    struct ibv_wc            wc_list[CQ_POLL_BATCH];
     struct ibv_cq           *cq_list[CQ_COUNT];
-    static int               cq_index=0;
+    bool                    *cq_armed_list[CQ_COUNT];
 
     long entry_time  =trios_get_time_ms();
     long elapsed_time=0;
@@ -6696,6 +9970,8 @@ static NNTI_result_t progress(
 
     cq_list[0]=transport_global_data.data_cq;
     cq_list[1]=transport_global_data.req_cq;
+    cq_armed_list[0]=&transport_global_data.data_cq_armed;
+    cq_armed_list[1]=&transport_global_data.req_cq_armed;
 
     /*
      * Only one thread is allowed to make progress at a time.  All others
@@ -6762,70 +10038,54 @@ static NNTI_result_t progress(
 
             struct ibv_cq *cq=cq_list[i];
 
-            memset(&wc, 0, sizeof(struct ibv_wc));
-
-            log_debug(debug_level, "polling for 1 work completion on cq=%p", cq);
-            trios_start_timer(call_time);
-            ibv_rc = ibv_poll_cq_wrapper(cq, 1, &wc);
-            trios_stop_timer("progress - ibv_poll_cq", call_time);
-
-            log_debug(debug_level, "ibv_poll_cq(cq=%p) rc==%d", cq, ibv_rc);
-
-            if (ibv_rc < 0) {
-                // an error occurred
-                log_debug(debug_level, "ibv_poll_cq failed: %d", ibv_rc);
-            } else if (ibv_rc == 0) {
-                // no work completions in the queue
-            } else  if (ibv_rc > 0) {
-                // got a work completion
-                log_debug(debug_level, "got wc from cq=%p", cq);
-                log_debug(debug_level, "polling status is %s", ibv_wc_status_str(wc.status));
-
-                print_wc(&wc, false);
-                if ((wc.status == IBV_WC_RNR_RETRY_EXC_ERR) ||
-                    (wc.status == IBV_WC_RETRY_EXC_ERR)) {
-                    nnti_rc=NNTI_EDROPPED;
-
-                    ib_work_request *ib_wr=decode_work_request(&wc);
-                    int min_rnr_timer=1;  /* means 0.01ms delay before sending RNR NAK */
-                    int ack_timeout  =17; /* time to wait for ACK/NAK before retransmitting.  4.096us * 2^17 == 0.536ss */
-                    int retry_count;
-                    if (config.drop_if_full_queue) {
-                        retry_count=1; /* number of retries if no answer on primary path or if remote sends RNR NAK */
-                    } else {
-                        retry_count=7; /* number of retries if no answer on primary path or if remote sends RNR NAK.  7 has special meaning of infinite retries. */
-                    }
-                    transition_qp_from_error_to_ready(
-                            ib_wr->conn->req_qp.qp,
-                            ib_wr->conn->peer_req_qpn,
-                            ib_wr->conn->peer_lid,
-                            min_rnr_timer,
-                            ack_timeout,
-                            retry_count);
-
-                } else if (wc.status != IBV_WC_SUCCESS) {
-                    log_error(debug_level, "Failed status %s (%d) for wr_id %lx",
-                            ibv_wc_status_str(wc.status),
-                            wc.status, wc.wr_id);
-                    nnti_rc=NNTI_EIO;
-                }
+            bool repoll=true;
+            while (repoll) {
+                repoll=false;
 
+                log_debug(debug_level, "polling for %d work completions on cq=%p", CQ_POLL_BATCH, cq);
                 trios_start_timer(call_time);
-                ib_work_request *ib_wr=decode_work_request(&wc);
-                trios_stop_timer("progress - decode_work_request", call_time);
-                trios_start_timer(call_time);
-                nthread_lock(&ib_wr->lock);
-                process_event(ib_wr, &wc);
-                nthread_unlock(&ib_wr->lock);
-                trios_stop_timer("progress - process_event", call_time);
+                ibv_rc = ibv_poll_cq_wrapper(cq, CQ_POLL_BATCH, wc_list);
+                trios_stop_timer("progress - ibv_poll_cq", call_time);
+
+                log_debug(debug_level, "ibv_poll_cq(cq=%p) rc==%d", cq, ibv_rc);
 
-                made_progress=true;
+                if (ibv_rc < 0) {
+                    // an error occurred
+                    log_debug(debug_level, "ibv_poll_cq failed: %d", ibv_rc);
+                    break;
+                }
+                if (ibv_rc > 0) {
+                    // got work completions
+                    log_debug(debug_level, "got %d wc from cq=%p", ibv_rc, cq);
+                    process_wc_list(wc_list, ibv_rc, &nnti_rc);
+                    made_progress=true;
+                }
+                if (ibv_rc < CQ_POLL_BATCH) {
+                    // the CQ is drained.  rearm it and poll once more to catch completions that beat the rearm.
+                    repoll=arm_drained_cq(cq, cq_armed_list[i]);
+                }
             }
         }
 
-        if ((!made_progress) && (wr_complete == FALSE)) {
+        check_atomic_callbacks();
+
+        if (wr_complete == TRUE) {
+            // another thread finished our work request before we became the progress maker
+            break;
+        }
+
+        if (!made_progress) {
+            int poll_timeout=timeout-elapsed_time;
+            nthread_lock(&transport_global_data.atomics_lock);
+            if ((atomic_callbacks_watched > 0) &&
+                ((poll_timeout < 0) || (poll_timeout > ATOMIC_CALLBACK_POLL_MS))) {
+                // remote atomics don't wake poll_all(), so look at the watched variables regularly
+                poll_timeout=ATOMIC_CALLBACK_POLL_MS;
+            }
+            nthread_unlock(&transport_global_data.atomics_lock);
+
             trios_start_timer(call_time);
-            rc = poll_all(/*100*/ timeout-elapsed_time);
+            rc = poll_all(/*100*/ poll_timeout);
             trios_stop_timer("progress - poll_all", call_time);
 
             elapsed_time = (trios_get_time_ms() - entry_time);
@@ -6932,6 +10192,16 @@ static void config_init(nnti_ib_config *c)
     c->use_mlock           = true;
     c->use_memset          = true;
     c->drop_if_full_queue  = false;
+    c->use_verbs_emulator  = false;
+    c->max_inline_data     = 256;
+    c->send_signal_interval= 16;
+    c->send_chain_max      = 1;
+    c->request_credits     = 0;
+    c->wr_pool_initial_size= 32;
+    c->wr_pool_max_size    = 16384;
+    c->rdma_chunk_threshold= 64*1024*1024;
+    c->rdma_chunk_size     = 8*1024*1024;
+    c->rdma_chunk_window   = 4;
 }
 
 static void config_get_from_env(nnti_ib_config *c)
@@ -6998,6 +10268,129 @@ static void config_get_from_env(nnti_ib_config *c)
     } else {
         log_debug(nnti_debug_level, "TRIOS_NNTI_USE_MEMSET is undefined.  using c->memset default");
     }
+    if ((env_str=getenv("TRIOS_NNTI_IB_EMULATE_VERBS")) != NULL) {
+        if ((!strcasecmp(env_str, "TRUE")) ||
+            (!strcmp(env_str, "1"))) {
+            log_debug(nnti_debug_level, "setting c->use_verbs_emulator to TRUE");
+            c->use_verbs_emulator=true;
+        } else {
+            log_debug(nnti_debug_level, "setting c->use_verbs_emulator to FALSE");
+            c->use_verbs_emulator=false;
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_IB_EMULATE_VERBS is undefined.  using c->use_verbs_emulator default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_IB_MAX_INLINE")) != NULL) {
+        errno=0;
+        uint32_t max_inline=strtoul(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->max_inline_data to %lu", max_inline);
+            c->max_inline_data=max_inline;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_IB_MAX_INLINE value conversion failed (%s).  using c->max_inline_data default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_IB_MAX_INLINE is undefined.  using c->max_inline_data default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_IB_SIGNAL_INTERVAL")) != NULL) {
+        errno=0;
+        uint32_t interval=strtoul(env_str, NULL, 0);
+        if ((errno == 0) && (interval > 0)) {
+            log_debug(nnti_debug_level, "setting c->send_signal_interval to %lu", interval);
+            c->send_signal_interval=interval;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_IB_SIGNAL_INTERVAL value conversion failed (%s).  using c->send_signal_interval default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_IB_SIGNAL_INTERVAL is undefined.  using c->send_signal_interval default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_IB_SEND_CHAIN")) != NULL) {
+        errno=0;
+        uint32_t chain=strtoul(env_str, NULL, 0);
+        if ((errno == 0) && (chain > 0)) {
+            if (chain > IB_SEND_CHAIN_MAX) {
+                chain=IB_SEND_CHAIN_MAX;
+            }
+            log_debug(nnti_debug_level, "setting c->send_chain_max to %lu", chain);
+            c->send_chain_max=chain;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_IB_SEND_CHAIN value conversion failed (%s).  using c->send_chain_max default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_IB_SEND_CHAIN is undefined.  using c->send_chain_max default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_REQUEST_CREDITS")) != NULL) {
+        errno=0;
+        uint32_t credits=strtoul(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->request_credits to %u", credits);
+            c->request_credits=credits;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_REQUEST_CREDITS value conversion failed (%s).  using c->request_credits default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_REQUEST_CREDITS is undefined.  using c->request_credits default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_WR_POOL_INITIAL_SIZE")) != NULL) {
+        errno=0;
+        uint32_t initial_size=strtoul(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->wr_pool_initial_size to %u", initial_size);
+            c->wr_pool_initial_size=initial_size;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_WR_POOL_INITIAL_SIZE value conversion failed (%s).  using c->wr_pool_initial_size default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_WR_POOL_INITIAL_SIZE is undefined.  using c->wr_pool_initial_size default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_WR_POOL_MAX_SIZE")) != NULL) {
+        errno=0;
+        uint32_t max_size=strtoul(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->wr_pool_max_size to %u", max_size);
+            c->wr_pool_max_size=max_size;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_WR_POOL_MAX_SIZE value conversion failed (%s).  using c->wr_pool_max_size default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_WR_POOL_MAX_SIZE is undefined.  using c->wr_pool_max_size default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD")) != NULL) {
+        errno=0;
+        uint64_t threshold=strtoull(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_threshold to %llu", threshold);
+            c->rdma_chunk_threshold=threshold;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_THRESHOLD value conversion failed (%s).  using c->rdma_chunk_threshold default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_THRESHOLD is undefined.  using c->rdma_chunk_threshold default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_SIZE")) != NULL) {
+        errno=0;
+        uint64_t chunk_size=strtoull(env_str, NULL, 0);
+        if ((errno == 0) && (chunk_size > 0) && (chunk_size <= 0x80000000ULL)) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_size to %llu", chunk_size);
+            c->rdma_chunk_size=chunk_size;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_SIZE value conversion failed (%s).  using c->rdma_chunk_size default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_SIZE is undefined.  using c->rdma_chunk_size default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW")) != NULL) {
+        errno=0;
+        uint32_t window=strtoul(env_str, NULL, 0);
+        if ((errno == 0) && (window > 0)) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_window to %lu", window);
+            c->rdma_chunk_window=window;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_WINDOW value conversion failed (%s).  using c->rdma_chunk_window default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_WINDOW is undefined.  using c->rdma_chunk_window default");
+    }
 }
 
 //static void print_wr(ib_work_request *ib_wr)
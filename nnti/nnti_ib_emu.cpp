@@ -0,0 +1,927 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/**
+ * nnti_ib_emu.cpp
+ *
+ * In-process stand-in for the verbs calls made by nnti_ib.cpp.  See
+ * nnti_ib_emu.h for what is and isn't emulated.
+ */
+
+#include "Trios_config.h"
+
+#include "Trios_logger.h"
+#include "Trios_threads.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include <map>
+#include <deque>
+
+#include "nnti_ib_emu.h"
+#include "nnti_internal.h"
+
+
+#define EMU_MAX_SGE 32
+#define EMU_MAX_INLINE_DATA 512
+
+typedef struct {
+    struct ibv_comp_channel channel;
+    /* write end of the pipe.  channel.fd is the read end. */
+    int                     notify_fd;
+} emu_channel;
+
+typedef struct {
+    struct ibv_cq             cq;
+    std::deque<struct ibv_wc> wcs;
+    /* the next completion writes an event to the channel */
+    bool                      armed;
+} emu_cq;
+
+typedef struct {
+    struct ibv_mr mr;
+    int           access;
+} emu_mr;
+
+typedef struct {
+    uint64_t      wr_id;
+    int           num_sge;
+    struct ibv_sge sg_list[EMU_MAX_SGE];
+} emu_recv;
+
+/*
+ * A message that arrived before a receive was posted.  The sender asked
+ * for infinite RNR retries, so it waits here instead of failing.
+ */
+typedef struct {
+    uint32_t           src_qpn;
+    uint32_t           dst_qpn;
+    enum ibv_wc_opcode recv_opcode;
+    uint32_t           imm_data;
+    int                wc_flags;
+    char              *payload;
+    uint32_t           len;
+    /* completion owed to the sender once the message is delivered */
+    uint64_t           send_wr_id;
+    enum ibv_wc_opcode send_opcode;
+    bool               signaled;
+} emu_pending;
+
+typedef struct {
+    struct ibv_srq          srq;
+    std::deque<emu_recv>    recvs;
+    std::deque<emu_pending> pending;
+} emu_srq;
+
+typedef struct {
+    struct ibv_qp           qp;
+    struct ibv_qp_init_attr init_attr;
+    uint32_t                dest_qp_num;
+    uint8_t                 rnr_retry;
+    int                     access_flags;
+} emu_qp;
+
+typedef std::map<uint32_t, emu_qp *>           emu_qp_map_t;
+typedef std::map<uint32_t, emu_qp *>::iterator emu_qp_map_iter_t;
+typedef std::map<uint32_t, emu_mr *>           emu_mr_map_t;
+typedef std::map<uint32_t, emu_mr *>::iterator emu_mr_map_iter_t;
+
+
+/* one lock covers every emulated object.  posting a send touches both ends. */
+static nthread_lock_t emu_lock;
+static bool           emu_initialized=false;
+
+static struct ibv_device  emu_device;
+static struct ibv_device *emu_device_list[2];
+
+static emu_qp_map_t qps_by_num;
+static emu_mr_map_t mrs_by_rkey;
+
+static uint32_t next_qp_num=0x100;
+
+/* what ibv_emu_post_send() has seen.  read with ibv_emu_get_stats(). */
+static struct ibv_emu_stats emu_stats;
+static uint32_t next_key   =0x1000;
+
+
+static void push_completion(
+        struct ibv_cq       *cq,
+        const struct ibv_wc *wc)
+{
+    emu_cq *ecq=(emu_cq *)cq;
+
+    ecq->wcs.push_back(*wc);
+
+    if (ecq->armed && (cq->channel != NULL)) {
+        emu_channel   *ch=(emu_channel *)cq->channel;
+        struct ibv_cq *ev_cq=cq;
+
+        ecq->armed=false;
+        /* a full pipe already has an event pending, so losing this one is harmless */
+        if (write(ch->notify_fd, &ev_cq, sizeof(ev_cq)) != sizeof(ev_cq)) {
+            log_debug(nnti_debug_level, "failed to write event for cq=%p: %s", cq, strerror(errno));
+        }
+    }
+}
+
+static void complete_send(
+        emu_qp             *qp,
+        uint64_t            wr_id,
+        enum ibv_wc_opcode  opcode,
+        uint32_t            byte_len,
+        enum ibv_wc_status  status,
+        bool                signaled)
+{
+    struct ibv_wc wc;
+
+    if (status != IBV_WC_SUCCESS) {
+        /* errors complete regardless of IBV_SEND_SIGNALED and take the QP down */
+        qp->qp.state=IBV_QPS_ERR;
+    } else if (!signaled) {
+        return;
+    }
+
+    memset(&wc, 0, sizeof(wc));
+    wc.wr_id   =wr_id;
+    wc.status  =status;
+    wc.opcode  =opcode;
+    wc.byte_len=byte_len;
+    wc.qp_num  =qp->qp.qp_num;
+    push_completion(qp->qp.send_cq, &wc);
+}
+
+static emu_qp *find_qp(uint32_t qp_num)
+{
+    emu_qp_map_iter_t iter=qps_by_num.find(qp_num);
+    if (iter == qps_by_num.end()) {
+        return NULL;
+    }
+    return iter->second;
+}
+
+/*
+ * Find the MR that covers [addr, addr+len) and grants <tt>access</tt>.
+ */
+static emu_mr *find_remote_mr(
+        uint32_t rkey,
+        uint64_t addr,
+        uint64_t len,
+        int      access)
+{
+    emu_mr_map_iter_t iter=mrs_by_rkey.find(rkey);
+    if (iter == mrs_by_rkey.end()) {
+        return NULL;
+    }
+    emu_mr  *mr   =iter->second;
+    uint64_t start=(uint64_t)mr->mr.addr;
+    if ((addr < start) || (addr+len > start+mr->mr.length)) {
+        return NULL;
+    }
+    if ((mr->access & access) != access) {
+        return NULL;
+    }
+    return mr;
+}
+
+static uint32_t sge_length(
+        const struct ibv_sge *sg_list,
+        int                   num_sge)
+{
+    uint32_t len=0;
+    for (int i=0;i<num_sge;i++) {
+        len += sg_list[i].length;
+    }
+    return len;
+}
+
+static void gather(
+        char                 *dst,
+        const struct ibv_sge *sg_list,
+        int                   num_sge)
+{
+    for (int i=0;i<num_sge;i++) {
+        memcpy(dst, (void *)sg_list[i].addr, sg_list[i].length);
+        dst += sg_list[i].length;
+    }
+}
+
+static void scatter(
+        const struct ibv_sge *sg_list,
+        int                   num_sge,
+        const char           *src,
+        uint32_t              len)
+{
+    for (int i=0;(i<num_sge) && (len>0);i++) {
+        uint32_t n=(sg_list[i].length < len) ? sg_list[i].length : len;
+        memcpy((void *)sg_list[i].addr, src, n);
+        src += n;
+        len -= n;
+    }
+}
+
+/*
+ * Match a message with the next receive on the destination SRQ and
+ * complete both sides.  Takes ownership of p->payload.
+ */
+static void deliver(
+        emu_srq     *srq,
+        emu_pending *p)
+{
+    struct ibv_wc wc;
+    emu_recv      recv=srq->recvs.front();
+    emu_qp       *dst=find_qp(p->dst_qpn);
+    emu_qp       *src=find_qp(p->src_qpn);
+
+    srq->recvs.pop_front();
+
+    memset(&wc, 0, sizeof(wc));
+    wc.wr_id   =recv.wr_id;
+    wc.status  =IBV_WC_SUCCESS;
+    wc.opcode  =p->recv_opcode;
+    wc.byte_len=p->len;
+    wc.imm_data=p->imm_data;
+    wc.wc_flags=p->wc_flags;
+    wc.qp_num  =p->dst_qpn;
+    wc.src_qp  =p->src_qpn;
+
+    /* write-with-immediate lands in the target MR and never touches the receive buffers */
+    if (p->payload != NULL) {
+        if (p->len > sge_length(recv.sg_list, recv.num_sge)) {
+            wc.status=IBV_WC_LOC_LEN_ERR;
+        } else {
+            scatter(recv.sg_list, recv.num_sge, p->payload, p->len);
+        }
+    }
+
+    if (dst != NULL) {
+        push_completion(dst->qp.recv_cq, &wc);
+    }
+    if (src != NULL) {
+        complete_send(src, p->send_wr_id, p->send_opcode, p->len,
+                (wc.status == IBV_WC_SUCCESS) ? IBV_WC_SUCCESS : IBV_WC_REM_INV_REQ_ERR,
+                p->signaled);
+    }
+
+    free(p->payload);
+    p->payload=NULL;
+}
+
+/*
+ * Hand a message to the peer's SRQ.  With no receive posted the message
+ * waits if the sender retries forever (rnr_retry==7) and fails otherwise.
+ */
+static void send_message(
+        emu_qp      *src,
+        emu_qp      *dst,
+        emu_pending *p)
+{
+    emu_srq *srq=(emu_srq *)dst->qp.srq;
+
+    if (srq == NULL) {
+        log_error(nnti_debug_level, "qp_num=%u has no SRQ.  the emulator only receives through an SRQ.", dst->qp.qp_num);
+        free(p->payload);
+        complete_send(src, p->send_wr_id, p->send_opcode, 0, IBV_WC_REM_OP_ERR, p->signaled);
+        return;
+    }
+
+    if (srq->pending.empty() && !srq->recvs.empty()) {
+        deliver(srq, p);
+    } else if (src->rnr_retry == 7) {
+        log_debug(nnti_debug_level, "no receive posted on srq=%p.  message from qp_num=%u waits.", srq, src->qp.qp_num);
+        srq->pending.push_back(*p);
+    } else {
+        log_debug(nnti_debug_level, "no receive posted on srq=%p.  RNR retries exceeded.", srq);
+        free(p->payload);
+        complete_send(src, p->send_wr_id, p->send_opcode, 0, IBV_WC_RNR_RETRY_EXC_ERR, p->signaled);
+    }
+}
+
+static void execute_send_wr(
+        emu_qp             *qp,
+        struct ibv_send_wr *wr)
+{
+    emu_qp  *peer=NULL;
+    emu_mr  *mr  =NULL;
+    uint32_t len =sge_length(wr->sg_list, wr->num_sge);
+    bool     signaled=(wr->send_flags & IBV_SEND_SIGNALED) || qp->init_attr.sq_sig_all;
+
+    enum ibv_wc_opcode opcode;
+    switch (wr->opcode) {
+        case IBV_WR_RDMA_WRITE:
+        case IBV_WR_RDMA_WRITE_WITH_IMM:
+            opcode=IBV_WC_RDMA_WRITE;
+            break;
+        case IBV_WR_RDMA_READ:
+            opcode=IBV_WC_RDMA_READ;
+            break;
+        case IBV_WR_ATOMIC_FETCH_AND_ADD:
+            opcode=IBV_WC_FETCH_ADD;
+            break;
+        case IBV_WR_ATOMIC_CMP_AND_SWP:
+            opcode=IBV_WC_COMP_SWAP;
+            break;
+        default:
+            opcode=IBV_WC_SEND;
+            break;
+    }
+
+    if (qp->qp.state != IBV_QPS_RTS) {
+        complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_WR_FLUSH_ERR, signaled);
+        return;
+    }
+
+    peer=find_qp(qp->dest_qp_num);
+    if ((peer == NULL) ||
+        ((peer->qp.state != IBV_QPS_RTR) && (peer->qp.state != IBV_QPS_RTS))) {
+        log_debug(nnti_debug_level, "peer qp_num=%u is gone or not ready", qp->dest_qp_num);
+        complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_RETRY_EXC_ERR, signaled);
+        return;
+    }
+
+    switch (wr->opcode) {
+        case IBV_WR_SEND:
+        case IBV_WR_SEND_WITH_IMM:
+        {
+            emu_pending p;
+            memset(&p, 0, sizeof(p));
+            p.src_qpn    =qp->qp.qp_num;
+            p.dst_qpn    =peer->qp.qp_num;
+            p.recv_opcode=IBV_WC_RECV;
+            if (wr->opcode == IBV_WR_SEND_WITH_IMM) {
+                p.imm_data=wr->imm_data;
+                p.wc_flags=IBV_WC_WITH_IMM;
+            }
+            p.payload    =(char *)malloc(len > 0 ? len : 1);
+            p.len        =len;
+            p.send_wr_id =wr->wr_id;
+            p.send_opcode=opcode;
+            p.signaled   =signaled;
+            gather(p.payload, wr->sg_list, wr->num_sge);
+            send_message(qp, peer, &p);
+            break;
+        }
+        case IBV_WR_RDMA_WRITE:
+        case IBV_WR_RDMA_WRITE_WITH_IMM:
+            mr=find_remote_mr(wr->wr.rdma.rkey, wr->wr.rdma.remote_addr, len, IBV_ACCESS_REMOTE_WRITE);
+            if ((mr == NULL) || !(peer->access_flags & IBV_ACCESS_REMOTE_WRITE)) {
+                complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_REM_ACCESS_ERR, signaled);
+                break;
+            }
+            gather((char *)wr->wr.rdma.remote_addr, wr->sg_list, wr->num_sge);
+            if (wr->opcode == IBV_WR_RDMA_WRITE_WITH_IMM) {
+                emu_pending p;
+                memset(&p, 0, sizeof(p));
+                p.src_qpn    =qp->qp.qp_num;
+                p.dst_qpn    =peer->qp.qp_num;
+                p.recv_opcode=IBV_WC_RECV_RDMA_WITH_IMM;
+                p.imm_data   =wr->imm_data;
+                p.wc_flags   =IBV_WC_WITH_IMM;
+                p.payload    =NULL;
+                p.len        =len;
+                p.send_wr_id =wr->wr_id;
+                p.send_opcode=opcode;
+                p.signaled   =signaled;
+                send_message(qp, peer, &p);
+            } else {
+                complete_send(qp, wr->wr_id, opcode, len, IBV_WC_SUCCESS, signaled);
+            }
+            break;
+        case IBV_WR_RDMA_READ:
+            mr=find_remote_mr(wr->wr.rdma.rkey, wr->wr.rdma.remote_addr, len, IBV_ACCESS_REMOTE_READ);
+            if ((mr == NULL) || !(peer->access_flags & IBV_ACCESS_REMOTE_READ)) {
+                complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_REM_ACCESS_ERR, signaled);
+                break;
+            }
+            scatter(wr->sg_list, wr->num_sge, (const char *)wr->wr.rdma.remote_addr, len);
+            complete_send(qp, wr->wr_id, opcode, len, IBV_WC_SUCCESS, signaled);
+            break;
+        case IBV_WR_ATOMIC_FETCH_AND_ADD:
+        case IBV_WR_ATOMIC_CMP_AND_SWP:
+        {
+            mr=find_remote_mr(wr->wr.atomic.rkey, wr->wr.atomic.remote_addr, sizeof(uint64_t), IBV_ACCESS_REMOTE_ATOMIC);
+            if ((mr == NULL) ||
+                !(peer->access_flags & IBV_ACCESS_REMOTE_ATOMIC) ||
+                (wr->wr.atomic.remote_addr % sizeof(uint64_t) != 0) ||
+                (len != sizeof(uint64_t))) {
+                complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_REM_ACCESS_ERR, signaled);
+                break;
+            }
+            /* emu_lock is held, so the read-modify-write is atomic with respect to every other emulated op */
+            uint64_t *target  =(uint64_t *)wr->wr.atomic.remote_addr;
+            uint64_t  original=*target;
+            if (wr->opcode == IBV_WR_ATOMIC_FETCH_AND_ADD) {
+                *target=original + wr->wr.atomic.compare_add;
+            } else if (original == wr->wr.atomic.compare_add) {
+                *target=wr->wr.atomic.swap;
+            }
+            scatter(wr->sg_list, wr->num_sge, (const char *)&original, sizeof(original));
+            complete_send(qp, wr->wr_id, opcode, len, IBV_WC_SUCCESS, signaled);
+            break;
+        }
+        default:
+            complete_send(qp, wr->wr_id, opcode, 0, IBV_WC_LOC_QP_OP_ERR, signaled);
+            break;
+    }
+}
+
+
+struct ibv_device **ibv_emu_get_device_list(
+        int *num_devices)
+{
+    if (!emu_initialized) {
+        nthread_lock_init(&emu_lock);
+        memset(&emu_device, 0, sizeof(emu_device));
+        emu_device.node_type     =IBV_NODE_CA;
+        emu_device.transport_type=IBV_TRANSPORT_IB;
+        strcpy(emu_device.name, "nnti_emu0");
+        strcpy(emu_device.dev_name, "nnti_emu0");
+        emu_device_list[0]=&emu_device;
+        emu_device_list[1]=NULL;
+        emu_initialized=true;
+    }
+
+    log_debug(nnti_debug_level, "emulating verbs with device %s", emu_device.name);
+
+    if (num_devices != NULL) {
+        *num_devices=1;
+    }
+    return emu_device_list;
+}
+
+void ibv_emu_free_device_list(
+        struct ibv_device **list)
+{
+    return;
+}
+
+struct ibv_context *ibv_emu_open_device(
+        struct ibv_device *device)
+{
+    int fds[2];
+
+    /* nobody writes to the async pipe.  it gives the transport a real fd to poke at. */
+    if (pipe(fds) < 0) {
+        log_error(nnti_debug_level, "failed to create async pipe: %s", strerror(errno));
+        return NULL;
+    }
+    close(fds[1]);
+
+    struct ibv_context *ctx=(struct ibv_context *)calloc(1, sizeof(struct ibv_context));
+    ctx->device          =device;
+    ctx->cmd_fd          =-1;
+    ctx->async_fd        =fds[0];
+    ctx->num_comp_vectors=1;
+
+    return ctx;
+}
+
+int ibv_emu_close_device(
+        struct ibv_context *context)
+{
+    close(context->async_fd);
+    free(context);
+    return 0;
+}
+
+int ibv_emu_query_device(
+        struct ibv_context     *context,
+        struct ibv_device_attr *device_attr)
+{
+    memset(device_attr, 0, sizeof(struct ibv_device_attr));
+    strcpy(device_attr->fw_ver, "emulated");
+    device_attr->max_mr_size        =~0ULL;
+    device_attr->max_qp             =65536;
+    device_attr->max_qp_wr          =16384;
+    device_attr->max_sge            =EMU_MAX_SGE;
+    device_attr->max_cq             =65536;
+    device_attr->max_cqe            =65536;
+    device_attr->max_mr             =65536;
+    device_attr->max_pd             =65536;
+    device_attr->max_qp_rd_atom     =16;
+    device_attr->max_qp_init_rd_atom=16;
+    device_attr->atomic_cap         =IBV_ATOMIC_HCA;
+    device_attr->max_srq            =65536;
+    device_attr->max_srq_wr         =16384;
+    device_attr->max_srq_sge        =EMU_MAX_SGE;
+    device_attr->phys_port_cnt      =1;
+
+    return 0;
+}
+
+int ibv_emu_query_port(
+        struct ibv_context   *context,
+        uint8_t               port_num,
+        struct ibv_port_attr *port_attr)
+{
+    memset(port_attr, 0, sizeof(struct ibv_port_attr));
+    port_attr->state     =IBV_PORT_ACTIVE;
+    port_attr->max_mtu   =IBV_MTU_4096;
+    port_attr->active_mtu=IBV_MTU_4096;
+    port_attr->max_msg_sz=0x80000000;
+    port_attr->lid       =1;
+    port_attr->sm_lid    =1;
+    port_attr->link_layer=IBV_LINK_LAYER_INFINIBAND;
+
+    return 0;
+}
+
+struct ibv_pd *ibv_emu_alloc_pd(
+        struct ibv_context *context)
+{
+    struct ibv_pd *pd=(struct ibv_pd *)calloc(1, sizeof(struct ibv_pd));
+    pd->context=context;
+    return pd;
+}
+
+int ibv_emu_dealloc_pd(
+        struct ibv_pd *pd)
+{
+    free(pd);
+    return 0;
+}
+
+struct ibv_mr *ibv_emu_reg_mr(
+        struct ibv_pd *pd,
+        void          *addr,
+        size_t         length,
+        int            access)
+{
+    emu_mr *mr=new emu_mr;
+    memset(&mr->mr, 0, sizeof(mr->mr));
+    mr->access=access;
+
+    nthread_lock(&emu_lock);
+    mr->mr.context=pd->context;
+    mr->mr.pd     =pd;
+    mr->mr.addr   =addr;
+    mr->mr.length =length;
+    mr->mr.lkey   =next_key;
+    mr->mr.rkey   =next_key;
+    next_key++;
+    mrs_by_rkey[mr->mr.rkey]=mr;
+    nthread_unlock(&emu_lock);
+
+    return &mr->mr;
+}
+
+int ibv_emu_dereg_mr(
+        struct ibv_mr *mr)
+{
+    nthread_lock(&emu_lock);
+    mrs_by_rkey.erase(mr->rkey);
+    nthread_unlock(&emu_lock);
+
+    delete (emu_mr *)mr;
+    return 0;
+}
+
+struct ibv_comp_channel *ibv_emu_create_comp_channel(
+        struct ibv_context *context)
+{
+    int fds[2];
+    int flags;
+
+    if (pipe(fds) < 0) {
+        log_error(nnti_debug_level, "failed to create completion pipe: %s", strerror(errno));
+        return NULL;
+    }
+    /* completions are queued with emu_lock held, so never block on a full pipe */
+    flags=fcntl(fds[1], F_GETFL);
+    fcntl(fds[1], F_SETFL, flags | O_NONBLOCK);
+
+    emu_channel *ch=(emu_channel *)calloc(1, sizeof(emu_channel));
+    ch->channel.context=context;
+    ch->channel.fd     =fds[0];
+    ch->notify_fd      =fds[1];
+
+    return &ch->channel;
+}
+
+int ibv_emu_destroy_comp_channel(
+        struct ibv_comp_channel *channel)
+{
+    emu_channel *ch=(emu_channel *)channel;
+    close(ch->channel.fd);
+    close(ch->notify_fd);
+    free(ch);
+    return 0;
+}
+
+struct ibv_cq *ibv_emu_create_cq(
+        struct ibv_context      *context,
+        int                      cqe,
+        void                    *cq_context,
+        struct ibv_comp_channel *channel,
+        int                      comp_vector)
+{
+    emu_cq *cq=new emu_cq;
+    memset(&cq->cq, 0, sizeof(cq->cq));
+    cq->cq.context   =context;
+    cq->cq.channel   =channel;
+    cq->cq.cq_context=cq_context;
+    cq->cq.cqe       =cqe;
+    cq->armed        =false;
+    return &cq->cq;
+}
+
+int ibv_emu_destroy_cq(
+        struct ibv_cq *cq)
+{
+    delete (emu_cq *)cq;
+    return 0;
+}
+
+int ibv_emu_req_notify_cq(
+        struct ibv_cq *cq,
+        int            solicited_only)
+{
+    nthread_lock(&emu_lock);
+    ((emu_cq *)cq)->armed=true;
+    nthread_unlock(&emu_lock);
+    return 0;
+}
+
+int ibv_emu_get_cq_event(
+        struct ibv_comp_channel  *channel,
+        struct ibv_cq           **cq,
+        void                    **cq_context)
+{
+    struct ibv_cq *ev_cq=NULL;
+
+    /* read() sets errno to EAGAIN when the transport has made the fd nonblocking */
+    if (read(channel->fd, &ev_cq, sizeof(ev_cq)) != sizeof(ev_cq)) {
+        return -1;
+    }
+    *cq        =ev_cq;
+    *cq_context=ev_cq->cq_context;
+    return 0;
+}
+
+void ibv_emu_ack_cq_events(
+        struct ibv_cq *cq,
+        unsigned int   nevents)
+{
+    return;
+}
+
+int ibv_emu_poll_cq(
+        struct ibv_cq *cq,
+        int            num_entries,
+        struct ibv_wc *wc)
+{
+    emu_cq *ecq=(emu_cq *)cq;
+    int     count=0;
+
+    nthread_lock(&emu_lock);
+    while ((count < num_entries) && !ecq->wcs.empty()) {
+        wc[count++]=ecq->wcs.front();
+        ecq->wcs.pop_front();
+    }
+    nthread_unlock(&emu_lock);
+
+    return count;
+}
+
+struct ibv_srq *ibv_emu_create_srq(
+        struct ibv_pd            *pd,
+        struct ibv_srq_init_attr *srq_init_attr)
+{
+    emu_srq *srq=new emu_srq;
+    memset(&srq->srq, 0, sizeof(srq->srq));
+    srq->srq.context    =pd->context;
+    srq->srq.srq_context=srq_init_attr->srq_context;
+    srq->srq.pd         =pd;
+    return &srq->srq;
+}
+
+int ibv_emu_destroy_srq(
+        struct ibv_srq *srq)
+{
+    emu_srq *esrq=(emu_srq *)srq;
+
+    nthread_lock(&emu_lock);
+    while (!esrq->pending.empty()) {
+        free(esrq->pending.front().payload);
+        esrq->pending.pop_front();
+    }
+    nthread_unlock(&emu_lock);
+
+    delete esrq;
+    return 0;
+}
+
+int ibv_emu_post_srq_recv(
+        struct ibv_srq      *srq,
+        struct ibv_recv_wr  *recv_wr,
+        struct ibv_recv_wr **bad_recv_wr)
+{
+    emu_srq *esrq=(emu_srq *)srq;
+
+    nthread_lock(&emu_lock);
+    for (struct ibv_recv_wr *wr=recv_wr;wr!=NULL;wr=wr->next) {
+        if (wr->num_sge > EMU_MAX_SGE) {
+            nthread_unlock(&emu_lock);
+            *bad_recv_wr=wr;
+            return EINVAL;
+        }
+        emu_recv recv;
+        recv.wr_id  =wr->wr_id;
+        recv.num_sge=wr->num_sge;
+        memcpy(recv.sg_list, wr->sg_list, wr->num_sge*sizeof(struct ibv_sge));
+        esrq->recvs.push_back(recv);
+    }
+    /* messages that were waiting for a receive go first */
+    while (!esrq->pending.empty() && !esrq->recvs.empty()) {
+        emu_pending p=esrq->pending.front();
+        esrq->pending.pop_front();
+        deliver(esrq, &p);
+    }
+    nthread_unlock(&emu_lock);
+
+    return 0;
+}
+
+struct ibv_qp *ibv_emu_create_qp(
+        struct ibv_pd           *pd,
+        struct ibv_qp_init_attr *qp_init_attr)
+{
+    emu_qp *qp;
+
+    /* like an HCA, refuse rather than silently shrink an inline request */
+    if (qp_init_attr->cap.max_inline_data > EMU_MAX_INLINE_DATA) {
+        errno=EINVAL;
+        return NULL;
+    }
+
+    qp=new emu_qp;
+    memset(qp, 0, sizeof(emu_qp));
+    qp->init_attr     =*qp_init_attr;
+    qp->qp.context    =pd->context;
+    qp->qp.qp_context =qp_init_attr->qp_context;
+    qp->qp.pd         =pd;
+    qp->qp.send_cq    =qp_init_attr->send_cq;
+    qp->qp.recv_cq    =qp_init_attr->recv_cq;
+    qp->qp.srq        =qp_init_attr->srq;
+    qp->qp.state      =IBV_QPS_RESET;
+    qp->qp.qp_type    =qp_init_attr->qp_type;
+
+    nthread_lock(&emu_lock);
+    qp->qp.qp_num=next_qp_num++;
+    qps_by_num[qp->qp.qp_num]=qp;
+    nthread_unlock(&emu_lock);
+
+    return &qp->qp;
+}
+
+int ibv_emu_destroy_qp(
+        struct ibv_qp *qp)
+{
+    nthread_lock(&emu_lock);
+    qps_by_num.erase(qp->qp_num);
+    nthread_unlock(&emu_lock);
+
+    delete (emu_qp *)qp;
+    return 0;
+}
+
+int ibv_emu_modify_qp(
+        struct ibv_qp      *qp,
+        struct ibv_qp_attr *attr,
+        int                 attr_mask)
+{
+    emu_qp *eqp=(emu_qp *)qp;
+
+    nthread_lock(&emu_lock);
+    if (attr_mask & IBV_QP_STATE) {
+        eqp->qp.state=attr->qp_state;
+    }
+    if (attr_mask & IBV_QP_ACCESS_FLAGS) {
+        eqp->access_flags=attr->qp_access_flags;
+    }
+    if (attr_mask & IBV_QP_DEST_QPN) {
+        eqp->dest_qp_num=attr->dest_qp_num;
+    }
+    if (attr_mask & IBV_QP_RNR_RETRY) {
+        eqp->rnr_retry=attr->rnr_retry;
+    }
+    nthread_unlock(&emu_lock);
+
+    return 0;
+}
+
+int ibv_emu_query_qp(
+        struct ibv_qp           *qp,
+        struct ibv_qp_attr      *attr,
+        int                      attr_mask,
+        struct ibv_qp_init_attr *init_attr)
+{
+    emu_qp *eqp=(emu_qp *)qp;
+
+    memset(attr, 0, sizeof(struct ibv_qp_attr));
+
+    nthread_lock(&emu_lock);
+    attr->qp_state       =eqp->qp.state;
+    attr->cur_qp_state   =eqp->qp.state;
+    attr->qp_access_flags=eqp->access_flags;
+    attr->dest_qp_num    =eqp->dest_qp_num;
+    attr->rnr_retry      =eqp->rnr_retry;
+    attr->cap            =eqp->init_attr.cap;
+    *init_attr           =eqp->init_attr;
+    nthread_unlock(&emu_lock);
+
+    return 0;
+}
+
+int ibv_emu_post_send(
+        struct ibv_qp       *qp,
+        struct ibv_send_wr  *wr,
+        struct ibv_send_wr **bad_wr)
+{
+    emu_qp *eqp=(emu_qp *)qp;
+
+    nthread_lock(&emu_lock);
+    emu_stats.post_send_calls++;
+    for (;wr!=NULL;wr=wr->next) {
+        if ((eqp->qp.state == IBV_QPS_RESET) ||
+            (eqp->qp.state == IBV_QPS_INIT)  ||
+            (eqp->qp.state == IBV_QPS_RTR)) {
+            nthread_unlock(&emu_lock);
+            *bad_wr=wr;
+            return EINVAL;
+        }
+        if (wr->send_flags & IBV_SEND_INLINE) {
+            uint64_t inline_len=0;
+            for (int i=0;i<wr->num_sge;i++) {
+                inline_len += wr->sg_list[i].length;
+            }
+            if ((inline_len > eqp->init_attr.cap.max_inline_data) ||
+                (wr->opcode == IBV_WR_RDMA_READ) ||
+                (wr->opcode == IBV_WR_ATOMIC_CMP_AND_SWP) ||
+                (wr->opcode == IBV_WR_ATOMIC_FETCH_AND_ADD)) {
+                nthread_unlock(&emu_lock);
+                *bad_wr=wr;
+                return EINVAL;
+            }
+            emu_stats.inline_wrs++;
+        }
+        emu_stats.send_wrs++;
+        if ((wr->send_flags & IBV_SEND_SIGNALED) || eqp->init_attr.sq_sig_all) {
+            emu_stats.signaled_wrs++;
+        }
+        execute_send_wr(eqp, wr);
+    }
+    nthread_unlock(&emu_lock);
+
+    return 0;
+}
+
+void ibv_emu_get_stats(
+        struct ibv_emu_stats *stats)
+{
+    nthread_lock(&emu_lock);
+    *stats=emu_stats;
+    nthread_unlock(&emu_lock);
+}
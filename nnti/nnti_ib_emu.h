@@ -0,0 +1,187 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*-------------------------------------------------------------------------*/
+/**  @file nnti_ib_emu.h
+ *
+ *   @brief In-process emulation of the verbs calls used by the IB transport.
+ *
+ *   The emulator stands in for an HCA so the InfiniBand transport can be
+ *   exercised on machines without one.  It is selected at runtime with
+ *   TRIOS_NNTI_IB_EMULATE_VERBS.  The ibv_*_wrapper functions in nnti_ib.cpp
+ *   call these instead of libibverbs when it is enabled.
+ *
+ *   Every queue pair lives in the calling process.  Sends, RDMA and atomics
+ *   are carried out with memcpy when they are posted, and completions are
+ *   queued on the CQ right away.  Both ends of a connection must be in the
+ *   same process, so only self-connections work and the transport refuses
+ *   to connect to another process.  Tests that need a client and a server
+ *   process (NntiPerfTest, for example) still need an HCA.
+ *
+ */
+
+#ifndef _NNTI_IB_EMU_H_
+#define _NNTI_IB_EMU_H_
+
+#include "Trios_config.h"
+
+#include <verbs.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Counters kept by ibv_emu_post_send().
+ *
+ * Lets tests check how the transport drives the send queue (doorbells,
+ * inline and signaled work requests) without real hardware.
+ */
+struct ibv_emu_stats {
+    /** number of ibv_emu_post_send() calls (doorbells) */
+    uint64_t post_send_calls;
+    /** work requests posted to a send queue */
+    uint64_t send_wrs;
+    /** work requests posted with IBV_SEND_INLINE */
+    uint64_t inline_wrs;
+    /** work requests that will generate a completion */
+    uint64_t signaled_wrs;
+};
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+    extern struct ibv_device **ibv_emu_get_device_list(
+            int *num_devices);
+    extern void ibv_emu_free_device_list(
+            struct ibv_device **list);
+    extern struct ibv_context *ibv_emu_open_device(
+            struct ibv_device *device);
+    extern int ibv_emu_close_device(
+            struct ibv_context *context);
+    extern int ibv_emu_query_device(
+            struct ibv_context     *context,
+            struct ibv_device_attr *device_attr);
+    extern int ibv_emu_query_port(
+            struct ibv_context   *context,
+            uint8_t               port_num,
+            struct ibv_port_attr *port_attr);
+
+    extern struct ibv_pd *ibv_emu_alloc_pd(
+            struct ibv_context *context);
+    extern int ibv_emu_dealloc_pd(
+            struct ibv_pd *pd);
+    extern struct ibv_mr *ibv_emu_reg_mr(
+            struct ibv_pd *pd,
+            void          *addr,
+            size_t         length,
+            int            access);
+    extern int ibv_emu_dereg_mr(
+            struct ibv_mr *mr);
+
+    extern struct ibv_comp_channel *ibv_emu_create_comp_channel(
+            struct ibv_context *context);
+    extern int ibv_emu_destroy_comp_channel(
+            struct ibv_comp_channel *channel);
+    extern struct ibv_cq *ibv_emu_create_cq(
+            struct ibv_context      *context,
+            int                      cqe,
+            void                    *cq_context,
+            struct ibv_comp_channel *channel,
+            int                      comp_vector);
+    extern int ibv_emu_destroy_cq(
+            struct ibv_cq *cq);
+    extern int ibv_emu_req_notify_cq(
+            struct ibv_cq *cq,
+            int            solicited_only);
+    extern int ibv_emu_get_cq_event(
+            struct ibv_comp_channel  *channel,
+            struct ibv_cq           **cq,
+            void                    **cq_context);
+    extern void ibv_emu_ack_cq_events(
+            struct ibv_cq *cq,
+            unsigned int   nevents);
+    extern int ibv_emu_poll_cq(
+            struct ibv_cq *cq,
+            int            num_entries,
+            struct ibv_wc *wc);
+
+    extern struct ibv_srq *ibv_emu_create_srq(
+            struct ibv_pd           *pd,
+            struct ibv_srq_init_attr *srq_init_attr);
+    extern int ibv_emu_destroy_srq(
+            struct ibv_srq *srq);
+    extern int ibv_emu_post_srq_recv(
+            struct ibv_srq      *srq,
+            struct ibv_recv_wr  *recv_wr,
+            struct ibv_recv_wr **bad_recv_wr);
+
+    extern struct ibv_qp *ibv_emu_create_qp(
+            struct ibv_pd           *pd,
+            struct ibv_qp_init_attr *qp_init_attr);
+    extern int ibv_emu_destroy_qp(
+            struct ibv_qp *qp);
+    extern int ibv_emu_modify_qp(
+            struct ibv_qp      *qp,
+            struct ibv_qp_attr *attr,
+            int                 attr_mask);
+    extern int ibv_emu_query_qp(
+            struct ibv_qp           *qp,
+            struct ibv_qp_attr      *attr,
+            int                      attr_mask,
+            struct ibv_qp_init_attr *init_attr);
+    extern int ibv_emu_post_send(
+            struct ibv_qp       *qp,
+            struct ibv_send_wr  *wr,
+            struct ibv_send_wr **bad_wr);
+
+    extern void ibv_emu_get_stats(
+            struct ibv_emu_stats *stats);
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -51,6 +51,7 @@
 #define NNTI_INTERNAL_H_
 
 #include "Trios_logger.h"
+#include "Trios_threads.h"
 
 #include "Trios_nnti.h"
 #include <Trios_nnti_xdr.h>
@@ -207,6 +208,116 @@ typedef NNTI_result_t (*NNTI_WAITALL_FN) (
         const int             timeout,
         NNTI_status_t       **status);
 
+typedef NNTI_result_t (*NNTI_DEQUEUE_REQUESTS_FN) (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count);
+
+typedef NNTI_result_t (*NNTI_RELEASE_REQUESTS_FN) (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count);
+
+typedef NNTI_result_t (*NNTI_PUT_STREAM_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t *wr);
+
+typedef NNTI_result_t (*NNTI_PUTV_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+
+typedef NNTI_result_t (*NNTI_GETV_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+
+typedef NNTI_result_t (*NNTI_PUT_NOTIFY_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr);
+
+typedef NNTI_result_t (*NNTI_COUNTER_BIND_FN) (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter);
+
+typedef NNTI_result_t (*NNTI_COUNTER_WAIT_FN) (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value);
+
+typedef NNTI_result_t (*NNTI_SEND_IMPLICIT_FN) (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl);
+
+typedef NNTI_result_t (*NNTI_PUT_IMPLICIT_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+typedef NNTI_result_t (*NNTI_GET_IMPLICIT_FN) (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+typedef NNTI_result_t (*NNTI_ATOMIC_SET_THRESHOLD_CALLBACK_FN) (
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          local_atomic,
+        const int64_t           threshold,
+        NNTI_callback_fn_t      cbfunc,
+        void                   *context);
+
+typedef NNTI_result_t (*NNTI_ATOMIC_FOP_BUFFER_FN) (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           operand,
+        const NNTI_atomic_op_t  op,
+        NNTI_work_request_t    *wr);
+
+typedef NNTI_result_t (*NNTI_ATOMIC_CSWAP_BUFFER_FN) (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           compare_operand,
+        const int64_t           swap_operand,
+        NNTI_work_request_t    *wr);
+
+typedef NNTI_result_t (*NNTI_ATOMIC_FOPV_FN) (
+        const NNTI_transport_t     *trans_hdl,
+        const NNTI_peer_t          *peer_hdl,
+        const NNTI_atomic_update_t *updates,
+        const uint32_t              update_count,
+        NNTI_work_request_t        *wr);
+
+/* a NULL peer_hdl flushes every peer */
+typedef NNTI_result_t (*NNTI_FLUSH_FN) (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout);
+
 typedef NNTI_result_t (*NNTI_FINI_FN) (
         const NNTI_transport_t *trans_hdl);
 
@@ -240,9 +351,64 @@ typedef struct NNTI_transport_ops_t
     NNTI_WAITANY_FN              nnti_waitany_fn;
     NNTI_WAITALL_FN              nnti_waitall_fn;
     NNTI_FINI_FN                 nnti_fini_fn;
+    /* optional ops.  NULL means the transport doesn't support the operation. */
+    NNTI_DEQUEUE_REQUESTS_FN     nnti_dequeue_requests_fn;
+    NNTI_RELEASE_REQUESTS_FN     nnti_release_requests_fn;
+    NNTI_PUT_STREAM_FN           nnti_put_stream_fn;
+    NNTI_PUTV_FN                 nnti_putv_fn;
+    NNTI_GETV_FN                 nnti_getv_fn;
+    NNTI_PUT_NOTIFY_FN           nnti_put_notify_fn;
+    NNTI_COUNTER_BIND_FN         nnti_counter_bind_fn;
+    NNTI_COUNTER_WAIT_FN         nnti_counter_wait_fn;
+    NNTI_SEND_IMPLICIT_FN        nnti_send_implicit_fn;
+    NNTI_PUT_IMPLICIT_FN         nnti_put_implicit_fn;
+    NNTI_GET_IMPLICIT_FN         nnti_get_implicit_fn;
+    NNTI_FLUSH_FN                nnti_flush_fn;
+    NNTI_ATOMIC_FOP_BUFFER_FN    nnti_atomic_fop_buffer_fn;
+    NNTI_ATOMIC_CSWAP_BUFFER_FN  nnti_atomic_cswap_buffer_fn;
+    NNTI_ATOMIC_SET_THRESHOLD_CALLBACK_FN nnti_atomic_set_threshold_callback_fn;
+    NNTI_ATOMIC_FOPV_FN          nnti_atomic_fopv_fn;
 } NNTI_transport_ops_t;
 
 
+/**
+ * @brief A target completion counter (see NNTI_counter_create()).
+ *
+ * Transports keep a pointer to the counter in the memory handle of each
+ * buffer bound to it and add one as each put or get on the buffer completes.
+ */
+typedef struct {
+    nthread_counter_t value;
+} nnti_counter;
+
+#define NNTI_COUNTER(c) ((nnti_counter *)(c)->transport_private)
+
+
+/**
+ * @brief Occupancy of a transport's work request pool.
+ *
+ * Filled in by NNTI_ib_get_wr_pool_stats() and NNTI_gni_get_wr_pool_stats().
+ */
+typedef struct {
+    /** @brief Work requests owned by the pool (free or in use). */
+    uint32_t size;
+    /** @brief Work requests waiting in the pool. */
+    uint32_t free;
+    /** @brief Work requests popped and not yet pushed back. */
+    uint32_t in_use;
+    /** @brief Sum of each shard's most work requests in use at once. */
+    uint32_t high_water;
+    /** @brief Pops served from the pool. */
+    uint64_t pops;
+    /** @brief Times an empty shard took work requests from another. */
+    uint64_t steals;
+    /** @brief Chunks added after init. */
+    uint64_t grows;
+    /** @brief Work requests allocated outside the pool because it was at its max size. */
+    uint64_t overflows;
+} nnti_wr_pool_stats;
+
+
 /**
  * @brief The internal representation of a configured transport.
  */
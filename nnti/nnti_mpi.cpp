@@ -60,6 +60,7 @@
 
 #include <assert.h>
 #include <string.h>
+#include <limits.h>
 
 #include <map>
 #include <deque>
@@ -67,6 +68,7 @@
 
 #include "nnti_mpi.h"
 #include "nnti_utils.h"
+#include "nnti_credits.h"
 
 
 
@@ -90,12 +92,26 @@ typedef struct {
 
 	uint32_t min_atomics_vars;
 
+	/* the most request queue credits offered to each client.  0 disables flow control. */
+	uint32_t request_credits;
+
+	/* put/get transfers larger than rdma_chunk_threshold bytes are split
+	 * into rdma_chunk_size byte messages with at most rdma_chunk_window
+	 * of them in flight.  a threshold of 0 disables chunking. */
+	uint64_t rdma_chunk_threshold;
+	uint64_t rdma_chunk_size;
+	uint32_t rdma_chunk_window;
+
 } nnti_mpi_config;
 
 
 #define NNTI_MPI_REQUEST_TAG          0x01
 #define NNTI_MPI_ATOMICS_REQUEST_TAG  0x02
 #define NNTI_MPI_ATOMICS_RESULT_TAG   0x03
+#define NNTI_MPI_CREDIT_TAG           0x04
+#define NNTI_MPI_ATOMICS_VECTOR_TAG   0x05
+#define NNTI_MPI_CONNECT_TAG          0x06
+#define NNTI_MPI_CONNECT_REPLY_TAG    0x07
 
 
 #define MPI_OP_PUT_INITIATOR  1
@@ -125,23 +141,49 @@ typedef struct {
     uint64_t offset;
     uint64_t length;
     int32_t  tag;
+    /* request queue credits returned to the receiver of this command */
+    uint32_t credits;
+    /* size of each data message.  0 if the data is one message. */
+    uint64_t chunk_size;
     uint8_t  op;
+    /* TRUE if the target raises an event per chunk (see NNTI_mpi_put_stream()) */
+    uint8_t  stream;
+    /*
+     * number of regions in a vectored put/get.  the list follows the
+     * command on the target's put data tag (see NNTI_mpi_putv()).
+     */
+    uint32_t iov_count;
+    /* the value of an NNTI_mpi_put_notify().  delivered in the target's status. */
+    uint64_t imm;
 } mpi_command_msg;
 
+/* request queue credits returned in a message of their own or offered at connect */
+typedef struct {
+    uint32_t    credits;
+    MPI_Request request;
+} mpi_credit_msg;
+
 typedef enum {
-	MPI_ATOMIC_FETCH_ADD  =1,
-	MPI_ATOMIC_CMP_AND_SWP=2
+	MPI_ATOMIC_FOP        =1,
+	MPI_ATOMIC_CMP_AND_SWP=2,
+	MPI_ATOMIC_VECTOR     =3
 } mpi_atomic_op_t;
 
 typedef struct {
     int64_t  compare_add;
     int64_t  swap;
-    uint32_t index;
+    uint64_t offset;      /* of the variable in the buffer named by buffer_tag */
+    uint32_t index;       /* or the number of updates of an MPI_ATOMIC_VECTOR */
+    uint32_t buffer_tag;  /* cmd_tag of the target buffer */
     uint8_t  op;
+    uint8_t  nnti_op;     /* the NNTI_atomic_op_t of an MPI_ATOMIC_FOP */
+    uint8_t  reply;       /* the target sends the previous value back */
+    uint8_t  on_buffer;   /* the target is in a buffer, not the atomics table */
 } mpi_atomic_request_msg;
 
 typedef struct {
     int64_t result;
+    int32_t status;  /* NNTI_OK, or why the target didn't apply the op */
 } mpi_atomic_result_msg;
 
 #define RDMA_CMD_INDEX      0
@@ -153,8 +195,9 @@ typedef struct {
 #define RECV_INDEX          6
 #define ATOMICS_SEND_INDEX  7
 #define ATOMICS_RECV_INDEX  8
+#define ATOMICS_VECTOR_INDEX 9
 
-#define MAX_INDEX           9
+#define MAX_INDEX           10
 
 #define RDMA_CMD_REQUEST_ACTIVE      0x001
 #define SEND_REQUEST_ACTIVE          0x002
@@ -165,6 +208,7 @@ typedef struct {
 #define RECV_REQUEST_ACTIVE          0x040
 #define ATOMICS_SEND_REQUEST_ACTIVE  0x080
 #define ATOMICS_RECV_REQUEST_ACTIVE  0x100
+#define ATOMICS_VECTOR_REQUEST_ACTIVE 0x200
 
 typedef struct mpi_work_request {
     NNTI_work_request_t *nnti_wr;
@@ -179,11 +223,47 @@ typedef struct mpi_work_request {
     MPI_Request    *request_ptr;
     uint32_t        request_count;
     int             request_index;
-    uint8_t         active_requests;
+    uint16_t        active_requests;
 
     mpi_command_msg cmd_msg;
 
-    int             atomics_result_index;
+    /*
+     * a chunked put or get moves the data in chunk_count messages.  chunk i
+     * uses chunk_request[i % chunk_window].  only the oldest unfinished
+     * chunk is exposed through request_ptr, so the wait functions see one
+     * MPI_Request per work request.
+     */
+    char           *chunk_base;
+    uint64_t        chunk_length;
+    uint64_t        chunk_size;
+    int             chunk_rank;
+    int             chunk_tag;
+    int8_t          chunk_is_send;
+    uint32_t        chunk_count;
+    uint32_t        chunk_window;
+    uint32_t        chunk_posted;
+    uint32_t        chunk_retired;
+    MPI_Request    *chunk_request;
+    /* chunks of a streaming put delivered to the target's waiter */
+    uint32_t        stream_delivered;
+
+    /* the region list of a vectored put/get.  the initiator keeps it until it has been sent. */
+    NNTI_iovec_t   *iov;
+    MPI_Request     iov_request;
+
+    int                    atomics_result_index;
+    int64_t               *atomics_result;  /* where a buffer atomic lands the previous value */
+    mpi_atomic_request_msg atomics_request_msg;
+    mpi_atomic_result_msg  atomics_result_msg;
+    /*
+     * the updates of a vectored atomic follow the request on
+     * NNTI_MPI_ATOMICS_VECTOR_TAG.  the previous values come back in
+     * atomics_results, one per update, followed by the status of the
+     * vector in atomics_results[atomics_update_count].
+     */
+    NNTI_atomic_update_t  *atomics_updates;
+    uint32_t               atomics_update_count;
+    int64_t               *atomics_results;
 
     mpi_op_state_t  op_state;
 
@@ -202,6 +282,9 @@ typedef struct mpi_memory_handle {
 
     wr_queue_t     wr_queue;
     nthread_lock_t wr_queue_lock;
+
+    /* completed puts and gets are counted here instead of raising events (see NNTI_mpi_counter_bind()) */
+    nnti_counter  *counter;
 } mpi_memory_handle;
 
 
@@ -221,11 +304,92 @@ typedef struct mpi_request_queue_handle {
     MPI_Request *mpi_request_list;
     uint64_t     last_request_index;
 
+    /*
+     * requests completed by MPI_Testsome() but not yet handed out by
+     * NNTI_mpi_dequeue_requests().  a ring of req_count entries.
+     */
+    nthread_lock_t ready_lock;
+    int           *ready_index;
+    MPI_Status    *ready_event;
+    uint32_t       ready_head;
+    uint32_t       ready_count;
+    int           *testsome_index;
+    MPI_Status    *testsome_event;
+    /*
+     * MPI matches receives in the order they were posted.  ordering a
+     * MPI_Testsome() batch by post sequence restores arrival order.
+     */
+    uint64_t      *post_seq;
+    uint64_t       next_post_seq;
+    /* sender of the request in each loaned slot */
+    int           *slot_src;
+
 } mpi_request_queue_handle;
 
+/*
+ * A request ring packs incoming requests back to back into one contiguous
+ * buffer.  Each request is preceded by a record header and padded to
+ * RING_RECORD_ALIGN bytes.  A record that doesn't fit before the end of the
+ * ring is preceded by a SKIP record and placed at the start of the ring.
+ *
+ * Requests are matched with MPI_Improbe() so the length is known before
+ * space is reserved.  When the ring is full the matched message is held
+ * until enough records are released, which in turn holds off the sender.
+ */
+#define RING_RECORD_ALIGN 16
+#define RING_RECORD_SIZE(len) (sizeof(mpi_ring_record_hdr) + (((len) + RING_RECORD_ALIGN - 1) & ~((uint64_t)RING_RECORD_ALIGN - 1)))
+
+typedef enum {
+    RING_RECORD_READY=1,
+    RING_RECORD_LOANED,
+    RING_RECORD_RELEASED,
+    RING_RECORD_SKIP
+} mpi_ring_record_state_t;
+
+typedef struct {
+    /* length of the request that follows the header */
+    uint32_t length;
+    /* number of ring bytes used by this record including the header */
+    uint32_t size;
+    int32_t  src_rank;
+    uint32_t state;
+} mpi_ring_record_hdr;
+
+typedef struct mpi_request_ring_handle {
+    NNTI_buffer_t *reg_buf;
+
+    char     *ring;
+    uint64_t  ring_size;
+
+    /* next record is written here */
+    uint64_t  head;
+    /* oldest record that hasn't been released */
+    uint64_t  tail;
+    /* oldest record that hasn't been handed out */
+    uint64_t  deliver;
+    /* bytes between tail and head */
+    uint64_t  used;
+    /* records between deliver and head */
+    uint64_t  ready_count;
+
+    /* a matched request that is waiting for ring space */
+    bool          have_pending;
+    MPI_Message   pending_msg;
+    MPI_Status    pending_event;
+
+    nthread_lock_t lock;
+} mpi_request_ring_handle;
+
 typedef struct {
 	nthread_lock_t lock;
 	int64_t        value;
+
+	/* see NNTI_mpi_atomic_set_threshold_callback() */
+	NNTI_callback_fn_t      cbfunc;
+	void                   *context;
+	const NNTI_transport_t *trans_hdl;
+	int64_t                 threshold;
+	int8_t                  use_threshold;
 } mpi_atomic_t;
 
 typedef struct mpi_transport_global {
@@ -237,14 +401,28 @@ typedef struct mpi_transport_global {
     MPI_Comm nnti_comm;
 
     nthread_counter_t mbits;
+    /* tags for chunked transfers, see chunk_tag() */
+    nthread_counter_t put_chunk_tags;
+    nthread_counter_t get_chunk_tags;
+    int64_t           chunk_tag_span;
 
     mpi_request_queue_handle req_queue;
+    mpi_request_ring_handle  req_ring;
 
     mpi_atomic_t           *atomics;
     mpi_atomic_request_msg  atomics_request_msg;
     mpi_atomic_result_msg   atomics_result_msg;
     MPI_Request             atomics_recv_request;
     MPI_Request             atomics_send_request;
+    /*
+     * the updates of a vectored atomic being received from
+     * atomics_vector_source.  the next atomic request isn't received until
+     * they're applied, so the replies go out in request order.
+     */
+    NNTI_atomic_update_t   *atomics_vector_updates;
+    uint32_t                atomics_vector_count;
+    int                     atomics_vector_source;
+    MPI_Request             atomics_vector_request;
 
     bool init_called_mpi_init;
 
@@ -260,7 +438,54 @@ static int process_event(
         const MPI_Status *event);
 static NNTI_result_t setup_atomics(void);
 static int check_atomic_operation(void);
+static void atomic_vector_recv(
+        const uint32_t update_count,
+        const int      source);
+static int atomic_vector_check(void);
+static void atomic_vector_apply(
+        NNTI_atomic_update_t *updates,
+        const uint32_t        update_count,
+        const int             source,
+        NNTI_result_t         status);
+static void atomic_vector_release(
+        mpi_work_request *mpi_wr,
+        const int         land_results);
+static NNTI_result_t mpi_atomic_start(
+        const NNTI_transport_id_t transport_id,
+        const NNTI_peer_t        *peer_hdl,
+        mpi_work_request         *mpi_wr,
+        NNTI_work_request_t      *wr);
 static int check_target_buffer_progress(void);
+static int check_request_ring_progress(void);
+static int check_control_messages(void);
+static uint32_t request_credit_offer(void);
+static NNTI_result_t exchange_request_credits(
+        const int rank,
+        const int timeout);
+static NNTI_result_t implicit_track(
+        NNTI_work_request_t *wr,
+        NNTI_result_t        rc);
+static uint32_t check_implicit_progress(
+        const int rank);
+static void return_request_credits(
+        int      rank,
+        uint32_t credits);
+static int64_t ring_reserve(
+        mpi_request_ring_handle *ring,
+        uint64_t                 need);
+static int64_t ring_deliver(
+        mpi_request_ring_handle *ring);
+static void ring_release(
+        mpi_request_ring_handle *ring,
+        uint64_t                 offset);
+static void create_ring_status(
+        mpi_request_ring_handle *ring,
+        uint64_t                 offset,
+        NNTI_status_t           *status);
+static NNTI_result_t ring_wait(
+        NNTI_work_request_t  *wr,
+        const int             timeout,
+        NNTI_status_t        *status);
 static NNTI_result_t post_atomics_recv_request(void);
 static NNTI_result_t post_recv_queue_work_request(
         NNTI_buffer_t    *reg_buf,
@@ -274,6 +499,66 @@ static NNTI_result_t repost_recv_work_request(
         mpi_work_request *mpi_wr);
 static NNTI_result_t repost_rdma_target_work_request(
         mpi_work_request *mpi_wr);
+static int chunk_tag(
+        const int8_t      is_put);
+static int chunk_start(
+        mpi_work_request *mpi_wr,
+        char             *base,
+        uint64_t          length,
+        uint64_t          chunk_size,
+        int               rank,
+        int               tag,
+        int8_t            is_send,
+        uint32_t          window);
+static int chunk_post(
+        mpi_work_request *mpi_wr);
+static int8_t chunk_progress(
+        mpi_work_request *mpi_wr,
+        MPI_Request      *done_slot);
+static void stream_deliver(
+        mpi_work_request *mpi_wr);
+static NNTI_result_t mpi_put(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       stream_chunk,
+        const uint64_t       imm,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+static NNTI_result_t mpi_get(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr);
+static NNTI_result_t check_iovec(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count);
+static int iovec_type(
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int8_t        src_side,
+        MPI_Datatype       *type);
+static int iovec_send(
+        mpi_work_request   *mpi_wr,
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int           rank,
+        const int           tag);
+static int iovec_recv(
+        mpi_work_request *mpi_wr,
+        const int         rank,
+        const int         tag);
+static void iovec_release(
+        mpi_work_request *mpi_wr);
 static int is_wr_complete(
         mpi_work_request *mpi_wr);
 static int8_t is_wr_complete(
@@ -314,6 +599,11 @@ typedef std::map<uint32_t, NNTI_buffer_t *>::iterator buf_by_bufhash_iter_t;
 typedef std::pair<uint32_t, NNTI_buffer_t *> buf_by_bufhash_t;
 static nthread_lock_t nnti_buf_bufhash_lock;
 
+/* buffers registered with NNTI_BOP_ATOMICS, by cmd_tag */
+static std::map<uint32_t, NNTI_buffer_t *> atomic_buffers_by_tag;
+typedef std::map<uint32_t, NNTI_buffer_t *>::iterator atomic_buf_by_tag_iter_t;
+static nthread_lock_t nnti_atomic_buffers_lock;
+
 static std::map<uint32_t, mpi_work_request *> wr_by_wrhash;
 typedef std::map<uint32_t, mpi_work_request *>::iterator wr_by_wrhash_iter_t;
 typedef std::pair<uint32_t, mpi_work_request *> wr_by_wrhash_t;
@@ -329,6 +619,32 @@ target_buffer_queue_t target_buffers;
 static nnti_mpi_config config;
 
 
+static nnti_credit_table_t request_credits;
+
+typedef std::deque<mpi_credit_msg *>           credit_msg_queue_t;
+typedef std::deque<mpi_credit_msg *>::iterator credit_msg_queue_iter_t;
+static nthread_lock_t                         nnti_credit_msgs_lock;
+
+credit_msg_queue_t credit_msgs;
+
+/*
+ * Implicit operations that haven't completed yet (see NNTI_mpi_flush()).
+ * MPI only moves a transfer along while its requests are tested, so these
+ * are kept instead of a bare count.
+ */
+typedef std::deque<mpi_work_request *>           implicit_wr_queue_t;
+typedef std::deque<mpi_work_request *>::iterator implicit_wr_queue_iter_t;
+static nthread_lock_t                           nnti_implicit_lock;
+
+implicit_wr_queue_t implicit_wrs;
+
+/* the first failure since the last flush, to any rank and by rank.  protected by nnti_implicit_lock. */
+typedef std::map<int, NNTI_result_t>           implicit_result_map_t;
+typedef std::map<int, NNTI_result_t>::iterator implicit_result_iter_t;
+static NNTI_result_t         implicit_result=NNTI_OK;
+static implicit_result_map_t implicit_results;
+
+
 static mpi_transport_global transport_global_data;
 static const int MAX_SLEEP = 10;  /* in milliseconds */
 
@@ -366,12 +682,17 @@ NNTI_result_t NNTI_mpi_init (
 
         nthread_lock_init(&nnti_mpi_lock);
         nthread_lock_init(&nnti_buf_bufhash_lock);
+        nthread_lock_init(&nnti_atomic_buffers_lock);
         nthread_lock_init(&nnti_wr_wrhash_lock);
         nthread_lock_init(&nnti_target_buffer_queue_lock);
+        nthread_lock_init(&nnti_credit_msgs_lock);
+        nthread_lock_init(&nnti_implicit_lock);
 
         config_init(&config);
         config_get_from_env(&config);
 
+        nnti_credits_init(&request_credits, config.request_credits);
+
         if (my_url != NULL) {
             log_error(nnti_debug_level,"The MPI transport does not accept a URL at init.  Ignoring URL.");
         }
@@ -417,6 +738,14 @@ NNTI_result_t NNTI_mpi_init (
         nthread_counter_init(&transport_global_data.mbits);
         nthread_counter_set(&transport_global_data.mbits, 0x111);
 
+        int  *tag_ub=NULL;
+        int   flag=0;
+        MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &tag_ub, &flag);
+        // buffer tags count up from the bottom.  chunked transfers get the top half.
+        transport_global_data.chunk_tag_span=((flag ? *tag_ub : 32767) / 4);
+        nthread_counter_init(&transport_global_data.put_chunk_tags);
+        nthread_counter_init(&transport_global_data.get_chunk_tags);
+
         setup_atomics();
 
         create_peer(&trans_hdl->me, transport_global_data.rank);
@@ -519,6 +848,8 @@ NNTI_result_t NNTI_mpi_connect (
             peer_hdl,
             peer_rank);
 
+    nnti_rc=exchange_request_credits(peer_rank, timeout);
+
     log_debug(nnti_debug_level, "exit");
 
     return(nnti_rc);
@@ -663,7 +994,7 @@ NNTI_result_t NNTI_mpi_register_memory (
     log_debug(nnti_debug_level, "rpc_buffer->payload_size=%ld",
             reg_buf->payload_size);
 
-    if (ops == NNTI_BOP_RECV_QUEUE) {
+    if ((ops == NNTI_BOP_RECV_QUEUE) || (ops == NNTI_BOP_RECV_RING)) {
         mpi_mem_hdl->cmd_tag      = 0;
         mpi_mem_hdl->get_data_tag = 0;
         mpi_mem_hdl->put_data_tag = NNTI_MPI_REQUEST_TAG;
@@ -682,6 +1013,12 @@ NNTI_result_t NNTI_mpi_register_memory (
     reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.get_data_tag = mpi_mem_hdl->get_data_tag;
     reg_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag = mpi_mem_hdl->put_data_tag;
 
+    if (ops & NNTI_BOP_ATOMICS) {
+        nthread_lock(&nnti_atomic_buffers_lock);
+        atomic_buffers_by_tag[mpi_mem_hdl->cmd_tag]=reg_buf;
+        nthread_unlock(&nnti_atomic_buffers_lock);
+    }
+
     if (ops == NNTI_BOP_RECV_QUEUE) {
         mpi_request_queue_handle *q_hdl=&transport_global_data.req_queue;
 
@@ -693,6 +1030,20 @@ NNTI_result_t NNTI_mpi_register_memory (
         q_hdl->last_request_index=0;
         q_hdl->mpi_request_list  =(MPI_Request*)calloc(q_hdl->req_count, sizeof(MPI_Request));
 
+        nthread_lock_init(&q_hdl->ready_lock);
+        q_hdl->ready_index    =(int*)calloc(q_hdl->req_count, sizeof(int));
+        q_hdl->ready_event    =(MPI_Status*)calloc(q_hdl->req_count, sizeof(MPI_Status));
+        q_hdl->ready_head     =0;
+        q_hdl->ready_count    =0;
+        q_hdl->testsome_index =(int*)calloc(q_hdl->req_count, sizeof(int));
+        q_hdl->testsome_event =(MPI_Status*)calloc(q_hdl->req_count, sizeof(MPI_Status));
+        q_hdl->post_seq       =(uint64_t*)calloc(q_hdl->req_count, sizeof(uint64_t));
+        for (int i=0;i<q_hdl->req_count;i++) {
+            q_hdl->post_seq[i]=i;
+        }
+        q_hdl->next_post_seq  =q_hdl->req_count;
+        q_hdl->slot_src       =(int*)calloc(q_hdl->req_count, sizeof(int));
+
         /* initialize the buffer */
         memset(q_hdl->req_queue, 0, q_hdl->req_count*q_hdl->req_size);
 
@@ -703,6 +1054,18 @@ NNTI_result_t NNTI_mpi_register_memory (
                 q_hdl->req_count,
                 q_hdl->mpi_request_list);
 
+    } else if (ops == NNTI_BOP_RECV_RING) {
+        mpi_request_ring_handle *ring=&transport_global_data.req_ring;
+
+        memset(ring, 0, sizeof(mpi_request_ring_handle));
+        nthread_lock_init(&ring->lock);
+
+        ring->ring     =buffer;
+        ring->ring_size=(element_size*num_elements) & ~((uint64_t)RING_RECORD_ALIGN - 1);
+        ring->reg_buf  =reg_buf;
+
+        log_debug(nnti_debug_level, "request ring is %llu bytes", (unsigned long long)ring->ring_size);
+
     } else if ((ops & NNTI_BOP_REMOTE_READ) || (ops & NNTI_BOP_REMOTE_WRITE)) {
         post_rdma_target_work_request(
                 reg_buf);
@@ -769,6 +1132,12 @@ NNTI_result_t NNTI_mpi_unregister_memory (
 
     del_target_buffer(reg_buf);
 
+    if (reg_buf->ops & NNTI_BOP_ATOMICS) {
+        nthread_lock(&nnti_atomic_buffers_lock);
+        atomic_buffers_by_tag.erase(mpi_mem_hdl->cmd_tag);
+        nthread_unlock(&nnti_atomic_buffers_lock);
+    }
+
     nthread_lock(&mpi_mem_hdl->wr_queue_lock);
     while (!mpi_mem_hdl->wr_queue.empty()) {
         mpi_work_request *mpi_wr=NULL;
@@ -796,6 +1165,34 @@ NNTI_result_t NNTI_mpi_unregister_memory (
     }
     nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
 
+    if (reg_buf->ops == NNTI_BOP_RECV_QUEUE) {
+        mpi_request_queue_handle *q_hdl=&transport_global_data.req_queue;
+
+        nthread_lock_fini(&q_hdl->ready_lock);
+        free(q_hdl->ready_index);
+        free(q_hdl->ready_event);
+        free(q_hdl->testsome_index);
+        free(q_hdl->testsome_event);
+        free(q_hdl->post_seq);
+        free(q_hdl->slot_src);
+        q_hdl->ready_index   =NULL;
+        q_hdl->ready_event   =NULL;
+        q_hdl->testsome_index=NULL;
+        q_hdl->testsome_event=NULL;
+        q_hdl->post_seq      =NULL;
+        q_hdl->slot_src      =NULL;
+        q_hdl->reg_buf       =NULL;
+    }
+    if (reg_buf->ops == NNTI_BOP_RECV_RING) {
+        mpi_request_ring_handle *ring=&transport_global_data.req_ring;
+
+        if (ring->have_pending) {
+            log_warn(nnti_debug_level, "request ring freed with a request (src=%d) waiting for space", ring->pending_event.MPI_SOURCE);
+        }
+        ring->reg_buf=NULL;
+        nthread_lock_fini(&ring->lock);
+    }
+
     if (mpi_mem_hdl)
         nthread_lock_fini(&mpi_mem_hdl->wr_queue_lock);
         delete mpi_mem_hdl;
@@ -851,7 +1248,18 @@ NNTI_result_t NNTI_mpi_send (
                 "NNTI_mpi_send", dest_hdl);
     }
 
-    if ((dest_hdl == NULL) || (dest_hdl->ops == NNTI_BOP_RECV_QUEUE)) {
+    if ((dest_hdl == NULL) || (dest_hdl->ops == NNTI_BOP_RECV_QUEUE) || (dest_hdl->ops == NNTI_BOP_RECV_RING)) {
+        dest_rank=peer_hdl->peer.NNTI_remote_process_t_u.mpi.rank;
+
+        if (!nnti_credits_take(&request_credits, dest_rank)) {
+            /* look for credits that came back in their own message before giving up */
+            check_control_messages();
+            if (!nnti_credits_take(&request_credits, dest_rank)) {
+                log_debug(nnti_debug_level, "out of request credits for rank %d", dest_rank);
+                return(NNTI_EAGAIN);
+            }
+        }
+
         mpi_mem_hdl=MPI_MEM_HDL(msg_hdl);
         assert(mpi_mem_hdl);
         mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
@@ -926,6 +1334,75 @@ NNTI_result_t NNTI_mpi_put (
         const NNTI_buffer_t *dest_buffer_hdl,
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr)
+{
+    return(mpi_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, NULL, 0, wr));
+}
+
+
+/**
+ * @brief Transfer data to a peer as a stream of chunks.
+ *
+ * Like NNTI_mpi_put(), but the data always goes in messages of
+ * <tt>chunk_size</tt> bytes and the command message asks the target to
+ * raise an event as each one arrives.
+ */
+NNTI_result_t NNTI_mpi_put_stream (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t *wr)
+{
+    if ((chunk_size == 0) || (chunk_size > 0x7fffffffULL)) {
+        log_debug(nnti_debug_level, "chunk_size(%llu) must be >0 and fit in an MPI count", chunk_size);
+        return(NNTI_EINVAL);
+    }
+
+    // an empty put has no chunks.  it gets one event like a regular put.
+    return(mpi_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, (src_length > 0) ? chunk_size : 0, 0, NULL, 0, wr));
+}
+
+
+/**
+ * @brief Transfer data to a peer and tell the target what it was.
+ *
+ * Like NNTI_mpi_put(), but <tt>imm</tt> travels in the command message
+ * and is delivered in the status of the target's event.
+ */
+NNTI_result_t NNTI_mpi_put_notify (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr)
+{
+    return(mpi_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, imm, NULL, 0, wr));
+}
+
+
+/*
+ * Build and start a put.  <stream_chunk> is 0 for a regular put.  <imm>
+ * travels in the command message (see NNTI_mpi_put_notify()).
+ *
+ * If <iov> isn't NULL, the put moves the regions it lists (see
+ * NNTI_mpi_putv()) and <src_offset>/<src_length> describe the extent of
+ * the regions in the source buffer.
+ */
+static NNTI_result_t mpi_put(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       stream_chunk,
+        const uint64_t       imm,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
 {
     int rc=0;
     NNTI_result_t nnti_rc=NNTI_OK;
@@ -933,6 +1410,7 @@ NNTI_result_t NNTI_mpi_put (
     mpi_memory_handle *mpi_mem_hdl=NULL;
     mpi_work_request  *mpi_wr=NULL;
     int                dest_rank;
+    MPI_Datatype       iov_type;
 
     log_debug(nnti_debug_level, "enter (wr=%p)", wr);
 
@@ -968,6 +1446,21 @@ NNTI_result_t NNTI_mpi_put (
     mpi_wr->cmd_msg.offset=dest_offset;
     mpi_wr->cmd_msg.tag   =dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag;
     mpi_wr->cmd_msg.op    =MPI_OP_PUT_TARGET;
+    mpi_wr->cmd_msg.credits=nnti_credits_collect(&request_credits, dest_rank);
+    mpi_wr->cmd_msg.imm   =imm;
+    if (iov != NULL) {
+        // the target's event describes the regions it received
+        nnti_iovec_extent(iov, iov_count, FALSE, &mpi_wr->cmd_msg.offset, &mpi_wr->cmd_msg.length);
+        mpi_wr->cmd_msg.iov_count=iov_count;
+    } else if (stream_chunk > 0) {
+        mpi_wr->cmd_msg.chunk_size=stream_chunk;
+        mpi_wr->cmd_msg.stream    =TRUE;
+    } else if ((config.rdma_chunk_threshold > 0) && (src_length > config.rdma_chunk_threshold)) {
+        mpi_wr->cmd_msg.chunk_size=config.rdma_chunk_size;
+    }
+    if (mpi_wr->cmd_msg.chunk_size > 0) {
+        mpi_wr->cmd_msg.tag=chunk_tag(TRUE);
+    }
 
     nthread_lock(&nnti_mpi_lock);
     rc=MPI_Issend(
@@ -985,16 +1478,52 @@ NNTI_result_t NNTI_mpi_put (
         goto cleanup;
     }
 
-    nthread_lock(&nnti_mpi_lock);
-    rc=MPI_Issend(
-            (char*)src_buffer_hdl->payload+src_offset,
-            src_length,
-            MPI_BYTE,
-            dest_rank,
-            dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag,
-            MPI_COMM_WORLD,
-            &mpi_wr->request[PUT_SEND_INDEX]);
-    nthread_unlock(&nnti_mpi_lock);
+    if (iov != NULL) {
+        rc=iovec_send(
+                mpi_wr,
+                iov,
+                iov_count,
+                dest_rank,
+                dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag);
+        if (rc == MPI_SUCCESS) {
+            rc=iovec_type(iov, iov_count, TRUE, &iov_type);
+        }
+        if (rc == MPI_SUCCESS) {
+            nthread_lock(&nnti_mpi_lock);
+            rc=MPI_Issend(
+                    (char*)src_buffer_hdl->payload,
+                    1,
+                    iov_type,
+                    dest_rank,
+                    dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag,
+                    MPI_COMM_WORLD,
+                    &mpi_wr->request[PUT_SEND_INDEX]);
+            MPI_Type_free(&iov_type);
+            nthread_unlock(&nnti_mpi_lock);
+        }
+    } else if (mpi_wr->cmd_msg.chunk_size > 0) {
+        mpi_wr->request[PUT_SEND_INDEX]=MPI_REQUEST_NULL;
+        rc=chunk_start(
+                mpi_wr,
+                (char*)src_buffer_hdl->payload+src_offset,
+                src_length,
+                mpi_wr->cmd_msg.chunk_size,
+                dest_rank,
+                mpi_wr->cmd_msg.tag,
+                TRUE,
+                config.rdma_chunk_window);
+    } else {
+        nthread_lock(&nnti_mpi_lock);
+        rc=MPI_Issend(
+                (char*)src_buffer_hdl->payload+src_offset,
+                src_length,
+                MPI_BYTE,
+                dest_rank,
+                dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag,
+                MPI_COMM_WORLD,
+                &mpi_wr->request[PUT_SEND_INDEX]);
+        nthread_unlock(&nnti_mpi_lock);
+    }
     if (rc != MPI_SUCCESS) {
         log_error(nnti_debug_level, "failed to Issend region");
         nnti_rc = NNTI_EBADRPC;
@@ -1041,6 +1570,25 @@ NNTI_result_t NNTI_mpi_get (
         const NNTI_buffer_t *dest_buffer_hdl,
         const uint64_t       dest_offset,
         NNTI_work_request_t *wr)
+{
+    return(mpi_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, NULL, 0, wr));
+}
+
+
+/*
+ * Build and start a get.  If <iov> isn't NULL, the get moves the regions
+ * it lists (see NNTI_mpi_getv()) and <src_offset>/<src_length> describe
+ * the extent of the regions in the source buffer.
+ */
+static NNTI_result_t mpi_get(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
 {
     int rc=0;
     NNTI_result_t nnti_rc=NNTI_OK;
@@ -1048,6 +1596,7 @@ NNTI_result_t NNTI_mpi_get (
     mpi_memory_handle *mpi_mem_hdl=NULL;
     mpi_work_request  *mpi_wr=NULL;
     int                src_rank;
+    MPI_Datatype       iov_type;
 
     log_debug(nnti_debug_level, "enter");
 
@@ -1093,17 +1642,54 @@ NNTI_result_t NNTI_mpi_get (
     mpi_wr->cmd_msg.offset=src_offset;
     mpi_wr->cmd_msg.tag=dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.get_data_tag;
     mpi_wr->cmd_msg.op =MPI_OP_GET_TARGET;
+    mpi_wr->cmd_msg.credits=nnti_credits_collect(&request_credits, src_rank);
+    if (iov != NULL) {
+        mpi_wr->cmd_msg.iov_count=iov_count;
+        // the initiator's status describes the regions it received
+        nnti_iovec_extent(iov, iov_count, FALSE, &mpi_wr->dst_offset, &mpi_wr->length);
+    } else if ((config.rdma_chunk_threshold > 0) && (src_length > config.rdma_chunk_threshold)) {
+        mpi_wr->cmd_msg.chunk_size=config.rdma_chunk_size;
+        mpi_wr->cmd_msg.tag       =chunk_tag(FALSE);
+    }
 
-    nthread_lock(&nnti_mpi_lock);
-    rc=MPI_Irecv(
-            (char*)dest_buffer_hdl->payload+dest_offset,
-            src_length,
-            MPI_BYTE,
-            src_rank,
-            dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.get_data_tag,
-            MPI_COMM_WORLD,
-            &mpi_wr->request[GET_RECV_INDEX]);
-    nthread_unlock(&nnti_mpi_lock);
+    if (iov != NULL) {
+        rc=iovec_type(iov, iov_count, FALSE, &iov_type);
+        if (rc == MPI_SUCCESS) {
+            nthread_lock(&nnti_mpi_lock);
+            rc=MPI_Irecv(
+                    (char*)dest_buffer_hdl->payload,
+                    1,
+                    iov_type,
+                    src_rank,
+                    dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.get_data_tag,
+                    MPI_COMM_WORLD,
+                    &mpi_wr->request[GET_RECV_INDEX]);
+            MPI_Type_free(&iov_type);
+            nthread_unlock(&nnti_mpi_lock);
+        }
+    } else if (mpi_wr->cmd_msg.chunk_size > 0) {
+        mpi_wr->request[GET_RECV_INDEX]=MPI_REQUEST_NULL;
+        rc=chunk_start(
+                mpi_wr,
+                (char*)dest_buffer_hdl->payload+dest_offset,
+                src_length,
+                mpi_wr->cmd_msg.chunk_size,
+                src_rank,
+                mpi_wr->cmd_msg.tag,
+                FALSE,
+                config.rdma_chunk_window);
+    } else {
+        nthread_lock(&nnti_mpi_lock);
+        rc=MPI_Irecv(
+                (char*)dest_buffer_hdl->payload+dest_offset,
+                src_length,
+                MPI_BYTE,
+                src_rank,
+                dest_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.get_data_tag,
+                MPI_COMM_WORLD,
+                &mpi_wr->request[GET_RECV_INDEX]);
+        nthread_unlock(&nnti_mpi_lock);
+    }
     if (rc != MPI_SUCCESS) {
         log_error(nnti_debug_level, "failed to Irecv region");
         nnti_rc = NNTI_EBADRPC;
@@ -1126,6 +1712,20 @@ NNTI_result_t NNTI_mpi_get (
         goto cleanup;
     }
 
+    if (iov != NULL) {
+        rc=iovec_send(
+                mpi_wr,
+                iov,
+                iov_count,
+                src_rank,
+                src_buffer_hdl->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.put_data_tag);
+        if (rc != MPI_SUCCESS) {
+            log_error(nnti_debug_level, "failed to send the region list");
+            nnti_rc = NNTI_EBADRPC;
+            goto cleanup;
+        }
+    }
+
     mpi_wr->request_ptr=&mpi_wr->request[RDMA_CMD_INDEX];
     mpi_wr->request_count=1;
     mpi_wr->active_requests |= RDMA_CMD_REQUEST_ACTIVE;
@@ -1152,6 +1752,68 @@ cleanup:
 }
 
 
+/**
+ * @brief Transfer a list of regions to a peer.
+ *
+ * Both sides describe the regions with an hindexed datatype, so the data
+ * is one message.  The target needs the list to build its datatype, so
+ * the list follows the command on the target's put data tag.  MPI keeps
+ * messages between two ranks on one tag in order, which means the list
+ * is always ahead of the data.
+ */
+NNTI_result_t NNTI_mpi_putv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+    uint64_t src_offset=0;
+    uint64_t src_length=0;
+    uint64_t dest_offset=0;
+    uint64_t dest_length=0;
+
+    rc=check_iovec(src_buffer_hdl, dest_buffer_hdl, iov, iov_count);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    nnti_iovec_extent(iov, iov_count, TRUE,  &src_offset,  &src_length);
+    nnti_iovec_extent(iov, iov_count, FALSE, &dest_offset, &dest_length);
+
+    return(mpi_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, iov, iov_count, wr));
+}
+
+
+/**
+ * @brief Transfer a list of regions from a peer.
+ *
+ * Like NNTI_mpi_putv().  The list still goes to the target on its put
+ * data tag, and the data comes back as one message.
+ */
+NNTI_result_t NNTI_mpi_getv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t *wr)
+{
+    NNTI_result_t rc=NNTI_OK;
+    uint64_t src_offset=0;
+    uint64_t src_length=0;
+
+    rc=check_iovec(src_buffer_hdl, dest_buffer_hdl, iov, iov_count);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    nnti_iovec_extent(iov, iov_count, TRUE, &src_offset, &src_length);
+
+    return(mpi_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, 0, iov, iov_count, wr));
+}
+
+
 /**
  * @brief Transfer data to a peer.
  *
@@ -1192,13 +1854,56 @@ NNTI_result_t NNTI_mpi_gather (
 }
 
 
+/*
+ * Attach <cbfunc> to the atomic variable <local_atomic>.  The target side
+ * of a remote atomic invokes it from check_atomic_operation().
+ */
+static NNTI_result_t set_atomic_callback(
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		const int8_t            use_threshold,
+		const int64_t           threshold,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context)
+{
+    mpi_atomic_t *atomic=NULL;
+
+    if (local_atomic >= config.min_atomics_vars) {
+        return NNTI_EINVAL;
+    }
+
+    atomic=&transport_global_data.atomics[local_atomic];
+
+    nthread_lock(&atomic->lock);
+    atomic->cbfunc       =cbfunc;
+    atomic->context      =context;
+    atomic->trans_hdl    =trans_hdl;
+    atomic->threshold    =threshold;
+    atomic->use_threshold=use_threshold;
+    nthread_unlock(&atomic->lock);
+
+    return NNTI_OK;
+}
+
+
 NNTI_result_t NNTI_mpi_atomic_set_callback (
 		const NNTI_transport_t *trans_hdl,
 		const uint64_t          local_atomic,
 		NNTI_callback_fn_t      cbfunc,
 		void                   *context)
 {
-    return NNTI_ENOTSUP;
+    return(set_atomic_callback(trans_hdl, local_atomic, FALSE, 0, cbfunc, context));
+}
+
+
+NNTI_result_t NNTI_mpi_atomic_set_threshold_callback (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		const int64_t           threshold,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context)
+{
+    return(set_atomic_callback(trans_hdl, local_atomic, TRUE, threshold, cbfunc, context));
 }
 
 
@@ -1215,71 +1920,89 @@ NNTI_result_t NNTI_mpi_atomic_read (
 }
 
 
-NNTI_result_t NNTI_mpi_atomic_fop (
-		const NNTI_transport_t *trans_hdl,
-		const NNTI_peer_t      *peer_hdl,
-		const uint64_t          target_atomic,
-		const uint64_t          result_atomic,
-		const int64_t           operand,
-		const NNTI_atomic_op_t  op,
-		NNTI_work_request_t    *wr)
+/*
+ * Send the atomic request in <mpi_wr> to <peer_hdl> and, if the target
+ * replies, post the receive for the previous value.
+ */
+static NNTI_result_t mpi_atomic_start(
+        const NNTI_transport_id_t transport_id,
+        const NNTI_peer_t        *peer_hdl,
+        mpi_work_request         *mpi_wr,
+        NNTI_work_request_t      *wr)
 {
     int rc=0;
     NNTI_result_t nnti_rc=NNTI_OK;
 
-    mpi_work_request  *mpi_wr=NULL;
-    int                dest_rank;
+    int dest_rank;
 
     log_debug(nnti_debug_level, "enter");
 
     assert(peer_hdl);
 
-    mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
-    assert(mpi_wr);
-
     mpi_wr->nnti_wr   =wr;
     mpi_wr->op_state  =BUFFER_INIT;
 
-    mpi_wr->atomics_result_index=result_atomic;
-
     mpi_wr->peer   =*peer_hdl;
     mpi_wr->last_op=MPI_OP_FETCH_ADD;
     dest_rank      =peer_hdl->peer.NNTI_remote_process_t_u.mpi.rank;
 
-    transport_global_data.atomics_request_msg.op         =MPI_ATOMIC_FETCH_ADD;
-    transport_global_data.atomics_request_msg.index      =target_atomic;
-    transport_global_data.atomics_request_msg.compare_add=operand;
-
-    log_debug(nnti_debug_level, "sending fetch-add to (rank=%d)", dest_rank);
+    log_debug(nnti_debug_level, "sending atomic op %d to (rank=%d)", mpi_wr->atomics_request_msg.op, dest_rank);
 
+    /*
+     * one lock across the request, its updates and the reply receive.
+     * another thread's atomic to the same peer can't slip in between, so
+     * the target pairs every request with its own updates and the replies
+     * match the receives in order.
+     */
     nthread_lock(&nnti_mpi_lock);
     rc=MPI_Isend(
-            (char*)&transport_global_data.atomics_request_msg,
-            sizeof(transport_global_data.atomics_request_msg),
+            (char*)&mpi_wr->atomics_request_msg,
+            sizeof(mpi_wr->atomics_request_msg),
             MPI_BYTE,
             dest_rank,
             NNTI_MPI_ATOMICS_REQUEST_TAG,
             MPI_COMM_WORLD,
             &mpi_wr->request[ATOMICS_SEND_INDEX]);
-    nthread_unlock(&nnti_mpi_lock);
-    if (rc != MPI_SUCCESS) {
-        log_error(nnti_debug_level, "failed to send with Isend");
-        nnti_rc = NNTI_EBADRPC;
-        goto cleanup;
+    if ((rc == MPI_SUCCESS) && (mpi_wr->atomics_updates != NULL)) {
+        rc=MPI_Isend(
+                (char*)mpi_wr->atomics_updates,
+                mpi_wr->atomics_update_count*sizeof(NNTI_atomic_update_t),
+                MPI_BYTE,
+                dest_rank,
+                NNTI_MPI_ATOMICS_VECTOR_TAG,
+                MPI_COMM_WORLD,
+                &mpi_wr->request[ATOMICS_VECTOR_INDEX]);
+        if (rc == MPI_SUCCESS) {
+            mpi_wr->active_requests |= ATOMICS_VECTOR_REQUEST_ACTIVE;
+        }
+    }
+    if ((rc == MPI_SUCCESS) && (mpi_wr->atomics_request_msg.reply)) {
+        if (mpi_wr->atomics_updates != NULL) {
+            rc=MPI_Irecv(
+                    (char*)mpi_wr->atomics_results,
+                    (mpi_wr->atomics_update_count+1)*sizeof(int64_t),
+                    MPI_BYTE,
+                    dest_rank,
+                    NNTI_MPI_ATOMICS_RESULT_TAG,
+                    MPI_COMM_WORLD,
+                    &mpi_wr->request[ATOMICS_RECV_INDEX]);
+        } else {
+            rc=MPI_Irecv(
+                    (char*)&mpi_wr->atomics_result_msg,
+                    sizeof(mpi_wr->atomics_result_msg),
+                    MPI_BYTE,
+                    dest_rank,
+                    NNTI_MPI_ATOMICS_RESULT_TAG,
+                    MPI_COMM_WORLD,
+                    &mpi_wr->request[ATOMICS_RECV_INDEX]);
+        }
+        if (rc == MPI_SUCCESS) {
+            mpi_wr->active_requests |= ATOMICS_RECV_REQUEST_ACTIVE;
+        }
     }
-
-    nthread_lock(&nnti_mpi_lock);
-    rc=MPI_Irecv(
-            (char*)&transport_global_data.atomics_result_msg,
-            sizeof(transport_global_data.atomics_result_msg),
-            MPI_BYTE,
-            dest_rank,
-            NNTI_MPI_ATOMICS_RESULT_TAG,
-            MPI_COMM_WORLD,
-            &mpi_wr->request[ATOMICS_RECV_INDEX]);
     nthread_unlock(&nnti_mpi_lock);
     if (rc != MPI_SUCCESS) {
-        log_error(nnti_debug_level, "failed to post recv with Irecv");
+        log_error(nnti_debug_level, "failed to start the atomic with Isend/Irecv");
         nnti_rc = NNTI_EBADRPC;
         goto cleanup;
     }
@@ -1287,9 +2010,8 @@ NNTI_result_t NNTI_mpi_atomic_fop (
     mpi_wr->request_ptr  =&mpi_wr->request[ATOMICS_SEND_INDEX];
     mpi_wr->request_count=1;
     mpi_wr->active_requests |= ATOMICS_SEND_REQUEST_ACTIVE;
-    mpi_wr->active_requests |= ATOMICS_RECV_REQUEST_ACTIVE;
 
-    wr->transport_id     =trans_hdl->id;
+    wr->transport_id     =transport_id;
     wr->reg_buf          =(NNTI_buffer_t*)NULL;
     wr->ops              =NNTI_BOP_ATOMICS;
     wr->result           =NNTI_OK;
@@ -1302,6 +2024,32 @@ cleanup:
 }
 
 
+NNTI_result_t NNTI_mpi_atomic_fop (
+		const NNTI_transport_t *trans_hdl,
+		const NNTI_peer_t      *peer_hdl,
+		const uint64_t          target_atomic,
+		const uint64_t          result_atomic,
+		const int64_t           operand,
+		const NNTI_atomic_op_t  op,
+		NNTI_work_request_t    *wr)
+{
+    mpi_work_request *mpi_wr=NULL;
+
+    mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
+    assert(mpi_wr);
+
+    mpi_wr->atomics_result_index=result_atomic;
+
+    mpi_wr->atomics_request_msg.op         =MPI_ATOMIC_FOP;
+    mpi_wr->atomics_request_msg.nnti_op    =op;
+    mpi_wr->atomics_request_msg.reply      =(nnti_atomic_fetches(op) > 0);
+    mpi_wr->atomics_request_msg.index      =target_atomic;
+    mpi_wr->atomics_request_msg.compare_add=operand;
+
+    return(mpi_atomic_start(trans_hdl->id, peer_hdl, mpi_wr, wr));
+}
+
+
 NNTI_result_t NNTI_mpi_atomic_cswap (
 		const NNTI_transport_t *trans_hdl,
 		const NNTI_peer_t      *peer_hdl,
@@ -1311,82 +2059,150 @@ NNTI_result_t NNTI_mpi_atomic_cswap (
 		const int64_t           swap_operand,
 		NNTI_work_request_t    *wr)
 {
-    int rc=0;
-    NNTI_result_t nnti_rc=NNTI_OK;
+    mpi_work_request *mpi_wr=NULL;
 
-    mpi_work_request  *mpi_wr=NULL;
-    int                dest_rank;
+    mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
+    assert(mpi_wr);
 
-    log_debug(nnti_debug_level, "enter");
+    mpi_wr->atomics_result_index=result_atomic;
 
-    assert(peer_hdl);
+    mpi_wr->atomics_request_msg.op         =MPI_ATOMIC_CMP_AND_SWP;
+    mpi_wr->atomics_request_msg.reply      =1;
+    mpi_wr->atomics_request_msg.index      =target_atomic;
+    mpi_wr->atomics_request_msg.compare_add=compare_operand;
+    mpi_wr->atomics_request_msg.swap       =swap_operand;
+
+    return(mpi_atomic_start(trans_hdl->id, peer_hdl, mpi_wr, wr));
+}
+
+
+/**
+ * @brief Perform a list of atomic operations on one peer.
+ *
+ * The request carries the number of updates and the updates follow it.
+ * The target applies them from check_atomic_operation() and sends every
+ * previous value back in one reply, followed by the status of the vector.
+ * The reply is sent even if no update fetches, so a vector the target
+ * refuses fails the work request.
+ */
+NNTI_result_t NNTI_mpi_atomic_fopv (
+		const NNTI_transport_t     *trans_hdl,
+		const NNTI_peer_t          *peer_hdl,
+		const NNTI_atomic_update_t *updates,
+		const uint32_t              update_count,
+		NNTI_work_request_t        *wr)
+{
+    mpi_work_request *mpi_wr=NULL;
 
     mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
     assert(mpi_wr);
 
-    mpi_wr->nnti_wr   =wr;
-    mpi_wr->op_state  =BUFFER_INIT;
+    mpi_wr->atomics_updates=(NNTI_atomic_update_t *)malloc(update_count*sizeof(NNTI_atomic_update_t));
+    assert(mpi_wr->atomics_updates);
+    memcpy(mpi_wr->atomics_updates, updates, update_count*sizeof(NNTI_atomic_update_t));
+    mpi_wr->atomics_update_count=update_count;
 
-    mpi_wr->atomics_result_index=result_atomic;
+    mpi_wr->atomics_request_msg.op   =MPI_ATOMIC_VECTOR;
+    mpi_wr->atomics_request_msg.index=update_count;
+    mpi_wr->atomics_request_msg.reply=1;
+    mpi_wr->atomics_results=(int64_t *)malloc((update_count+1)*sizeof(int64_t));
+    assert(mpi_wr->atomics_results);
 
-    mpi_wr->peer   =*peer_hdl;
-    mpi_wr->last_op=MPI_OP_FETCH_ADD;
-    dest_rank      =peer_hdl->peer.NNTI_remote_process_t_u.mpi.rank;
+    return(mpi_atomic_start(trans_hdl->id, peer_hdl, mpi_wr, wr));
+}
 
-    transport_global_data.atomics_request_msg.op         =MPI_ATOMIC_CMP_AND_SWP;
-    transport_global_data.atomics_request_msg.index      =target_atomic;
-    transport_global_data.atomics_request_msg.compare_add=compare_operand;
-    transport_global_data.atomics_request_msg.swap       =swap_operand;
+/*
+ * A vectored atomic is done.  Land the previous values of the fetching
+ * updates in their result variables, unless the target refused the
+ * vector, and free the lists.
+ */
+static void atomic_vector_release(
+        mpi_work_request *mpi_wr,
+        const int         land_results)
+{
+    if ((land_results) && (mpi_wr->atomics_results != NULL)) {
+        for (uint32_t i=0;i<mpi_wr->atomics_update_count;i++) {
+            const NNTI_atomic_update_t *update=&mpi_wr->atomics_updates[i];
+            if (nnti_atomic_fetches(update->op) > 0) {
+                mpi_atomic_t *atomic=&transport_global_data.atomics[update->result_atomic];
+                nthread_lock(&atomic->lock);
+                atomic->value=mpi_wr->atomics_results[i];
+                nthread_unlock(&atomic->lock);
+            }
+        }
+    }
 
-    log_debug(nnti_debug_level, "sending compare-swap to (rank=%d)", dest_rank);
+    free(mpi_wr->atomics_updates);
+    free(mpi_wr->atomics_results);
+    mpi_wr->atomics_updates=NULL;
+    mpi_wr->atomics_results=NULL;
+}
 
-    nthread_lock(&nnti_mpi_lock);
-    rc=MPI_Isend(
-            (char*)&transport_global_data.atomics_request_msg,
-            sizeof(transport_global_data.atomics_request_msg),
-            MPI_BYTE,
-            dest_rank,
-            NNTI_MPI_ATOMICS_REQUEST_TAG,
-            MPI_COMM_WORLD,
-            &mpi_wr->request[ATOMICS_SEND_INDEX]);
-    nthread_unlock(&nnti_mpi_lock);
-    if (rc != MPI_SUCCESS) {
-        log_error(nnti_debug_level, "failed to send with Isend");
-        nnti_rc = NNTI_EBADRPC;
-        goto cleanup;
-    }
 
-    nthread_lock(&nnti_mpi_lock);
-    rc=MPI_Irecv(
-            (char*)&transport_global_data.atomics_result_msg,
-            sizeof(transport_global_data.atomics_result_msg),
-            MPI_BYTE,
-            dest_rank,
-            NNTI_MPI_ATOMICS_RESULT_TAG,
-            MPI_COMM_WORLD,
-            &mpi_wr->request[ATOMICS_RECV_INDEX]);
-    nthread_unlock(&nnti_mpi_lock);
-    if (rc != MPI_SUCCESS) {
-        log_error(nnti_debug_level, "failed to post recv with Irecv");
-        nnti_rc = NNTI_EBADRPC;
-        goto cleanup;
+/**
+ * @brief Perform an atomic operation on a variable in a registered buffer.
+ *
+ * The target finds the buffer by its command tag and applies the op in
+ * check_atomic_operation().
+ */
+NNTI_result_t NNTI_mpi_atomic_fop_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           operand,
+        const NNTI_atomic_op_t  op,
+        NNTI_work_request_t    *wr)
+{
+    mpi_work_request *mpi_wr=NULL;
+
+    mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
+    assert(mpi_wr);
+
+    if (result_buf != NULL) {
+        mpi_wr->atomics_result=(int64_t *)(result_buf->payload+result_offset);
     }
 
-    mpi_wr->request_ptr  =&mpi_wr->request[ATOMICS_SEND_INDEX];
-    mpi_wr->request_count=1;
-    mpi_wr->active_requests |= ATOMICS_SEND_REQUEST_ACTIVE;
-    mpi_wr->active_requests |= ATOMICS_RECV_REQUEST_ACTIVE;
+    mpi_wr->atomics_request_msg.op         =MPI_ATOMIC_FOP;
+    mpi_wr->atomics_request_msg.nnti_op    =op;
+    mpi_wr->atomics_request_msg.reply      =(nnti_atomic_fetches(op) > 0);
+    mpi_wr->atomics_request_msg.on_buffer  =1;
+    mpi_wr->atomics_request_msg.buffer_tag =target_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.cmd_tag;
+    mpi_wr->atomics_request_msg.offset     =target_offset;
+    mpi_wr->atomics_request_msg.compare_add=operand;
 
-    wr->transport_id     =trans_hdl->id;
-    wr->reg_buf          =(NNTI_buffer_t*)NULL;
-    wr->ops              =NNTI_BOP_ATOMICS;
-    wr->result           =NNTI_OK;
-    wr->transport_private=(uint64_t)mpi_wr;
+    return(mpi_atomic_start(target_buf->transport_id, &target_buf->buffer_owner, mpi_wr, wr));
+}
 
-cleanup:
-    log_debug(nnti_debug_level, "exit");
 
-    return(nnti_rc);
+/**
+ * @brief Perform a compare-and-swap on a variable in a registered buffer.
+ */
+NNTI_result_t NNTI_mpi_atomic_cswap_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           compare_operand,
+        const int64_t           swap_operand,
+        NNTI_work_request_t    *wr)
+{
+    mpi_work_request *mpi_wr=NULL;
+
+    mpi_wr=(mpi_work_request *)calloc(1, sizeof(mpi_work_request));
+    assert(mpi_wr);
+
+    mpi_wr->atomics_result=(int64_t *)(result_buf->payload+result_offset);
+
+    mpi_wr->atomics_request_msg.op         =MPI_ATOMIC_CMP_AND_SWP;
+    mpi_wr->atomics_request_msg.reply      =1;
+    mpi_wr->atomics_request_msg.on_buffer  =1;
+    mpi_wr->atomics_request_msg.buffer_tag =target_buf->buffer_segments.NNTI_remote_addr_array_t_val[0].NNTI_remote_addr_t_u.mpi.cmd_tag;
+    mpi_wr->atomics_request_msg.offset     =target_offset;
+    mpi_wr->atomics_request_msg.compare_add=compare_operand;
+    mpi_wr->atomics_request_msg.swap       =swap_operand;
+
+    return(mpi_atomic_start(target_buf->transport_id, &target_buf->buffer_owner, mpi_wr, wr));
 }
 
 
@@ -1427,6 +2243,9 @@ NNTI_result_t NNTI_mpi_clear_work_request (
 {
     log_debug(nnti_debug_level, "enter (wr=%p)", wr);
 
+    if ((wr->ops == NNTI_BOP_RECV_RING) && (wr->transport_private != 0)) {
+        ring_release(&transport_global_data.req_ring, wr->transport_private-1);
+    }
     wr->transport_private=(uint64_t)NULL;
 
     log_debug(nnti_debug_level, "exit (wr=%p)", wr);
@@ -1444,6 +2263,10 @@ NNTI_result_t NNTI_mpi_destroy_work_request (
 {
     log_debug(nnti_debug_level, "enter (wr=%p)", wr);
 
+    if ((wr->ops == NNTI_BOP_RECV_RING) && (wr->transport_private != 0)) {
+        ring_release(&transport_global_data.req_ring, wr->transport_private-1);
+    }
+
     wr->transport_id     =NNTI_TRANSPORT_NULL;
     wr->reg_buf          =NULL;
     wr->ops              =(NNTI_buf_ops_t)0;
@@ -1533,6 +2356,12 @@ NNTI_result_t NNTI_mpi_wait (
     assert(wr);
     assert(status);
 
+    if (wr->ops == NNTI_BOP_RECV_RING) {
+        nnti_rc=ring_wait(wr, timeout, status);
+        trios_stop_timer("NNTI_mpi_wait", total_time);
+        return(nnti_rc);
+    }
+
 	mpi_wr=MPI_WORK_REQUEST(wr);
     if (wr->ops != NNTI_BOP_ATOMICS) {
     	mpi_mem_hdl=MPI_MEM_HDL(wr->reg_buf);
@@ -1562,6 +2391,8 @@ NNTI_result_t NNTI_mpi_wait (
 
             ops_completed += check_atomic_operation();
             ops_completed += check_target_buffer_progress();
+            ops_completed += check_request_ring_progress();
+            ops_completed += check_control_messages();
 
             if (ops_completed > 0) {
                 ops_completed=0;
@@ -1678,6 +2509,8 @@ NNTI_result_t NNTI_mpi_wait (
                 free(mpi_wr);
                 break;
         }
+        // an atomic the target refused
+        nnti_rc=status->result;
     }
 
     if (logging_debug(debug_level)) {
@@ -1781,6 +2614,8 @@ NNTI_result_t NNTI_mpi_waitany (
 
             ops_completed += check_atomic_operation();
             ops_completed += check_target_buffer_progress();
+            ops_completed += check_request_ring_progress();
+            ops_completed += check_control_messages();
 
             if (ops_completed > 0) {
                 ops_completed=0;
@@ -1938,6 +2773,8 @@ NNTI_result_t NNTI_mpi_waitany (
                 free(mpi_wr);
                 break;
         }
+        // an atomic the target refused
+        nnti_rc=status->result;
     }
 
     if (logging_debug(debug_level)) {
@@ -1979,9 +2816,6 @@ NNTI_result_t NNTI_mpi_waitall (
     mpi_memory_handle *mpi_mem_hdl=NULL;
     mpi_work_request  *mpi_wr=NULL;
 
-    uint32_t     mpi_request_count=0;
-    MPI_Request *mpi_requests=NULL;
-    MPI_Status  *events=NULL;
     int done=FALSE;
 
     int ops_completed=0;
@@ -2040,6 +2874,8 @@ NNTI_result_t NNTI_mpi_waitall (
 
             ops_completed += check_atomic_operation();
             ops_completed += check_target_buffer_progress();
+            ops_completed += check_request_ring_progress();
+            ops_completed += check_control_messages();
 
             if (ops_completed > 0) {
                 ops_completed=0;
@@ -2051,103 +2887,72 @@ NNTI_result_t NNTI_mpi_waitall (
             log_debug(debug_level, "waiting on wr_list(%p)", wr_list);
 
             /*
-             * The list of MPI_Requests is recreated each time through this loop.  There is probably a better way.
+             * Test each work request on its own, like NNTI_mpi_wait() does.  A
+             * chunked transfer only exposes its oldest chunk, so waiting for all
+             * of the exposed requests at once deadlocks when the target of one
+             * transfer can't move on until another finishes.
              */
-            /* find the number of MPI_Requests in wr_list */
-            mpi_request_count=0;
+            done=FALSE;
             for (uint32_t i=0;i<wr_count;i++) {
-                if (wr_list[i] != NULL) {
-                    mpi_wr=MPI_WORK_REQUEST(wr_list[i]);
-                    if (mpi_wr != NULL) {
-                        mpi_request_count += mpi_wr->request_count;
-                    }
-                }
-            }
-            log_debug(debug_level, "wr_list (wr_count=%lu) contains %lu MPI_Requests", wr_count, mpi_request_count);
+                MPI_Status event;
+                int        flag=FALSE;
 
-            mpi_requests=(MPI_Request *)realloc(mpi_requests, mpi_request_count * sizeof(MPI_Request));
-            events      =(MPI_Status *)realloc(events, mpi_request_count * sizeof(MPI_Status));
-            assert(mpi_requests);
-            assert(events);
-            uint32_t request_index=0;
-            /* for each NNTI work request */
-            for (uint32_t i=0;i<wr_count;i++) {
-                if (wr_list[i] != NULL) {
-                    mpi_wr=MPI_WORK_REQUEST(wr_list[i]);
-                    if (mpi_wr != NULL) {
-                        for (uint32_t j=0;j<mpi_wr->request_count;j++) {
-                            mpi_requests[request_index++]=mpi_wr->request_ptr[j];
-                        }
-                    }
+                if (wr_list[i] == NULL) {
+                    continue;
                 }
-            }
-
-            memset(events, 0, mpi_request_count*sizeof(MPI_Status));
-            done=FALSE;
-            trios_start_timer(call_time);
-            nthread_lock(&nnti_mpi_lock);
-            rc = MPI_Testall(mpi_request_count, mpi_requests, &done, events);
-            nthread_unlock(&nnti_mpi_lock);
-            trios_stop_timer("NNTI_mpi_waitall - MPI_Testall", call_time);
-            log_debug(debug_level, "polling status is %d (rc=%d, done=%d)", rc, rc, done);
-
-            if (done == TRUE) {
-                for (uint32_t i=0;i<mpi_request_count;i++) {
-                    log_debug(debug_level, "Poll Event[%d]= {", i);
-                    log_debug(debug_level, "\tsource  = %d", events[i].MPI_SOURCE);
-                    log_debug(debug_level, "\ttag     = %d", events[i].MPI_TAG);
-                    log_debug(debug_level, "\terror   = %d", events[i].MPI_ERROR);
-                    log_debug(debug_level, "}");
+                mpi_wr=MPI_WORK_REQUEST(wr_list[i]);
+                if ((mpi_wr == NULL) || (is_wr_complete(mpi_wr) == TRUE)) {
+                    continue;
                 }
-            }
 
-            /* MPI_Testany() says requests have completed */
-            if (rc == MPI_SUCCESS) {
-                /* case 1: success */
-                if (done == TRUE) {
-                    nnti_rc = NNTI_OK;
-                    for (uint32_t i=0;i<wr_count;i++) {
-                        log_debug(debug_level, "processing event #%lu of %lu", i, wr_count);
-                        process_event(MPI_WORK_REQUEST(wr_list[i]), &(events[i]));
-                    }
+                memset(&event, 0, sizeof(MPI_Status));
+                trios_start_timer(call_time);
+                nthread_lock(&nnti_mpi_lock);
+                rc = MPI_Testany(mpi_wr->request_count, mpi_wr->request_ptr, &mpi_wr->request_index, &flag, &event);
+                nthread_unlock(&nnti_mpi_lock);
+                trios_stop_timer("NNTI_mpi_waitall - MPI_Testany", call_time);
+                log_debug(debug_level, "polling status of wr_list[%u] is %d (which_req=%d, done=%d)", i, rc, mpi_wr->request_index, flag);
+
+                if (rc != MPI_SUCCESS) {
+                    log_error(debug_level, "MPI_Testany() failed (request=%p): rc=%d",
+                            mpi_wr->request_ptr, rc);
+                    break;
                 }
-                /* case 2: timed out */
-                else {
-                    elapsed_time = (trios_get_time_ms() - entry_time);
-
-                    /* if the caller asked for a legitimate timeout, we need to exit */
-                    if (((timeout > 0) && (elapsed_time >= timeout))) {
-                        log_debug(debug_level, "MPI_Testany() timed out");
-                        nnti_rc = NNTI_ETIMEDOUT;
-                        break;
-                    }
-
-                    int timeout_remaining=timeout-elapsed_time;
-                    if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
-                        nnti_sleep(MAX_SLEEP);
-                    } else {
-                        if (timeout_remaining > 0) {
-                            nnti_sleep(timeout_remaining);
-                        }
-                    }
-
-                    /* continue if the timeout has not expired */
-                    /* log_debug(debug_level, "timedout... continuing"); */
-
-                    continue;
+                /* MPI_UNDEFINED means no active requests.  this is not fatal. */
+                if ((flag == TRUE) && (mpi_wr->request_index != MPI_UNDEFINED)) {
+                    process_event(mpi_wr, &event);
+                    done=TRUE;
                 }
             }
-            /* MPI_Testany() failure */
-            else {
-                log_error(debug_level, "MPI_Testany() failed (request=%p): rc=%d",
-                        mpi_wr->request_ptr, rc);
+            if (rc != MPI_SUCCESS) {
                 nnti_rc = NNTI_EIO;
                 break;
             }
 
             if (is_all_wr_complete(wr_list, wr_count) == TRUE) {
+                nnti_rc = NNTI_OK;
                 break;
             }
+
+            if (done == FALSE) {
+                elapsed_time = (trios_get_time_ms() - entry_time);
+
+                /* if the caller asked for a legitimate timeout, we need to exit */
+                if (((timeout > 0) && (elapsed_time >= timeout))) {
+                    log_debug(debug_level, "MPI_Testany() timed out");
+                    nnti_rc = NNTI_ETIMEDOUT;
+                    break;
+                }
+
+                int timeout_remaining=timeout-elapsed_time;
+                if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
+                    nnti_sleep(MAX_SLEEP);
+                } else {
+                    if (timeout_remaining > 0) {
+                        nnti_sleep(timeout_remaining);
+                    }
+                }
+            }
         }
     }
 
@@ -2204,9 +3009,6 @@ NNTI_result_t NNTI_mpi_waitall (
     }
 
 cleanup:
-    if (mpi_requests != NULL)        free(mpi_requests);
-    if (events != NULL)              free(events);
-
     log_debug(debug_level, "exit");
 
     trios_stop_timer("NNTI_mpi_waitall", total_time);
@@ -2215,53 +3017,527 @@ cleanup:
 }
 
 /**
- * @brief Disable this transport.
- *
- * Shutdown the transport.  Any outstanding sends, gets and puts will be
- * canceled.  Any new transport requests will fail.
+ * @brief Take up to <tt>max_count</tt> received requests from a receive queue.
  *
+ * MPI_Testsome() harvests every completed request slot at once.  A completed
+ * slot's MPI_Request becomes MPI_REQUEST_NULL, so the slot is not reused
+ * until NNTI_mpi_release_requests() posts a new MPI_Irecv() into it.  Slots
+ * beyond <tt>max_count</tt> are kept in the ready ring for the next call.
  */
-NNTI_result_t NNTI_mpi_fini (
-        const NNTI_transport_t *trans_hdl)
+NNTI_result_t NNTI_mpi_dequeue_requests (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count)
 {
-    nthread_counter_fini(&transport_global_data.mbits);
+    int rc=MPI_SUCCESS;
+    NNTI_result_t nnti_rc=NNTI_OK;
+    mpi_request_queue_handle *q_hdl=&transport_global_data.req_queue;
+    int      outcount=0;
+    uint32_t n=0;
 
-    nthread_lock_fini(&nnti_mpi_lock);
-    nthread_lock_fini(&nnti_buf_bufhash_lock);
-    nthread_lock_fini(&nnti_wr_wrhash_lock);
-    nthread_lock_fini(&nnti_target_buffer_queue_lock);
+    long entry_time=trios_get_time_ms();
+    long elapsed_time=0;
 
-    if (transport_global_data.init_called_mpi_init) {
-    	MPI_Finalize();
-    }
+    log_level debug_level=nnti_debug_level;
 
-    return(NNTI_OK);
-}
+    log_debug(debug_level, "enter (reg_buf=%p ; max_count=%u ; timeout=%d)", reg_buf, max_count, timeout);
 
+    assert(reg_buf);
+    assert(wr_list);
+    assert(status_list);
 
+    *count=0;
 
-static NNTI_result_t setup_atomics(void)
-{
-    NNTI_result_t rc=NNTI_OK; /* return code */
+    if ((q_hdl->reg_buf != reg_buf) && (transport_global_data.req_ring.reg_buf != reg_buf)) {
+        log_error(debug_level, "reg_buf(%p) is not the receive queue", reg_buf);
+        return(NNTI_EINVAL);
+    }
 
-    trios_declare_timer(callTime);
+    while (1) {
+        if (trios_exit_now()) {
+            log_debug(debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
 
-    uint32_t atomics_bytes;
+        check_atomic_operation();
+        check_target_buffer_progress();
+        check_control_messages();
 
-    log_debug(nnti_debug_level, "enter");
+        if (reg_buf->ops == NNTI_BOP_RECV_RING) {
+            mpi_request_ring_handle *ring=&transport_global_data.req_ring;
 
-    atomics_bytes=config.min_atomics_vars * sizeof(mpi_atomic_t);
-    trios_start_timer(callTime);
-    transport_global_data.atomics=(mpi_atomic_t*)malloc(atomics_bytes);
-    if (transport_global_data.atomics == NULL) {
-    	rc=NNTI_ENOMEM;
-    	goto cleanup;
-    }
-    memset(transport_global_data.atomics, 0, atomics_bytes);
-    trios_stop_timer("malloc and memset", callTime);
+            check_request_ring_progress();
 
-    trios_start_timer(callTime);
-    for (uint32_t i=0;i<config.min_atomics_vars;i++) {
+            nthread_lock(&ring->lock);
+            while ((ring->ready_count > 0) && (n < max_count)) {
+                int64_t offset=ring_deliver(ring);
+
+                wr_list[n].transport_id     =reg_buf->transport_id;
+                wr_list[n].reg_buf          =reg_buf;
+                wr_list[n].ops              =reg_buf->ops;
+                wr_list[n].result           =NNTI_OK;
+                wr_list[n].transport_private=(uint64_t)offset+1;
+
+                create_ring_status(ring, offset, &status_list[n]);
+                n++;
+            }
+            nthread_unlock(&ring->lock);
+        } else {
+            nthread_lock(&q_hdl->ready_lock);
+            if (q_hdl->ready_count == 0) {
+                nthread_lock(&nnti_mpi_lock);
+                rc=MPI_Testsome(q_hdl->req_count, q_hdl->mpi_request_list, &outcount, q_hdl->testsome_index, q_hdl->testsome_event);
+                nthread_unlock(&nnti_mpi_lock);
+                if (rc != MPI_SUCCESS) {
+                    nthread_unlock(&q_hdl->ready_lock);
+                    log_error(debug_level, "MPI_Testsome() failed: rc=%d", rc);
+                    nnti_rc=NNTI_EIO;
+                    break;
+                }
+                if (outcount != MPI_UNDEFINED) {
+                    /* MPI_Testsome() reports by slot index; put the batch back in post order */
+                    for (int i=1;i<outcount;i++) {
+                        int        index=q_hdl->testsome_index[i];
+                        MPI_Status event=q_hdl->testsome_event[i];
+                        int j=i-1;
+                        while ((j >= 0) && (q_hdl->post_seq[q_hdl->testsome_index[j]] > q_hdl->post_seq[index])) {
+                            q_hdl->testsome_index[j+1]=q_hdl->testsome_index[j];
+                            q_hdl->testsome_event[j+1]=q_hdl->testsome_event[j];
+                            j--;
+                        }
+                        q_hdl->testsome_index[j+1]=index;
+                        q_hdl->testsome_event[j+1]=event;
+                    }
+                    for (int i=0;i<outcount;i++) {
+                        uint32_t tail=(q_hdl->ready_head + q_hdl->ready_count) % q_hdl->req_count;
+                        q_hdl->ready_index[tail]=q_hdl->testsome_index[i];
+                        q_hdl->ready_event[tail]=q_hdl->testsome_event[i];
+                        q_hdl->ready_count++;
+                    }
+                }
+            }
+            while ((q_hdl->ready_count > 0) && (n < max_count)) {
+                int         index=q_hdl->ready_index[q_hdl->ready_head];
+                MPI_Status *event=&q_hdl->ready_event[q_hdl->ready_head];
+                int         length=0;
+
+                MPI_Get_count(event, MPI_BYTE, &length);
+
+                wr_list[n].transport_id     =reg_buf->transport_id;
+                wr_list[n].reg_buf          =reg_buf;
+                wr_list[n].ops              =reg_buf->ops;
+                wr_list[n].result           =NNTI_OK;
+                wr_list[n].transport_private=(uint64_t)index;
+
+                status_list[n].op    =reg_buf->ops;
+                status_list[n].result=NNTI_OK;
+                status_list[n].start =reg_buf->payload;
+                status_list[n].offset=(uint64_t)index * q_hdl->req_size;
+                status_list[n].length=length;
+                create_peer(&status_list[n].src, event->MPI_SOURCE);
+                q_hdl->slot_src[index]=event->MPI_SOURCE;
+                create_peer(&status_list[n].dest, transport_global_data.rank);
+
+                log_debug(debug_level, "loaning request slot %d (src=%d ; length=%d)", index, event->MPI_SOURCE, length);
+
+                q_hdl->ready_head=(q_hdl->ready_head + 1) % q_hdl->req_count;
+                q_hdl->ready_count--;
+                n++;
+            }
+            nthread_unlock(&q_hdl->ready_lock);
+        }
+
+        if (n > 0) {
+            nnti_rc=NNTI_OK;
+            break;
+        }
+
+        elapsed_time=trios_get_time_ms() - entry_time;
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+
+        int timeout_remaining=timeout-elapsed_time;
+        if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
+            nnti_sleep(MAX_SLEEP);
+        } else if (timeout_remaining > 0) {
+            nnti_sleep(timeout_remaining);
+        }
+    }
+
+    *count=n;
+
+    log_debug(debug_level, "exit (count=%u)", n);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Return loaned request slots to the receive queue.
+ *
+ */
+NNTI_result_t NNTI_mpi_release_requests (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count)
+{
+    mpi_request_queue_handle *q_hdl=&transport_global_data.req_queue;
+
+    log_debug(nnti_debug_level, "enter (wr_count=%u)", wr_count);
+
+    for (uint32_t i=0;i<wr_count;i++) {
+        int index=(int)wr_list[i].transport_private;
+
+        if ((wr_list[i].reg_buf != NULL) && (wr_list[i].reg_buf == transport_global_data.req_ring.reg_buf)) {
+            ring_release(&transport_global_data.req_ring, wr_list[i].transport_private-1);
+
+            wr_list[i].transport_id     =NNTI_TRANSPORT_NULL;
+            wr_list[i].reg_buf          =NULL;
+            wr_list[i].ops              =(NNTI_buf_ops_t)0;
+            wr_list[i].transport_private=(uint64_t)NULL;
+            continue;
+        }
+        if (wr_list[i].reg_buf != q_hdl->reg_buf) {
+            log_warn(nnti_debug_level, "wr_list[%u] is not on loan from the receive queue", i);
+            continue;
+        }
+
+        log_debug(nnti_debug_level, "reposting request slot %d", index);
+        nthread_lock(&nnti_mpi_lock);
+        q_hdl->post_seq[index]=q_hdl->next_post_seq++;
+        MPI_Irecv(
+                q_hdl->req_queue + ((uint64_t)index * q_hdl->req_size),
+                q_hdl->req_size,
+                MPI_BYTE,
+                MPI_ANY_SOURCE,
+                NNTI_MPI_REQUEST_TAG,
+                MPI_COMM_WORLD,
+                &q_hdl->mpi_request_list[index]);
+        nthread_unlock(&nnti_mpi_lock);
+
+        return_request_credits(q_hdl->slot_src[index], 1);
+
+        wr_list[i].transport_id     =NNTI_TRANSPORT_NULL;
+        wr_list[i].reg_buf          =NULL;
+        wr_list[i].ops              =(NNTI_buf_ops_t)0;
+        wr_list[i].transport_private=(uint64_t)NULL;
+    }
+
+    log_debug(nnti_debug_level, "exit");
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Bind a target buffer to a counter.
+ *
+ * Once bound, check_target_buffer_progress() bumps the counter and
+ * recycles the work request when a put or get completes, just like it
+ * does for buffers registered without NNTI_BOP_WITH_EVENTS.
+ */
+NNTI_result_t NNTI_mpi_counter_bind (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter)
+{
+    mpi_memory_handle *mpi_mem_hdl=NULL;
+
+    log_debug(nnti_debug_level, "enter (reg_buf=%p ; counter=%p)", reg_buf, counter);
+
+    if (!(reg_buf->ops & NNTI_BOP_REMOTE_WRITE) &&
+        !(reg_buf->ops & NNTI_BOP_REMOTE_READ)) {
+        log_debug(nnti_debug_level, "reg_buf(%p) isn't an RDMA target (ops=%d)", reg_buf, reg_buf->ops);
+        return(NNTI_EINVAL);
+    }
+
+    mpi_mem_hdl=MPI_MEM_HDL(reg_buf);
+    assert(mpi_mem_hdl);
+
+    nthread_lock(&nnti_target_buffer_queue_lock);
+    mpi_mem_hdl->counter=(counter != NULL) ? NNTI_COUNTER(counter) : NULL;
+    nthread_unlock(&nnti_target_buffer_queue_lock);
+
+    log_debug(nnti_debug_level, "exit");
+
+    return(NNTI_OK);
+}
+
+
+/**
+ * @brief Wait for a counter to reach a threshold.
+ *
+ */
+NNTI_result_t NNTI_mpi_counter_wait (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+
+    nnti_counter *c=NNTI_COUNTER(counter);
+
+    long entry_time  =trios_get_time_ms();
+    long elapsed_time=0;
+
+    log_debug(nnti_debug_level, "enter (counter=%p ; threshold=%llu ; timeout=%d)", c, threshold, timeout);
+
+    while (1) {
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        check_atomic_operation();
+        check_target_buffer_progress();
+        check_request_ring_progress();
+        check_control_messages();
+
+        if ((uint64_t)nthread_counter_read(&c->value) >= threshold) {
+            nnti_rc=NNTI_OK;
+            break;
+        }
+
+        elapsed_time=trios_get_time_ms() - entry_time;
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+
+        int timeout_remaining=timeout-elapsed_time;
+        if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
+            nnti_sleep(MAX_SLEEP);
+        } else if (timeout_remaining > 0) {
+            nnti_sleep(timeout_remaining);
+        }
+    }
+
+    *value=(uint64_t)nthread_counter_read(&c->value);
+
+    log_debug(nnti_debug_level, "exit (value=%llu ; nnti_rc=%d)", *value, nnti_rc);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Send a message to a peer without a work request.
+ *
+ */
+NNTI_result_t NNTI_mpi_send_implicit (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl)
+{
+    NNTI_work_request_t *wr=(NNTI_work_request_t *)calloc(1, sizeof(NNTI_work_request_t));
+    if (wr == NULL) {
+        return(NNTI_ENOMEM);
+    }
+
+    return(implicit_track(wr, NNTI_mpi_send(peer_hdl, msg_hdl, dest_hdl, wr)));
+}
+
+
+/**
+ * @brief Transfer data to a peer without a work request.
+ *
+ */
+NNTI_result_t NNTI_mpi_put_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
+{
+    NNTI_work_request_t *wr=(NNTI_work_request_t *)calloc(1, sizeof(NNTI_work_request_t));
+    if (wr == NULL) {
+        return(NNTI_ENOMEM);
+    }
+
+    return(implicit_track(wr, mpi_put(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, 0, 0, NULL, 0, wr)));
+}
+
+
+/**
+ * @brief Transfer data from a peer without a work request.
+ *
+ */
+NNTI_result_t NNTI_mpi_get_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset)
+{
+    NNTI_work_request_t *wr=(NNTI_work_request_t *)calloc(1, sizeof(NNTI_work_request_t));
+    if (wr == NULL) {
+        return(NNTI_ENOMEM);
+    }
+
+    return(implicit_track(wr, mpi_get(src_buffer_hdl, src_offset, src_length, dest_buffer_hdl, dest_offset, NULL, 0, wr)));
+}
+
+
+/**
+ * @brief Wait for the implicit operations to a peer (or every peer) to complete.
+ *
+ * Tests the requests of the outstanding implicit operations and makes
+ * progress on target buffers, so two peers flushing toward each other
+ * don't stall.  A NULL <tt>peer_hdl</tt> waits on every peer.
+ */
+NNTI_result_t NNTI_mpi_flush (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+
+    int rank=-1;
+
+    long entry_time  =trios_get_time_ms();
+    long elapsed_time=0;
+
+    log_debug(nnti_debug_level, "enter (peer_hdl=%p ; timeout=%d)", peer_hdl, timeout);
+
+    if (peer_hdl != NULL) {
+        rank=peer_hdl->peer.NNTI_remote_process_t_u.mpi.rank;
+    }
+
+    while (1) {
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        check_atomic_operation();
+        check_target_buffer_progress();
+        check_request_ring_progress();
+        check_control_messages();
+
+        if (check_implicit_progress(rank) == 0) {
+            // report (and forget) the first failure since the last flush
+            nthread_lock(&nnti_implicit_lock);
+            if (rank != -1) {
+                implicit_result_iter_t iter=implicit_results.find(rank);
+                if (iter != implicit_results.end()) {
+                    nnti_rc=iter->second;
+                    implicit_results.erase(iter);
+                }
+            } else {
+                nnti_rc=implicit_result;
+                implicit_result=NNTI_OK;
+            }
+            nthread_unlock(&nnti_implicit_lock);
+            break;
+        }
+
+        elapsed_time=trios_get_time_ms() - entry_time;
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+
+        int timeout_remaining=timeout-elapsed_time;
+        if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
+            nnti_sleep(MAX_SLEEP);
+        } else if (timeout_remaining > 0) {
+            nnti_sleep(timeout_remaining);
+        }
+    }
+
+    log_debug(nnti_debug_level, "exit (nnti_rc=%d)", nnti_rc);
+
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Disable this transport.
+ *
+ * Shutdown the transport.  Any outstanding sends, gets and puts will be
+ * canceled.  Any new transport requests will fail.
+ *
+ */
+NNTI_result_t NNTI_mpi_fini (
+        const NNTI_transport_t *trans_hdl)
+{
+    nthread_counter_fini(&transport_global_data.mbits);
+    nthread_counter_fini(&transport_global_data.put_chunk_tags);
+    nthread_counter_fini(&transport_global_data.get_chunk_tags);
+
+    nthread_lock_fini(&nnti_mpi_lock);
+    nthread_lock_fini(&nnti_buf_bufhash_lock);
+    nthread_lock_fini(&nnti_atomic_buffers_lock);
+    nthread_lock_fini(&nnti_wr_wrhash_lock);
+    nthread_lock_fini(&nnti_target_buffer_queue_lock);
+
+    nthread_lock(&nnti_credit_msgs_lock);
+    for (credit_msg_queue_iter_t iter=credit_msgs.begin();iter != credit_msgs.end();++iter) {
+        MPI_Cancel(&(*iter)->request);
+        MPI_Request_free(&(*iter)->request);
+        free(*iter);
+    }
+    credit_msgs.clear();
+    nthread_unlock(&nnti_credit_msgs_lock);
+    nthread_lock_fini(&nnti_credit_msgs_lock);
+
+    nthread_lock(&nnti_implicit_lock);
+    for (implicit_wr_queue_iter_t iter=implicit_wrs.begin();iter != implicit_wrs.end();++iter) {
+        free((*iter)->nnti_wr);
+        free(*iter);
+    }
+    implicit_wrs.clear();
+    implicit_results.clear();
+    implicit_result=NNTI_OK;
+    nthread_unlock(&nnti_implicit_lock);
+    nthread_lock_fini(&nnti_implicit_lock);
+
+    if (transport_global_data.atomics_vector_updates != NULL) {
+        MPI_Cancel(&transport_global_data.atomics_vector_request);
+        MPI_Request_free(&transport_global_data.atomics_vector_request);
+        free(transport_global_data.atomics_vector_updates);
+        transport_global_data.atomics_vector_updates=NULL;
+    }
+
+    nnti_credits_fini(&request_credits);
+
+    if (transport_global_data.init_called_mpi_init) {
+    	MPI_Finalize();
+    }
+
+    return(NNTI_OK);
+}
+
+
+
+static NNTI_result_t setup_atomics(void)
+{
+    NNTI_result_t rc=NNTI_OK; /* return code */
+
+    trios_declare_timer(callTime);
+
+    uint32_t atomics_bytes;
+
+    log_debug(nnti_debug_level, "enter");
+
+    atomics_bytes=config.min_atomics_vars * sizeof(mpi_atomic_t);
+    trios_start_timer(callTime);
+    transport_global_data.atomics=(mpi_atomic_t*)malloc(atomics_bytes);
+    if (transport_global_data.atomics == NULL) {
+    	rc=NNTI_ENOMEM;
+    	goto cleanup;
+    }
+    memset(transport_global_data.atomics, 0, atomics_bytes);
+    trios_stop_timer("malloc and memset", callTime);
+
+    trios_start_timer(callTime);
+    for (uint32_t i=0;i<config.min_atomics_vars;i++) {
     	nthread_lock_init(&transport_global_data.atomics[i].lock);
     	transport_global_data.atomics[i].value=0;
     }
@@ -2367,17 +3643,25 @@ static int check_target_buffer_progress()
             ops_completed++;
 
             // the op is complete
-            if (!(reg_buf->ops & NNTI_BOP_WITH_EVENTS)) {
-                // app doesn't want events, so we can recycle the work request
-                nthread_lock(&mpi_mem_hdl->wr_queue_lock);
-                wr_queue_iter_t victim=find(mpi_mem_hdl->wr_queue.begin(), mpi_mem_hdl->wr_queue.end(), mpi_wr);
-                if (victim != mpi_mem_hdl->wr_queue.end()) {
-                    log_debug(debug_level, "erasing mpi_wr(%p) from wr_queue", mpi_wr);
-                    mpi_mem_hdl->wr_queue.erase(victim);
-                }
-                nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
+            if (!(reg_buf->ops & NNTI_BOP_WITH_EVENTS) || (mpi_mem_hdl->counter != NULL)) {
+                // app doesn't want events, so we can recycle the work request (and skip the events of a stream)
+                do {
+                    if ((mpi_mem_hdl->counter != NULL) &&
+                        ((mpi_wr->cmd_msg.stream == FALSE) || (mpi_wr->stream_delivered == mpi_wr->chunk_count))) {
+                        // a stream is counted once, after its last chunk
+                        nthread_counter_increment(&mpi_mem_hdl->counter->value);
+                    }
 
-                repost_rdma_target_work_request(mpi_wr);
+                    nthread_lock(&mpi_mem_hdl->wr_queue_lock);
+                    wr_queue_iter_t victim=find(mpi_mem_hdl->wr_queue.begin(), mpi_mem_hdl->wr_queue.end(), mpi_wr);
+                    if (victim != mpi_mem_hdl->wr_queue.end()) {
+                        log_debug(debug_level, "erasing mpi_wr(%p) from wr_queue", mpi_wr);
+                        mpi_mem_hdl->wr_queue.erase(victim);
+                    }
+                    nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
+
+                    repost_rdma_target_work_request(mpi_wr);
+                } while (is_wr_complete(mpi_wr) == TRUE);
             }
         }
     }
@@ -2390,17 +3674,590 @@ static int check_target_buffer_progress()
     return(ops_completed);
 }
 
-static int check_atomic_operation(void)
+/*
+ * Move a just-started implicit operation from the wr_queue of its buffer
+ * to the list NNTI_mpi_flush() drives.  If it didn't start, there is
+ * nothing to track.
+ */
+static NNTI_result_t implicit_track(
+        NNTI_work_request_t *wr,
+        NNTI_result_t        rc)
 {
-    int ops_completed=0;
+    mpi_memory_handle *mpi_mem_hdl=NULL;
+    mpi_work_request  *mpi_wr     =MPI_WORK_REQUEST(wr);
+
+    if ((rc != NNTI_OK) || (mpi_wr == NULL)) {
+        free(wr);
+        return(rc);
+    }
+
+    mpi_mem_hdl=MPI_MEM_HDL(mpi_wr->reg_buf);
+    assert(mpi_mem_hdl);
+
+    nthread_lock(&mpi_mem_hdl->wr_queue_lock);
+    wr_queue_iter_t victim=find(mpi_mem_hdl->wr_queue.begin(), mpi_mem_hdl->wr_queue.end(), mpi_wr);
+    if (victim != mpi_mem_hdl->wr_queue.end()) {
+        mpi_mem_hdl->wr_queue.erase(victim);
+    }
+    nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
+
+    nthread_lock(&nnti_implicit_lock);
+    implicit_wrs.push_back(mpi_wr);
+    nthread_unlock(&nnti_implicit_lock);
+
+    log_debug(nnti_debug_level, "tracking implicit mpi_wr(%p)", mpi_wr);
+
+    return(NNTI_OK);
+}
+
+/*
+ * Test the implicit operations to <rank> (-1 for every rank) and free the
+ * ones that have completed.  Failures are kept for the next flush.
+ * Returns the number still outstanding.
+ */
+static uint32_t check_implicit_progress(
+        const int rank)
+{
+    uint32_t outstanding=0;
+
+    MPI_Status event;
+    int        done=FALSE;
+    int        rc=MPI_SUCCESS;
+
+    nthread_lock(&nnti_implicit_lock);
+    implicit_wr_queue_iter_t iter=implicit_wrs.begin();
+    while (iter != implicit_wrs.end()) {
+        mpi_work_request *mpi_wr=*iter;
+
+        if ((rank != -1) && (mpi_wr->peer.peer.NNTI_remote_process_t_u.mpi.rank != rank)) {
+            ++iter;
+            continue;
+        }
+
+        if (is_wr_complete(mpi_wr) == FALSE) {
+            memset(&event, 0, sizeof(MPI_Status));
+            done=FALSE;
+            nthread_lock(&nnti_mpi_lock);
+            rc=MPI_Testany(mpi_wr->request_count, mpi_wr->request_ptr, &mpi_wr->request_index, &done, &event);
+            nthread_unlock(&nnti_mpi_lock);
+            if (rc != MPI_SUCCESS) {
+                log_error(nnti_debug_level, "MPI_Testany() failed (request=%p): rc=%d", mpi_wr->request_ptr, rc);
+                // nobody waits on this operation.  give up on it and let the flush report it.
+                nthread_lock(&nnti_mpi_lock);
+                for (uint32_t i=0;i<mpi_wr->request_count;i++) {
+                    if (mpi_wr->request_ptr[i] != MPI_REQUEST_NULL) {
+                        MPI_Cancel(&mpi_wr->request_ptr[i]);
+                        MPI_Request_free(&mpi_wr->request_ptr[i]);
+                    }
+                }
+                nthread_unlock(&nnti_mpi_lock);
+                mpi_wr->nnti_wr->result=NNTI_EIO;
+            } else if ((done == TRUE) && (mpi_wr->request_index != MPI_UNDEFINED)) {
+                process_event(mpi_wr, &event);
+            }
+        }
+
+        if ((mpi_wr->nnti_wr->result != NNTI_OK) || (is_wr_complete(mpi_wr) == TRUE)) {
+            log_debug(nnti_debug_level, "retiring implicit mpi_wr(%p) (result=%d)", mpi_wr, mpi_wr->nnti_wr->result);
+            if (mpi_wr->nnti_wr->result != NNTI_OK) {
+                int wr_rank=mpi_wr->peer.peer.NNTI_remote_process_t_u.mpi.rank;
+                if (implicit_results.find(wr_rank) == implicit_results.end()) {
+                    implicit_results[wr_rank]=mpi_wr->nnti_wr->result;
+                }
+                if (implicit_result == NNTI_OK) {
+                    implicit_result=mpi_wr->nnti_wr->result;
+                }
+            }
+            free(mpi_wr->nnti_wr);
+            free(mpi_wr);
+            iter=implicit_wrs.erase(iter);
+        } else {
+            outstanding++;
+            ++iter;
+        }
+    }
+    nthread_unlock(&nnti_implicit_lock);
+
+    return(outstanding);
+}
+
+/*
+ * Reap finished credit messages, answer connect requests and collect
+ * credits that peers returned in their own message.  Returns the number
+ * of messages received.
+ */
+static int check_control_messages(void)
+{
+    int received=0;
+
+    nthread_lock(&nnti_credit_msgs_lock);
+    credit_msg_queue_iter_t iter=credit_msgs.begin();
+    while (iter != credit_msgs.end()) {
+        int done=FALSE;
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Test(&(*iter)->request, &done, MPI_STATUS_IGNORE);
+        nthread_unlock(&nnti_mpi_lock);
+        if (done) {
+            free(*iter);
+            iter=credit_msgs.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    nthread_unlock(&nnti_credit_msgs_lock);
+
+    while (1) {
+        int             flag=FALSE;
+        uint32_t        granted=0;
+        MPI_Status      event;
+        mpi_credit_msg *msg=NULL;
+
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Iprobe(MPI_ANY_SOURCE, NNTI_MPI_CONNECT_TAG, MPI_COMM_WORLD, &flag, &event);
+        if (flag) {
+            MPI_Recv(&granted, sizeof(granted), MPI_BYTE, event.MPI_SOURCE, NNTI_MPI_CONNECT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        nthread_unlock(&nnti_mpi_lock);
+        if (!flag) {
+            break;
+        }
+
+        msg=(mpi_credit_msg *)malloc(sizeof(mpi_credit_msg));
+        assert(msg);
+        msg->credits=request_credit_offer();
+        nnti_credits_connect(&request_credits, event.MPI_SOURCE, msg->credits, granted);
+
+        log_debug(nnti_debug_level, "answering connect from rank %d with %u credits", event.MPI_SOURCE, msg->credits);
+
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Isend(&msg->credits, sizeof(msg->credits), MPI_BYTE, event.MPI_SOURCE, NNTI_MPI_CONNECT_REPLY_TAG, MPI_COMM_WORLD, &msg->request);
+        nthread_unlock(&nnti_mpi_lock);
+
+        nthread_lock(&nnti_credit_msgs_lock);
+        credit_msgs.push_back(msg);
+        nthread_unlock(&nnti_credit_msgs_lock);
+
+        received++;
+    }
+
+    if (!nnti_credits_enabled(&request_credits)) {
+        return(received);
+    }
+
+    while (1) {
+        int        flag=FALSE;
+        uint32_t   credits=0;
+        MPI_Status event;
+
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Iprobe(MPI_ANY_SOURCE, NNTI_MPI_CREDIT_TAG, MPI_COMM_WORLD, &flag, &event);
+        if (flag) {
+            MPI_Recv(&credits, sizeof(credits), MPI_BYTE, event.MPI_SOURCE, NNTI_MPI_CREDIT_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        nthread_unlock(&nnti_mpi_lock);
+        if (!flag) {
+            break;
+        }
+
+        nnti_credits_add(&request_credits, event.MPI_SOURCE, credits);
+        received++;
+    }
+
+    return(received);
+}
+
+/*
+ * The credits to offer a connecting peer: one for each slot in the
+ * request queue, capped by the configured limit.  Requests to a ring
+ * vary in size, so a ring is offered the limit.
+ */
+static uint32_t request_credit_offer(void)
+{
+    if (transport_global_data.req_ring.reg_buf != NULL) {
+        return(nnti_credits_offer(&request_credits, request_credits.limit));
+    }
+    return(nnti_credits_offer(&request_credits, transport_global_data.req_queue.req_count));
+}
+
+/*
+ * Tell <tt>rank</tt> how many request credits this process offers it and
+ * wait for its offer in return.  The peer answers from its progress
+ * engine.  Connect requests are answered while waiting because
+ * <tt>rank</tt> may be this process or may be connecting to this process.
+ */
+static NNTI_result_t exchange_request_credits(
+        const int rank,
+        const int timeout)
+{
+    mpi_credit_msg *msg=NULL;
+    uint32_t offered=request_credit_offer();
+    uint32_t granted=0;
+    int      flag=FALSE;
+
+    long entry_time=trios_get_time_ms();
+
+    msg=(mpi_credit_msg *)malloc(sizeof(mpi_credit_msg));
+    assert(msg);
+    msg->credits=offered;
+
+    nthread_lock(&nnti_mpi_lock);
+    MPI_Isend(&msg->credits, sizeof(msg->credits), MPI_BYTE, rank, NNTI_MPI_CONNECT_TAG, MPI_COMM_WORLD, &msg->request);
+    nthread_unlock(&nnti_mpi_lock);
+
+    nthread_lock(&nnti_credit_msgs_lock);
+    credit_msgs.push_back(msg);
+    nthread_unlock(&nnti_credit_msgs_lock);
+
+    while (1) {
+        check_control_messages();
+
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Iprobe(rank, NNTI_MPI_CONNECT_REPLY_TAG, MPI_COMM_WORLD, &flag, MPI_STATUS_IGNORE);
+        if (flag) {
+            MPI_Recv(&granted, sizeof(granted), MPI_BYTE, rank, NNTI_MPI_CONNECT_REPLY_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        nthread_unlock(&nnti_mpi_lock);
+        if (flag) {
+            break;
+        }
+
+        if ((timeout >= 0) && (trios_get_time_ms() - entry_time > timeout)) {
+            log_debug(nnti_debug_level, "rank %d didn't answer the connect within %d ms", rank, timeout);
+            return(NNTI_ETIMEDOUT);
+        }
+        nnti_sleep(1);
+    }
+
+    nnti_credits_connect(&request_credits, rank, offered, granted);
+
+    return(NNTI_OK);
+}
+
+/*
+ * A request from <tt>rank</tt> was consumed.  Credits are normally returned
+ * with the next command message to <tt>rank</tt>.  If this process hasn't
+ * sent one by the time half of the offer is owed, the credits are sent
+ * back in a message of their own so the client doesn't stall.
+ */
+static void return_request_credits(
+        int      rank,
+        uint32_t credits)
+{
+    mpi_credit_msg *msg=NULL;
+    uint32_t        owed=0;
+
+    owed=nnti_credits_owe(&request_credits, rank, credits);
+    if (owed == 0) {
+        return;
+    }
+
+    msg=(mpi_credit_msg *)malloc(sizeof(mpi_credit_msg));
+    assert(msg);
+    msg->credits=owed;
+
+    log_debug(nnti_debug_level, "returning %u credits to rank %d", msg->credits, rank);
+
+    nthread_lock(&nnti_mpi_lock);
+    MPI_Isend(&msg->credits, sizeof(msg->credits), MPI_BYTE, rank, NNTI_MPI_CREDIT_TAG, MPI_COMM_WORLD, &msg->request);
+    nthread_unlock(&nnti_mpi_lock);
+
+    nthread_lock(&nnti_credit_msgs_lock);
+    credit_msgs.push_back(msg);
+    nthread_unlock(&nnti_credit_msgs_lock);
+}
+
+/*
+ * Move matched requests into the request ring until there are no more
+ * requests or the ring is full.  Returns the number of requests received.
+ */
+static int check_request_ring_progress(void)
+{
+    int rc=MPI_SUCCESS;
+    int received=0;
+    mpi_request_ring_handle *ring=&transport_global_data.req_ring;
+
+    if (ring->reg_buf == NULL) {
+        return(0);
+    }
+
+    nthread_lock(&ring->lock);
+    while (1) {
+        int                  flag=FALSE;
+        int                  length=0;
+        int64_t              offset=0;
+        uint64_t             need=0;
+        mpi_ring_record_hdr *hdr=NULL;
+        MPI_Status           event;
+
+        if (!ring->have_pending) {
+            nthread_lock(&nnti_mpi_lock);
+            rc=MPI_Improbe(MPI_ANY_SOURCE, NNTI_MPI_REQUEST_TAG, MPI_COMM_WORLD, &flag, &ring->pending_msg, &ring->pending_event);
+            nthread_unlock(&nnti_mpi_lock);
+            if ((rc != MPI_SUCCESS) || (flag == FALSE)) {
+                break;
+            }
+            ring->have_pending=true;
+        }
+
+        MPI_Get_count(&ring->pending_event, MPI_BYTE, &length);
+        need=RING_RECORD_SIZE(length);
+
+        if (need > ring->ring_size) {
+            /* this request will never fit.  receive it and throw it away. */
+            char *scratch=(char *)malloc(length);
+            log_error(nnti_debug_level, "request (src=%d ; length=%d) is larger than the request ring (%llu bytes).  dropping.",
+                    ring->pending_event.MPI_SOURCE, length, (unsigned long long)ring->ring_size);
+            nthread_lock(&nnti_mpi_lock);
+            MPI_Mrecv(scratch, length, MPI_BYTE, &ring->pending_msg, &event);
+            nthread_unlock(&nnti_mpi_lock);
+            free(scratch);
+            ring->have_pending=false;
+            continue;
+        }
+
+        offset=ring_reserve(ring, need);
+        if (offset < 0) {
+            log_debug(nnti_debug_level, "request ring is full (used=%llu ; need=%llu)",
+                    (unsigned long long)ring->used, (unsigned long long)need);
+            break;
+        }
+
+        hdr=(mpi_ring_record_hdr *)(ring->ring + offset);
+        nthread_lock(&nnti_mpi_lock);
+        MPI_Mrecv(ring->ring + offset + sizeof(mpi_ring_record_hdr), length, MPI_BYTE, &ring->pending_msg, &event);
+        nthread_unlock(&nnti_mpi_lock);
+
+        hdr->length  =length;
+        hdr->size    =need;
+        hdr->src_rank=event.MPI_SOURCE;
+        hdr->state   =RING_RECORD_READY;
+
+        log_debug(nnti_debug_level, "received request into ring (offset=%lld ; src=%d ; length=%d)",
+                (long long)offset, event.MPI_SOURCE, length);
+
+        ring->have_pending=false;
+        ring->ready_count++;
+        received++;
+    }
+    nthread_unlock(&ring->lock);
+
+    return(received);
+}
+
+/*
+ * Reserve <tt>need</tt> contiguous bytes at the head of the ring.  Returns
+ * the offset of the new record or -1 if there isn't enough room.  Call with
+ * the ring lock held.
+ */
+static int64_t ring_reserve(
+        mpi_request_ring_handle *ring,
+        uint64_t                 need)
+{
+    int64_t offset=-1;
+
+    if (ring->used == 0) {
+        /* empty ring.  start over at the beginning to avoid a wrap. */
+        ring->head   =0;
+        ring->tail   =0;
+        ring->deliver=0;
+    }
+    if (ring->used == ring->ring_size) {
+        return(-1);
+    }
+
+    if (ring->head >= ring->tail) {
+        uint64_t room_at_end=ring->ring_size - ring->head;
+        if (room_at_end >= need) {
+            offset=ring->head;
+        } else if (ring->tail >= need) {
+            if (room_at_end > 0) {
+                mpi_ring_record_hdr *skip=(mpi_ring_record_hdr *)(ring->ring + ring->head);
+                skip->length=0;
+                skip->size  =room_at_end;
+                skip->state =RING_RECORD_SKIP;
+                ring->used += room_at_end;
+            }
+            offset=0;
+        }
+    } else if (ring->tail - ring->head >= need) {
+        offset=ring->head;
+    }
+
+    if (offset >= 0) {
+        ring->head=offset + need;
+        if (ring->head == ring->ring_size) {
+            ring->head=0;
+        }
+        ring->used += need;
+    }
+
+    return(offset);
+}
+
+/*
+ * Hand out the oldest received record.  Call with the ring lock held and
+ * ready_count > 0.
+ */
+static int64_t ring_deliver(
+        mpi_request_ring_handle *ring)
+{
+    uint64_t             offset=ring->deliver;
+    mpi_ring_record_hdr *hdr=NULL;
+
+    if (offset == ring->ring_size) {
+        offset=0;
+    }
+    hdr=(mpi_ring_record_hdr *)(ring->ring + offset);
+    if (hdr->state == RING_RECORD_SKIP) {
+        offset=0;
+        hdr=(mpi_ring_record_hdr *)ring->ring;
+    }
+    assert(hdr->state == RING_RECORD_READY);
+
+    hdr->state=RING_RECORD_LOANED;
+    ring->deliver=offset + hdr->size;
+    ring->ready_count--;
+
+    return(offset);
+}
+
+/*
+ * Release the record at <tt>offset</tt>.  Records may be released in any
+ * order, but space is only reclaimed from the tail.
+ */
+static void ring_release(
+        mpi_request_ring_handle *ring,
+        uint64_t                 offset)
+{
+    mpi_ring_record_hdr *hdr=(mpi_ring_record_hdr *)(ring->ring + offset);
+    int                  src_rank=hdr->src_rank;
+
+    log_debug(nnti_debug_level, "releasing ring record (offset=%llu)", (unsigned long long)offset);
+
+    nthread_lock(&ring->lock);
+    hdr->state=RING_RECORD_RELEASED;
+    while (ring->used > 0) {
+        if (ring->tail == ring->ring_size) {
+            ring->tail=0;
+        }
+        hdr=(mpi_ring_record_hdr *)(ring->ring + ring->tail);
+        if ((hdr->state != RING_RECORD_RELEASED) && (hdr->state != RING_RECORD_SKIP)) {
+            break;
+        }
+        ring->used -= hdr->size;
+        ring->tail += hdr->size;
+    }
+    if (ring->tail == ring->ring_size) {
+        ring->tail=0;
+    }
+    nthread_unlock(&ring->lock);
+
+    return_request_credits(src_rank, 1);
+}
+
+static void create_ring_status(
+        mpi_request_ring_handle *ring,
+        uint64_t                 offset,
+        NNTI_status_t           *status)
+{
+    mpi_ring_record_hdr *hdr=(mpi_ring_record_hdr *)(ring->ring + offset);
+
+    status->op    =NNTI_BOP_RECV_RING;
+    status->result=NNTI_OK;
+    status->start =ring->reg_buf->payload;
+    status->offset=offset + sizeof(mpi_ring_record_hdr);
+    status->length=hdr->length;
+    create_peer(&status->src, hdr->src_rank);
+    create_peer(&status->dest, transport_global_data.rank);
+}
+
+/*
+ * NNTI_mpi_wait() for a request ring.  The record returned by the previous
+ * wait on <tt>wr</tt> is released first.
+ */
+static NNTI_result_t ring_wait(
+        NNTI_work_request_t  *wr,
+        const int             timeout,
+        NNTI_status_t        *status)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    mpi_request_ring_handle *ring=&transport_global_data.req_ring;
+    int64_t offset=-1;
+
+    long entry_time=trios_get_time_ms();
+    long elapsed_time=0;
+
+    if (wr->transport_private != 0) {
+        ring_release(ring, wr->transport_private-1);
+        wr->transport_private=(uint64_t)NULL;
+    }
+
+    while (1) {
+        if (trios_exit_now()) {
+            log_debug(nnti_debug_level, "caught abort signal");
+            nnti_rc=NNTI_ECANCELED;
+            break;
+        }
+
+        check_atomic_operation();
+        check_target_buffer_progress();
+        check_request_ring_progress();
+        check_control_messages();
+
+        nthread_lock(&ring->lock);
+        if (ring->ready_count > 0) {
+            offset=ring_deliver(ring);
+        }
+        nthread_unlock(&ring->lock);
+
+        if (offset >= 0) {
+            break;
+        }
+
+        elapsed_time=trios_get_time_ms() - entry_time;
+        if ((timeout >= 0) && (elapsed_time >= timeout)) {
+            nnti_rc=NNTI_ETIMEDOUT;
+            break;
+        }
+
+        int timeout_remaining=timeout-elapsed_time;
+        if ((timeout < 0) || (timeout_remaining > MAX_SLEEP)) {
+            nnti_sleep(MAX_SLEEP);
+        } else if (timeout_remaining > 0) {
+            nnti_sleep(timeout_remaining);
+        }
+    }
+
+    if (nnti_rc == NNTI_OK) {
+        wr->transport_private=(uint64_t)offset+1;
+        wr->result           =NNTI_OK;
+        create_ring_status(ring, offset, status);
+    } else {
+        status->op    =wr->ops;
+        status->result=nnti_rc;
+    }
+
+    return(nnti_rc);
+}
+
+static int check_atomic_operation(void)
+{
+    int ops_completed=0;
 
     int rc=MPI_SUCCESS;
 
     MPI_Status event;
     int        done=FALSE;
 
-    int atomics_index   =-1;
-    mpi_atomic_t *atomic=NULL;
+    mpi_atomic_request_msg *req=&transport_global_data.atomics_request_msg;
+    int64_t        *target=NULL;
+    nthread_lock_t *lock  =NULL;
+
+    mpi_atomic_t           *atomic   =NULL;
+    NNTI_callback_fn_t      cbfunc   =NULL;
+    void                   *context  =NULL;
+    const NNTI_transport_t *trans_hdl=NULL;
+    uint64_t                index    =0;
 
     log_level debug_level=nnti_debug_level;
 
@@ -2409,83 +4266,300 @@ static int check_atomic_operation(void)
 
     trios_start_timer(total_time);
 
-    log_debug(debug_level, "enter");
+    log_debug(debug_level, "enter");
+
+    if (transport_global_data.atomics_vector_updates != NULL) {
+        /* the next request waits until the updates of a vector are applied */
+        ops_completed=atomic_vector_check();
+        goto cleanup;
+    }
+
+    memset(&event, 0, sizeof(MPI_Status));
+    done=FALSE;
+    trios_start_timer(call_time);
+    nthread_lock(&nnti_mpi_lock);
+    /* NULL while another thread handles the last request */
+    if (transport_global_data.atomics_recv_request != MPI_REQUEST_NULL) {
+        rc = MPI_Test(&transport_global_data.atomics_recv_request, &done, &event);
+    }
+    nthread_unlock(&nnti_mpi_lock);
+    trios_stop_timer("check_atomic_operation - MPI_Test", call_time);
+    log_debug(debug_level, "polling status is %d", rc);
+
+    log_debug(debug_level, "Poll Event= {");
+    log_debug(debug_level, "\tsource  = %d", event.MPI_SOURCE);
+    log_debug(debug_level, "\ttag     = %d", event.MPI_TAG);
+    log_debug(debug_level, "\terror   = %d", event.MPI_ERROR);
+    log_debug(debug_level, "}");
+    log_debug(debug_level, "done = %d", done);
+
+    if (rc == MPI_SUCCESS) {
+    	/* case 1: success */
+    	if (done == 0) {
+    		goto cleanup;
+    	}
+    }
+    /* MPI_Test failure */
+    else {
+    	log_error(debug_level, "MPI_Test(atomics_recv_request) failed: rc=%d", rc);
+    	goto cleanup;
+    }
+
+    if (req->op == MPI_ATOMIC_VECTOR) {
+        atomic_vector_recv(req->index, event.MPI_SOURCE);
+        goto cleanup;
+    }
+
+    if (req->on_buffer) {
+        /* the map lock also keeps the buffer from being unregistered under us */
+        lock=&nnti_atomic_buffers_lock;
+        nthread_lock(lock);
+        atomic_buf_by_tag_iter_t iter=atomic_buffers_by_tag.find(req->buffer_tag);
+        if ((iter != atomic_buffers_by_tag.end()) &&
+            (req->offset + sizeof(int64_t) <= iter->second->payload_size)) {
+            target=(int64_t *)(iter->second->payload + req->offset);
+        }
+    } else if (req->index < config.min_atomics_vars) {
+        index =req->index;
+        atomic=&transport_global_data.atomics[index];
+        lock  =&atomic->lock;
+        target=&atomic->value;
+        nthread_lock(lock);
+    }
+
+    transport_global_data.atomics_result_msg.result=0;
+    transport_global_data.atomics_result_msg.status=NNTI_OK;
+    if (target == NULL) {
+        if (req->on_buffer) {
+            log_error(debug_level, "no atomic buffer at (tag=%u ; offset=%llu)",
+                    req->buffer_tag, (unsigned long long)req->offset);
+        } else {
+            log_error(debug_level, "atomic index (%u) is out of range (max_index=%u)",
+                    req->index, config.min_atomics_vars);
+        }
+        transport_global_data.atomics_result_msg.status=NNTI_EINVAL;
+    } else {
+        switch (req->op) {
+            case MPI_ATOMIC_FOP:
+                transport_global_data.atomics_result_msg.result = *target;
+                *target = nnti_atomic_apply((NNTI_atomic_op_t)req->nnti_op, *target, req->compare_add);
+                break;
+            case MPI_ATOMIC_CMP_AND_SWP:
+                transport_global_data.atomics_result_msg.result = *target;
+                if (*target == req->compare_add) {
+                    *target = req->swap;
+                }
+                break;
+            default:
+                log_error(debug_level, "unknown atomic op: rc=%d", req->op);
+                transport_global_data.atomics_result_msg.status=NNTI_EINVAL;
+                break;
+        }
+        if ((atomic != NULL) && (atomic->cbfunc != NULL)) {
+            int64_t previous=transport_global_data.atomics_result_msg.result;
+            if (!atomic->use_threshold ||
+                ((previous < atomic->threshold) && (*target >= atomic->threshold))) {
+                cbfunc   =atomic->cbfunc;
+                context  =atomic->context;
+                trans_hdl=atomic->trans_hdl;
+            }
+        }
+    }
+
+    if (req->reply) {
+        nthread_lock(&nnti_mpi_lock);
+        rc=MPI_Send(
+                (char*)&transport_global_data.atomics_result_msg,
+                sizeof(transport_global_data.atomics_result_msg),
+                MPI_BYTE,
+                event.MPI_SOURCE,
+                NNTI_MPI_ATOMICS_RESULT_TAG,
+                MPI_COMM_WORLD);
+        nthread_unlock(&nnti_mpi_lock);
+        if (rc != MPI_SUCCESS) {
+            log_error(nnti_debug_level, "failed to send with Isend");
+        }
+    }
+
+    if (lock != NULL) {
+        nthread_unlock(lock);
+    }
+
+    ops_completed++;
+
+    post_atomics_recv_request();
+
+    /* the request is reposted first, so the callback may issue atomics of its own */
+    if (cbfunc != NULL) {
+        cbfunc(trans_hdl, index, context);
+    }
+
+cleanup:
+    trios_stop_timer("check_atomic_operation", total_time);
+
+    log_debug(debug_level, "exit");
+
+    return(ops_completed);
+}
+
+
+/*
+ * Post the receive for the updates of a vectored atomic from <source>.
+ * The initiator sent them right behind the request.  progress() applies
+ * them from atomic_vector_check() once they land.
+ */
+static void atomic_vector_recv(
+        const uint32_t update_count,
+        const int      source)
+{
+    int rc=MPI_SUCCESS;
+
+    NNTI_atomic_update_t *updates=(NNTI_atomic_update_t *)malloc(update_count*sizeof(NNTI_atomic_update_t));
+    assert(updates);
+
+    log_debug(nnti_debug_level, "receiving %u atomic updates from rank(%d)", update_count, source);
+
+    nthread_lock(&nnti_mpi_lock);
+    rc=MPI_Irecv(
+            updates,
+            update_count*sizeof(NNTI_atomic_update_t),
+            MPI_BYTE,
+            source,
+            NNTI_MPI_ATOMICS_VECTOR_TAG,
+            MPI_COMM_WORLD,
+            &transport_global_data.atomics_vector_request);
+    if (rc == MPI_SUCCESS) {
+        transport_global_data.atomics_vector_count  =update_count;
+        transport_global_data.atomics_vector_source =source;
+        transport_global_data.atomics_vector_updates=updates;
+    }
+    nthread_unlock(&nnti_mpi_lock);
+    if (rc != MPI_SUCCESS) {
+        log_error(nnti_debug_level, "failed to post the receive for the atomic updates: rc=%d", rc);
+        atomic_vector_apply(updates, update_count, source, NNTI_EIO);
+    }
+}
+
+/*
+ * Apply the updates of a vectored atomic if they have landed.  Returns
+ * the number of vectors applied.
+ */
+static int atomic_vector_check(void)
+{
+    int rc  =MPI_SUCCESS;
+    int done=FALSE;
+
+    NNTI_atomic_update_t *updates=NULL;
+    uint32_t              update_count=0;
+    int                   source=0;
 
-    memset(&event, 0, sizeof(MPI_Status));
-    done=FALSE;
-    trios_start_timer(call_time);
     nthread_lock(&nnti_mpi_lock);
-    rc = MPI_Test(&transport_global_data.atomics_recv_request, &done, &event);
+    /* test and take the updates together so only one thread applies them */
+    if (transport_global_data.atomics_vector_updates != NULL) {
+        rc=MPI_Test(&transport_global_data.atomics_vector_request, &done, MPI_STATUS_IGNORE);
+        if ((rc != MPI_SUCCESS) || (done)) {
+            updates     =transport_global_data.atomics_vector_updates;
+            update_count=transport_global_data.atomics_vector_count;
+            source      =transport_global_data.atomics_vector_source;
+            transport_global_data.atomics_vector_updates=NULL;
+        }
+    }
     nthread_unlock(&nnti_mpi_lock);
-    trios_stop_timer("check_atomic_operation - MPI_Test", call_time);
-    log_debug(debug_level, "polling status is %d", rc);
-
-    log_debug(debug_level, "Poll Event= {");
-    log_debug(debug_level, "\tsource  = %d", event.MPI_SOURCE);
-    log_debug(debug_level, "\ttag     = %d", event.MPI_TAG);
-    log_debug(debug_level, "\terror   = %d", event.MPI_ERROR);
-    log_debug(debug_level, "}");
-    log_debug(debug_level, "done = %d", done);
 
-    if (rc == MPI_SUCCESS) {
-    	/* case 1: success */
-    	if (done == 0) {
-    		goto cleanup;
-    	}
+    if (updates == NULL) {
+        return(0);
     }
-    /* MPI_Test failure */
-    else {
-    	log_error(debug_level, "MPI_Test(atomics_recv_request) failed: rc=%d", rc);
-    	goto cleanup;
+    if (rc != MPI_SUCCESS) {
+        log_error(nnti_debug_level, "failed to receive the atomic updates: rc=%d", rc);
     }
 
-    atomics_index=transport_global_data.atomics_request_msg.index;
-    atomic       =&transport_global_data.atomics[atomics_index];
+    atomic_vector_apply(updates, update_count, source, (rc == MPI_SUCCESS) ? NNTI_OK : NNTI_EIO);
 
-    nthread_lock(&atomic->lock);
+    return(1);
+}
+
+/*
+ * Apply the updates of a vectored atomic from <source>.  Each update is
+ * applied under the lock of its variable, then the previous values and
+ * <status> go back in one reply.  If any update names a variable past the
+ * atomics table or an unknown op, none are applied and the reply carries
+ * NNTI_EINVAL.  Like a single atomic, the request is reposted before any
+ * callback runs.  Frees <updates>.
+ */
+static void atomic_vector_apply(
+        NNTI_atomic_update_t *updates,
+        const uint32_t        update_count,
+        const int             source,
+        NNTI_result_t         status)
+{
+    int      rc=MPI_SUCCESS;
+    uint32_t applied=0;
+
+    std::deque<uint64_t> fired;
+
+    int64_t *results=(int64_t *)calloc(update_count+1, sizeof(int64_t));
+    assert(results);
+
+    for (uint32_t i=0;(i<update_count) && (status == NNTI_OK);i++) {
+        if (updates[i].target_atomic >= config.min_atomics_vars) {
+            log_error(nnti_debug_level, "atomic update %u targets variable %llu (only %u variables)",
+                    i, (unsigned long long)updates[i].target_atomic, config.min_atomics_vars);
+            status=NNTI_EINVAL;
+        } else if (nnti_atomic_fetches(updates[i].op) < 0) {
+            log_error(nnti_debug_level, "atomic update %u has an unknown op (%d)", i, updates[i].op);
+            status=NNTI_EINVAL;
+        }
+    }
+    if (status == NNTI_OK) {
+        applied=update_count;
+    }
 
-    switch (transport_global_data.atomics_request_msg.op) {
-		case MPI_ATOMIC_FETCH_ADD:
-			transport_global_data.atomics_result_msg.result = atomic->value;
-			atomic->value += transport_global_data.atomics_request_msg.compare_add;
-			break;
-		case MPI_ATOMIC_CMP_AND_SWP:
-			transport_global_data.atomics_result_msg.result=atomic->value;
-			if (atomic->value == transport_global_data.atomics_request_msg.compare_add) {
-				atomic->value = transport_global_data.atomics_request_msg.swap;
-			}
-			break;
-		default:
-	    	log_error(debug_level, "unknown atomic op: rc=%d", transport_global_data.atomics_request_msg.op);
-			break;
+    for (uint32_t i=0;i<applied;i++) {
+        mpi_atomic_t *atomic=&transport_global_data.atomics[updates[i].target_atomic];
+
+        nthread_lock(&atomic->lock);
+        results[i]   =atomic->value;
+        atomic->value=nnti_atomic_apply(updates[i].op, atomic->value, updates[i].operand);
+        if ((atomic->cbfunc != NULL) &&
+            (!atomic->use_threshold ||
+             ((results[i] < atomic->threshold) && (atomic->value >= atomic->threshold)))) {
+            fired.push_back(updates[i].target_atomic);
+        }
+        nthread_unlock(&atomic->lock);
     }
+    results[update_count]=status;
 
     nthread_lock(&nnti_mpi_lock);
     rc=MPI_Send(
-            (char*)&transport_global_data.atomics_result_msg,
-            sizeof(transport_global_data.atomics_result_msg),
+            (char*)results,
+            (update_count+1)*sizeof(int64_t),
             MPI_BYTE,
-            event.MPI_SOURCE,
+            source,
             NNTI_MPI_ATOMICS_RESULT_TAG,
             MPI_COMM_WORLD);
     nthread_unlock(&nnti_mpi_lock);
     if (rc != MPI_SUCCESS) {
         log_error(nnti_debug_level, "failed to send with Isend");
-        goto cleanup;
     }
 
-    nthread_unlock(&atomic->lock);
-
-    ops_completed++;
+    free(updates);
+    free(results);
 
     post_atomics_recv_request();
 
-cleanup:
-    trios_stop_timer("check_atomic_operation", total_time);
+    for (std::deque<uint64_t>::iterator iter=fired.begin();iter!=fired.end();++iter) {
+        mpi_atomic_t *atomic=&transport_global_data.atomics[*iter];
 
-    log_debug(debug_level, "exit");
+        nthread_lock(&atomic->lock);
+        NNTI_callback_fn_t      cbfunc   =atomic->cbfunc;
+        void                   *context  =atomic->context;
+        const NNTI_transport_t *trans_hdl=atomic->trans_hdl;
+        nthread_unlock(&atomic->lock);
 
-    return(ops_completed);
+        if (cbfunc != NULL) {
+            cbfunc(trans_hdl, *iter, context);
+        }
+    }
 }
 
 
@@ -2508,11 +4582,28 @@ static int process_event(
             log_debug(debug_level, "got NNTI_BOP_ATOMICS send completion - event arrived from %d - tag %4d",
                     event->MPI_SOURCE, event->MPI_TAG);
 
+            if (mpi_wr->request_ptr == &mpi_wr->request[ATOMICS_SEND_INDEX]) {
+                mpi_wr->active_requests &= ~ATOMICS_SEND_REQUEST_ACTIVE;
+            } else {
+                mpi_wr->active_requests &= ~ATOMICS_VECTOR_REQUEST_ACTIVE;
+            }
+            if (mpi_wr->active_requests & ATOMICS_VECTOR_REQUEST_ACTIVE) {
+                /* the updates of a vectored atomic must be sent too */
+                mpi_wr->request_ptr  =&mpi_wr->request[ATOMICS_VECTOR_INDEX];
+                mpi_wr->request_count=1;
+                mpi_wr->nnti_wr->result=NNTI_OK;
+                return NNTI_OK;
+            }
+
             mpi_wr->op_state = SEND_COMPLETE;
-            mpi_wr->active_requests &= ~ATOMICS_SEND_REQUEST_ACTIVE;
 
-            mpi_wr->request_ptr  =&mpi_wr->request[ATOMICS_RECV_INDEX];
-            mpi_wr->request_count=1;
+            if (mpi_wr->active_requests & ATOMICS_RECV_REQUEST_ACTIVE) {
+                mpi_wr->request_ptr  =&mpi_wr->request[ATOMICS_RECV_INDEX];
+                mpi_wr->request_count=1;
+            } else {
+                /* a non-fetching op is done once the request is sent */
+                mpi_wr->op_state = RECV_COMPLETE;
+            }
 
     	} else if (mpi_wr->op_state == SEND_COMPLETE) {
             log_debug(debug_level, "got NNTI_BOP_ATOMICS recv completion - event arrived from %d - tag %4d",
@@ -2520,11 +4611,29 @@ static int process_event(
 
             mpi_wr->op_state = RECV_COMPLETE;
             mpi_wr->active_requests &= ~ATOMICS_RECV_REQUEST_ACTIVE;
-    	}
 
-    	nthread_lock(&transport_global_data.atomics[mpi_wr->atomics_result_index].lock);
-    	transport_global_data.atomics[mpi_wr->atomics_result_index].value = transport_global_data.atomics_result_msg.result;
-    	nthread_unlock(&transport_global_data.atomics[mpi_wr->atomics_result_index].lock);
+            NNTI_result_t status;
+            if (mpi_wr->atomics_updates != NULL) {
+                status=(NNTI_result_t)mpi_wr->atomics_results[mpi_wr->atomics_update_count];
+                atomic_vector_release(mpi_wr, (status == NNTI_OK));
+            } else {
+                status=(NNTI_result_t)mpi_wr->atomics_result_msg.status;
+                if (status != NNTI_OK) {
+                    /* the target left the value alone */
+                } else if (mpi_wr->atomics_result != NULL) {
+                    *mpi_wr->atomics_result = mpi_wr->atomics_result_msg.result;
+                } else {
+                    nthread_lock(&transport_global_data.atomics[mpi_wr->atomics_result_index].lock);
+                    transport_global_data.atomics[mpi_wr->atomics_result_index].value = mpi_wr->atomics_result_msg.result;
+                    nthread_unlock(&transport_global_data.atomics[mpi_wr->atomics_result_index].lock);
+                }
+            }
+            if (status != NNTI_OK) {
+                log_debug(debug_level, "the target didn't apply the atomic: status=%d", status);
+                mpi_wr->nnti_wr->result=status;
+                return status;
+            }
+    	}
 
         mpi_wr->nnti_wr->result=NNTI_OK;
         return NNTI_OK;
@@ -2541,6 +4650,8 @@ static int process_event(
          * message tells us the operation being performed by
          * the remote initiator.  */
         mpi_wr->last_op = mpi_wr->cmd_msg.op;
+
+        nnti_credits_add(&request_credits, event->MPI_SOURCE, mpi_wr->cmd_msg.credits);
     }
 
     log_debug(debug_level, "mpi_wr=%p; mpi_wr->last_op=%d", mpi_wr, mpi_wr->last_op);
@@ -2576,15 +4687,27 @@ static int process_event(
             mpi_wr->op_state = RDMA_RTS_COMPLETE;
             mpi_wr->active_requests &= ~RDMA_CMD_REQUEST_ACTIVE;
 
-            mpi_wr->request_ptr  =&mpi_wr->request[PUT_SEND_INDEX];
+            if (mpi_wr->chunk_count > 0) {
+                mpi_wr->request_ptr=&mpi_wr->chunk_request[mpi_wr->chunk_retired % mpi_wr->chunk_window];
+            } else {
+                mpi_wr->request_ptr=&mpi_wr->request[PUT_SEND_INDEX];
+            }
             mpi_wr->request_count=1;
 
         } else if (mpi_wr->op_state == RDMA_RTS_COMPLETE) {
+            if ((mpi_wr->chunk_count > 0) &&
+                (chunk_progress(mpi_wr, &mpi_wr->request[PUT_SEND_INDEX]) == FALSE)) {
+                log_debug(debug_level, "got put_src chunk completion (initiator) - %u of %u chunks retired",
+                        mpi_wr->chunk_retired, mpi_wr->chunk_count);
+                return(rc);
+            }
+
             log_debug(debug_level, "got put_src WRITE completion (initiator) - event arrived from %d - tag %4d",
                     event->MPI_SOURCE, event->MPI_TAG);
 
             mpi_wr->op_state = RDMA_WRITE_COMPLETE;
             mpi_wr->active_requests &= ~PUT_SEND_REQUEST_ACTIVE;
+            iovec_release(mpi_wr);
         }
     } else if (mpi_wr->last_op == MPI_OP_PUT_TARGET) {
         if (mpi_wr->op_state == BUFFER_INIT) {
@@ -2594,27 +4717,83 @@ static int process_event(
             mpi_wr->op_state = RDMA_RTS_COMPLETE;
             mpi_wr->active_requests &= ~RDMA_CMD_REQUEST_ACTIVE;
 
-            log_debug(debug_level, "receiving data from PUT initiator - rank(%d) tag(%d) dst_offset(%llu) dst_length(%llu)",
+            log_debug(debug_level, "receiving data from PUT initiator - rank(%d) tag(%d) dst_offset(%llu) dst_length(%llu) chunk_size(%llu)",
                     event->MPI_SOURCE, mpi_wr->cmd_msg.tag,
-                    mpi_wr->cmd_msg.offset, mpi_wr->cmd_msg.length);
-            nthread_lock(&nnti_mpi_lock);
-            MPI_Irecv(
-                    (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
-                    mpi_wr->cmd_msg.length,
-                    MPI_BYTE,
-                    event->MPI_SOURCE,
-                    mpi_mem_hdl->put_data_tag,
-                    MPI_COMM_WORLD,
-                    &mpi_wr->request[PUT_RECV_INDEX]);
-            nthread_unlock(&nnti_mpi_lock);
-            mpi_wr->request_ptr  =&mpi_wr->request[PUT_RECV_INDEX];
-            mpi_wr->request_count=1;
+                    mpi_wr->cmd_msg.offset, mpi_wr->cmd_msg.length, mpi_wr->cmd_msg.chunk_size);
+            if (mpi_wr->cmd_msg.iov_count > 0) {
+                // the data is received once the region list is here
+                iovec_recv(mpi_wr, event->MPI_SOURCE, mpi_mem_hdl->put_data_tag);
+            } else if (mpi_wr->cmd_msg.chunk_size > 0) {
+                mpi_wr->request[PUT_RECV_INDEX]=MPI_REQUEST_NULL;
+                chunk_start(
+                        mpi_wr,
+                        (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
+                        mpi_wr->cmd_msg.length,
+                        mpi_wr->cmd_msg.chunk_size,
+                        event->MPI_SOURCE,
+                        mpi_wr->cmd_msg.tag,
+                        FALSE,
+                        0);
+                mpi_wr->stream_delivered=0;
+            } else {
+                nthread_lock(&nnti_mpi_lock);
+                MPI_Irecv(
+                        (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
+                        mpi_wr->cmd_msg.length,
+                        MPI_BYTE,
+                        event->MPI_SOURCE,
+                        mpi_mem_hdl->put_data_tag,
+                        MPI_COMM_WORLD,
+                        &mpi_wr->request[PUT_RECV_INDEX]);
+                nthread_unlock(&nnti_mpi_lock);
+                mpi_wr->request_ptr  =&mpi_wr->request[PUT_RECV_INDEX];
+                mpi_wr->request_count=1;
+            }
             mpi_wr->active_requests |= PUT_RECV_REQUEST_ACTIVE;
 
             mpi_wr->dst_offset=mpi_wr->cmd_msg.offset;
             mpi_wr->length    =mpi_wr->cmd_msg.length;
 
         } else if (mpi_wr->op_state == RDMA_RTS_COMPLETE) {
+            if (mpi_wr->iov != NULL) {
+                MPI_Datatype iov_type;
+
+                log_debug(debug_level, "got put_dst region list (target) - event arrived from %d - tag %4d",
+                        event->MPI_SOURCE, event->MPI_TAG);
+
+                iovec_type(mpi_wr->iov, mpi_wr->cmd_msg.iov_count, FALSE, &iov_type);
+                free(mpi_wr->iov);
+                mpi_wr->iov=NULL;
+
+                nthread_lock(&nnti_mpi_lock);
+                MPI_Irecv(
+                        (char*)reg_buf->payload,
+                        1,
+                        iov_type,
+                        event->MPI_SOURCE,
+                        mpi_mem_hdl->put_data_tag,
+                        MPI_COMM_WORLD,
+                        &mpi_wr->request[PUT_RECV_INDEX]);
+                MPI_Type_free(&iov_type);
+                nthread_unlock(&nnti_mpi_lock);
+                mpi_wr->request_ptr  =&mpi_wr->request[PUT_RECV_INDEX];
+                mpi_wr->request_count=1;
+                return(rc);
+            }
+            if ((mpi_wr->chunk_count > 0) &&
+                (chunk_progress(mpi_wr, &mpi_wr->request[PUT_RECV_INDEX]) == FALSE) &&
+                (mpi_wr->cmd_msg.stream == FALSE)) {
+                log_debug(debug_level, "got put_dst chunk completion (target) - %u of %u chunks retired",
+                        mpi_wr->chunk_retired, mpi_wr->chunk_count);
+                return(rc);
+            }
+            if (mpi_wr->cmd_msg.stream == TRUE) {
+                log_debug(debug_level, "got put_dst chunk completion (streaming target) - %u of %u chunks retired",
+                        mpi_wr->chunk_retired, mpi_wr->chunk_count);
+                stream_deliver(mpi_wr);
+                return(rc);
+            }
+
             log_debug(debug_level, "got put_dst WRITE completion (target) - event arrived from %d - tag %4d",
                     event->MPI_SOURCE, event->MPI_TAG);
 
@@ -2629,15 +4808,27 @@ static int process_event(
             mpi_wr->op_state = RDMA_RTR_COMPLETE;
             mpi_wr->active_requests &= ~RDMA_CMD_REQUEST_ACTIVE;
 
-            mpi_wr->request_ptr  =&mpi_wr->request[GET_RECV_INDEX];
+            if (mpi_wr->chunk_count > 0) {
+                mpi_wr->request_ptr=&mpi_wr->chunk_request[mpi_wr->chunk_retired % mpi_wr->chunk_window];
+            } else {
+                mpi_wr->request_ptr=&mpi_wr->request[GET_RECV_INDEX];
+            }
             mpi_wr->request_count=1;
 
         } else if (mpi_wr->op_state == RDMA_RTR_COMPLETE) {
+            if ((mpi_wr->chunk_count > 0) &&
+                (chunk_progress(mpi_wr, &mpi_wr->request[GET_RECV_INDEX]) == FALSE)) {
+                log_debug(debug_level, "got get_dst chunk completion (initiator) - %u of %u chunks retired",
+                        mpi_wr->chunk_retired, mpi_wr->chunk_count);
+                return(rc);
+            }
+
             log_debug(debug_level, "got get_dst READ completion (initiator) - event arrived from %d - tag %4d",
                     event->MPI_SOURCE, event->MPI_TAG);
 
             mpi_wr->op_state = RDMA_READ_COMPLETE;
             mpi_wr->active_requests &= ~GET_RECV_REQUEST_ACTIVE;
+            iovec_release(mpi_wr);
         }
     } else if (mpi_wr->last_op == MPI_OP_GET_TARGET) {
         if (mpi_wr->op_state == BUFFER_INIT) {
@@ -2647,26 +4838,74 @@ static int process_event(
             mpi_wr->op_state = RDMA_RTR_COMPLETE;
             mpi_wr->active_requests &= ~RDMA_CMD_REQUEST_ACTIVE;
 
-            log_debug(debug_level, "sending data to GET initiator - rank(%d) tag(%d) src_offset(%llu) src_length(%llu)",
+            log_debug(debug_level, "sending data to GET initiator - rank(%d) tag(%d) src_offset(%llu) src_length(%llu) chunk_size(%llu)",
                     event->MPI_SOURCE, mpi_wr->cmd_msg.tag,
-                    mpi_wr->cmd_msg.offset, mpi_wr->cmd_msg.length);
-            nthread_lock(&nnti_mpi_lock);
-            MPI_Issend(
-                    (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
-                    mpi_wr->cmd_msg.length,
-                    MPI_BYTE,
-                    event->MPI_SOURCE,
-                    mpi_wr->cmd_msg.tag,
-                    MPI_COMM_WORLD,
-                    &mpi_wr->request[GET_SEND_INDEX]);
-            nthread_unlock(&nnti_mpi_lock);
-            mpi_wr->request_ptr  =&mpi_wr->request[GET_SEND_INDEX];
-            mpi_wr->request_count=1;
+                    mpi_wr->cmd_msg.offset, mpi_wr->cmd_msg.length, mpi_wr->cmd_msg.chunk_size);
+            if (mpi_wr->cmd_msg.iov_count > 0) {
+                // the data is sent once the region list is here
+                iovec_recv(mpi_wr, event->MPI_SOURCE, mpi_mem_hdl->put_data_tag);
+            } else if (mpi_wr->cmd_msg.chunk_size > 0) {
+                mpi_wr->request[GET_SEND_INDEX]=MPI_REQUEST_NULL;
+                chunk_start(
+                        mpi_wr,
+                        (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
+                        mpi_wr->cmd_msg.length,
+                        mpi_wr->cmd_msg.chunk_size,
+                        event->MPI_SOURCE,
+                        mpi_wr->cmd_msg.tag,
+                        TRUE,
+                        0);
+            } else {
+                nthread_lock(&nnti_mpi_lock);
+                MPI_Issend(
+                        (char*)reg_buf->payload+mpi_wr->cmd_msg.offset,
+                        mpi_wr->cmd_msg.length,
+                        MPI_BYTE,
+                        event->MPI_SOURCE,
+                        mpi_wr->cmd_msg.tag,
+                        MPI_COMM_WORLD,
+                        &mpi_wr->request[GET_SEND_INDEX]);
+                nthread_unlock(&nnti_mpi_lock);
+                mpi_wr->request_ptr  =&mpi_wr->request[GET_SEND_INDEX];
+                mpi_wr->request_count=1;
+            }
             mpi_wr->active_requests |= GET_SEND_REQUEST_ACTIVE;
 
             mpi_wr->src_offset=mpi_wr->cmd_msg.offset;
             mpi_wr->length    =mpi_wr->cmd_msg.length;
         } else if (mpi_wr->op_state == RDMA_RTR_COMPLETE) {
+            if (mpi_wr->iov != NULL) {
+                MPI_Datatype iov_type;
+
+                log_debug(debug_level, "got get_src region list (target) - event arrived from %d - tag %4d",
+                        event->MPI_SOURCE, event->MPI_TAG);
+
+                iovec_type(mpi_wr->iov, mpi_wr->cmd_msg.iov_count, TRUE, &iov_type);
+                free(mpi_wr->iov);
+                mpi_wr->iov=NULL;
+
+                nthread_lock(&nnti_mpi_lock);
+                MPI_Issend(
+                        (char*)reg_buf->payload,
+                        1,
+                        iov_type,
+                        event->MPI_SOURCE,
+                        mpi_wr->cmd_msg.tag,
+                        MPI_COMM_WORLD,
+                        &mpi_wr->request[GET_SEND_INDEX]);
+                MPI_Type_free(&iov_type);
+                nthread_unlock(&nnti_mpi_lock);
+                mpi_wr->request_ptr  =&mpi_wr->request[GET_SEND_INDEX];
+                mpi_wr->request_count=1;
+                return(rc);
+            }
+            if ((mpi_wr->chunk_count > 0) &&
+                (chunk_progress(mpi_wr, &mpi_wr->request[GET_SEND_INDEX]) == FALSE)) {
+                log_debug(debug_level, "got get_src chunk completion (target) - %u of %u chunks retired",
+                        mpi_wr->chunk_retired, mpi_wr->chunk_count);
+                return(rc);
+            }
+
             log_debug(debug_level, "got get_src READ completion (target) - event arrived from %d - tag %4d",
                     event->MPI_SOURCE, event->MPI_TAG);
 
@@ -2832,6 +5071,8 @@ static NNTI_result_t repost_recv_work_request(
     mpi_mem_hdl->wr_queue.push_back(mpi_wr);
     nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
 
+    return_request_credits(mpi_wr->last_event.MPI_SOURCE, 1);
+
     log_debug(nnti_debug_level, "exit (reg_buf=%p)", reg_buf);
 
     return(NNTI_OK);
@@ -2849,8 +5090,30 @@ static NNTI_result_t repost_rdma_target_work_request(
     mpi_mem_hdl=MPI_MEM_HDL(reg_buf);
     assert(mpi_mem_hdl);
 
+    if ((mpi_wr->cmd_msg.stream == TRUE) && (mpi_wr->stream_delivered < mpi_wr->chunk_count)) {
+        // the stream isn't over.  deliver the next chunk if it's here or keep waiting for it.
+        mpi_wr->op_state=RDMA_RTS_COMPLETE;
+        stream_deliver(mpi_wr);
+
+        nthread_lock(&mpi_mem_hdl->wr_queue_lock);
+        if (find(mpi_mem_hdl->wr_queue.begin(), mpi_mem_hdl->wr_queue.end(), mpi_wr) == mpi_mem_hdl->wr_queue.end()) {
+            mpi_mem_hdl->wr_queue.push_front(mpi_wr);
+        }
+        nthread_unlock(&mpi_mem_hdl->wr_queue_lock);
+
+        log_debug(nnti_debug_level, "exit (reg_buf=%p ; stream_delivered=%u)", reg_buf, mpi_wr->stream_delivered);
+
+        return(NNTI_OK);
+    }
+
     mpi_wr->op_state=BUFFER_INIT;
 
+    if (mpi_wr->chunk_request != NULL) {
+        free(mpi_wr->chunk_request);
+        mpi_wr->chunk_request=NULL;
+    }
+    mpi_wr->chunk_count=0;
+
     mpi_wr->request_count=0;
     if ((reg_buf->ops & NNTI_BOP_REMOTE_READ) ||
         (reg_buf->ops & NNTI_BOP_REMOTE_WRITE)) {
@@ -2881,6 +5144,330 @@ static NNTI_result_t repost_rdma_target_work_request(
 }
 
 
+/*
+ * Pick the tag for the chunks of a put or a get.  Chunks go out a window at
+ * a time, so on a buffer's data tag they could match the receives of other
+ * transfers to that buffer.  The sender of a put and the receiver of a get
+ * pick the tag, from separate ranges, so in each direction between two
+ * ranks a range is drawn from one counter.  A tag is reused after
+ * chunk_tag_span transfers.
+ */
+static int chunk_tag(
+        const int8_t is_put)
+{
+    int64_t span=transport_global_data.chunk_tag_span;
+    int64_t n;
+
+    if (is_put) {
+        n=nthread_counter_increment(&transport_global_data.put_chunk_tags);
+        return((int)(3*span + (n % span)));
+    }
+    n=nthread_counter_increment(&transport_global_data.get_chunk_tags);
+    return((int)(2*span + (n % span)));
+}
+
+/*
+ * Start a chunked transfer of <length> bytes at <base>.  The first <window>
+ * chunks are posted immediately.  The rest are posted by chunk_progress() as
+ * earlier chunks complete.  A window of 0 posts every chunk at once.
+ *
+ * MPI matches messages with the same source and tag in the order they were
+ * posted, so the two sides only have to agree on the chunk size and the tag
+ * (see chunk_tag()).  The target isn't guaranteed to make progress while the
+ * initiator waits, so the target posts every chunk and the initiator's window
+ * paces the transfer.
+ */
+static int chunk_start(
+        mpi_work_request *mpi_wr,
+        char             *base,
+        uint64_t          length,
+        uint64_t          chunk_size,
+        int               rank,
+        int               tag,
+        int8_t            is_send,
+        uint32_t          window)
+{
+    log_debug(nnti_debug_level, "enter (mpi_wr=%p ; length=%llu ; chunk_size=%llu)", mpi_wr, length, chunk_size);
+
+    mpi_wr->chunk_base   =base;
+    mpi_wr->chunk_length =length;
+    mpi_wr->chunk_size   =chunk_size;
+    mpi_wr->chunk_rank   =rank;
+    mpi_wr->chunk_tag    =tag;
+    mpi_wr->chunk_is_send=is_send;
+    mpi_wr->chunk_count  =(length + chunk_size - 1) / chunk_size;
+    mpi_wr->chunk_window =window;
+    if ((mpi_wr->chunk_window == 0) || (mpi_wr->chunk_window > mpi_wr->chunk_count)) {
+        mpi_wr->chunk_window=mpi_wr->chunk_count;
+    }
+    mpi_wr->chunk_posted =0;
+    mpi_wr->chunk_retired=0;
+
+    mpi_wr->chunk_request=(MPI_Request *)malloc(mpi_wr->chunk_window * sizeof(MPI_Request));
+    assert(mpi_wr->chunk_request);
+    for (uint32_t i=0;i<mpi_wr->chunk_window;i++) {
+        mpi_wr->chunk_request[i]=MPI_REQUEST_NULL;
+    }
+
+    mpi_wr->request_ptr  =&mpi_wr->chunk_request[0];
+    mpi_wr->request_count=1;
+
+    return(chunk_post(mpi_wr));
+}
+
+/*
+ * Post chunks until the window is full or every chunk has been posted.
+ */
+static int chunk_post(
+        mpi_work_request *mpi_wr)
+{
+    int rc=MPI_SUCCESS;
+
+    nthread_lock(&nnti_mpi_lock);
+    while ((mpi_wr->chunk_posted < mpi_wr->chunk_count) &&
+           (mpi_wr->chunk_posted - mpi_wr->chunk_retired < mpi_wr->chunk_window)) {
+        uint64_t     offset=(uint64_t)mpi_wr->chunk_posted * mpi_wr->chunk_size;
+        uint64_t     length=mpi_wr->chunk_length - offset;
+        MPI_Request *slot  =&mpi_wr->chunk_request[mpi_wr->chunk_posted % mpi_wr->chunk_window];
+
+        if (length > mpi_wr->chunk_size) {
+            length=mpi_wr->chunk_size;
+        }
+
+        log_debug(nnti_debug_level, "posting chunk %u of %u (offset=%llu ; length=%llu ; rank=%d ; tag=%d)",
+                mpi_wr->chunk_posted, mpi_wr->chunk_count, offset, length, mpi_wr->chunk_rank, mpi_wr->chunk_tag);
+        if (mpi_wr->chunk_is_send == TRUE) {
+            rc=MPI_Issend(mpi_wr->chunk_base+offset, length, MPI_BYTE, mpi_wr->chunk_rank, mpi_wr->chunk_tag, MPI_COMM_WORLD, slot);
+        } else {
+            rc=MPI_Irecv(mpi_wr->chunk_base+offset, length, MPI_BYTE, mpi_wr->chunk_rank, mpi_wr->chunk_tag, MPI_COMM_WORLD, slot);
+        }
+        if (rc != MPI_SUCCESS) {
+            log_error(nnti_debug_level, "failed to post chunk %u of %u: rc=%d", mpi_wr->chunk_posted, mpi_wr->chunk_count, rc);
+            break;
+        }
+        mpi_wr->chunk_posted++;
+    }
+    nthread_unlock(&nnti_mpi_lock);
+
+    return(rc);
+}
+
+/*
+ * The oldest unfinished chunk has completed.  Retire it and any younger
+ * chunks that are also done, refill the window and expose the next
+ * unfinished chunk.  When every chunk is done, request_ptr is pointed at
+ * <done_slot> (an inactive request) and TRUE is returned.
+ */
+static int8_t chunk_progress(
+        mpi_work_request *mpi_wr,
+        MPI_Request      *done_slot)
+{
+    int flag=FALSE;
+
+    /* the wait functions may have tested a copy of this request */
+    mpi_wr->chunk_request[mpi_wr->chunk_retired % mpi_wr->chunk_window]=MPI_REQUEST_NULL;
+    mpi_wr->chunk_retired++;
+
+    nthread_lock(&nnti_mpi_lock);
+    while (mpi_wr->chunk_retired < mpi_wr->chunk_posted) {
+        MPI_Test(&mpi_wr->chunk_request[mpi_wr->chunk_retired % mpi_wr->chunk_window], &flag, MPI_STATUS_IGNORE);
+        if (flag == FALSE) {
+            break;
+        }
+        mpi_wr->chunk_retired++;
+    }
+    nthread_unlock(&nnti_mpi_lock);
+
+    chunk_post(mpi_wr);
+
+    if (mpi_wr->chunk_retired == mpi_wr->chunk_count) {
+        free(mpi_wr->chunk_request);
+        mpi_wr->chunk_request=NULL;
+
+        *done_slot=MPI_REQUEST_NULL;
+        mpi_wr->request_ptr  =done_slot;
+        mpi_wr->request_count=1;
+
+        return(TRUE);
+    }
+
+    mpi_wr->request_ptr  =&mpi_wr->chunk_request[mpi_wr->chunk_retired % mpi_wr->chunk_window];
+    mpi_wr->request_count=1;
+
+    return(FALSE);
+}
+
+/*
+ * Complete a streaming put target with the oldest chunk that has arrived
+ * but hasn't been delivered.  Chunks are retired in order, so chunk
+ * <stream_delivered> is next.
+ */
+static void stream_deliver(
+        mpi_work_request *mpi_wr)
+{
+    if (mpi_wr->stream_delivered == mpi_wr->chunk_retired) {
+        return;
+    }
+
+    uint64_t offset=(uint64_t)mpi_wr->stream_delivered * mpi_wr->chunk_size;
+    uint64_t length=mpi_wr->chunk_length - offset;
+    if (length > mpi_wr->chunk_size) {
+        length=mpi_wr->chunk_size;
+    }
+    mpi_wr->dst_offset=mpi_wr->cmd_msg.offset + offset;
+    mpi_wr->length    =length;
+    mpi_wr->stream_delivered++;
+
+    log_debug(nnti_debug_level, "delivering chunk %u of %u (dst_offset=%llu ; length=%llu)",
+            mpi_wr->stream_delivered, mpi_wr->chunk_count, mpi_wr->dst_offset, mpi_wr->length);
+
+    mpi_wr->op_state = RDMA_WRITE_COMPLETE;
+    if (mpi_wr->stream_delivered == mpi_wr->chunk_count) {
+        mpi_wr->active_requests &= ~PUT_RECV_REQUEST_ACTIVE;
+    }
+}
+
+/*
+ * An MPI block length is an int, so neither the list nor a region may
+ * be longer than INT_MAX.
+ */
+static NNTI_result_t check_iovec(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count)
+{
+    if (iov_count > INT_MAX) {
+        log_debug(nnti_debug_level, "iov_count(%u) is out of range", iov_count);
+        return(NNTI_EINVAL);
+    }
+
+    return(nnti_iovec_check(src_buffer_hdl, dest_buffer_hdl, iov, iov_count, INT_MAX));
+}
+
+/*
+ * Describe one side of <iov> as bytes at offsets from the buffer's
+ * payload.  The datatype may be freed as soon as the send or receive that
+ * uses it has been started.
+ */
+static int iovec_type(
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int8_t        src_side,
+        MPI_Datatype       *type)
+{
+    int rc=MPI_SUCCESS;
+
+    int      *lengths      =(int *)malloc(iov_count*sizeof(int));
+    MPI_Aint *displacements=(MPI_Aint *)malloc(iov_count*sizeof(MPI_Aint));
+    assert(lengths);
+    assert(displacements);
+
+    for (uint32_t i=0;i<iov_count;i++) {
+        lengths[i]      =(int)iov[i].length;
+        displacements[i]=(MPI_Aint)((src_side == TRUE) ? iov[i].src_offset : iov[i].dest_offset);
+    }
+
+    nthread_lock(&nnti_mpi_lock);
+    rc=MPI_Type_create_hindexed((int)iov_count, lengths, displacements, MPI_BYTE, type);
+    if (rc == MPI_SUCCESS) {
+        rc=MPI_Type_commit(type);
+    }
+    nthread_unlock(&nnti_mpi_lock);
+
+    free(lengths);
+    free(displacements);
+
+    return(rc);
+}
+
+/*
+ * Send a copy of <iov> to the target of a vectored put/get.  The copy
+ * stays with the work request until iovec_release().
+ */
+static int iovec_send(
+        mpi_work_request   *mpi_wr,
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int           rank,
+        const int           tag)
+{
+    int rc=MPI_SUCCESS;
+
+    mpi_wr->iov=(NNTI_iovec_t *)malloc(iov_count*sizeof(NNTI_iovec_t));
+    assert(mpi_wr->iov);
+    memcpy(mpi_wr->iov, iov, iov_count*sizeof(NNTI_iovec_t));
+
+    log_debug(nnti_debug_level, "sending %u regions to rank(%d) tag(%d)", iov_count, rank, tag);
+
+    nthread_lock(&nnti_mpi_lock);
+    rc=MPI_Isend(
+            mpi_wr->iov,
+            iov_count*sizeof(NNTI_iovec_t),
+            MPI_BYTE,
+            rank,
+            tag,
+            MPI_COMM_WORLD,
+            &mpi_wr->iov_request);
+    nthread_unlock(&nnti_mpi_lock);
+
+    return(rc);
+}
+
+/*
+ * Post the receive of the region list of a vectored put/get at the
+ * target.  The list lands in mpi_wr->iov and process_event() moves the
+ * data once it is here, so progress never waits on the initiator.
+ */
+static int iovec_recv(
+        mpi_work_request *mpi_wr,
+        const int         rank,
+        const int         tag)
+{
+    int rc=MPI_SUCCESS;
+
+    mpi_wr->iov=(NNTI_iovec_t *)malloc(mpi_wr->cmd_msg.iov_count*sizeof(NNTI_iovec_t));
+    assert(mpi_wr->iov);
+
+    log_debug(nnti_debug_level, "receiving %u regions from rank(%d) tag(%d)", mpi_wr->cmd_msg.iov_count, rank, tag);
+
+    nthread_lock(&nnti_mpi_lock);
+    rc=MPI_Irecv(
+            mpi_wr->iov,
+            mpi_wr->cmd_msg.iov_count*sizeof(NNTI_iovec_t),
+            MPI_BYTE,
+            rank,
+            tag,
+            MPI_COMM_WORLD,
+            &mpi_wr->iov_request);
+    nthread_unlock(&nnti_mpi_lock);
+
+    mpi_wr->request_ptr  =&mpi_wr->iov_request;
+    mpi_wr->request_count=1;
+
+    return(rc);
+}
+
+/*
+ * The data of a vectored put/get has moved, so the target has the region
+ * list and the initiator's send of it is done.
+ */
+static void iovec_release(
+        mpi_work_request *mpi_wr)
+{
+    if (mpi_wr->iov == NULL) {
+        return;
+    }
+
+    nthread_lock(&nnti_mpi_lock);
+    MPI_Wait(&mpi_wr->iov_request, MPI_STATUS_IGNORE);
+    nthread_unlock(&nnti_mpi_lock);
+
+    free(mpi_wr->iov);
+    mpi_wr->iov=NULL;
+}
+
+
 static int is_wr_complete(
         mpi_work_request *mpi_wr)
 {
@@ -3066,7 +5653,11 @@ static void create_status(
 
     status->op    =wr->ops;
     status->result=(NNTI_result_t)nnti_rc;
-    if (nnti_rc==NNTI_OK) {
+    status->imm   =0;
+    if ((nnti_rc == NNTI_OK) && (wr->ops == NNTI_BOP_ATOMICS)) {
+        // the target may have refused the operation
+        status->result=wr->result;
+    } else if (nnti_rc==NNTI_OK) {
         if (mpi_wr->reg_buf) {
         	status->start =mpi_wr->reg_buf->payload;
             status->length=mpi_wr->length;
@@ -3087,6 +5678,9 @@ static void create_status(
                 status->offset=mpi_wr->dst_offset;
                 create_peer(&status->src, mpi_wr->last_event.MPI_SOURCE); // allocates url
                 create_peer(&status->dest, transport_global_data.rank); // allocates url
+                if (mpi_wr->last_op == MPI_OP_PUT_TARGET) {
+                    status->imm=mpi_wr->cmd_msg.imm;
+                }
                 break;
         }
     }
@@ -3109,6 +5703,10 @@ static void create_peer(NNTI_peer_t *peer, int rank)
 static void config_init(nnti_mpi_config *c)
 {
     c->min_atomics_vars    = 512;
+    c->request_credits     = 0;
+    c->rdma_chunk_threshold= 64*1024*1024;
+    c->rdma_chunk_size     = 8*1024*1024;
+    c->rdma_chunk_window   = 4;
 }
 
 static void config_get_from_env(nnti_mpi_config *c)
@@ -3117,6 +5715,10 @@ static void config_get_from_env(nnti_mpi_config *c)
 
     // defaults
     c->min_atomics_vars    = 512;
+    c->request_credits     = 0;
+    c->rdma_chunk_threshold= 64*1024*1024;
+    c->rdma_chunk_size     = 8*1024*1024;
+    c->rdma_chunk_window   = 4;
 
     if ((env_str=getenv("TRIOS_NNTI_MIN_ATOMIC_VARS")) != NULL) {
         errno=0;
@@ -3130,4 +5732,52 @@ static void config_get_from_env(nnti_mpi_config *c)
     } else {
         log_debug(nnti_debug_level, "TRIOS_NNTI_MIN_ATOMIC_VARS is undefined.  using c->min_atomics_vars default");
     }
+    if ((env_str=getenv("TRIOS_NNTI_REQUEST_CREDITS")) != NULL) {
+        errno=0;
+        uint32_t credits=strtoul(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->request_credits to %u", credits);
+            c->request_credits=credits;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_REQUEST_CREDITS value conversion failed (%s).  using c->request_credits default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_REQUEST_CREDITS is undefined.  using c->request_credits default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD")) != NULL) {
+        errno=0;
+        uint64_t threshold=strtoull(env_str, NULL, 0);
+        if (errno == 0) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_threshold to %llu", threshold);
+            c->rdma_chunk_threshold=threshold;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_THRESHOLD value conversion failed (%s).  using c->rdma_chunk_threshold default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_THRESHOLD is undefined.  using c->rdma_chunk_threshold default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_SIZE")) != NULL) {
+        errno=0;
+        uint64_t chunk_size=strtoull(env_str, NULL, 0);
+        if ((errno == 0) && (chunk_size > 0) && (chunk_size <= 0x7fffffffULL)) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_size to %llu", chunk_size);
+            c->rdma_chunk_size=chunk_size;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_SIZE value conversion failed (%s).  using c->rdma_chunk_size default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_SIZE is undefined.  using c->rdma_chunk_size default");
+    }
+    if ((env_str=getenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW")) != NULL) {
+        errno=0;
+        uint32_t window=strtoul(env_str, NULL, 0);
+        if ((errno == 0) && (window > 0)) {
+            log_debug(nnti_debug_level, "setting c->rdma_chunk_window to %lu", window);
+            c->rdma_chunk_window=window;
+        } else {
+            log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_WINDOW value conversion failed (%s).  using c->rdma_chunk_window default.", strerror(errno));
+        }
+    } else {
+        log_debug(nnti_debug_level, "TRIOS_NNTI_RDMA_CHUNK_WINDOW is undefined.  using c->rdma_chunk_window default");
+    }
 }
@@ -133,6 +133,24 @@ NNTI_result_t NNTI_mpi_put (
         const uint64_t       dest_offset,
         NNTI_work_request_t  *wr);
 
+NNTI_result_t NNTI_mpi_put_stream (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       chunk_size,
+        NNTI_work_request_t  *wr);
+
+NNTI_result_t NNTI_mpi_put_notify (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset,
+        const uint64_t       imm,
+        NNTI_work_request_t *wr);
+
 NNTI_result_t NNTI_mpi_get (
         const NNTI_buffer_t *src_buffer_hdl,
         const uint64_t       src_offset,
@@ -141,6 +159,20 @@ NNTI_result_t NNTI_mpi_get (
         const uint64_t       dest_offset,
         NNTI_work_request_t  *wr);
 
+NNTI_result_t NNTI_mpi_putv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t  *wr);
+
+NNTI_result_t NNTI_mpi_getv (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        NNTI_work_request_t  *wr);
+
 NNTI_result_t NNTI_mpi_scatter (
         const NNTI_buffer_t  *src_buffer_hdl,
         const uint64_t        src_length,
@@ -161,6 +193,13 @@ NNTI_result_t NNTI_mpi_atomic_set_callback (
 		NNTI_callback_fn_t      cbfunc,
 		void                   *context);
 
+NNTI_result_t NNTI_mpi_atomic_set_threshold_callback (
+		const NNTI_transport_t *trans_hdl,
+		const uint64_t          local_atomic,
+		const int64_t           threshold,
+		NNTI_callback_fn_t      cbfunc,
+		void                   *context);
+
 NNTI_result_t NNTI_mpi_atomic_read (
 		const NNTI_transport_t *trans_hdl,
 		const uint64_t          local_atomic,
@@ -184,6 +223,13 @@ NNTI_result_t NNTI_mpi_atomic_cswap (
 		const int64_t           swap_operand,
 		NNTI_work_request_t    *wr);
 
+NNTI_result_t NNTI_mpi_atomic_fopv (
+		const NNTI_transport_t     *trans_hdl,
+		const NNTI_peer_t          *peer_hdl,
+		const NNTI_atomic_update_t *updates,
+		const uint32_t              update_count,
+		NNTI_work_request_t        *wr);
+
 NNTI_result_t NNTI_mpi_create_work_request (
         NNTI_buffer_t        *reg_buf,
         NNTI_work_request_t  *wr);
@@ -222,6 +268,69 @@ NNTI_result_t NNTI_mpi_waitall (
         const int             timeout,
         NNTI_status_t       **status);
 
+NNTI_result_t NNTI_mpi_dequeue_requests (
+        NNTI_buffer_t       *reg_buf,
+        const uint32_t       max_count,
+        const int            timeout,
+        NNTI_work_request_t *wr_list,
+        NNTI_status_t       *status_list,
+        uint32_t            *count);
+
+NNTI_result_t NNTI_mpi_release_requests (
+        NNTI_work_request_t *wr_list,
+        const uint32_t       wr_count);
+
+NNTI_result_t NNTI_mpi_counter_bind (
+        const NNTI_buffer_t *reg_buf,
+        NNTI_counter_t      *counter);
+
+NNTI_result_t NNTI_mpi_counter_wait (
+        const NNTI_counter_t *counter,
+        const uint64_t        threshold,
+        const int             timeout,
+        uint64_t             *value);
+
+NNTI_result_t NNTI_mpi_send_implicit (
+        const NNTI_peer_t   *peer_hdl,
+        const NNTI_buffer_t *msg_hdl,
+        const NNTI_buffer_t *dest_hdl);
+
+NNTI_result_t NNTI_mpi_put_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+NNTI_result_t NNTI_mpi_get_implicit (
+        const NNTI_buffer_t *src_buffer_hdl,
+        const uint64_t       src_offset,
+        const uint64_t       src_length,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const uint64_t       dest_offset);
+
+NNTI_result_t NNTI_mpi_atomic_fop_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           operand,
+        const NNTI_atomic_op_t  op,
+        NNTI_work_request_t    *wr);
+
+NNTI_result_t NNTI_mpi_atomic_cswap_buffer (
+        const NNTI_buffer_t    *target_buf,
+        const uint64_t          target_offset,
+        const NNTI_buffer_t    *result_buf,
+        const uint64_t          result_offset,
+        const int64_t           compare_operand,
+        const int64_t           swap_operand,
+        NNTI_work_request_t    *wr);
+
+NNTI_result_t NNTI_mpi_flush (
+        const NNTI_peer_t *peer_hdl,
+        const int          timeout);
+
 NNTI_result_t NNTI_mpi_fini (
         const NNTI_transport_t *trans_hdl);
 
@@ -1508,6 +1508,7 @@ NNTI_bgqpami_wait (const NNTI_buffer_t * reg_buf,
   conn = get_conn_rank (wr->peer_rank);
   status->op = remote_op;
   status->result = nnti_rc;
+  status->imm = 0;
   if (nnti_rc == NNTI_OK)
     {
       status->start = (uint64_t) reg_buf->payload;
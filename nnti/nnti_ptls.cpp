@@ -3156,6 +3156,7 @@ static void create_status(
 
     status->op     = wr->ops;
     status->result = (NNTI_result_t)nnti_rc;
+    status->imm    = 0;
     if (nnti_rc==NNTI_OK) {
         ptl_wr=(portals_work_request *)wr->transport_private;
         assert(ptl_wr);
@@ -217,3 +217,131 @@ int nnti_sleep(const uint64_t msec)
 
     return(rc);
 }
+
+/*
+ * Returns 1 if <op> fetches the previous value, 0 if it doesn't and -1 if
+ * <op> isn't an atomic operation.
+ */
+int nnti_atomic_fetches(const NNTI_atomic_op_t op)
+{
+    switch (op) {
+        case NNTI_ATOMIC_FADD:
+        case NNTI_ATOMIC_FSWAP:
+        case NNTI_ATOMIC_FAND:
+        case NNTI_ATOMIC_FOR:
+        case NNTI_ATOMIC_FXOR:
+        case NNTI_ATOMIC_FMIN:
+        case NNTI_ATOMIC_FMAX:
+            return(1);
+        case NNTI_ATOMIC_ADD:
+        case NNTI_ATOMIC_AND:
+        case NNTI_ATOMIC_OR:
+        case NNTI_ATOMIC_XOR:
+        case NNTI_ATOMIC_MIN:
+        case NNTI_ATOMIC_MAX:
+            return(0);
+    }
+
+    return(-1);
+}
+
+/*
+ * Returns the new value of a variable that held <value> after <op> is
+ * applied with <operand>.
+ */
+int64_t nnti_atomic_apply(const NNTI_atomic_op_t op, const int64_t value, const int64_t operand)
+{
+    switch (op) {
+        case NNTI_ATOMIC_FADD:
+        case NNTI_ATOMIC_ADD:
+            /* wrap like the hardware does */
+            return((int64_t)((uint64_t)value + (uint64_t)operand));
+        case NNTI_ATOMIC_FSWAP:
+            return(operand);
+        case NNTI_ATOMIC_FAND:
+        case NNTI_ATOMIC_AND:
+            return(value & operand);
+        case NNTI_ATOMIC_FOR:
+        case NNTI_ATOMIC_OR:
+            return(value | operand);
+        case NNTI_ATOMIC_FXOR:
+        case NNTI_ATOMIC_XOR:
+            return(value ^ operand);
+        case NNTI_ATOMIC_FMIN:
+        case NNTI_ATOMIC_MIN:
+            return((operand < value) ? operand : value);
+        case NNTI_ATOMIC_FMAX:
+        case NNTI_ATOMIC_MAX:
+            return((operand > value) ? operand : value);
+    }
+
+    return(value);
+}
+
+/*
+ * Reject an empty list, regions that fall outside either buffer and
+ * regions longer than <max_length> bytes.
+ */
+NNTI_result_t nnti_iovec_check(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        const uint64_t       max_length)
+{
+    uint64_t total=0;
+    uint32_t i;
+
+    if ((iov == NULL) || (iov_count == 0)) {
+        log_debug(nnti_debug_level, "empty iovec");
+        return(NNTI_EINVAL);
+    }
+    for (i=0;i<iov_count;i++) {
+        if ((iov[i].length > max_length) ||
+            (iov[i].src_offset  + iov[i].length > src_buffer_hdl->payload_size) ||
+            (iov[i].dest_offset + iov[i].length > dest_buffer_hdl->payload_size)) {
+            log_debug(nnti_debug_level, "iov[%u] (src_offset=%llu ; dest_offset=%llu ; length=%llu) is out of bounds",
+                    i, iov[i].src_offset, iov[i].dest_offset, iov[i].length);
+            return(NNTI_EINVAL);
+        }
+        total += iov[i].length;
+    }
+    if (total == 0) {
+        log_debug(nnti_debug_level, "iovec moves no data");
+        return(NNTI_EINVAL);
+    }
+
+    return(NNTI_OK);
+}
+
+/*
+ * The lowest offset and the extent of the regions in <iov> on the source
+ * side (<src_side> is TRUE) or the destination side.  Empty regions don't count.
+ */
+void nnti_iovec_extent(
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int8_t        src_side,
+        uint64_t           *offset,
+        uint64_t           *length)
+{
+    uint64_t lo=(uint64_t)-1;
+    uint64_t hi=0;
+    uint32_t i;
+
+    for (i=0;i<iov_count;i++) {
+        uint64_t start=(src_side == TRUE) ? iov[i].src_offset : iov[i].dest_offset;
+        if (iov[i].length == 0) {
+            continue;
+        }
+        if (start < lo) {
+            lo=start;
+        }
+        if (start + iov[i].length > hi) {
+            hi=start + iov[i].length;
+        }
+    }
+
+    *offset=lo;
+    *length=hi - lo;
+}
@@ -64,6 +64,22 @@ NNTI_result_t nnti_url_get_params(const char *url, char *outstr, const int maxle
 
 int nnti_sleep(const uint64_t msec);
 
+int     nnti_atomic_fetches(const NNTI_atomic_op_t op);
+int64_t nnti_atomic_apply(const NNTI_atomic_op_t op, const int64_t value, const int64_t operand);
+
+NNTI_result_t nnti_iovec_check(
+        const NNTI_buffer_t *src_buffer_hdl,
+        const NNTI_buffer_t *dest_buffer_hdl,
+        const NNTI_iovec_t  *iov,
+        const uint32_t       iov_count,
+        const uint64_t       max_length);
+void nnti_iovec_extent(
+        const NNTI_iovec_t *iov,
+        const uint32_t      iov_count,
+        const int8_t        src_side,
+        uint64_t           *offset,
+        uint64_t           *length);
+
 #ifdef __cplusplus
 }
 #endif
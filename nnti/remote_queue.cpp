@@ -0,0 +1,375 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*-------------------------------------------------------------------------*/
+/**  @file remote_queue.cpp
+ *
+ *   @brief A many-producer, single-consumer queue that producers fill with
+ *          NNTI_atomic_fop_buffer() and NNTI_put().
+ *
+ */
+
+#include "Trios_config.h"
+
+#include "Trios_logger.h"
+#include "remote_queue.h"
+
+#include "assert.h"
+#include "string.h"
+#include "stddef.h"
+
+log_level rq_debug_level = LOG_UNDEFINED;
+
+
+#define RQ_HEADER_SIZE  (sizeof(trios_remote_queue_header_t))
+#define RQ_TRAILER_SIZE (sizeof(trios_remote_queue_trailer_t))
+
+#define RQ_TAIL_OFFSET  (offsetof(trios_remote_queue_header_t, tail))
+#define RQ_HEAD_OFFSET  (offsetof(trios_remote_queue_header_t, head))
+
+/* the control buffer holds the fetched ticket and the last head read */
+#define RQ_CONTROL_TICKET 0
+#define RQ_CONTROL_HEAD   8
+#define RQ_CONTROL_SIZE   RQ_HEADER_SIZE
+
+
+static uint32_t aligned_length(uint32_t length)
+{
+    return((length+7) & ~7);
+}
+
+static uint64_t entry_offset(const trios_remote_queue_t *rq, uint64_t ticket)
+{
+    return(RQ_HEADER_SIZE + (ticket % rq->entry_count) * rq->entry_stride);
+}
+
+static trios_remote_queue_header_t *ring_header(const trios_remote_queue_t *rq)
+{
+    return((trios_remote_queue_header_t *)NNTI_BUFFER_C_POINTER(&rq->ring));
+}
+
+static volatile trios_remote_queue_trailer_t *ring_trailer(const trios_remote_queue_t *rq, uint64_t ticket)
+{
+    char *entry=NNTI_BUFFER_C_POINTER(&rq->ring) + entry_offset(rq, ticket);
+    return((volatile trios_remote_queue_trailer_t *)(entry + rq->entry_stride - RQ_TRAILER_SIZE));
+}
+
+static NNTI_result_t wait_for(NNTI_work_request_t *wr)
+{
+    NNTI_result_t nnti_rc;
+    NNTI_status_t status;
+
+    nnti_rc=NNTI_wait(wr, -1, &status);
+    if ((nnti_rc == NNTI_OK) && (status.result != NNTI_OK)) {
+        nnti_rc=status.result;
+    }
+    return(nnti_rc);
+}
+
+
+/**
+ * @brief Create the ring on the consumer.
+ *
+ * Messages up to <tt>entry_size</tt> bytes fit in an entry.  Producers
+ * attach with the handle in <tt>rq->ring</tt>, which the consumer ships
+ * to them (NNTI_dt_pack()) however it likes.
+ */
+int trios_remote_queue_create(
+        trios_remote_queue_t *rq,
+        NNTI_transport_t     *trans_hdl,
+        uint32_t              entry_count,
+        uint32_t              entry_size)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    trios_remote_queue_header_t *hdr;
+
+    log_debug(rq_debug_level, "enter");
+
+    if ((entry_count == 0) || (entry_size == 0)) {
+        return((int)NNTI_EINVAL);
+    }
+
+    memset(rq, 0, sizeof(trios_remote_queue_t));
+    rq->trans_hdl   =trans_hdl;
+    rq->is_consumer =1;
+    rq->entry_count =entry_count;
+    rq->entry_size  =entry_size;
+    rq->entry_stride=aligned_length(entry_size) + RQ_TRAILER_SIZE;
+
+    nnti_rc=NNTI_alloc(
+            trans_hdl,
+            RQ_HEADER_SIZE + (uint64_t)entry_count * rq->entry_stride,
+            1,
+            (NNTI_buf_ops_t)(NNTI_BOP_LOCAL_READ|NNTI_BOP_LOCAL_WRITE|NNTI_BOP_REMOTE_READ|NNTI_BOP_REMOTE_WRITE|NNTI_BOP_ATOMICS),
+            &rq->ring);
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed registering the ring: %d", nnti_rc);
+        return((int)nnti_rc);
+    }
+    memset(NNTI_BUFFER_C_POINTER(&rq->ring), 0, NNTI_BUFFER_SIZE(&rq->ring));
+
+    hdr=ring_header(rq);
+    hdr->entry_count=entry_count;
+    hdr->entry_size =entry_size;
+
+    rq->ring_hdl=&rq->ring;
+
+    nthread_lock_init(&rq->mutex);
+
+    log_debug(rq_debug_level, "exit");
+
+    return((int)nnti_rc);
+}
+
+/**
+ * @brief Attach a producer to the ring behind <tt>ring_hdl</tt>.
+ *
+ * Reads the ring's geometry from its header.
+ */
+int trios_remote_queue_attach(
+        trios_remote_queue_t *rq,
+        NNTI_transport_t     *trans_hdl,
+        const NNTI_buffer_t  *ring_hdl)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    NNTI_work_request_t wr;
+    trios_remote_queue_header_t *hdr;
+
+    log_debug(rq_debug_level, "enter");
+
+    memset(rq, 0, sizeof(trios_remote_queue_t));
+    rq->trans_hdl=trans_hdl;
+    rq->ring_hdl =ring_hdl;
+
+    nnti_rc=NNTI_alloc(trans_hdl, RQ_CONTROL_SIZE, 1, NNTI_GET_DST, &rq->control);
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed registering the control buffer: %d", nnti_rc);
+        return((int)nnti_rc);
+    }
+
+    nnti_rc=NNTI_get(ring_hdl, 0, RQ_HEADER_SIZE, &rq->control, 0, &wr);
+    if (nnti_rc == NNTI_OK) {
+        nnti_rc=wait_for(&wr);
+    }
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed reading the ring header: %d", nnti_rc);
+        NNTI_free(&rq->control);
+        return((int)nnti_rc);
+    }
+
+    hdr=(trios_remote_queue_header_t *)NNTI_BUFFER_C_POINTER(&rq->control);
+    rq->entry_count =hdr->entry_count;
+    rq->entry_size  =hdr->entry_size;
+    rq->entry_stride=aligned_length(rq->entry_size) + RQ_TRAILER_SIZE;
+    rq->head        =hdr->head;
+
+    nnti_rc=NNTI_alloc(trans_hdl, rq->entry_stride, 1, NNTI_PUT_SRC, &rq->staging);
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed registering the staging buffer: %d", nnti_rc);
+        NNTI_free(&rq->control);
+        return((int)nnti_rc);
+    }
+
+    nthread_lock_init(&rq->mutex);
+
+    log_debug(rq_debug_level, "ring has %u entries of %u bytes", rq->entry_count, rq->entry_size);
+
+    return((int)nnti_rc);
+}
+
+/**
+ * @brief Put a message in the ring.
+ *
+ * Returns NNTI_EMSGSIZE if the message is larger than an entry.  Once a
+ * ticket is taken its entry must be filled or the consumer stalls on it,
+ * so a full ring makes this block (polling the consumer's head) rather
+ * than fail.
+ */
+int trios_remote_queue_enqueue(
+        trios_remote_queue_t *rq,
+        const void           *msg,
+        uint32_t              length)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    NNTI_work_request_t wr;
+    uint64_t ticket;
+    uint32_t put_length;
+    char    *staging;
+    trios_remote_queue_trailer_t *trailer;
+
+    if (rq->is_consumer) {
+        return((int)NNTI_EINVAL);
+    }
+    if (length > rq->entry_size) {
+        return((int)NNTI_EMSGSIZE);
+    }
+
+    if (nthread_lock(&rq->mutex)) log_warn(rq_debug_level, "failed to get thread lock");
+
+    nnti_rc=NNTI_atomic_fop_buffer(rq->ring_hdl, RQ_TAIL_OFFSET, &rq->control, RQ_CONTROL_TICKET, 1, NNTI_ATOMIC_FADD, &wr);
+    if (nnti_rc == NNTI_OK) {
+        nnti_rc=wait_for(&wr);
+    }
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed taking a ticket: %d", nnti_rc);
+        goto out;
+    }
+    ticket=*(uint64_t *)(NNTI_BUFFER_C_POINTER(&rq->control) + RQ_CONTROL_TICKET);
+
+    while (ticket - rq->head >= rq->entry_count) {
+        rq->full_waits++;
+        nnti_rc=NNTI_get(rq->ring_hdl, RQ_HEAD_OFFSET, sizeof(uint64_t), &rq->control, RQ_CONTROL_HEAD, &wr);
+        if (nnti_rc == NNTI_OK) {
+            nnti_rc=wait_for(&wr);
+        }
+        if (nnti_rc != NNTI_OK) {
+            log_error(rq_debug_level, "failed reading the ring head: %d", nnti_rc);
+            goto out;
+        }
+        rq->head=*(uint64_t *)(NNTI_BUFFER_C_POINTER(&rq->control) + RQ_CONTROL_HEAD);
+    }
+
+    /* right-align the message against the trailer so one put carries both */
+    put_length=aligned_length(length) + RQ_TRAILER_SIZE;
+    staging   =NNTI_BUFFER_C_POINTER(&rq->staging) + rq->entry_stride - put_length;
+    memcpy(staging, msg, length);
+    trailer=(trios_remote_queue_trailer_t *)(NNTI_BUFFER_C_POINTER(&rq->staging) + rq->entry_stride - RQ_TRAILER_SIZE);
+    trailer->length  =length;
+    trailer->reserved=0;
+    trailer->ticket  =ticket+1;
+
+    nnti_rc=NNTI_put(
+            &rq->staging,
+            rq->entry_stride - put_length,
+            put_length,
+            rq->ring_hdl,
+            entry_offset(rq, ticket) + rq->entry_stride - put_length,
+            &wr);
+    if (nnti_rc == NNTI_OK) {
+        nnti_rc=wait_for(&wr);
+    }
+    if (nnti_rc != NNTI_OK) {
+        log_error(rq_debug_level, "failed putting ticket %llu: %d", (unsigned long long)ticket, nnti_rc);
+        goto out;
+    }
+    rq->messages++;
+
+out:
+    nthread_unlock(&rq->mutex);
+
+    return((int)nnti_rc);
+}
+
+/**
+ * @brief Take the next message from the ring without waiting.
+ *
+ * Returns NNTI_EAGAIN if the next message hasn't landed yet and
+ * NNTI_EMSGSIZE (with the message left in the ring and its size in
+ * <tt>length</tt>) if <tt>max_length</tt> is too small.
+ */
+int trios_remote_queue_dequeue(
+        trios_remote_queue_t *rq,
+        void                 *msg,
+        uint32_t              max_length,
+        uint32_t             *length)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+    volatile trios_remote_queue_trailer_t *trailer;
+    uint32_t msg_length;
+    char    *entry;
+
+    if (!rq->is_consumer) {
+        return((int)NNTI_EINVAL);
+    }
+
+    if (nthread_lock(&rq->mutex)) log_warn(rq_debug_level, "failed to get thread lock");
+
+    trailer=ring_trailer(rq, rq->head);
+    if (trailer->ticket != rq->head+1) {
+        nnti_rc=NNTI_EAGAIN;
+        goto out;
+    }
+    /* don't read the message before the trailer that says it's there */
+    __sync_synchronize();
+
+    msg_length=trailer->length;
+    *length=msg_length;
+    if (msg_length > max_length) {
+        nnti_rc=NNTI_EMSGSIZE;
+        goto out;
+    }
+    entry=(char *)trailer - aligned_length(msg_length);
+    memcpy(msg, entry, msg_length);
+
+    /* finish reading the entry before handing it back to the producers */
+    __sync_synchronize();
+    rq->head++;
+    ring_header(rq)->head=rq->head;
+    rq->messages++;
+
+out:
+    nthread_unlock(&rq->mutex);
+
+    return((int)nnti_rc);
+}
+
+int trios_remote_queue_fini(
+        trios_remote_queue_t *rq)
+{
+    NNTI_result_t nnti_rc=NNTI_OK;
+
+    log_debug(rq_debug_level, "enter");
+
+    if (nthread_lock(&rq->mutex)) log_warn(rq_debug_level, "failed to get thread lock");
+    if (rq->is_consumer) {
+        nnti_rc=NNTI_free(&rq->ring);
+    } else {
+        NNTI_free(&rq->staging);
+        nnti_rc=NNTI_free(&rq->control);
+    }
+    nthread_unlock(&rq->mutex);
+    nthread_lock_fini(&rq->mutex);
+
+    log_debug(rq_debug_level, "exit");
+
+    return((int)nnti_rc);
+}
@@ -0,0 +1,143 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*-------------------------------------------------------------------------*/
+/**  @file remote_queue.h
+ *
+ *   @brief API for a many-producer, single-consumer message queue that
+ *          producers fill with one-sided operations.
+ *
+ */
+
+#ifndef _TRIOS_REMOTE_QUEUE_H_
+#define _TRIOS_REMOTE_QUEUE_H_
+
+
+#include "Trios_config.h"
+
+#include "Trios_threads.h"
+
+#include "Trios_nnti.h"
+
+
+/*
+ * The consumer owns a ring of fixed size entries in a buffer registered
+ * with NNTI_BOP_ATOMICS.  A producer reserves an entry by fetch-adding the
+ * tail in the ring's header, then puts the message into it.  The consumer
+ * polls its own memory, so a message costs the consumer nothing until it
+ * is dequeued.  On transports without one-sided hardware (MPI) the puts and
+ * atomics still land only while the consumer is inside the NNTI progress
+ * functions (NNTI_wait() and friends).
+ *
+ * Every entry ends in a trailer.  A message is right-aligned against the
+ * trailer, so the message and the trailer go out in one put.  The ticket in
+ * the trailer is the entry's ticket plus one.  It is the ready flag, and
+ * because tickets never repeat, an entry left over from the previous lap
+ * of the ring never looks ready.  The consumer publishes the next ticket it
+ * will consume in the header.  A producer whose ticket is a full ring ahead
+ * of it gets the header until its entry is free.
+ */
+typedef struct trios_remote_queue_header {
+    uint64_t tail;         /* next ticket to hand out */
+    uint64_t head;         /* next ticket the consumer will dequeue */
+    uint32_t entry_count;
+    uint32_t entry_size;   /* largest message */
+    uint64_t reserved[5];
+} trios_remote_queue_header_t;
+
+typedef struct trios_remote_queue_trailer {
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t ticket;       /* ticket+1 once the message has landed */
+} trios_remote_queue_trailer_t;
+
+typedef struct trios_remote_queue {
+    nthread_lock_t        mutex;         /* serializes the callers of one handle */
+    NNTI_transport_t     *trans_hdl;
+    uint8_t               is_consumer;
+    NNTI_buffer_t         ring;          /* consumer: the ring */
+    const NNTI_buffer_t  *ring_hdl;      /* the ring's handle.  a producer's must outlive the queue. */
+    NNTI_buffer_t         control;       /* producer: fetched tickets and heads land here */
+    NNTI_buffer_t         staging;       /* producer: messages are put from here */
+    uint32_t              entry_count;
+    uint32_t              entry_size;
+    uint32_t              entry_stride;
+    uint64_t              head;          /* consumer: next ticket.  producer: last head it read. */
+    uint64_t              messages;      /* enqueued or dequeued through this handle */
+    uint64_t              full_waits;    /* producer: header reads because the ring was full */
+} trios_remote_queue_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__STDC__) || defined(__cplusplus)
+
+    extern int trios_remote_queue_create(
+            trios_remote_queue_t *rq,
+            NNTI_transport_t     *trans_hdl,
+            uint32_t              entry_count,
+            uint32_t              entry_size);
+    extern int trios_remote_queue_attach(
+            trios_remote_queue_t *rq,
+            NNTI_transport_t     *trans_hdl,
+            const NNTI_buffer_t  *ring_hdl);
+    extern int trios_remote_queue_enqueue(
+            trios_remote_queue_t *rq,
+            const void           *msg,
+            uint32_t              length);
+    extern int trios_remote_queue_dequeue(
+            trios_remote_queue_t *rq,
+            void                 *msg,
+            uint32_t              max_length,
+            uint32_t             *length);
+    extern int trios_remote_queue_fini(
+            trios_remote_queue_t *rq);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
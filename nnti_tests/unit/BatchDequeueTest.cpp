@@ -0,0 +1,164 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * BatchDequeueTest.cpp
+ *
+ *  Sends several requests to ourselves, then takes them off the receive
+ *  queue in batches with NNTI_dequeue_requests() and returns the slots
+ *  with NNTI_release_requests().
+ */
+
+#include "Trios_nnti.h"
+
+#include "Trios_logger.h"
+
+#include "SelfConnect.h"
+
+#include <string.h>
+
+#include <iostream>
+
+#define QUEUE_SLOTS 8
+#define SEND_COUNT  5
+#define BATCH_SIZE  3
+
+NNTI_transport_t     trans_hdl;
+NNTI_peer_t          server_hdl;
+NNTI_buffer_t        queue_mr, send_mr;
+
+bool success=true;
+
+static void send_requests(int first)
+{
+    NNTI_work_request_t send_wr;
+    NNTI_status_t       send_status;
+
+    for (int i=0;i<SEND_COUNT;i++) {
+        uint32_t *val=(uint32_t *)NNTI_BUFFER_C_POINTER(&send_mr);
+        *val=first+i;
+        NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+        NNTI_wait(&send_wr, 5000, &send_status);
+    }
+}
+
+static uint32_t drain_requests(int first)
+{
+    NNTI_work_request_t wr_list[BATCH_SIZE];
+    NNTI_status_t       status_list[BATCH_SIZE];
+    uint32_t            count=0;
+    uint32_t            total=0;
+    NNTI_result_t       rc;
+
+    while (total < SEND_COUNT) {
+        rc=NNTI_dequeue_requests(&queue_mr, BATCH_SIZE, 5000, wr_list, status_list, &count);
+        if ((rc != NNTI_OK) || (count == 0) || (count > BATCH_SIZE)) {
+            std::cout << "NNTI_dequeue_requests() failed: rc=" << rc << " count=" << count << std::endl;
+            success=false;
+            break;
+        }
+        for (uint32_t i=0;i<count;i++) {
+            uint32_t *val=(uint32_t *)(status_list[i].start + status_list[i].offset);
+            if (*val != (uint32_t)(first+total+i)) {
+                std::cout << "out of order request: expected " << first+total+i << " got " << *val << std::endl;
+                success=false;
+            }
+        }
+        total += count;
+        NNTI_release_requests(wr_list, count);
+    }
+
+    return(total);
+}
+
+int main(int argc, char *argv[])
+{
+    NNTI_result_t rc;
+
+    NNTI_work_request_t wr_list[BATCH_SIZE];
+    NNTI_status_t       status_list[BATCH_SIZE];
+    uint32_t            count=0;
+
+    logger_init(LOG_ERROR, NULL);
+
+    rc=NNTI_init(NNTI_DEFAULT_TRANSPORT, NULL, &trans_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_init() failed: rc=" << rc << std::endl;
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    rc=NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, QUEUE_SLOTS, NNTI_RECV_QUEUE, &queue_mr);
+
+    rc=self_connect(&trans_hdl, 5000, &server_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_connect() failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+
+    /* an empty queue times out */
+    rc=NNTI_dequeue_requests(&queue_mr, BATCH_SIZE, 100, wr_list, status_list, &count);
+    if ((rc != NNTI_ETIMEDOUT) || (count != 0)) {
+        std::cout << "expected NNTI_ETIMEDOUT from an empty queue: rc=" << rc << " count=" << count << std::endl;
+        success=false;
+    }
+
+    /* the second round only fits if the first round's slots were reposted */
+    send_requests(0);
+    drain_requests(0);
+    send_requests(SEND_COUNT);
+    drain_requests(SEND_COUNT);
+
+    NNTI_free(&send_mr);
+    NNTI_free(&queue_mr);
+
+    NNTI_fini(&trans_hdl);
+
+    if (success)
+        std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+    else
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+    return (success ? 0 : 1 );
+}
@@ -0,0 +1,162 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * BufferPoolTest.cpp
+ *
+ *      Author: thkorde
+ */
+
+#include "Trios_nnti.h"
+
+#include "Trios_logger.h"
+
+#include "buffer_queue.h"
+
+#include <unistd.h>
+
+#include <iostream>
+
+NNTI_transport_t     trans_hdl;
+
+bool success=true;
+
+int main(int argc, char *argv[])
+{
+    NNTI_result_t rc;
+    trios_buffer_pool_t       pool;
+    trios_buffer_pool_stats_t stats;
+    NNTI_buffer_t            *bufs[8];
+
+    uint32_t class_sizes[3] = { 256, 4096, 65536 };
+
+    logger_init(LOG_ERROR, NULL);
+
+    rc=NNTI_init(NNTI_DEFAULT_TRANSPORT, NULL, &trans_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_init() failed: rc=" << rc << std::endl;
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    /* 2 buffers per class up front, room to grow to 8, trim after 10ms idle */
+    trios_buffer_pool_init(&pool, 3, class_sizes, 2, 8, 10, &trans_hdl, NNTI_SEND_SRC);
+
+    /* a 1000 byte request belongs in the 4096 byte class */
+    bufs[0]=trios_buffer_pool_pop(&pool, 1000);
+    if ((bufs[0] == NULL) || (NNTI_BUFFER_SIZE(bufs[0]) != 4096)) {
+        std::cout << "1000 byte request was not served by the 4096 byte class" << std::endl;
+        success=false;
+    }
+    trios_buffer_pool_push(&pool, bufs[0]);
+
+    /* nothing fits a request larger than the largest class */
+    if (trios_buffer_pool_pop(&pool, 65537) != NULL) {
+        std::cout << "oversized request returned a buffer" << std::endl;
+        success=false;
+    }
+
+    /* a burst of 6 grows the 256 byte class to 6 and keeps the buffers */
+    for (int i=0;i<6;i++) bufs[i]=trios_buffer_pool_pop(&pool, 100);
+    for (int i=0;i<6;i++) trios_buffer_pool_push(&pool, bufs[i]);
+    trios_buffer_pool_get_stats(&pool, 0, &stats);
+    if ((stats.high_water != 6) || (stats.queue.pooled != 6) || (stats.queue.deregistrations != 0)) {
+        std::cout << "burst: high_water=" << stats.high_water << " pooled=" << stats.queue.pooled
+                  << " deregistrations=" << stats.queue.deregistrations << std::endl;
+        success=false;
+    }
+
+    /* the same burst again is served entirely from the pool */
+    for (int i=0;i<6;i++) bufs[i]=trios_buffer_pool_pop(&pool, 100);
+    for (int i=0;i<6;i++) trios_buffer_pool_push(&pool, bufs[i]);
+    trios_buffer_pool_get_stats(&pool, 0, &stats);
+    if ((stats.queue.hits != 8) || (stats.queue.registrations != 6)) {
+        std::cout << "repeat burst: hits=" << stats.queue.hits << " registrations=" << stats.queue.registrations << std::endl;
+        success=false;
+    }
+
+    /* after going idle the class decays back toward initial_size */
+    uint64_t held_before=0;
+    uint64_t held_after=0;
+    uint32_t released=0;
+    for (uint32_t i=0;i<3;i++) {
+        trios_buffer_pool_get_stats(&pool, i, &stats);
+        held_before += stats.queue.pooled;
+    }
+    usleep(20*1000);
+    released += trios_buffer_pool_trim(&pool);
+    usleep(20*1000);
+    released += trios_buffer_pool_trim(&pool);
+    for (uint32_t i=0;i<3;i++) {
+        trios_buffer_pool_get_stats(&pool, i, &stats);
+        held_after += stats.queue.pooled;
+    }
+    trios_buffer_pool_get_stats(&pool, 0, &stats);
+    if ((stats.queue.pooled >= 6) || (stats.queue.bytes_held != stats.queue.pooled*256)) {
+        std::cout << "trim: pooled=" << stats.queue.pooled << " bytes_held=" << stats.queue.bytes_held << std::endl;
+        success=false;
+    }
+    /* trim reports exactly the buffers the queues gave up */
+    if (released != held_before - held_after) {
+        std::cout << "trim: released=" << released << " but pooled went from " << held_before << " to " << held_after << std::endl;
+        success=false;
+    }
+
+    trios_buffer_pool_fini(&pool);
+
+    /* a rejected configuration leaves the pool empty */
+    uint32_t bad_sizes[2] = { 4096, 256 };
+    if ((trios_buffer_pool_init(&pool, 2, bad_sizes, 2, 8, 10, &trans_hdl, NNTI_SEND_SRC) == NNTI_OK) ||
+        (trios_buffer_pool_pop(&pool, 100) != NULL)) {
+        std::cout << "pool with decreasing class sizes was usable" << std::endl;
+        success=false;
+    }
+
+    NNTI_fini(&trans_hdl);
+
+    if (success)
+        std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+    else
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+    return (success ? 0 : 1 );
+}
@@ -0,0 +1,174 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * CreditFlowTest.cpp
+ *
+ *  Enables request flow control, sends requests to ourselves until the
+ *  credits run out and checks that consuming requests returns the
+ *  credits.  The limit is larger than the request queue, so the credits
+ *  granted at connect come from the number of queue slots.
+ */
+
+#include "Trios_nnti.h"
+
+#include "Trios_logger.h"
+
+#include "SelfConnect.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+#define QUEUE_SLOTS   4
+#define CREDITS       QUEUE_SLOTS
+#define CREDIT_LIMIT 64
+
+NNTI_transport_t     trans_hdl;
+NNTI_peer_t          server_hdl;
+NNTI_buffer_t        queue_mr, send_mr;
+
+bool success=true;
+
+static NNTI_result_t send_request(void)
+{
+    NNTI_work_request_t send_wr;
+    NNTI_status_t       send_status;
+    NNTI_result_t       rc;
+
+    rc=NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+    if (rc == NNTI_OK) {
+        rc=NNTI_wait(&send_wr, 5000, &send_status);
+    }
+
+    return(rc);
+}
+
+static void consume_request(void)
+{
+    NNTI_work_request_t queue_wr;
+    NNTI_status_t       queue_status;
+    NNTI_result_t       rc;
+
+    NNTI_create_work_request(&queue_mr, &queue_wr);
+    rc=NNTI_wait(&queue_wr, 5000, &queue_status);
+    if (rc != NNTI_OK) {
+        std::cout << "waiting for a request failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    NNTI_destroy_work_request(&queue_wr);
+}
+
+int main(int argc, char *argv[])
+{
+    NNTI_result_t rc;
+    char credits[16];
+
+    logger_init(LOG_ERROR, NULL);
+
+    sprintf(credits, "%d", CREDIT_LIMIT);
+    setenv("TRIOS_NNTI_REQUEST_CREDITS", credits, 1);
+
+    rc=NNTI_init(NNTI_DEFAULT_TRANSPORT, NULL, &trans_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_init() failed: rc=" << rc << std::endl;
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    rc=NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, QUEUE_SLOTS, NNTI_RECV_QUEUE, &queue_mr);
+
+    rc=self_connect(&trans_hdl, 5000, &server_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "connect failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+
+    for (int i=0;i<CREDITS;i++) {
+        if ((rc=send_request()) != NNTI_OK) {
+            std::cout << "request " << i << " failed: rc=" << rc << std::endl;
+            success=false;
+        }
+    }
+
+    /* the queue has room, but the client is out of credits */
+    rc=send_request();
+    if (rc != NNTI_EAGAIN) {
+        std::cout << "expected NNTI_EAGAIN without credits: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    /* consuming half of the grant sends those credits back */
+    for (int i=0;i<CREDITS/2;i++) {
+        consume_request();
+    }
+    for (int i=0;i<CREDITS/2;i++) {
+        if ((rc=send_request()) != NNTI_OK) {
+            std::cout << "request after credit return failed: rc=" << rc << std::endl;
+            success=false;
+        }
+    }
+    rc=send_request();
+    if (rc != NNTI_EAGAIN) {
+        std::cout << "expected NNTI_EAGAIN after spending returned credits: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    for (int i=0;i<CREDITS;i++) {
+        consume_request();
+    }
+
+    NNTI_free(&send_mr);
+    NNTI_free(&queue_mr);
+
+    NNTI_fini(&trans_hdl);
+
+    if (success)
+        std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+    else
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+    return (success ? 0 : 1 );
+}
@@ -0,0 +1,235 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbActiveMessageTest.cpp
+ *
+ *  Active messages over the InfiniBand transport with the verbs emulator,
+ *  run by the waiter on the request queue and by handler threads.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#include <unistd.h>
+
+/* active messages sent to handler threads */
+#define AM_THREADS 2
+#define AM_BURST   40
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+static NNTI_result_t sum_handler(
+        const NNTI_transport_t *trans_hdl,
+        const NNTI_peer_t      *src,
+        void                   *payload,
+        const uint32_t          length,
+        void                   *context)
+{
+    if (length == sizeof(int)) {
+        __sync_fetch_and_add((int *)context, *(int *)payload);
+    }
+    return(NNTI_OK);
+}
+
+/*
+ * Active messages share the request queue with ordinary requests.  Waiting
+ * on the queue should only return the ordinary ones after the handlers have
+ * run on the rest.  An active message for a handler that isn't registered
+ * comes back as an ordinary request.
+ */
+static void check_active_messages(void)
+{
+    NNTI_buffer_t        am_mr;
+    NNTI_work_request_t  wr[4];
+    NNTI_status_t        status[4];
+    NNTI_work_request_t  am_queue_wr;
+    NNTI_status_t        am_queue_status;
+    NNTI_result_t        rc=NNTI_OK;
+    int                  sum=0;
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &am_mr);
+    NNTI_am_register(&trans_hdl, 7, sum_handler, &sum);
+
+    /* AM(1), request, AM(2), AM to an unregistered handler */
+    for (int i=0;i<4;i++) {
+        if (i == 1) {
+            *(uint32_t *)NNTI_BUFFER_C_POINTER(&am_mr)=0xFEEDFACE;
+            if (rc == NNTI_OK) rc=NNTI_send(&server_hdl, &am_mr, NULL, &wr[i]);
+        } else {
+            *(int *)NNTI_AM_PAYLOAD(&am_mr)=i ? 2 : 1;
+            if (rc == NNTI_OK) rc=NNTI_am_send(&server_hdl, &am_mr, (i == 3) ? 8 : 7, sizeof(int), &wr[i]);
+        }
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr[i], 5000, &status[i]);
+    }
+
+    if (rc == NNTI_OK) {
+        NNTI_create_work_request(&queue_mr, &am_queue_wr);
+        rc=NNTI_wait(&am_queue_wr, 5000, &am_queue_status);
+        if ((rc == NNTI_OK) && (*(uint32_t *)(am_queue_status.start + am_queue_status.offset) != 0xFEEDFACE)) {
+            std::cout << "wait returned an active message" << std::endl;
+            success=false;
+        }
+        NNTI_destroy_work_request(&am_queue_wr);
+    }
+    if (rc == NNTI_OK) {
+        NNTI_create_work_request(&queue_mr, &am_queue_wr);
+        rc=NNTI_wait(&am_queue_wr, 5000, &am_queue_status);
+        if ((rc == NNTI_OK) && (am_queue_status.length != NNTI_AM_HEADER_SIZE+sizeof(int))) {
+            std::cout << "active message for an unregistered handler has length " << am_queue_status.length << std::endl;
+            success=false;
+        }
+        NNTI_destroy_work_request(&am_queue_wr);
+    }
+    /* nothing left, so this times out */
+    if (rc == NNTI_OK) {
+        NNTI_create_work_request(&queue_mr, &am_queue_wr);
+        rc=NNTI_wait(&am_queue_wr, 100, &am_queue_status);
+        NNTI_destroy_work_request(&am_queue_wr);
+        if (rc == NNTI_ETIMEDOUT) rc=NNTI_OK;
+    }
+    if ((rc != NNTI_OK) || (sum != 3)) {
+        std::cout << "active messages failed: rc=" << rc << " sum=" << sum << std::endl;
+        success=false;
+    }
+
+    if ((NNTI_am_send(&server_hdl, &am_mr, 7, NNTI_REQUEST_BUFFER_SIZE, &wr[0]) != NNTI_EMSGSIZE) ||
+        (NNTI_am_send(&server_hdl, &am_mr, NNTI_AM_MAX_HANDLERS, sizeof(int), &wr[0]) != NNTI_EINVAL)) {
+        std::cout << "invalid active message was not rejected" << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_am_start_threads(&queue_mr, AM_THREADS);
+    if (rc == NNTI_ENOTSUP) {
+        std::cout << "no handler threads in this build.  skipping handler thread checks." << std::endl;
+    } else if (rc != NNTI_OK) {
+        std::cout << "handler threads failed to start: rc=" << rc << std::endl;
+        success=false;
+    } else {
+        rc=NNTI_OK;
+        for (int i=0;i<AM_BURST;i++) {
+            *(int *)NNTI_AM_PAYLOAD(&am_mr)=1;
+            if (rc == NNTI_OK) rc=NNTI_am_send(&server_hdl, &am_mr, 7, sizeof(int), &wr[0]);
+            if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        }
+        for (int i=0;(i<100) && (sum != 3+AM_BURST);i++) {
+            usleep(10000);
+        }
+        NNTI_am_stop_threads(&trans_hdl);
+        if ((rc != NNTI_OK) || (sum != 3+AM_BURST)) {
+            std::cout << "handler threads failed: rc=" << rc << " sum=" << sum << std::endl;
+            success=false;
+        }
+    }
+
+    NNTI_am_register(&trans_hdl, 7, NULL, NULL);
+    NNTI_free(&am_mr);
+}
+
+/*
+ * A short active message staged in a buffer larger than a request only
+ * sends the message, so the handler still runs.
+ */
+static void check_large_buffer(void)
+{
+    NNTI_buffer_t        big_mr;
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    NNTI_work_request_t  am_queue_wr;
+    NNTI_status_t        am_queue_status;
+    NNTI_result_t        rc=NNTI_OK;
+    int                  sum=0;
+
+    NNTI_alloc(&trans_hdl, 4*NNTI_REQUEST_BUFFER_SIZE, 1, (NNTI_buf_ops_t)(NNTI_SEND_SRC|NNTI_GET_SRC), &big_mr);
+    NNTI_am_register(&trans_hdl, 7, sum_handler, &sum);
+
+    /* more than there are raw slots, so each send has to give its slot back */
+    for (int i=0;(rc == NNTI_OK) && (i<NNTI_RAW_MAX+2);i++) {
+        *(int *)NNTI_AM_PAYLOAD(&big_mr)=1;
+        rc=NNTI_am_send(&server_hdl, &big_mr, 7, sizeof(int), &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+        if ((rc == NNTI_OK) && (status.length != NNTI_AM_HEADER_SIZE+sizeof(int))) {
+            std::cout << "active message from a large buffer sent " << status.length << " bytes" << std::endl;
+            success=false;
+        }
+        /* runs the handler and times out */
+        if (rc == NNTI_OK) {
+            NNTI_create_work_request(&queue_mr, &am_queue_wr);
+            rc=NNTI_wait(&am_queue_wr, 100, &am_queue_status);
+            NNTI_destroy_work_request(&am_queue_wr);
+            if (rc == NNTI_ETIMEDOUT) rc=NNTI_OK;
+        }
+    }
+    if ((rc != NNTI_OK) || (sum != NNTI_RAW_MAX+2)) {
+        std::cout << "active messages from a large buffer failed: rc=" << rc << " sum=" << sum << std::endl;
+        success=false;
+    }
+
+    NNTI_am_register(&trans_hdl, 7, NULL, NULL);
+    NNTI_free(&big_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_active_messages();
+    check_large_buffer();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
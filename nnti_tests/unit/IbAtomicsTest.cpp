@@ -0,0 +1,333 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbAtomicsTest.cpp
+ *
+ *  Atomics over the InfiniBand transport with the verbs emulator:
+ *  the NNTI atomic variables, atomics on buffers, callbacks on changed
+ *  variables and vectors of updates.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+static void check_atomics(void)
+{
+    NNTI_work_request_t wr;
+    NNTI_status_t       status;
+    NNTI_result_t       rc;
+    int64_t             value=-1;
+
+    for (int i=0;i<10;i++) {
+        rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 0, 1, 1, NNTI_ATOMIC_FADD, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+        NNTI_atomic_read(&trans_hdl, 1, &value);
+        if ((rc != NNTI_OK) || (value != i)) {
+            std::cout << "fetch-add failed: rc=" << rc << " previous=" << value << " expected=" << i << std::endl;
+            success=false;
+        }
+    }
+
+    rc=NNTI_atomic_cswap(&trans_hdl, &server_hdl, 0, 1, 10, 100, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    NNTI_atomic_read(&trans_hdl, 0, &value);
+    if ((rc != NNTI_OK) || (value != 100)) {
+        std::cout << "compare-and-swap failed: rc=" << rc << " value=" << value << std::endl;
+        success=false;
+    }
+
+    /* each op starts from the value the previous one left behind */
+    static const struct {
+        NNTI_atomic_op_t op;
+        int64_t          operand;
+        int64_t          previous;
+        int64_t          value;
+    } ops[] = {
+        { NNTI_ATOMIC_FSWAP,  7, 100,  7 },
+        { NNTI_ATOMIC_FAND,   6,   7,  6 },
+        { NNTI_ATOMIC_FOR,    9,   6, 15 },
+        { NNTI_ATOMIC_FXOR,   5,  15, 10 },
+        { NNTI_ATOMIC_FMIN,  -3,  10, -3 },
+        { NNTI_ATOMIC_FMAX,   4,  -3,  4 },
+        { NNTI_ATOMIC_ADD,   10,  -3, 14 },
+        { NNTI_ATOMIC_OR,     1,  -3, 15 },
+        { NNTI_ATOMIC_MAX,   20,  -3, 20 },
+        { NNTI_ATOMIC_MIN,   -1,  -3, -1 },
+        { NNTI_ATOMIC_XOR,   -1,  -3,  0 },
+    };
+    for (size_t i=0;i<sizeof(ops)/sizeof(ops[0]);i++) {
+        int64_t previous=-1;
+
+        rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 0, 1, ops[i].operand, ops[i].op, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+        NNTI_atomic_read(&trans_hdl, 1, &previous);
+        NNTI_atomic_read(&trans_hdl, 0, &value);
+        if ((rc != NNTI_OK) || (previous != ops[i].previous) || (value != ops[i].value)) {
+            std::cout << "atomic op " << ops[i].op << " failed: rc=" << rc << " previous=" << previous
+                      << " value=" << value << " expected=" << ops[i].previous << "/" << ops[i].value << std::endl;
+            success=false;
+        }
+    }
+
+    rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 0, 1, 1, (NNTI_atomic_op_t)99, &wr);
+    if (rc != NNTI_EINVAL) {
+        std::cout << "invalid atomic op was not rejected: rc=" << rc << std::endl;
+        success=false;
+    }
+}
+
+static void check_atomic_buffers(void)
+{
+    NNTI_buffer_t       target_mr;
+    NNTI_buffer_t       result_mr;
+    NNTI_buffer_t       plain_mr;
+    NNTI_work_request_t wr;
+    NNTI_status_t       status;
+    NNTI_result_t       rc;
+    int64_t            *target;
+    int64_t            *result;
+
+    NNTI_alloc(&trans_hdl, 8*sizeof(int64_t), 1, (NNTI_buf_ops_t)(NNTI_BOP_ATOMICS|NNTI_BOP_REMOTE_WRITE), &target_mr);
+    NNTI_alloc(&trans_hdl, 8*sizeof(int64_t), 1, NNTI_GET_DST, &result_mr);
+    NNTI_alloc(&trans_hdl, 8*sizeof(int64_t), 1, NNTI_GET_SRC, &plain_mr);
+    target=(int64_t *)NNTI_BUFFER_C_POINTER(&target_mr);
+    result=(int64_t *)NNTI_BUFFER_C_POINTER(&result_mr);
+    memset(target, 0, 8*sizeof(int64_t));
+    memset(result, 0, 8*sizeof(int64_t));
+    target[3]=40;
+    target[5]=7;
+
+    rc=NNTI_atomic_fop_buffer(&target_mr, 3*sizeof(int64_t), &result_mr, 1*sizeof(int64_t), 2, NNTI_ATOMIC_FADD, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (result[1] != 40) || (target[3] != 42)) {
+        std::cout << "buffer fetch-add failed: rc=" << rc << " previous=" << result[1] << " value=" << target[3] << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_atomic_fop_buffer(&target_mr, 5*sizeof(int64_t), &result_mr, 2*sizeof(int64_t), 3, NNTI_ATOMIC_FMAX, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (result[2] != 7) || (target[5] != 7)) {
+        std::cout << "buffer fetch-max failed: rc=" << rc << " previous=" << result[2] << " value=" << target[5] << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_atomic_fop_buffer(&target_mr, 5*sizeof(int64_t), NULL, 0, 5, NNTI_ATOMIC_XOR, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (target[5] != 2)) {
+        std::cout << "buffer xor failed: rc=" << rc << " value=" << target[5] << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_atomic_cswap_buffer(&target_mr, 3*sizeof(int64_t), &result_mr, 0, 42, -1, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (result[0] != 42) || (target[3] != -1)) {
+        std::cout << "buffer compare-and-swap failed: rc=" << rc << " previous=" << result[0] << " value=" << target[3] << std::endl;
+        success=false;
+    }
+
+    /* misaligned, out of range, a fetch without a result and a buffer without atomics */
+    if ((NNTI_atomic_fop_buffer(&target_mr, 4, &result_mr, 0, 1, NNTI_ATOMIC_FADD, &wr) != NNTI_EINVAL) ||
+        (NNTI_atomic_fop_buffer(&target_mr, 8*sizeof(int64_t), &result_mr, 0, 1, NNTI_ATOMIC_FADD, &wr) != NNTI_EINVAL) ||
+        (NNTI_atomic_fop_buffer(&target_mr, 0, NULL, 0, 1, NNTI_ATOMIC_FADD, &wr) != NNTI_EINVAL) ||
+        (NNTI_atomic_cswap_buffer(&plain_mr, 0, &result_mr, 0, 0, 1, &wr) != NNTI_EINVAL)) {
+        std::cout << "invalid buffer atomic was not rejected" << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&plain_mr);
+    NNTI_free(&result_mr);
+    NNTI_free(&target_mr);
+}
+
+static NNTI_result_t count_callback(
+        const NNTI_transport_t *trans_hdl,
+        const uint64_t          local_atomic,
+        void                   *context)
+{
+    (*(int *)context)++;
+    return(NNTI_OK);
+}
+
+static void check_atomic_callbacks(void)
+{
+    NNTI_work_request_t wr;
+    NNTI_status_t       status;
+    NNTI_result_t       rc;
+    int                 changes=0;
+    int                 crossings=0;
+
+    NNTI_atomic_set_callback(&trans_hdl, 5, count_callback, &changes);
+    NNTI_atomic_set_threshold_callback(&trans_hdl, 4, 3, count_callback, &crossings);
+
+    for (int i=0;i<5;i++) {
+        rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 4, 6, 1, NNTI_ATOMIC_FADD, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    }
+    for (int i=0;i<2;i++) {
+        rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 5, 6, 1, NNTI_ATOMIC_FADD, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    }
+    if ((rc != NNTI_OK) || (changes != 2) || (crossings != 1)) {
+        std::cout << "atomic callbacks failed: rc=" << rc << " changes=" << changes << " crossings=" << crossings << std::endl;
+        success=false;
+    }
+
+    NNTI_atomic_set_callback(&trans_hdl, 5, NULL, NULL);
+    NNTI_atomic_set_threshold_callback(&trans_hdl, 4, 3, NULL, NULL);
+    rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 5, 6, 1, NNTI_ATOMIC_FADD, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (changes != 2)) {
+        std::cout << "removed atomic callback still ran: rc=" << rc << " changes=" << changes << std::endl;
+        success=false;
+    }
+
+    if (NNTI_atomic_set_callback(&trans_hdl, 1<<30, count_callback, &changes) != NNTI_EINVAL) {
+        std::cout << "atomic callback on a bad variable was not rejected" << std::endl;
+        success=false;
+    }
+}
+
+static void check_atomic_vectors(void)
+{
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    NNTI_result_t        rc;
+    NNTI_atomic_update_t updates[208];
+    uint32_t             count=0;
+    int64_t              value;
+
+    /* more updates than fit in one window, several on each counter */
+    for (int i=0;i<200;i++) {
+        updates[count].target_atomic=100 + (i % 50);
+        updates[count].result_atomic=0;
+        updates[count].operand      =i;
+        updates[count].op           =NNTI_ATOMIC_ADD;
+        count++;
+    }
+    /* emulated updates that race each other on one variable */
+    for (int i=0;i<4;i++) {
+        updates[count].target_atomic=210;
+        updates[count].result_atomic=0;
+        updates[count].operand      =10*(i+1);
+        updates[count].op           =NNTI_ATOMIC_MAX;
+        count++;
+    }
+    for (int i=0;i<4;i++) {
+        updates[count].target_atomic=200 + i;
+        updates[count].result_atomic=300 + i;
+        updates[count].operand      =i+1;
+        updates[count].op           =(i % 2) ? NNTI_ATOMIC_FOR : NNTI_ATOMIC_FADD;
+        count++;
+    }
+
+    /* the second pass fetches what the first one left behind */
+    for (int pass=0;pass<2;pass++) {
+        rc=NNTI_atomic_fopv(&trans_hdl, &server_hdl, updates, count, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+        if (rc != NNTI_OK) {
+            std::cout << "vector atomic failed: rc=" << rc << std::endl;
+            success=false;
+        }
+    }
+
+    for (int c=0;c<50;c++) {
+        int64_t expected=2*(4*c + 300);
+        NNTI_atomic_read(&trans_hdl, 100 + c, &value);
+        if (value != expected) {
+            std::cout << "vector add on " << 100 + c << " failed: value=" << value << " expected=" << expected << std::endl;
+            success=false;
+        }
+    }
+    NNTI_atomic_read(&trans_hdl, 210, &value);
+    if (value != 40) {
+        std::cout << "vector max failed: value=" << value << std::endl;
+        success=false;
+    }
+    for (int i=0;i<4;i++) {
+        int64_t previous;
+        int64_t expected_value=(i % 2) ? (i+1) : 2*(i+1);
+        NNTI_atomic_read(&trans_hdl, 300 + i, &previous);
+        NNTI_atomic_read(&trans_hdl, 200 + i, &value);
+        if ((previous != i+1) || (value != expected_value)) {
+            std::cout << "vector fetch on " << 200 + i << " failed: previous=" << previous << " value=" << value << std::endl;
+            success=false;
+        }
+    }
+
+    updates[0].op=(NNTI_atomic_op_t)99;
+    if ((NNTI_atomic_fopv(&trans_hdl, &server_hdl, updates, count, &wr) != NNTI_EINVAL) ||
+        (NNTI_atomic_fopv(&trans_hdl, &server_hdl, updates, 0, &wr) != NNTI_EINVAL)) {
+        std::cout << "invalid vector atomic was not rejected" << std::endl;
+        success=false;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_atomics();
+    check_atomic_buffers();
+    check_atomic_callbacks();
+    check_atomic_vectors();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
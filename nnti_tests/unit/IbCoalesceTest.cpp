@@ -0,0 +1,328 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbCoalesceTest.cpp
+ *
+ *  Coalesced sends and puts over the InfiniBand transport with the verbs
+ *  emulator.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+/* small sends framed into one request and adjacent puts merged into one */
+#define COALESCED_SENDS 20
+#define COALESCED_PUT   8
+/* request credits, so the batch after this many is refused */
+#define COALESCE_CREDITS 2
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * Small sends to one peer arrive as one request that splits back into the
+ * messages.  Adjacent puts go out as one put.  Every operation still
+ * completes on its own work request.
+ */
+static void check_coalescing(void)
+{
+    NNTI_buffer_t        msg_mr[COALESCED_SENDS], src_mr, target_mr;
+    NNTI_work_request_t  wr[NNTI_COALESCE_MAX+1];
+    NNTI_work_request_t *wr_list[NNTI_COALESCE_MAX];
+    NNTI_status_t       *status_list[NNTI_COALESCE_MAX];
+    NNTI_status_t        status[NNTI_COALESCE_MAX];
+    NNTI_work_request_t  header_wr;
+    NNTI_status_t        header_status, msg_status;
+    NNTI_result_t        rc=NNTI_OK;
+    uint32_t             count=0;
+    uint32_t             which=0;
+
+    /* only size, a flush or a wait sends a batch */
+    NNTI_coalesce_config(&trans_hdl, NNTI_COALESCE_SIZE, 60000);
+
+    for (int i=0;i<COALESCED_SENDS;i++) {
+        NNTI_alloc(&trans_hdl, i+1, 1, NNTI_SEND_SRC, &msg_mr[i]);
+        memset(NNTI_BUFFER_C_POINTER(&msg_mr[i]), 0x40+i, i+1);
+        if (rc == NNTI_OK) rc=NNTI_send_coalesced(&server_hdl, &msg_mr[i], &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, COALESCED_SENDS, 5000, status_list);
+    if (rc == NNTI_OK) {
+        NNTI_create_work_request(&queue_mr, &header_wr);
+        rc=NNTI_wait(&header_wr, 5000, &header_status);
+        NNTI_coalesced_count(&header_status, &count);
+        if ((rc == NNTI_OK) && (count != COALESCED_SENDS)) {
+            std::cout << "coalesced request has " << count << " messages" << std::endl;
+            success=false;
+        }
+        for (uint32_t i=0;(rc == NNTI_OK) && (i<count);i++) {
+            char *p=NULL;
+            rc=NNTI_coalesced_message(&header_status, i, &msg_status);
+            p=(char *)msg_status.start + msg_status.offset;
+            if ((rc != NNTI_OK) || (msg_status.length != i+1) || (p[0] != (char)(0x40+i)) || (p[i] != (char)(0x40+i))) {
+                std::cout << "coalesced message " << i << " is corrupt: length=" << msg_status.length << std::endl;
+                success=false;
+                break;
+            }
+            if (status[i].length != i+1) {
+                std::cout << "coalesced send " << i << " has status length " << status[i].length << std::endl;
+                success=false;
+            }
+        }
+        if ((rc == NNTI_OK) && (NNTI_coalesced_message(&header_status, count, &msg_status) != NNTI_ENOENT)) {
+            std::cout << "coalesced request has a message past its count" << std::endl;
+            success=false;
+        }
+        NNTI_destroy_work_request(&header_wr);
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "coalesced sends failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    /* every op in one batch, then one too many */
+    NNTI_alloc(&trans_hdl, NNTI_COALESCE_MAX*COALESCED_PUT, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, NNTI_COALESCE_MAX*COALESCED_PUT, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    for (int i=0;i<NNTI_COALESCE_MAX*COALESCED_PUT;i++) {
+        src[i]=(char)i;
+    }
+    memset(target, 0, NNTI_COALESCE_MAX*COALESCED_PUT);
+
+    rc=NNTI_OK;
+    for (int i=0;(rc == NNTI_OK) && (i<NNTI_COALESCE_MAX);i++) {
+        rc=NNTI_put_coalesced(&src_mr, i*COALESCED_PUT, COALESCED_PUT, &target_mr, i*COALESCED_PUT, &wr[i]);
+        wr_list[i]=&wr[i];
+    }
+    if ((rc == NNTI_OK) && (NNTI_put_coalesced(&src_mr, 0, COALESCED_PUT, &target_mr, 0, &wr[NNTI_COALESCE_MAX]) != NNTI_EAGAIN)) {
+        std::cout << "coalesced put with every op busy didn't return NNTI_EAGAIN" << std::endl;
+        success=false;
+    }
+    if (rc == NNTI_OK) rc=NNTI_coalesce_flush(&trans_hdl);
+    for (int i=0;(rc == NNTI_OK) && (i<NNTI_COALESCE_MAX);i++) {
+        rc=NNTI_waitany(wr_list, NNTI_COALESCE_MAX, 5000, &which, &status[0]);
+        if ((rc == NNTI_OK) && ((status[0].offset != which*COALESCED_PUT) || (status[0].length != COALESCED_PUT))) {
+            std::cout << "coalesced put " << which << " has status offset " << status[0].offset << std::endl;
+            success=false;
+        }
+        wr_list[which]=NULL;
+    }
+    if ((rc != NNTI_OK) || memcmp(src, target, NNTI_COALESCE_MAX*COALESCED_PUT)) {
+        std::cout << "coalesced puts failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_coalesce_config(&trans_hdl, NNTI_COALESCE_SIZE, NNTI_COALESCE_DELAY);
+
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+    for (int i=0;i<COALESCED_SENDS;i++) {
+        NNTI_free(&msg_mr[i]);
+    }
+}
+
+/*
+ * A batch the transport refuses for lack of credits stays open with its
+ * messages and goes out once the credits come back.
+ */
+static void check_coalesce_retry(void)
+{
+    NNTI_buffer_t        msg_mr;
+    NNTI_work_request_t  wr[COALESCE_CREDITS+2];
+    NNTI_work_request_t *wr_list[COALESCE_CREDITS+2];
+    NNTI_status_t       *status_list[COALESCE_CREDITS+2];
+    NNTI_status_t        status[COALESCE_CREDITS+2];
+    NNTI_work_request_t  queue_wr;
+    NNTI_status_t        queue_status, msg_status;
+    NNTI_result_t        rc=NNTI_OK;
+    uint32_t             count=0;
+    uint32_t             which=0;
+
+    /* every operation is sent as soon as it's coalesced */
+    NNTI_coalesce_config(&trans_hdl, NNTI_COALESCE_SIZE, 0);
+
+    NNTI_alloc(&trans_hdl, sizeof(uint64_t), 1, NNTI_SEND_SRC, &msg_mr);
+    for (int i=0;(rc == NNTI_OK) && (i<COALESCE_CREDITS+2);i++) {
+        *(uint64_t *)NNTI_BUFFER_C_POINTER(&msg_mr)=i;
+        rc=NNTI_send_coalesced(&server_hdl, &msg_mr, &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, COALESCE_CREDITS, 5000, status_list);
+    if (rc != NNTI_OK) {
+        std::cout << "coalesced sends with credits failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    /* the refused batch holds the last two messages until a request is consumed */
+    if (NNTI_coalesce_flush(&trans_hdl) != NNTI_EAGAIN) {
+        std::cout << "flushing a refused batch didn't return NNTI_EAGAIN" << std::endl;
+        success=false;
+    }
+    rc=NNTI_waitany(&wr_list[COALESCE_CREDITS], 2, 100, &which, &status[0]);
+    if (rc != NNTI_ETIMEDOUT) {
+        std::cout << "coalesced send without credits didn't time out: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    for (int i=0;i<COALESCE_CREDITS+1;i++) {
+        NNTI_create_work_request(&queue_mr, &queue_wr);
+        rc=NNTI_wait(&queue_wr, 5000, &queue_status);
+        if (rc == NNTI_OK) {
+            NNTI_coalesced_count(&queue_status, &count);
+        }
+        if ((rc != NNTI_OK) || (count != ((i < COALESCE_CREDITS) ? 1 : 2))) {
+            std::cout << "request " << i << " after a refused batch: rc=" << rc << " count=" << count << std::endl;
+            success=false;
+        }
+        for (uint32_t j=0;(rc == NNTI_OK) && (j<count);j++) {
+            NNTI_coalesced_message(&queue_status, j, &msg_status);
+            if (*(uint64_t *)(msg_status.start + msg_status.offset) != (uint64_t)(i+j)) {
+                std::cout << "request " << i << " message " << j << " is out of order" << std::endl;
+                success=false;
+            }
+        }
+        NNTI_destroy_work_request(&queue_wr);
+        if (i == 0) {
+            rc=NNTI_waitall(&wr_list[COALESCE_CREDITS], 2, 5000, &status_list[COALESCE_CREDITS]);
+            if (rc != NNTI_OK) {
+                std::cout << "refused batch wasn't sent again: rc=" << rc << std::endl;
+                success=false;
+            }
+        }
+    }
+
+    NNTI_coalesce_config(&trans_hdl, NNTI_COALESCE_SIZE, NNTI_COALESCE_DELAY);
+
+    NNTI_free(&msg_mr);
+}
+
+/*
+ * A batch that fails doesn't stop NNTI_waitall() from finishing the other
+ * work requests.  Run last, because the failure breaks the connection's
+ * RDMA queue pair.
+ */
+static void check_coalesce_failure(void)
+{
+    NNTI_buffer_t        src_mr, target_mr, bad_target;
+    NNTI_remote_addr_t   bad_segment;
+    NNTI_work_request_t  wr[2];
+    NNTI_work_request_t *wr_list[2];
+    NNTI_status_t       *status_list[2];
+    NNTI_status_t        status[2];
+    NNTI_work_request_t  queue_wr;
+    NNTI_status_t        queue_status;
+    NNTI_result_t        rc=NNTI_OK;
+
+    NNTI_alloc(&trans_hdl, COALESCED_PUT, 1, (NNTI_buf_ops_t)(NNTI_PUT_SRC|NNTI_SEND_SRC), &src_mr);
+    NNTI_alloc(&trans_hdl, COALESCED_PUT, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    memset(NNTI_BUFFER_C_POINTER(&src_mr), 0x5A, COALESCED_PUT);
+
+    bad_target =target_mr;
+    bad_segment=target_mr.buffer_segments.NNTI_remote_addr_array_t_val[0];
+    bad_segment.NNTI_remote_addr_t_u.ib.key ^= 0x5A5A;
+    bad_target.buffer_segments.NNTI_remote_addr_array_t_val=&bad_segment;
+
+    rc=NNTI_put_coalesced(&src_mr, 0, COALESCED_PUT, &bad_target, 0, &wr[0]);
+    if (rc == NNTI_OK) rc=NNTI_send(&server_hdl, &src_mr, NULL, &wr[1]);
+    for (int i=0;i<2;i++) {
+        memset(&status[i], 0, sizeof(NNTI_status_t));
+        status[i].result=NNTI_EINVAL;
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) {
+        rc=NNTI_waitall(wr_list, 2, 5000, status_list);
+        if ((rc == NNTI_OK) || (rc == NNTI_ETIMEDOUT) || (status[0].result == NNTI_OK)) {
+            std::cout << "coalesced put to a bad buffer: rc=" << rc << " result=" << status[0].result << std::endl;
+            success=false;
+        }
+        if (status[1].result != NNTI_OK) {
+            std::cout << "send after a failed batch wasn't finished: result=" << status[1].result << std::endl;
+            success=false;
+        }
+    } else {
+        std::cout << "coalesced put to a bad buffer failed to start: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_create_work_request(&queue_mr, &queue_wr);
+    NNTI_wait(&queue_wr, 5000, &queue_status);
+    NNTI_destroy_work_request(&queue_wr);
+
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    char credits[16];
+
+    sprintf(credits, "%d", COALESCE_CREDITS);
+    setenv("TRIOS_NNTI_REQUEST_CREDITS", credits, 1);
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_coalescing();
+    check_coalesce_retry();
+    check_coalesce_failure();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
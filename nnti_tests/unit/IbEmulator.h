@@ -0,0 +1,132 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbEmulator.h
+ *
+ *  Setup shared by the tests that run the InfiniBand transport against
+ *  the in-process verbs emulator.  The emulator only connects a process
+ *  to itself, so each test connects to its own URL and keeps a request
+ *  queue for whatever it sends itself.
+ */
+
+#ifndef IBEMULATOR_H_
+#define IBEMULATOR_H_
+
+#include "Trios_config.h"
+#include "Trios_nnti.h"
+
+#include "Trios_logger.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+#include "nnti_ib.h"
+#include "nnti_ib_emu.h"
+
+#include "SelfConnect.h"
+
+#define IB_EMULATOR_QUEUE_SLOTS 10
+
+static NNTI_transport_t trans_hdl;
+static NNTI_peer_t      server_hdl;
+static NNTI_buffer_t    queue_mr;
+
+static bool success=true;
+
+/* TRIOS_NNTI_USE_RDMA_TARGET_ACK is set */
+static bool target_ack=false;
+
+/*
+ * Initialize the IB transport on the emulator and connect it to itself.
+ * Set any other TRIOS_NNTI_* variables before calling this.
+ */
+static NNTI_result_t ib_emulator_start(void)
+{
+    NNTI_result_t rc;
+
+    logger_init(LOG_ERROR, NULL);
+
+    setenv("TRIOS_NNTI_IB_EMULATE_VERBS", "TRUE", 1);
+
+    char *env_str=getenv("TRIOS_NNTI_USE_RDMA_TARGET_ACK");
+    target_ack=((env_str != NULL) && ((!strcasecmp(env_str, "TRUE")) || (!strcmp(env_str, "1"))));
+
+    rc=NNTI_init(NNTI_TRANSPORT_IB, NULL, &trans_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_init() failed: rc=" << rc << std::endl;
+        return(rc);
+    }
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, IB_EMULATOR_QUEUE_SLOTS, NNTI_RECV_QUEUE, &queue_mr);
+
+    rc=self_connect(&trans_hdl, 5000, &server_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "connect failed: rc=" << rc << std::endl;
+        NNTI_free(&queue_mr);
+        NNTI_fini(&trans_hdl);
+    }
+
+    return(rc);
+}
+
+static int ib_emulator_finish(void)
+{
+    NNTI_free(&queue_mr);
+
+    NNTI_fini(&trans_hdl);
+
+    if (success)
+        std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+    else
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+    return (success ? 0 : 1 );
+}
+
+#endif
+
+#endif /* IBEMULATOR_H_ */
@@ -0,0 +1,255 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbImplicitTest.cpp
+ *
+ *  Implicit sends, puts and gets over the InfiniBand transport with the
+ *  verbs emulator, completed by a flush.  A flush reports the first
+ *  implicit operation that failed.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define RDMA_SIZE 8192
+
+/* above TRIOS_NNTI_RDMA_CHUNK_THRESHOLD */
+#define CHUNKED_RDMA_SIZE 65536
+
+/* implicit puts in flight before a flush.  more than the work request pool starts with. */
+#define IMPLICIT_PUTS 16
+
+/* implicit sends in flight before a flush.  the request queue has room for this many. */
+#define IMPLICIT_SENDS 4
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * Implicit puts and gets have no work request.  A flush waits for all of
+ * them to the peer, after which the data is in place and every work
+ * request the transport used has gone back to its pool.  With target
+ * ACKs, the target counts them instead of raising events.
+ */
+static void check_implicit(void)
+{
+    NNTI_buffer_t       src_mr, target_mr, dst_mr;
+    NNTI_counter_t      counter;
+    nnti_wr_pool_stats  rdma_before, sendrecv_before, rdma_after, sendrecv_after;
+    NNTI_result_t       rc=NNTI_OK;
+    uint64_t            value=0;
+
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<CHUNKED_RDMA_SIZE;i++) {
+        src[i]=(char)(11*i + 5);
+    }
+    memset(target, 0, CHUNKED_RDMA_SIZE);
+    memset(dst, 0, CHUNKED_RDMA_SIZE);
+
+    if (target_ack) {
+        NNTI_counter_create(&trans_hdl, &counter);
+        NNTI_counter_bind(&target_mr, &counter);
+    }
+
+    bool pool=(NNTI_ib_get_wr_pool_stats(&rdma_before, &sendrecv_before) == NNTI_OK);
+
+    for (int i=0;(i<IMPLICIT_PUTS) && (rc == NNTI_OK);i++) {
+        rc=NNTI_put_implicit(&src_mr, i*RDMA_SIZE/IMPLICIT_PUTS, RDMA_SIZE/IMPLICIT_PUTS, &target_mr, i*RDMA_SIZE/IMPLICIT_PUTS);
+    }
+    // big enough to go out in chunks
+    if (rc == NNTI_OK) rc=NNTI_put_implicit(&src_mr, 0, CHUNKED_RDMA_SIZE, &target_mr, 0);
+    if (rc == NNTI_OK) rc=NNTI_flush(&server_hdl, 5000);
+    if ((rc != NNTI_OK) || memcmp(src, target, CHUNKED_RDMA_SIZE)) {
+        std::cout << "implicit puts: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_get_implicit(&target_mr, 0, CHUNKED_RDMA_SIZE, &dst_mr, 0);
+    if (rc == NNTI_OK) rc=NNTI_flush_all(&trans_hdl, 5000);
+    if ((rc != NNTI_OK) || memcmp(src, dst, CHUNKED_RDMA_SIZE)) {
+        std::cout << "implicit get: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_flush(&server_hdl, 0);
+    if (rc != NNTI_OK) {
+        std::cout << "flush with nothing outstanding: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    if (pool) {
+        NNTI_ib_get_wr_pool_stats(&rdma_after, &sendrecv_after);
+        if ((rdma_after.in_use != rdma_before.in_use) || (sendrecv_after.in_use != sendrecv_before.in_use)) {
+            std::cout << "implicit operations leaked work requests: rdma " << rdma_before.in_use << "->" << rdma_after.in_use
+                      << " sendrecv " << sendrecv_before.in_use << "->" << sendrecv_after.in_use << std::endl;
+            success=false;
+        }
+    }
+
+    if (target_ack) {
+        rc=NNTI_counter_wait(&counter, IMPLICIT_PUTS+2, 5000, &value);
+        if ((rc != NNTI_OK) || (value != IMPLICIT_PUTS+2)) {
+            std::cout << "implicit operations at the target: rc=" << rc << " value=" << value << std::endl;
+            success=false;
+        }
+        NNTI_counter_bind(&target_mr, NULL);
+        NNTI_counter_destroy(&counter);
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+/*
+ * Implicit sends land in the request queue like ordinary ones once the
+ * flush returns.
+ */
+static void check_implicit_send(void)
+{
+    NNTI_buffer_t       send_mr;
+    NNTI_work_request_t queue_wr;
+    NNTI_status_t       queue_status;
+    NNTI_result_t       rc=NNTI_OK;
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+    *(uint32_t *)NNTI_BUFFER_C_POINTER(&send_mr)=0xFEEDFACE;
+
+    for (int i=0;(i<IMPLICIT_SENDS) && (rc == NNTI_OK);i++) {
+        rc=NNTI_send_implicit(&server_hdl, &send_mr, NULL);
+    }
+    if (rc == NNTI_OK) rc=NNTI_flush(&server_hdl, 5000);
+    if (rc != NNTI_OK) {
+        std::cout << "implicit sends: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    for (int i=0;i<IMPLICIT_SENDS;i++) {
+        NNTI_create_work_request(&queue_mr, &queue_wr);
+        rc=NNTI_wait(&queue_wr, 5000, &queue_status);
+        NNTI_destroy_work_request(&queue_wr);
+        if (rc != NNTI_OK) {
+            std::cout << "implicit send " << i << " never arrived: rc=" << rc << std::endl;
+            success=false;
+            break;
+        } else if (*(uint32_t *)(queue_status.start + queue_status.offset) != 0xFEEDFACE) {
+            std::cout << "implicit send " << i << " is corrupt" << std::endl;
+            success=false;
+        }
+    }
+
+    NNTI_free(&send_mr);
+}
+
+/*
+ * An implicit put with a bad rkey completes in error.  The flush still
+ * waits for it, then reports the failure once.  The failure takes the
+ * connection down, so this runs last.
+ */
+static void check_implicit_failure(void)
+{
+    NNTI_buffer_t     src_mr, target_mr, bad_target;
+    NNTI_remote_addr_t bad_segment;
+    NNTI_result_t     rc;
+
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_PUT_DST, &target_mr);
+
+    bad_target =target_mr;
+    bad_segment=target_mr.buffer_segments.NNTI_remote_addr_array_t_val[0];
+    bad_segment.NNTI_remote_addr_t_u.ib.key ^= 0x5A5A;
+    bad_target.buffer_segments.NNTI_remote_addr_array_t_val=&bad_segment;
+
+    rc=NNTI_put_implicit(&src_mr, 0, RDMA_SIZE, &bad_target, 0);
+    if (rc == NNTI_OK) rc=NNTI_flush(&server_hdl, 5000);
+    if ((rc == NNTI_OK) || (rc == NNTI_ETIMEDOUT)) {
+        std::cout << "flush after a failed implicit put: rc=" << rc << std::endl;
+        success=false;
+    }
+    rc=NNTI_flush(&server_hdl, 0);
+    if (rc != NNTI_OK) {
+        std::cout << "second flush after a failed implicit put: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_USE_WR_POOL", "TRUE", 0);
+    setenv("TRIOS_NNTI_WR_POOL_INITIAL_SIZE", "4", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD", "16384", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_SIZE", "4096", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW", "2", 1);
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_implicit();
+    check_implicit_send();
+    check_implicit_failure();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,252 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbRawTest.cpp
+ *
+ *  Sends, puts and gets from unregistered memory over the InfiniBand
+ *  transport with the verbs emulator.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define RDMA_SIZE 8192
+
+/* raw transfers on both sides of the bounce buffer size */
+#define RAW_SMALL 100
+#define RAW_LARGE (2*RDMA_SIZE)
+#define RAW_BURST 8
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * Raw transfers from unregistered memory.  Small ones go through a bounce
+ * buffer, so the caller may reuse its memory as soon as the call returns.
+ * Large ones are registered and the registration is cached.
+ */
+static void check_raw_operations(void)
+{
+    NNTI_buffer_t        target_mr;
+    NNTI_work_request_t  wr[RAW_BURST];
+    NNTI_work_request_t *wr_list[RAW_BURST];
+    NNTI_status_t       *status_list[RAW_BURST];
+    NNTI_status_t        status[RAW_BURST];
+    NNTI_work_request_t  header_wr;
+    NNTI_status_t        header_status;
+    NNTI_result_t        rc=NNTI_OK;
+    char                 small[RAW_SMALL];
+    char                *large=(char *)malloc(RAW_LARGE);
+    char                *back =(char *)malloc(RAW_LARGE);
+
+    NNTI_alloc(&trans_hdl, 2*RAW_LARGE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    memset(target, 0, 2*RAW_LARGE);
+
+    /* a small request through the queue */
+    strcpy(small, "raw request");
+    rc=NNTI_send_raw(&trans_hdl, &server_hdl, small, strlen(small)+1, NULL, &wr[0]);
+    memset(small, 0, RAW_SMALL);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+    if (rc == NNTI_OK) {
+        NNTI_create_work_request(&queue_mr, &header_wr);
+        rc=NNTI_wait(&header_wr, 5000, &header_status);
+        if ((rc == NNTI_OK) && strcmp((char *)header_status.start+header_status.offset, "raw request")) {
+            std::cout << "raw request is corrupt" << std::endl;
+            success=false;
+        }
+        NNTI_destroy_work_request(&header_wr);
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "raw send failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    /* puts and gets on both paths, twice so the second large one hits the cache */
+    for (int pass=0;(rc == NNTI_OK) && (pass<2);pass++) {
+        for (int i=0;i<RAW_SMALL;i++) {
+            small[i]=(char)(i+pass);
+        }
+        for (int i=0;i<RAW_LARGE;i++) {
+            large[i]=(char)(3*i+pass);
+        }
+        rc=NNTI_put_from(&trans_hdl, small, RAW_SMALL, &target_mr, 0, &wr[0]);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        if (rc == NNTI_OK) rc=NNTI_put_from(&trans_hdl, large, RAW_LARGE, &target_mr, RAW_LARGE, &wr[0]);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        if ((rc != NNTI_OK) || memcmp(small, target, RAW_SMALL) || memcmp(large, target+RAW_LARGE, RAW_LARGE)) {
+            std::cout << "raw put failed: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+
+        memset(back, 0, RAW_LARGE);
+        rc=NNTI_get_into(&trans_hdl, &target_mr, 0, RAW_SMALL, back, &wr[0]);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        if ((rc != NNTI_OK) || memcmp(small, back, RAW_SMALL)) {
+            std::cout << "raw get failed: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+        rc=NNTI_get_into(&trans_hdl, &target_mr, RAW_LARGE, RAW_LARGE, back, &wr[0]);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        if ((rc != NNTI_OK) || memcmp(large, back, RAW_LARGE)) {
+            std::cout << "raw large get failed: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+    }
+
+    /* several in flight at once, each with its own bounce buffer */
+    for (int i=0;(rc == NNTI_OK) && (i<RAW_BURST);i++) {
+        rc=NNTI_put_from(&trans_hdl, small, RAW_SMALL, &target_mr, i*RAW_SMALL, &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, RAW_BURST, 5000, status_list);
+    for (int i=0;(rc == NNTI_OK) && (i<RAW_BURST);i++) {
+        if (memcmp(small, target+i*RAW_SMALL, RAW_SMALL)) {
+            std::cout << "raw put " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "raw put burst failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_raw_cache_flush(&trans_hdl);
+
+    NNTI_free(&target_mr);
+    free(back);
+    free(large);
+}
+
+/*
+ * Gets from a buffer with a bad rkey fail.  Each failure gives its slot
+ * back without copying the bounce buffer out, so more gets than there are
+ * slots still start.  The failure takes the connection down, so this runs
+ * last.
+ */
+static void check_raw_failure(void)
+{
+    NNTI_buffer_t        target_mr, bad_target;
+    NNTI_remote_addr_t   bad_segment;
+    NNTI_work_request_t  wr[2];
+    NNTI_work_request_t *wr_list[2];
+    NNTI_status_t        status[2];
+    NNTI_status_t       *status_list[2];
+    NNTI_result_t        rc=NNTI_OK;
+    char                 back[RAW_SMALL];
+
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+
+    bad_target =target_mr;
+    bad_segment=target_mr.buffer_segments.NNTI_remote_addr_array_t_val[0];
+    bad_segment.NNTI_remote_addr_t_u.ib.key ^= 0x5A5A;
+    bad_target.buffer_segments.NNTI_remote_addr_array_t_val=&bad_segment;
+
+    for (int i=0;i<NNTI_RAW_MAX+2;i++) {
+        memset(back, 0x5A, RAW_SMALL);
+        rc=NNTI_get_into(&trans_hdl, &bad_target, 0, RAW_SMALL, back, &wr[0]);
+        if (rc != NNTI_OK) {
+            std::cout << "raw get " << i << " after failed gets: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+        rc=NNTI_wait(&wr[0], 5000, &status[0]);
+        if (((rc == NNTI_OK) && (status[0].result == NNTI_OK)) || (rc == NNTI_ETIMEDOUT) || (back[0] != 0x5A)) {
+            std::cout << "raw get " << i << " from a bad buffer: rc=" << rc << " result=" << status[0].result << std::endl;
+            success=false;
+        }
+    }
+
+    /* a failure in a waitall still finishes the other work request */
+    for (int i=0;i<NNTI_RAW_MAX;i++) {
+        rc=NNTI_get_into(&trans_hdl, &bad_target, 0, RAW_SMALL, back, &wr[0]);
+        if (rc == NNTI_OK) rc=NNTI_get_into(&trans_hdl, &bad_target, 0, RAW_SMALL, back, &wr[1]);
+        if (rc != NNTI_OK) {
+            std::cout << "raw get pair " << i << " after failed waitalls: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+        wr_list[0]=&wr[0]; status_list[0]=&status[0];
+        wr_list[1]=&wr[1]; status_list[1]=&status[1];
+        rc=NNTI_waitall(wr_list, 2, 5000, status_list);
+        if ((rc == NNTI_OK) || (rc == NNTI_ETIMEDOUT)) {
+            std::cout << "raw get pair " << i << " from a bad buffer: rc=" << rc << std::endl;
+            success=false;
+        }
+    }
+
+    NNTI_free(&target_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    /* nothing waits on the target buffer, so target ACKs would use up the receives */
+    unsetenv("TRIOS_NNTI_USE_RDMA_TARGET_ACK");
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_raw_operations();
+    check_raw_failure();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,315 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbRdmaTest.cpp
+ *
+ *  Puts and gets over the InfiniBand transport with the verbs emulator.
+ *  Large transfers go out in chunks and vectored transfers gather and
+ *  scatter their regions.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define RDMA_SIZE 8192
+
+/* above TRIOS_NNTI_RDMA_CHUNK_THRESHOLD, so these go out in CHUNK_COUNT chunks, CHUNK_WINDOW at a time */
+#define CHUNKED_RDMA_SIZE 65536
+#define CHUNK_SIZE        4096
+#define CHUNK_COUNT       (CHUNKED_RDMA_SIZE/CHUNK_SIZE)
+#define CHUNK_WINDOW      2
+
+/* vectored transfers of VECTOR_COUNT regions, strided on one side and packed on the other */
+#define VECTOR_COUNT  200
+#define VECTOR_REGION 100
+#define VECTOR_STRIDE 256
+#define VECTOR_SGES   32
+#define VECTOR_WINDOW 64
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+static void check_rdma(void)
+{
+    NNTI_buffer_t       src_mr, target_mr, dst_mr;
+    NNTI_work_request_t wr;
+    NNTI_status_t       status;
+    NNTI_result_t       rc;
+
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<RDMA_SIZE;i++) {
+        src[i]=(char)i;
+    }
+    memset(target, 0, RDMA_SIZE);
+    memset(dst, 0, RDMA_SIZE);
+
+    rc=NNTI_put(&src_mr, 0, RDMA_SIZE, &target_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || memcmp(src, target, RDMA_SIZE)) {
+        std::cout << "put failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_get(&target_mr, 0, RDMA_SIZE, &dst_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || memcmp(src, dst, RDMA_SIZE)) {
+        std::cout << "get failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+/*
+ * A put and a get above the chunk threshold should arrive intact.  The first
+ * window goes out with one ibv_post_send() and each later chunk is posted on
+ * its own as an earlier one completes.
+ */
+static void check_chunked_rdma(void)
+{
+    NNTI_buffer_t        src_mr, target_mr, dst_mr;
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    struct ibv_emu_stats before, after;
+    NNTI_result_t        rc;
+
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<CHUNKED_RDMA_SIZE;i++) {
+        src[i]=(char)(i/CHUNK_SIZE + i);
+    }
+    memset(target, 0, CHUNKED_RDMA_SIZE);
+    memset(dst, 0, CHUNKED_RDMA_SIZE);
+
+    ibv_emu_get_stats(&before);
+    rc=NNTI_put(&src_mr, 0, CHUNKED_RDMA_SIZE, &target_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if ((rc != NNTI_OK) || memcmp(src, target, CHUNKED_RDMA_SIZE)) {
+        std::cout << "chunked put failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    if (after.post_send_calls - before.post_send_calls != CHUNK_COUNT-CHUNK_WINDOW+1) {
+        std::cout << "chunked put was not pipelined: post_send calls=" << (after.post_send_calls - before.post_send_calls) << std::endl;
+        success=false;
+    }
+
+    ibv_emu_get_stats(&before);
+    rc=NNTI_get(&target_mr, 0, CHUNKED_RDMA_SIZE, &dst_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if ((rc != NNTI_OK) || memcmp(src, dst, CHUNKED_RDMA_SIZE)) {
+        std::cout << "chunked get failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    if (after.post_send_calls - before.post_send_calls != CHUNK_COUNT-CHUNK_WINDOW+1) {
+        std::cout << "chunked get was not pipelined: post_send calls=" << (after.post_send_calls - before.post_send_calls) << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+/*
+ * Strided regions bound for one packed remote range should be gathered
+ * into VECTOR_SGES SGEs per work request, and a packed range read into
+ * strided regions should be scattered the same way.  Strided remote
+ * regions need a work request each, which go out VECTOR_WINDOW at a time.
+ */
+static void check_vector_rdma(void)
+{
+    NNTI_buffer_t        src_mr, target_mr, dst_mr;
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    NNTI_iovec_t         iov[VECTOR_COUNT];
+    struct ibv_emu_stats before, after;
+    NNTI_result_t        rc;
+
+    uint64_t             ack_wrs=target_ack ? 1 : 0;
+
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<CHUNKED_RDMA_SIZE;i++) {
+        src[i]=(char)(i/VECTOR_STRIDE + 5*i);
+    }
+    memset(target, 0, CHUNKED_RDMA_SIZE);
+    memset(dst, 0, CHUNKED_RDMA_SIZE);
+
+    /* strided source, packed target */
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        iov[i].src_offset =i*VECTOR_STRIDE;
+        iov[i].dest_offset=i*VECTOR_REGION;
+        iov[i].length     =VECTOR_REGION;
+    }
+    ibv_emu_get_stats(&before);
+    rc=NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if ((rc != NNTI_OK) ||
+        (status.offset != 0) || (status.length != (VECTOR_COUNT-1)*VECTOR_STRIDE+VECTOR_REGION)) {
+        std::cout << "gathering putv failed: rc=" << rc << " offset=" << status.offset << " length=" << status.length << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_STRIDE, target+i*VECTOR_REGION, VECTOR_REGION)) {
+            std::cout << "gathering putv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+    if (after.send_wrs - before.send_wrs != (VECTOR_COUNT+VECTOR_SGES-1)/VECTOR_SGES + ack_wrs) {
+        std::cout << "gathering putv used " << (after.send_wrs - before.send_wrs) << " work requests" << std::endl;
+        success=false;
+    }
+
+    /* packed target, strided destination */
+    ibv_emu_get_stats(&before);
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        iov[i].src_offset =i*VECTOR_REGION;
+        iov[i].dest_offset=i*VECTOR_STRIDE;
+    }
+    rc=NNTI_getv(&target_mr, &dst_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if (rc != NNTI_OK) {
+        std::cout << "scattering getv failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_STRIDE, dst+i*VECTOR_STRIDE, VECTOR_REGION)) {
+            std::cout << "scattering getv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+    if (after.send_wrs - before.send_wrs != (VECTOR_COUNT+VECTOR_SGES-1)/VECTOR_SGES + ack_wrs) {
+        std::cout << "scattering getv used " << (after.send_wrs - before.send_wrs) << " work requests" << std::endl;
+        success=false;
+    }
+
+    /* packed source, strided target */
+    memset(target, 0, CHUNKED_RDMA_SIZE);
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        iov[i].src_offset =i*VECTOR_REGION;
+        iov[i].dest_offset=i*VECTOR_STRIDE;
+    }
+    ibv_emu_get_stats(&before);
+    rc=NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if (rc != NNTI_OK) {
+        std::cout << "strided putv failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_REGION, target+i*VECTOR_STRIDE, VECTOR_REGION)) {
+            std::cout << "strided putv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+    if (after.post_send_calls - before.post_send_calls != VECTOR_COUNT-VECTOR_WINDOW+1) {
+        std::cout << "strided putv was not windowed: post_send calls=" << (after.post_send_calls - before.post_send_calls) << std::endl;
+        success=false;
+    }
+
+    iov[1].length=CHUNKED_RDMA_SIZE;
+    if (NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr) != NNTI_EINVAL) {
+        std::cout << "putv accepted a region past the end of the buffer" << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD", "16384", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_SIZE", "4096", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW", "2", 1);
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_rdma();
+    check_chunked_rdma();
+    check_vector_rdma();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
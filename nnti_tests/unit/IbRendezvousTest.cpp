@@ -0,0 +1,248 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbRendezvousTest.cpp
+ *
+ *  Requests larger than a queue slot over the InfiniBand transport with
+ *  the verbs emulator.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define RDMA_SIZE 8192
+
+/* requests too large for a queue slot, sent by rendezvous two at a time */
+#define RENDEZVOUS_SIZE  (4*RDMA_SIZE)
+#define RENDEZVOUS_COUNT 2
+/* a message that fits in a queue slot */
+#define SMALL_SIZE 64
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * Rendezvous sends of requests larger than a queue slot only queue a
+ * header.  The receiver pulls each one into its own buffer and that
+ * completes the send.
+ */
+static void check_rendezvous(void)
+{
+    NNTI_buffer_t        msg_mr[RENDEZVOUS_COUNT], dest_mr;
+    NNTI_work_request_t  wr[RENDEZVOUS_COUNT];
+    NNTI_work_request_t *wr_list[RENDEZVOUS_COUNT];
+    NNTI_status_t       *status_list[RENDEZVOUS_COUNT];
+    NNTI_status_t        status[RENDEZVOUS_COUNT];
+    NNTI_work_request_t  header_wr, pull_wr;
+    NNTI_status_t        header_status, pull_status;
+    NNTI_result_t        rc=NNTI_OK;
+    uint64_t             length=0;
+
+    NNTI_alloc(&trans_hdl, RENDEZVOUS_COUNT*RENDEZVOUS_SIZE, 1, NNTI_GET_DST, &dest_mr);
+    for (int i=0;i<RENDEZVOUS_COUNT;i++) {
+        NNTI_alloc(&trans_hdl, RENDEZVOUS_SIZE, 1, NNTI_GET_SRC, &msg_mr[i]);
+        memset(NNTI_BUFFER_C_POINTER(&msg_mr[i]), 0x30+i, RENDEZVOUS_SIZE);
+        if (rc == NNTI_OK) rc=NNTI_rendezvous_send(&server_hdl, &msg_mr[i], &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+
+    for (int i=0;(rc == NNTI_OK) && (i<RENDEZVOUS_COUNT);i++) {
+        NNTI_create_work_request(&queue_mr, &header_wr);
+        rc=NNTI_wait(&header_wr, 5000, &header_status);
+        if ((rc == NNTI_OK) && ((NNTI_rendezvous_length(&header_status, &length) != NNTI_OK) || (length != RENDEZVOUS_SIZE))) {
+            std::cout << "rendezvous header is corrupt: length=" << length << std::endl;
+            success=false;
+        }
+        if (rc == NNTI_OK) rc=NNTI_rendezvous_recv(&header_status, &dest_mr, i*RENDEZVOUS_SIZE, &pull_wr);
+        NNTI_destroy_work_request(&header_wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&pull_wr, 5000, &pull_status);
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, RENDEZVOUS_COUNT, 5000, status_list);
+
+    if (rc != NNTI_OK) {
+        std::cout << "rendezvous failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;(rc == NNTI_OK) && (i<RENDEZVOUS_COUNT);i++) {
+        char *p=NNTI_BUFFER_C_POINTER(&dest_mr) + i*RENDEZVOUS_SIZE;
+        if ((p[0] != 0x30+i) || (p[RENDEZVOUS_SIZE-1] != 0x30+i) || (status[i].length != RENDEZVOUS_SIZE)) {
+            std::cout << "rendezvous " << i << " is corrupt: status length=" << status[i].length << std::endl;
+            success=false;
+        }
+    }
+
+    for (int i=0;i<RENDEZVOUS_COUNT;i++) {
+        NNTI_free(&msg_mr[i]);
+    }
+    NNTI_free(&dest_mr);
+}
+
+/*
+ * A send canceled before the peer pulls it fails its work request.  The
+ * slot goes back to the table, so more sends than there are slots still
+ * start.  The peer drops the headers unread.
+ */
+static void check_rendezvous_cancel(void)
+{
+    NNTI_buffer_t       msg_mr;
+    NNTI_work_request_t wr, header_wr;
+    NNTI_status_t       status, header_status;
+    NNTI_result_t       rc=NNTI_OK;
+
+    NNTI_alloc(&trans_hdl, RENDEZVOUS_SIZE, 1, NNTI_GET_SRC, &msg_mr);
+
+    for (int i=0;i<NNTI_RENDEZVOUS_MAX+2;i++) {
+        rc=NNTI_rendezvous_send(&server_hdl, &msg_mr, &wr);
+        if (rc != NNTI_OK) {
+            std::cout << "rendezvous send " << i << " after canceled sends: rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+        NNTI_cancel(&wr);
+        rc=NNTI_wait(&wr, 5000, &status);
+        if ((rc != NNTI_ECANCELED) || (status.result != NNTI_ECANCELED)) {
+            std::cout << "canceled rendezvous send " << i << ": rc=" << rc << " result=" << status.result << std::endl;
+            success=false;
+        }
+
+        NNTI_create_work_request(&queue_mr, &header_wr);
+        rc=NNTI_wait(&header_wr, 5000, &header_status);
+        NNTI_destroy_work_request(&header_wr);
+        if (rc != NNTI_OK) {
+            std::cout << "header of canceled rendezvous send " << i << ": rc=" << rc << std::endl;
+            success=false;
+            break;
+        }
+    }
+
+    NNTI_free(&msg_mr);
+}
+
+/*
+ * Rendezvous is only used when asked for.  A small message goes by
+ * rendezvous with NNTI_rendezvous_send() and as itself with NNTI_send(),
+ * and a buffer the peer can't read is refused.
+ */
+static void check_rendezvous_explicit(void)
+{
+    NNTI_buffer_t       msg_mr, send_mr, dest_mr;
+    NNTI_work_request_t wr, header_wr, pull_wr;
+    NNTI_status_t       status, header_status, pull_status;
+    NNTI_result_t       rc=NNTI_OK;
+    uint64_t            length=0;
+
+    NNTI_alloc(&trans_hdl, SMALL_SIZE, 1, (NNTI_buf_ops_t)(NNTI_SEND_SRC|NNTI_GET_SRC), &msg_mr);
+    NNTI_alloc(&trans_hdl, SMALL_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+    NNTI_alloc(&trans_hdl, SMALL_SIZE, 1, NNTI_GET_DST, &dest_mr);
+    memset(NNTI_BUFFER_C_POINTER(&msg_mr), 0x41, SMALL_SIZE);
+
+    for (int i=0;(rc == NNTI_OK) && (i<2);i++) {
+        if (i == 0) {
+            rc=NNTI_rendezvous_send(&server_hdl, &msg_mr, &wr);
+        } else {
+            rc=NNTI_send(&server_hdl, &msg_mr, NULL, &wr);
+        }
+        if (rc == NNTI_OK) {
+            NNTI_create_work_request(&queue_mr, &header_wr);
+            rc=NNTI_wait(&header_wr, 5000, &header_status);
+            NNTI_destroy_work_request(&header_wr);
+        }
+        if (rc != NNTI_OK) {
+            break;
+        }
+        if (NNTI_rendezvous_length(&header_status, &length) != ((i == 0) ? NNTI_OK : NNTI_ENOENT)) {
+            std::cout << "send " << i << " went by the wrong protocol" << std::endl;
+            success=false;
+        }
+        if (i == 0) {
+            rc=NNTI_rendezvous_recv(&header_status, &dest_mr, 0, &pull_wr);
+            if (rc == NNTI_OK) rc=NNTI_wait(&pull_wr, 5000, &pull_status);
+            if ((rc == NNTI_OK) && (NNTI_BUFFER_C_POINTER(&dest_mr)[SMALL_SIZE-1] != 0x41)) {
+                std::cout << "small rendezvous is corrupt" << std::endl;
+                success=false;
+            }
+        }
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "explicit rendezvous failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    if (NNTI_rendezvous_send(&server_hdl, &send_mr, &wr) != NNTI_EINVAL) {
+        std::cout << "rendezvous from a buffer the peer can't read wasn't refused" << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&dest_mr);
+    NNTI_free(&send_mr);
+    NNTI_free(&msg_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_rendezvous();
+    check_rendezvous_cancel();
+    check_rendezvous();
+    check_rendezvous_explicit();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
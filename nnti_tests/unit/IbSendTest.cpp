@@ -0,0 +1,169 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbSendTest.cpp
+ *
+ *  Sends requests to ourselves over the InfiniBand transport with the
+ *  verbs emulator.  Small requests should go out inline, several to a
+ *  doorbell.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define SMALL_SEND_SIZE  64
+/* the request queue has room for this many */
+#define SMALL_SEND_COUNT 8
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * One ordinary request should arrive intact.
+ */
+static void check_send(void)
+{
+    NNTI_buffer_t       send_mr;
+    NNTI_work_request_t send_wr, queue_wr;
+    NNTI_status_t       send_status, queue_status;
+    NNTI_result_t       rc;
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+    *(uint32_t *)NNTI_BUFFER_C_POINTER(&send_mr)=0xFEEDFACE;
+
+    rc=NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&send_wr, 5000, &send_status);
+    if (rc != NNTI_OK) {
+        std::cout << "send failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_create_work_request(&queue_mr, &queue_wr);
+    if (NNTI_wait(&queue_wr, 5000, &queue_status) != NNTI_OK) {
+        std::cout << "request never arrived" << std::endl;
+        success=false;
+    } else if (*(uint32_t *)(queue_status.start + queue_status.offset) != 0xFEEDFACE) {
+        std::cout << "request is corrupt" << std::endl;
+        success=false;
+    }
+    NNTI_destroy_work_request(&queue_wr);
+
+    NNTI_free(&send_mr);
+}
+
+/*
+ * With TRIOS_NNTI_IB_SEND_CHAIN=4 and TRIOS_NNTI_IB_SIGNAL_INTERVAL=4, eight
+ * small requests should go out inline in two doorbells with at most two of
+ * them signaled.
+ */
+static void check_small_sends(void)
+{
+    NNTI_buffer_t        small_mr;
+    NNTI_work_request_t  wr[SMALL_SEND_COUNT];
+    NNTI_work_request_t *wr_list[SMALL_SEND_COUNT];
+    NNTI_status_t       *status_list[SMALL_SEND_COUNT];
+    NNTI_status_t        status[SMALL_SEND_COUNT];
+    struct ibv_emu_stats before, after;
+    NNTI_result_t        rc=NNTI_OK;
+
+    NNTI_alloc(&trans_hdl, SMALL_SEND_SIZE, 1, NNTI_SEND_SRC, &small_mr);
+    memset(NNTI_BUFFER_C_POINTER(&small_mr), 0x5A, SMALL_SEND_SIZE);
+
+    ibv_emu_get_stats(&before);
+    for (int i=0;i<SMALL_SEND_COUNT;i++) {
+        if (rc == NNTI_OK) rc=NNTI_send(&server_hdl, &small_mr, NULL, &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, SMALL_SEND_COUNT, 5000, status_list);
+    ibv_emu_get_stats(&after);
+
+    if (rc != NNTI_OK) {
+        std::cout << "small sends failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    if ((after.send_wrs - before.send_wrs != SMALL_SEND_COUNT) ||
+        (after.inline_wrs - before.inline_wrs != SMALL_SEND_COUNT)) {
+        std::cout << "small sends were not inline: wrs=" << (after.send_wrs - before.send_wrs)
+                  << " inline=" << (after.inline_wrs - before.inline_wrs) << std::endl;
+        success=false;
+    }
+    if (after.post_send_calls - before.post_send_calls != SMALL_SEND_COUNT/4) {
+        std::cout << "small sends were not chained: post_send calls=" << (after.post_send_calls - before.post_send_calls) << std::endl;
+        success=false;
+    }
+    if (after.signaled_wrs - before.signaled_wrs > SMALL_SEND_COUNT/4) {
+        std::cout << "too many small sends were signaled: " << (after.signaled_wrs - before.signaled_wrs) << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&small_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_IB_SEND_CHAIN", "4", 1);
+    setenv("TRIOS_NNTI_IB_SIGNAL_INTERVAL", "4", 1);
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_send();
+    check_small_sends();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
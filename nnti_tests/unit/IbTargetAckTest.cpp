@@ -0,0 +1,344 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbTargetAckTest.cpp
+ *
+ *  Operations that need target ACKs over the InfiniBand transport with
+ *  the verbs emulator: put notifications, streaming puts and counters.
+ *  Without target ACKs they should be refused.
+ *
+ *  --target-ack and --no-target-ack set TRIOS_NNTI_USE_RDMA_TARGET_ACK.
+ *  Otherwise it is taken from the environment.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+#define RDMA_SIZE 8192
+
+#define CHUNKED_RDMA_SIZE 65536
+
+/* a streaming put whose last chunk is short */
+#define STREAM_SIZE       (CHUNKED_RDMA_SIZE-1000)
+#define STREAM_CHUNK_SIZE 8192
+#define STREAM_CHUNKS     ((STREAM_SIZE+STREAM_CHUNK_SIZE-1)/STREAM_CHUNK_SIZE)
+
+/* wider than the 32-bit IB immediate */
+#define NOTIFY_IMM 0x123456789abcdef0ULL
+
+/* puts counted at a target, plus one streaming put that counts once */
+#define COUNTED_PUTS 10
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * With target ACKs, the target of NNTI_put_notify() should find the
+ * immediate in its status and the put should cost the same work requests
+ * as a regular put.  A regular put that follows reports no immediate.
+ * Without target ACKs, notifications aren't supported.
+ */
+static void check_put_notify(void)
+{
+    NNTI_buffer_t        src_mr, target_mr;
+    NNTI_work_request_t  wr, target_wr;
+    NNTI_status_t        status, target_status;
+    struct ibv_emu_stats before, after;
+    NNTI_result_t        rc;
+
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, RDMA_SIZE, 1, NNTI_PUT_DST, &target_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    for (int i=0;i<RDMA_SIZE;i++) {
+        src[i]=(char)(7*i + 1);
+    }
+    memset(target, 0, RDMA_SIZE);
+
+    ibv_emu_get_stats(&before);
+    rc=NNTI_put_notify(&src_mr, 0, RDMA_SIZE/2, &target_mr, RDMA_SIZE/2, NOTIFY_IMM, &wr);
+    if (!target_ack) {
+        if (rc != NNTI_ENOTSUP) {
+            std::cout << "put notification without target ACKs: rc=" << rc << std::endl;
+            success=false;
+        }
+        NNTI_free(&target_mr);
+        NNTI_free(&src_mr);
+        return;
+    }
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    ibv_emu_get_stats(&after);
+    if (rc != NNTI_OK) {
+        std::cout << "put notification failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    if (after.send_wrs - before.send_wrs != 2) {
+        std::cout << "put notification used " << (after.send_wrs - before.send_wrs) << " work requests" << std::endl;
+        success=false;
+    }
+
+    NNTI_create_work_request(&target_mr, &target_wr);
+    rc=NNTI_wait(&target_wr, 5000, &target_status);
+    if ((rc != NNTI_OK) || (target_status.imm != NOTIFY_IMM) ||
+        (target_status.offset != RDMA_SIZE/2) || (target_status.length != RDMA_SIZE/2)) {
+        std::cout << "put notification target: rc=" << rc << " imm=0x" << std::hex << target_status.imm << std::dec
+                  << " offset=" << target_status.offset << " length=" << target_status.length << std::endl;
+        success=false;
+    } else if (memcmp(src, target+RDMA_SIZE/2, RDMA_SIZE/2)) {
+        std::cout << "put notification arrived before its data" << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_put(&src_mr, 0, RDMA_SIZE/2, &target_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc == NNTI_OK) rc=NNTI_wait(&target_wr, 5000, &target_status);
+    if ((rc != NNTI_OK) || (target_status.imm != 0)) {
+        std::cout << "put after the notification: rc=" << rc << " imm=0x" << std::hex << target_status.imm << std::dec << std::endl;
+        success=false;
+    }
+
+    NNTI_destroy_work_request(&target_wr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+/*
+ * With target ACKs, the target of a streaming put should see one event per
+ * chunk, in order, and the data of each chunk should be there when its
+ * event arrives.  A regular put to the same buffer afterward is one event
+ * again.  Without target ACKs, streaming isn't supported.
+ */
+static void check_streaming_put(void)
+{
+    NNTI_buffer_t       src_mr, target_mr;
+    NNTI_work_request_t wr, target_wr;
+    NNTI_status_t       status, target_status;
+    NNTI_result_t       rc;
+
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_RDMA_SIZE, 1, NNTI_PUT_DST, &target_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    for (int i=0;i<CHUNKED_RDMA_SIZE;i++) {
+        src[i]=(char)(i/STREAM_CHUNK_SIZE + 3*i);
+    }
+    memset(target, 0, CHUNKED_RDMA_SIZE);
+
+    rc=NNTI_put_stream(&src_mr, 0, STREAM_SIZE, &target_mr, 0, STREAM_CHUNK_SIZE, &wr);
+    if (!target_ack) {
+        if (rc != NNTI_ENOTSUP) {
+            std::cout << "streaming put without target ACKs: rc=" << rc << std::endl;
+            success=false;
+        }
+        NNTI_free(&target_mr);
+        NNTI_free(&src_mr);
+        return;
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "streaming put failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_create_work_request(&target_mr, &target_wr);
+    for (int i=0;(rc == NNTI_OK) && (i<STREAM_CHUNKS);i++) {
+        uint64_t offset=(uint64_t)i*STREAM_CHUNK_SIZE;
+        uint64_t length=(i<STREAM_CHUNKS-1) ? STREAM_CHUNK_SIZE : STREAM_SIZE-offset;
+
+        rc=NNTI_wait(&target_wr, 5000, &target_status);
+        if ((rc != NNTI_OK) || (target_status.offset != offset) || (target_status.length != length)) {
+            std::cout << "stream event " << i << ": rc=" << rc << " offset=" << target_status.offset
+                      << " length=" << target_status.length << " expected " << offset << "/" << length << std::endl;
+            success=false;
+        } else if (memcmp(src+offset, target+offset, length)) {
+            std::cout << "stream event " << i << " arrived before its data" << std::endl;
+            success=false;
+        }
+    }
+    rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) || (status.length != STREAM_SIZE)) {
+        std::cout << "streaming put didn't complete: rc=" << rc << " length=" << status.length << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_put(&src_mr, 0, RDMA_SIZE, &target_mr, RDMA_SIZE, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc == NNTI_OK) rc=NNTI_wait(&target_wr, 5000, &target_status);
+    if ((rc != NNTI_OK) || (target_status.offset != RDMA_SIZE) || (target_status.length != RDMA_SIZE)) {
+        std::cout << "put after the stream: rc=" << rc << " offset=" << target_status.offset
+                  << " length=" << target_status.length << std::endl;
+        success=false;
+    }
+
+    NNTI_destroy_work_request(&target_wr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+/*
+ * With target ACKs, puts to a buffer bound to a counter bump the counter
+ * instead of raising events.  A streaming put counts once.  After the
+ * buffer is unbound, a put raises an event again.  Without target ACKs,
+ * counters aren't supported.
+ */
+static void check_counters(void)
+{
+    NNTI_buffer_t        src_mr, target_mr;
+    NNTI_work_request_t  wr, target_wr;
+    NNTI_status_t        status, target_status;
+    NNTI_counter_t       counter;
+    NNTI_result_t        rc;
+    uint64_t             value=0;
+
+    NNTI_alloc(&trans_hdl, STREAM_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, STREAM_SIZE, 1, NNTI_PUT_DST, &target_mr);
+    NNTI_counter_create(&trans_hdl, &counter);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    for (int i=0;i<STREAM_SIZE;i++) {
+        src[i]=(char)(5*i + 3);
+    }
+    memset(target, 0, STREAM_SIZE);
+
+    rc=NNTI_counter_bind(&target_mr, &counter);
+    if (!target_ack) {
+        if (rc != NNTI_ENOTSUP) {
+            std::cout << "counter without target ACKs: rc=" << rc << std::endl;
+            success=false;
+        }
+        NNTI_counter_destroy(&counter);
+        NNTI_free(&target_mr);
+        NNTI_free(&src_mr);
+        return;
+    }
+    if (rc != NNTI_OK) {
+        std::cout << "counter bind failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    for (int i=0;i<COUNTED_PUTS;i++) {
+        rc=NNTI_put(&src_mr, i*RDMA_SIZE/COUNTED_PUTS, RDMA_SIZE/COUNTED_PUTS, &target_mr, i*RDMA_SIZE/COUNTED_PUTS, &wr);
+        if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+        if (rc != NNTI_OK) {
+            std::cout << "counted put " << i << " failed: rc=" << rc << std::endl;
+            success=false;
+        }
+    }
+    rc=NNTI_put_stream(&src_mr, 0, STREAM_SIZE, &target_mr, 0, STREAM_CHUNK_SIZE, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc != NNTI_OK) {
+        std::cout << "counted streaming put failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    rc=NNTI_counter_wait(&counter, COUNTED_PUTS+1, 5000, &value);
+    if ((rc != NNTI_OK) || (value != COUNTED_PUTS+1)) {
+        std::cout << "counter wait: rc=" << rc << " value=" << value << " expected=" << (COUNTED_PUTS+1) << std::endl;
+        success=false;
+    } else if (memcmp(src, target, STREAM_SIZE)) {
+        std::cout << "counter reached its threshold before the data landed" << std::endl;
+        success=false;
+    }
+
+    NNTI_create_work_request(&target_mr, &target_wr);
+    rc=NNTI_wait(&target_wr, 0, &target_status);
+    if (rc != NNTI_ETIMEDOUT) {
+        std::cout << "counted puts raised an event: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_counter_bind(&target_mr, NULL);
+    rc=NNTI_put(&src_mr, 0, RDMA_SIZE, &target_mr, 0, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc == NNTI_OK) rc=NNTI_wait(&target_wr, 5000, &target_status);
+    NNTI_counter_read(&counter, &value);
+    if ((rc != NNTI_OK) || (value != COUNTED_PUTS+1)) {
+        std::cout << "put after unbinding: rc=" << rc << " value=" << value << std::endl;
+        success=false;
+    }
+
+    NNTI_destroy_work_request(&target_wr);
+    NNTI_counter_destroy(&counter);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD", "16384", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_SIZE", "4096", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW", "2", 1);
+
+    for (int i=1;i<argc;i++) {
+        if (!strcmp(argv[i], "--target-ack")) {
+            setenv("TRIOS_NNTI_USE_RDMA_TARGET_ACK", "TRUE", 1);
+        } else if (!strcmp(argv[i], "--no-target-ack")) {
+            setenv("TRIOS_NNTI_USE_RDMA_TARGET_ACK", "FALSE", 1);
+        }
+    }
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_put_notify();
+    check_streaming_put();
+    check_counters();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
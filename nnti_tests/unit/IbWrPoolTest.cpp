@@ -0,0 +1,131 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * IbWrPoolTest.cpp
+ *
+ *  Grows the InfiniBand work request pool with a burst of atomics larger
+ *  than the pool and checks that every request goes back to it.
+ */
+
+#include "Trios_config.h"
+
+#include "IbEmulator.h"
+
+/* more atomics in flight than the work request pool starts with (4) */
+#define POOL_BURST 32
+
+#if defined(HAVE_TRIOS_INFINIBAND)
+
+/*
+ * A burst of atomics larger than the pool should grow it rather than fail,
+ * and every request should be back in the pool afterwards.
+ */
+static void check_wr_pool(void)
+{
+    NNTI_work_request_t  wr[POOL_BURST];
+    NNTI_work_request_t *wr_list[POOL_BURST];
+    NNTI_status_t       *status_list[POOL_BURST];
+    NNTI_status_t        status[POOL_BURST];
+    nnti_wr_pool_stats   before, after;
+    NNTI_result_t        rc=NNTI_OK;
+    int64_t              value=-1;
+
+    if (NNTI_ib_get_wr_pool_stats(NULL, &before) != NNTI_OK) {
+        std::cout << "work request pool is disabled.  skipping pool checks." << std::endl;
+        return;
+    }
+
+    for (int i=0;i<POOL_BURST;i++) {
+        if (rc == NNTI_OK) rc=NNTI_atomic_fop(&trans_hdl, &server_hdl, 3, 2, 1, NNTI_ATOMIC_FADD, &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, POOL_BURST, 5000, status_list);
+    NNTI_atomic_fop(&trans_hdl, &server_hdl, 3, 2, 0, NNTI_ATOMIC_FADD, &wr[0]);
+    NNTI_wait(&wr[0], 5000, &status[0]);
+    NNTI_atomic_read(&trans_hdl, 3, &value);
+
+    NNTI_ib_get_wr_pool_stats(NULL, &after);
+
+    if ((rc != NNTI_OK) || (value != POOL_BURST)) {
+        std::cout << "pool burst failed: rc=" << rc << " value=" << value << std::endl;
+        success=false;
+    }
+    if ((after.grows == 0) || (after.size < POOL_BURST) || (after.high_water < POOL_BURST)) {
+        std::cout << "pool didn't grow: size=" << after.size << " high_water=" << after.high_water
+                  << " grows=" << after.grows << std::endl;
+        success=false;
+    }
+    if ((after.in_use != before.in_use) || (after.overflows != 0)) {
+        std::cout << "pool leaked: in_use before=" << before.in_use << " after=" << after.in_use
+                  << " overflows=" << after.overflows << std::endl;
+        success=false;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_USE_WR_POOL", "TRUE", 0);
+    setenv("TRIOS_NNTI_WR_POOL_INITIAL_SIZE", "4", 1);
+
+    if (ib_emulator_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_wr_pool();
+
+    return(ib_emulator_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "InfiniBand is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,144 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * MpiChunkTest.cpp
+ *
+ *  Puts and gets above the chunk threshold over the MPI transport.  Two
+ *  chunked transfers to the same buffer are kept in flight at once, so
+ *  their chunks must not match each other's receives.
+ */
+
+#include "Trios_config.h"
+
+#include "MpiTransport.h"
+
+/* above TRIOS_NNTI_RDMA_CHUNK_THRESHOLD, so these go out in chunks, CHUNK_WINDOW at a time */
+#define CHUNKED_RDMA_SIZE 65536
+#define CHUNK_SIZE        4096
+#define CHUNK_WINDOW      2
+
+/* chunked transfers in flight to one buffer */
+#define CHUNKED_TRANSFERS 2
+
+#if defined(HAVE_TRIOS_MPI)
+
+static void check_chunked_rdma(void)
+{
+    NNTI_buffer_t        src_mr, target_mr, dst_mr;
+    NNTI_work_request_t  wr[CHUNKED_TRANSFERS];
+    NNTI_work_request_t *wr_list[CHUNKED_TRANSFERS];
+    NNTI_status_t       *status_list[CHUNKED_TRANSFERS];
+    NNTI_status_t        status[CHUNKED_TRANSFERS];
+    NNTI_result_t        rc=NNTI_OK;
+
+    NNTI_alloc(&trans_hdl, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE;i++) {
+        src[i]=(char)(i/CHUNK_SIZE + 7*i);
+    }
+    memset(target, 0, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE);
+    memset(dst, 0, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE);
+
+    for (int i=0;i<CHUNKED_TRANSFERS;i++) {
+        if (rc == NNTI_OK) rc=NNTI_put(&src_mr, i*CHUNKED_RDMA_SIZE, CHUNKED_RDMA_SIZE, &target_mr, i*CHUNKED_RDMA_SIZE, &wr[i]);
+        wr_list[i]    =&wr[i];
+        status_list[i]=&status[i];
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, CHUNKED_TRANSFERS, 5000, status_list);
+    if ((rc != NNTI_OK) || memcmp(src, target, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE)) {
+        std::cout << "chunked puts failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    for (int i=0;i<CHUNKED_TRANSFERS;i++) {
+        if (rc == NNTI_OK) rc=NNTI_get(&target_mr, i*CHUNKED_RDMA_SIZE, CHUNKED_RDMA_SIZE, &dst_mr, i*CHUNKED_RDMA_SIZE, &wr[i]);
+    }
+    if (rc == NNTI_OK) rc=NNTI_waitall(wr_list, CHUNKED_TRANSFERS, 5000, status_list);
+    if ((rc != NNTI_OK) || memcmp(src, dst, CHUNKED_TRANSFERS*CHUNKED_RDMA_SIZE)) {
+        std::cout << "chunked gets failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;(rc == NNTI_OK) && (i<CHUNKED_TRANSFERS);i++) {
+        if ((status[i].offset != (uint64_t)i*CHUNKED_RDMA_SIZE) || (status[i].length != CHUNKED_RDMA_SIZE)) {
+            std::cout << "chunked get " << i << ": offset=" << status[i].offset << " length=" << status[i].length << std::endl;
+            success=false;
+        }
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("TRIOS_NNTI_RDMA_CHUNK_THRESHOLD", "16384", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_SIZE", "4096", 1);
+    setenv("TRIOS_NNTI_RDMA_CHUNK_WINDOW", "2", 1);
+
+    if (mpi_transport_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_chunked_rdma();
+
+    return(mpi_transport_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "MPI is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,172 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * MpiVectorTest.cpp
+ *
+ *  Vectored puts and gets over the MPI transport.  The target receives
+ *  the region list without blocking progress, then moves the data.
+ */
+
+#include "Trios_config.h"
+
+#include "MpiTransport.h"
+
+/* vectored transfers of VECTOR_COUNT regions, strided on one side and packed on the other */
+#define VECTOR_COUNT  200
+#define VECTOR_REGION 100
+#define VECTOR_STRIDE 256
+#define VECTOR_SIZE   (VECTOR_COUNT*VECTOR_STRIDE)
+
+#if defined(HAVE_TRIOS_MPI)
+
+static void check_vector_rdma(void)
+{
+    NNTI_buffer_t        src_mr, target_mr, dst_mr;
+    NNTI_work_request_t  wr;
+    NNTI_status_t        status;
+    NNTI_iovec_t         iov[VECTOR_COUNT];
+    NNTI_result_t        rc;
+
+    NNTI_alloc(&trans_hdl, VECTOR_SIZE, 1, NNTI_PUT_SRC, &src_mr);
+    NNTI_alloc(&trans_hdl, VECTOR_SIZE, 1, (NNTI_buf_ops_t)(NNTI_PUT_DST|NNTI_GET_SRC), &target_mr);
+    NNTI_alloc(&trans_hdl, VECTOR_SIZE, 1, NNTI_GET_DST, &dst_mr);
+
+    char *src   =NNTI_BUFFER_C_POINTER(&src_mr);
+    char *target=NNTI_BUFFER_C_POINTER(&target_mr);
+    char *dst   =NNTI_BUFFER_C_POINTER(&dst_mr);
+    for (int i=0;i<VECTOR_SIZE;i++) {
+        src[i]=(char)(i/VECTOR_STRIDE + 5*i);
+    }
+    memset(target, 0, VECTOR_SIZE);
+    memset(dst, 0, VECTOR_SIZE);
+
+    /* strided source, packed target */
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        iov[i].src_offset =i*VECTOR_STRIDE;
+        iov[i].dest_offset=i*VECTOR_REGION;
+        iov[i].length     =VECTOR_REGION;
+    }
+    rc=NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if ((rc != NNTI_OK) ||
+        (status.offset != 0) || (status.length != (VECTOR_COUNT-1)*VECTOR_STRIDE+VECTOR_REGION)) {
+        std::cout << "gathering putv failed: rc=" << rc << " offset=" << status.offset << " length=" << status.length << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_STRIDE, target+i*VECTOR_REGION, VECTOR_REGION)) {
+            std::cout << "gathering putv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+
+    /* packed target, strided destination */
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        iov[i].src_offset =i*VECTOR_REGION;
+        iov[i].dest_offset=i*VECTOR_STRIDE;
+    }
+    rc=NNTI_getv(&target_mr, &dst_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc != NNTI_OK) {
+        std::cout << "scattering getv failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_STRIDE, dst+i*VECTOR_STRIDE, VECTOR_REGION)) {
+            std::cout << "scattering getv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+
+    /* packed source, strided target */
+    memset(target, 0, VECTOR_SIZE);
+    rc=NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr);
+    if (rc == NNTI_OK) rc=NNTI_wait(&wr, 5000, &status);
+    if (rc != NNTI_OK) {
+        std::cout << "strided putv failed: rc=" << rc << std::endl;
+        success=false;
+    }
+    for (int i=0;i<VECTOR_COUNT;i++) {
+        if (memcmp(src+i*VECTOR_REGION, target+i*VECTOR_STRIDE, VECTOR_REGION)) {
+            std::cout << "strided putv region " << i << " is corrupt" << std::endl;
+            success=false;
+            break;
+        }
+    }
+
+    iov[1].length=VECTOR_SIZE;
+    if (NNTI_putv(&src_mr, &target_mr, iov, VECTOR_COUNT, &wr) != NNTI_EINVAL) {
+        std::cout << "putv accepted a region past the end of the buffer" << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&dst_mr);
+    NNTI_free(&target_mr);
+    NNTI_free(&src_mr);
+}
+
+int main(int argc, char *argv[])
+{
+    if (mpi_transport_start() != NNTI_OK) {
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    check_vector_rdma();
+
+    return(mpi_transport_finish());
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+    std::cout << "MPI is not enabled.  Nothing to test." << std::endl;
+    std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,335 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * RemoteQueuePerfTest.cpp
+ *
+ * Compares small message throughput into one server for NNTI_send() to an
+ * NNTI_RECV_QUEUE buffer and for trios_remote_queue_enqueue() (fetch-add
+ * plus put into a ring the server polls).  Rank 0 is the server.  Every
+ * other rank is a client.
+ */
+
+#include "Trios_nnti.h"
+#include "Trios_logger.h"
+#include "Trios_timer.h"
+
+#include "remote_queue.h"
+
+#include <unistd.h>
+
+#include <iostream>
+
+#include <mpi.h>
+
+
+int nprocs, nclients;
+int rank;
+
+
+NNTI_transport_t trans_hdl;
+NNTI_peer_t      server_hdl;
+char             url[NNTI_URL_LEN];
+
+NNTI_buffer_t queue_mr;
+NNTI_buffer_t send_mr;
+NNTI_buffer_t ring_mr;
+
+NNTI_work_request_t queue_wr;
+
+trios_remote_queue_t rq;
+
+log_level rqperf_debug_level = LOG_UNDEFINED;
+
+uint32_t num_msgs;
+uint32_t msg_size;
+uint32_t entry_count;
+
+
+void client(void) {
+    NNTI_result_t rc=NNTI_OK;
+    NNTI_status_t send_status;
+    NNTI_work_request_t send_wr;
+    char *msg;
+
+    double op_timer;
+
+    NNTI_connect(&trans_hdl, url, 5000, &server_hdl);
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_SEND_SRC, &send_mr);
+    msg=NNTI_BUFFER_C_POINTER(&send_mr);
+    memset(msg, rank, NNTI_REQUEST_BUFFER_SIZE);
+
+    rc=(NNTI_result_t)trios_remote_queue_attach(&rq, &trans_hdl, &ring_mr);
+    if (rc != NNTI_OK) {
+        log_error(rqperf_debug_level, "trios_remote_queue_attach() returned an error: %d", rc);
+        MPI_Abort(MPI_COMM_WORLD, rc);
+    }
+
+    // the server makes progress on the attach while it waits for this
+    rc=NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+    if (rc == NNTI_OK) {
+        rc=NNTI_wait(&send_wr, 5000, &send_status);
+    }
+    if (rc != NNTI_OK) {
+        log_error(rqperf_debug_level, "NNTI_send() failed: %d", rc);
+        MPI_Abort(MPI_COMM_WORLD, rc);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /*
+     * Phase 1 - sends to the server's request queue
+     */
+    op_timer=trios_get_time();
+    for (uint32_t i=0;i<num_msgs;i++) {
+        rc=NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+        if (rc == NNTI_OK) {
+            rc=NNTI_wait(&send_wr, 5000, &send_status);
+        }
+        if (rc != NNTI_OK) {
+            log_error(rqperf_debug_level, "NNTI_send() failed: %d", rc);
+            MPI_Abort(MPI_COMM_WORLD, rc);
+        }
+    }
+    op_timer=trios_get_time()-op_timer;
+    log_debug(rqperf_debug_level, "client %d sent %u messages in %f seconds", rank, num_msgs, op_timer);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /*
+     * Phase 2 - enqueues to the server's remote queue
+     */
+    op_timer=trios_get_time();
+    for (uint32_t i=0;i<num_msgs;i++) {
+        rc=(NNTI_result_t)trios_remote_queue_enqueue(&rq, msg, msg_size);
+        if (rc != NNTI_OK) {
+            log_error(rqperf_debug_level, "trios_remote_queue_enqueue() failed: %d", rc);
+            MPI_Abort(MPI_COMM_WORLD, rc);
+        }
+    }
+    op_timer=trios_get_time()-op_timer;
+    log_debug(rqperf_debug_level, "client %d enqueued %u messages in %f seconds (%llu full waits)",
+            rank, num_msgs, op_timer, (unsigned long long)rq.full_waits);
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    trios_remote_queue_fini(&rq);
+    NNTI_dt_free(&trans_hdl, &ring_mr);
+
+    NNTI_free(&send_mr);
+
+    return;
+}
+
+bool server(void)
+{
+    NNTI_result_t rc=NNTI_OK;
+    NNTI_status_t queue_status;
+    uint64_t total=(uint64_t)nclients*num_msgs;
+    uint64_t received;
+    uint32_t length;
+    char    *msg;
+    bool     success=true;
+
+    double op_timer;
+
+    NNTI_alloc(&trans_hdl, NNTI_REQUEST_BUFFER_SIZE, nclients+total, NNTI_RECV_QUEUE, &queue_mr);
+    msg=(char *)malloc(msg_size);
+
+    // wait for every client to attach to the remote queue
+    for (int i=0;i<nclients;i++) {
+        NNTI_create_work_request(&queue_mr, &queue_wr);
+        rc=NNTI_wait(&queue_wr, -1, &queue_status);
+        if (rc != NNTI_OK) {
+            log_error(rqperf_debug_level, "NNTI_wait() returned an error: %d", rc);
+            MPI_Abort(MPI_COMM_WORLD, rc);
+        }
+        NNTI_destroy_work_request(&queue_wr);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /*
+     * Phase 1 - sends to the request queue
+     */
+    op_timer=trios_get_time();
+    for (received=0;received<total;received++) {
+        NNTI_create_work_request(&queue_mr, &queue_wr);
+        rc=NNTI_wait(&queue_wr, 5000, &queue_status);
+        if (rc != NNTI_OK) {
+            log_error(rqperf_debug_level, "NNTI_wait() returned an error: %d", rc);
+            MPI_Abort(MPI_COMM_WORLD, rc);
+        }
+        NNTI_destroy_work_request(&queue_wr);
+    }
+    op_timer=trios_get_time()-op_timer;
+    std::cout << "   NNTI_send to request queue (" << msg_size << " byte messages) == " << total/op_timer << " msgs/sec" << std::endl;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    /*
+     * Phase 2 - enqueues to the remote queue.  the ring is polled locally.
+     * when it is empty, a short wait on the request queue lets transports
+     * without one-sided hardware make progress on the clients' operations.
+     */
+    NNTI_create_work_request(&queue_mr, &queue_wr);
+    op_timer=trios_get_time();
+    for (received=0;received<total;) {
+        rc=(NNTI_result_t)trios_remote_queue_dequeue(&rq, msg, msg_size, &length);
+        if (rc == NNTI_EAGAIN) {
+            NNTI_wait(&queue_wr, 1, &queue_status);
+            continue;
+        }
+        if (rc != NNTI_OK) {
+            log_error(rqperf_debug_level, "trios_remote_queue_dequeue() returned an error: %d", rc);
+            MPI_Abort(MPI_COMM_WORLD, rc);
+        }
+        if ((length != msg_size) || (msg[0] < 1) || (msg[0] > nclients) || (msg[length-1] != msg[0])) {
+            log_error(rqperf_debug_level, "message %llu is corrupt (length=%u)", (unsigned long long)received, length);
+            success=false;
+        }
+        received++;
+    }
+    op_timer=trios_get_time()-op_timer;
+    NNTI_destroy_work_request(&queue_wr);
+    std::cout << "remote queue enqueue/dequeue (" << msg_size << " byte messages) == " << total/op_timer << " msgs/sec" << std::endl;
+
+    if (trios_remote_queue_dequeue(&rq, msg, msg_size, &length) != NNTI_EAGAIN) {
+        log_error(rqperf_debug_level, "the remote queue has extra messages");
+        success=false;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    trios_remote_queue_fini(&rq);
+
+    NNTI_free(&queue_mr);
+    free(msg);
+
+    return(success);
+}
+
+int main(int argc, char *argv[])
+{
+    bool success=true;
+    char     *packed=NULL;
+    uint64_t  packed_size=0;
+
+    MPI_Init(&argc, &argv);
+
+    MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    nclients=nprocs-1;
+
+    if (nprocs < 2) {
+        fprintf(stderr, "%s needs at least 2 ranks.\n", argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (argc == 4) {
+        num_msgs   =atol(argv[1]);
+        msg_size   =atol(argv[2]);
+        entry_count=atol(argv[3]);
+    } else if (argc == 1) {
+        // no args from user.  set some defaults.
+        num_msgs   =1000;
+        msg_size   =64;
+        entry_count=64;
+    } else {
+        if (rank == 0) {
+            fprintf(stderr, "Usage: %s <num msgs per client> <msg size> <ring entries>\n", argv[0]);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    if ((msg_size == 0) || (msg_size > NNTI_REQUEST_BUFFER_SIZE)) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: msg size must be between 1 and %d bytes.\n", argv[0], NNTI_REQUEST_BUFFER_SIZE);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    logger_init(LOG_ERROR, NULL);
+
+    NNTI_init(NNTI_DEFAULT_TRANSPORT, NULL, &trans_hdl);
+
+    if (rank==0) {
+        NNTI_get_url(&trans_hdl, url, NNTI_URL_LEN);
+        if (trios_remote_queue_create(&rq, &trans_hdl, entry_count, msg_size) != NNTI_OK) {
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        NNTI_dt_sizeof(&trans_hdl, &rq.ring, &packed_size);
+        packed=(char *)malloc(packed_size);
+        NNTI_dt_pack(&trans_hdl, &rq.ring, packed, packed_size);
+    }
+
+    MPI_Bcast(&url[0], NNTI_URL_LEN, MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&packed_size, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (rank != 0) {
+        packed=(char *)malloc(packed_size);
+    }
+    MPI_Bcast(packed, packed_size, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    if (rank==0) {
+        success=server();
+    } else {
+        NNTI_dt_unpack(&trans_hdl, &ring_mr, packed, packed_size);
+        client();
+    }
+    free(packed);
+
+    NNTI_fini(&trans_hdl);
+
+    MPI_Finalize();
+
+    if (rank == 0) {
+        if (success)
+            std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+        else
+            std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+    }
+
+    return (success ? 0 : 1 );
+}
@@ -0,0 +1,219 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * RequestRingTest.cpp
+ *
+ *  Sends variable length requests (some larger than NNTI_REQUEST_BUFFER_SIZE)
+ *  to ourselves through a request ring and checks that they arrive intact,
+ *  in order and that the ring wraps once the oldest requests are released.
+ *
+ *  IB and Gemini prepost receives into fixed slots and refuse ring buffers
+ *  with NNTI_ENOTSUP; on those transports the test checks that both
+ *  NNTI_alloc() and NNTI_register_memory() refuse cleanly.
+ */
+
+#include "Trios_nnti.h"
+
+#include "Trios_logger.h"
+
+#include "SelfConnect.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+
+#define RING_SIZE 4096
+
+NNTI_transport_t     trans_hdl;
+NNTI_peer_t          server_hdl;
+NNTI_buffer_t        ring_mr;
+
+bool success=true;
+
+static void send_request(uint32_t length)
+{
+    NNTI_buffer_t       send_mr;
+    NNTI_work_request_t send_wr;
+    NNTI_status_t       send_status;
+    NNTI_result_t       rc;
+
+    NNTI_alloc(&trans_hdl, length, 1, NNTI_SEND_SRC, &send_mr);
+    memset(NNTI_BUFFER_C_POINTER(&send_mr), (char)length, length);
+
+    NNTI_send(&server_hdl, &send_mr, NULL, &send_wr);
+    rc=NNTI_wait(&send_wr, 5000, &send_status);
+    if (rc != NNTI_OK) {
+        std::cout << "send of " << length << " bytes failed: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_free(&send_mr);
+}
+
+static void check_request(NNTI_status_t *status, uint32_t length)
+{
+    char *req=(char *)(status->start + status->offset);
+
+    if (status->length != length) {
+        std::cout << "expected a " << length << " byte request, got " << status->length << " bytes" << std::endl;
+        success=false;
+        return;
+    }
+    for (uint32_t i=0;i<length;i++) {
+        if (req[i] != (char)length) {
+            std::cout << "request of " << length << " bytes is corrupt at byte " << i << std::endl;
+            success=false;
+            return;
+        }
+    }
+}
+
+/*
+ * Transports that can't pack requests must refuse a ring whether the
+ * transport or the caller allocates the memory.
+ */
+static void check_ring_refused(void)
+{
+    NNTI_buffer_t user_mr;
+    char         *buf=(char *)malloc(RING_SIZE);
+
+    if (NNTI_register_memory(&trans_hdl, buf, RING_SIZE, 1, NNTI_RECV_RING, &user_mr) != NNTI_ENOTSUP) {
+        std::cout << "NNTI_register_memory() accepted a ring the transport can't serve" << std::endl;
+        success=false;
+    }
+
+    free(buf);
+}
+
+int main(int argc, char *argv[])
+{
+    NNTI_result_t rc;
+
+    NNTI_work_request_t ring_wr;
+    NNTI_status_t       ring_status;
+    NNTI_work_request_t wr_list[4];
+    NNTI_status_t       status_list[4];
+    uint32_t            count=0;
+
+    logger_init(LOG_ERROR, NULL);
+
+    rc=NNTI_init(NNTI_DEFAULT_TRANSPORT, NULL, &trans_hdl);
+    if (rc != NNTI_OK) {
+        std::cout << "NNTI_init() failed: rc=" << rc << std::endl;
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+        return 1;
+    }
+
+    rc=NNTI_alloc(&trans_hdl, RING_SIZE, 1, NNTI_RECV_RING, &ring_mr);
+    if (rc == NNTI_ENOTSUP) {
+        if ((trans_hdl.id != NNTI_TRANSPORT_IB) && (trans_hdl.id != NNTI_TRANSPORT_GEMINI)) {
+            std::cout << "only IB and Gemini should refuse request rings" << std::endl;
+            success=false;
+        }
+        check_ring_refused();
+        NNTI_fini(&trans_hdl);
+
+        if (success)
+            std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+        else
+            std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+        return (success ? 0 : 1 );
+    }
+
+    rc=self_connect(&trans_hdl, 5000, &server_hdl);
+
+    NNTI_create_work_request(&ring_mr, &ring_wr);
+
+    send_request(100);
+    send_request(3000);
+    send_request(50);
+
+    rc=NNTI_wait(&ring_wr, 5000, &ring_status);
+    check_request(&ring_status, 100);
+
+    rc=NNTI_dequeue_requests(&ring_mr, 4, 5000, wr_list, status_list, &count);
+    if (count != 2) {
+        std::cout << "expected 2 requests, got " << count << std::endl;
+        success=false;
+    } else {
+        check_request(&status_list[0], 3000);
+        check_request(&status_list[1], 50);
+    }
+
+    /* release everything but the last request, so the next one has to wrap */
+    NNTI_clear_work_request(&ring_wr);
+    NNTI_release_requests(&wr_list[0], 1);
+
+    send_request(1000);
+
+    rc=NNTI_wait(&ring_wr, 5000, &ring_status);
+    check_request(&ring_status, 1000);
+    if (ring_status.offset >= status_list[1].offset) {
+        std::cout << "expected the ring to wrap" << std::endl;
+        success=false;
+    }
+
+    NNTI_release_requests(&wr_list[1], 1);
+
+    /* nothing left */
+    rc=NNTI_wait(&ring_wr, 0, &ring_status);
+    if (rc != NNTI_ETIMEDOUT) {
+        std::cout << "expected NNTI_ETIMEDOUT from an empty ring: rc=" << rc << std::endl;
+        success=false;
+    }
+
+    NNTI_destroy_work_request(&ring_wr);
+
+    NNTI_free(&ring_mr);
+
+    NNTI_fini(&trans_hdl);
+
+    if (success)
+        std::cout << "\nEnd Result: TEST PASSED" << std::endl;
+    else
+        std::cout << "\nEnd Result: TEST FAILED" << std::endl;
+
+    return (success ? 0 : 1 );
+}
@@ -0,0 +1,107 @@
+/**
+//@HEADER
+// ************************************************************************
+//
+//                   Trios: Trilinos I/O Support
+//                 Copyright 2011 Sandia Corporation
+//
+// Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//Questions? Contact Ron A. Oldfield (raoldfi@sandia.gov)
+//
+// *************************************************************************
+//@HEADER
+ */
+/*
+ * SelfConnect.h
+ *
+ *  Connects a transport to its own URL from a single threaded test.
+ *  Some transports (IB, for example) only accept a connection while the
+ *  server side is making progress, so a helper thread waits on a scratch
+ *  receive buffer until NNTI_connect() returns.
+ */
+
+#ifndef SELFCONNECT_H_
+#define SELFCONNECT_H_
+
+#include "Trios_nnti.h"
+
+#include <pthread.h>
+
+static volatile bool self_connect_done=false;
+
+static void *self_connect_progress(void *args)
+{
+    NNTI_transport_t   *trans_hdl=(NNTI_transport_t *)args;
+    NNTI_buffer_t       scratch_mr;
+    NNTI_work_request_t scratch_wr;
+    NNTI_status_t       scratch_status;
+
+    NNTI_alloc(trans_hdl, NNTI_REQUEST_BUFFER_SIZE, 1, NNTI_RECV_DST, &scratch_mr);
+    NNTI_create_work_request(&scratch_mr, &scratch_wr);
+
+    /* nothing is ever sent here.  each wait accepts pending connections. */
+    while (!self_connect_done) {
+        NNTI_wait(&scratch_wr, 10, &scratch_status);
+    }
+
+    NNTI_destroy_work_request(&scratch_wr);
+    NNTI_free(&scratch_mr);
+
+    return(NULL);
+}
+
+static NNTI_result_t self_connect(
+        NNTI_transport_t *trans_hdl,
+        const int         timeout,
+        NNTI_peer_t      *peer_hdl)
+{
+    NNTI_result_t rc;
+    pthread_t     progress_thread;
+    char          url[NNTI_URL_LEN];
+
+    rc=NNTI_get_url(trans_hdl, url, NNTI_URL_LEN);
+    if (rc != NNTI_OK) {
+        return(rc);
+    }
+
+    self_connect_done=false;
+    pthread_create(&progress_thread, NULL, self_connect_progress, trans_hdl);
+
+    rc=NNTI_connect(trans_hdl, url, timeout, peer_hdl);
+
+    self_connect_done=true;
+    pthread_join(progress_thread, NULL);
+
+    return(rc);
+}
+
+#endif /* SELFCONNECT_H_ */